@@ -2,6 +2,7 @@
 #include "hal/gpio_hal.h"
 #include "esp_log.h"
 #include "qmsd_utils.h"
+#include "qmsd_mem.h"
 #include "qmsd_board.h"
 #include "qmsd_lcd_wrapper.h"
 #include "aw9523.h"
@@ -130,11 +131,8 @@ void qmsd_board_init_gui() {
     }
 
     for (uint8_t i = 0; i < buffer_num; i++) {
-        if (g_board_config.gui.flags.fb_in_psram) {
-            buffers[i] = (uint8_t *)QMSD_MALLOC_PSRAM(buffer_size);
-        } else {
-            buffers[i] = (uint8_t *)QMSD_MALLOC(buffer_size);
-        }
+        uint32_t flags = g_board_config.gui.flags.fb_in_psram ? QMSD_MEM_PSRAM : QMSD_MEM_INTERNAL;
+        buffers[i] = (uint8_t *)qmsd_mem_malloc(QMSD_MEM_TAG_GUI, buffer_size, flags);
     }
 
     qmsd_gui_config_t gui_config = {
@@ -263,6 +263,16 @@ esp_err_t esp_periph_set_register_callback(esp_periph_set_handle_t periph_set_ha
     }
 }
 
+esp_err_t esp_periph_set_get_callback(esp_periph_set_handle_t periph_set_handle, esp_periph_event_handle_t *cb, void **user_context)
+{
+    if (periph_set_handle == NULL) {
+        return ESP_FAIL;
+    }
+    *cb = periph_set_handle->event_handle.cb;
+    *user_context = periph_set_handle->event_handle.user_ctx;
+    return ESP_OK;
+}
+
 QueueHandle_t esp_periph_set_get_queue(esp_periph_set_handle_t periph_set_handle)
 {
     return audio_event_iface_get_queue_handle(periph_set_handle->event_handle.iface);
@@ -180,6 +180,19 @@ audio_event_iface_handle_t esp_periph_set_get_event_iface(esp_periph_set_handle_
  */
 esp_err_t esp_periph_set_register_callback(esp_periph_set_handle_t periph_set_handle, esp_periph_event_handle_t cb, void *user_context);
 
+/**
+ * @brief      Get the callback function registered with `esp_periph_set_register_callback`
+ *
+ * @param      periph_set_handle    The esp_periph_set_handle_t instance
+ * @param[out] cb                   The event handle callback function, NULL if none
+ * @param[out] user_context         Its user context pointer
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t esp_periph_set_get_callback(esp_periph_set_handle_t periph_set_handle, esp_periph_event_handle_t *cb, void **user_context);
+
 /**
  * @brief      Peripheral is using event_iface to control the event, all events are send out to event_iface queue.
  *             This function will be useful in case we want to read events directly from the event_iface queue.
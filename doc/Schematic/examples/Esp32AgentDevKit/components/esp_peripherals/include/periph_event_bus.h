@@ -0,0 +1,39 @@
+#ifndef _PERIPH_EVENT_BUS_H_
+#define _PERIPH_EVENT_BUS_H_
+
+#include "esp_peripherals.h"
+#include "qmsd_event_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Publish every event of the peripheral set on an event bus
+ *
+ *             Button and adc button events go to QMSD_EVENT_TOPIC_BUTTON, touch to
+ *             QMSD_EVENT_TOPIC_TOUCH, wifi to QMSD_EVENT_TOPIC_WIFI, the led drivers to
+ *             QMSD_EVENT_TOPIC_LED and the rest to QMSD_EVENT_TOPIC_PERIPH. The event id is
+ *             the peripheral event id, the value is the esp_periph_id_t and data is passed
+ *             through by reference.
+ *
+ *             This takes the callback slot of esp_periph_set_register_callback. A callback
+ *             registered there before is kept and called first for every event, listeners
+ *             of the set's event interface keep working. Register other callbacks before
+ *             the bridge: one registered after it replaces the bridge.
+ *
+ * @param[in]  periph_set_handle  The esp_periph_set_handle_t instance
+ * @param[in]  bus                The bus to publish on
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t esp_periph_set_bridge_event_bus(esp_periph_set_handle_t periph_set_handle, qmsd_event_bus_handle_t bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _PERIPH_METRICS_H_
+#define _PERIPH_METRICS_H_
+
+#include "esp_peripherals.h"
+#include "qmsd_metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Console command dumping the metrics registry
+ *
+ *             `metrics [prefix]` prints every metric whose name starts with prefix, histograms
+ *             with their count, mean and non empty buckets. `metrics bin` prints one
+ *             "QMTS:<hex>" line holding a binary snapshot without names, `metrics bin names`
+ *             one with names; qmsd-esp32-bsp/tools/metrics_decode.py decodes both from a
+ *             serial log.
+ *
+ * @param[in]  periph  The console peripheral
+ * @param[in]  argc    The argument count, the command itself not included
+ * @param[in]  argv    The arguments
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t periph_metrics_console_cmd(esp_periph_handle_t periph, int argc, char *argv[]);
+
+#define PERIPH_METRICS_CONSOLE_CMD { \
+    .cmd = "metrics", \
+    .help = "metrics [prefix] | metrics bin [names]", \
+    .func = periph_metrics_console_cmd, \
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -55,6 +55,7 @@ static void sdmmc_card_print_info(const sdmmc_card_t *card)
              card->csd.csd_ver,
              card->csd.sector_size, card->csd.capacity, card->csd.read_block_len);
     ESP_LOGD(TAG, "SCR: sd_spec=%d, bus_width=%d\n", card->scr.sd_spec, card->scr.bus_width);
+    ESP_LOGI(TAG, "Bus: %d-line, %d kHz", 1 << card->log_bus_width, card->max_freq_khz);
 }
 
 esp_err_t sdcard_mount(const char *base_path, periph_sdcard_mode_t mode)
@@ -76,7 +77,8 @@ esp_err_t sdcard_mount(const char *base_path, periph_sdcard_mode_t mode)
         ESP_LOGI(TAG, "Using %d-line SD mode,  base path=%s", mode, base_path);
 
         sdmmc_host_t host = SDMMC_HOST_DEFAULT();
-        // host.max_freq_khz = SDMMC_FREQ_HIGHSPEED;
+        // 40 MHz: a 4-line bus moves ~20MB/s, enough for raw multi channel capture
+        host.max_freq_khz = SDMMC_FREQ_HIGHSPEED;
 
         sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
         // slot_config.gpio_cd = g_gpio;
@@ -101,6 +103,12 @@ esp_err_t sdcard_mount(const char *base_path, periph_sdcard_mode_t mode)
         slot_config.wp = ESP_SD_PIN_WP;
 #endif
         ret = esp_vfs_fat_sdmmc_mount(base_path, &host, &slot_config, &mount_config, &card);
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE && ret != ESP_FAIL) {
+            // weak pull-ups or long traces may not hold 40 MHz, try again at the default speed
+            ESP_LOGW(TAG, "High speed init failed (%d), retry at %d kHz", ret, SDMMC_FREQ_DEFAULT);
+            host.max_freq_khz = SDMMC_FREQ_DEFAULT;
+            ret = esp_vfs_fat_sdmmc_mount(base_path, &host, &slot_config, &mount_config, &card);
+        }
 #endif
     } else {
         ESP_LOGI(TAG, "Using SPI mode, base path=%s", base_path);
@@ -0,0 +1,67 @@
+#include "esp_log.h"
+#include "audio_event_iface.h"
+#include "audio_mem.h"
+#include "periph_event_bus.h"
+
+static const char *TAG = "PERIPH_EVENT_BUS";
+
+typedef struct {
+    qmsd_event_bus_handle_t bus;
+    esp_periph_event_handle_t prev_cb;      // the callback the bridge took the place of
+    void *prev_ctx;
+} periph_event_bus_bridge_t;
+
+static uint8_t periph_event_bus_topic(int periph_id)
+{
+    switch (periph_id) {
+        case PERIPH_ID_BUTTON:
+        case PERIPH_ID_ADC_BTN:
+            return QMSD_EVENT_TOPIC_BUTTON;
+        case PERIPH_ID_TOUCH:
+            return QMSD_EVENT_TOPIC_TOUCH;
+        case PERIPH_ID_WIFI:
+            return QMSD_EVENT_TOPIC_WIFI;
+        case PERIPH_ID_LED:
+        case PERIPH_ID_IS31FL3216:
+        case PERIPH_ID_WS2812:
+        case PERIPH_ID_AW2013:
+            return QMSD_EVENT_TOPIC_LED;
+        default:
+            return QMSD_EVENT_TOPIC_PERIPH;
+    }
+}
+
+static esp_err_t periph_event_bus_cb(audio_event_iface_msg_t *msg, void *context)
+{
+    periph_event_bus_bridge_t *bridge = (periph_event_bus_bridge_t *)context;
+    esp_err_t ret = ESP_OK;
+    if (bridge->prev_cb) {
+        ret = bridge->prev_cb(msg, bridge->prev_ctx);
+    }
+    if (!qmsd_event_bus_publish(bridge->bus, periph_event_bus_topic(msg->source_type), msg->cmd, msg->source_type, msg->data, msg->data_len)) {
+        ESP_LOGW(TAG, "Bus full, event %d of periph %d dropped", msg->cmd, msg->source_type);
+        return ESP_FAIL;
+    }
+    return ret;
+}
+
+esp_err_t esp_periph_set_bridge_event_bus(esp_periph_set_handle_t periph_set_handle, qmsd_event_bus_handle_t bus)
+{
+    esp_periph_event_handle_t prev_cb = NULL;
+    void *prev_ctx = NULL;
+    if (bus == NULL || esp_periph_set_get_callback(periph_set_handle, &prev_cb, &prev_ctx) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (prev_cb == periph_event_bus_cb) {
+        // bridged already, move it to the new bus
+        ((periph_event_bus_bridge_t *)prev_ctx)->bus = bus;
+        return ESP_OK;
+    }
+    // lives as long as the set, like the callback slot it sits in
+    periph_event_bus_bridge_t *bridge = audio_calloc(1, sizeof(periph_event_bus_bridge_t));
+    AUDIO_MEM_CHECK(TAG, bridge, return ESP_ERR_NO_MEM);
+    bridge->bus = bus;
+    bridge->prev_cb = prev_cb;
+    bridge->prev_ctx = prev_ctx;
+    return esp_periph_set_register_callback(periph_set_handle, periph_event_bus_cb, bridge);
+}
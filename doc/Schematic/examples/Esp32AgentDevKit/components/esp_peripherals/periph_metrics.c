@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_mem.h"
+#include "periph_metrics.h"
+
+static const char *TAG = "PERIPH_METRICS";
+
+#define METRICS_SNAPSHOT_MIN_SIZE   (1024)
+#define METRICS_SNAPSHOT_MAX_SIZE   (16 * 1024)
+
+static void periph_metrics_print(const qmsd_metric_t *metric, void *ctx)
+{
+    const char *prefix = (const char *)ctx;
+    if (prefix && strncmp(metric->name, prefix, strlen(prefix)) != 0) {
+        return;
+    }
+    qmsd_metric_value_t value;
+    qmsd_metric_read(metric, &value);
+    if (value.type == QMSD_METRIC_COUNTER) {
+        printf("%-28s %lu\r\n", metric->name, (unsigned long)value.count);
+        return;
+    }
+    if (value.type == QMSD_METRIC_GAUGE) {
+        printf("%-28s %ld\r\n", metric->name, (long)value.gauge);
+        return;
+    }
+    printf("%-28s n %lu, mean %lu\r\n", metric->name, (unsigned long)value.count,
+           (unsigned long)(value.count ? value.sum / value.count : 0));
+    for (int i = 0; i < value.bucket_num; i++) {
+        if (value.buckets[i] == 0) {
+            continue;
+        }
+        if (i < metric->bound_num) {
+            printf("%28s <= %-8lu %lu\r\n", "", (unsigned long)metric->bounds[i], (unsigned long)value.buckets[i]);
+        } else {
+            printf("%28s  > %-8lu %lu\r\n", "", (unsigned long)metric->bounds[i - 1], (unsigned long)value.buckets[i]);
+        }
+    }
+}
+
+static esp_err_t periph_metrics_print_binary(uint8_t flags)
+{
+    uint32_t size = METRICS_SNAPSHOT_MIN_SIZE;
+    uint8_t *buf = NULL;
+    int len = -1;
+    while (len < 0 && size <= METRICS_SNAPSHOT_MAX_SIZE) {
+        buf = audio_malloc(size);
+        if (buf == NULL) {
+            ESP_LOGE(TAG, "No memory for a %lu byte snapshot", (unsigned long)size);
+            return ESP_ERR_NO_MEM;
+        }
+        len = qmsd_metrics_snapshot(buf, size, (uint32_t)(esp_timer_get_time() / 1000), flags);
+        if (len < 0) {
+            audio_free(buf);
+            buf = NULL;
+            size *= 2;
+        }
+    }
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Snapshot larger than %d bytes", METRICS_SNAPSHOT_MAX_SIZE);
+        return ESP_ERR_NO_MEM;
+    }
+    printf("QMTS:");
+    for (int i = 0; i < len; i++) {
+        printf("%02x", buf[i]);
+    }
+    printf("\r\n");
+    audio_free(buf);
+    return ESP_OK;
+}
+
+esp_err_t periph_metrics_console_cmd(esp_periph_handle_t periph, int argc, char *argv[])
+{
+    if (argc > 0 && strcmp(argv[0], "bin") == 0) {
+        uint8_t flags = (argc > 1 && strcmp(argv[1], "names") == 0) ? QMSD_METRICS_SNAPSHOT_NAMES : 0;
+        return periph_metrics_print_binary(flags);
+    }
+    qmsd_metrics_foreach(periph_metrics_print, argc > 0 ? argv[0] : NULL);
+    return ESP_OK;
+}
@@ -3,6 +3,8 @@
 // #include "freertos/FreeRTOS.h"
 // #include "freertos/task.h"
 #include "esp_log.h"
+#include "qmsd_mem.h"
+#include "qmsd_sched.h"
 #include "sdkconfig.h"
 #include "audio_element.h"
 #include "audio_pipeline.h"
@@ -36,6 +38,7 @@
 #endif
 #include "audio_idf_version.h"
 #include "raw_stream.h"
+#include "mp3_player.h"
 
 #define CHANNEL 1
 #define RECORD_TIME_SECONDS (10)
@@ -88,13 +91,16 @@ struct player_pipeline_t
     audio_element_handle_t audio_decoder;
     audio_element_handle_t i2s_stream_writer;
     esp_timer_handle_t poll_audio_timer;
+    volatile bool prompt;               // a local prompt holds the i2s element, the call decoder is paused
+    bool call_paused;                   // the prompt paused it and resumes it at the end
+    audio_element_info_t call_info;     // the i2s clock of the call, given back after the prompt
 };
 
 static void player_thread(void *arg);
 
 player_thread_data_handle_t player_thread_data_create(void *user_data)
 {
-    player_thread_data_handle_t handle = heap_caps_malloc(sizeof(player_thread_data), MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+    player_thread_data_handle_t handle = qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, sizeof(player_thread_data), QMSD_MEM_PSRAM);
     assert(handle != NULL);
     handle->audio_queue = xQueueCreate(256, sizeof(queue_item));
     assert(handle->audio_queue != NULL);
@@ -106,7 +112,7 @@ player_thread_data_handle_t player_thread_data_create(void *user_data)
 void player_thread_data_destory(player_thread_data_handle_t handle)
 {
     assert(handle != 0);
-    heap_caps_free(handle);
+    qmsd_mem_free(handle);
 };
 
 void player_thread_data_start(player_thread_data_handle_t handle) {
@@ -119,6 +125,21 @@ void player_thread_data_stop(player_thread_data_handle_t handle)
     handle->stoped = true;
 };
 
+// Element tasks are named by their pipeline tag, the task plan (qmsd_task_plan.h) may move them
+#define PIPELINE_PLACE(tag, cfg)    pipeline_place(tag, &(cfg).task_stack, &(cfg).task_prio, &(cfg).task_core)
+
+static void pipeline_place(const char *tag, int *task_stack, int *task_prio, int *task_core)
+{
+    UBaseType_t prio = *task_prio;
+    BaseType_t core = *task_core;
+    uint32_t stack_size = *task_stack;
+    if (qmsd_sched_place(tag, &prio, &core, &stack_size)) {
+        *task_stack = stack_size;
+        *task_prio = prio;
+        *task_core = core;
+    }
+}
+
 static audio_element_handle_t create_resample_stream(void)
 {
     rsp_filter_cfg_t rsp_cfg_w = DEFAULT_RESAMPLE_FILTER_CONFIG();
@@ -138,6 +159,7 @@ static audio_element_handle_t create_algo_stream(void)
     algo_config.sample_rate = 8000;
     algo_config.out_rb_size = 256;
     algo_config.algo_mask = ALGORITHM_STREAM_DEFAULT_MASK | ALGORITHM_STREAM_USE_AGC;
+    PIPELINE_PLACE("algo", algo_config);
     audio_element_handle_t element_algo = algo_stream_init(&algo_config);
     audio_element_set_music_info(element_algo, 8000, 1, 16);
     audio_element_set_input_timeout(element_algo, portMAX_DELAY);
@@ -147,7 +169,7 @@ static audio_element_handle_t create_algo_stream(void)
 #include "es7210.h"
 recorder_pipeline_handle_t recorder_pipeline_open()
 {
-    recorder_pipeline_handle_t pipeline = heap_caps_malloc(sizeof(recorder_pipeline_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+    recorder_pipeline_handle_t pipeline = qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, sizeof(recorder_pipeline_t), QMSD_MEM_PSRAM);
     // memset(&pipeline,0,sizeof(recorder_pipeline_t));
     int channel_format = I2S_CHANNEL_TYPE_RIGHT_LEFT;
     if (CHANNEL == 1)
@@ -180,6 +202,7 @@ recorder_pipeline_handle_t recorder_pipeline_open()
 
     i2s_stream_set_channel_type(&i2s_cfg, channel_format);
     i2s_cfg.std_cfg.clk_cfg.sample_rate_hz = sample_rate;
+    PIPELINE_PLACE("i2s", i2s_cfg);
     pipeline->i2s_stream_reader = i2s_stream_init(&i2s_cfg);
     ESP_LOGI(TAG, "[3.3] Create audio encoder to handle data");
 
@@ -189,15 +212,18 @@ recorder_pipeline_handle_t recorder_pipeline_open()
     opus_cfg.channel = CHANNEL;
     opus_cfg.bitrate = BIT_RATE;
     opus_cfg.complexity = COMPLEXITY;
+    PIPELINE_PLACE("opus", opus_cfg);
     pipeline->audio_encoder = raw_opus_decoder_init(&opus_cfg);
 #elif defined(CONFIG_CHOICE_AAC_ENCODER)
     aac_encoder_cfg_t aac_cfg = DEFAULT_AAC_ENCODER_CONFIG();
     aac_cfg.sample_rate = SAMPLE_RATE;
     aac_cfg.channel = CHANNEL;
     aac_cfg.bitrate = BIT_RATE;
+    PIPELINE_PLACE("aac", aac_cfg);
     pipeline->audio_encoder = aac_encoder_init(&aac_cfg);
 #elif defined(CONFIG_CHOICE_G711A_ENCODER)
     g711_encoder_cfg_t g711_cfg = DEFAULT_G711_ENCODER_CONFIG();
+    PIPELINE_PLACE("g711a", g711_cfg);
     pipeline->audio_encoder = g711_encoder_init(&g711_cfg);
 #endif
     ESP_LOGI(TAG, "[3.4] Register all elements to audio pipeline");
@@ -252,7 +278,7 @@ void recorder_pipeline_close(recorder_pipeline_handle_t pipeline)
     audio_element_deinit(pipeline->i2s_stream_reader);
     audio_element_deinit(pipeline->audio_encoder);
 
-    heap_caps_free(pipeline);
+    qmsd_mem_free(pipeline);
 };
 
 void recorder_pipeline_run(recorder_pipeline_handle_t pipeline)
@@ -291,6 +317,11 @@ static void poll_audio_timer_callback(void *arg)
     TickType_t delay = portMAX_DELAY;
     queue_item qitem = {0};
 
+    // the paused decoder takes nothing, the packets wait in the queue until the prompt ends
+    if (player_pipeline->prompt)
+    {
+        return;
+    }
     if (player_pipeline->thread_data->play_packet_count <= 0)
     {
         // ESP_LOGI(TAG, "processing .......");
@@ -304,7 +335,7 @@ static void poll_audio_timer_callback(void *arg)
             else
             {
                 raw_stream_write(player_pipeline->raw_writer, qitem.buffer, qitem.size);
-                audio_free(qitem.buffer);
+                qmsd_mem_free(qitem.buffer);
             }
         }
     }
@@ -339,10 +370,12 @@ static void poll_audio_timer_callback(void *arg)
 
 player_pipeline_handle_t player_pipeline_open(void)
 {
-    player_pipeline_handle_t player_pipeline = heap_caps_malloc(sizeof(player_pipeline_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+    player_pipeline_handle_t player_pipeline = qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, sizeof(player_pipeline_t), QMSD_MEM_PSRAM);
     ESP_LOGI(TAG, "[ 2 ] Start codec chip");
 
     assert(player_pipeline != 0);
+    player_pipeline->prompt = false;
+    player_pipeline->call_paused = false;
 
     player_pipeline->thread_data = player_thread_data_create(player_pipeline);
     assert(player_pipeline->thread_data);
@@ -366,6 +399,7 @@ player_pipeline_handle_t player_pipeline_open(void)
     i2s_cfg.out_rb_size = 8 * 1024;
     i2s_stream_set_channel_type(&i2s_cfg, I2S_CHANNEL_TYPE_ONLY_LEFT);
     i2s_cfg.buffer_len = 708;
+    PIPELINE_PLACE("i2s", i2s_cfg);
     player_pipeline->i2s_stream_writer = i2s_stream_init(&i2s_cfg);
 
 #ifdef CONFIG_AUDIO_SUPPORT_OPUS_DECODER
@@ -373,14 +407,17 @@ player_pipeline_handle_t player_pipeline_open(void)
     raw_opus_dec_cfg_t opus_dec_cfg = DEFAULT_OPUS_DECODER_CONFIG();
     opus_dec_cfg.samp_rate = DEC_SAMPLE_RATE;
     opus_dec_cfg.dec_frame_size = DEC_BIT_RATE * FRAME_TIME_MS / 1000;
+    PIPELINE_PLACE("dec", opus_dec_cfg);
     player_pipeline->audio_decoder = raw_opus_decoder_init(&opus_dec_cfg);
 #elif CONFIG_AUDIO_SUPPORT_AAC_DECODER
     ESP_LOGI(TAG, "[3.3] Create aac decoder");
     aac_decoder_cfg_t aac_dec_cfg = DEFAULT_AAC_DECODER_CONFIG();
+    PIPELINE_PLACE("dec", aac_dec_cfg);
     player_pipeline->audio_decoder = aac_decoder_init(&aac_dec_cfg);
 #elif CONFIG_AUDIO_SUPPORT_G711A_DECODER
     g711_decoder_cfg_t g711_dec_cfg = DEFAULT_G711_DECODER_CONFIG();
     g711_dec_cfg.out_rb_size = 8 * 1024;
+    PIPELINE_PLACE("dec", g711_dec_cfg);
     player_pipeline->audio_decoder = g711_decoder_init(&g711_dec_cfg);
 #endif
 
@@ -406,8 +443,11 @@ void player_pipeline_run(player_pipeline_handle_t player_pipeline)
     audio_pipeline_run(player_pipeline->audio_pipeline);
 };
 
+static void player_pipeline_detach_mp3player(player_pipeline_handle_t player_pipeline);
+
 void player_pipeline_close(player_pipeline_handle_t player_pipeline)
 {
+    player_pipeline_detach_mp3player(player_pipeline);
     audio_pipeline_stop(player_pipeline->audio_pipeline);
     audio_pipeline_wait_for_stop(player_pipeline->audio_pipeline);
     audio_pipeline_terminate(player_pipeline->audio_pipeline);
@@ -425,7 +465,7 @@ void player_pipeline_close(player_pipeline_handle_t player_pipeline)
 
     esp_timer_stop(player_pipeline->poll_audio_timer);
     esp_timer_delete(player_pipeline->poll_audio_timer);
-    heap_caps_free(player_pipeline);
+    qmsd_mem_free(player_pipeline);
 };
 
 #define RTC_PLAY_DATA_BUFFER_SIZE 16000
@@ -455,11 +495,14 @@ int player_pipeline_write(player_pipeline_handle_t player_pipeline, char *buffer
 
     queue_item qitem;
     // assert(qitem != 0);
-    qitem.buffer = audio_calloc(1, buf_size);
+    qitem.buffer = qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, buf_size, 0);
     assert(qitem.buffer != 0);
     memcpy(qitem.buffer, buffer, buf_size);
     qitem.size = buf_size;
-    xQueueSend(player_pipeline->thread_data->audio_queue, &qitem, 0);
+    if (xQueueSend(player_pipeline->thread_data->audio_queue, &qitem, 0) != pdTRUE)
+    {
+        qmsd_mem_free(qitem.buffer); // queue full, the packet is dropped
+    }
     // printf("write to player thread %d ...\n",buf_size);
     player_pipeline->thread_data->play_packet_count--;
     return 0;
@@ -472,3 +515,155 @@ void player_pipeline_write_play_buffer_flag(player_pipeline_handle_t player_pipe
     qitem.size = 4;
     xQueueSend(player_pipeline->thread_data->audio_queue, &qitem, 0);
 };
+
+
+// Local prompts: PCM from the mp3 player goes straight into the i2s element's
+// input ring buffer, the raw writer and the call decoder are bypassed. The
+// call decoder writes to the same ring buffer, so a prompt first pauses it and
+// only then takes the i2s element, and gives the call its clock back at the end.
+static player_pipeline_handle_t s_pcm_pipeline = NULL;
+
+int player_pipeline_write_pcm(player_pipeline_handle_t player_pipeline, const char *pcm, int len, TickType_t ticks)
+{
+    ringbuf_handle_t rb = audio_element_get_input_ringbuf(player_pipeline->i2s_stream_writer);
+    if (rb == NULL || audio_element_get_state(player_pipeline->audio_decoder) == AEL_STATE_RUNNING)
+    {
+        return -1;
+    }
+    return rb_write(rb, (char *)pcm, len, ticks);
+}
+
+esp_err_t player_pipeline_set_pcm_info(player_pipeline_handle_t player_pipeline, int sample_rate, int channels, int bits)
+{
+    return i2s_stream_set_clk(player_pipeline->i2s_stream_writer, sample_rate, bits, channels);
+}
+
+// The PCM still queued for the i2s element plays at the clock it was written for
+static void player_pipeline_pcm_drain(player_pipeline_handle_t player_pipeline)
+{
+    ringbuf_handle_t rb = audio_element_get_input_ringbuf(player_pipeline->i2s_stream_writer);
+    for (int i = 0; rb && rb_bytes_filled(rb) > 0 && i < 50; i++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+// On the mp3player task, before the first frame of a prompt
+static esp_err_t player_pipeline_prompt_begin(player_pipeline_handle_t player_pipeline)
+{
+    if (player_pipeline->prompt)
+    {
+        return ESP_OK;
+    }
+    audio_element_state_t state = audio_element_get_state(player_pipeline->audio_decoder);
+    if (state == AEL_STATE_RUNNING)
+    {
+        audio_element_pause(player_pipeline->audio_decoder);
+        state = audio_element_get_state(player_pipeline->audio_decoder);
+        if (state == AEL_STATE_RUNNING)
+        {
+            ESP_LOGW(TAG, "call decoder did not pause, prompt dropped");
+            return ESP_ERR_INVALID_STATE;
+        }
+        player_pipeline->call_paused = true;
+    }
+    audio_element_getinfo(player_pipeline->i2s_stream_writer, &player_pipeline->call_info);
+    player_pipeline->prompt = true;
+    return ESP_OK;
+}
+
+// On the mp3player task, once the prompt is done or stopped
+static void player_pipeline_prompt_end(player_pipeline_handle_t player_pipeline)
+{
+    if (!player_pipeline->prompt)
+    {
+        return;
+    }
+    player_pipeline_pcm_drain(player_pipeline);
+    player_pipeline_set_pcm_info(player_pipeline, player_pipeline->call_info.sample_rates, player_pipeline->call_info.channels,
+                                 player_pipeline->call_info.bits);
+    if (player_pipeline->call_paused)
+    {
+        audio_element_resume(player_pipeline->audio_decoder, 0, 0);
+        player_pipeline->call_paused = false;
+    }
+    player_pipeline->prompt = false;
+}
+
+static uint32_t mp3player_sink_write(void *ctx, const uint8_t *pcm, uint32_t len, uint32_t timeout_ms)
+{
+    player_pipeline_handle_t player_pipeline = (player_pipeline_handle_t)ctx;
+    if (!player_pipeline->prompt)
+    {
+        // the call kept the i2s element, this prompt is not heard
+        return len;
+    }
+    int ret = player_pipeline_write_pcm(player_pipeline, (const char *)pcm, len, pdMS_TO_TICKS(timeout_ms));
+    if (ret < 0 && ret != RB_TIMEOUT)
+    {
+        // refused, or the i2s element stopped: wait as a full ring buffer would, the player looks at its stop bits
+        vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+    }
+    return ret > 0 ? ret : 0;
+}
+
+static void mp3player_sink_end(void *ctx)
+{
+    player_pipeline_prompt_end((player_pipeline_handle_t)ctx);
+}
+
+static void mp3player_sink_info(int samprate, int chans, int bits_per_sample)
+{
+    if (s_pcm_pipeline == NULL)
+    {
+        return;
+    }
+    if (s_pcm_pipeline->prompt)
+    {
+        player_pipeline_pcm_drain(s_pcm_pipeline);
+    }
+    if (player_pipeline_prompt_begin(s_pcm_pipeline) == ESP_OK)
+    {
+        player_pipeline_set_pcm_info(s_pcm_pipeline, samprate, chans, bits_per_sample);
+    }
+}
+
+void player_pipeline_attach_mp3player(player_pipeline_handle_t player_pipeline, uint8_t task_core, uint8_t task_prio)
+{
+    mp3player_init(mp3player_sink_info, task_core, task_prio);
+    // a prompt of the previous pipeline ends first, it may still hold that one
+    mp3player_stop(portMAX_DELAY);
+    s_pcm_pipeline = player_pipeline;
+    mp3player_sink_t sink = {
+        .write = mp3player_sink_write,
+        .end = mp3player_sink_end,
+        .ctx = player_pipeline,
+    };
+    mp3player_set_sink(&sink);
+}
+
+static void player_pipeline_detach_mp3player(player_pipeline_handle_t player_pipeline)
+{
+    if (s_pcm_pipeline != player_pipeline)
+    {
+        return;
+    }
+    mp3player_stop(portMAX_DELAY);
+    mp3player_set_sink(NULL);
+    s_pcm_pipeline = NULL;
+}
+
+esp_err_t player_pipeline_play_prompt(player_pipeline_handle_t player_pipeline, const char *path)
+{
+    if (s_pcm_pipeline != player_pipeline)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    mp3_source_t src;
+    if (mp3_source_init_file(&src, path) != 0)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    mp3player_start_source(&src);
+    return ESP_OK;
+}
\ No newline at end of file
@@ -25,6 +25,14 @@ void player_pipeline_run(player_pipeline_handle_t);
 void player_pipeline_close(player_pipeline_handle_t);
 int player_pipeline_write(player_pipeline_handle_t,char *buffer, int buf_size);
 void player_pipeline_write_play_buffer_flag(player_pipeline_handle_t player_pipeline);
+// -1 while the call decoder runs, it writes to the i2s element too
+int player_pipeline_write_pcm(player_pipeline_handle_t, const char *pcm, int len, TickType_t ticks);
+esp_err_t player_pipeline_set_pcm_info(player_pipeline_handle_t, int sample_rate, int channels, int bits);
+// mp3player in push mode, decoded frames go straight to the i2s element. A prompt pauses
+// the call decoder and keeps its i2s clock, both come back when the prompt ends.
+void player_pipeline_attach_mp3player(player_pipeline_handle_t, uint8_t task_core, uint8_t task_prio);
+// Plays an mp3 file through the attached mp3player, ESP_ERR_NOT_FOUND without the file
+esp_err_t player_pipeline_play_prompt(player_pipeline_handle_t, const char *path);
 
 #ifdef __cplusplus
 }
@@ -11,6 +11,7 @@
 #include "esp_system.h"
 #include "nvs_flash.h"
 #include "protocol_examples_common.h"
+#include "qmsd_wifi.h"
 #include "esp_netif.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -37,6 +38,17 @@
 #include "start_bot/start_bot.h"
 #include "lvgl.h"
 #include "ui_code/ui.h"
+#include "ui_wid.h"
+#include "qmsd_ui_ctrl.h"
+#include "qmsd_event_bus_task.h"
+#include "qmsd_recorder.h"
+#include "qmsd_metrics.h"
+#include "qmsd_mem.h"
+#include "qmsd_utils.h"
+#include "qmsd_sched.h"
+#include "qmsd_gui.h"
+#include "qmsd_transcript.h"
+#include "cJSON.h"
 
 #define STATS_TASK_PRIO 5
 #define DEFAULT_READ_COUNT 50000
@@ -52,6 +64,11 @@ char *global_roomid = NULL;
 char *global_uid = NULL;
 extern EventGroupHandle_t s_wifi_event_group;
 
+QMSD_METRIC_COUNTER(s_rtc_uplink_frames, "rtc.uplink.frames");
+QMSD_METRIC_COUNTER(s_rtc_uplink_bytes, "rtc.uplink.bytes");
+QMSD_METRIC_COUNTER(s_rtc_downlink_frames, "rtc.downlink.frames");
+QMSD_METRIC_COUNTER(s_rtc_downlink_bytes, "rtc.downlink.bytes");
+
 static void esp_dump_per_task_heap_info(void);
 static void realtime_stats_timer_callback(void *arg)
 {
@@ -74,11 +91,21 @@ static void byte_rtc_on_join_room_success(byte_rtc_engine_t engine, const char *
 {
 	ESP_LOGI(TAG, "join channel success %s elapsed %d ms now %d ms\n", channel, elapsed_ms, elapsed_ms);
 	joined = true;
+	// the recorder opens a session for this call
+	qmsd_event_bus_publish(qmsd_event_bus_default(), QMSD_EVENT_TOPIC_CALL, QMSD_EVENT_CALL_JOINED, (int32_t)esp_random(), NULL, 0);
 };
 
+// A chime on the storage partition (mounted by the recorder), put there with the other assets
+#define RTC_PROMPT_JOINED "/littlefs/prompt/joined.mp3"
+
 static void byte_rtc_on_user_joined(byte_rtc_engine_t engine, const char *channel, const char *user_name, int elapsed_ms)
 {
 	ESP_LOGI(TAG, "remote user joined  %s:%s\n", channel, user_name);
+	player_pipeline_handle_t player_pipeline = (player_pipeline_handle_t)byte_rtc_get_user_data(engine);
+	if (player_pipeline != NULL && player_pipeline_play_prompt(player_pipeline, RTC_PROMPT_JOINED) == ESP_ERR_NOT_FOUND)
+	{
+		ESP_LOGD(TAG, "no %s, joined without a prompt", RTC_PROMPT_JOINED);
+	}
 };
 
 static void byte_rtc_on_user_offline(byte_rtc_engine_t engine, const char *channel, const char *user_name, int reason)
@@ -104,11 +131,52 @@ static void byte_rtc_on_audio_data(byte_rtc_engine_t engine, const char *channel
 	{
 		player_pipeline_write(player_pipeline, data_ptr, data_len);
 	}
+	qmsd_recorder_push(QMSD_REC_STREAM_DOWNLINK, codec, data_ptr, data_len);
+	qmsd_metric_inc(&s_rtc_downlink_frames);
+	qmsd_metric_add(&s_rtc_downlink_bytes, data_len);
+}
+
+static lv_obj_t *g_transcript = NULL;
+
+void rtc_set_transcript(lv_obj_t *view)
+{
+	g_transcript = view;
+}
+
+// Subtitles from the bot: "subv", a big endian length, then
+// {"type":"subtitle","data":[{"text":"...","definite":false,...}]}.
+// The sentence is resent whole as it grows, set_tail relays only what changed.
+static void rtc_show_subtitle(const uint8_t *message, int size)
+{
+	if (g_transcript == NULL || size < 8 || memcmp(message, "subv", 4) != 0)
+		return;
+	uint32_t len = ((uint32_t)message[4] << 24) | ((uint32_t)message[5] << 16) | ((uint32_t)message[6] << 8) | message[7];
+	if (len > (uint32_t)size - 8)
+		return;
+	cJSON *root = cJSON_ParseWithLength((const char *)message + 8, len);
+	if (root == NULL)
+		return;
+	cJSON *item;
+	if (qmsd_gui_lock(portMAX_DELAY) == 0)
+	{
+		cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "data"))
+		{
+			cJSON *text = cJSON_GetObjectItem(item, "text");
+			if (!cJSON_IsString(text))
+				continue;
+			qmsd_transcript_set_tail(g_transcript, text->valuestring);
+			if (cJSON_IsTrue(cJSON_GetObjectItem(item, "definite")))
+				qmsd_transcript_append(g_transcript, "\n");
+		}
+		qmsd_gui_unlock();
+	}
+	cJSON_Delete(root);
 }
 
 static void on_message_received(byte_rtc_engine_t engine, const char *room, const char *uid, const uint8_t *message, int size, bool binary)
 {
 	ESP_LOGI(TAG, "on_message_received uid: %s, message size: %d", uid, size);
+	rtc_show_subtitle(message, size);
 }
 
 static void on_fini_notify(byte_rtc_engine_t engine)
@@ -116,6 +184,27 @@ static void on_fini_notify(byte_rtc_engine_t engine)
 	fini_notifyed = true;
 }
 
+// The engine runs its own thread, its place comes from the "rtc-engine" plan entry.
+static void byte_rtc_place_engine(byte_rtc_engine_t engine)
+{
+	UBaseType_t prio = 5;
+	BaseType_t core = 1;
+	uint32_t stack_size = 0;
+	char params[64];
+
+	qmsd_sched_place("rtc-engine", &prio, &core, &stack_size);
+	if (core != tskNO_AFFINITY) {
+		snprintf(params, sizeof(params), "{\"rtc\":{\"thread\":{\"pinned_to_core\":%d}}}", (int)core);
+		byte_rtc_set_params(engine, params);
+	}
+	snprintf(params, sizeof(params), "{\"rtc\":{\"thread\":{\"priority\":%u}}}", (unsigned)prio);
+	byte_rtc_set_params(engine, params);
+	if (stack_size) {
+		snprintf(params, sizeof(params), "{\"rtc\":{\"thread\":{\"stack_size\":%lu}}}", (unsigned long)stack_size);
+		byte_rtc_set_params(engine, params);
+	}
+}
+
 static void byte_rtc_task(void *pvParameters)
 {
 	int run_count = 0;
@@ -126,8 +215,12 @@ static void byte_rtc_task(void *pvParameters)
 	esp_timer_start_periodic(realtime_stats_timer, 20 * 1000 * 1000);
 	if (s_wifi_event_group != NULL)
 		xEventGroupSetBits(s_wifi_event_group, BIT1);
-	if (ui_Label2 != NULL)
-		lv_label_set_text(ui_Label2, "挂断");
+	// from this task the label only changes through a batch, under the gui lock
+	uint8_t ui_buf[32];
+	qmsd_ui_enc_t ui_enc;
+	qmsd_ui_enc_init(&ui_enc, ui_buf, sizeof(ui_buf));
+	qmsd_ui_enc_text(&ui_enc, UI_WID_Label2, "挂断");
+	qmsd_ui_apply(ui_buf, qmsd_ui_enc_finish(&ui_enc));
 
 	do
 	{
@@ -137,7 +230,7 @@ static void byte_rtc_task(void *pvParameters)
 
 		recorder_pipeline_handle_t pipeline = recorder_pipeline_open();
 		const int default_read_size = recorder_pipeline_get_default_read_size(pipeline);
-		audio_buffer = heap_caps_malloc(default_read_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+		audio_buffer = qmsd_mem_malloc(QMSD_MEM_TAG_RTC, default_read_size, QMSD_MEM_PSRAM);
 		if (!audio_buffer)
 		{
 			break;
@@ -145,6 +238,7 @@ static void byte_rtc_task(void *pvParameters)
 		player_pipeline_handle_t player_pipeline = player_pipeline_open();
 		recorder_pipeline_run(pipeline);
 		player_pipeline_run(player_pipeline);
+		player_pipeline_attach_mp3player(player_pipeline, 1, 5);
 
 		byte_rtc_event_handler_t handler = {0};
 		handler.on_join_room_success = byte_rtc_on_join_room_success;
@@ -169,9 +263,7 @@ static void byte_rtc_task(void *pvParameters)
 		// byte_rtc_set_params(engine, "{\"rtc\":{\"root_path\":\"/littlefs\"}}");
 		// byte_rtc_config_log(engine, NULL, 1024 * 200, 8);
 		byte_rtc_set_params(engine, "{\"debug\":{\"log_to_console\":1}}");
-		byte_rtc_set_params(engine, "{\"rtc\":{\"thread\":{\"pinned_to_core\":1}}}");
-		// byte_rtc_set_params(engine,"{\"rtc\":{\"thread\":{\"stack_size\":16000}}}");
-		byte_rtc_set_params(engine, "{\"rtc\":{\"thread\":{\"priority\":5}}}");
+		byte_rtc_place_engine(engine);
 		// byte_rtc_set_params(engine,"{\"rtc\":{\"license\":{\"enable\":1}}}");
 		byte_rtc_init(engine);
 		byte_rtc_set_audio_codec(engine, AUDIO_CODEC_TYPE_G711A);
@@ -202,13 +294,21 @@ static void byte_rtc_task(void *pvParameters)
 #else
 				byte_rtc_send_audio_data(engine, DEFAULT_ROOMID, audio_buffer, default_read_size, &audio_frame_info);
 #endif
+				qmsd_recorder_push(QMSD_REC_STREAM_UPLINK, AUDIO_CODEC_TYPE_G711A, audio_buffer, default_read_size);
+				qmsd_metric_inc(&s_rtc_uplink_frames);
+				qmsd_metric_add(&s_rtc_uplink_bytes, default_read_size);
 			}
 			if (exit_rtc_task)
 			{
 				break;
 			}
 		}
-		heap_caps_free(audio_buffer);
+		qmsd_mem_free(audio_buffer);
+		audio_buffer = NULL;
+		if (joined)
+		{
+			qmsd_event_bus_publish(qmsd_event_bus_default(), QMSD_EVENT_TOPIC_CALL, QMSD_EVENT_CALL_LEFT, 0, NULL, 0);
+		}
 
 		byte_rtc_fini(engine);
 		while (!fini_notifyed)
@@ -233,7 +333,7 @@ static void byte_rtc_task(void *pvParameters)
 
 	if (audio_buffer)
 	{
-		heap_caps_free(audio_buffer);
+		qmsd_mem_free(audio_buffer);
 	}
 	ESP_LOGI(TAG, "closeRtc");
 	esp_timer_stop(realtime_stats_timer);
@@ -241,7 +341,9 @@ static void byte_rtc_task(void *pvParameters)
 	vTaskDelete(byte_rtc_task); // 从外部删除任务
 }
 void create_lvgl_task(int core_id);
-void rtc_initial(void)
+
+// rtc_initial in steps, so the boot graph can run them as separate stages
+void rtc_net_init(void)
 {
 	ESP_ERROR_CHECK(nvs_flash_init());
 	ESP_ERROR_CHECK(esp_netif_init());
@@ -249,6 +351,42 @@ void rtc_initial(void)
 	esp_log_level_set(TAG, ESP_LOG_INFO);
 	esp_log_level_set("AUDIO_PIPELINE", ESP_LOG_INFO);
 	esp_log_level_set("AUDIO_SYS", ESP_LOG_INFO);
+}
+
+void rtc_connect(void)
+{
+	wifi_config_init();
+	ESP_ERROR_CHECK(qmsd_wifi_start(CONFIG_EXAMPLE_WIFI_SSID, CONFIG_EXAMPLE_WIFI_PASSWORD));
+	// 首次启动或网络变化时可能需要较长时间, 后台会一直重试
+	while (!qmsd_wifi_wait_ip(10000))
+	{
+		ESP_LOGW(TAG, "waiting for wifi...");
+	}
+}
+
+void rtc_bot_start(void)
+{
+	bool is_start = false;
+	// 不断尝试启动 RTCBot
+	while (!is_start)
+	{
+		is_start = startRTCBot();
+		if (!is_start)
+		{
+			ESP_LOGE(TAG, "startRTCBot failed, retrying...");
+			vTaskDelay(pdMS_TO_TICKS(1000)); // 等待 1 秒后重试，避免过于频繁的请求
+		}
+	}
+}
+
+void rtc_task_start(void)
+{
+	qmsd_thread_create(&byte_rtc_task, "byte_rtc_task", 8192, NULL, STATS_TASK_PRIO, NULL, tskNO_AFFINITY, 0);
+}
+
+void rtc_initial(void)
+{
+	rtc_net_init();
 
 	// esp_periph_config_t periph_cfg = DEFAULT_ESP_PERIPH_SET_CONFIG();
 	// esp_periph_set_handle_t set = esp_periph_set_init(&periph_cfg);
@@ -307,22 +445,12 @@ void rtc_initial(void)
 
 	// audio_board_key_init(set);
 #if 1
-	ESP_ERROR_CHECK(example_connect());
-	bool is_start = false;
-	// 不断尝试启动 RTCBot
-	while (!is_start)
-	{
-		is_start = startRTCBot();
-		if (!is_start)
-		{
-			ESP_LOGE(TAG, "startRTCBot failed, retrying...");
-			vTaskDelay(pdMS_TO_TICKS(1000)); // 等待 1 秒后重试，避免过于频繁的请求
-		}
-	}
+	rtc_connect();
+	rtc_bot_start();
 
 	// vTaskDelay(pdMS_TO_TICKS(100));
 	//   xTaskCreatePinnedToCore( &byte_rtc_task,  "byte_rtc_task", 1024*10, NULL, 5, NULL, 1);
-	xTaskCreate(&byte_rtc_task, "byte_rtc_task", 8192, NULL, STATS_TASK_PRIO, NULL);
+	rtc_task_start();
 #endif
 #if 0
     bsp_i2c_init();
@@ -402,6 +530,6 @@ void StartRtc(void)
 	}
 
 	vTaskDelay(pdMS_TO_TICKS(100));
-	xTaskCreate(&byte_rtc_task, "byte_rtc_task", 8192, NULL, STATS_TASK_PRIO, NULL);
+	qmsd_thread_create(&byte_rtc_task, "byte_rtc_task", 8192, NULL, STATS_TASK_PRIO, NULL, tskNO_AFFINITY, 0);
 	// xTaskCreatePinnedToCore(&byte_rtc_task, "byte_rtc_task", 8192, NULL, 5, STATS_TASK_PRIO, 1);
 }
@@ -1,8 +1,20 @@
 #ifndef __VOLCRTCDEMO_H__
 #define __VOLCRTCDEMO_H__
 
+#include "lvgl.h"
 
 void rtc_app(void);
 void StartRtc(void);
 
+void rtc_initial(void);
+void rtc_net_init(void);
+void rtc_connect(void);
+void rtc_bot_start(void);
+void rtc_task_start(void);
+
+// bot subtitles go to this qmsd_transcript view
+void rtc_set_transcript(lv_obj_t *view);
+
+void wifi_config_init(void);
+
 #endif
\ No newline at end of file
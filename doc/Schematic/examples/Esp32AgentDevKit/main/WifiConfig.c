@@ -13,6 +13,9 @@
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "ui_code/ui.h" // LVGL UI 代码
+#include "qmsd_gui.h"
+#include "qmsd_wifi.h"
+#include "qmsd_utils.h"
 
 #define TAG "WIFI_CONFIG"
 extern uint8_t exit_rtc_task;
@@ -27,80 +30,49 @@ static lv_obj_t *kb;
  EventGroupHandle_t s_wifi_event_group;
 const int WIFI_CONNECTED_BIT = BIT0;
 
-// WIFI 事件处理函数
-static void event_handler(void *arg, esp_event_base_t event_base,
-                          int32_t event_id, void *event_data)
+// WIFI 状态回调, 在事件循环任务中执行
+static void wifi_state_cb(qmsd_wifi_state_t state, void *user_data)
 {
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
+    if (state == QMSD_WIFI_STATE_CONNECTED)
     {
-        esp_wifi_connect();
-      
+        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+    }
+    else
+    {
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
-    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
+    // 界面还没创建
+    if (ui_Label5 == NULL || qmsd_gui_lock(portMAX_DELAY) != 0)
     {
-        esp_wifi_connect();
-        lv_label_set_text(ui_Label5, "正在联接...");
-        ESP_LOGI(TAG, "retry to connect to the AP");
+        return;
     }
-    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
+    if (state == QMSD_WIFI_STATE_CONNECTED)
     {
-        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
-        // lv_label_set_text(status_label, "Connected!");
         lv_label_set_text(ui_Label5, "已经联网");
         lv_label_set_text(ui_Label2, " 接通 ");
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
         lv_disp_load_scr(ui_Screen1);
     }
+    else
+    {
+        lv_label_set_text(ui_Label5, "正在联接...");
+    }
+    qmsd_gui_unlock();
 }
 
-// 连接到 WIFI 函数
-static void connect_to_wifi(const char *ssid, const char *password)
+void wifi_config_init(void)
 {
-   // esp_netif_init();
-    s_wifi_event_group = xEventGroupCreate();
-   // esp_event_loop_create_default();
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    esp_wifi_init(&cfg);
-
-    esp_event_handler_instance_register(WIFI_EVENT,
-                                        ESP_EVENT_ANY_ID,
-                                        &event_handler,
-                                        NULL,
-                                        NULL);
-    esp_event_handler_instance_register(IP_EVENT,
-                                        IP_EVENT_STA_GOT_IP,
-                                        &event_handler,
-                                        NULL,
-                                        NULL);
-
-    wifi_config_t wifi_config = {
-        .sta = {
-        //     .ssid = "QMYD2.4G",
-        //     .password = "QMYD13286306350",
-            .ssid = "test",
-            .password = "123456789",
-            /* Setting a password implies station will connect to all security modes including WEP/WPA.
-             * However these modes are deprecated and not advisable to be used. Incase your Access point
-             * doesn't support WPA2, these mode can be enabled by commenting below line */
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .capable = true,
-                .required = false},
-        },
-    };
-    strcpy((char *)wifi_config.sta.ssid, ssid);
-    strcpy((char *)wifi_config.sta.password, password);
-
-    esp_wifi_set_mode(WIFI_MODE_STA);
-    esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config);
-    esp_wifi_start();
+    if (s_wifi_event_group == NULL)
+    {
+        s_wifi_event_group = xEventGroupCreate();
+    }
+    qmsd_wifi_register_cb(wifi_state_cb, NULL);
+}
 
-    ESP_LOGI(TAG, "wifi_init_sta finished.");
-    ESP_LOGI(TAG, "connect to ap SSID:%s password:%s",
-             ssid, password);
+// 连接到 WIFI 函数, 凭据保存后立即重连
+static void connect_to_wifi(const char *ssid, const char *password)
+{
+    esp_err_t err = qmsd_wifi_set_credentials(ssid, password);
+    ESP_LOGI(TAG, "connect to ap SSID:%s %s", ssid, esp_err_to_name(err));
 }
 
 // 连接按钮点击事件回调函数
@@ -201,7 +173,7 @@ void app_main(void)
 
     lvgl_init();
 
-    xTaskCreate(lvgl_task, "lvgl_task", 4096, NULL, 5, NULL);
+    qmsd_thread_create(lvgl_task, "lvgl_task", 4096, NULL, 5, NULL, tskNO_AFFINITY, 0);
 }
 #endif
 
@@ -16,13 +16,71 @@
 
 #include "spiffs_stream.h"
 #include "periph_spiffs.h"
+#include "periph_event_bus.h"
+#include "periph_console.h"
+#include "periph_metrics.h"
+#include "qmsd_metrics_sys.h"
+#include "qmsd_mem_report.h"
+#include "qmsd_event_bus_task.h"
+#include "qmsd_boot.h"
+#include "qmsd_recorder.h"
+#include "qmsd_sched.h"
+#include "ui_code/ui.h"
+#include "ui_wid.h"
+#include "qmsd_transcript.h"
+#include "VolcRTCDemo.h"
 
 #define TAG "QMSD-MAIN"
+// 1: print the boot timeline as chrome trace json once everything is up
+#define BOOT_TRACE_DUMP 0
+
+// Where the tasks run: UI on core 0 next to the wifi driver, audio and the call on core 1.
+// Priority 0 keeps the creator's. The cpu profiler flags any task that ends up elsewhere.
+static const qmsd_task_place_t g_task_plan[] = {
+    {"gui-refresh",   "ui",    0, 0, 0},
+    {"gui-update",    "ui",    0, 0, 0},
+    {"gui-band*",     "render", 1, 0, 0},  // band rendering of gui-update, takes the other core
+    {"touch",         "ui",    0, 0, 0},
+    {"lvgl_task",     "ui",    0, 0, 0},
+    {"byte_rtc_task", "rtc",   1, 5, 0},
+    {"rtc-engine",    "rtc",   1, 5, 0},   // engine thread, set through byte_rtc_set_params
+    {"i2s",           "audio", 1, 0, 0},   // adf elements, by pipeline tag
+    {"algo",          "audio", 1, 0, 0},
+    {"g711a",         "audio", 1, 0, 0},
+    {"opus",          "audio", 1, 0, 0},
+    {"aac",           "audio", 1, 0, 0},
+    {"dec",           "audio", 1, 0, 0},
+    {"mp3player",     "audio", 1, 0, 0},
+    {"sd_capture",    "audio", 1, 0, 0},
+    {"mem_report",    NULL,    QMSD_TASK_CORE_ANY, 1, 0},
+    {"cpu_prof",      NULL,    QMSD_TASK_CORE_ANY, 1, 0},
+};
+
+// monitor_cb runs on the gui task once a frame is drawn and flushed, after the render bands joined
+static void first_frame_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    qmsd_boot_mark("first_frame");
+    drv->monitor_cb = NULL;
+}
 
+// called from qmsd_gui_init, before the gui task starts
 void gui_user_init()
 {
     extern void test_ui();
     ui_init();
+    qmsd_wid_set_table(&ui_wid_table); // 控件 id 表, 见 tools/wid_gen.py
+    ui_wid_bind_all();
+
+    lv_obj_t *transcript = qmsd_transcript_create(ui_Screen1, 4 * 1024); // 智能体字幕, 流式追加
+    if (transcript) {
+        lv_obj_set_size(transcript, lv_pct(90), 64);
+        lv_obj_align(transcript, LV_ALIGN_BOTTOM_MID, 0, -8);
+        lv_obj_set_style_bg_opa(transcript, LV_OPA_TRANSP, 0);
+        lv_obj_set_style_border_width(transcript, 0, 0);
+        lv_obj_set_style_text_font(transcript, &ui_font_Font22, 0);
+        rtc_set_transcript(transcript);
+    }
+    lv_disp_get_default()->driver->monitor_cb = first_frame_cb;
 }
 
 void board_aw9523_device_init(void)
@@ -57,34 +115,106 @@ void board_aw9523_device_init(void)
 }
 
 
-void app_main(void)
+static void boot_periph(void *arg)
 {
-    board_aw9523_device_init();
-
-    ESP_LOGI(TAG, "[ 1 ] 挂载");
     esp_periph_config_t periph_cfg = DEFAULT_ESP_PERIPH_SET_CONFIG(); // 创建外设配置
     esp_periph_set_handle_t set = esp_periph_set_init(&periph_cfg);   // 创建外设集
+    qmsd_event_bus_handle_t bus = qmsd_event_bus_start(32, 10, 0);    // 外设事件总线
+    qmsd_event_bus_set_coalesce(bus, QMSD_EVENT_TOPIC_SENSOR, true);  // 传感器读数只留最新一个
+    esp_periph_set_bridge_event_bus(set, bus);
+
+    static const periph_console_cmd_t console_cmds[] = {
+        PERIPH_METRICS_CONSOLE_CMD,
+    };
+    periph_console_cfg_t console_cfg = {
+        .command_num = sizeof(console_cmds) / sizeof(periph_console_cmd_t),
+        .commands = console_cmds,
+    };
+    esp_periph_start(set, periph_console_init(&console_cfg));        // 串口命令: metrics
+    qmsd_metrics_sys_start(1000);                                    // 堆内存指标, 1 秒采样
+    qmsd_mem_report_start(60 * 1000);                                // 分模块内存统计, 1 分钟打印
+    qmsd_cpu_prof_start(10 * 1000, 0);                               // 每核/每任务 CPU 负载, 10 秒打印
+}
 
-    //--------------------------
-
-    ESP_LOGI(TAG, "[ 2 ] 启动编解码芯片");
-    audio_board_handle_t board_handle = audio_board_init();                                         // 初始化编码芯片
-    audio_hal_ctrl_codec(board_handle->audio_hal, AUDIO_HAL_CODEC_MODE_BOTH, AUDIO_HAL_CTRL_START); // 启动编码芯片
+static void boot_recorder(void *arg)
+{
+    qmsd_recorder_config_t config = QMSD_RECORDER_DEFAULT_CONFIG();
+    if (qmsd_recorder_start(&config) == ESP_OK) {
+        qmsd_recorder_attach_event_bus(qmsd_event_bus_default()); // 通话开始/结束自动录音
+    }
+}
 
-    audio_hal_set_volume(board_handle->audio_hal, 90);
-    ESP_LOGI(TAG, "audio_board & audio_board_key init");
+static void boot_aw9523(void *arg)
+{
+    board_aw9523_device_init();
+}
 
-    gpio_install_isr_service(ESP_INTR_FLAG_SHARED);
+static void boot_board(void *arg)
+{
     qmsd_board_config_t config = QMSD_BOARD_DEFAULT_CONFIG;
     config.board_dir = BOARD_ROTATION_0;
     config.touch.en = 1;
     config.backlight.value = 0;
-    qmsd_board_init(&config);
+    qmsd_board_init(&config); // 屏幕, 触摸, gui (gui_user_init)
     printf("Fine qmsd!\r\n");
+}
 
-    gui_user_init();
+static void boot_codec(void *arg)
+{
+    audio_board_handle_t board_handle = audio_board_init();                                         // 初始化编码芯片
+    audio_hal_ctrl_codec(board_handle->audio_hal, AUDIO_HAL_CODEC_MODE_BOTH, AUDIO_HAL_CTRL_START); // 启动编码芯片
+    audio_hal_set_volume(board_handle->audio_hal, 90);
+    ESP_LOGI(TAG, "audio_board & audio_board_key init");
+}
+
+static void boot_net(void *arg)
+{
+    rtc_net_init();
+}
+
+static void boot_wifi(void *arg)
+{
+    rtc_connect();
+}
 
-    rtc_initial();
+static void boot_bot(void *arg)
+{
+    rtc_bot_start();
+}
+
+static void boot_rtc(void *arg)
+{
+    rtc_task_start();
+    qmsd_boot_mark("call_ready");
+}
+
+void app_main(void)
+{
+    gpio_install_isr_service(ESP_INTR_FLAG_SHARED);
+    qmsd_task_plan_set(g_task_plan, sizeof(g_task_plan) / sizeof(g_task_plan[0]));
+
+    // aw9523, the codec and touch share I2C_NUM_0 through different drivers: keep them in one chain,
+    // in the order they always came up. The network chain shares no hardware with it and runs alongside.
+    int periph = qmsd_boot_add("periph", boot_periph, NULL, 0, 4096, -1);
+    int aw9523 = qmsd_boot_add("aw9523", boot_aw9523, NULL, 0, 3072, 0);
+    int codec = qmsd_boot_add("codec", boot_codec, NULL, QMSD_BOOT_DEP(aw9523), 4096, 0);
+    int board = qmsd_boot_add("board", boot_board, NULL, QMSD_BOOT_DEP(codec), 6144, 0);
+    int net = qmsd_boot_add("net", boot_net, NULL, 0, 4096, 1);
+    int wifi = qmsd_boot_add("wifi", boot_wifi, NULL, QMSD_BOOT_DEP(net), 4096, 1);
+    int bot = qmsd_boot_add("bot", boot_bot, NULL, QMSD_BOOT_DEP(wifi), 8192, 1);
+    // littlefs mount (a format on first boot) only needs the bus; rtc waits for it since it publishes call events
+    int recorder = qmsd_boot_add("recorder", boot_recorder, NULL, QMSD_BOOT_DEP(periph), 4096, 0);
+    int rtc = qmsd_boot_add("rtc", boot_rtc, NULL, QMSD_BOOT_DEP(bot) | QMSD_BOOT_DEP(board) | QMSD_BOOT_DEP(recorder), 3072, -1);
+    qmsd_boot_start(5);
+
+    uint32_t all = QMSD_BOOT_DEP(periph) | QMSD_BOOT_DEP(board) | QMSD_BOOT_DEP(rtc);
+    if (!qmsd_boot_wait(all, 30 * 1000)) {
+        ESP_LOGW(TAG, "boot not finished after 30 s");
+    }
+    qmsd_boot_print();
+#if BOOT_TRACE_DUMP
+    qmsd_boot_dump_trace();
+#endif
     while (1)
     {
         vTaskDelay(1000 / portTICK_PERIOD_MS);
@@ -0,0 +1,59 @@
+// Generated by tools/wid_gen.py from ui_code/ui.h, do not edit.
+
+#include "ui_wid.h"
+#include "qmsd_ui_ctrl.h"
+#include "ui_code/ui.h"
+
+static const char* const g_names[] = {
+    "ui_Screen1",
+    "ui_Image1",
+    "ui_Button1",
+    "ui_Label1",
+    "ui_Label2",
+    "ui_configwifi",
+    "ui_TextArea1",
+    "ui_TextArea2",
+    "ui_Label3",
+    "ui_Label4",
+    "ui_Keyboard1",
+    "ui_Button3",
+    "ui_Label5",
+    "ui____initial_actions0",
+};
+
+static const uint16_t g_disp[] = {
+    4, 8, 2, 10,
+};
+
+static const uint16_t g_slots[] = {
+    10, 0xffff, 9, 5, 4, 12, 3, 0, 11, 1, 0xffff, 7,
+    6, 2, 13, 8,
+};
+
+const qmsd_wid_table_t ui_wid_table = {
+    .seed = 0,
+    .num = 14,
+    .bucket_mask = 3,
+    .slot_mask = 15,
+    .disp = g_disp,
+    .slots = g_slots,
+    .names = g_names,
+};
+
+void ui_wid_bind_all(void)
+{
+    qmsd_ui_bind(UI_WID_Screen1, ui_Screen1);
+    qmsd_ui_bind(UI_WID_Image1, ui_Image1);
+    qmsd_ui_bind(UI_WID_Button1, ui_Button1);
+    qmsd_ui_bind(UI_WID_Label1, ui_Label1);
+    qmsd_ui_bind(UI_WID_Label2, ui_Label2);
+    qmsd_ui_bind(UI_WID_configwifi, ui_configwifi);
+    qmsd_ui_bind(UI_WID_TextArea1, ui_TextArea1);
+    qmsd_ui_bind(UI_WID_TextArea2, ui_TextArea2);
+    qmsd_ui_bind(UI_WID_Label3, ui_Label3);
+    qmsd_ui_bind(UI_WID_Label4, ui_Label4);
+    qmsd_ui_bind(UI_WID_Keyboard1, ui_Keyboard1);
+    qmsd_ui_bind(UI_WID_Button3, ui_Button3);
+    qmsd_ui_bind(UI_WID_Label5, ui_Label5);
+    qmsd_ui_bind(UI_WID____initial_actions0, ui____initial_actions0);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Generated by tools/wid_gen.py from ui_code/ui.h, do not edit.
+
+#include "qmsd_wid.h"
+
+#define UI_WID_Screen1              0
+#define UI_WID_Image1               1
+#define UI_WID_Button1              2
+#define UI_WID_Label1               3
+#define UI_WID_Label2               4
+#define UI_WID_configwifi           5
+#define UI_WID_TextArea1            6
+#define UI_WID_TextArea2            7
+#define UI_WID_Label3               8
+#define UI_WID_Label4               9
+#define UI_WID_Keyboard1            10
+#define UI_WID_Button3              11
+#define UI_WID_Label5               12
+#define UI_WID____initial_actions0  13
+#define UI_WID_NUM                  14
+
+extern const qmsd_wid_table_t ui_wid_table;
+
+// Binds every widget of the table to its object, after ui_init.
+void ui_wid_bind_all(void);
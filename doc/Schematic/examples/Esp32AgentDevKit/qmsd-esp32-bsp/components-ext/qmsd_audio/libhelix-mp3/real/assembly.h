@@ -414,7 +414,7 @@ static __inline Word64 SAR64(Word64 x, int n)
 	return (x >> n);
 }
 
-#else
+#elif defined(__XTENSA__)
 
 // #error Unsupported platform in assembly.h
 
@@ -440,14 +440,15 @@ static __inline int MULSHIFT32(int x, int y)
 	 *   require an extra "mov r0, r1")
      */
 	int ret;
-    asm volatile ("mulsh %0, %1, %2" : "=r" (ret) : "r" (x), "r" (y));
+    /* not volatile: a pure op, lets gcc interleave the mulsh with the loads of the next taps */
+    asm ("mulsh %0, %1, %2" : "=r" (ret) : "r" (x), "r" (y));
     return ret;
 }
 
 static __inline int FASTABS(int x) 
 {
 	int ret;
-    asm volatile ("abs %0, %1" : "=r" (ret) : "r" (x));
+    asm ("abs %0, %1" : "=r" (ret) : "r" (x));
     return ret;
 }
 
@@ -461,6 +462,53 @@ static __inline int CLZ(int x)
 	return __builtin_clz(x);
 }
 
+#else
+
+/* portable C, for host builds of testwrap */
+typedef long long Word64;
+
+static __inline Word64 MADD64(Word64 sum64, int x, int y)
+{
+	return (sum64 + ((long long)x * y));
+}
+
+static __inline int MULSHIFT32(int x, int y)
+{
+	return (int)(((long long)x * y) >> 32);
+}
+
+static __inline int FASTABS(int x) 
+{
+	int sign;
+
+	sign = x >> (sizeof(int) * 8 - 1);
+	x ^= sign;
+	x -= sign;
+
+	return x;
+}
+
+static __inline Word64 SAR64(Word64 x, int n)
+{
+	return x >> n;
+}
+
+static __inline int CLZ(int x)
+{
+	int numZeros;
+
+	if (!x)
+		return (sizeof(int) * 8);
+
+	numZeros = 0;
+	while (!(x & 0x80000000)) {
+		numZeros++;
+		x <<= 1;
+	} 
+
+	return numZeros;
+}
+
 #endif
 
 #endif	/* platforms */
@@ -42,9 +42,11 @@
  *
  * This is the C reference version using __int64
  * Look in the appropriate subdirectories for optimized asm implementations 
- *   (e.g. arm/asmpoly.s)
+ *   (e.g. arm/asmpoly.s, xtensa/xtpoly.c when HELIX_FAST_KERNELS is defined)
  **************************************************************************************/
 
+#ifndef HELIX_FAST_KERNELS
+
 #include "coder.h"
 #include "assembly.h"
 
@@ -293,3 +295,5 @@ void PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase)
 		pcm += 2;
 	}
 }
+
+#endif	/* HELIX_FAST_KERNELS */
@@ -0,0 +1,218 @@
+/**************************************************************************************
+ * xtpoly.c - polyphase synthesis filter for cores without a 64-bit mac (Xtensa LX7)
+ *
+ * Bit exact replacement for real/polyphase.c, selected with HELIX_FAST_KERNELS.
+ *
+ * polyphase.c accumulates 32x32 -> 64 products and keeps (sum >> 20). Xtensa has
+ * mull (low 32 bits) and mulsh (high 32 bits) but no carry, so every MADD64 costs
+ * two multiplies plus a compare-and-branch to propagate the carry. Here the sum
+ * is split instead:
+ *
+ *   hi += mulsh(x, c << 12)     = floor(x*c / 2^20), exact: c has 12 sign bits (CSHIFT)
+ *   lo += mull(x, c)            = x*c mod 2^32
+ *
+ * Both wrap freely. After 16 taps the dropped fraction bits, sum(x*c) - hi * 2^20,
+ * are inside (-2^24, 2^24), so they are recovered exactly as lo - (hi << 20), and
+ *
+ *   (int)SAR64(rnd + sum(x*c), 20) == hi + ((lo - (hi << 20) + rnd) >> 20)
+ *
+ * The -c2 taps subtract both halves instead of negating c2, the fraction then
+ * goes negative, which the same formula covers. ESP32-S3 PIE / MAC16 lanes are
+ * 16 bits wide with 40-bit accumulators, too narrow for these 32-bit taps, so
+ * this stays on the scalar multiplier.
+ **************************************************************************************/
+
+#ifdef HELIX_FAST_KERNELS
+
+#include "coder.h"
+#include "assembly.h"
+
+#define DEF_NFRACBITS	(DQ_FRACBITS_OUT - 2 - 2 - 15)
+#define CSHIFT			12
+#define RND_VAL			(1 << (DEF_NFRACBITS - 1 + (32 - CSHIFT)))
+
+/* gcc emits a single mulsh for this, unlike the asm volatile MULSHIFT32 it can be scheduled */
+static __inline int MulHi(int x, int y)
+{
+	return (int)(((long long)x * y) >> 32);
+}
+
+static __inline short ClipToShort(int x, int fracBits)
+{
+	int sign;
+
+	x >>= fracBits;
+
+	sign = x >> 31;
+	if (sign != (x >> 15))
+		x = sign ^ ((1 << 15) - 1);
+
+	return (short)x;
+}
+
+static __inline short SplitToShort(int hi, unsigned int lo)
+{
+	int frac = (int)(lo - ((unsigned int)hi << (32 - CSHIFT)));
+
+	return ClipToShort(hi + ((frac + RND_VAL) >> (32 - CSHIFT)), DEF_NFRACBITS);
+}
+
+#define MAC(h, l, v, c)	{ h += MulHi(v, (c) << CSHIFT);	l += (unsigned int)(v) * (unsigned int)(c); }
+#define MSU(h, l, v, c)	{ h -= MulHi(v, (c) << CSHIFT);	l -= (unsigned int)(v) * (unsigned int)(c); }
+
+#define XC0M(x)	{ \
+	c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+	vLo = *(vb1+(x));			vHi = *(vb1+(23-(x))); \
+	MAC(h1L, l1L, vLo, c1)	MSU(h1L, l1L, vHi, c2) \
+}
+
+#define XC1M(x)	{ \
+	c1 = *coef;		coef++; \
+	vLo = *(vb1+(x)); \
+	MAC(h1L, l1L, vLo, c1) \
+}
+
+#define XC2M(x)	{ \
+	c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+	vLo = *(vb1+(x));	vHi = *(vb1+(23-(x))); \
+	MAC(h1L, l1L, vLo, c1)	MAC(h2L, l2L, vLo, c2) \
+	MSU(h1L, l1L, vHi, c2)	MAC(h2L, l2L, vHi, c1) \
+}
+
+/**************************************************************************************
+ * Function:    PolyphaseMono
+ *
+ * Description: same contract as PolyphaseMono in polyphase.c
+ **************************************************************************************/
+void PolyphaseMono(short *pcm, int *vbuf, const int *coefBase)
+{
+	int i;
+	const int *coef;
+	int *vb1;
+	int vLo, vHi, c1, c2;
+	int h1L, h2L;
+	unsigned int l1L, l2L;
+
+	/* special case, output sample 0 */
+	coef = coefBase;
+	vb1 = vbuf;
+	h1L = 0;	l1L = 0;
+
+	XC0M(0)	XC0M(1)	XC0M(2)	XC0M(3)
+	XC0M(4)	XC0M(5)	XC0M(6)	XC0M(7)
+
+	*(pcm + 0) = SplitToShort(h1L, l1L);
+
+	/* special case, output sample 16 */
+	coef = coefBase + 256;
+	vb1 = vbuf + 64*16;
+	h1L = 0;	l1L = 0;
+
+	XC1M(0)	XC1M(1)	XC1M(2)	XC1M(3)
+	XC1M(4)	XC1M(5)	XC1M(6)	XC1M(7)
+
+	*(pcm + 16) = SplitToShort(h1L, l1L);
+
+	/* main convolution loop: h1L = samples 1, 2, 3, ... 15   h2L = samples 31, 30, ... 17 */
+	coef = coefBase + 16;
+	vb1 = vbuf + 64;
+	pcm++;
+
+	for (i = 15; i > 0; i--) {
+		h1L = h2L = 0;
+		l1L = l2L = 0;
+
+		XC2M(0)	XC2M(1)	XC2M(2)	XC2M(3)
+		XC2M(4)	XC2M(5)	XC2M(6)	XC2M(7)
+
+		vb1 += 64;
+		*(pcm)       = SplitToShort(h1L, l1L);
+		*(pcm + 2*i) = SplitToShort(h2L, l2L);
+		pcm++;
+	}
+}
+
+#define XC0S(x)	{ \
+	c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+	vLo = *(vb1+(x));		vHi = *(vb1+(23-(x))); \
+	MAC(h1L, l1L, vLo, c1)	MSU(h1L, l1L, vHi, c2) \
+	vLo = *(vb1+32+(x));	vHi = *(vb1+32+(23-(x))); \
+	MAC(h1R, l1R, vLo, c1)	MSU(h1R, l1R, vHi, c2) \
+}
+
+#define XC1S(x)	{ \
+	c1 = *coef;		coef++; \
+	vLo = *(vb1+(x)); \
+	MAC(h1L, l1L, vLo, c1) \
+	vLo = *(vb1+32+(x)); \
+	MAC(h1R, l1R, vLo, c1) \
+}
+
+#define XC2S(x)	{ \
+	c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+	vLo = *(vb1+(x));	vHi = *(vb1+(23-(x))); \
+	MAC(h1L, l1L, vLo, c1)	MAC(h2L, l2L, vLo, c2) \
+	MSU(h1L, l1L, vHi, c2)	MAC(h2L, l2L, vHi, c1) \
+	vLo = *(vb1+32+(x));	vHi = *(vb1+32+(23-(x))); \
+	MAC(h1R, l1R, vLo, c1)	MAC(h2R, l2R, vLo, c2) \
+	MSU(h1R, l1R, vHi, c2)	MAC(h2R, l2R, vHi, c1) \
+}
+
+/**************************************************************************************
+ * Function:    PolyphaseStereo
+ *
+ * Description: same contract as PolyphaseStereo in polyphase.c, interleaves LRLRLR...
+ **************************************************************************************/
+void PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase)
+{
+	int i;
+	const int *coef;
+	int *vb1;
+	int vLo, vHi, c1, c2;
+	int h1L, h2L, h1R, h2R;
+	unsigned int l1L, l2L, l1R, l2R;
+
+	/* special case, output sample 0 */
+	coef = coefBase;
+	vb1 = vbuf;
+	h1L = h1R = 0;	l1L = l1R = 0;
+
+	XC0S(0)	XC0S(1)	XC0S(2)	XC0S(3)
+	XC0S(4)	XC0S(5)	XC0S(6)	XC0S(7)
+
+	*(pcm + 0) = SplitToShort(h1L, l1L);
+	*(pcm + 1) = SplitToShort(h1R, l1R);
+
+	/* special case, output sample 16 */
+	coef = coefBase + 256;
+	vb1 = vbuf + 64*16;
+	h1L = h1R = 0;	l1L = l1R = 0;
+
+	XC1S(0)	XC1S(1)	XC1S(2)	XC1S(3)
+	XC1S(4)	XC1S(5)	XC1S(6)	XC1S(7)
+
+	*(pcm + 2*16 + 0) = SplitToShort(h1L, l1L);
+	*(pcm + 2*16 + 1) = SplitToShort(h1R, l1R);
+
+	/* main convolution loop: h1L = samples 1, 2, 3, ... 15   h2L = samples 31, 30, ... 17 */
+	coef = coefBase + 16;
+	vb1 = vbuf + 64;
+	pcm += 2;
+
+	for (i = 15; i > 0; i--) {
+		h1L = h2L = h1R = h2R = 0;
+		l1L = l2L = l1R = l2R = 0;
+
+		XC2S(0)	XC2S(1)	XC2S(2)	XC2S(3)
+		XC2S(4)	XC2S(5)	XC2S(6)	XC2S(7)
+
+		vb1 += 64;
+		*(pcm + 0)         = SplitToShort(h1L, l1L);
+		*(pcm + 1)         = SplitToShort(h1R, l1R);
+		*(pcm + 2*2*i + 0) = SplitToShort(h2L, l2L);
+		*(pcm + 2*2*i + 1) = SplitToShort(h2R, l2R);
+		pcm += 2;
+	}
+}
+
+#endif	/* HELIX_FAST_KERNELS */
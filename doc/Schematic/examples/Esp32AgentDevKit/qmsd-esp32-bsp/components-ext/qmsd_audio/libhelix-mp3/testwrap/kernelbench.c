@@ -0,0 +1,218 @@
+/**************************************************************************************
+ * kernelbench.c - host profile of the libhelix hot kernels
+ *
+ * Decodes every file of a corpus and times each call of
+ *   IMDCT, FDCT32, PolyphaseMono/Stereo (polyphase.c)
+ * through -Wl,--wrap, and runs the split accumulator polyphase (xtensa/xtpoly.c)
+ * on the same vbuf as the reference, every output must be identical.
+ *
+ * Time is reported as MCPS, million cycles per second of audio at the given clock.
+ * The timer ticks in us, far coarser than one call, but the start of a call is
+ * not locked to the tick so the sum over many calls is unbiased; the cost of
+ * reading the timer itself is measured once and taken out.
+ *
+ * usage: kernelbench [-m mhz] file.mp3 ...
+ **************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "mp3dec.h"
+#include "coder.h"
+#include "timing.h"
+
+enum {
+	K_IMDCT = 0,
+	K_FDCT32,
+	K_POLY_REF,
+	K_POLY_SPLIT,
+	K_NUM,
+};
+
+static const char *kernelName[K_NUM] = {
+	"IMDCT", "FDCT32", "polyphase ref", "polyphase split",
+};
+
+static double kernelTime[K_NUM];
+static unsigned long kernelCalls[K_NUM];
+static unsigned long polyMismatch;
+static double timerCost;
+
+/* the reference kernels, renamed by the linker */
+int __real_xmp3_IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch);
+void __real_xmp3_FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb);
+void __real_xmp3_PolyphaseMono(short *pcm, int *vbuf, const int *coefBase);
+void __real_xmp3_PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase);
+
+/* xtpoly.c, symbols renamed with objcopy */
+void split_PolyphaseMono(short *pcm, int *vbuf, const int *coefBase);
+void split_PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase);
+
+#define TIMED(k, call)	{ \
+	UINT t = ReadTimer(); \
+	call; \
+	kernelTime[k] += CalcTimeDifference(t, ReadTimer()) - timerCost; \
+	kernelCalls[k]++; \
+}
+
+int __wrap_xmp3_IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch)
+{
+	int ret;
+
+	TIMED(K_IMDCT, ret = __real_xmp3_IMDCT(mp3DecInfo, gr, ch))
+	return ret;
+}
+
+void __wrap_xmp3_FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb)
+{
+	TIMED(K_FDCT32, __real_xmp3_FDCT32(buf, dest, offset, oddBlock, gb))
+}
+
+void __wrap_xmp3_PolyphaseMono(short *pcm, int *vbuf, const int *coefBase)
+{
+	short split[NBANDS];
+
+	TIMED(K_POLY_REF, __real_xmp3_PolyphaseMono(pcm, vbuf, coefBase))
+	TIMED(K_POLY_SPLIT, split_PolyphaseMono(split, vbuf, coefBase))
+	if (memcmp(pcm, split, sizeof(split)))
+		polyMismatch++;
+}
+
+void __wrap_xmp3_PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase)
+{
+	short split[2 * NBANDS];
+
+	TIMED(K_POLY_REF, __real_xmp3_PolyphaseStereo(pcm, vbuf, coefBase))
+	TIMED(K_POLY_SPLIT, split_PolyphaseStereo(split, vbuf, coefBase))
+	if (memcmp(pcm, split, sizeof(split)))
+		polyMismatch++;
+}
+
+static void CalibrateTimer(void)
+{
+	UINT t, sum = 0;
+	int i, n = 1000000;
+
+	for (i = 0; i < n; i++) {
+		t = ReadTimer();
+		sum += CalcTimeDifference(t, ReadTimer());
+	}
+	timerCost = (double)sum / n;
+}
+
+/* the split kernel needs c << 12 to be exact */
+static int CheckCoefRange(void)
+{
+	int i;
+
+	for (i = 0; i < 264; i++) {
+		if (((polyCoef[i] << 12) >> 12) != polyCoef[i])
+			return -1;
+	}
+	return 0;
+}
+
+static int DecodeFile(const char *name, double *audioSec)
+{
+	short outBuf[MAX_NCHAN * MAX_NGRAN * MAX_NSAMP];
+	unsigned char *mp3, *readPtr;
+	MP3FrameInfo info;
+	HMP3Decoder dec;
+	FILE *infile;
+	long len;
+	int bytesLeft, err, frames = 0;
+
+	infile = fopen(name, "rb");
+	if (!infile)
+		return -1;
+	fseek(infile, 0, SEEK_END);
+	len = ftell(infile);
+	fseek(infile, 0, SEEK_SET);
+	mp3 = (unsigned char *)malloc(len);
+	if (!mp3 || fread(mp3, 1, len, infile) != (size_t)len) {
+		fclose(infile);
+		free(mp3);
+		return -1;
+	}
+	fclose(infile);
+
+	dec = MP3InitDecoder();
+	readPtr = mp3;
+	bytesLeft = (int)len;
+	for (;;) {
+		err = MP3FindSyncWord(readPtr, bytesLeft);
+		if (err < 0)
+			break;
+		readPtr += err;
+		bytesLeft -= err;
+		err = MP3Decode(dec, &readPtr, &bytesLeft, outBuf, 0);
+		if (err == ERR_MP3_MAINDATA_UNDERFLOW)
+			continue;
+		if (err == ERR_MP3_INVALID_FRAMEHEADER) {
+			/* false sync inside a tag or junk, step over it */
+			readPtr++;
+			bytesLeft--;
+			continue;
+		}
+		if (err)
+			break;
+		MP3GetLastFrameInfo(dec, &info);
+		*audioSec += (double)info.outputSamps / info.nChans / info.samprate;
+		frames++;
+	}
+	MP3FreeDecoder(dec);
+	free(mp3);
+	return frames;
+}
+
+int main(int argc, char **argv)
+{
+	double audioSec = 0, mhz = 240;
+	int i, frames, files = 0;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-m") && i + 1 < argc)
+			mhz = atof(argv[++i]);
+	}
+	if (i >= argc) {
+		printf("usage: kernelbench [-m mhz] file.mp3 ...\n");
+		return -1;
+	}
+	if (CheckCoefRange()) {
+		printf("polyCoef does not fit in 20 bits, split polyphase is not exact\n");
+		return 1;
+	}
+
+	InitTimer();
+	CalibrateTimer();
+	for (; i < argc; i++) {
+		frames = DecodeFile(argv[i], &audioSec);
+		if (frames < 0) {
+			printf("%s: open error\n", argv[i]);
+			continue;
+		}
+		printf("%s: %d frames\n", argv[i], frames);
+		files++;
+	}
+	FreeTimer();
+	if (audioSec <= 0) {
+		printf("no audio decoded\n");
+		return -1;
+	}
+
+	/* us of cpu per s of audio == MHz of a core kept busy at this speed */
+	printf("%d files, %.2f s audio, timer cost %.3f us, MCPS at %.0f MHz host clock\n", files, audioSec, timerCost, mhz);
+	for (i = 0; i < K_NUM; i++) {
+		double us = kernelTime[i] * 1000000.0 / GetClockFrequency();
+		printf("%-16s calls %8lu  %8.3f us/call  %7.2f MCPS\n", kernelName[i], kernelCalls[i],
+			kernelCalls[i] ? us / kernelCalls[i] : 0.0, us / 1000000.0 / audioSec * mhz);
+	}
+
+	if (polyMismatch) {
+		printf("polyphase MISMATCH in %lu blocks\n", polyMismatch);
+		return 1;
+	}
+	printf("polyphase split identical\n");
+	return 0;
+}
@@ -0,0 +1,197 @@
+/**************************************************************************************
+ * mp3bench.c - host benchmark of the qmsd mp3player input paths
+ *
+ * Decodes the same file through
+ *   staging:   the old mp3player loop, memmove + memcpy into a MAINBUF_SIZE buffer per frame
+ *   zerocopy:  mp3_source over the file in memory, the decoder reads it in place
+ *   window:    mp3_source over stdio, a window compacted only when it runs out
+ * and checks that all three produce the same PCM.
+ *
+ * usage: mp3bench infile.mp3 [loops]
+ **************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "mp3dec.h"
+#include "mp3_source.h"
+#include "timing.h"
+
+typedef struct {
+	const char *name;
+	int frames;
+	unsigned int decTime;
+	unsigned int totalTime;
+	unsigned long copied;
+	unsigned int pcmHash;
+	unsigned long pcmBytes;
+} BenchResult;
+
+static void HashPCM(BenchResult *res, const short *pcm, int bytes)
+{
+	const unsigned char *p = (const unsigned char *)pcm;
+	int i;
+
+	for (i = 0; i < bytes; i++)
+		res->pcmHash = (res->pcmHash ^ p[i]) * 0x01000193;
+	res->pcmBytes += bytes;
+}
+
+/* what mp3player_task did before mp3_source */
+static void BenchStaging(HMP3Decoder dec, const unsigned char *mp3, int len, BenchResult *res)
+{
+	static unsigned char readBuf[MAINBUF_SIZE];
+	short outBuf[MAX_NCHAN * MAX_NGRAN * MAX_NSAMP];
+	MP3FrameInfo info;
+	unsigned char *readPtr = readBuf;
+	int bytesLeft = 0, offset = 0, err, nRead, t;
+
+	for (;;) {
+		if (bytesLeft < MAINBUF_SIZE) {
+			memmove(readBuf, readPtr, bytesLeft);
+			nRead = MAINBUF_SIZE - bytesLeft;
+			if (nRead > len - offset)
+				nRead = len - offset;
+			memcpy(readBuf + bytesLeft, mp3 + offset, nRead);
+			res->copied += bytesLeft + nRead;
+			offset += nRead;
+			bytesLeft += nRead;
+			readPtr = readBuf;
+		}
+		err = MP3FindSyncWord(readPtr, bytesLeft);
+		if (err < 0)
+			break;
+		readPtr += err;
+		bytesLeft -= err;
+
+		t = ReadTimer();
+		err = MP3Decode(dec, &readPtr, &bytesLeft, outBuf, 0);
+		res->decTime += CalcTimeDifference(t, ReadTimer());
+		if (err == ERR_MP3_INDATA_UNDERFLOW)
+			break;
+		if (err == ERR_MP3_MAINDATA_UNDERFLOW)
+			continue;
+		if (err)
+			break;
+		MP3GetLastFrameInfo(dec, &info);
+		HashPCM(res, outBuf, info.outputSamps * info.bitsPerSample / 8);
+		res->frames++;
+	}
+}
+
+static void BenchSource(HMP3Decoder dec, mp3_source_t *src, BenchResult *res)
+{
+	short outBuf[MAX_NCHAN * MAX_NGRAN * MAX_NSAMP];
+	MP3FrameInfo info;
+	int ret, t;
+
+	for (;;) {
+		t = ReadTimer();
+		ret = mp3_source_decode(src, dec, outBuf, 0);
+		res->decTime += CalcTimeDifference(t, ReadTimer());
+		if (ret < 0)
+			break;
+		if (ret == 0)
+			continue;
+		MP3GetLastFrameInfo(dec, &info);
+		HashPCM(res, outBuf, info.outputSamps * info.bitsPerSample / 8);
+		res->frames++;
+	}
+	res->copied += src->copied;
+}
+
+static void PrintResult(const BenchResult *res, int loops)
+{
+	printf("%-9s frames %6d  decode %8.2f ms  total %8.2f ms  copied %9lu B  pcm %9lu B  hash %08x\n",
+		res->name, res->frames / loops, res->decTime / 1000.0f / loops, res->totalTime / 1000.0f / loops,
+		res->copied / loops, res->pcmBytes / loops, res->pcmHash);
+}
+
+int main(int argc, char **argv)
+{
+	BenchResult res[3];
+	unsigned char *mp3;
+	FILE *infile;
+	long len;
+	int loops, i, t, id3Skip;
+	HMP3Decoder dec;
+	mp3_source_t src;
+
+	if (argc < 2) {
+		printf("usage: mp3bench infile.mp3 [loops]\n");
+		return -1;
+	}
+	loops = argc > 2 ? atoi(argv[2]) : 20;
+	if (loops < 1)
+		loops = 1;
+
+	infile = fopen(argv[1], "rb");
+	if (!infile) {
+		printf("file open error\n");
+		return -1;
+	}
+	fseek(infile, 0, SEEK_END);
+	len = ftell(infile);
+	fseek(infile, 0, SEEK_SET);
+	mp3 = (unsigned char *)malloc(len);
+	if (!mp3 || fread(mp3, 1, len, infile) != (size_t)len) {
+		printf("file read error\n");
+		return -1;
+	}
+	fclose(infile);
+
+	/* the staging loop skipped the tag the same way */
+	mp3_source_init_memory(&src, mp3, len);
+	mp3_source_skip_id3(&src, 0);
+	id3Skip = src.start;
+
+	InitTimer();
+	memset(res, 0, sizeof(res));
+	res[0].name = "staging";
+	res[1].name = "zerocopy";
+	res[2].name = "window";
+
+	for (i = 0; i < loops; i++) {
+		dec = MP3InitDecoder();
+		t = ReadTimer();
+		BenchStaging(dec, mp3 + id3Skip, len - id3Skip, &res[0]);
+		res[0].totalTime += CalcTimeDifference(t, ReadTimer());
+		MP3FreeDecoder(dec);
+
+		dec = MP3InitDecoder();
+		t = ReadTimer();
+		mp3_source_init_memory(&src, mp3, len);
+		mp3_source_skip_id3(&src, 0);
+		BenchSource(dec, &src, &res[1]);
+		mp3_source_close(&src);
+		res[1].totalTime += CalcTimeDifference(t, ReadTimer());
+		MP3FreeDecoder(dec);
+
+		dec = MP3InitDecoder();
+		t = ReadTimer();
+		if (mp3_source_init_file(&src, argv[1]) != 0) {
+			printf("file open error\n");
+			return -1;
+		}
+		mp3_source_skip_id3(&src, 0);
+		BenchSource(dec, &src, &res[2]);
+		mp3_source_close(&src);
+		res[2].totalTime += CalcTimeDifference(t, ReadTimer());
+		MP3FreeDecoder(dec);
+	}
+
+	printf("%s: %ld bytes, %d loops\n", argv[1], len, loops);
+	for (i = 0; i < 3; i++)
+		PrintResult(&res[i], loops);
+
+	free(mp3);
+	FreeTimer();
+
+	if (res[1].pcmHash != res[0].pcmHash || res[2].pcmHash != res[0].pcmHash || res[1].pcmBytes != res[0].pcmBytes) {
+		printf("PCM MISMATCH\n");
+		return 1;
+	}
+	printf("PCM identical\n");
+	return 0;
+}
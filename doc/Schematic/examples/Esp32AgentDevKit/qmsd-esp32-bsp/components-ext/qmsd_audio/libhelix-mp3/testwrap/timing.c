@@ -86,6 +86,43 @@ UINT CalcTimeDifference(UINT startTime, UINT endTime)
     else
 		return (endTime - startTime);
 }
+#elif defined (__unix__) || defined (__APPLE__)
+
+#include <time.h>
+
+/* host benchmark: 1 us ticks from the monotonic clock */
+int InitTimer(void)
+{
+    return 0;
+}
+
+UINT ReadTimer(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UINT)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+int FreeTimer(void)
+{
+    return 0;
+}
+
+UINT GetClockFrequency(void)
+{
+    return 1000000;
+}
+
+UINT GetClockDivFactor(void)
+{
+    return 1;
+}
+
+UINT CalcTimeDifference(UINT startTime, UINT endTime)
+{
+    /* 32-bit counter, wraps */
+    return endTime - startTime;
+}
 #elif defined (_WIN32) && defined (_WIN32_WCE)
 
 #include <windows.h>
@@ -2,6 +2,7 @@
 
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -10,9 +11,15 @@
 #include "freertos/stream_buffer.h"
 #include "mp3dec.h"
 #include "mp3_player.h"
+#include "qmsd_metrics.h"
+#include "qmsd_sched.h"
 
-#define MP3_INBUFF_SIZE  MAINBUF_SIZE
 #define MP3_OUTBUFF_SIZE (1152 * 2)
+// how long a stream source may stall before the stop bits are looked at again
+#define MP3_READ_TIMEOUT_MS 100
+#define MP3_ID3_TIMEOUT_MS  1000
+// same for a sink that takes no pcm, e.g. a stopped i2s element
+#define MP3_WRITE_TIMEOUT_MS 100
 
 #define MP3_EVENT_DECODEING        (BIT0)
 #define MP3_EVENT_RESUME           (BIT1)
@@ -23,24 +30,15 @@
 
 static const char *TAG = "mp3_player";
 
-typedef struct {
-    char header[3];     /*!< Always "ID3" */
-    char ver;           /*!< Version, equals to3 if ID3V2.3 */
-    char revision;      /*!< Revision, should be 0 */
-    char flag;          /*!< Flag byte, use Bit[7..5] only */
-    char size[4];       /*!< TAG size */
-} __attribute__((packed)) mp3_id3_header_v2_t;
-
-typedef struct _mp3_player_t {
-    const uint8_t* buffer;
-    uint32_t length;
-    uint32_t buffer_offset;
-} mp3player_info_t;
-
+QMSD_METRIC_COUNTER(s_mp3_frames, "audio.mp3.frames");
+QMSD_METRIC_COUNTER(s_mp3_stalls, "audio.mp3.stalls");
+// source read included, a frame is 24 ms at 48 kHz
+QMSD_METRIC_HISTOGRAM(s_mp3_decode_us, "audio.mp3.decode_us", 2000, 4000, 8000, 16000, 32000);
+// time blocked on a full sink
+QMSD_METRIC_HISTOGRAM(s_mp3_sink_us, "audio.mp3.sink_us", 1000, 5000, 20000, 50000);
 
 typedef struct _mp3_decode_t {
     HMP3Decoder mp3_decoder;
-    uint8_t read_buffer[MP3_INBUFF_SIZE];
     uint8_t dst_channel; 
     uint8_t task_core;
     uint8_t task_prio;
@@ -54,28 +52,24 @@ typedef struct _mp3_decode_t {
 
     mp3plyaer_update_fun_t info_update;
     StreamBufferHandle_t stream;
+    mp3player_sink_t sink;
 } mp3_decode_t;
 
 static mp3_decode_t* decoder;
 
 static void mp3player_task(void *arg);
 
-static uint32_t mp3player_read_buffer(mp3player_info_t* info, uint8_t* buffer, uint32_t length) {
-    uint32_t need_read = length;
-    if (length + info->buffer_offset > info->length) {
-        need_read = info->length - info->buffer_offset;
+// false when a stop came in before the sink took all of it
+static bool mp3player_sink_push(const uint8_t* pcm, uint32_t len) {
+    while (len > 0) {
+        if (xEventGroupGetBits(decoder->event_group) & MP3_EVENT_STOP) {
+            return false;
+        }
+        uint32_t written = decoder->sink.write(decoder->sink.ctx, pcm, len, MP3_WRITE_TIMEOUT_MS);
+        pcm += written;
+        len -= written;
     }
-    memcpy(buffer, info->buffer + info->buffer_offset, need_read);
-    info->buffer_offset += need_read;
-    return need_read;
-}
-
-static int mp3player_fill_valid_buffer(mp3player_info_t* info, uint8_t* buffer, uint32_t data_left) {
-    memmove(decoder->read_buffer, buffer, data_left);
-    uint32_t unspace_left = MP3_INBUFF_SIZE - data_left;
-    uint32_t read_size = 0;
-    read_size = mp3player_read_buffer(info, decoder->read_buffer + data_left, unspace_left);
-    return read_size;
+    return true;
 }
 
 void mp3player_resume() {
@@ -119,36 +113,43 @@ void mp3player_init(mp3plyaer_update_fun_t update_fun, uint8_t task_core, uint8_
     decoder->stream = xStreamBufferCreateStatic(MP3_OUTBUFF_SIZE * 2 + 1, 128, decoder->stream_buffer, &xStreamBufferStruct);
 }
 
-void mp3player_start(const uint8_t* mp3_buff, uint32_t length) {
-    mp3player_info_t* audio_mp3 = (mp3player_info_t*)calloc(1, sizeof(mp3player_info_t));
-    assert(audio_mp3);
-    audio_mp3->buffer = mp3_buff; 
-    audio_mp3->length = length;
+void mp3player_set_sink(const mp3player_sink_t* sink) {
+    if (sink) {
+        decoder->sink = *sink;
+    } else {
+        memset(&decoder->sink, 0, sizeof(mp3player_sink_t));
+    }
+}
+
+void mp3player_start_source(const mp3_source_t* source) {
+    mp3_source_t* src = (mp3_source_t *)malloc(sizeof(mp3_source_t));
+    assert(src);
+    *src = *source;
     mp3player_stop(portMAX_DELAY);
     xEventGroupClearBits(decoder->event_group, MP3_EVENT_RESUME | MP3_EVENT_PAUSE | MP3_EVENT_STOP | MP3_EVENT_EXIT);
     xEventGroupSetBits(decoder->event_group, MP3_EVENT_DECODEING);
-    xTaskCreatePinnedToCore(mp3player_task, "mp3player", 5 * 1024, audio_mp3, decoder->task_prio, NULL, decoder->task_core);
+    UBaseType_t prio = decoder->task_prio;
+    BaseType_t core = decoder->task_core;
+    uint32_t stack_size = 5 * 1024;
+    qmsd_sched_place("mp3player", &prio, &core, &stack_size);
+    xTaskCreatePinnedToCore(mp3player_task, "mp3player", stack_size, src, prio, NULL, core);
+}
+
+void mp3player_start(const uint8_t* mp3_buff, uint32_t length) {
+    mp3_source_t src;
+    mp3_source_init_memory(&src, mp3_buff, length);
+    mp3player_start_source(&src);
 }
 
 static void mp3player_task(void *arg) {
     esp_err_t ret = ESP_OK;
     (void)ret;
-    mp3player_info_t* audio_info = (mp3player_info_t *)arg;
-    mp3_id3_header_v2_t tag;
+    mp3_source_t* src = (mp3_source_t *)arg;
     MP3FrameInfo frame_info;
 
-    mp3player_read_buffer(audio_info, (uint8_t *)&tag, sizeof(mp3_id3_header_v2_t));
-    if (memcmp("ID3", (const void *)&tag, sizeof(tag.header)) == 0) {
-        int tag_len = ((tag.size[0] & 0x7F) << 21) + ((tag.size[1] & 0x7F) << 14) + ((tag.size[2] & 0x7F) << 7) + ((tag.size[3] & 0x7F) << 0);
-        audio_info->buffer_offset += tag_len;
-    } else {
-        audio_info->buffer_offset = 0;
-    }
-
-    int bytes_left = 0;
-    uint32_t bytes_read = 0;
-    unsigned char *read_ptr = decoder->read_buffer;
     decoder->mp3_decoder = MP3InitDecoder();
+    ESP_GOTO_ON_FALSE(decoder->mp3_decoder, ESP_ERR_NO_MEM, clean_up, TAG, "MP3 decoder init failed");
+    mp3_source_skip_id3(src, MP3_ID3_TIMEOUT_MS);
 
     for (;;) {
         EventBits_t event_bits = xEventGroupGetBits(decoder->event_group);
@@ -161,32 +162,21 @@ static void mp3player_task(void *arg) {
             goto clean_up;
         }
 
-        /* Read `mainDataBegin` size to RAM */
-        if (bytes_left < MP3_INBUFF_SIZE) {
-            bytes_read = mp3player_fill_valid_buffer(audio_info, read_ptr, bytes_left);
-            bytes_left = bytes_left + bytes_read;
-            read_ptr = decoder->read_buffer;
+        /* Decode straight from the source, memory sources are not copied */
+        int64_t t = esp_timer_get_time();
+        int decoded = mp3_source_decode(src, decoder->mp3_decoder, decoder->out_buffer, MP3_READ_TIMEOUT_MS);
+        if (decoded == MP3_SOURCE_ERROR) {
+            ESP_GOTO_ON_FALSE(0, ESP_FAIL, clean_up, TAG, "Can't decode MP3 frame");
         }
-
-        /* Find MP3 sync word from read buffer */
-        int offset = MP3FindSyncWord(decoder->read_buffer, MAINBUF_SIZE);
-        if (offset < 0) {
+        if (decoded < 0) {
             break ;
         }
-        read_ptr += offset;      
-        bytes_left -= offset;
-        int mp3_dec_err = MP3Decode(decoder->mp3_decoder, &read_ptr, &bytes_left, decoder->out_buffer, 0);
-        if(mp3_dec_err < ERR_MP3_FREE_BITRATE_SYNC) {
-            ESP_GOTO_ON_FALSE(0, ESP_FAIL, clean_up, TAG, "Can't decode MP3 frame: %d", mp3_dec_err);
-        }
-
-        if (mp3_dec_err == ERR_MP3_INDATA_UNDERFLOW) {
-            break ;
-        }
-
-        if (mp3_dec_err != ERR_MP3_NONE) {
+        if (decoded == 0) {
+            qmsd_metric_inc(&s_mp3_stalls);
             continue;
         }
+        qmsd_metric_observe(&s_mp3_decode_us, esp_timer_get_time() - t);
+        qmsd_metric_inc(&s_mp3_frames);
 
         /* Get MP3 frame info and configure I2S clock */
         MP3GetLastFrameInfo(decoder->mp3_decoder, &frame_info);
@@ -194,22 +184,41 @@ static void mp3player_task(void *arg) {
             decoder->channel = frame_info.nChans;
             decoder->sample = frame_info.samprate;
             decoder->bits_per_sample = frame_info.bitsPerSample;
-            while (!xStreamBufferIsEmpty(decoder->stream)) {
+            while (decoder->sink.write == NULL && !xStreamBufferIsEmpty(decoder->stream)) {
                 vTaskDelay(pdMS_TO_TICKS(10));
             }
             if (decoder->info_update) {
                 decoder->info_update(decoder->sample, decoder->channel, decoder->bits_per_sample);
             }
         }
-        xStreamBufferSend(decoder->stream, (uint8_t *)decoder->out_buffer, (frame_info.bitsPerSample * frame_info.outputSamps) >> 3, portMAX_DELAY);
+        uint32_t pcm_bytes = (frame_info.bitsPerSample * frame_info.outputSamps) >> 3;
+        t = esp_timer_get_time();
+        if (decoder->sink.write) {
+            if (!mp3player_sink_push((const uint8_t *)decoder->out_buffer, pcm_bytes)) {
+                goto clean_up;
+            }
+        } else {
+            xStreamBufferSend(decoder->stream, (uint8_t *)decoder->out_buffer, pcm_bytes, portMAX_DELAY);
+        }
+        qmsd_metric_observe(&s_mp3_sink_us, esp_timer_get_time() - t);
     }
 
 clean_up:
     /* Clean up resources */
     if (NULL != decoder->mp3_decoder) {
         MP3FreeDecoder(decoder->mp3_decoder);
+        decoder->mp3_decoder = NULL;
+    }
+    if (src->error) {
+        ESP_LOGW(TAG, "source read error");
+    }
+    mp3_source_close(src);
+    free(src);
+    /* the next stream may come with another format */
+    decoder->sample = 0;
+    if (decoder->sink.end) {
+        decoder->sink.end(decoder->sink.ctx);
     }
-    free(audio_info);
     xEventGroupClearBits(decoder->event_group, MP3_EVENT_DECODEING);
     xEventGroupSetBits(decoder->event_group, MP3_EVENT_EXIT);
     vTaskDelete(NULL);
@@ -1,9 +1,21 @@
 #pragma once
 
 #include "stdint.h"
+#include "mp3_source.h"
 
 typedef void(*mp3plyaer_update_fun_t)(int samprate, int chans, int bits_per_sample);
 
+// Push mode: every decoded frame goes straight to write() from the decoder
+// task, no stream buffer in between and mp3player_read_data is not used.
+// write() returns the bytes it took within timeout_ms, the rest is written
+// again after a look at the stop bits. end() runs on the decoder task once a
+// stream is done or stopped, it may be NULL.
+typedef struct {
+    uint32_t (*write)(void* ctx, const uint8_t* pcm, uint32_t len, uint32_t timeout_ms);
+    void (*end)(void* ctx);
+    void* ctx;
+} mp3player_sink_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,6 +32,12 @@ void mp3player_init(mp3plyaer_update_fun_t info_update, uint8_t task_core, uint8
 
 void mp3player_start(const uint8_t* mp3_buff, uint32_t length);
 
+// The player owns the source from here on and closes it when playback ends
+void mp3player_start_source(const mp3_source_t* source);
+
+// NULL goes back to pull mode, set it while nothing is playing
+void mp3player_set_sink(const mp3player_sink_t* sink);
+
 #ifdef __cplusplus
 }
 #endif
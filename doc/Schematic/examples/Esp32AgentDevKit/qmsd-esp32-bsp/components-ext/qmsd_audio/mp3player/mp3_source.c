@@ -0,0 +1,171 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "mp3dec.h"
+#include "mp3_source.h"
+
+void mp3_source_init_memory(mp3_source_t* src, const uint8_t* data, uint32_t len) {
+    memset(src, 0, sizeof(mp3_source_t));
+    src->data = data;
+    src->end = len;
+    src->eof = 1;
+}
+
+int mp3_source_init_stream(mp3_source_t* src, mp3_source_read_t read, void (*close)(mp3_source_t* src), void* ctx, uint32_t window_size) {
+    memset(src, 0, sizeof(mp3_source_t));
+    src->window = (uint8_t *)malloc(window_size);
+    if (src->window == NULL) {
+        return -1;
+    }
+    src->data = src->window;
+    src->window_size = window_size;
+    src->read = read;
+    src->close = close;
+    src->ctx = ctx;
+    return 0;
+}
+
+uint32_t mp3_source_peek(mp3_source_t* src, const uint8_t** data, uint32_t want, uint32_t timeout_ms) {
+    uint32_t avail = src->end - src->start;
+    if (src->window && want > src->window_size) {
+        want = src->window_size;
+    }
+    while (avail < want && !src->eof) {
+        // only move the unread tail when the rest would not fit behind it
+        if (src->start + want > src->window_size) {
+            memmove(src->window, src->window + src->start, avail);
+            src->start = 0;
+            src->end = avail;
+        }
+        int ret = src->read(src, src->window + src->end, src->window_size - src->end, timeout_ms);
+        if (ret == 0) {
+            break;
+        }
+        if (ret < 0) {
+            src->eof = 1;
+            src->error = ret != MP3_SOURCE_EOF;
+            break;
+        }
+        src->end += ret;
+        src->copied += ret;
+        avail = src->end - src->start;
+    }
+    *data = src->data + src->start;
+    return avail;
+}
+
+void mp3_source_consume(mp3_source_t* src, uint32_t len) {
+    if (len > src->end - src->start) {
+        len = src->end - src->start;
+    }
+    src->start += len;
+}
+
+bool mp3_source_skip(mp3_source_t* src, uint32_t len, uint32_t timeout_ms) {
+    while (len) {
+        const uint8_t* data;
+        uint32_t avail = mp3_source_peek(src, &data, len, timeout_ms);
+        if (avail == 0) {
+            return false;
+        }
+        avail = avail < len ? avail : len;
+        mp3_source_consume(src, avail);
+        len -= avail;
+    }
+    return true;
+}
+
+bool mp3_source_is_end(mp3_source_t* src) {
+    return src->eof && src->start == src->end;
+}
+
+void mp3_source_close(mp3_source_t* src) {
+    if (src->close) {
+        src->close(src);
+    }
+    free(src->window);
+    memset(src, 0, sizeof(mp3_source_t));
+}
+
+bool mp3_source_skip_id3(mp3_source_t* src, uint32_t timeout_ms) {
+    const uint8_t* tag;
+    if (mp3_source_peek(src, &tag, 10, timeout_ms) < 10 || memcmp(tag, "ID3", 3) != 0) {
+        return true;
+    }
+    // synchsafe size, excludes the 10 byte header
+    uint32_t tag_len = ((tag[6] & 0x7f) << 21) | ((tag[7] & 0x7f) << 14) | ((tag[8] & 0x7f) << 7) | (tag[9] & 0x7f);
+    return mp3_source_skip(src, tag_len + 10, timeout_ms);
+}
+
+int mp3_source_decode(mp3_source_t* src, void* decoder, int16_t* pcm, uint32_t timeout_ms) {
+    const uint8_t* data;
+    uint32_t avail = mp3_source_peek(src, &data, MAINBUF_SIZE, timeout_ms);
+    if (avail == 0) {
+        return mp3_source_is_end(src) ? MP3_SOURCE_EOF : 0;
+    }
+    int offset = MP3FindSyncWord((unsigned char *)data, avail);
+    if (offset < 0) {
+        // keep the last bytes, a sync word may straddle the next read
+        mp3_source_consume(src, avail > 3 ? avail - 3 : (src->eof ? avail : 0));
+        return 0;
+    }
+    if (offset > 0) {
+        // peek again so the frame starts with a full MAINBUF_SIZE behind it
+        mp3_source_consume(src, offset);
+        return 0;
+    }
+
+    unsigned char* read_ptr = (unsigned char *)data;
+    int bytes_left = avail;
+    int err = MP3Decode((HMP3Decoder)decoder, &read_ptr, &bytes_left, pcm, 0);
+    mp3_source_consume(src, avail - bytes_left);
+    switch (err) {
+        case ERR_MP3_NONE:
+            return 1;
+        case ERR_MP3_INDATA_UNDERFLOW:
+            if (avail >= MAINBUF_SIZE) {
+                // no frame is that long, a false sync word
+                mp3_source_consume(src, 1);
+                return 0;
+            }
+            if (src->eof) {
+                // a truncated last frame
+                mp3_source_consume(src, avail);
+                return MP3_SOURCE_EOF;
+            }
+            return 0;
+        case ERR_MP3_MAINDATA_UNDERFLOW:
+            // bit reservoir still filling after a seek or the first frames
+            return 0;
+        case ERR_MP3_FREE_BITRATE_SYNC:
+            mp3_source_consume(src, 1);
+            return 0;
+        default:
+            return MP3_SOURCE_ERROR;
+    }
+}
+
+static int file_read(mp3_source_t* src, uint8_t* buf, uint32_t len, uint32_t timeout_ms) {
+    (void)timeout_ms;   // a file never stalls
+    size_t ret = fread(buf, 1, len, (FILE *)src->ctx);
+    if (ret == 0) {
+        return ferror((FILE *)src->ctx) ? MP3_SOURCE_ERROR : MP3_SOURCE_EOF;
+    }
+    return ret;
+}
+
+static void file_close(mp3_source_t* src) {
+    fclose((FILE *)src->ctx);
+}
+
+int mp3_source_init_file(mp3_source_t* src, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    if (mp3_source_init_stream(src, file_read, file_close, file, MP3_SOURCE_WINDOW_SIZE) != 0) {
+        fclose(file);
+        return -1;
+    }
+    return 0;
+}
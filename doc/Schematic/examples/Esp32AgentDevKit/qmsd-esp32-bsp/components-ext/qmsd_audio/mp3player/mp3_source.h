@@ -0,0 +1,72 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Where the decoder reads mp3 from.
+//
+// Memory sources (RAM, embedded files, mmap'd partitions) hand the decoder
+// pointers into the data itself, nothing is copied. Stream sources (file,
+// http, ring buffer) read into a window that is only compacted when the
+// unread tail no longer fits, not on every frame.
+//
+// mp3_source.c is portable, mp3_source_esp.c has the ESP-IDF backed sources.
+
+#define MP3_SOURCE_WINDOW_SIZE      (4 * 1024)
+// read() return values besides a byte count
+#define MP3_SOURCE_EOF              (-1)
+#define MP3_SOURCE_ERROR            (-2)
+
+typedef struct mp3_source_t mp3_source_t;
+
+// Fill up to len bytes, 0 when nothing arrived within timeout_ms
+typedef int (*mp3_source_read_t)(mp3_source_t* src, uint8_t* buf, uint32_t len, uint32_t timeout_ms);
+
+struct mp3_source_t {
+    const uint8_t* data;        // memory source: the stream, stream source: the window
+    uint32_t start;             // first unread byte in data
+    uint32_t end;               // one past the last valid byte
+    uint8_t* window;            // NULL for memory sources
+    uint32_t window_size;
+    uint8_t eof;
+    uint8_t error;
+    mp3_source_read_t read;
+    void (*close)(mp3_source_t* src);
+    void* ctx;
+    uint32_t copied;            // bytes that went through the window
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void mp3_source_init_memory(mp3_source_t* src, const uint8_t* data, uint32_t len);
+
+int mp3_source_init_stream(mp3_source_t* src, mp3_source_read_t read, void (*close)(mp3_source_t* src), void* ctx, uint32_t window_size);
+
+int mp3_source_init_file(mp3_source_t* src, const char* path);
+
+// Contiguous unread bytes, at least want of them unless the stream ended or
+// timed out. The pointer stays valid until the next peek or consume.
+uint32_t mp3_source_peek(mp3_source_t* src, const uint8_t** data, uint32_t want, uint32_t timeout_ms);
+
+void mp3_source_consume(mp3_source_t* src, uint32_t len);
+
+// Skip len bytes even past the window, false when the stream ended first
+bool mp3_source_skip(mp3_source_t* src, uint32_t len, uint32_t timeout_ms);
+
+bool mp3_source_is_end(mp3_source_t* src);
+
+// Skip an ID3v2 tag when the stream starts with one
+bool mp3_source_skip_id3(mp3_source_t* src, uint32_t timeout_ms);
+
+// Decode the next frame into pcm (MAX_NCHAN * MAX_NGRAN * MAX_NSAMP samples).
+// 1: a frame is out, MP3GetLastFrameInfo has its format, 0: call again
+// (resync, reservoir, no data yet), MP3_SOURCE_EOF / MP3_SOURCE_ERROR: done.
+int mp3_source_decode(mp3_source_t* src, void* decoder, int16_t* pcm, uint32_t timeout_ms);
+
+void mp3_source_close(mp3_source_t* src);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,122 @@
+#include "stdlib.h"
+#include "string.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "mp3_source_esp.h"
+
+static const char *TAG = "mp3_source";
+
+typedef struct {
+    RingbufHandle_t ringbuf;
+    volatile uint8_t finished;
+} ringbuf_ctx_t;
+
+static void partition_close(mp3_source_t* src) {
+    esp_partition_munmap((esp_partition_mmap_handle_t)(uintptr_t)src->ctx);
+}
+
+esp_err_t mp3_source_init_partition(mp3_source_t* src, const esp_partition_t* partition, uint32_t offset, uint32_t len) {
+    if (partition == NULL || offset >= partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0 || offset + len > partition->size) {
+        len = partition->size - offset;
+    }
+    const void* data = NULL;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(partition, offset, len, ESP_PARTITION_MMAP_DATA, &data, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mmap %s failed: %s", partition->label, esp_err_to_name(err));
+        return err;
+    }
+    mp3_source_init_memory(src, (const uint8_t *)data, len);
+    src->close = partition_close;
+    src->ctx = (void *)(uintptr_t)handle;
+    return ESP_OK;
+}
+
+static int http_read(mp3_source_t* src, uint8_t* buf, uint32_t len, uint32_t timeout_ms) {
+    esp_http_client_handle_t client = (esp_http_client_handle_t)src->ctx;
+    int ret = esp_http_client_read(client, (char *)buf, len);
+    if (ret < 0) {
+        return MP3_SOURCE_ERROR;
+    }
+    if (ret == 0 && esp_http_client_is_complete_data_received(client)) {
+        return MP3_SOURCE_EOF;
+    }
+    return ret;
+}
+
+static void http_close(mp3_source_t* src) {
+    esp_http_client_handle_t client = (esp_http_client_handle_t)src->ctx;
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+}
+
+esp_err_t mp3_source_init_http(mp3_source_t* src, const char* url) {
+    esp_http_client_config_t config = {
+        .url = url,
+        .timeout_ms = 5000,
+        .buffer_size = 2048,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        goto failed;
+    }
+    esp_http_client_fetch_headers(client);
+    if (esp_http_client_get_status_code(client) != 200) {
+        ESP_LOGE(TAG, "http status %d", esp_http_client_get_status_code(client));
+        err = ESP_FAIL;
+        goto close;
+    }
+    if (mp3_source_init_stream(src, http_read, http_close, client, MP3_SOURCE_WINDOW_SIZE) != 0) {
+        err = ESP_ERR_NO_MEM;
+        goto close;
+    }
+    return ESP_OK;
+
+close:
+    esp_http_client_close(client);
+failed:
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+static int ringbuf_read(mp3_source_t* src, uint8_t* buf, uint32_t len, uint32_t timeout_ms) {
+    ringbuf_ctx_t* ctx = (ringbuf_ctx_t *)src->ctx;
+    // sample finished first, bytes sent before it are then surely in the buffer
+    uint8_t finished = ctx->finished;
+    size_t size = 0;
+    uint8_t* item = (uint8_t *)xRingbufferReceiveUpTo(ctx->ringbuf, &size, finished ? 0 : pdMS_TO_TICKS(timeout_ms), len);
+    if (item == NULL) {
+        return finished ? MP3_SOURCE_EOF : 0;
+    }
+    memcpy(buf, item, size);
+    vRingbufferReturnItem(ctx->ringbuf, item);
+    return size;
+}
+
+static void ringbuf_close(mp3_source_t* src) {
+    free(src->ctx);
+}
+
+esp_err_t mp3_source_init_ringbuf(mp3_source_t* src, RingbufHandle_t ringbuf) {
+    ringbuf_ctx_t* ctx = (ringbuf_ctx_t *)calloc(1, sizeof(ringbuf_ctx_t));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->ringbuf = ringbuf;
+    if (mp3_source_init_stream(src, ringbuf_read, ringbuf_close, ctx, MP3_SOURCE_WINDOW_SIZE) != 0) {
+        free(ctx);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void mp3_source_ringbuf_finish(mp3_source_t* src) {
+    ((ringbuf_ctx_t *)src->ctx)->finished = 1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "mp3_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maps [offset, offset + len) of the partition into the data cache and reads
+// it in place, len 0 means up to the end of the partition.
+esp_err_t mp3_source_init_partition(mp3_source_t* src, const esp_partition_t* partition, uint32_t offset, uint32_t len);
+
+esp_err_t mp3_source_init_http(mp3_source_t* src, const char* url);
+
+// Byte ring buffer (RINGBUF_TYPE_BYTEBUF) fed by another task, e.g. tts.
+// The producer calls mp3_source_ringbuf_finish after its last byte.
+esp_err_t mp3_source_init_ringbuf(mp3_source_t* src, RingbufHandle_t ringbuf);
+
+void mp3_source_ringbuf_finish(mp3_source_t* src);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+#include "stdio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "qmsd_boot.h"
+
+#define TAG "QMSD_BOOT"
+
+typedef struct {
+    qmsd_boot_fn_t fn;
+    void* arg;
+    uint32_t stack_size;
+    int8_t core;
+} boot_task_t;
+
+static qmsd_boot_graph_t g_graph;
+static boot_task_t g_task[QMSD_BOOT_MAX_STAGES];
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+static EventGroupHandle_t g_done_event = NULL;
+static uint8_t g_priority = 5;
+static uint8_t g_is_init = 0;
+
+static uint32_t boot_now_us() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+static void boot_init() {
+    if (g_is_init == 0) {
+        qmsd_boot_graph_init(&g_graph);
+        g_done_event = xEventGroupCreate();
+        g_is_init = 1;
+    }
+}
+
+static void boot_spawn(uint32_t ready);
+
+static void boot_stage_task(void* arg) {
+    uint8_t id = (uint32_t)arg;
+
+    portENTER_CRITICAL(&g_lock);
+    qmsd_boot_graph_begin(&g_graph, id, boot_now_us(), xPortGetCoreID());
+    portEXIT_CRITICAL(&g_lock);
+
+    g_task[id].fn(g_task[id].arg);
+
+    portENTER_CRITICAL(&g_lock);
+    uint32_t ready = qmsd_boot_graph_finish(&g_graph, id, boot_now_us());
+    portEXIT_CRITICAL(&g_lock);
+
+    xEventGroupSetBits(g_done_event, QMSD_BOOT_DEP(id));
+    boot_spawn(ready);
+    vTaskDelete(NULL);
+}
+
+static void boot_spawn(uint32_t ready) {
+    for (uint8_t i = 0; ready; i++, ready >>= 1) {
+        if (!(ready & 0x01)) {
+            continue;
+        }
+        BaseType_t core = g_task[i].core < 0 ? tskNO_AFFINITY : g_task[i].core;
+        if (xTaskCreatePinnedToCore(boot_stage_task, g_graph.stage[i].name, g_task[i].stack_size, (void *)(uint32_t)i, g_priority, NULL, core) != pdPASS) {
+            // its dependents never start, qmsd_boot_print shows where boot stopped
+            ESP_LOGE(TAG, "Create stage %s failed", g_graph.stage[i].name);
+        }
+    }
+}
+
+int qmsd_boot_add(const char* name, qmsd_boot_fn_t fn, void* arg, uint32_t deps, uint32_t stack_size, int8_t core) {
+    boot_init();
+    int id = qmsd_boot_graph_add(&g_graph, name, deps);
+    if (id < 0) {
+        ESP_LOGE(TAG, "Add stage %s failed", name);
+        return -1;
+    }
+    g_task[id].fn = fn;
+    g_task[id].arg = arg;
+    g_task[id].stack_size = stack_size;
+    g_task[id].core = core;
+    return id;
+}
+
+void qmsd_boot_start(uint8_t priority) {
+    boot_init();
+    g_priority = priority;
+    portENTER_CRITICAL(&g_lock);
+    uint32_t ready = qmsd_boot_graph_take_ready(&g_graph);
+    portEXIT_CRITICAL(&g_lock);
+    boot_spawn(ready);
+}
+
+bool qmsd_boot_wait(uint32_t stages, uint32_t timeout_ms) {
+    boot_init();
+    EventBits_t bits = xEventGroupWaitBits(g_done_event, stages, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & stages) == stages;
+}
+
+void qmsd_boot_mark(const char* name) {
+    boot_init();
+    uint32_t now = boot_now_us();
+    portENTER_CRITICAL(&g_lock);
+    qmsd_boot_graph_mark(&g_graph, name, now);
+    portEXIT_CRITICAL(&g_lock);
+    ESP_LOGI(TAG, "%s at %lu ms", name, now / 1000);
+}
+
+void qmsd_boot_print(void) {
+    int last = -1;
+    for (uint8_t i = 0; i < g_graph.stage_num; i++) {
+        qmsd_boot_stage_t* stage = &g_graph.stage[i];
+        if (!(g_graph.done & QMSD_BOOT_DEP(i))) {
+            ESP_LOGW(TAG, "%-12s %s", stage->name, (g_graph.started & QMSD_BOOT_DEP(i)) ? "running" : "waiting");
+            continue;
+        }
+        ESP_LOGI(TAG, "%-12s core %d, %6lu -> %6lu ms (%lu ms)", stage->name, stage->core,
+                 stage->start_us / 1000, stage->end_us / 1000, (stage->end_us - stage->start_us) / 1000);
+        if (last < 0 || stage->end_us > g_graph.stage[last].end_us) {
+            last = i;
+        }
+    }
+    if (last < 0) {
+        return ;
+    }
+    uint8_t path[QMSD_BOOT_MAX_STAGES];
+    uint8_t len = qmsd_boot_graph_critical_path(&g_graph, last, path, QMSD_BOOT_MAX_STAGES);
+    printf("critical path:");
+    for (uint8_t i = 0; i < len; i++) {
+        printf(" %s%s", g_graph.stage[path[i]].name, (i + 1 < len) ? " ->" : "\r\n");
+    }
+}
+
+static void boot_write_stdout(const char* str, void* arg) {
+    fputs(str, stdout);
+}
+
+void qmsd_boot_dump_trace(void) {
+    qmsd_boot_graph_to_json(&g_graph, boot_write_stdout, NULL);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "qmsd_boot_graph.h"
+
+// Boot orchestrator: every stage declares the stages it needs and gets its own
+// task as soon as they are all done, so independent bring-up (network vs
+// display) overlaps. Start and end of every stage go into the boot trace.
+
+typedef void (*qmsd_boot_fn_t)(void* arg);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// deps: QMSD_BOOT_DEP(id) of stages added before. core: -1 for no affinity.
+// Returns the stage id, -1 on error. Only before qmsd_boot_start.
+int qmsd_boot_add(const char* name, qmsd_boot_fn_t fn, void* arg, uint32_t deps, uint32_t stack_size, int8_t core);
+
+// Spawn every stage without deps, the rest follow as their deps finish
+void qmsd_boot_start(uint8_t priority);
+
+// Wait until all `stages` (QMSD_BOOT_DEP mask) are done, true when they are
+bool qmsd_boot_wait(uint32_t stages, uint32_t timeout_ms);
+
+// Instant event in the trace, e.g. "first_frame". Any task, not from isr.
+void qmsd_boot_mark(const char* name);
+
+// Stage durations and the critical path of the last stage to finish
+void qmsd_boot_print(void);
+
+// Chrome trace json on stdout, save it and open with chrome://tracing or perfetto
+void qmsd_boot_dump_trace(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+#include "stdio.h"
+#include "string.h"
+#include "qmsd_boot_graph.h"
+
+void qmsd_boot_graph_init(qmsd_boot_graph_t* graph) {
+    memset(graph, 0, sizeof(qmsd_boot_graph_t));
+}
+
+int qmsd_boot_graph_add(qmsd_boot_graph_t* graph, const char* name, uint32_t deps) {
+    if (graph->stage_num >= QMSD_BOOT_MAX_STAGES || (deps >> graph->stage_num)) {
+        return -1;
+    }
+    qmsd_boot_stage_t* stage = &graph->stage[graph->stage_num];
+    stage->name = name;
+    stage->deps = deps;
+    stage->core = -1;
+    return graph->stage_num++;
+}
+
+uint32_t qmsd_boot_graph_take_ready(qmsd_boot_graph_t* graph) {
+    uint32_t ready = 0;
+    for (uint8_t i = 0; i < graph->stage_num; i++) {
+        if (!(graph->started & QMSD_BOOT_DEP(i)) && (graph->stage[i].deps & graph->done) == graph->stage[i].deps) {
+            ready |= QMSD_BOOT_DEP(i);
+        }
+    }
+    graph->started |= ready;
+    return ready;
+}
+
+void qmsd_boot_graph_begin(qmsd_boot_graph_t* graph, uint8_t id, uint32_t now_us, int8_t core) {
+    graph->stage[id].start_us = now_us;
+    graph->stage[id].core = core;
+}
+
+uint32_t qmsd_boot_graph_finish(qmsd_boot_graph_t* graph, uint8_t id, uint32_t now_us) {
+    graph->stage[id].end_us = now_us;
+    graph->done |= QMSD_BOOT_DEP(id);
+    return qmsd_boot_graph_take_ready(graph);
+}
+
+void qmsd_boot_graph_mark(qmsd_boot_graph_t* graph, const char* name, uint32_t now_us) {
+    if (graph->mark_num >= QMSD_BOOT_MAX_MARKS) {
+        return ;
+    }
+    graph->mark[graph->mark_num].name = name;
+    graph->mark[graph->mark_num].ts_us = now_us;
+    graph->mark_num++;
+}
+
+uint8_t qmsd_boot_graph_critical_path(qmsd_boot_graph_t* graph, uint8_t id, uint8_t* path, uint8_t max_len) {
+    uint8_t reverse[QMSD_BOOT_MAX_STAGES];
+    uint8_t len = 0;
+    int cur = id;
+    while (cur >= 0 && len < QMSD_BOOT_MAX_STAGES) {
+        reverse[len++] = cur;
+        int last = -1;
+        for (uint8_t i = 0; i < graph->stage_num; i++) {
+            if ((graph->stage[cur].deps & QMSD_BOOT_DEP(i)) && (last < 0 || graph->stage[i].end_us > graph->stage[last].end_us)) {
+                last = i;
+            }
+        }
+        cur = last;
+    }
+    if (len > max_len) {
+        len = max_len;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        path[i] = reverse[len - 1 - i];
+    }
+    return len;
+}
+
+void qmsd_boot_graph_to_json(qmsd_boot_graph_t* graph, void (*write)(const char* str, void* arg), void* arg) {
+    char line[160];
+    const char* sep = "";
+    write("{\"traceEvents\":[\n", arg);
+    for (uint8_t i = 0; i < graph->stage_num; i++) {
+        qmsd_boot_stage_t* stage = &graph->stage[i];
+        snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                 sep, i, stage->name);
+        write(line, arg);
+        sep = ",\n";
+        if (!(graph->done & QMSD_BOOT_DEP(i))) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":0,\"tid\":%u,\"args\":{\"core\":%d}}",
+                 sep, stage->name, (unsigned long)stage->start_us, (unsigned long)(stage->end_us - stage->start_us), i, stage->core);
+        write(line, arg);
+    }
+    for (uint8_t i = 0; i < graph->mark_num; i++) {
+        snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lu,\"pid\":0,\"tid\":0}",
+                 sep, graph->mark[i].name, (unsigned long)graph->mark[i].ts_us);
+        write(line, arg);
+        sep = ",\n";
+    }
+    write("\n]}\n", arg);
+}
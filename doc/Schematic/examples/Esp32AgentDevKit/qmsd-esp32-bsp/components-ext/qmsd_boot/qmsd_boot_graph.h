@@ -0,0 +1,64 @@
+#pragma once
+
+#include "stdint.h"
+
+// Boot stage graph and timeline, portable: the caller passes time and core in.
+// A stage may only depend on stages added before it, so the graph can not
+// have cycles.
+
+// one event group bit per stage on the FreeRTOS side
+#define QMSD_BOOT_MAX_STAGES    24
+#define QMSD_BOOT_MAX_MARKS     8
+#define QMSD_BOOT_DEP(id)       (1UL << (id))
+
+typedef struct {
+    const char* name;
+    uint32_t deps;
+    uint32_t start_us;
+    uint32_t end_us;
+    int8_t core;
+} qmsd_boot_stage_t;
+
+typedef struct {
+    const char* name;
+    uint32_t ts_us;
+} qmsd_boot_mark_t;
+
+typedef struct {
+    qmsd_boot_stage_t stage[QMSD_BOOT_MAX_STAGES];
+    uint8_t stage_num;
+    uint32_t started;
+    uint32_t done;
+    qmsd_boot_mark_t mark[QMSD_BOOT_MAX_MARKS];
+    uint8_t mark_num;
+} qmsd_boot_graph_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void qmsd_boot_graph_init(qmsd_boot_graph_t* graph);
+
+// Returns the stage id, -1 when full or deps name a stage that does not exist yet
+int qmsd_boot_graph_add(qmsd_boot_graph_t* graph, const char* name, uint32_t deps);
+
+// Stages whose deps are all done and that were not handed out yet, they are taken as started
+uint32_t qmsd_boot_graph_take_ready(qmsd_boot_graph_t* graph);
+
+void qmsd_boot_graph_begin(qmsd_boot_graph_t* graph, uint8_t id, uint32_t now_us, int8_t core);
+
+// Returns the stages this one unblocked, taken as started
+uint32_t qmsd_boot_graph_finish(qmsd_boot_graph_t* graph, uint8_t id, uint32_t now_us);
+
+void qmsd_boot_graph_mark(qmsd_boot_graph_t* graph, const char* name, uint32_t now_us);
+
+// Chain of stages that decided when `id` could start: at each step the dep that finished last.
+// Fills path from the first stage to `id` (the last max_len of it), returns its length.
+uint8_t qmsd_boot_graph_critical_path(qmsd_boot_graph_t* graph, uint8_t id, uint8_t* path, uint8_t max_len);
+
+// Chrome trace json (chrome://tracing, perfetto): one lane per stage, marks as instant events.
+void qmsd_boot_graph_to_json(qmsd_boot_graph_t* graph, void (*write)(const char* str, void* arg), void* arg);
+
+#ifdef __cplusplus
+}
+#endif
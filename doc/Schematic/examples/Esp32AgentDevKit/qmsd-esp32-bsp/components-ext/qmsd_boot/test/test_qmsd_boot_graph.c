@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "qmsd_boot_graph.h"
+
+// aw9523 -> codec -> board ------+
+// nvs -> netif -> wifi -> bot ----+-> rtc
+typedef struct {
+    int aw9523, board, codec, nvs, netif, wifi, bot, rtc;
+} app_stages_t;
+
+static void add_app_stages(qmsd_boot_graph_t* graph, app_stages_t* s) {
+    qmsd_boot_graph_init(graph);
+    s->aw9523 = qmsd_boot_graph_add(graph, "aw9523", 0);
+    s->codec = qmsd_boot_graph_add(graph, "codec", QMSD_BOOT_DEP(s->aw9523));
+    s->board = qmsd_boot_graph_add(graph, "board", QMSD_BOOT_DEP(s->codec));
+    s->nvs = qmsd_boot_graph_add(graph, "nvs", 0);
+    s->netif = qmsd_boot_graph_add(graph, "netif", QMSD_BOOT_DEP(s->nvs));
+    s->wifi = qmsd_boot_graph_add(graph, "wifi", QMSD_BOOT_DEP(s->netif));
+    s->bot = qmsd_boot_graph_add(graph, "bot", QMSD_BOOT_DEP(s->wifi));
+    s->rtc = qmsd_boot_graph_add(graph, "rtc", QMSD_BOOT_DEP(s->bot) | QMSD_BOOT_DEP(s->board));
+}
+
+static void run(qmsd_boot_graph_t* graph, int id, uint32_t* now, uint32_t dur, uint32_t expect_ready) {
+    qmsd_boot_graph_begin(graph, id, *now, 0);
+    *now += dur;
+    TEST_ASSERT_EQUAL_HEX32(expect_ready, qmsd_boot_graph_finish(graph, id, *now));
+}
+
+TEST_CASE("boot graph rejects forward deps", "[qmsd_boot]")
+{
+    qmsd_boot_graph_t graph;
+    qmsd_boot_graph_init(&graph);
+    TEST_ASSERT_EQUAL(-1, qmsd_boot_graph_add(&graph, "a", QMSD_BOOT_DEP(0)));
+    TEST_ASSERT_EQUAL(0, qmsd_boot_graph_add(&graph, "a", 0));
+    TEST_ASSERT_EQUAL(-1, qmsd_boot_graph_add(&graph, "b", QMSD_BOOT_DEP(1)));
+    TEST_ASSERT_EQUAL(1, qmsd_boot_graph_add(&graph, "b", QMSD_BOOT_DEP(0)));
+    for (int i = 2; i < QMSD_BOOT_MAX_STAGES; i++) {
+        TEST_ASSERT_EQUAL(i, qmsd_boot_graph_add(&graph, "x", 0));
+    }
+    TEST_ASSERT_EQUAL(-1, qmsd_boot_graph_add(&graph, "full", 0));
+}
+
+TEST_CASE("boot graph releases stages as their deps finish", "[qmsd_boot]")
+{
+    qmsd_boot_graph_t graph;
+    app_stages_t s;
+    add_app_stages(&graph, &s);
+    uint32_t now = 0;
+
+    TEST_ASSERT_EQUAL_HEX32(QMSD_BOOT_DEP(s.aw9523) | QMSD_BOOT_DEP(s.nvs), qmsd_boot_graph_take_ready(&graph));
+    TEST_ASSERT_EQUAL_HEX32(0, qmsd_boot_graph_take_ready(&graph));
+
+    run(&graph, s.nvs, &now, 10, QMSD_BOOT_DEP(s.netif));
+    run(&graph, s.aw9523, &now, 30, QMSD_BOOT_DEP(s.codec));
+    run(&graph, s.netif, &now, 10, QMSD_BOOT_DEP(s.wifi));
+    run(&graph, s.codec, &now, 100, QMSD_BOOT_DEP(s.board));
+    run(&graph, s.board, &now, 300, 0);
+    // rtc needs both chains
+    run(&graph, s.wifi, &now, 1500, QMSD_BOOT_DEP(s.bot));
+    run(&graph, s.bot, &now, 400, QMSD_BOOT_DEP(s.rtc));
+    run(&graph, s.rtc, &now, 5, 0);
+    TEST_ASSERT_EQUAL_HEX32((1UL << graph.stage_num) - 1, graph.done);
+}
+
+TEST_CASE("boot graph critical path follows the last dep", "[qmsd_boot]")
+{
+    qmsd_boot_graph_t graph;
+    app_stages_t s;
+    add_app_stages(&graph, &s);
+    qmsd_boot_graph_take_ready(&graph);
+
+    // network and display overlap, network finishes last
+    uint32_t t_disp = 0, t_net = 0;
+    run(&graph, s.aw9523, &t_disp, 30, QMSD_BOOT_DEP(s.codec));
+    run(&graph, s.nvs, &t_net, 20, QMSD_BOOT_DEP(s.netif));
+    run(&graph, s.codec, &t_disp, 100, QMSD_BOOT_DEP(s.board));
+    run(&graph, s.board, &t_disp, 300, 0);
+    run(&graph, s.netif, &t_net, 10, QMSD_BOOT_DEP(s.wifi));
+    run(&graph, s.wifi, &t_net, 1500, QMSD_BOOT_DEP(s.bot));
+    run(&graph, s.bot, &t_net, 400, QMSD_BOOT_DEP(s.rtc));
+    run(&graph, s.rtc, &t_net, 5, 0);
+
+    uint8_t path[QMSD_BOOT_MAX_STAGES];
+    uint8_t expect[] = {s.nvs, s.netif, s.wifi, s.bot, s.rtc};
+    TEST_ASSERT_EQUAL(5, qmsd_boot_graph_critical_path(&graph, s.rtc, path, QMSD_BOOT_MAX_STAGES));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, path, 5);
+    // call ready at 1935 ms instead of 2365 ms back to back
+    TEST_ASSERT_EQUAL(1935, graph.stage[s.rtc].end_us);
+
+    // truncated keeps the stages right before rtc
+    TEST_ASSERT_EQUAL(2, qmsd_boot_graph_critical_path(&graph, s.rtc, path, 2));
+    TEST_ASSERT_EQUAL(s.bot, path[0]);
+    TEST_ASSERT_EQUAL(s.rtc, path[1]);
+}
+
+typedef struct {
+    char buf[2048];
+    size_t len;
+} json_buf_t;
+
+static void json_write(const char* str, void* arg) {
+    json_buf_t* json = (json_buf_t *)arg;
+    size_t n = strlen(str);
+    TEST_ASSERT_LESS_THAN(sizeof(json->buf), json->len + n);
+    memcpy(json->buf + json->len, str, n + 1);
+    json->len += n;
+}
+
+TEST_CASE("boot graph chrome trace json", "[qmsd_boot]")
+{
+    qmsd_boot_graph_t graph;
+    qmsd_boot_graph_init(&graph);
+    int a = qmsd_boot_graph_add(&graph, "screen", 0);
+    int b = qmsd_boot_graph_add(&graph, "gui", QMSD_BOOT_DEP(a));
+    qmsd_boot_graph_take_ready(&graph);
+    qmsd_boot_graph_begin(&graph, a, 1000, 1);
+    qmsd_boot_graph_finish(&graph, a, 251000);
+    qmsd_boot_graph_begin(&graph, b, 251000, 0);
+    qmsd_boot_graph_mark(&graph, "first_frame", 300000);
+
+    json_buf_t json = {0};
+    qmsd_boot_graph_to_json(&graph, json_write, &json);
+    TEST_ASSERT_NOT_NULL(strstr(json.buf, "{\"name\":\"screen\",\"ph\":\"X\",\"ts\":1000,\"dur\":250000,\"pid\":0,\"tid\":0,\"args\":{\"core\":1}}"));
+    // unfinished stages only get their lane
+    TEST_ASSERT_NULL(strstr(json.buf, "\"name\":\"gui\",\"ph\":\"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(json.buf, "\"args\":{\"name\":\"gui\"}"));
+    TEST_ASSERT_NOT_NULL(strstr(json.buf, "{\"name\":\"first_frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":300000"));
+    TEST_ASSERT_EQUAL(0, strncmp(json.buf, "{\"traceEvents\":[", 16));
+    TEST_ASSERT_EQUAL(0, strcmp(json.buf + json.len - 4, "\n]}\n"));
+}
@@ -20,7 +20,7 @@ void app_main(void)
     
     // USE button GPIO0  
     btn_handle_t* btn0 = qmsd_button_create_gpio(0, 0, NULL);
-    // btn_handle_t* btn0 = qmsd_button_create_adc(ADC1_CHANNEL_1, 1630, 200, NULL);
+    // btn_handle_t* btn0 = qmsd_button_create_adc(ADC_CHANNEL_1, 1630, 200, NULL);
 
     qmsd_button_register_cb(btn0, BUTTON_PRESS_DOWN,       btn_callback);
 	qmsd_button_register_cb(btn0, BUTTON_PRESS_UP,         btn_callback);
@@ -31,12 +31,21 @@ void app_main(void)
 	qmsd_button_register_cb(btn0, BUTTON_LONG_PRESS_HOLD,  btn_callback);
     qmsd_button_start(btn0);
 
+    QueueHandle_t event_queue = qmsd_button_get_event_queue();
+    qmsd_button_event_t event;
     for (;;) {
-        if (qmsd_button_wait_event(btn0, BUTTON_SINGLE_CLICK, 0)) {
+        // blocks until something happens, no polling needed
+        if (xQueueReceive(event_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (event.event == BUTTON_SINGLE_CLICK) {
             printf("___ SINGLE_CLICK ___\r\n");
-        } else if (qmsd_button_wait_event(btn0, BUTTON_DOUBLE_CLICK, 0)) {
+        } else if (event.event == BUTTON_DOUBLE_CLICK) {
             printf("___ DOUBLE_CLICK ___\r\n");
+            qmsd_button_stats_t stats;
+            qmsd_button_get_stats(&stats);
+            printf("wakeups %lu in %lu ms, latency avg %lu us max %lu us\r\n", stats.wakeups, stats.elapsed_ms,
+                   stats.latency_us_avg, stats.latency_us_max);
         }
-        vTaskDelay(pdMS_TO_TICKS(20));
     }
 }
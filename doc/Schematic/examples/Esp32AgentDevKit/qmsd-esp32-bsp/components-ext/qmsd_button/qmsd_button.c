@@ -1,21 +1,21 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
 
 #include "qmsd_button.h"
+#include "qmsd_sched.h"
 
-#define BTN_EVENT_CB(ev) do { \
-	xEventGroupSetBits(handle->event_group, 1 << ev);	\
-	if(handle->cb[ev]) { \
-		handle->cb[ev]((btn_handle_t)handle, handle->user_data); \
-	} \
-} while (0)
+#define QMSD_BUTTON_EVENT_QUEUE_LEN     16
+#define QMSD_BUTTON_INPUT_QUEUE_LEN     16
 
 typedef struct _btn_data_t {
-	uint16_t ticks;
-	uint8_t  repeat;
+	btn_fsm_t fsm;
 	uint8_t  event;
-	uint8_t  state : 3;
-	uint8_t  debounce_cnt : 3;
-	uint8_t  active_level : 1;
-	uint8_t  button_level : 1;
+	uint8_t  started : 1;
+	uint8_t  wake_src : 2;
+	int64_t  edge_us;
 	btn_get_level_fun_t get_level;
 	void* hardware_data;
 	void* user_data;
@@ -28,14 +28,87 @@ typedef struct _btn_data_t {
 static btn_data_t* g_head_handle = NULL;
 static qmsd_button_config_t* g_button_config = NULL;
 
+static btn_wheel_t g_wheel;
+static btn_fsm_ops_t g_fsm_ops;
+static SemaphoreHandle_t g_lock = NULL;
+static QueueHandle_t g_input_queue = NULL;
+static QueueHandle_t g_event_queue = NULL;
+static uint8_t g_adc_active = 0;
+static qmsd_button_stats_t g_stats = {0};
+static uint32_t g_latency_cnt = 0;
+static uint64_t g_latency_sum = 0;
+static int64_t g_stats_start_us = 0;
+
 static void qmsd_button_update_task(void *arg);
 
+static uint32_t qmsd_button_now(void)
+{
+	return (uint32_t)(esp_timer_get_time() / 1000 / g_button_config->ticks_interval_ms);
+}
+
+static uint8_t qmsd_button_read_level(btn_data_t* handle, uint8_t scan_start)
+{
+	uint8_t wait_press = handle->fsm.state == 0 || handle->fsm.state == 2;
+	return handle->get_level(scan_start, wait_press, handle->hardware_data);
+}
+
+static uint8_t qmsd_button_fsm_read(btn_fsm_t* fsm)
+{
+	return qmsd_button_read_level((btn_data_t*)fsm, 1);
+}
+
+static void qmsd_button_fsm_emit(btn_fsm_t* fsm, press_event_t event, uint32_t now)
+{
+	btn_data_t* handle = (btn_data_t*)fsm;
+	handle->event = (uint8_t)event;
+	g_stats.events++;
+
+	if (handle->edge_us && (event == BUTTON_PRESS_DOWN || event == BUTTON_PRESS_UP)) {
+		uint32_t latency = (uint32_t)(esp_timer_get_time() - handle->edge_us);
+		handle->edge_us = 0;
+		if (latency > g_stats.latency_us_max) {
+			g_stats.latency_us_max = latency;
+		}
+		g_latency_sum += latency;
+		g_latency_cnt++;
+	}
+
+	xEventGroupSetBits(handle->event_group, 1 << event);
+	if (handle->cb[event]) {
+		handle->cb[event]((btn_handle_t)handle, handle->user_data);
+	}
+	if (g_event_queue) {
+		qmsd_button_event_t evt = {
+			.handle = (btn_handle_t)handle,
+			.event = event,
+			.user_data = handle->user_data,
+		};
+		if (xQueueSend(g_event_queue, &evt, 0) != pdTRUE) {
+			g_stats.dropped++;
+		}
+	}
+}
+
 void qmsd_button_init(qmsd_button_config_t* config) {
 	g_button_config = (qmsd_button_config_t *)calloc(1, sizeof(qmsd_button_config_t));
 	memcpy(g_button_config, config, sizeof(qmsd_button_config_t));
+	g_fsm_ops.debounce_ticks = g_button_config->debounce_ticks;
+	g_fsm_ops.short_ticks = g_button_config->short_ticks;
+	g_fsm_ops.long_ticks = g_button_config->long_ticks;
+	g_fsm_ops.hold_ticks = g_button_config->hold_ticks;
+	g_fsm_ops.read_level = qmsd_button_fsm_read;
+	g_fsm_ops.emit = qmsd_button_fsm_emit;
+	btn_wheel_init(&g_wheel, qmsd_button_now());
+	g_lock = xSemaphoreCreateRecursiveMutex();
+	g_stats_start_us = esp_timer_get_time();
 	if (g_button_config->update_task.en) {
-        xTaskCreatePinnedToCore(qmsd_button_update_task, "btn-update", 4 * 1024, NULL, g_button_config->update_task.priority, NULL, g_button_config->update_task.core);
-    }
+		g_input_queue = xQueueCreate(QMSD_BUTTON_INPUT_QUEUE_LEN, sizeof(btn_data_t *));
+		UBaseType_t prio = g_button_config->update_task.priority;
+		BaseType_t core = g_button_config->update_task.core;
+		uint32_t stack_size = 4 * 1024;
+		qmsd_sched_place("btn-update", &prio, &core, &stack_size);
+		xTaskCreatePinnedToCore(qmsd_button_update_task, "btn-update", stack_size, NULL, prio, NULL, core);
+	}
 }
 
 btn_handle_t qmsd_button_create(btn_get_level_fun_t get_level, void* hardware_data, uint8_t active_level, void* user_data)
@@ -43,11 +116,11 @@ btn_handle_t qmsd_button_create(btn_get_level_fun_t get_level, void* hardware_da
 	btn_data_t* handle = (btn_data_t *)calloc(1, sizeof(btn_data_t));
 	handle->event = (uint8_t)BUTTON_NONE_PRESS;
 	handle->get_level = get_level;
-	handle->button_level = handle->get_level(1, handle->state == 0 || handle->state == 2, hardware_data);
 	handle->hardware_data = hardware_data;
 	handle->user_data = user_data;
-	handle->active_level = active_level;
+	handle->wake_src = QMSD_BUTTON_WAKE_POLL;
 	handle->event_group = xEventGroupCreate();
+	btn_fsm_init(&handle->fsm, &g_wheel, &g_fsm_ops, active_level, get_level(1, 1, hardware_data));
 	return (btn_handle_t)handle;
 }
 
@@ -72,127 +145,44 @@ press_event_t qmsd_button_get_event(btn_handle_t btn_handle)
 uint8_t qmsd_button_get_repeat(btn_handle_t btn_handle)
 {
 	btn_data_t* handle = (btn_data_t*)btn_handle;
-	return handle->repeat;
+	return handle->fsm.repeat;
 }
 
-static void button_handler(uint8_t scan_start, btn_data_t* handle)
+static void button_handler(btn_data_t* handle, uint8_t level, uint32_t now)
 {
-	uint8_t read_gpio_level = handle->get_level(scan_start, handle->state == 0 || handle->state == 2, handle->hardware_data);
-
-	//ticks counter working..
-	if((handle->state) > 0) handle->ticks++;
-
-	/*------------button debounce handle---------------*/
-	if(read_gpio_level != handle->button_level) { //not equal to prev one
-		//continue read 3 times same new level change
-		if(++(handle->debounce_cnt) >= g_button_config->debounce_ticks) {
-			handle->button_level = read_gpio_level;
-			handle->debounce_cnt = 0;
-		}
-	} else { //level not change ,counter reset.
-		handle->debounce_cnt = 0;
-	}
-
-	/*-----------------State machine-------------------*/
-	switch (handle->state) {
-		case 0:
-			if(handle->button_level == handle->active_level) {	//start press down
-				handle->event = (uint8_t)BUTTON_PRESS_DOWN;
-				BTN_EVENT_CB(BUTTON_PRESS_DOWN);
-				handle->ticks = 0;
-				handle->repeat = 1;
-				handle->state = 1;
-			} else {
-				handle->event = (uint8_t)BUTTON_NONE_PRESS;
-			}
-			break;
-
-		case 1:
-			if(handle->button_level != handle->active_level) { //released press up
-				handle->event = (uint8_t)BUTTON_PRESS_UP;
-				BTN_EVENT_CB(BUTTON_PRESS_UP);
-				handle->ticks = 0;
-				handle->state = 2;
-
-			} else if(handle->ticks > g_button_config->long_ticks) {
-				handle->event = (uint8_t)BUTTON_LONG_PRESS_START;
-				BTN_EVENT_CB(BUTTON_LONG_PRESS_START);
-				handle->state = 5;
-			}
-			break;
-
-		case 2:
-			if(handle->button_level == handle->active_level) { //press down again
-				handle->event = (uint8_t)BUTTON_PRESS_DOWN;
-				BTN_EVENT_CB(BUTTON_PRESS_DOWN);
-				handle->repeat++;
-				handle->event = (uint8_t)BUTTON_PRESS_REPEAT;
-				BTN_EVENT_CB(BUTTON_PRESS_REPEAT); // repeat hit
-				handle->ticks = 0;
-				handle->state = 3;
-			} else if(handle->ticks > g_button_config->short_ticks) { //released timeout
-				if(handle->repeat == 1) {
-					handle->event = (uint8_t)BUTTON_SINGLE_CLICK;
-					BTN_EVENT_CB(BUTTON_SINGLE_CLICK);
-				} else if(handle->repeat == 2) {
-					handle->event = (uint8_t)BUTTON_DOUBLE_CLICK;
-					BTN_EVENT_CB(BUTTON_DOUBLE_CLICK); // repeat hit
-				}
-				handle->state = 0;
-			}
-			break;
-
-		case 3:
-			if(handle->button_level != handle->active_level) { //released press up
-				handle->event = (uint8_t)BUTTON_PRESS_UP;
-				BTN_EVENT_CB(BUTTON_PRESS_UP);
-				if(handle->ticks < g_button_config->short_ticks) {
-					handle->ticks = 0;
-					handle->state = 2; //repeat press
-				} else {
-					handle->state = 0;
-				}
-			} else if(handle->ticks > g_button_config->long_ticks){ // long press up
-				handle->state = 1;
-			}
-			break;
-
-		case 5:
-			if(handle->button_level == handle->active_level) {
-				//continue hold trigger
-				handle->event = (uint8_t)BUTTON_LONG_PRESS_HOLD;
-				BTN_EVENT_CB(BUTTON_LONG_PRESS_HOLD);
-			} else { //released
-				handle->event = (uint8_t)BUTTON_PRESS_UP;
-				BTN_EVENT_CB(BUTTON_PRESS_UP);
-				handle->state = 0; //reset
-			}
-			break;
-		default:
-			handle->state = 0; //reset
-			break;
+	btn_fsm_input(&handle->fsm, level, now);
+	if (btn_fsm_idle(&handle->fsm) && handle->fsm.button_level != handle->fsm.active_level) {
+		handle->event = (uint8_t)BUTTON_NONE_PRESS;
 	}
 }
 
 uint8_t qmsd_button_get_level(btn_handle_t btn_handle) {
 	btn_data_t* handle = (btn_data_t*)btn_handle;
-	if (g_button_config && g_button_config->update_task.en && handle->next) {
-		return handle->button_level;
+	if (g_button_config && g_button_config->update_task.en && handle->started) {
+		return handle->fsm.button_level;
 	}
 
-	return handle->get_level(1, handle->state == 0 || handle->state == 2, handle->hardware_data);
+	return qmsd_button_read_level(handle, 1);
 }
 
 int qmsd_button_start(btn_handle_t btn_handle)
 {
 	btn_data_t* handle = (btn_data_t*)btn_handle;
+	xSemaphoreTakeRecursive(g_lock, portMAX_DELAY);
 	btn_data_t* target = g_head_handle;
 	while(target) {
-		if(target == handle) return -1;	//already exist.
+		if(target == handle) {
+			xSemaphoreGiveRecursive(g_lock);
+			return -1;	//already exist.
+		}
 		target = target->next;
 	}
 	handle->next = g_head_handle;
 	g_head_handle = handle;
+	handle->started = 1;
+	xSemaphoreGiveRecursive(g_lock);
+	// pick up the new button right away, the engine may be sleeping without timeout
+	qmsd_button_notify(btn_handle);
 	return 0;
 }
 
@@ -200,23 +190,31 @@ void qmsd_button_stop(btn_handle_t btn_handle)
 {
 	btn_data_t* handle = (btn_data_t*)btn_handle;
 	btn_data_t** curr;
+	xSemaphoreTakeRecursive(g_lock, portMAX_DELAY);
 	for(curr = &g_head_handle; *curr; ) {
 		btn_data_t* entry = *curr;
 		if (entry == handle) {
 			*curr = entry->next;
-			return; //glacier add 2021-8-18
+			handle->started = 0;
+			btn_fsm_stop(&handle->fsm);
+			break; //glacier add 2021-8-18
 		} else {
 			curr = &entry->next;
 		}
 	}
+	xSemaphoreGiveRecursive(g_lock);
 }
 
 void qmsd_button_update()
 {
 	btn_data_t* target;
+	xSemaphoreTakeRecursive(g_lock, portMAX_DELAY);
+	uint32_t now = qmsd_button_now();
+	btn_wheel_advance(&g_wheel, now);
 	for(target = g_head_handle; target; target = target->next) {
-		button_handler(target == g_head_handle, target);
+		button_handler(target, qmsd_button_read_level(target, target == g_head_handle), now);
 	}
+	xSemaphoreGiveRecursive(g_lock);
 }
 
 void qmsd_button_reset_event(btn_handle_t btn_handle)
@@ -240,10 +238,123 @@ bool qmsd_button_wait_event(btn_handle_t btn_handle, press_event_t event, uint32
 	return (xEventGroupWaitBits(handle->event_group, wait_bits, true, false, pdMS_TO_TICKS(ticks_ms)) & wait_bits) > 0x00;
 }
 
+QueueHandle_t qmsd_button_get_event_queue(void)
+{
+	if (g_event_queue == NULL) {
+		g_event_queue = xQueueCreate(QMSD_BUTTON_EVENT_QUEUE_LEN, sizeof(qmsd_button_event_t));
+	}
+	return g_event_queue;
+}
+
+void qmsd_button_set_wake_source(btn_handle_t btn_handle, qmsd_button_wake_t wake_src)
+{
+	btn_data_t* handle = (btn_data_t*)btn_handle;
+	handle->wake_src = wake_src;
+}
+
+void IRAM_ATTR qmsd_button_notify_from_isr(btn_handle_t btn_handle)
+{
+	if (g_input_queue == NULL) {
+		return ;
+	}
+	btn_data_t* handle = (btn_data_t*)btn_handle;
+	BaseType_t task_woken = pdFALSE;
+	if (handle->edge_us == 0) {
+		handle->edge_us = esp_timer_get_time();
+	}
+	xQueueSendFromISR(g_input_queue, &handle, &task_woken);
+	if (task_woken) {
+		portYIELD_FROM_ISR();
+	}
+}
+
+void qmsd_button_notify(btn_handle_t btn_handle)
+{
+	if (g_input_queue == NULL) {
+		return ;
+	}
+	xQueueSend(g_input_queue, &btn_handle, 0);
+}
+
+void qmsd_button_get_stats(qmsd_button_stats_t* stats)
+{
+	*stats = g_stats;
+	stats->latency_us_avg = g_latency_cnt ? (uint32_t)(g_latency_sum / g_latency_cnt) : 0;
+	stats->elapsed_ms = (uint32_t)((esp_timer_get_time() - g_stats_start_us) / 1000);
+}
+
+void qmsd_button_reset_stats(void)
+{
+	memset(&g_stats, 0, sizeof(g_stats));
+	g_latency_cnt = 0;
+	g_latency_sum = 0;
+	g_stats_start_us = esp_timer_get_time();
+}
+
+// Buttons that can not raise an interrupt are sampled every tick, ADC buttons
+// only between a monitor wake up and the moment they are all released again.
+static bool qmsd_button_poll_needed(void)
+{
+	bool adc_busy = false;
+	for (btn_data_t* target = g_head_handle; target; target = target->next) {
+		if (target->wake_src == QMSD_BUTTON_WAKE_POLL) {
+			return true;
+		}
+		if (target->wake_src == QMSD_BUTTON_WAKE_ADC && g_adc_active) {
+			if (!btn_fsm_idle(&target->fsm) || target->fsm.button_level == target->fsm.active_level) {
+				adc_busy = true;
+			}
+		}
+	}
+	if (g_adc_active && !adc_busy) {
+		g_adc_active = 0;
+		qmsd_button_adc_rearm();
+	}
+	return g_adc_active;
+}
+
+static void qmsd_button_poll(uint32_t now)
+{
+	uint8_t scan_start = 1;
+	for (btn_data_t* target = g_head_handle; target; target = target->next) {
+		if (target->wake_src == QMSD_BUTTON_WAKE_POLL || (target->wake_src == QMSD_BUTTON_WAKE_ADC && g_adc_active)) {
+			button_handler(target, qmsd_button_read_level(target, scan_start), now);
+			scan_start = 0;
+		}
+	}
+}
+
 static void qmsd_button_update_task(void *arg)
 {
+	btn_data_t* handle = NULL;
 	for (;;) {
-		qmsd_button_update();
-		vTaskDelay(pdMS_TO_TICKS(g_button_config->ticks_interval_ms));
+		xSemaphoreTakeRecursive(g_lock, portMAX_DELAY);
+		bool poll = qmsd_button_poll_needed();
+		uint32_t next = poll ? 1 : btn_wheel_next(&g_wheel);
+		xSemaphoreGiveRecursive(g_lock);
+
+		TickType_t timeout = portMAX_DELAY;
+		if (next != BTN_WHEEL_NONE) {
+			timeout = pdMS_TO_TICKS(next * g_button_config->ticks_interval_ms);
+		}
+		BaseType_t got = xQueueReceive(g_input_queue, &handle, timeout);
+		g_stats.wakeups++;
+
+		xSemaphoreTakeRecursive(g_lock, portMAX_DELAY);
+		uint32_t now = qmsd_button_now();
+		btn_wheel_advance(&g_wheel, now);
+		while (got == pdTRUE) {
+			if (handle->started) {
+				if (handle->wake_src == QMSD_BUTTON_WAKE_ADC) {
+					g_adc_active = 1;
+				}
+				button_handler(handle, qmsd_button_read_level(handle, 1), now);
+			}
+			got = xQueueReceive(g_input_queue, &handle, 0);
+		}
+		if (poll) {
+			qmsd_button_poll(now);
+		}
+		xSemaphoreGiveRecursive(g_lock);
 	}
 }
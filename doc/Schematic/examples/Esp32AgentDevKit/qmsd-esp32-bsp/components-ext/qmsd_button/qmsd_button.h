@@ -5,30 +5,43 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
+#include "freertos/queue.h"
 
-#include "driver/adc.h"
+#include "hal/adc_types.h"
+
+#include "qmsd_button_fsm.h"
 
 typedef void *btn_handle_t;
 typedef void (*btn_callback_t)(btn_handle_t handle, void* user_data);
 typedef uint8_t (*btn_get_level_fun_t)(uint8_t scan_start, uint8_t wait_press, void* hardware_data);
 
 typedef enum {
-    BUTTON_PRESS_DOWN = 0,
-    BUTTON_PRESS_UP,
-    BUTTON_PRESS_REPEAT,
-    BUTTON_SINGLE_CLICK,
-    BUTTON_DOUBLE_CLICK,
-    BUTTON_LONG_PRESS_START,
-    BUTTON_LONG_PRESS_HOLD,
-    BUTTON_EVENT_MAX,
-    BUTTON_NONE_PRESS
-} press_event_t;
+    QMSD_BUTTON_WAKE_POLL = 0,  // sampled every tick, for get_level callbacks without interrupt
+    QMSD_BUTTON_WAKE_GPIO,      // gpio edge interrupt
+    QMSD_BUTTON_WAKE_ADC,       // adc continuous monitor threshold
+} qmsd_button_wake_t;
+
+typedef struct {
+    btn_handle_t handle;
+    press_event_t event;
+    void* user_data;
+} qmsd_button_event_t;
+
+typedef struct {
+    uint32_t elapsed_ms;        // since init or the last reset
+    uint32_t wakeups;           // update task wake ups
+    uint32_t events;
+    uint32_t dropped;           // events lost on a full event queue
+    uint32_t latency_us_max;    // edge interrupt -> press down / up event
+    uint32_t latency_us_avg;
+} qmsd_button_stats_t;
 
 typedef struct {
 	uint8_t ticks_interval_ms;
 	uint8_t debounce_ticks;
 	uint16_t long_ticks;
 	uint16_t short_ticks;
+	uint16_t hold_ticks;	// LONG_PRESS_HOLD period, 0 is every tick
 	struct {
 		uint8_t en: 1;
 		uint8_t priority: 7;
@@ -41,6 +54,7 @@ typedef struct {
     .debounce_ticks = 2,\
     .short_ticks = 200 / 10,\
     .long_ticks = 1000 / 10,\
+    .hold_ticks = 1,\
     .update_task = {\
         .en = 1,\
         .core = 1,\
@@ -58,7 +72,7 @@ btn_handle_t qmsd_button_create(btn_get_level_fun_t get_level, void* hardware_da
 
 btn_handle_t qmsd_button_create_gpio(uint8_t gpio_num, uint8_t active_level, void* user_data);
 
-btn_handle_t qmsd_button_create_adc(adc1_channel_t adc_channel, uint16_t middle_volt_mv, uint16_t diff_volt_mv, void* user_data);
+btn_handle_t qmsd_button_create_adc(adc_channel_t adc_channel, uint16_t middle_volt_mv, uint16_t diff_volt_mv, void* user_data);
 
 void qmsd_button_register_cb(btn_handle_t handle, press_event_t event, btn_callback_t cb);
 
@@ -80,6 +94,22 @@ void qmsd_button_reset_event(btn_handle_t btn_handle);
 
 bool qmsd_button_wait_event(btn_handle_t btn_handle, press_event_t event, uint32_t ticks_ms);
 
+// All events of all buttons, created on first call. Item type is qmsd_button_event_t.
+QueueHandle_t qmsd_button_get_event_queue(void);
+
+void qmsd_button_get_stats(qmsd_button_stats_t* stats);
+
+void qmsd_button_reset_stats(void);
+
+// For hardware backends: how a button wakes the update task, and the wake up itself.
+void qmsd_button_set_wake_source(btn_handle_t btn_handle, qmsd_button_wake_t wake_src);
+
+void qmsd_button_notify_from_isr(btn_handle_t btn_handle);
+
+void qmsd_button_notify(btn_handle_t btn_handle);
+
+void qmsd_button_adc_rearm(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,87 +1,224 @@
-#include "driver/adc.h"
 #include "esp_log.h"
-#include "esp_adc_cal.h"
+#include "esp_attr.h"
+#include "soc/soc_caps.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_monitor.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
 #include "qmsd_button.h"
 
 #define TAG "BTN_ADC"
 
-#define ADC_BUTTON_WIDTH        ADC_WIDTH_MAX-1
-#define ADC_BUTTON_ATTEN        3 // ADC_ATTEN_DB_12 or ADC_ATTEN_DB_11 (old sdk version)
+#define ADC_BUTTON_ATTEN        ADC_ATTEN_DB_12
 #define ADC_BUTTON_ADC_UNIT     ADC_UNIT_1
-#define ADC_DEFAULT_VREF        1100
-#define ADC_NUM_OF_SAMPLES      1
+#define ADC_BUTTON_BITWIDTH     ADC_BITWIDTH_12
+#define ADC_BUTTON_CHANNEL_NUM  SOC_ADC_CHANNEL_NUM(ADC_BUTTON_ADC_UNIT)
+#define ADC_BUTTON_FULL_MV      3100
+#define ADC_BUTTON_SAMPLE_HZ    SOC_ADC_SAMPLE_FREQ_THRES_LOW
+// ~10 dma frames per second while idle, the only cpu work until a key goes down
+#define ADC_BUTTON_FRAME_CONV   64
+#define ADC_BUTTON_READ_BUF     (ADC_BUTTON_FRAME_CONV * SOC_ADC_DIGI_RESULT_BYTES)
+#define ADC_BUTTON_MONITOR_NUM  SOC_ADC_DIGI_MONITOR_NUM
+// wake a little early, the monitor compares raw codes without calibration
+#define ADC_BUTTON_MONITOR_MARGIN_MV    50
 
 typedef struct {
-    esp_adc_cal_characteristics_t adc_chars;
+    adc_continuous_handle_t handle;
+    adc_cali_handle_t cali;
     uint8_t is_configured;
+    uint8_t is_running;
+    uint8_t monitor_used;
+    volatile uint8_t monitor_armed;
     struct {
         uint8_t is_init;
         uint16_t volt_mv;
-    } channel[ADC1_CHANNEL_MAX];
+        uint16_t wake_below_mv;
+        btn_handle_t first_btn;
+        adc_monitor_handle_t monitor;
+    } channel[ADC_BUTTON_CHANNEL_NUM];
 } adc_data_t;
 
-typedef struct {
+typedef struct _btn_hw_info_t {
     uint8_t channel;
     uint16_t max_volt_mv;
     uint16_t min_volt_mv;
+    btn_handle_t handle;
+    struct _btn_hw_info_t* next;
 } btn_hw_info_t;
 
 static adc_data_t g_btn = {0};
+static btn_hw_info_t* g_hw_head = NULL;
 
-uint16_t get_volt_mv(adc1_channel_t channel) {
-    uint32_t adc_reading = 0;
-
-    for (int i = 0; i < ADC_NUM_OF_SAMPLES; i++) {
-        adc_reading += adc1_get_raw(channel);
+// Drain what the dma collected so far and keep the newest sample of each channel.
+static void adc_update_volt(void) {
+    uint8_t buf[ADC_BUTTON_READ_BUF];
+    uint32_t out_len = 0;
+    while (adc_continuous_read(g_btn.handle, buf, sizeof(buf), &out_len, 0) == ESP_OK) {
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= out_len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t* p = (adc_digi_output_data_t *)&buf[i];
+            uint32_t chan = p->type2.channel;
+            if (chan >= ADC_BUTTON_CHANNEL_NUM || !g_btn.channel[chan].is_init) {
+                continue;
+            }
+            int voltage = 0;
+            if (g_btn.cali && adc_cali_raw_to_voltage(g_btn.cali, p->type2.data, &voltage) == ESP_OK) {
+                g_btn.channel[chan].volt_mv = voltage;
+            } else {
+                g_btn.channel[chan].volt_mv = (uint32_t)p->type2.data * ADC_BUTTON_FULL_MV / 4095;
+            }
+        }
     }
-    adc_reading /= ADC_NUM_OF_SAMPLES;
-
-    //Convert adc_reading to voltage in mV
-    uint32_t voltage = esp_adc_cal_raw_to_voltage(adc_reading, &g_btn.adc_chars);
-    return voltage;
 }
 
 uint8_t qmsd_button_adc_read(uint8_t scan_start, uint8_t wait_press, void* hardware_data) {
-    if (scan_start) {
-        for (uint8_t i = 0; i < ADC1_CHANNEL_MAX; i++) {
-            if (g_btn.channel[i].is_init) {
-                g_btn.channel[i].volt_mv = get_volt_mv(i);
-            }
-        }
+    if (scan_start && g_btn.is_running) {
+        adc_update_volt();
     }
     btn_hw_info_t* hw_info = hardware_data;
     return g_btn.channel[hw_info->channel].volt_mv > hw_info->max_volt_mv || g_btn.channel[hw_info->channel].volt_mv < hw_info->min_volt_mv;
 }
 
+static bool IRAM_ATTR adc_monitor_below_cb(adc_monitor_handle_t monitor, const adc_monitor_evt_data_t* data, void* user_data) {
+    // the monitor keeps firing while the key is held, only the first one wakes the engine
+    if (!g_btn.monitor_armed) {
+        return false;
+    }
+    g_btn.monitor_armed = 0;
+    qmsd_button_notify_from_isr((btn_handle_t)user_data);
+    return false;
+}
+
+void qmsd_button_adc_rearm(void) {
+    g_btn.monitor_armed = 1;
+}
+
+static void adc_stop(void) {
+    if (!g_btn.is_running) {
+        return ;
+    }
+    adc_continuous_stop(g_btn.handle);
+    for (uint8_t i = 0; i < ADC_BUTTON_CHANNEL_NUM; i++) {
+        if (g_btn.channel[i].monitor) {
+            adc_continuous_monitor_disable(g_btn.channel[i].monitor);
+            adc_del_continuous_monitor(g_btn.channel[i].monitor);
+            g_btn.channel[i].monitor = NULL;
+        }
+    }
+    adc_continuous_deinit(g_btn.handle);
+    g_btn.handle = NULL;
+    g_btn.monitor_used = 0;
+    g_btn.is_running = 0;
+}
+
+static void adc_start(void) {
+    adc_digi_pattern_config_t pattern[ADC_BUTTON_CHANNEL_NUM] = {0};
+    uint32_t pattern_num = 0;
+    for (uint8_t i = 0; i < ADC_BUTTON_CHANNEL_NUM; i++) {
+        if (g_btn.channel[i].is_init) {
+            pattern[pattern_num].atten = ADC_BUTTON_ATTEN;
+            pattern[pattern_num].channel = i;
+            pattern[pattern_num].unit = ADC_BUTTON_ADC_UNIT;
+            pattern[pattern_num].bit_width = ADC_BUTTON_BITWIDTH;
+            pattern_num++;
+        }
+    }
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = ADC_BUTTON_READ_BUF * 2,
+        .conv_frame_size = ADC_BUTTON_READ_BUF,
+        .flags.flush_pool = 1,
+    };
+    ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_cfg, &g_btn.handle));
+
+    adc_continuous_config_t adc_cfg = {
+        .pattern_num = pattern_num,
+        .adc_pattern = pattern,
+        .sample_freq_hz = ADC_BUTTON_SAMPLE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    ESP_ERROR_CHECK(adc_continuous_config(g_btn.handle, &adc_cfg));
+
+    for (uint8_t i = 0; i < ADC_BUTTON_CHANNEL_NUM; i++) {
+        if (!g_btn.channel[i].is_init) {
+            continue;
+        }
+        // idle level of a resistor ladder sits above every key window,
+        // channels where it does not, or past the monitor count, stay polled
+        if (g_btn.channel[i].wake_below_mv + ADC_BUTTON_MONITOR_MARGIN_MV >= ADC_BUTTON_FULL_MV || g_btn.monitor_used >= ADC_BUTTON_MONITOR_NUM) {
+            continue;
+        }
+        adc_monitor_config_t monitor_cfg = {
+            .adc_unit = ADC_BUTTON_ADC_UNIT,
+            .channel = i,
+            .h_threshold = -1,
+            .l_threshold = (uint32_t)(g_btn.channel[i].wake_below_mv + ADC_BUTTON_MONITOR_MARGIN_MV) * 4095 / ADC_BUTTON_FULL_MV,
+        };
+        adc_monitor_evt_cbs_t cbs = {
+            .on_below_low_thresh = adc_monitor_below_cb,
+        };
+        if (adc_new_continuous_monitor(g_btn.handle, &monitor_cfg, &g_btn.channel[i].monitor) != ESP_OK) {
+            g_btn.channel[i].monitor = NULL;
+            continue;
+        }
+        adc_continuous_monitor_register_event_callbacks(g_btn.channel[i].monitor, &cbs, g_btn.channel[i].first_btn);
+        adc_continuous_monitor_enable(g_btn.channel[i].monitor);
+        g_btn.monitor_used++;
+    }
+
+    ESP_ERROR_CHECK(adc_continuous_start(g_btn.handle));
+    g_btn.monitor_armed = 1;
+    g_btn.is_running = 1;
+}
+
 // ESP32S3 only support ADC1: 10 channels: GPIO1 - GPIO10
-btn_handle_t qmsd_button_create_adc(adc1_channel_t adc_channel, uint16_t middle_volt_mv, uint16_t diff_volt_mv, void* user_data) {
+btn_handle_t qmsd_button_create_adc(adc_channel_t adc_channel, uint16_t middle_volt_mv, uint16_t diff_volt_mv, void* user_data) {
     if (g_btn.is_configured == 0) {
-        //Configure ADC
-        adc1_config_width(ADC_BUTTON_WIDTH);
-        //Characterize ADC
-        esp_adc_cal_value_t val_type = esp_adc_cal_characterize(ADC_BUTTON_ADC_UNIT, ADC_BUTTON_ATTEN, ADC_BUTTON_WIDTH, ADC_DEFAULT_VREF, &g_btn.adc_chars);
-        if (val_type == ESP_ADC_CAL_VAL_EFUSE_TP) {
-            ESP_LOGI(TAG, "Characterized using Two Point Value");
-        } else if (val_type == ESP_ADC_CAL_VAL_EFUSE_VREF) {
-            ESP_LOGI(TAG, "Characterized using eFuse Vref");
+        adc_cali_curve_fitting_config_t cali_cfg = {
+            .unit_id = ADC_BUTTON_ADC_UNIT,
+            .chan = adc_channel,
+            .atten = ADC_BUTTON_ATTEN,
+            .bitwidth = ADC_BUTTON_BITWIDTH,
+        };
+        if (adc_cali_create_scheme_curve_fitting(&cali_cfg, &g_btn.cali) == ESP_OK) {
+            ESP_LOGI(TAG, "Characterized using curve fitting");
         } else {
+            g_btn.cali = NULL;
             ESP_LOGI(TAG, "Characterized using Default Vref");
         }
         g_btn.is_configured = 1;
     }
 
-    if (g_btn.channel[adc_channel].is_init == 0) {
-        adc1_config_channel_atten(adc_channel, ADC_BUTTON_ATTEN);
-        g_btn.channel[adc_channel].is_init = 1;
-    }
-    btn_hw_info_t* hw_info = (btn_hw_info_t *)malloc(sizeof(btn_hw_info_t));
+    btn_hw_info_t* hw_info = (btn_hw_info_t *)calloc(1, sizeof(btn_hw_info_t));
     hw_info->channel = adc_channel;
     hw_info->max_volt_mv = middle_volt_mv + diff_volt_mv;
     if (diff_volt_mv > middle_volt_mv) {
-        hw_info->min_volt_mv = 0;    
+        hw_info->min_volt_mv = 0;
     } else {
         hw_info->min_volt_mv = middle_volt_mv - diff_volt_mv;
     }
 
-    return qmsd_button_create(qmsd_button_adc_read, (void *)hw_info, 0, user_data);
+    // the pattern and the monitors are fixed once started, rebuild them with the new key
+    adc_stop();
+    if (g_btn.channel[adc_channel].is_init == 0) {
+        g_btn.channel[adc_channel].is_init = 1;
+        g_btn.channel[adc_channel].volt_mv = ADC_BUTTON_FULL_MV;
+    }
+    if (hw_info->max_volt_mv > g_btn.channel[adc_channel].wake_below_mv) {
+        g_btn.channel[adc_channel].wake_below_mv = hw_info->max_volt_mv;
+    }
+
+    btn_handle_t handle = qmsd_button_create(qmsd_button_adc_read, (void *)hw_info, 0, user_data);
+    hw_info->handle = handle;
+    hw_info->next = g_hw_head;
+    g_hw_head = hw_info;
+    if (g_btn.channel[adc_channel].first_btn == NULL) {
+        g_btn.channel[adc_channel].first_btn = handle;
+    }
+    adc_start();
+
+    for (btn_hw_info_t* info = g_hw_head; info; info = info->next) {
+        qmsd_button_set_wake_source(info->handle, g_btn.channel[info->channel].monitor ? QMSD_BUTTON_WAKE_ADC : QMSD_BUTTON_WAKE_POLL);
+    }
+    return handle;
 }
@@ -0,0 +1,272 @@
+#include "stddef.h"
+#include "string.h"
+
+#include "qmsd_button_fsm.h"
+
+#define TICK_AFTER(a, b)	((int32_t)((a) - (b)) > 0)
+#define FSM_OF(timer, member)	((btn_fsm_t *)((char *)(timer) - offsetof(btn_fsm_t, member)))
+
+enum {
+	BTN_STATE_IDLE = 0,
+	BTN_STATE_PRESSED,
+	BTN_STATE_RELEASED,
+	BTN_STATE_REPEAT,
+	BTN_STATE_LONG_HOLD = 5,
+};
+
+void btn_wheel_init(btn_wheel_t* wheel, uint32_t now)
+{
+	memset(wheel, 0, sizeof(btn_wheel_t));
+	wheel->now = now;
+}
+
+void btn_wheel_add(btn_wheel_t* wheel, btn_timer_t* timer, uint32_t expires)
+{
+	if (timer->armed) {
+		btn_wheel_del(wheel, timer);
+	}
+	// a timer in the past would sit in a slot the wheel already passed
+	if (!TICK_AFTER(expires, wheel->now)) {
+		expires = wheel->now + 1;
+	}
+	btn_timer_t** slot = &wheel->slot[expires % BTN_WHEEL_SLOTS];
+	timer->expires = expires;
+	timer->armed = 1;
+	timer->next = *slot;
+	*slot = timer;
+	wheel->count++;
+}
+
+void btn_wheel_del(btn_wheel_t* wheel, btn_timer_t* timer)
+{
+	if (!timer->armed) {
+		return ;
+	}
+	btn_timer_t** curr;
+	for (curr = &wheel->slot[timer->expires % BTN_WHEEL_SLOTS]; *curr; curr = &(*curr)->next) {
+		if (*curr == timer) {
+			*curr = timer->next;
+			timer->next = NULL;
+			timer->armed = 0;
+			wheel->count--;
+			return ;
+		}
+	}
+}
+
+// Walk the slots forward from now: the first timer due in this round is the earliest.
+// Only when none is due within BTN_WHEEL_SLOTS ticks has every slot been looked at.
+static btn_timer_t* btn_wheel_earliest(btn_wheel_t* wheel)
+{
+	btn_timer_t* later = NULL;
+	if (wheel->count == 0) {
+		return NULL;
+	}
+	for (uint32_t i = 0; i < BTN_WHEEL_SLOTS; i++) {
+		uint32_t tick = wheel->now + i;
+		for (btn_timer_t* timer = wheel->slot[tick % BTN_WHEEL_SLOTS]; timer; timer = timer->next) {
+			if (timer->expires == tick) {
+				return timer;
+			}
+			if (later == NULL || TICK_AFTER(later->expires, timer->expires)) {
+				later = timer;
+			}
+		}
+	}
+	return later;
+}
+
+void btn_wheel_advance(btn_wheel_t* wheel, uint32_t now)
+{
+	while (TICK_AFTER(now, wheel->now)) {
+		btn_timer_t* earliest = btn_wheel_earliest(wheel);
+		if (earliest == NULL || TICK_AFTER(earliest->expires, now)) {
+			wheel->now = now;
+			break;
+		}
+		// jump straight over empty ticks
+		wheel->now = earliest->expires;
+
+		// detach first: callbacks are free to re-arm into the same slot
+		btn_timer_t* fired = NULL;
+		btn_timer_t** curr = &wheel->slot[wheel->now % BTN_WHEEL_SLOTS];
+		while (*curr) {
+			btn_timer_t* timer = *curr;
+			if (timer->expires == wheel->now) {
+				*curr = timer->next;
+				timer->armed = 0;
+				timer->next = fired;
+				fired = timer;
+				wheel->count--;
+			} else {
+				curr = &timer->next;
+			}
+		}
+		while (fired) {
+			btn_timer_t* timer = fired;
+			fired = timer->next;
+			timer->next = NULL;
+			timer->cb(timer, wheel->now);
+		}
+	}
+}
+
+uint32_t btn_wheel_next(btn_wheel_t* wheel)
+{
+	if (wheel->count == 0) {
+		return BTN_WHEEL_NONE;
+	}
+	btn_timer_t* earliest = btn_wheel_earliest(wheel);
+	if (!TICK_AFTER(earliest->expires, wheel->now)) {
+		return 0;
+	}
+	return earliest->expires - wheel->now;
+}
+
+static void btn_fsm_arm(btn_fsm_t* fsm, uint32_t expires)
+{
+	btn_wheel_add(fsm->wheel, &fsm->state_timer, expires);
+}
+
+static void btn_fsm_apply_level(btn_fsm_t* fsm, uint8_t level, uint32_t now)
+{
+	const btn_fsm_ops_t* ops = fsm->ops;
+	uint8_t pressed = (level == fsm->active_level);
+	fsm->button_level = level;
+
+	switch (fsm->state) {
+		case BTN_STATE_IDLE:
+			if (pressed) {
+				ops->emit(fsm, BUTTON_PRESS_DOWN, now);
+				fsm->repeat = 1;
+				fsm->press_tick = now;
+				fsm->state = BTN_STATE_PRESSED;
+				btn_fsm_arm(fsm, now + ops->long_ticks + 1);
+			}
+			break;
+
+		case BTN_STATE_PRESSED:
+			if (!pressed) {
+				ops->emit(fsm, BUTTON_PRESS_UP, now);
+				fsm->state = BTN_STATE_RELEASED;
+				btn_fsm_arm(fsm, now + ops->short_ticks + 1);
+			}
+			break;
+
+		case BTN_STATE_RELEASED:
+			if (pressed) {
+				ops->emit(fsm, BUTTON_PRESS_DOWN, now);
+				fsm->repeat++;
+				ops->emit(fsm, BUTTON_PRESS_REPEAT, now);
+				fsm->press_tick = now;
+				fsm->state = BTN_STATE_REPEAT;
+				btn_fsm_arm(fsm, now + ops->long_ticks + 1);
+			}
+			break;
+
+		case BTN_STATE_REPEAT:
+			if (!pressed) {
+				ops->emit(fsm, BUTTON_PRESS_UP, now);
+				if (now - fsm->press_tick < ops->short_ticks) {
+					fsm->state = BTN_STATE_RELEASED;
+					btn_fsm_arm(fsm, now + ops->short_ticks + 1);
+				} else {
+					fsm->state = BTN_STATE_IDLE;
+					btn_wheel_del(fsm->wheel, &fsm->state_timer);
+				}
+			}
+			break;
+
+		case BTN_STATE_LONG_HOLD:
+			if (!pressed) {
+				ops->emit(fsm, BUTTON_PRESS_UP, now);
+				fsm->state = BTN_STATE_IDLE;
+				btn_wheel_del(fsm->wheel, &fsm->state_timer);
+			}
+			break;
+
+		default:
+			fsm->state = BTN_STATE_IDLE;
+			break;
+	}
+}
+
+static void btn_fsm_state_timeout(btn_timer_t* timer, uint32_t now)
+{
+	btn_fsm_t* fsm = FSM_OF(timer, state_timer);
+	const btn_fsm_ops_t* ops = fsm->ops;
+	uint16_t hold_ticks = ops->hold_ticks ? ops->hold_ticks : 1;
+
+	switch (fsm->state) {
+		case BTN_STATE_PRESSED:
+		case BTN_STATE_REPEAT:
+			ops->emit(fsm, BUTTON_LONG_PRESS_START, now);
+			fsm->state = BTN_STATE_LONG_HOLD;
+			btn_fsm_arm(fsm, now + hold_ticks);
+			break;
+
+		case BTN_STATE_RELEASED:
+			if (fsm->repeat == 1) {
+				ops->emit(fsm, BUTTON_SINGLE_CLICK, now);
+			} else if (fsm->repeat == 2) {
+				ops->emit(fsm, BUTTON_DOUBLE_CLICK, now);
+			}
+			fsm->state = BTN_STATE_IDLE;
+			break;
+
+		case BTN_STATE_LONG_HOLD:
+			ops->emit(fsm, BUTTON_LONG_PRESS_HOLD, now);
+			btn_fsm_arm(fsm, now + hold_ticks);
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void btn_fsm_debounce_timeout(btn_timer_t* timer, uint32_t now)
+{
+	btn_fsm_t* fsm = FSM_OF(timer, debounce_timer);
+	uint8_t level = fsm->ops->read_level(fsm);
+	if (level != fsm->button_level) {
+		btn_fsm_apply_level(fsm, level, now);
+	}
+}
+
+void btn_fsm_init(btn_fsm_t* fsm, btn_wheel_t* wheel, const btn_fsm_ops_t* ops, uint8_t active_level, uint8_t level)
+{
+	memset(fsm, 0, sizeof(btn_fsm_t));
+	fsm->wheel = wheel;
+	fsm->ops = ops;
+	fsm->active_level = active_level;
+	fsm->button_level = level;
+	fsm->debounce_timer.cb = btn_fsm_debounce_timeout;
+	fsm->state_timer.cb = btn_fsm_state_timeout;
+}
+
+void btn_fsm_input(btn_fsm_t* fsm, uint8_t level, uint32_t now)
+{
+	if (level == fsm->button_level) {
+		// bounced back before the debounce window closed
+		btn_wheel_del(fsm->wheel, &fsm->debounce_timer);
+		return ;
+	}
+
+	if (fsm->ops->debounce_ticks == 0) {
+		btn_fsm_apply_level(fsm, level, now);
+	} else if (!fsm->debounce_timer.armed) {
+		btn_wheel_add(fsm->wheel, &fsm->debounce_timer, now + fsm->ops->debounce_ticks);
+	}
+}
+
+void btn_fsm_stop(btn_fsm_t* fsm)
+{
+	btn_wheel_del(fsm->wheel, &fsm->debounce_timer);
+	btn_wheel_del(fsm->wheel, &fsm->state_timer);
+	fsm->state = BTN_STATE_IDLE;
+}
+
+bool btn_fsm_idle(btn_fsm_t* fsm)
+{
+	return fsm->state == BTN_STATE_IDLE && !fsm->debounce_timer.armed;
+}
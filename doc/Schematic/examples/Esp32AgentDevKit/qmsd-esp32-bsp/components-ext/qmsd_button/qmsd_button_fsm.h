@@ -0,0 +1,90 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Portable part of qmsd_button: timer wheel + press state machine.
+// No FreeRTOS / driver dependency so it can be built and unit-tested on the host.
+// Time is counted in button ticks (qmsd_button_config_t.ticks_interval_ms).
+
+#define BTN_WHEEL_SLOTS         64
+#define BTN_WHEEL_NONE          0xffffffffUL
+
+typedef enum {
+    BUTTON_PRESS_DOWN = 0,
+    BUTTON_PRESS_UP,
+    BUTTON_PRESS_REPEAT,
+    BUTTON_SINGLE_CLICK,
+    BUTTON_DOUBLE_CLICK,
+    BUTTON_LONG_PRESS_START,
+    BUTTON_LONG_PRESS_HOLD,
+    BUTTON_EVENT_MAX,
+    BUTTON_NONE_PRESS
+} press_event_t;
+
+typedef struct _btn_timer_t {
+	uint32_t expires;
+	uint8_t  armed;
+	void (*cb)(struct _btn_timer_t* timer, uint32_t now);
+	struct _btn_timer_t* next;
+} btn_timer_t;
+
+typedef struct {
+	uint32_t now;
+	uint32_t count;
+	btn_timer_t* slot[BTN_WHEEL_SLOTS];
+} btn_wheel_t;
+
+typedef struct _btn_fsm_t btn_fsm_t;
+
+typedef struct {
+	uint8_t  debounce_ticks;
+	uint16_t short_ticks;
+	uint16_t long_ticks;
+	uint16_t hold_ticks;
+	// read the debounced input again once the debounce timer expires
+	uint8_t (*read_level)(btn_fsm_t* fsm);
+	void (*emit)(btn_fsm_t* fsm, press_event_t event, uint32_t now);
+} btn_fsm_ops_t;
+
+struct _btn_fsm_t {
+	uint8_t  state;
+	uint8_t  repeat;
+	uint8_t  active_level : 1;
+	uint8_t  button_level : 1;
+	uint32_t press_tick;
+	btn_timer_t debounce_timer;
+	btn_timer_t state_timer;
+	btn_wheel_t* wheel;
+	const btn_fsm_ops_t* ops;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void btn_wheel_init(btn_wheel_t* wheel, uint32_t now);
+
+void btn_wheel_add(btn_wheel_t* wheel, btn_timer_t* timer, uint32_t expires);
+
+void btn_wheel_del(btn_wheel_t* wheel, btn_timer_t* timer);
+
+// Run every timer that expires at or before now.
+void btn_wheel_advance(btn_wheel_t* wheel, uint32_t now);
+
+// Ticks until the next timer fires, BTN_WHEEL_NONE when the wheel is empty.
+uint32_t btn_wheel_next(btn_wheel_t* wheel);
+
+void btn_fsm_init(btn_fsm_t* fsm, btn_wheel_t* wheel, const btn_fsm_ops_t* ops, uint8_t active_level, uint8_t level);
+
+// Feed a raw level sample (from an edge interrupt or a poll).
+void btn_fsm_input(btn_fsm_t* fsm, uint8_t level, uint32_t now);
+
+void btn_fsm_stop(btn_fsm_t* fsm);
+
+// True when nothing is pending: released, no debounce or click timeout running.
+bool btn_fsm_idle(btn_fsm_t* fsm);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,17 +1,22 @@
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "qmsd_button.h"
 
 uint8_t qmsd_button_gpio_read(uint8_t scan_start, uint8_t wait_press, void* hardware_data) {
     return gpio_get_level((uint32_t)hardware_data);
 }
 
+static void IRAM_ATTR qmsd_button_gpio_isr(void* arg) {
+    qmsd_button_notify_from_isr((btn_handle_t)arg);
+}
+
 btn_handle_t qmsd_button_create_gpio(uint8_t gpio_num, uint8_t active_level, void* user_data) {
     gpio_config_t cfg = {
         .pin_bit_mask = BIT64(gpio_num),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = 0,
         .pull_down_en = 0,
-        .intr_type = GPIO_INTR_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
     };
     if (active_level == 0) {
         cfg.pull_down_en = 0;
@@ -21,5 +26,14 @@ btn_handle_t qmsd_button_create_gpio(uint8_t gpio_num, uint8_t active_level, voi
         cfg.pull_up_en = 0;
     }
     gpio_config(&cfg);
-    return qmsd_button_create(qmsd_button_gpio_read, (void *)(uint32_t)gpio_num, active_level, user_data);
+    btn_handle_t handle = qmsd_button_create(qmsd_button_gpio_read, (void *)(uint32_t)gpio_num, active_level, user_data);
+
+    // ESP_ERR_INVALID_STATE: the service is already installed by the board
+    esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_SHARED);
+    if ((err == ESP_OK || err == ESP_ERR_INVALID_STATE) && gpio_isr_handler_add(gpio_num, qmsd_button_gpio_isr, handle) == ESP_OK) {
+        qmsd_button_set_wake_source(handle, QMSD_BUTTON_WAKE_GPIO);
+    } else {
+        gpio_set_intr_type(gpio_num, GPIO_INTR_DISABLE);
+    }
+    return handle;
 }
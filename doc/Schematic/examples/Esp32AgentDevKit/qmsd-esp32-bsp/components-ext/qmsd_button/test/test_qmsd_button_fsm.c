@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "qmsd_button_fsm.h"
+
+#define DEBOUNCE_TICKS  2
+#define SHORT_TICKS     20
+#define LONG_TICKS      100
+#define HOLD_TICKS      10
+
+typedef struct {
+	btn_fsm_t fsm;
+	uint8_t level;
+	uint8_t count;
+	press_event_t events[32];
+	uint32_t ticks[32];
+} fake_btn_t;
+
+static btn_wheel_t s_wheel;
+
+static uint8_t fake_read(btn_fsm_t* fsm)
+{
+	return ((fake_btn_t *)fsm)->level;
+}
+
+static void fake_emit(btn_fsm_t* fsm, press_event_t event, uint32_t now)
+{
+	fake_btn_t* btn = (fake_btn_t *)fsm;
+	if (btn->count < 32) {
+		btn->events[btn->count] = event;
+		btn->ticks[btn->count] = now;
+		btn->count++;
+	}
+}
+
+static const btn_fsm_ops_t s_ops = {
+	.debounce_ticks = DEBOUNCE_TICKS,
+	.short_ticks = SHORT_TICKS,
+	.long_ticks = LONG_TICKS,
+	.hold_ticks = HOLD_TICKS,
+	.read_level = fake_read,
+	.emit = fake_emit,
+};
+
+static void fake_setup(fake_btn_t* btn)
+{
+	memset(btn, 0, sizeof(fake_btn_t));
+	btn_wheel_init(&s_wheel, 1000);
+	btn->level = 1;
+	btn_fsm_init(&btn->fsm, &s_wheel, &s_ops, 0, 1);
+}
+
+// edge interrupt at tick `at`
+static void fake_edge(fake_btn_t* btn, uint8_t level, uint32_t at)
+{
+	btn_wheel_advance(&s_wheel, at);
+	btn->level = level;
+	btn_fsm_input(&btn->fsm, level, at);
+}
+
+TEST_CASE("button wheel fires in expiry order and reports next", "[qmsd_button]")
+{
+	btn_wheel_t wheel;
+	btn_timer_t a = {0}, b = {0};
+	btn_wheel_init(&wheel, 0);
+	TEST_ASSERT_EQUAL_UINT32(BTN_WHEEL_NONE, btn_wheel_next(&wheel));
+
+	btn_wheel_add(&wheel, &a, 5);
+	btn_wheel_add(&wheel, &b, 5 + BTN_WHEEL_SLOTS);	// same slot, next round
+	TEST_ASSERT_EQUAL_UINT32(5, btn_wheel_next(&wheel));
+
+	btn_wheel_del(&wheel, &a);
+	TEST_ASSERT_EQUAL_UINT32(5 + BTN_WHEEL_SLOTS, btn_wheel_next(&wheel));
+	btn_wheel_del(&wheel, &b);
+	TEST_ASSERT_EQUAL_UINT32(0, wheel.count);
+}
+
+TEST_CASE("button wheel finds the earliest timer past a round", "[qmsd_button]")
+{
+	btn_wheel_t wheel;
+	btn_timer_t a = {0}, b = {0}, c = {0};
+	btn_wheel_init(&wheel, BTN_WHEEL_SLOTS - 3);
+
+	// c is due this round, a sits in its slot a round later, b in the slot walked last
+	btn_wheel_add(&wheel, &a, 2 * BTN_WHEEL_SLOTS + 1);
+	btn_wheel_add(&wheel, &b, 3 * BTN_WHEEL_SLOTS - 4);
+	btn_wheel_add(&wheel, &c, BTN_WHEEL_SLOTS + 1);
+	TEST_ASSERT_EQUAL_UINT32(4, btn_wheel_next(&wheel));
+	btn_wheel_del(&wheel, &c);
+	TEST_ASSERT_EQUAL_UINT32(BTN_WHEEL_SLOTS + 4, btn_wheel_next(&wheel));
+	btn_wheel_del(&wheel, &a);
+	TEST_ASSERT_EQUAL_UINT32(2 * BTN_WHEEL_SLOTS - 1, btn_wheel_next(&wheel));
+}
+
+TEST_CASE("button idle wheel is empty", "[qmsd_button]")
+{
+	fake_btn_t btn;
+	fake_setup(&btn);
+	btn_wheel_advance(&s_wheel, 100000);
+	TEST_ASSERT_EQUAL_UINT32(BTN_WHEEL_NONE, btn_wheel_next(&s_wheel));
+	TEST_ASSERT_TRUE(btn_fsm_idle(&btn.fsm));
+	TEST_ASSERT_EQUAL(0, btn.count);
+}
+
+TEST_CASE("button bounce shorter than debounce is ignored", "[qmsd_button]")
+{
+	fake_btn_t btn;
+	fake_setup(&btn);
+	fake_edge(&btn, 0, 1001);
+	fake_edge(&btn, 1, 1002);
+	btn_wheel_advance(&s_wheel, 1100);
+	TEST_ASSERT_EQUAL(0, btn.count);
+	TEST_ASSERT_EQUAL_UINT32(BTN_WHEEL_NONE, btn_wheel_next(&s_wheel));
+}
+
+TEST_CASE("button single click", "[qmsd_button]")
+{
+	fake_btn_t btn;
+	fake_setup(&btn);
+	fake_edge(&btn, 0, 1001);
+	TEST_ASSERT_EQUAL_UINT32(DEBOUNCE_TICKS, btn_wheel_next(&s_wheel));
+	fake_edge(&btn, 1, 1010);
+	btn_wheel_advance(&s_wheel, 2000);
+
+	TEST_ASSERT_EQUAL(3, btn.count);
+	TEST_ASSERT_EQUAL(BUTTON_PRESS_DOWN, btn.events[0]);
+	TEST_ASSERT_EQUAL_UINT32(1001 + DEBOUNCE_TICKS, btn.ticks[0]);
+	TEST_ASSERT_EQUAL(BUTTON_PRESS_UP, btn.events[1]);
+	TEST_ASSERT_EQUAL_UINT32(1010 + DEBOUNCE_TICKS, btn.ticks[1]);
+	TEST_ASSERT_EQUAL(BUTTON_SINGLE_CLICK, btn.events[2]);
+	TEST_ASSERT_EQUAL_UINT32(1010 + DEBOUNCE_TICKS + SHORT_TICKS + 1, btn.ticks[2]);
+	TEST_ASSERT_TRUE(btn_fsm_idle(&btn.fsm));
+	TEST_ASSERT_EQUAL_UINT32(BTN_WHEEL_NONE, btn_wheel_next(&s_wheel));
+}
+
+TEST_CASE("button double click", "[qmsd_button]")
+{
+	fake_btn_t btn;
+	fake_setup(&btn);
+	fake_edge(&btn, 0, 1001);
+	fake_edge(&btn, 1, 1008);
+	fake_edge(&btn, 0, 1015);
+	fake_edge(&btn, 1, 1022);
+	btn_wheel_advance(&s_wheel, 2000);
+
+	press_event_t expect[] = {
+		BUTTON_PRESS_DOWN, BUTTON_PRESS_UP, BUTTON_PRESS_DOWN, BUTTON_PRESS_REPEAT, BUTTON_PRESS_UP, BUTTON_DOUBLE_CLICK,
+	};
+	TEST_ASSERT_EQUAL(sizeof(expect) / sizeof(expect[0]), btn.count);
+	for (int i = 0; i < btn.count; i++) {
+		TEST_ASSERT_EQUAL(expect[i], btn.events[i]);
+	}
+	TEST_ASSERT_EQUAL(2, btn.fsm.repeat);
+}
+
+TEST_CASE("button long press and hold repeat", "[qmsd_button]")
+{
+	fake_btn_t btn;
+	fake_setup(&btn);
+	fake_edge(&btn, 0, 1001);
+	btn_wheel_advance(&s_wheel, 1003 + LONG_TICKS + 1 + 3 * HOLD_TICKS);
+	fake_edge(&btn, 1, 1003 + LONG_TICKS + 1 + 3 * HOLD_TICKS + 5);
+	btn_wheel_advance(&s_wheel, 5000);
+
+	TEST_ASSERT_EQUAL(BUTTON_PRESS_DOWN, btn.events[0]);
+	TEST_ASSERT_EQUAL(BUTTON_LONG_PRESS_START, btn.events[1]);
+	TEST_ASSERT_EQUAL_UINT32(1003 + LONG_TICKS + 1, btn.ticks[1]);
+	TEST_ASSERT_EQUAL(BUTTON_LONG_PRESS_HOLD, btn.events[2]);
+	TEST_ASSERT_EQUAL(BUTTON_LONG_PRESS_HOLD, btn.events[3]);
+	TEST_ASSERT_EQUAL(BUTTON_LONG_PRESS_HOLD, btn.events[4]);
+	TEST_ASSERT_EQUAL_UINT32(HOLD_TICKS, btn.ticks[3] - btn.ticks[2]);
+	TEST_ASSERT_EQUAL(BUTTON_PRESS_UP, btn.events[5]);
+	TEST_ASSERT_EQUAL(6, btn.count);
+	TEST_ASSERT_TRUE(btn_fsm_idle(&btn.fsm));
+}
+
+TEST_CASE("button polled input matches edge input", "[qmsd_button]")
+{
+	fake_btn_t btn;
+	fake_setup(&btn);
+	// a polled button reports the same level every tick, the debounce window must not restart
+	for (uint32_t t = 1001; t < 1010; t++) {
+		fake_edge(&btn, 0, t);
+	}
+	TEST_ASSERT_EQUAL(1, btn.count);
+	TEST_ASSERT_EQUAL_UINT32(1001 + DEBOUNCE_TICKS, btn.ticks[0]);
+}
+
+TEST_CASE("button stop cancels pending timers", "[qmsd_button]")
+{
+	fake_btn_t btn;
+	fake_setup(&btn);
+	fake_edge(&btn, 0, 1001);
+	btn_wheel_advance(&s_wheel, 1010);
+	btn_fsm_stop(&btn.fsm);
+	TEST_ASSERT_EQUAL_UINT32(BTN_WHEEL_NONE, btn_wheel_next(&s_wheel));
+	TEST_ASSERT_TRUE(btn_fsm_idle(&btn.fsm));
+}
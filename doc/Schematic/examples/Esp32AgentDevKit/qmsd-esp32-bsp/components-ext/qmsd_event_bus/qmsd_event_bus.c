@@ -0,0 +1,288 @@
+#include "stdlib.h"
+#include "string.h"
+#include "qmsd_event_bus.h"
+
+#define SLOT_NONE       0xffff
+
+typedef struct {
+    uint32_t topic_mask;
+    qmsd_event_cb_t cb;
+    void* user_data;
+} subscriber_t;
+
+typedef struct {
+    uint32_t published;
+    uint32_t delivered;
+    uint32_t coalesced;
+    uint32_t dropped;
+    uint32_t dispatched;
+    uint64_t latency_sum_us;
+    uint32_t latency_max_us;
+} topic_stats_t;
+
+typedef struct {
+    qmsd_event_bus_port_t port;
+    qmsd_event_t* slot;
+    uint16_t slot_num;
+    uint16_t head;
+    uint16_t tail;
+    uint16_t count;
+    uint32_t coalesce_mask;
+    // coalescing topics: slot of each undelivered event of the topic, chained by id
+    uint16_t pending[QMSD_EVENT_BUS_MAX_TOPICS];
+    uint16_t* pending_next;
+    subscriber_t subscriber[QMSD_EVENT_BUS_MAX_SUBSCRIBERS];
+    topic_stats_t stats[QMSD_EVENT_BUS_MAX_TOPICS];
+} event_bus_t;
+
+static void bus_lock(event_bus_t* bus)
+{
+    if (bus->port.lock) {
+        bus->port.lock(bus->port.arg);
+    }
+}
+
+static void bus_unlock(event_bus_t* bus)
+{
+    if (bus->port.unlock) {
+        bus->port.unlock(bus->port.arg);
+    }
+}
+
+static uint32_t bus_now_us(event_bus_t* bus)
+{
+    return bus->port.now_us ? bus->port.now_us(bus->port.arg) : 0;
+}
+
+qmsd_event_bus_handle_t qmsd_event_bus_create(uint16_t slot_num, const qmsd_event_bus_port_t* port)
+{
+    if (slot_num == 0 || slot_num >= SLOT_NONE) {
+        return NULL;
+    }
+    event_bus_t* bus = (event_bus_t*)calloc(1, sizeof(event_bus_t));
+    if (bus == NULL) {
+        return NULL;
+    }
+    bus->slot = (qmsd_event_t*)calloc(slot_num, sizeof(qmsd_event_t));
+    bus->pending_next = (uint16_t*)calloc(slot_num, sizeof(uint16_t));
+    if (bus->slot == NULL || bus->pending_next == NULL) {
+        goto create_failed;
+    }
+    bus->slot_num = slot_num;
+    for (uint8_t i = 0; i < QMSD_EVENT_BUS_MAX_TOPICS; i++) {
+        bus->pending[i] = SLOT_NONE;
+    }
+    if (port) {
+        bus->port = *port;
+    }
+    return (qmsd_event_bus_handle_t)bus;
+
+create_failed:
+    free(bus->slot);
+    free(bus->pending_next);
+    free(bus);
+    return NULL;
+}
+
+void qmsd_event_bus_delete(qmsd_event_bus_handle_t handle)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    if (bus == NULL) {
+        return ;
+    }
+    free(bus->slot);
+    free(bus->pending_next);
+    free(bus);
+}
+
+int qmsd_event_bus_subscribe(qmsd_event_bus_handle_t handle, uint32_t topic_mask, qmsd_event_cb_t cb, void* user_data)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    int id = -1;
+    bus_lock(bus);
+    for (uint8_t i = 0; i < QMSD_EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+        if (bus->subscriber[i].cb == NULL) {
+            bus->subscriber[i].topic_mask = topic_mask;
+            bus->subscriber[i].user_data = user_data;
+            bus->subscriber[i].cb = cb;
+            id = i;
+            break;
+        }
+    }
+    bus_unlock(bus);
+    return id;
+}
+
+void qmsd_event_bus_unsubscribe(qmsd_event_bus_handle_t handle, int subscriber)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    if (subscriber < 0 || subscriber >= QMSD_EVENT_BUS_MAX_SUBSCRIBERS) {
+        return ;
+    }
+    bus_lock(bus);
+    memset(&bus->subscriber[subscriber], 0, sizeof(subscriber_t));
+    bus_unlock(bus);
+}
+
+void qmsd_event_bus_set_coalesce(qmsd_event_bus_handle_t handle, uint8_t topic, bool enable)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    if (topic >= QMSD_EVENT_BUS_MAX_TOPICS) {
+        return ;
+    }
+    bus_lock(bus);
+    if (enable) {
+        bus->coalesce_mask |= QMSD_EVENT_TOPIC_BIT(topic);
+    } else {
+        // events already in the ring stay, they just stop being merged
+        bus->coalesce_mask &= ~QMSD_EVENT_TOPIC_BIT(topic);
+        bus->pending[topic] = SLOT_NONE;
+    }
+    bus_unlock(bus);
+}
+
+bool qmsd_event_bus_publish(qmsd_event_bus_handle_t handle, uint8_t topic, uint16_t id, int32_t value, void* data, uint32_t data_len)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    if (topic >= QMSD_EVENT_BUS_MAX_TOPICS) {
+        return false;
+    }
+    uint32_t now = bus_now_us(bus);
+    bool wakeup = false;
+
+    bus_lock(bus);
+    topic_stats_t* stats = &bus->stats[topic];
+    stats->published++;
+    if (bus->coalesce_mask & QMSD_EVENT_TOPIC_BIT(topic)) {
+        for (uint16_t i = bus->pending[topic]; i != SLOT_NONE; i = bus->pending_next[i]) {
+            if (bus->slot[i].id == id) {
+                // keep the original timestamp, latency counts from the oldest merged publish
+                bus->slot[i].value = value;
+                bus->slot[i].data = data;
+                bus->slot[i].data_len = data_len;
+                stats->coalesced++;
+                bus_unlock(bus);
+                return true;
+            }
+        }
+    }
+    if (bus->count == bus->slot_num) {
+        stats->dropped++;
+        bus_unlock(bus);
+        return false;
+    }
+    uint16_t index = bus->head;
+    qmsd_event_t* event = &bus->slot[index];
+    event->topic = topic;
+    event->id = id;
+    event->value = value;
+    event->data = data;
+    event->data_len = data_len;
+    event->timestamp_us = now;
+    if (bus->coalesce_mask & QMSD_EVENT_TOPIC_BIT(topic)) {
+        bus->pending_next[index] = bus->pending[topic];
+        bus->pending[topic] = index;
+    }
+    bus->head = (bus->head + 1) % bus->slot_num;
+    // only the first event wakes the dispatcher, it drains the ring anyway
+    wakeup = bus->count++ == 0;
+    bus_unlock(bus);
+
+    if (wakeup && bus->port.wakeup) {
+        bus->port.wakeup(bus->port.arg);
+    }
+    return true;
+}
+
+// unlink a slot from its topic's pending chain so nothing merges into it while it is delivered
+static void pending_remove(event_bus_t* bus, uint16_t index)
+{
+    uint16_t* link = &bus->pending[bus->slot[index].topic];
+    while (*link != SLOT_NONE) {
+        if (*link == index) {
+            *link = bus->pending_next[index];
+            return ;
+        }
+        link = &bus->pending_next[*link];
+    }
+}
+
+uint32_t qmsd_event_bus_dispatch(qmsd_event_bus_handle_t handle, uint32_t max_num)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    subscriber_t subscriber[QMSD_EVENT_BUS_MAX_SUBSCRIBERS];
+    uint32_t num = 0;
+
+    while (num < max_num) {
+        bus_lock(bus);
+        if (bus->count == 0) {
+            bus_unlock(bus);
+            break;
+        }
+        uint16_t index = bus->tail;
+        const qmsd_event_t* event = &bus->slot[index];
+        if (bus->coalesce_mask & QMSD_EVENT_TOPIC_BIT(event->topic)) {
+            pending_remove(bus, index);
+        }
+        memcpy(subscriber, bus->subscriber, sizeof(subscriber));
+        bus_unlock(bus);
+
+        // the slot is not released until every subscriber returned, publishers can not reach it
+        bool delivered = false;
+        for (uint8_t i = 0; i < QMSD_EVENT_BUS_MAX_SUBSCRIBERS; i++) {
+            if (subscriber[i].cb && (subscriber[i].topic_mask & QMSD_EVENT_TOPIC_BIT(event->topic))) {
+                subscriber[i].cb(event, subscriber[i].user_data);
+                delivered = true;
+            }
+        }
+        uint32_t latency = bus_now_us(bus) - event->timestamp_us;
+
+        bus_lock(bus);
+        topic_stats_t* stats = &bus->stats[event->topic];
+        stats->dispatched++;
+        stats->delivered += delivered;
+        stats->latency_sum_us += latency;
+        if (latency > stats->latency_max_us) {
+            stats->latency_max_us = latency;
+        }
+        bus->tail = (bus->tail + 1) % bus->slot_num;
+        bus->count--;
+        bus_unlock(bus);
+        num++;
+    }
+    return num;
+}
+
+uint32_t qmsd_event_bus_pending(qmsd_event_bus_handle_t handle)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    return bus->count;
+}
+
+void qmsd_event_bus_get_stats(qmsd_event_bus_handle_t handle, uint8_t topic, qmsd_event_bus_stats_t* stats)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    memset(stats, 0, sizeof(qmsd_event_bus_stats_t));
+    if (topic >= QMSD_EVENT_BUS_MAX_TOPICS) {
+        return ;
+    }
+    bus_lock(bus);
+    topic_stats_t* topic_stats = &bus->stats[topic];
+    stats->published = topic_stats->published;
+    stats->delivered = topic_stats->delivered;
+    stats->coalesced = topic_stats->coalesced;
+    stats->dropped = topic_stats->dropped;
+    stats->latency_max_us = topic_stats->latency_max_us;
+    if (topic_stats->dispatched) {
+        stats->latency_avg_us = topic_stats->latency_sum_us / topic_stats->dispatched;
+    }
+    bus_unlock(bus);
+}
+
+void qmsd_event_bus_reset_stats(qmsd_event_bus_handle_t handle)
+{
+    event_bus_t* bus = (event_bus_t*)handle;
+    bus_lock(bus);
+    memset(bus->stats, 0, sizeof(bus->stats));
+    bus_unlock(bus);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Publish / subscribe bus for peripheral events.
+//
+// Events live in a ring of slots allocated once at create, publish never
+// allocates and never blocks, so it is safe from an isr. The dispatcher hands
+// every subscriber whose topic mask matches a pointer to the slot itself,
+// nothing is copied; `data` is passed by reference and has to stay valid
+// until the event is dispatched.
+//
+// A coalescing topic keeps at most one pending event per id: a new publish
+// overwrites the undelivered one. Only for streams where the newest value is
+// all that counts, like sensor readings: discrete events such as presses or
+// touches of the same id would be merged into one.
+//
+// qmsd_event_bus.c is portable, qmsd_event_bus_task.c runs it on FreeRTOS.
+
+#define QMSD_EVENT_BUS_MAX_TOPICS       32
+#define QMSD_EVENT_BUS_MAX_SUBSCRIBERS  8
+
+#define QMSD_EVENT_TOPIC_BIT(topic)     (1UL << (topic))
+#define QMSD_EVENT_TOPIC_ALL            0xffffffffUL
+
+typedef enum {
+    QMSD_EVENT_TOPIC_PERIPH = 0,        // bridged esp_periph events, value is the periph id
+    QMSD_EVENT_TOPIC_BUTTON,
+    QMSD_EVENT_TOPIC_TOUCH,
+    QMSD_EVENT_TOPIC_WIFI,
+    QMSD_EVENT_TOPIC_LED,
+    QMSD_EVENT_TOPIC_ADC,
+    QMSD_EVENT_TOPIC_SENSOR,
+    QMSD_EVENT_TOPIC_CALL,              // id is qmsd_event_call_t, value the session id
+    QMSD_EVENT_TOPIC_USER = 16,         // 16 ~ 31 are free for the application
+} qmsd_event_topic_t;
+
+typedef enum {
+    QMSD_EVENT_CALL_JOINED = 0,
+    QMSD_EVENT_CALL_LEFT,
+} qmsd_event_call_t;
+
+typedef void *qmsd_event_bus_handle_t;
+
+typedef struct {
+    uint8_t topic;
+    uint16_t id;
+    int32_t value;
+    void* data;
+    uint32_t data_len;
+    uint32_t timestamp_us;
+} qmsd_event_t;
+
+// Runs in the dispatcher, the event is only valid during the call.
+typedef void (*qmsd_event_cb_t)(const qmsd_event_t* event, void* user_data);
+
+typedef struct {
+    uint32_t published;
+    uint32_t delivered;         // events that reached at least one subscriber
+    uint32_t coalesced;
+    uint32_t dropped;           // ring full
+    uint32_t latency_avg_us;    // publish -> dispatch
+    uint32_t latency_max_us;
+} qmsd_event_bus_stats_t;
+
+typedef struct {
+    // must work from an isr too when events are published from isrs
+    void (*lock)(void* arg);
+    void (*unlock)(void* arg);
+    void (*wakeup)(void* arg);
+    uint32_t (*now_us)(void* arg);
+    void* arg;
+} qmsd_event_bus_port_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+qmsd_event_bus_handle_t qmsd_event_bus_create(uint16_t slot_num, const qmsd_event_bus_port_t* port);
+
+void qmsd_event_bus_delete(qmsd_event_bus_handle_t bus);
+
+// Returns the subscriber id, -1 when full
+int qmsd_event_bus_subscribe(qmsd_event_bus_handle_t bus, uint32_t topic_mask, qmsd_event_cb_t cb, void* user_data);
+
+void qmsd_event_bus_unsubscribe(qmsd_event_bus_handle_t bus, int subscriber);
+
+void qmsd_event_bus_set_coalesce(qmsd_event_bus_handle_t bus, uint8_t topic, bool enable);
+
+// Task or isr. false when the ring is full and the event was dropped.
+bool qmsd_event_bus_publish(qmsd_event_bus_handle_t bus, uint8_t topic, uint16_t id, int32_t value, void* data, uint32_t data_len);
+
+// Deliver up to max_num events, returns how many were taken from the ring. One dispatcher at a time.
+uint32_t qmsd_event_bus_dispatch(qmsd_event_bus_handle_t bus, uint32_t max_num);
+
+uint32_t qmsd_event_bus_pending(qmsd_event_bus_handle_t bus);
+
+void qmsd_event_bus_get_stats(qmsd_event_bus_handle_t bus, uint8_t topic, qmsd_event_bus_stats_t* stats);
+
+void qmsd_event_bus_reset_stats(qmsd_event_bus_handle_t bus);
+
+#ifdef __cplusplus
+}
+#endif
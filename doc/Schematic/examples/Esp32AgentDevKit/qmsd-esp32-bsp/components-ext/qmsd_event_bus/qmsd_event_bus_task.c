@@ -0,0 +1,95 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "qmsd_event_bus.h"
+#include "qmsd_event_bus_task.h"
+#include "qmsd_sched.h"
+
+#define TAG "EVENT_BUS"
+
+typedef struct {
+    qmsd_event_bus_handle_t bus;
+    // publish runs in isrs too, a spinlock is the only lock both sides can take
+    portMUX_TYPE spinlock;
+    TaskHandle_t task;
+} event_bus_port_t;
+
+static qmsd_event_bus_handle_t g_default_bus = NULL;
+
+static void IRAM_ATTR port_lock(void* arg) {
+    portENTER_CRITICAL_SAFE(&((event_bus_port_t *)arg)->spinlock);
+}
+
+static void IRAM_ATTR port_unlock(void* arg) {
+    portEXIT_CRITICAL_SAFE(&((event_bus_port_t *)arg)->spinlock);
+}
+
+static void IRAM_ATTR port_wakeup(void* arg) {
+    event_bus_port_t* port = (event_bus_port_t *)arg;
+    if (port->task == NULL) {
+        return ;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t need_yield = pdFALSE;
+        vTaskNotifyGiveFromISR(port->task, &need_yield);
+        portYIELD_FROM_ISR(need_yield);
+    } else {
+        xTaskNotifyGive(port->task);
+    }
+}
+
+static uint32_t IRAM_ATTR port_now_us(void* arg) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+static void qmsd_event_bus_task(void *arg) {
+    event_bus_port_t* port = (event_bus_port_t *)arg;
+    for (;;) {
+        qmsd_event_bus_dispatch(port->bus, UINT32_MAX);
+        // only the publish that finds the ring empty notifies, the rest are drained above
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+qmsd_event_bus_handle_t qmsd_event_bus_start(uint16_t slot_num, uint8_t priority, int8_t core) {
+    event_bus_port_t* port = (event_bus_port_t *)calloc(1, sizeof(event_bus_port_t));
+    if (port == NULL) {
+        return NULL;
+    }
+    portMUX_INITIALIZE(&port->spinlock);
+    qmsd_event_bus_port_t bus_port = {
+        .lock = port_lock,
+        .unlock = port_unlock,
+        .wakeup = port_wakeup,
+        .now_us = port_now_us,
+        .arg = port,
+    };
+    port->bus = qmsd_event_bus_create(slot_num, &bus_port);
+    if (port->bus == NULL) {
+        ESP_LOGE(TAG, "Memory allocation failed");
+        goto event_bus_start_error;
+    }
+    UBaseType_t prio = priority;
+    BaseType_t task_core = core;
+    uint32_t stack_size = 3 * 1024;
+    qmsd_sched_place("event_bus", &prio, &task_core, &stack_size);
+    if (xTaskCreatePinnedToCore(qmsd_event_bus_task, "event_bus", stack_size, port, prio, &port->task, task_core) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating task");
+        goto event_bus_start_error;
+    }
+    if (g_default_bus == NULL) {
+        g_default_bus = port->bus;
+    }
+    return port->bus;
+
+event_bus_start_error:
+    qmsd_event_bus_delete(port->bus);
+    free(port);
+    return NULL;
+}
+
+qmsd_event_bus_handle_t qmsd_event_bus_default(void) {
+    return g_default_bus;
+}
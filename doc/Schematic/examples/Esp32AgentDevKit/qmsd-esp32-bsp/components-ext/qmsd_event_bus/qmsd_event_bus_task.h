@@ -0,0 +1,19 @@
+#pragma once
+
+#include "stdint.h"
+#include "qmsd_event_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create a bus with slot_num preallocated slots and the task that dispatches it.
+// Subscriber callbacks run in that task.
+qmsd_event_bus_handle_t qmsd_event_bus_start(uint16_t slot_num, uint8_t priority, int8_t core);
+
+// The first bus started, NULL before that
+qmsd_event_bus_handle_t qmsd_event_bus_default(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "qmsd_event_bus.h"
+
+static uint32_t s_now_us;
+static uint32_t s_wakeups;
+static int s_lock_depth;
+
+static void test_lock(void* arg) {
+    TEST_ASSERT_EQUAL(0, s_lock_depth);
+    s_lock_depth++;
+}
+
+static void test_unlock(void* arg) {
+    s_lock_depth--;
+}
+
+static void test_wakeup(void* arg) {
+    s_wakeups++;
+}
+
+static uint32_t test_now_us(void* arg) {
+    return s_now_us;
+}
+
+static const qmsd_event_bus_port_t s_port = {
+    .lock = test_lock,
+    .unlock = test_unlock,
+    .wakeup = test_wakeup,
+    .now_us = test_now_us,
+};
+
+typedef struct {
+    uint32_t num;
+    qmsd_event_t last;
+    const qmsd_event_t* last_ptr;
+} recorder_t;
+
+static void record_cb(const qmsd_event_t* event, void* user_data) {
+    recorder_t* rec = (recorder_t *)user_data;
+    // callbacks run without the bus lock held
+    TEST_ASSERT_EQUAL(0, s_lock_depth);
+    rec->num++;
+    rec->last = *event;
+    rec->last_ptr = event;
+}
+
+static qmsd_event_bus_handle_t setup(uint16_t slot_num) {
+    s_now_us = 1000;
+    s_wakeups = 0;
+    s_lock_depth = 0;
+    return qmsd_event_bus_create(slot_num, &s_port);
+}
+
+TEST_CASE("event bus fans out by topic mask", "[event_bus]")
+{
+    qmsd_event_bus_handle_t bus = setup(8);
+    recorder_t button = {0}, touch = {0}, all = {0};
+    TEST_ASSERT_EQUAL(0, qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_BIT(QMSD_EVENT_TOPIC_BUTTON), record_cb, &button));
+    TEST_ASSERT_EQUAL(1, qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_BIT(QMSD_EVENT_TOPIC_TOUCH), record_cb, &touch));
+    TEST_ASSERT_EQUAL(2, qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_ALL, record_cb, &all));
+
+    static uint8_t payload[64];
+    TEST_ASSERT_TRUE(qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_BUTTON, 3, 1, NULL, 0));
+    TEST_ASSERT_TRUE(qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_WIFI, 7, 0, payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL(2, qmsd_event_bus_pending(bus));
+    TEST_ASSERT_EQUAL(2, qmsd_event_bus_dispatch(bus, UINT32_MAX));
+
+    TEST_ASSERT_EQUAL(1, button.num);
+    TEST_ASSERT_EQUAL(3, button.last.id);
+    TEST_ASSERT_EQUAL(0, touch.num);
+    TEST_ASSERT_EQUAL(2, all.num);
+    TEST_ASSERT_EQUAL(QMSD_EVENT_TOPIC_WIFI, all.last.topic);
+    // zero copy: the payload pointer itself is handed over
+    TEST_ASSERT_EQUAL_PTR(payload, all.last.data);
+    TEST_ASSERT_EQUAL(sizeof(payload), all.last.data_len);
+
+    qmsd_event_bus_unsubscribe(bus, 2);
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_WIFI, 7, 0, NULL, 0);
+    qmsd_event_bus_dispatch(bus, UINT32_MAX);
+    TEST_ASSERT_EQUAL(2, all.num);
+    qmsd_event_bus_delete(bus);
+}
+
+TEST_CASE("event bus subscribers share one slot", "[event_bus]")
+{
+    qmsd_event_bus_handle_t bus = setup(4);
+    recorder_t a = {0}, b = {0};
+    qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_ALL, record_cb, &a);
+    qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_ALL, record_cb, &b);
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_LED, 1, 2, NULL, 0);
+    qmsd_event_bus_dispatch(bus, 1);
+    TEST_ASSERT_EQUAL_PTR(a.last_ptr, b.last_ptr);
+    qmsd_event_bus_delete(bus);
+}
+
+TEST_CASE("event bus keeps order and drops when full", "[event_bus]")
+{
+    qmsd_event_bus_handle_t bus = setup(4);
+    recorder_t rec = {0};
+    qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_ALL, record_cb, &rec);
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 4; i++) {
+            TEST_ASSERT_TRUE(qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_BUTTON, i, round, NULL, 0));
+        }
+        TEST_ASSERT_FALSE(qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_BUTTON, 9, round, NULL, 0));
+        for (int i = 0; i < 4; i++) {
+            TEST_ASSERT_EQUAL(1, qmsd_event_bus_dispatch(bus, 1));
+            TEST_ASSERT_EQUAL(i, rec.last.id);
+            TEST_ASSERT_EQUAL(round, rec.last.value);
+        }
+        TEST_ASSERT_EQUAL(0, qmsd_event_bus_dispatch(bus, 1));
+    }
+
+    // only the publish into an empty ring wakes the dispatcher
+    TEST_ASSERT_EQUAL(3, s_wakeups);
+    qmsd_event_bus_stats_t stats;
+    qmsd_event_bus_get_stats(bus, QMSD_EVENT_TOPIC_BUTTON, &stats);
+    TEST_ASSERT_EQUAL(15, stats.published);
+    TEST_ASSERT_EQUAL(12, stats.delivered);
+    TEST_ASSERT_EQUAL(3, stats.dropped);
+    qmsd_event_bus_delete(bus);
+}
+
+TEST_CASE("event bus coalesces high rate topics per id", "[event_bus]")
+{
+    qmsd_event_bus_handle_t bus = setup(8);
+    recorder_t rec = {0};
+    qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_ALL, record_cb, &rec);
+    qmsd_event_bus_set_coalesce(bus, QMSD_EVENT_TOPIC_SENSOR, true);
+
+    // 100 readings of two sensors and a button press in between, before the dispatcher runs
+    for (int i = 0; i < 100; i++) {
+        s_now_us += 100;
+        qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_SENSOR, i & 1, i, NULL, 0);
+        if (i == 50) {
+            qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_BUTTON, 0, 1, NULL, 0);
+        }
+    }
+    TEST_ASSERT_EQUAL(3, qmsd_event_bus_pending(bus));
+
+    TEST_ASSERT_EQUAL(3, qmsd_event_bus_dispatch(bus, UINT32_MAX));
+    TEST_ASSERT_EQUAL(3, rec.num);
+    qmsd_event_bus_stats_t stats;
+    qmsd_event_bus_get_stats(bus, QMSD_EVENT_TOPIC_SENSOR, &stats);
+    TEST_ASSERT_EQUAL(100, stats.published);
+    TEST_ASSERT_EQUAL(98, stats.coalesced);
+    TEST_ASSERT_EQUAL(2, stats.delivered);
+
+    // a delivered event is not merged into any more
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_SENSOR, 0, 200, NULL, 0);
+    qmsd_event_bus_dispatch(bus, UINT32_MAX);
+    TEST_ASSERT_EQUAL(200, rec.last.value);
+
+    // off again: every publish gets its own slot
+    qmsd_event_bus_set_coalesce(bus, QMSD_EVENT_TOPIC_SENSOR, false);
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_SENSOR, 0, 1, NULL, 0);
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_SENSOR, 0, 2, NULL, 0);
+    TEST_ASSERT_EQUAL(2, qmsd_event_bus_pending(bus));
+    qmsd_event_bus_delete(bus);
+}
+
+static qmsd_event_bus_handle_t s_reentrant_bus;
+
+static void publish_cb(const qmsd_event_t* event, void* user_data) {
+    recorder_t* rec = (recorder_t *)user_data;
+    rec->num++;
+    // a subscriber publishing the next event, the slot it reads stays intact
+    if (event->value < 3) {
+        qmsd_event_bus_publish(s_reentrant_bus, event->topic, event->id, event->value + 1, NULL, 0);
+    }
+    TEST_ASSERT_EQUAL(rec->num - 1, event->value);
+}
+
+TEST_CASE("event bus subscribers may publish while dispatched", "[event_bus]")
+{
+    qmsd_event_bus_handle_t bus = setup(2);
+    s_reentrant_bus = bus;
+    recorder_t rec = {0};
+    qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_ALL, publish_cb, &rec);
+    qmsd_event_bus_set_coalesce(bus, QMSD_EVENT_TOPIC_ADC, true);
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_ADC, 0, 0, NULL, 0);
+    TEST_ASSERT_EQUAL(4, qmsd_event_bus_dispatch(bus, UINT32_MAX));
+    TEST_ASSERT_EQUAL(4, rec.num);
+    qmsd_event_bus_delete(bus);
+}
+
+TEST_CASE("event bus latency counters", "[event_bus]")
+{
+    qmsd_event_bus_handle_t bus = setup(8);
+    recorder_t rec = {0};
+    qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_ALL, record_cb, &rec);
+
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_SENSOR, 0, 0, NULL, 0);
+    s_now_us += 300;
+    qmsd_event_bus_publish(bus, QMSD_EVENT_TOPIC_SENSOR, 0, 0, NULL, 0);
+    s_now_us += 100;
+    qmsd_event_bus_dispatch(bus, UINT32_MAX);
+
+    qmsd_event_bus_stats_t stats;
+    qmsd_event_bus_get_stats(bus, QMSD_EVENT_TOPIC_SENSOR, &stats);
+    TEST_ASSERT_EQUAL(400, stats.latency_max_us);
+    TEST_ASSERT_EQUAL(250, stats.latency_avg_us);
+    TEST_ASSERT_EQUAL(1300, rec.last.timestamp_us);
+
+    qmsd_event_bus_reset_stats(bus);
+    qmsd_event_bus_get_stats(bus, QMSD_EVENT_TOPIC_SENSOR, &stats);
+    TEST_ASSERT_EQUAL(0, stats.published);
+    TEST_ASSERT_EQUAL(0, stats.latency_max_us);
+    qmsd_event_bus_delete(bus);
+}
@@ -0,0 +1,297 @@
+#include "stdlib.h"
+#include "string.h"
+#include "qmsd_mem.h"
+
+#define MEM_MAGIC           0xa5
+#define MEM_FREED           0x5a
+#define MEM_SITE_PROBES     8
+#define MEM_REGION_NONE     QMSD_MEM_REGION_MAX
+
+typedef struct {
+    uint32_t size;
+    uint16_t site;
+    uint8_t tag_region;                 // tag << 2 | region
+    uint8_t magic;
+} mem_header_t;
+
+_Static_assert(sizeof(mem_header_t) == QMSD_MEM_HEADER_SIZE, "header size");
+_Static_assert(QMSD_MEM_TAG_MAX <= 64 && QMSD_MEM_REGION_MAX <= 4, "tag_region packing");
+_Static_assert((QMSD_MEM_SITES & (QMSD_MEM_SITES - 1)) == 0, "sites must be a power of two");
+
+typedef struct {
+    const void* pc;
+    uint8_t tag;
+    uint32_t live_bytes;
+    uint32_t live_blocks;
+    uint32_t allocs;
+} mem_site_t;
+
+extern const qmsd_mem_backend_t qmsd_mem_default_backend;
+
+static const qmsd_mem_backend_t* g_backend = &qmsd_mem_default_backend;
+static qmsd_mem_tag_stats_t g_tag_stats[QMSD_MEM_TAG_MAX];
+static mem_site_t g_sites[QMSD_MEM_SITES];
+static uint32_t g_bad_frees = 0;
+
+static qmsd_mem_policy_t g_policy[QMSD_MEM_TAG_MAX] = {
+    [QMSD_MEM_TAG_OTHER]  = {QMSD_MEM_REGION_INTERNAL, QMSD_MEM_REGION_PSRAM, 0},
+    // packets and pipeline state, psram bandwidth is plenty for them
+    [QMSD_MEM_TAG_AUDIO]  = {QMSD_MEM_REGION_PSRAM, QMSD_MEM_REGION_INTERNAL, 128},
+    [QMSD_MEM_TAG_GUI]    = {QMSD_MEM_REGION_PSRAM, QMSD_MEM_REGION_INTERNAL, 512},
+    [QMSD_MEM_TAG_RTC]    = {QMSD_MEM_REGION_PSRAM, QMSD_MEM_REGION_INTERNAL, 128},
+    // lwip and tls buffers are touched per packet
+    [QMSD_MEM_TAG_NET]    = {QMSD_MEM_REGION_INTERNAL, QMSD_MEM_REGION_PSRAM, 0},
+    // isr and flash-off paths, psram is no use to them
+    [QMSD_MEM_TAG_DRIVER] = {QMSD_MEM_REGION_INTERNAL, MEM_REGION_NONE, 0},
+};
+
+static const char* const g_tag_names[QMSD_MEM_TAG_MAX] = {
+    "other", "audio", "gui", "rtc", "net", "driver",
+};
+
+void qmsd_mem_set_backend(const qmsd_mem_backend_t* backend) {
+    g_backend = backend ? backend : &qmsd_mem_default_backend;
+}
+
+void qmsd_mem_set_policy(qmsd_mem_tag_t tag, const qmsd_mem_policy_t* policy) {
+    if (tag < QMSD_MEM_TAG_MAX) {
+        g_policy[tag] = *policy;
+    }
+}
+
+const char* qmsd_mem_tag_name(qmsd_mem_tag_t tag) {
+    return tag < QMSD_MEM_TAG_MAX ? g_tag_names[tag] : "?";
+}
+
+static uint16_t mem_site_index(const void* pc, uint8_t tag) {
+    uint32_t hash = (uint32_t)(((uintptr_t)pc >> 2) * 2654435761u);
+    for (uint32_t i = 0; i < MEM_SITE_PROBES; i++) {
+        uint32_t index = (hash + i) & (QMSD_MEM_SITES - 1);
+        mem_site_t* site = &g_sites[index];
+        const void* cur = __atomic_load_n(&site->pc, __ATOMIC_ACQUIRE);
+        if (cur == NULL) {
+            if (__atomic_compare_exchange_n(&site->pc, &cur, pc, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                site->tag = tag;
+                return index;
+            }
+        }
+        if (cur == pc) {
+            return index;
+        }
+    }
+    return QMSD_MEM_SITE_NONE;
+}
+
+static void mem_account(mem_header_t* header, int sign) {
+    uint8_t tag = header->tag_region >> 2;
+    uint8_t region = header->tag_region & 0x03;
+    uint32_t size = header->size;
+    qmsd_mem_tag_stats_t* stats = &g_tag_stats[tag];
+    if (sign > 0) {
+        uint32_t live = __atomic_add_fetch(&stats->live_bytes, size, __ATOMIC_RELAXED);
+        uint32_t peak = __atomic_load_n(&stats->peak_bytes, __ATOMIC_RELAXED);
+        while (live > peak && !__atomic_compare_exchange_n(&stats->peak_bytes, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+        __atomic_add_fetch(&stats->live_blocks, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->allocs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&stats->region_bytes[region], size, __ATOMIC_RELAXED);
+    } else {
+        __atomic_sub_fetch(&stats->live_bytes, size, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&stats->live_blocks, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&stats->region_bytes[region], size, __ATOMIC_RELAXED);
+    }
+    if (header->site == QMSD_MEM_SITE_NONE) {
+        return ;
+    }
+    mem_site_t* site = &g_sites[header->site];
+    if (sign > 0) {
+        __atomic_add_fetch(&site->live_bytes, size, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&site->live_blocks, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&site->allocs, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_sub_fetch(&site->live_bytes, size, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&site->live_blocks, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void* mem_alloc_region(uint8_t tag, uint32_t size, uint8_t region, const void* pc) {
+    mem_header_t* header = (mem_header_t *)g_backend->alloc(size + QMSD_MEM_HEADER_SIZE, (qmsd_mem_region_t)region);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->size = size;
+    header->site = mem_site_index(pc, tag);
+    header->tag_region = (tag << 2) | region;
+    header->magic = MEM_MAGIC;
+    mem_account(header, 1);
+    return header + 1;
+}
+
+void* qmsd_mem_malloc_at(qmsd_mem_tag_t tag, uint32_t size, uint32_t flags, const void* site) {
+    if (tag >= QMSD_MEM_TAG_MAX) {
+        tag = QMSD_MEM_TAG_OTHER;
+    }
+    if (size > UINT32_MAX - QMSD_MEM_HEADER_SIZE) {
+        __atomic_add_fetch(&g_tag_stats[tag].failures, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    // a forced region is exactly that heap, like heap_caps_malloc
+    uint8_t region, fallback = MEM_REGION_NONE;
+    if (flags & QMSD_MEM_DMA) {
+        region = QMSD_MEM_REGION_DMA;
+    } else if (flags & QMSD_MEM_INTERNAL) {
+        region = QMSD_MEM_REGION_INTERNAL;
+    } else if (flags & QMSD_MEM_PSRAM) {
+        region = QMSD_MEM_REGION_PSRAM;
+    } else {
+        const qmsd_mem_policy_t* policy = &g_policy[tag];
+        region = policy->region;
+        fallback = policy->fallback;
+        if (region == QMSD_MEM_REGION_PSRAM && size < policy->internal_below) {
+            region = QMSD_MEM_REGION_INTERNAL;
+            fallback = QMSD_MEM_REGION_PSRAM;
+        }
+        if (flags & QMSD_MEM_NO_FALLBACK) {
+            fallback = MEM_REGION_NONE;
+        }
+    }
+
+    void* ptr = mem_alloc_region(tag, size, region, site);
+    if (ptr == NULL && fallback != MEM_REGION_NONE) {
+        ptr = mem_alloc_region(tag, size, fallback, site);
+        if (ptr) {
+            __atomic_add_fetch(&g_tag_stats[tag].fallbacks, 1, __ATOMIC_RELAXED);
+        }
+    }
+    if (ptr == NULL) {
+        __atomic_add_fetch(&g_tag_stats[tag].failures, 1, __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+void* qmsd_mem_malloc(qmsd_mem_tag_t tag, uint32_t size, uint32_t flags) {
+    return qmsd_mem_malloc_at(tag, size, flags, __builtin_return_address(0));
+}
+
+void* qmsd_mem_calloc(qmsd_mem_tag_t tag, uint32_t n, uint32_t size, uint32_t flags) {
+    if (size && n > UINT32_MAX / size) {
+        return NULL;
+    }
+    void* ptr = qmsd_mem_malloc_at(tag, n * size, flags, __builtin_return_address(0));
+    if (ptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+static mem_header_t* mem_header(const void* ptr) {
+    mem_header_t* header = (mem_header_t *)ptr - 1;
+    if (header->magic != MEM_MAGIC) {
+        __atomic_add_fetch(&g_bad_frees, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    return header;
+}
+
+void qmsd_mem_free(void* ptr) {
+    if (ptr == NULL) {
+        return ;
+    }
+    mem_header_t* header = mem_header(ptr);
+    if (header == NULL) {
+        // not ours or freed twice, freeing it would corrupt the heap
+        return ;
+    }
+    mem_account(header, -1);
+    header->magic = MEM_FREED;
+    g_backend->free(header);
+}
+
+void* qmsd_mem_realloc(void* ptr, uint32_t size) {
+    if (ptr == NULL) {
+        return NULL;
+    }
+    if (size == 0) {
+        qmsd_mem_free(ptr);
+        return NULL;
+    }
+    mem_header_t* header = mem_header(ptr);
+    if (header == NULL) {
+        return NULL;
+    }
+    uint8_t tag = header->tag_region >> 2;
+    uint8_t region = header->tag_region & 0x03;
+    const uint32_t region_flags[QMSD_MEM_REGION_MAX] = {QMSD_MEM_INTERNAL, QMSD_MEM_PSRAM, QMSD_MEM_DMA};
+    void* new_ptr = qmsd_mem_malloc_at((qmsd_mem_tag_t)tag, size, region_flags[region], __builtin_return_address(0));
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, header->size < size ? header->size : size);
+    qmsd_mem_free(ptr);
+    return new_ptr;
+}
+
+uint32_t qmsd_mem_size(const void* ptr) {
+    const mem_header_t* header = (const mem_header_t *)ptr - 1;
+    return header->magic == MEM_MAGIC ? header->size : 0;
+}
+
+void qmsd_mem_get_tag_stats(qmsd_mem_tag_t tag, qmsd_mem_tag_stats_t* stats) {
+    const qmsd_mem_tag_stats_t* src = &g_tag_stats[tag < QMSD_MEM_TAG_MAX ? tag : QMSD_MEM_TAG_OTHER];
+    const uint32_t* from = (const uint32_t *)src;
+    uint32_t* to = (uint32_t *)stats;
+    for (uint32_t i = 0; i < sizeof(qmsd_mem_tag_stats_t) / sizeof(uint32_t); i++) {
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+}
+
+uint32_t qmsd_mem_bad_frees(void) {
+    return __atomic_load_n(&g_bad_frees, __ATOMIC_RELAXED);
+}
+
+uint32_t qmsd_mem_get_sites(qmsd_mem_site_t* sites, uint32_t max) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < QMSD_MEM_SITES; i++) {
+        const mem_site_t* site = &g_sites[i];
+        const void* pc = __atomic_load_n(&site->pc, __ATOMIC_ACQUIRE);
+        uint32_t live_bytes = __atomic_load_n(&site->live_bytes, __ATOMIC_RELAXED);
+        if (pc == NULL || live_bytes == 0) {
+            continue;
+        }
+        // insertion into the sorted prefix, max is a screenful
+        uint32_t pos = count < max ? count++ : max;
+        while (pos > 0 && sites[pos - 1].live_bytes < live_bytes) {
+            if (pos < max) {
+                sites[pos] = sites[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < max) {
+            sites[pos].pc = pc;
+            sites[pos].tag = site->tag;
+            sites[pos].live_bytes = live_bytes;
+            sites[pos].live_blocks = __atomic_load_n(&site->live_blocks, __ATOMIC_RELAXED);
+            sites[pos].allocs = __atomic_load_n(&site->allocs, __ATOMIC_RELAXED);
+        }
+    }
+    return count;
+}
+
+uint8_t qmsd_mem_fragmentation(uint32_t free_bytes, uint32_t largest_block) {
+    if (free_bytes == 0 || largest_block >= free_bytes) {
+        return 0;
+    }
+    return 100 - (uint8_t)((uint64_t)largest_block * 100 / free_bytes);
+}
+
+#ifndef ESP_PLATFORM
+// host builds: one libc heap stands in for every region
+static void* libc_alloc(uint32_t size, qmsd_mem_region_t region) {
+    return malloc(size);
+}
+
+const qmsd_mem_backend_t qmsd_mem_default_backend = {
+    .alloc = libc_alloc,
+    .free = free,
+};
+#endif
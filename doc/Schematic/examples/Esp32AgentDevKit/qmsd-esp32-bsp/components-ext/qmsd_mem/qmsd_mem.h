@@ -0,0 +1,117 @@
+#pragma once
+
+#include "stdint.h"
+#include "stddef.h"
+#include "stdbool.h"
+
+// Tagged allocator. Every subsystem allocates under its tag, the tag's policy
+// picks the heap (internal, psram, dma) unless the call forces one:
+//
+//     buf = qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, size, 0);                 // policy
+//     dma = qmsd_mem_malloc(QMSD_MEM_TAG_DRIVER, size, QMSD_MEM_DMA);     // forced
+//     qmsd_mem_free(buf);
+//
+// Each block carries an 8 byte header (size, tag, call site), so a free finds
+// its tag without a lookup. Accounting is a few relaxed atomics per call: live
+// and peak bytes per tag, live bytes per call site, where the call site is the
+// return address of the allocating call (addr2line it). A site whose live
+// bytes only grow is the leak. Blocks must be freed with qmsd_mem_free, never
+// with free/heap_caps_free.
+
+#define QMSD_MEM_HEADER_SIZE    8
+#define QMSD_MEM_SITES          128         // distinct call sites tracked, the rest count under their tag only
+#define QMSD_MEM_SITE_NONE      0xffff
+
+typedef enum {
+    QMSD_MEM_TAG_OTHER = 0,
+    QMSD_MEM_TAG_AUDIO,
+    QMSD_MEM_TAG_GUI,
+    QMSD_MEM_TAG_RTC,
+    QMSD_MEM_TAG_NET,
+    QMSD_MEM_TAG_DRIVER,
+    QMSD_MEM_TAG_MAX,
+} qmsd_mem_tag_t;
+
+// Heap regions, also the caps a backend is asked for.
+typedef enum {
+    QMSD_MEM_REGION_INTERNAL = 0,
+    QMSD_MEM_REGION_PSRAM,
+    QMSD_MEM_REGION_DMA,                    // internal and dma capable
+    QMSD_MEM_REGION_MAX,
+} qmsd_mem_region_t;
+
+// Allocation flags, 0 follows the tag policy.
+#define QMSD_MEM_INTERNAL       (1 << 0)
+#define QMSD_MEM_PSRAM          (1 << 1)
+#define QMSD_MEM_DMA            (1 << 2)
+#define QMSD_MEM_NO_FALLBACK    (1 << 3)    // fail rather than take the other heap
+
+typedef struct {
+    uint8_t region;                         // qmsd_mem_region_t, first choice
+    uint8_t fallback;                       // qmsd_mem_region_t, or QMSD_MEM_REGION_MAX for none
+    uint16_t internal_below;                // smaller blocks try internal first
+} qmsd_mem_policy_t;
+
+typedef struct {
+    void* (*alloc)(uint32_t size, qmsd_mem_region_t region);
+    void (*free)(void* ptr);
+} qmsd_mem_backend_t;
+
+typedef struct {
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint32_t live_blocks;
+    uint32_t allocs;
+    uint32_t failures;
+    uint32_t fallbacks;                     // served by the fallback heap
+    uint32_t region_bytes[QMSD_MEM_REGION_MAX];
+} qmsd_mem_tag_stats_t;
+
+typedef struct {
+    const void* pc;
+    uint8_t tag;
+    uint32_t live_bytes;
+    uint32_t live_blocks;
+    uint32_t allocs;
+} qmsd_mem_site_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The default backend is heap_caps on target and libc malloc on the host.
+void qmsd_mem_set_backend(const qmsd_mem_backend_t* backend);
+
+void qmsd_mem_set_policy(qmsd_mem_tag_t tag, const qmsd_mem_policy_t* policy);
+
+void* qmsd_mem_malloc(qmsd_mem_tag_t tag, uint32_t size, uint32_t flags);
+
+void* qmsd_mem_calloc(qmsd_mem_tag_t tag, uint32_t n, uint32_t size, uint32_t flags);
+
+// Keeps the block's tag and region, size 0 frees. ptr must not be NULL.
+void* qmsd_mem_realloc(void* ptr, uint32_t size);
+
+// For wrappers: site is the return address of the wrapper's caller.
+void* qmsd_mem_malloc_at(qmsd_mem_tag_t tag, uint32_t size, uint32_t flags, const void* site);
+
+void qmsd_mem_free(void* ptr);
+
+// Requested size of a live block.
+uint32_t qmsd_mem_size(const void* ptr);
+
+const char* qmsd_mem_tag_name(qmsd_mem_tag_t tag);
+
+void qmsd_mem_get_tag_stats(qmsd_mem_tag_t tag, qmsd_mem_tag_stats_t* stats);
+
+// Frees of pointers without a valid header, double frees included.
+uint32_t qmsd_mem_bad_frees(void);
+
+// Up to max sites with live blocks, most live bytes first, returns the count.
+uint32_t qmsd_mem_get_sites(qmsd_mem_site_t* sites, uint32_t max);
+
+// 0 when all free memory is one block, toward 100 as it splinters.
+uint8_t qmsd_mem_fragmentation(uint32_t free_bytes, uint32_t largest_block);
+
+#ifdef __cplusplus
+}
+#endif
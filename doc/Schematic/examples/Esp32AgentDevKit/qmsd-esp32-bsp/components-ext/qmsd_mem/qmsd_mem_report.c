@@ -0,0 +1,127 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "qmsd_metrics.h"
+#include "qmsd_mem.h"
+#include "qmsd_mem_report.h"
+#include "qmsd_sched.h"
+
+#define TAG "QMSD_MEM"
+
+#define REPORT_STACK        3072
+#define REPORT_PRIORITY     1
+#define REPORT_SITES        8
+
+static void* esp_mem_alloc(uint32_t size, qmsd_mem_region_t region);
+
+const qmsd_mem_backend_t qmsd_mem_default_backend = {
+    .alloc = esp_mem_alloc,
+    .free = heap_caps_free,
+};
+
+static const uint32_t g_region_caps[QMSD_MEM_REGION_MAX] = {
+    [QMSD_MEM_REGION_INTERNAL] = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    [QMSD_MEM_REGION_PSRAM] = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+    [QMSD_MEM_REGION_DMA] = MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA,
+};
+
+static const char* const g_region_names[QMSD_MEM_REGION_MAX] = {
+    "internal", "psram", "dma",
+};
+
+static qmsd_metric_t g_live_metrics[QMSD_MEM_TAG_MAX] = {
+    {.name = "mem.other.live"}, {.name = "mem.audio.live"}, {.name = "mem.gui.live"},
+    {.name = "mem.rtc.live"}, {.name = "mem.net.live"}, {.name = "mem.driver.live"},
+};
+
+static qmsd_metric_t g_peak_metrics[QMSD_MEM_TAG_MAX] = {
+    {.name = "mem.other.peak"}, {.name = "mem.audio.peak"}, {.name = "mem.gui.peak"},
+    {.name = "mem.rtc.peak"}, {.name = "mem.net.peak"}, {.name = "mem.driver.peak"},
+};
+
+static qmsd_metric_t g_frag_metrics[QMSD_MEM_REGION_MAX] = {
+    {.name = "heap.internal.frag_pct"}, {.name = "heap.psram.frag_pct"}, {.name = "heap.dma.frag_pct"},
+};
+
+static bool g_report_started = false;
+
+static void* esp_mem_alloc(uint32_t size, qmsd_mem_region_t region) {
+    return heap_caps_malloc(size, g_region_caps[region]);
+}
+
+void qmsd_mem_report_log(void) {
+    qmsd_mem_tag_stats_t stats;
+    ESP_LOGI(TAG, "tag        live       peak   blocks  fallback  failed");
+    for (uint8_t tag = 0; tag < QMSD_MEM_TAG_MAX; tag++) {
+        qmsd_mem_get_tag_stats((qmsd_mem_tag_t)tag, &stats);
+        qmsd_metric_set(&g_live_metrics[tag], stats.live_bytes);
+        qmsd_metric_set(&g_peak_metrics[tag], stats.peak_bytes);
+        if (stats.allocs == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-7s %7lu    %7lu   %6lu  %8lu  %6lu", qmsd_mem_tag_name((qmsd_mem_tag_t)tag),
+                 (unsigned long)stats.live_bytes, (unsigned long)stats.peak_bytes, (unsigned long)stats.live_blocks,
+                 (unsigned long)stats.fallbacks, (unsigned long)stats.failures);
+    }
+
+    ESP_LOGI(TAG, "heap        free    largest   min free  blocks  frag");
+    for (uint8_t region = 0; region < QMSD_MEM_REGION_MAX; region++) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, g_region_caps[region]);
+        if (info.total_free_bytes + info.total_allocated_bytes == 0) {
+            continue;
+        }
+        uint8_t frag = qmsd_mem_fragmentation(info.total_free_bytes, info.largest_free_block);
+        qmsd_metric_set(&g_frag_metrics[region], frag);
+        ESP_LOGI(TAG, "%-8s %7u    %7u    %7u  %6u  %3u%%", g_region_names[region], info.total_free_bytes,
+                 info.largest_free_block, info.minimum_free_bytes, info.free_blocks, frag);
+    }
+
+    qmsd_mem_site_t sites[REPORT_SITES];
+    uint32_t n = qmsd_mem_get_sites(sites, REPORT_SITES);
+    for (uint32_t i = 0; i < n; i++) {
+        ESP_LOGI(TAG, "site %p %-7s %7lu B in %lu blocks, %lu allocs", sites[i].pc, qmsd_mem_tag_name((qmsd_mem_tag_t)sites[i].tag),
+                 (unsigned long)sites[i].live_bytes, (unsigned long)sites[i].live_blocks, (unsigned long)sites[i].allocs);
+    }
+    if (qmsd_mem_bad_frees()) {
+        ESP_LOGW(TAG, "%lu frees of foreign or freed blocks", (unsigned long)qmsd_mem_bad_frees());
+    }
+}
+
+static void report_task(void* arg) {
+    uint32_t period_ms = (uint32_t)arg;
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(period_ms));
+        qmsd_mem_report_log();
+    }
+}
+
+esp_err_t qmsd_mem_report_start(uint32_t period_ms) {
+    if (g_report_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (uint8_t tag = 0; tag < QMSD_MEM_TAG_MAX; tag++) {
+        g_live_metrics[tag].type = QMSD_METRIC_GAUGE;
+        g_peak_metrics[tag].type = QMSD_METRIC_GAUGE;
+        qmsd_metrics_register(&g_live_metrics[tag]);
+        qmsd_metrics_register(&g_peak_metrics[tag]);
+    }
+    for (uint8_t region = 0; region < QMSD_MEM_REGION_MAX; region++) {
+        g_frag_metrics[region].type = QMSD_METRIC_GAUGE;
+        qmsd_metrics_register(&g_frag_metrics[region]);
+    }
+    g_report_started = true;
+    if (period_ms == 0) {
+        return ESP_OK;
+    }
+    UBaseType_t prio = REPORT_PRIORITY;
+    BaseType_t core = tskNO_AFFINITY;
+    uint32_t stack_size = REPORT_STACK;
+    qmsd_sched_place("mem_report", &prio, &core, &stack_size);
+    if (xTaskCreatePinnedToCore(report_task, "mem_report", stack_size, (void *)period_ms, prio, NULL, core) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
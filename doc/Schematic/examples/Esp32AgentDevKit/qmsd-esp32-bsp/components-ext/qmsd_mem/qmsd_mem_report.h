@@ -0,0 +1,22 @@
+#pragma once
+
+#include "stdint.h"
+#include "esp_err.h"
+
+// Periodic report of the tagged allocator (qmsd_mem.h) and the heaps under
+// it: live and peak bytes per tag, free, largest block and fragmentation per
+// heap region, and the call sites holding the most memory. The same numbers go
+// to qmsd_metrics as mem.<tag>.live, mem.<tag>.peak and heap.<region>.frag_pct.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// period_ms 0 only registers the metrics and updates them on each log call.
+esp_err_t qmsd_mem_report_start(uint32_t period_ms);
+
+void qmsd_mem_report_log(void);
+
+#ifdef __cplusplus
+}
+#endif
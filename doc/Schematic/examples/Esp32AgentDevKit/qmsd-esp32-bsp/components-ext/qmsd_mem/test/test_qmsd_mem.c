@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "unity.h"
+#include "qmsd_mem.h"
+
+// malloc shim: each region has a byte budget, so psram can run out on the host
+typedef struct {
+    uint32_t size;
+    uint32_t region;
+} shim_header_t;
+
+static uint32_t s_budget[QMSD_MEM_REGION_MAX];
+static uint32_t s_used[QMSD_MEM_REGION_MAX];
+static uint32_t s_calls[QMSD_MEM_REGION_MAX];
+static pthread_mutex_t s_shim_lock = PTHREAD_MUTEX_INITIALIZER;
+// freed blocks linger here, so a double free reads a valid stale header
+static void* s_quarantine[16];
+static uint32_t s_quarantine_pos;
+
+static void* shim_alloc(uint32_t size, qmsd_mem_region_t region) {
+    pthread_mutex_lock(&s_shim_lock);
+    s_calls[region]++;
+    if (s_used[region] + size > s_budget[region]) {
+        pthread_mutex_unlock(&s_shim_lock);
+        return NULL;
+    }
+    s_used[region] += size;
+    pthread_mutex_unlock(&s_shim_lock);
+    shim_header_t* header = malloc(sizeof(shim_header_t) + size);
+    header->size = size;
+    header->region = region;
+    return header + 1;
+}
+
+static void shim_free(void* ptr) {
+    shim_header_t* header = (shim_header_t *)ptr - 1;
+    pthread_mutex_lock(&s_shim_lock);
+    s_used[header->region] -= header->size;
+    void* old = s_quarantine[s_quarantine_pos];
+    s_quarantine[s_quarantine_pos] = header;
+    s_quarantine_pos = (s_quarantine_pos + 1) % 16;
+    pthread_mutex_unlock(&s_shim_lock);
+    free(old);
+}
+
+static const qmsd_mem_backend_t s_shim = {
+    .alloc = shim_alloc,
+    .free = shim_free,
+};
+
+static void shim_reset(uint32_t internal, uint32_t psram, uint32_t dma) {
+    s_budget[QMSD_MEM_REGION_INTERNAL] = internal;
+    s_budget[QMSD_MEM_REGION_PSRAM] = psram;
+    s_budget[QMSD_MEM_REGION_DMA] = dma;
+    memset(s_calls, 0, sizeof(s_calls));
+    qmsd_mem_set_backend(&s_shim);
+}
+
+static uint32_t region_of(const void* ptr) {
+    // the shim header sits right in front of the allocator's
+    return ((const shim_header_t *)((const uint8_t *)ptr - QMSD_MEM_HEADER_SIZE) - 1)->region;
+}
+
+TEST_CASE("tag policy picks the region, forced regions never fall back", "[qmsd_mem]")
+{
+    shim_reset(64 * 1024, 64 * 1024, 8 * 1024);
+    void* big = qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, 4096, 0);
+    void* small = qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, 64, 0);
+    void* net = qmsd_mem_malloc(QMSD_MEM_TAG_NET, 4096, 0);
+    void* dma = qmsd_mem_malloc(QMSD_MEM_TAG_DRIVER, 1024, QMSD_MEM_DMA);
+    TEST_ASSERT_EQUAL_UINT32(QMSD_MEM_REGION_PSRAM, region_of(big));
+    TEST_ASSERT_EQUAL_UINT32(QMSD_MEM_REGION_INTERNAL, region_of(small));
+    TEST_ASSERT_EQUAL_UINT32(QMSD_MEM_REGION_INTERNAL, region_of(net));
+    TEST_ASSERT_EQUAL_UINT32(QMSD_MEM_REGION_DMA, region_of(dma));
+    TEST_ASSERT_NULL(qmsd_mem_malloc(QMSD_MEM_TAG_DRIVER, 16 * 1024, QMSD_MEM_DMA));
+
+    // psram full: the gui falls back to internal, a forced psram block fails
+    void* fill = qmsd_mem_malloc(QMSD_MEM_TAG_OTHER, 56 * 1024, QMSD_MEM_PSRAM);
+    TEST_ASSERT_NOT_NULL(fill);
+    void* gui = qmsd_mem_malloc(QMSD_MEM_TAG_GUI, 8 * 1024, 0);
+    TEST_ASSERT_NOT_NULL(gui);
+    TEST_ASSERT_EQUAL_UINT32(QMSD_MEM_REGION_INTERNAL, region_of(gui));
+    TEST_ASSERT_NULL(qmsd_mem_malloc(QMSD_MEM_TAG_GUI, 8 * 1024, QMSD_MEM_PSRAM));
+    TEST_ASSERT_NULL(qmsd_mem_malloc(QMSD_MEM_TAG_GUI, 8 * 1024, QMSD_MEM_NO_FALLBACK));
+
+    qmsd_mem_tag_stats_t stats;
+    qmsd_mem_get_tag_stats(QMSD_MEM_TAG_GUI, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fallbacks);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.failures);
+    TEST_ASSERT_EQUAL_UINT32(8 * 1024, stats.region_bytes[QMSD_MEM_REGION_INTERNAL]);
+
+    void* blocks[] = {big, small, net, dma, fill, gui};
+    for (int i = 0; i < 6; i++) {
+        qmsd_mem_free(blocks[i]);
+    }
+    for (int r = 0; r < QMSD_MEM_REGION_MAX; r++) {
+        TEST_ASSERT_EQUAL_UINT32(0, s_used[r]);
+    }
+}
+
+TEST_CASE("live and peak bytes are kept per tag", "[qmsd_mem]")
+{
+    shim_reset(1 << 20, 1 << 20, 0);
+    qmsd_mem_tag_stats_t before, stats;
+    qmsd_mem_get_tag_stats(QMSD_MEM_TAG_RTC, &before);
+    void* a = qmsd_mem_malloc(QMSD_MEM_TAG_RTC, 1000, 0);
+    uint8_t* b = qmsd_mem_calloc(QMSD_MEM_TAG_RTC, 10, 300, 0);
+    TEST_ASSERT_EQUAL_UINT32(3000, qmsd_mem_size(b));
+    for (int i = 0; i < 3000; i++) {
+        TEST_ASSERT_EQUAL_UINT8(0, b[i]);
+    }
+    qmsd_mem_get_tag_stats(QMSD_MEM_TAG_RTC, &stats);
+    TEST_ASSERT_EQUAL_UINT32(before.live_bytes + 4000, stats.live_bytes);
+    TEST_ASSERT_EQUAL_UINT32(before.live_blocks + 2, stats.live_blocks);
+    qmsd_mem_free(a);
+    qmsd_mem_free(b);
+    qmsd_mem_get_tag_stats(QMSD_MEM_TAG_RTC, &stats);
+    TEST_ASSERT_EQUAL_UINT32(before.live_bytes, stats.live_bytes);
+    TEST_ASSERT_EQUAL_UINT32(before.live_blocks, stats.live_blocks);
+    TEST_ASSERT_EQUAL_UINT32(before.allocs + 2, stats.allocs);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(before.live_bytes + 4000, stats.peak_bytes);
+    TEST_ASSERT_NULL(qmsd_mem_calloc(QMSD_MEM_TAG_RTC, 0x10000, 0x10000, 0));
+}
+
+TEST_CASE("realloc keeps tag, region and contents", "[qmsd_mem]")
+{
+    shim_reset(1 << 20, 1 << 20, 1 << 20);
+    char* p = qmsd_mem_malloc(QMSD_MEM_TAG_NET, 16, QMSD_MEM_DMA);
+    strcpy(p, "dma descriptor");
+    p = qmsd_mem_realloc(p, 4096);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_EQUAL_STRING("dma descriptor", p);
+    TEST_ASSERT_EQUAL_UINT32(QMSD_MEM_REGION_DMA, region_of(p));
+    TEST_ASSERT_EQUAL_UINT32(4096, qmsd_mem_size(p));
+    TEST_ASSERT_NULL(qmsd_mem_realloc(p, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, s_used[QMSD_MEM_REGION_DMA]);
+}
+
+static __attribute__((noinline)) void* leaky_site(void) {
+    return qmsd_mem_malloc(QMSD_MEM_TAG_AUDIO, 640, 0);
+}
+
+static __attribute__((noinline)) void* balanced_site(void) {
+    return qmsd_mem_malloc(QMSD_MEM_TAG_GUI, 64, 0);
+}
+
+TEST_CASE("leaks are attributed to their call site", "[qmsd_mem]")
+{
+    shim_reset(1 << 20, 1 << 20, 0);
+    void* leaked[10];
+    void* kept = NULL;
+    for (int i = 0; i <= 10; i++) {
+        void* p = balanced_site();
+        if (i == 10) {
+            kept = p;
+            break;
+        }
+        qmsd_mem_free(p);
+        leaked[i] = leaky_site();
+    }
+
+    qmsd_mem_site_t sites[4];
+    uint32_t n = qmsd_mem_get_sites(sites, 4);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, n);
+    TEST_ASSERT_EQUAL_UINT8(QMSD_MEM_TAG_AUDIO, sites[0].tag);
+    TEST_ASSERT_EQUAL_UINT32(6400, sites[0].live_bytes);
+    TEST_ASSERT_EQUAL_UINT32(10, sites[0].live_blocks);
+    TEST_ASSERT_TRUE(sites[0].pc != sites[1].pc);
+    TEST_ASSERT_EQUAL_UINT8(QMSD_MEM_TAG_GUI, sites[1].tag);
+    TEST_ASSERT_EQUAL_UINT32(64, sites[1].live_bytes);
+    TEST_ASSERT_EQUAL_UINT32(11, sites[1].allocs);
+    // a short table keeps the biggest
+    TEST_ASSERT_EQUAL_UINT32(1, qmsd_mem_get_sites(sites, 1));
+    TEST_ASSERT_EQUAL_UINT32(6400, sites[0].live_bytes);
+
+    for (int i = 0; i < 10; i++) {
+        qmsd_mem_free(leaked[i]);
+    }
+    qmsd_mem_free(kept);
+    TEST_ASSERT_EQUAL_UINT32(0, qmsd_mem_get_sites(sites, 4));
+}
+
+TEST_CASE("double and foreign frees are counted, not passed on", "[qmsd_mem]")
+{
+    shim_reset(1 << 20, 1 << 20, 0);
+    uint32_t bad = qmsd_mem_bad_frees();
+    void* p = qmsd_mem_malloc(QMSD_MEM_TAG_OTHER, 32, 0);
+    qmsd_mem_free(p);
+    qmsd_mem_free(p);
+    static uint64_t foreign[4];
+    qmsd_mem_free(&foreign[1]);
+    TEST_ASSERT_EQUAL_UINT32(bad + 2, qmsd_mem_bad_frees());
+    TEST_ASSERT_EQUAL_UINT32(0, s_used[QMSD_MEM_REGION_INTERNAL]);
+}
+
+TEST_CASE("fragmentation is the share of free memory outside the largest block", "[qmsd_mem]")
+{
+    TEST_ASSERT_EQUAL_UINT8(0, qmsd_mem_fragmentation(0, 0));
+    TEST_ASSERT_EQUAL_UINT8(0, qmsd_mem_fragmentation(100000, 100000));
+    TEST_ASSERT_EQUAL_UINT8(75, qmsd_mem_fragmentation(100000, 25000));
+    TEST_ASSERT_EQUAL_UINT8(99, qmsd_mem_fragmentation(4000000, 40000));
+}
+
+#define HAMMER_THREADS  4
+#define HAMMER_LOOPS    200000
+
+static void* hammer(void* arg) {
+    qmsd_mem_tag_t tag = (qmsd_mem_tag_t)(uintptr_t)arg;
+    for (uint32_t i = 0; i < HAMMER_LOOPS; i++) {
+        void* p = qmsd_mem_malloc(tag, 32 + (i & 255), 0);
+        qmsd_mem_free(p);
+    }
+    return NULL;
+}
+
+static double elapsed_ns(const struct timespec* t0, const struct timespec* t1) {
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+TEST_CASE("accounting is exact under contention and cheap", "[qmsd_mem]")
+{
+    qmsd_mem_set_backend(NULL);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t i = 0; i < HAMMER_LOOPS; i++) {
+        void* p = malloc(32 + (i & 255));
+        __asm__ volatile("" : : "r"(p) : "memory");
+        free(p);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double raw = elapsed_ns(&t0, &t1) / HAMMER_LOOPS;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    hammer((void *)QMSD_MEM_TAG_OTHER);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double tagged = elapsed_ns(&t0, &t1) / HAMMER_LOOPS;
+    printf("malloc+free: %.1f ns raw, %.1f ns tagged\n", raw, tagged);
+
+    qmsd_mem_tag_stats_t before[QMSD_MEM_TAG_MAX];
+    for (int t = 0; t < QMSD_MEM_TAG_MAX; t++) {
+        qmsd_mem_get_tag_stats((qmsd_mem_tag_t)t, &before[t]);
+    }
+    pthread_t threads[HAMMER_THREADS];
+    for (uintptr_t i = 0; i < HAMMER_THREADS; i++) {
+        // two threads share a tag
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, hammer, (void *)(QMSD_MEM_TAG_AUDIO + i / 2)));
+    }
+    for (int i = 0; i < HAMMER_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int t = QMSD_MEM_TAG_AUDIO; t < QMSD_MEM_TAG_AUDIO + HAMMER_THREADS / 2; t++) {
+        qmsd_mem_tag_stats_t stats;
+        qmsd_mem_get_tag_stats((qmsd_mem_tag_t)t, &stats);
+        TEST_ASSERT_EQUAL_UINT32(before[t].live_bytes, stats.live_bytes);
+        TEST_ASSERT_EQUAL_UINT32(before[t].live_blocks, stats.live_blocks);
+        TEST_ASSERT_EQUAL_UINT32(before[t].allocs + 2 * HAMMER_LOOPS, stats.allocs);
+    }
+}
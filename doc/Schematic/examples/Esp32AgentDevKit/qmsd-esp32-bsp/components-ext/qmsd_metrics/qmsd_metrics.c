@@ -0,0 +1,158 @@
+#include "string.h"
+#include "qmsd_metrics.h"
+
+static qmsd_metric_t* g_metrics = NULL;
+
+void qmsd_metrics_register(qmsd_metric_t* metric)
+{
+    qmsd_metric_t* head = __atomic_load_n(&g_metrics, __ATOMIC_ACQUIRE);
+    do {
+        metric->next = head;
+    } while (!__atomic_compare_exchange_n(&g_metrics, &head, metric, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+void qmsd_metric_read(const qmsd_metric_t* metric, qmsd_metric_value_t* value)
+{
+    memset(value, 0, sizeof(qmsd_metric_value_t));
+    value->type = metric->type;
+    if (metric->type == QMSD_METRIC_GAUGE) {
+        value->gauge = __atomic_load_n(&metric->gauge, __ATOMIC_RELAXED);
+    } else if (metric->type == QMSD_METRIC_COUNTER) {
+        for (uint8_t core = 0; core < QMSD_METRICS_CORES; core++) {
+            value->count += __atomic_load_n(&metric->cells[core], __ATOMIC_RELAXED);
+        }
+    } else {
+        value->bucket_num = metric->bound_num + 1;
+        for (uint8_t core = 0; core < QMSD_METRICS_CORES; core++) {
+            const uint32_t* cells = metric->cells + core * (metric->bound_num + 2);
+            for (uint8_t i = 0; i < value->bucket_num; i++) {
+                uint32_t n = __atomic_load_n(&cells[i], __ATOMIC_RELAXED);
+                value->buckets[i] += n;
+                value->count += n;
+            }
+            value->sum += __atomic_load_n(&cells[metric->bound_num + 1], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+const qmsd_metric_t* qmsd_metrics_find(const char* name)
+{
+    for (const qmsd_metric_t* m = __atomic_load_n(&g_metrics, __ATOMIC_ACQUIRE); m; m = m->next) {
+        if (strcmp(m->name, name) == 0) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+void qmsd_metrics_foreach(qmsd_metrics_visit_t visit, void* ctx)
+{
+    for (const qmsd_metric_t* m = __atomic_load_n(&g_metrics, __ATOMIC_ACQUIRE); m; m = m->next) {
+        visit(m, ctx);
+    }
+}
+
+static uint32_t fnv1a(uint32_t hash, const void* data, uint32_t len)
+{
+    const uint8_t* p = (const uint8_t *)data;
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+uint32_t qmsd_metrics_schema_hash(void)
+{
+    uint32_t hash = 0x811c9dc5;
+    for (const qmsd_metric_t* m = __atomic_load_n(&g_metrics, __ATOMIC_ACQUIRE); m; m = m->next) {
+        hash = fnv1a(hash, &m->type, 1);
+        hash = fnv1a(hash, m->name, strlen(m->name) + 1);
+        if (m->type == QMSD_METRIC_HISTOGRAM) {
+            hash = fnv1a(hash, m->bounds, m->bound_num * sizeof(uint32_t));
+        }
+    }
+    return hash;
+}
+
+typedef struct {
+    uint8_t* buf;
+    uint32_t size;
+    uint32_t len;
+    bool overflow;
+} writer_t;
+
+static void put_u8(writer_t* w, uint8_t v)
+{
+    if (w->len >= w->size) {
+        w->overflow = true;
+        return ;
+    }
+    w->buf[w->len++] = v;
+}
+
+static void put_le(writer_t* w, uint32_t v, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++) {
+        put_u8(w, (uint8_t)(v >> (8 * i)));
+    }
+}
+
+static void put_varint(writer_t* w, uint32_t v)
+{
+    while (v >= 0x80) {
+        put_u8(w, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    put_u8(w, (uint8_t)v);
+}
+
+int qmsd_metrics_snapshot(uint8_t* buf, uint32_t size, uint32_t timestamp_ms, uint8_t flags)
+{
+    writer_t w = {
+        .buf = buf,
+        .size = size,
+    };
+    uint16_t count = 0;
+    put_le(&w, QMSD_METRICS_MAGIC, 4);
+    put_u8(&w, QMSD_METRICS_VERSION);
+    put_u8(&w, flags);
+    put_le(&w, 0, 2);               // count, filled in below
+    put_le(&w, qmsd_metrics_schema_hash(), 4);
+    put_le(&w, timestamp_ms, 4);
+
+    qmsd_metric_value_t value;
+    for (const qmsd_metric_t* m = __atomic_load_n(&g_metrics, __ATOMIC_ACQUIRE); m; m = m->next) {
+        if (flags & QMSD_METRICS_SNAPSHOT_NAMES) {
+            uint8_t name_len = strlen(m->name);
+            put_u8(&w, m->type);
+            put_u8(&w, name_len);
+            for (uint8_t i = 0; i < name_len; i++) {
+                put_u8(&w, m->name[i]);
+            }
+            if (m->type == QMSD_METRIC_HISTOGRAM) {
+                put_u8(&w, m->bound_num);
+                for (uint8_t i = 0; i < m->bound_num; i++) {
+                    put_varint(&w, m->bounds[i]);
+                }
+            }
+        }
+        qmsd_metric_read(m, &value);
+        if (m->type == QMSD_METRIC_COUNTER) {
+            put_varint(&w, value.count);
+        } else if (m->type == QMSD_METRIC_GAUGE) {
+            put_varint(&w, ((uint32_t)value.gauge << 1) ^ (uint32_t)(value.gauge >> 31));
+        } else {
+            for (uint8_t i = 0; i < value.bucket_num; i++) {
+                put_varint(&w, value.buckets[i]);
+            }
+            put_varint(&w, value.sum);
+        }
+        count++;
+    }
+    if (w.overflow) {
+        return -1;
+    }
+    buf[6] = (uint8_t)count;
+    buf[7] = (uint8_t)(count >> 8);
+    return w.len;
+}
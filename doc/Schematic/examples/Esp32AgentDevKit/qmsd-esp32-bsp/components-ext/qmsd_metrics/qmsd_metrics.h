@@ -0,0 +1,158 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "soc/soc_caps.h"
+#endif
+
+// Metrics registry. A subsystem defines its metrics statically in the file
+// that updates them, a constructor links them into the registry before
+// app_main:
+//
+//     QMSD_METRIC_COUNTER(s_frames, "audio.mp3.frames");
+//     QMSD_METRIC_HISTOGRAM(s_decode_us, "audio.mp3.decode_us", 1000, 2000, 5000, 10000);
+//
+//     qmsd_metric_inc(&s_frames);
+//     qmsd_metric_observe(&s_decode_us, us);
+//
+// An update is one relaxed atomic add on the running core's slot: no lock, no
+// formatting, fine from any task or isr (not from one that runs with the flash
+// cache off, histogram bounds are const). Readers fold the slots. Counters and
+// histogram sums wrap at 32 bits, take differences between snapshots.
+//
+// Snapshot, little endian, v = unsigned LEB128 varint, z = zigzag varint:
+//     u32 magic "QMTS", u8 version, u8 flags, u16 metric count,
+//     u32 schema hash, u32 timestamp ms, then per metric
+//     with QMSD_METRICS_SNAPSHOT_NAMES: u8 type, u8 name len, name,
+//         histogram: u8 bound count, v bounds
+//     counter: v value / gauge: z value / histogram: v buckets (bounds + 1), v sum
+// A snapshot without names is decoded with the names of an earlier one of the
+// same schema hash (qmsd-esp32-bsp/tools/metrics_decode.py).
+
+#define QMSD_METRICS_MAGIC              0x53544D51UL    // "QMTS"
+#define QMSD_METRICS_VERSION            1
+#define QMSD_METRICS_SNAPSHOT_NAMES     0x01
+#define QMSD_METRICS_MAX_BUCKETS        16              // bounds + the overflow bucket
+#define QMSD_METRICS_NAME_LEN           32
+
+#ifndef QMSD_METRICS_CORES
+#ifdef ESP_PLATFORM
+#define QMSD_METRICS_CORES              SOC_CPU_CORES_NUM
+#else
+#define QMSD_METRICS_CORES              2
+#endif
+#endif
+
+#ifndef QMSD_METRICS_CORE_ID
+#ifdef ESP_PLATFORM
+#define QMSD_METRICS_CORE_ID()          esp_cpu_get_core_id()
+#else
+#define QMSD_METRICS_CORE_ID()          0
+#endif
+#endif
+
+typedef enum {
+    QMSD_METRIC_COUNTER = 0,
+    QMSD_METRIC_GAUGE,
+    QMSD_METRIC_HISTOGRAM,
+} qmsd_metric_type_t;
+
+typedef struct qmsd_metric {
+    const char* name;               // "subsystem.what", unique, < QMSD_METRICS_NAME_LEN
+    uint8_t type;
+    uint8_t bound_num;              // histogram
+    const uint32_t* bounds;         // histogram: ascending upper bounds, a sample v goes to the first v <= bound
+    uint32_t* cells;                // counter: [cores], histogram: [cores][bound_num + 2], the last one the sum
+    int32_t gauge;
+    struct qmsd_metric* next;
+} qmsd_metric_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t bucket_num;             // histogram: bound_num + 1
+    int32_t gauge;
+    uint32_t count;                 // counter value, histogram samples
+    uint32_t sum;                   // histogram
+    uint32_t buckets[QMSD_METRICS_MAX_BUCKETS];
+} qmsd_metric_value_t;
+
+typedef void (*qmsd_metrics_visit_t)(const qmsd_metric_t* metric, void* ctx);
+
+#define QMSD_METRIC_REGISTER_(var)                                                  \
+    static void __attribute__((constructor)) var##_register(void) {                 \
+        qmsd_metrics_register(&var);                                                \
+    }
+
+#define QMSD_METRIC_COUNTER(var, metric_name)                                       \
+    static uint32_t var##_cells[QMSD_METRICS_CORES];                                \
+    static qmsd_metric_t var = {                                                    \
+        .name = metric_name, .type = QMSD_METRIC_COUNTER, .cells = var##_cells,     \
+    };                                                                              \
+    QMSD_METRIC_REGISTER_(var)
+
+#define QMSD_METRIC_GAUGE(var, metric_name)                                         \
+    static qmsd_metric_t var = {                                                    \
+        .name = metric_name, .type = QMSD_METRIC_GAUGE,                             \
+    };                                                                              \
+    QMSD_METRIC_REGISTER_(var)
+
+#define QMSD_METRIC_HISTOGRAM(var, metric_name, ...)                                \
+    static const uint32_t var##_bounds[] = {__VA_ARGS__};                           \
+    _Static_assert(sizeof(var##_bounds) / sizeof(uint32_t) < QMSD_METRICS_MAX_BUCKETS, "too many buckets"); \
+    static uint32_t var##_cells[QMSD_METRICS_CORES][sizeof(var##_bounds) / sizeof(uint32_t) + 2]; \
+    static qmsd_metric_t var = {                                                    \
+        .name = metric_name, .type = QMSD_METRIC_HISTOGRAM,                         \
+        .bound_num = sizeof(var##_bounds) / sizeof(uint32_t),                       \
+        .bounds = var##_bounds, .cells = &var##_cells[0][0],                        \
+    };                                                                              \
+    QMSD_METRIC_REGISTER_(var)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called by the definition macros. Lock free, so a metric may also be
+// registered at run time, it must outlive the registry.
+void qmsd_metrics_register(qmsd_metric_t* metric);
+
+static inline void qmsd_metric_add(qmsd_metric_t* metric, uint32_t n) {
+    __atomic_fetch_add(&metric->cells[QMSD_METRICS_CORE_ID()], n, __ATOMIC_RELAXED);
+}
+
+static inline void qmsd_metric_inc(qmsd_metric_t* metric) {
+    qmsd_metric_add(metric, 1);
+}
+
+static inline void qmsd_metric_set(qmsd_metric_t* metric, int32_t value) {
+    __atomic_store_n(&metric->gauge, value, __ATOMIC_RELAXED);
+}
+
+static inline void qmsd_metric_observe(qmsd_metric_t* metric, uint32_t value) {
+    uint8_t bucket = 0;
+    while (bucket < metric->bound_num && value > metric->bounds[bucket]) {
+        bucket++;
+    }
+    uint32_t* cells = metric->cells + QMSD_METRICS_CORE_ID() * (metric->bound_num + 2);
+    __atomic_fetch_add(&cells[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&cells[metric->bound_num + 1], value, __ATOMIC_RELAXED);
+}
+
+// Folds the per core slots.
+void qmsd_metric_read(const qmsd_metric_t* metric, qmsd_metric_value_t* value);
+
+const qmsd_metric_t* qmsd_metrics_find(const char* name);
+
+// Every metric in snapshot order.
+void qmsd_metrics_foreach(qmsd_metrics_visit_t visit, void* ctx);
+
+// Changes only when metrics are added, or names, types or bounds change.
+uint32_t qmsd_metrics_schema_hash(void);
+
+// Returns the snapshot length, -1 when size is too small.
+int qmsd_metrics_snapshot(uint8_t* buf, uint32_t size, uint32_t timestamp_ms, uint8_t flags);
+
+#ifdef __cplusplus
+}
+#endif
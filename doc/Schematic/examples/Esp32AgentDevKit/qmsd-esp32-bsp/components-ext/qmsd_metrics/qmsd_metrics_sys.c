@@ -0,0 +1,49 @@
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "qmsd_metrics.h"
+#include "qmsd_metrics_sys.h"
+
+#define TAG "QMSD_METRICS"
+
+QMSD_METRIC_GAUGE(s_internal_free, "heap.internal.free");
+QMSD_METRIC_GAUGE(s_internal_min_free, "heap.internal.min_free");
+QMSD_METRIC_GAUGE(s_internal_largest, "heap.internal.largest");
+QMSD_METRIC_GAUGE(s_psram_free, "heap.psram.free");
+QMSD_METRIC_GAUGE(s_psram_min_free, "heap.psram.min_free");
+
+static esp_timer_handle_t g_sys_timer = NULL;
+
+static void sys_sample(void* arg) {
+    qmsd_metric_set(&s_internal_free, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    qmsd_metric_set(&s_internal_min_free, heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    qmsd_metric_set(&s_internal_largest, heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    qmsd_metric_set(&s_psram_free, heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    qmsd_metric_set(&s_psram_min_free, heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+}
+
+esp_err_t qmsd_metrics_sys_start(uint32_t period_ms) {
+    if (g_sys_timer) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const esp_timer_create_args_t timer_args = {
+        .callback = sys_sample,
+        .name = "metrics_sys",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &g_sys_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create the sample timer");
+        return ret;
+    }
+    sys_sample(NULL);
+    return esp_timer_start_periodic(g_sys_timer, (uint64_t)period_ms * 1000);
+}
+
+void qmsd_metrics_sys_stop(void) {
+    if (g_sys_timer == NULL) {
+        return ;
+    }
+    esp_timer_stop(g_sys_timer);
+    esp_timer_delete(g_sys_timer);
+    g_sys_timer = NULL;
+}
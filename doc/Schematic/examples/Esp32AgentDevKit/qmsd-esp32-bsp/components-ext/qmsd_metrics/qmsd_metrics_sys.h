@@ -0,0 +1,20 @@
+#pragma once
+
+#include "stdint.h"
+#include "esp_err.h"
+
+// Heap gauges sampled on an esp_timer, so a snapshot shows them next to the
+// subsystem metrics: heap.internal.{free,min_free,largest},
+// heap.psram.{free,min_free}. Everything else publishes where it happens.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t qmsd_metrics_sys_start(uint32_t period_ms);
+
+void qmsd_metrics_sys_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
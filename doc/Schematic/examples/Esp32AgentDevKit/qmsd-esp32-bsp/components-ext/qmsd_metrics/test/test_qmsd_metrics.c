@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "unity.h"
+
+// updates land on the slot of the "core" the calling thread pretends to run on
+static __thread uint8_t s_core;
+#define QMSD_METRICS_CORE_ID()  s_core
+#include "qmsd_metrics.h"
+
+QMSD_METRIC_COUNTER(s_frames, "test.frames");
+QMSD_METRIC_COUNTER(s_hammer, "test.hammer");
+QMSD_METRIC_GAUGE(s_level, "test.level");
+QMSD_METRIC_HISTOGRAM(s_latency, "test.latency_us", 100, 1000, 10000);
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+} reader_t;
+
+static uint32_t get_le(reader_t* r, uint8_t bytes)
+{
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < bytes; i++) {
+        TEST_ASSERT_TRUE(r->p < r->end);
+        v |= (uint32_t)*r->p++ << (8 * i);
+    }
+    return v;
+}
+
+static uint32_t get_varint(reader_t* r)
+{
+    uint32_t v = 0;
+    for (uint8_t shift = 0;; shift += 7) {
+        TEST_ASSERT_TRUE(r->p < r->end);
+        uint8_t b = *r->p++;
+        v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return v;
+        }
+    }
+}
+
+TEST_CASE("counters fold the slots of every core", "[qmsd_metrics]")
+{
+    s_core = 0;
+    qmsd_metric_add(&s_frames, 5);
+    s_core = 1;
+    qmsd_metric_inc(&s_frames);
+    qmsd_metric_inc(&s_frames);
+    s_core = 0;
+
+    qmsd_metric_value_t value;
+    qmsd_metric_read(&s_frames, &value);
+    TEST_ASSERT_EQUAL_UINT8(QMSD_METRIC_COUNTER, value.type);
+    TEST_ASSERT_EQUAL_UINT32(7, value.count);
+    TEST_ASSERT_EQUAL_UINT32(5, s_frames_cells[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, s_frames_cells[1]);
+    TEST_ASSERT_EQUAL_PTR(&s_frames, qmsd_metrics_find("test.frames"));
+    TEST_ASSERT_NULL(qmsd_metrics_find("test.nothing"));
+}
+
+TEST_CASE("histogram buckets take values up to their bound", "[qmsd_metrics]")
+{
+    const uint32_t samples[] = {0, 100, 101, 1000, 5000, 10000, 10001, 250000};
+    for (uint32_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        s_core = i & 1;
+        qmsd_metric_observe(&s_latency, samples[i]);
+    }
+    s_core = 0;
+    qmsd_metric_value_t value;
+    qmsd_metric_read(&s_latency, &value);
+    TEST_ASSERT_EQUAL_UINT8(4, value.bucket_num);
+    TEST_ASSERT_EQUAL_UINT32(2, value.buckets[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, value.buckets[1]);
+    TEST_ASSERT_EQUAL_UINT32(2, value.buckets[2]);
+    TEST_ASSERT_EQUAL_UINT32(2, value.buckets[3]);
+    TEST_ASSERT_EQUAL_UINT32(8, value.count);
+    TEST_ASSERT_EQUAL_UINT32(276202, value.sum);
+}
+
+typedef struct {
+    uint32_t seen;
+    uint32_t counters;
+} visit_t;
+
+static void visit(const qmsd_metric_t* metric, void* ctx)
+{
+    visit_t* v = (visit_t *)ctx;
+    v->seen++;
+    v->counters += metric->type == QMSD_METRIC_COUNTER;
+}
+
+TEST_CASE("snapshots carry every metric, names only on request", "[qmsd_metrics]")
+{
+    qmsd_metric_set(&s_level, -42);
+    visit_t v = {0};
+    qmsd_metrics_foreach(visit, &v);
+    TEST_ASSERT_EQUAL_UINT32(4, v.seen);
+    TEST_ASSERT_EQUAL_UINT32(2, v.counters);
+
+    uint8_t full[256], compact[256];
+    int full_len = qmsd_metrics_snapshot(full, sizeof(full), 123456, QMSD_METRICS_SNAPSHOT_NAMES);
+    int compact_len = qmsd_metrics_snapshot(compact, sizeof(compact), 123457, 0);
+    TEST_ASSERT_GREATER_THAN(0, compact_len);
+    TEST_ASSERT_GREATER_THAN(compact_len, full_len);
+    printf("snapshot of %lu metrics: %d B with names, %d B without\n", (unsigned long)v.seen, full_len, compact_len);
+    // one byte short fails instead of truncating
+    TEST_ASSERT_EQUAL_INT(-1, qmsd_metrics_snapshot(full, full_len - 1, 123456, QMSD_METRICS_SNAPSHOT_NAMES));
+    TEST_ASSERT_EQUAL_INT(full_len, qmsd_metrics_snapshot(full, full_len, 123456, QMSD_METRICS_SNAPSHOT_NAMES));
+
+    reader_t r = {full, full + full_len};
+    TEST_ASSERT_EQUAL_HEX32(QMSD_METRICS_MAGIC, get_le(&r, 4));
+    TEST_ASSERT_EQUAL_UINT8(QMSD_METRICS_VERSION, get_le(&r, 1));
+    TEST_ASSERT_EQUAL_UINT8(QMSD_METRICS_SNAPSHOT_NAMES, get_le(&r, 1));
+    uint16_t count = get_le(&r, 2);
+    TEST_ASSERT_EQUAL_UINT16(v.seen, count);
+    TEST_ASSERT_EQUAL_HEX32(qmsd_metrics_schema_hash(), get_le(&r, 4));
+    TEST_ASSERT_EQUAL_UINT32(123456, get_le(&r, 4));
+    // the compact one has the same header but for flags and time
+    TEST_ASSERT_EQUAL_MEMORY(full, compact, 5);
+    TEST_ASSERT_EQUAL_MEMORY(full + 6, compact + 6, 6);
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t type = get_le(&r, 1);
+        uint8_t name_len = get_le(&r, 1);
+        char name[QMSD_METRICS_NAME_LEN] = {0};
+        TEST_ASSERT_TRUE(name_len < sizeof(name));
+        memcpy(name, r.p, name_len);
+        r.p += name_len;
+        const qmsd_metric_t* metric = qmsd_metrics_find(name);
+        TEST_ASSERT_NOT_NULL(metric);
+        TEST_ASSERT_EQUAL_UINT8(metric->type, type);
+        qmsd_metric_value_t value;
+        qmsd_metric_read(metric, &value);
+        if (type == QMSD_METRIC_COUNTER) {
+            TEST_ASSERT_EQUAL_UINT32(value.count, get_varint(&r));
+        } else if (type == QMSD_METRIC_GAUGE) {
+            uint32_t z = get_varint(&r);
+            TEST_ASSERT_EQUAL_INT32(-42, (int32_t)(z >> 1) ^ -(int32_t)(z & 1));
+        } else {
+            uint8_t bound_num = get_le(&r, 1);
+            TEST_ASSERT_EQUAL_UINT8(3, bound_num);
+            for (uint8_t b = 0; b < bound_num; b++) {
+                TEST_ASSERT_EQUAL_UINT32(metric->bounds[b], get_varint(&r));
+            }
+            for (uint8_t b = 0; b <= bound_num; b++) {
+                TEST_ASSERT_EQUAL_UINT32(value.buckets[b], get_varint(&r));
+            }
+            TEST_ASSERT_EQUAL_UINT32(value.sum, get_varint(&r));
+        }
+    }
+    TEST_ASSERT_EQUAL_PTR(full + full_len, r.p);
+}
+
+#define HAMMER_THREADS  4
+#define HAMMER_LOOPS    1000000
+
+static void* hammer(void* arg)
+{
+    s_core = (uint8_t)(uintptr_t)arg % QMSD_METRICS_CORES;
+    for (uint32_t i = 0; i < HAMMER_LOOPS; i++) {
+        qmsd_metric_inc(&s_hammer);
+    }
+    return NULL;
+}
+
+TEST_CASE("concurrent updates are never lost", "[qmsd_metrics]")
+{
+    // two threads per slot: the add has to be atomic, not just per core
+    pthread_t threads[HAMMER_THREADS];
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uintptr_t i = 0; i < HAMMER_THREADS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, hammer, (void *)i));
+    }
+    for (int i = 0; i < HAMMER_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    qmsd_metric_value_t value;
+    qmsd_metric_read(&s_hammer, &value);
+    TEST_ASSERT_EQUAL_UINT32(HAMMER_THREADS * HAMMER_LOOPS, value.count);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / HAMMER_LOOPS;
+    printf("%d threads x %d increments: %.1f ns per increment per thread\n", HAMMER_THREADS, HAMMER_LOOPS, ns);
+}
@@ -1,5 +1,6 @@
 #include "qmsd_middleware_8ms.h"
 #include "qmsd_ctrl.h"
+#include "qmsd_wid.h"
 
 #define MASK_UNSED(x) (void)(x)
 
@@ -11,16 +12,15 @@ void lv_obj_qmsd_set_cb(struct _lv_obj_t *obj, lv_obj_qmsd_cb q_cb) {
 }
 
 void qmsd_screen_remove(const char *id) {
-    MASK_UNSED(id);
+    qmsd_wid_bind(qmsd_wid_lookup(id), NULL);
 }
 
 void qmsd_obj_set_id(lv_obj_t* obj, const char *id) {
-    MASK_UNSED(obj);
+    qmsd_wid_bind(qmsd_wid_intern(id), obj);
 }
 
 void qmsd_screen_register(lv_obj_t* obj,const char* id) {
-    MASK_UNSED(obj);
-    MASK_UNSED(id);
+    qmsd_wid_bind(qmsd_wid_intern(id), obj);
     lv_obj_qmsd_cb cb = obj->user_data;
     if(cb) {
         cb(obj, LV_EVENT_APPLY, NULL);
@@ -36,13 +36,11 @@ void qmsd_screen_print() {
 }
 
 lv_obj_t* qmsd_search_screen(const char *id) {
-    MASK_UNSED(id);
-    return NULL;
+    return qmsd_wid_get(qmsd_wid_lookup(id));
 }
 
 lv_obj_t* qmsd_search_widget(const char *id) {
-    MASK_UNSED(id);
-    return NULL;
+    return qmsd_wid_get(qmsd_wid_lookup(id));
 }
 
 void qmsd_set_screen(__qmsd_get_screen get_screen) {
@@ -0,0 +1,204 @@
+#include "string.h"
+#include "qmsd_ui_cmd.h"
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+} ui_reader_t;
+
+static bool put_bytes(qmsd_ui_enc_t* enc, const void* data, uint32_t n) {
+    if (enc->size - enc->len < n) {
+        return false;
+    }
+    memcpy(enc->buf + enc->len, data, n);
+    enc->len += n;
+    return true;
+}
+
+static bool put_u16(qmsd_ui_enc_t* enc, uint16_t v) {
+    uint8_t b[2] = {v & 0xff, v >> 8};
+    return put_bytes(enc, b, 2);
+}
+
+static bool put_varint(qmsd_ui_enc_t* enc, uint32_t v) {
+    uint8_t b[5];
+    uint8_t n = 0;
+    do {
+        b[n] = v & 0x7f;
+        v >>= 7;
+        b[n++] |= v ? 0x80 : 0;
+    } while (v);
+    return put_bytes(enc, b, n);
+}
+
+static bool put_head(qmsd_ui_enc_t* enc, uint8_t op, qmsd_wid_t wid) {
+    return put_bytes(enc, &op, 1) && put_u16(enc, wid);
+}
+
+// Keeps a command whole: on failure the batch goes back to where it was.
+static bool end_command(qmsd_ui_enc_t* enc, uint32_t start, bool ok) {
+    if (!ok || enc->count == UINT16_MAX) {
+        enc->len = start;
+        enc->overflow = true;
+        return false;
+    }
+    enc->count++;
+    return true;
+}
+
+void qmsd_ui_enc_init(qmsd_ui_enc_t* enc, uint8_t* buf, uint32_t size) {
+    enc->buf = buf;
+    enc->size = size;
+    enc->count = 0;
+    enc->overflow = false;
+    // a buffer without room for the header fails every command
+    enc->len = size < QMSD_UI_HEADER_SIZE ? size : QMSD_UI_HEADER_SIZE;
+}
+
+bool qmsd_ui_enc_text(qmsd_ui_enc_t* enc, qmsd_wid_t wid, const char* text) {
+    uint32_t start = enc->len;
+    uint32_t n = strlen(text) + 1;
+    return end_command(enc, start, put_head(enc, QMSD_UI_OP_TEXT, wid) && put_varint(enc, n) && put_bytes(enc, text, n));
+}
+
+bool qmsd_ui_enc_value(qmsd_ui_enc_t* enc, qmsd_wid_t wid, int32_t value) {
+    uint32_t start = enc->len;
+    uint32_t z = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    return end_command(enc, start, put_head(enc, QMSD_UI_OP_VALUE, wid) && put_varint(enc, z));
+}
+
+bool qmsd_ui_enc_style(qmsd_ui_enc_t* enc, qmsd_wid_t wid, uint16_t prop, uint32_t selector, uint32_t value) {
+    uint32_t start = enc->len;
+    return end_command(enc, start, put_head(enc, QMSD_UI_OP_STYLE, wid) && put_u16(enc, prop) &&
+                       put_varint(enc, selector) && put_varint(enc, value));
+}
+
+bool qmsd_ui_enc_event(qmsd_ui_enc_t* enc, qmsd_wid_t wid, uint8_t code) {
+    uint32_t start = enc->len;
+    return end_command(enc, start, put_head(enc, QMSD_UI_OP_EVENT, wid) && put_bytes(enc, &code, 1));
+}
+
+int qmsd_ui_enc_finish(qmsd_ui_enc_t* enc) {
+    if (enc->size < QMSD_UI_HEADER_SIZE) {
+        return -1;
+    }
+    enc->buf[0] = QMSD_UI_MAGIC;
+    enc->buf[1] = QMSD_UI_VERSION;
+    enc->buf[2] = enc->count & 0xff;
+    enc->buf[3] = enc->count >> 8;
+    return enc->len;
+}
+
+static bool get_u8(ui_reader_t* r, uint8_t* v) {
+    if (r->p >= r->end) {
+        return false;
+    }
+    *v = *r->p++;
+    return true;
+}
+
+static bool get_u16(ui_reader_t* r, uint16_t* v) {
+    if (r->end - r->p < 2) {
+        return false;
+    }
+    *v = r->p[0] | (r->p[1] << 8);
+    r->p += 2;
+    return true;
+}
+
+static bool get_varint(ui_reader_t* r, uint32_t* v) {
+    *v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        uint8_t b;
+        if (!get_u8(r, &b)) {
+            return false;
+        }
+        *v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// One command: checks it, and runs its op when ops is given.
+static int decode_command(ui_reader_t* r, const qmsd_ui_ops_t* ops, void* ctx) {
+    uint8_t op;
+    uint16_t wid;
+    if (!get_u8(r, &op) || !get_u16(r, &wid)) {
+        return QMSD_UI_ERR_TRUNCATED;
+    }
+    switch (op) {
+        case QMSD_UI_OP_TEXT: {
+            uint32_t n;
+            if (!get_varint(r, &n) || (uint32_t)(r->end - r->p) < n) {
+                return QMSD_UI_ERR_TRUNCATED;
+            }
+            if (n == 0 || r->p[n - 1] != '\0') {
+                return QMSD_UI_ERR_TEXT;
+            }
+            if (ops && ops->text) {
+                ops->text(ctx, wid, (const char *)r->p);
+            }
+            r->p += n;
+            break;
+        }
+        case QMSD_UI_OP_VALUE: {
+            uint32_t z;
+            if (!get_varint(r, &z)) {
+                return QMSD_UI_ERR_TRUNCATED;
+            }
+            if (ops && ops->value) {
+                ops->value(ctx, wid, (int32_t)(z >> 1) ^ -(int32_t)(z & 1));
+            }
+            break;
+        }
+        case QMSD_UI_OP_STYLE: {
+            uint16_t prop;
+            uint32_t selector, value;
+            if (!get_u16(r, &prop) || !get_varint(r, &selector) || !get_varint(r, &value)) {
+                return QMSD_UI_ERR_TRUNCATED;
+            }
+            if (ops && ops->style) {
+                ops->style(ctx, wid, prop, selector, value);
+            }
+            break;
+        }
+        case QMSD_UI_OP_EVENT: {
+            uint8_t code;
+            if (!get_u8(r, &code)) {
+                return QMSD_UI_ERR_TRUNCATED;
+            }
+            if (ops && ops->event) {
+                ops->event(ctx, wid, code);
+            }
+            break;
+        }
+        default:
+            return QMSD_UI_ERR_OP;
+    }
+    return 0;
+}
+
+static int decode_pass(const uint8_t* buf, uint32_t len, const qmsd_ui_ops_t* ops, void* ctx) {
+    if (len < QMSD_UI_HEADER_SIZE || buf[0] != QMSD_UI_MAGIC || buf[1] != QMSD_UI_VERSION) {
+        return QMSD_UI_ERR_HEADER;
+    }
+    uint16_t count = buf[2] | (buf[3] << 8);
+    ui_reader_t r = {buf + QMSD_UI_HEADER_SIZE, buf + len};
+    for (uint16_t i = 0; i < count; i++) {
+        int ret = decode_command(&r, ops, ctx);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    return r.p == r.end ? count : QMSD_UI_ERR_TRAILING;
+}
+
+int qmsd_ui_decode(const uint8_t* buf, uint32_t len, const qmsd_ui_ops_t* ops, void* ctx) {
+    int ret = decode_pass(buf, len, NULL, NULL);
+    if (ret <= 0 || ops == NULL) {
+        return ret;
+    }
+    return decode_pass(buf, len, ops, ctx);
+}
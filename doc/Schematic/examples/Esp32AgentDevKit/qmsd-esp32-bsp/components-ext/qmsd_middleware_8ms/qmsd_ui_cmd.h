@@ -0,0 +1,90 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "qmsd_wid.h"
+
+// Binary ui commands, the compact sibling of the json control strings. A
+// batch is built with the encoder by any task and applied in one go by the
+// gui side (qmsd_ui_ctrl.h), one lock for the whole batch:
+//
+//     uint8_t buf[128];
+//     qmsd_ui_enc_t enc;
+//     qmsd_ui_enc_init(&enc, buf, sizeof(buf));
+//     qmsd_ui_enc_text(&enc, UI_WID_Label5, "connected");
+//     qmsd_ui_enc_value(&enc, UI_WID_Bar1, 80);
+//     qmsd_ui_apply(buf, qmsd_ui_enc_finish(&enc));
+//
+// Layout, little endian, varints are LEB128, signed ones zigzag:
+//
+//   batch   magic u8 'U', version u8, count u16, count commands
+//   command op u8, wid u16, then by op
+//     TEXT  length varint (the terminating NUL included), the text and its NUL
+//     VALUE value zigzag varint
+//     STYLE prop u16 (QMSD_UI_STYLE_COLOR set: value is 0xRRGGBB), selector varint, value varint
+//     EVENT code u8
+//
+// Text is applied in place, without a copy, the trailing NUL is what allows it.
+
+#define QMSD_UI_MAGIC           0x55
+#define QMSD_UI_VERSION         1
+#define QMSD_UI_HEADER_SIZE     4
+#define QMSD_UI_STYLE_COLOR     0x8000
+
+typedef enum {
+    QMSD_UI_OP_TEXT = 1,
+    QMSD_UI_OP_VALUE,
+    QMSD_UI_OP_STYLE,
+    QMSD_UI_OP_EVENT,
+} qmsd_ui_op_t;
+
+enum {
+    QMSD_UI_ERR_HEADER = -1,
+    QMSD_UI_ERR_TRUNCATED = -2,
+    QMSD_UI_ERR_OP = -3,
+    QMSD_UI_ERR_TEXT = -4,                  // length 0 or no NUL where it ends
+    QMSD_UI_ERR_TRAILING = -5,
+};
+
+typedef struct {
+    uint8_t* buf;
+    uint32_t size;
+    uint32_t len;
+    uint16_t count;
+    bool overflow;                          // a command was dropped
+} qmsd_ui_enc_t;
+
+typedef struct {
+    void (*text)(void* ctx, qmsd_wid_t wid, const char* text);
+    void (*value)(void* ctx, qmsd_wid_t wid, int32_t value);
+    void (*style)(void* ctx, qmsd_wid_t wid, uint16_t prop, uint32_t selector, uint32_t value);
+    void (*event)(void* ctx, qmsd_wid_t wid, uint8_t code);
+} qmsd_ui_ops_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void qmsd_ui_enc_init(qmsd_ui_enc_t* enc, uint8_t* buf, uint32_t size);
+
+// A command that does not fit is dropped whole and false returned, the batch
+// so far stays valid: finish and apply it, then start over.
+bool qmsd_ui_enc_text(qmsd_ui_enc_t* enc, qmsd_wid_t wid, const char* text);
+
+bool qmsd_ui_enc_value(qmsd_ui_enc_t* enc, qmsd_wid_t wid, int32_t value);
+
+bool qmsd_ui_enc_style(qmsd_ui_enc_t* enc, qmsd_wid_t wid, uint16_t prop, uint32_t selector, uint32_t value);
+
+bool qmsd_ui_enc_event(qmsd_ui_enc_t* enc, qmsd_wid_t wid, uint8_t code);
+
+// Length of the batch, -1 when the buffer cannot hold even the header.
+int qmsd_ui_enc_finish(qmsd_ui_enc_t* enc);
+
+// Checks the whole batch before the first op runs, so a bad one applies
+// nothing. Returns the command count or a QMSD_UI_ERR_*. ops may be NULL to
+// only validate, a NULL op skips its commands.
+int qmsd_ui_decode(const uint8_t* buf, uint32_t len, const qmsd_ui_ops_t* ops, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
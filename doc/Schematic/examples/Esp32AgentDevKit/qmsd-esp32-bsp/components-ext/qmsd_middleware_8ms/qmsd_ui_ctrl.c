@@ -0,0 +1,286 @@
+#include "string.h"
+#include "stdlib.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "qmsd_gui.h"
+#include "qmsd_type.h"
+#include "qmsd_mem.h"
+#include "qmsd_metrics.h"
+#include "qmsd_ui_ctrl.h"
+
+#define TAG "QMSD_UI"
+
+QMSD_METRIC_COUNTER(s_ui_batches, "ui.batches");
+QMSD_METRIC_COUNTER(s_ui_cmds, "ui.cmds");
+QMSD_METRIC_COUNTER(s_ui_missing, "ui.missing");
+QMSD_METRIC_HISTOGRAM(s_ui_apply_us, "ui.apply_us", 100, 500, 2000, 10000);
+
+typedef struct {
+    const char* name;
+    uint16_t prop;                          // lv_style_prop_t, QMSD_UI_STYLE_COLOR for colors
+} style_name_t;
+
+typedef struct {
+    const char* name;
+    uint8_t code;
+} event_name_t;
+
+static const style_name_t g_style_names[] = {
+    {"bg_color", LV_STYLE_BG_COLOR | QMSD_UI_STYLE_COLOR},
+    {"bg_opa", LV_STYLE_BG_OPA},
+    {"text_color", LV_STYLE_TEXT_COLOR | QMSD_UI_STYLE_COLOR},
+    {"text_opa", LV_STYLE_TEXT_OPA},
+    {"border_color", LV_STYLE_BORDER_COLOR | QMSD_UI_STYLE_COLOR},
+    {"border_width", LV_STYLE_BORDER_WIDTH},
+    {"img_recolor", LV_STYLE_IMG_RECOLOR | QMSD_UI_STYLE_COLOR},
+    {"img_recolor_opa", LV_STYLE_IMG_RECOLOR_OPA},
+    {"radius", LV_STYLE_RADIUS},
+    {"opa", LV_STYLE_OPA},
+    {"x", LV_STYLE_X},
+    {"y", LV_STYLE_Y},
+    {"width", LV_STYLE_WIDTH},
+    {"height", LV_STYLE_HEIGHT},
+};
+
+static const event_name_t g_event_names[] = {
+    {"pressed", LV_EVENT_PRESSED},
+    {"released", LV_EVENT_RELEASED},
+    {"clicked", LV_EVENT_CLICKED},
+    {"long_pressed", LV_EVENT_LONG_PRESSED},
+    {"value_changed", LV_EVENT_VALUE_CHANGED},
+    {"focused", LV_EVENT_FOCUSED},
+    {"defocused", LV_EVENT_DEFOCUSED},
+    {"ready", LV_EVENT_READY},
+    {"cancel", LV_EVENT_CANCEL},
+};
+
+static lv_obj_t* ui_obj(qmsd_wid_t wid) {
+    lv_obj_t* obj = qmsd_wid_get(wid);
+    if (obj == NULL) {
+        qmsd_metric_inc(&s_ui_missing);
+    }
+    return obj;
+}
+
+static void ui_text(void* ctx, qmsd_wid_t wid, const char* text) {
+    lv_obj_t* obj = ui_obj(wid);
+    if (obj == NULL) {
+        return;
+    }
+    if (lv_obj_check_type(obj, &lv_label_class)) {
+        lv_label_set_text(obj, text);
+    } else if (lv_obj_check_type(obj, &lv_textarea_class)) {
+        lv_textarea_set_text(obj, text);
+    }
+}
+
+static void ui_value(void* ctx, qmsd_wid_t wid, int32_t value) {
+    lv_obj_t* obj = ui_obj(wid);
+    if (obj == NULL) {
+        return;
+    }
+    if (lv_obj_check_type(obj, &lv_slider_class)) {
+        lv_slider_set_value(obj, value, LV_ANIM_OFF);
+    } else if (lv_obj_check_type(obj, &lv_bar_class)) {
+        lv_bar_set_value(obj, value, LV_ANIM_OFF);
+    } else if (lv_obj_check_type(obj, &lv_arc_class)) {
+        lv_arc_set_value(obj, value);
+    } else if (lv_obj_check_type(obj, &lv_dropdown_class)) {
+        lv_dropdown_set_selected(obj, value);
+    } else if (lv_obj_check_type(obj, &lv_roller_class)) {
+        lv_roller_set_selected(obj, value, LV_ANIM_OFF);
+    } else if (lv_obj_check_type(obj, &lv_switch_class) || lv_obj_check_type(obj, &lv_checkbox_class)) {
+        if (value) {
+            lv_obj_add_state(obj, LV_STATE_CHECKED);
+        } else {
+            lv_obj_clear_state(obj, LV_STATE_CHECKED);
+        }
+    }
+}
+
+static void ui_style(void* ctx, qmsd_wid_t wid, uint16_t prop, uint32_t selector, uint32_t value) {
+    lv_obj_t* obj = ui_obj(wid);
+    if (obj == NULL) {
+        return;
+    }
+    lv_style_value_t v;
+    if (prop & QMSD_UI_STYLE_COLOR) {
+        v.color = lv_color_hex(value);
+    } else {
+        v.num = (int32_t)value;
+    }
+    lv_obj_set_local_style_prop(obj, prop & ~QMSD_UI_STYLE_COLOR, v, selector);
+}
+
+static void ui_event(void* ctx, qmsd_wid_t wid, uint8_t code) {
+    lv_obj_t* obj = ui_obj(wid);
+    if (obj != NULL) {
+        lv_event_send(obj, code, NULL);
+    }
+}
+
+static const qmsd_ui_ops_t g_ui_ops = {
+    .text = ui_text,
+    .value = ui_value,
+    .style = ui_style,
+    .event = ui_event,
+};
+
+static void ui_delete_cb(lv_event_t* e) {
+    qmsd_wid_unbind(lv_event_get_target(e));
+}
+
+void qmsd_ui_bind(qmsd_wid_t wid, lv_obj_t* obj) {
+    if (wid == QMSD_WID_NONE) {
+        return;
+    }
+    lv_obj_t* old = qmsd_wid_get(wid);
+    if (old == obj) {
+        return;
+    }
+    if (old) {
+        lv_obj_remove_event_cb(old, ui_delete_cb);
+    }
+    qmsd_wid_bind(wid, obj);
+    if (obj) {
+        lv_obj_add_event_cb(obj, ui_delete_cb, LV_EVENT_DELETE, NULL);
+    }
+}
+
+int qmsd_ui_apply_gui(const uint8_t* buf, uint32_t len) {
+    int64_t t = esp_timer_get_time();
+    int count = qmsd_ui_decode(buf, len, &g_ui_ops, NULL);
+    if (count < 0) {
+        ESP_LOGW(TAG, "bad batch of %lu bytes: %d", (unsigned long)len, count);
+        return count;
+    }
+    qmsd_metric_observe(&s_ui_apply_us, esp_timer_get_time() - t);
+    qmsd_metric_inc(&s_ui_batches);
+    qmsd_metric_add(&s_ui_cmds, count);
+    return count;
+}
+
+int qmsd_ui_apply(const uint8_t* buf, uint32_t len) {
+    // a bad batch never takes the lock
+    int count = qmsd_ui_decode(buf, len, NULL, NULL);
+    if (count <= 0) {
+        return count;
+    }
+    if (qmsd_gui_lock(portMAX_DELAY) != 0) {
+        return QMSD_UI_ERR_HEADER;
+    }
+    count = qmsd_ui_apply_gui(buf, len);
+    qmsd_gui_unlock();
+    return count;
+}
+
+static bool json_uint(const cJSON* item, uint32_t* value) {
+    if (cJSON_IsNumber(item)) {
+        *value = (uint32_t)item->valuedouble;
+        return true;
+    }
+    // colors as "#rrggbb" or "0xrrggbb"
+    if (cJSON_IsString(item)) {
+        const char* s = item->valuestring[0] == '#' ? item->valuestring + 1 : item->valuestring;
+        char* end = NULL;
+        *value = strtoul(s, &end, 16);
+        return end != s && *end == '\0';
+    }
+    return false;
+}
+
+static void json_set_status(qmsd_ui_enc_t* enc, qmsd_wid_t wid, const cJSON* attr) {
+    const cJSON* text = cJSON_GetObjectItem(attr, "text");
+    const cJSON* value = cJSON_GetObjectItem(attr, "value");
+    const cJSON* checked = cJSON_GetObjectItem(attr, "checked");
+    if (cJSON_IsString(text)) {
+        qmsd_ui_enc_text(enc, wid, text->valuestring);
+    }
+    if (cJSON_IsNumber(value)) {
+        qmsd_ui_enc_value(enc, wid, value->valueint);
+    }
+    if (cJSON_IsBool(checked)) {
+        qmsd_ui_enc_value(enc, wid, cJSON_IsTrue(checked));
+    }
+}
+
+static void json_set_style(qmsd_ui_enc_t* enc, qmsd_wid_t wid, const cJSON* attr) {
+    uint32_t selector = 0;
+    json_uint(cJSON_GetObjectItem(attr, "selector"), &selector);
+    for (uint32_t i = 0; i < sizeof(g_style_names) / sizeof(g_style_names[0]); i++) {
+        uint32_t value;
+        if (json_uint(cJSON_GetObjectItem(attr, g_style_names[i].name), &value)) {
+            qmsd_ui_enc_style(enc, wid, g_style_names[i].prop, selector, value);
+        }
+    }
+}
+
+static void json_send_event(qmsd_ui_enc_t* enc, qmsd_wid_t wid, const cJSON* attr) {
+    const cJSON* event = cJSON_GetObjectItem(attr, QMSD_CTRL_EVENT_NAME);
+    if (cJSON_IsNumber(event)) {
+        qmsd_ui_enc_event(enc, wid, event->valueint);
+        return;
+    }
+    for (uint32_t i = 0; cJSON_IsString(event) && i < sizeof(g_event_names) / sizeof(g_event_names[0]); i++) {
+        if (strcmp(event->valuestring, g_event_names[i].name) == 0) {
+            qmsd_ui_enc_event(enc, wid, g_event_names[i].code);
+            return;
+        }
+    }
+}
+
+static void json_encode(qmsd_ui_enc_t* enc, const cJSON* item) {
+    const cJSON* wid_item = cJSON_GetObjectItem(item, QMSD_CTRL_WID_NAME);
+    const cJSON* cmd = cJSON_GetObjectItem(item, QMSD_CTRL_CMD_NAME);
+    const cJSON* attr = cJSON_GetObjectItem(item, QMSD_CTRL_ATTR_NAME);
+    if (!cJSON_IsString(wid_item) || !cJSON_IsString(cmd) || !cJSON_IsObject(attr)) {
+        return;
+    }
+    qmsd_wid_t wid = qmsd_wid_lookup(wid_item->valuestring);
+    if (wid == QMSD_WID_NONE) {
+        qmsd_metric_inc(&s_ui_missing);
+        return;
+    }
+    if (strcmp(cmd->valuestring, QMSD_CTRL_CMD_SET_NAME) == 0) {
+        json_set_status(enc, wid, attr);
+    } else if (strcmp(cmd->valuestring, QMSD_CTRL_CMD_SET_STYLE) == 0) {
+        json_set_style(enc, wid, attr);
+    } else if (strcmp(cmd->valuestring, QMSD_CTRL_CMD_SEND_EVENT) == 0) {
+        json_send_event(enc, wid, attr);
+    }
+}
+
+int qmsd_ui_json(const char* json_str) {
+    int ret = QMSD_UI_ERR_HEADER;
+    uint8_t* buf = NULL;
+    cJSON* root = cJSON_Parse(json_str);
+    if (root == NULL) {
+        goto qmsd_ui_json_error;
+    }
+    // every attr is a key and a value in json, at most twice its size in binary
+    uint32_t size = 2 * strlen(json_str) + QMSD_UI_HEADER_SIZE;
+    buf = qmsd_mem_malloc(QMSD_MEM_TAG_GUI, size, 0);
+    if (buf == NULL) {
+        goto qmsd_ui_json_error;
+    }
+    qmsd_ui_enc_t enc;
+    qmsd_ui_enc_init(&enc, buf, size);
+    if (cJSON_IsArray(root)) {
+        const cJSON* item;
+        cJSON_ArrayForEach(item, root) {
+            json_encode(&enc, item);
+        }
+    } else {
+        json_encode(&enc, root);
+    }
+    ret = qmsd_ui_apply(buf, qmsd_ui_enc_finish(&enc));
+
+qmsd_ui_json_error:
+    if (buf) {
+        qmsd_mem_free(buf);
+    }
+    cJSON_Delete(root);
+    return ret;
+}
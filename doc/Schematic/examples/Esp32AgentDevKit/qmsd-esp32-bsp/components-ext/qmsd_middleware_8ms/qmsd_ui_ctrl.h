@@ -0,0 +1,43 @@
+#pragma once
+
+#include "stdint.h"
+#include "lvgl.h"
+#include "qmsd_wid.h"
+#include "qmsd_ui_cmd.h"
+
+// Applies qmsd_ui_cmd batches to lvgl v8 objects. Objects are bound to their
+// wid once (tools/wid_gen.py emits the bind_all for the generated ui), a
+// deleted object unbinds itself. Commands for unbound wids are counted under
+// ui.missing and skipped, the rest of the batch still applies.
+//
+// VALUE sets the slider, bar, arc, dropdown or roller value, on a switch or
+// checkbox it sets the checked state. STYLE sets a local style property, EVENT
+// sends the lv_event_code_t.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void qmsd_ui_bind(qmsd_wid_t wid, lv_obj_t* obj);
+
+// From any task, takes the gui lock once for the whole batch. Returns the
+// command count or a QMSD_UI_ERR_*.
+int qmsd_ui_apply(const uint8_t* buf, uint32_t len);
+
+// From the gui task, or with the lock held.
+int qmsd_ui_apply_gui(const uint8_t* buf, uint32_t len);
+
+// The json control strings, translated to one batch and applied like it:
+//
+//     {"wid": "ui_Label5", "cmd": "set_status", "attr": {"text": "connected"}}
+//     {"wid": "ui_Slider1", "cmd": "set_status", "attr": {"value": 80}}
+//     {"wid": "ui_Label5", "cmd": "set_style", "attr": {"text_color": "#ff0000", "selector": 0}}
+//     {"wid": "ui_Button1", "cmd": "send_event", "attr": {"event": "clicked"}}
+//
+// or an array of them. Returns the command count or a QMSD_UI_ERR_*, unknown
+// wids and attrs are skipped.
+int qmsd_ui_json(const char* json_str);
+
+#ifdef __cplusplus
+}
+#endif
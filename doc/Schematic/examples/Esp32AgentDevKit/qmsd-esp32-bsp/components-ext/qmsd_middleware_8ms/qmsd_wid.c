@@ -0,0 +1,231 @@
+#include "stdlib.h"
+#include "string.h"
+#include "qmsd_wid.h"
+
+#define WID_SEEDS           256
+#define WID_DISP_MAX        0xffff
+#define WID_EMPTY           0xffff
+
+_Static_assert((QMSD_WID_DYNAMIC & (QMSD_WID_DYNAMIC - 1)) == 0, "dynamic table must be a power of two");
+
+static const qmsd_wid_table_t* g_table = NULL;
+static void* g_objs[QMSD_WID_MAX];
+static char* g_dyn_names[QMSD_WID_DYNAMIC];
+static uint16_t g_dyn_slots[QMSD_WID_DYNAMIC];  // hash slot -> dynamic index + 1, 0 when empty
+static uint16_t g_dyn_num = 0;
+
+// build scratch, the builder runs once per table
+static uint32_t g_build_hash[QMSD_WID_MAX];
+static uint16_t g_build_bucket_size[QMSD_WID_BUCKETS(QMSD_WID_MAX)];
+
+uint32_t qmsd_wid_hash(const char* name, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// murmur3 finalizer over the name hash and the bucket's displacement
+static uint32_t wid_mix(uint32_t h, uint16_t d) {
+    h ^= d * 0x9e3779b9u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static bool place_bucket(uint16_t bucket, uint16_t num, uint16_t bucket_mask, uint16_t slot_mask, uint16_t* disp, uint16_t* slots) {
+    for (uint32_t d = 1; d <= WID_DISP_MAX; d++) {
+        uint16_t placed = 0;
+        bool fits = true;
+        for (uint16_t i = 0; i < num && fits; i++) {
+            if ((wid_mix(g_build_hash[i], 0) & bucket_mask) != bucket) {
+                continue;
+            }
+            uint16_t slot = wid_mix(g_build_hash[i], d) & slot_mask;
+            if (slots[slot] != WID_EMPTY) {
+                fits = false;
+                break;
+            }
+            slots[slot] = i;
+            placed++;
+        }
+        if (fits) {
+            disp[bucket] = d;
+            return true;
+        }
+        // undo this try: the slots taken by the bucket's names
+        for (uint16_t i = 0; i < num && placed; i++) {
+            if ((wid_mix(g_build_hash[i], 0) & bucket_mask) != bucket) {
+                continue;
+            }
+            uint16_t slot = wid_mix(g_build_hash[i], d) & slot_mask;
+            if (slots[slot] == i) {
+                slots[slot] = WID_EMPTY;
+                placed--;
+            }
+        }
+    }
+    return false;
+}
+
+static bool try_build(uint32_t seed, const char* const* names, uint16_t num, uint16_t* disp, uint16_t* slots) {
+    uint16_t buckets = QMSD_WID_BUCKETS(num);
+    uint16_t size = QMSD_WID_SLOTS(num);
+    uint16_t largest = 0;
+
+    memset(g_build_bucket_size, 0, sizeof(g_build_bucket_size));
+    for (uint16_t i = 0; i < num; i++) {
+        g_build_hash[i] = qmsd_wid_hash(names[i], seed);
+        uint16_t b = wid_mix(g_build_hash[i], 0) & (buckets - 1);
+        if (++g_build_bucket_size[b] > largest) {
+            largest = g_build_bucket_size[b];
+        }
+    }
+    memset(disp, 0, buckets * sizeof(uint16_t));
+    memset(slots, 0xff, size * sizeof(uint16_t));
+    // largest buckets first, while the table is still empty
+    for (uint16_t n = largest; n > 0; n--) {
+        for (uint16_t b = 0; b < buckets; b++) {
+            if (g_build_bucket_size[b] == n && !place_bucket(b, num, buckets - 1, size - 1, disp, slots)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int qmsd_wid_build(const char* const* names, uint16_t num, uint16_t* disp, uint16_t* slots, qmsd_wid_table_t* table) {
+    if (num == 0 || num > QMSD_WID_MAX) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < num; i++) {
+        for (uint16_t j = i + 1; j < num; j++) {
+            if (strcmp(names[i], names[j]) == 0) {
+                return -1;
+            }
+        }
+    }
+    for (uint32_t seed = 0; seed < WID_SEEDS; seed++) {
+        if (try_build(seed, names, num, disp, slots)) {
+            table->seed = seed;
+            table->num = num;
+            table->bucket_mask = QMSD_WID_BUCKETS(num) - 1;
+            table->slot_mask = QMSD_WID_SLOTS(num) - 1;
+            table->disp = disp;
+            table->slots = slots;
+            table->names = names;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+qmsd_wid_t qmsd_wid_table_lookup(const qmsd_wid_table_t* table, const char* name) {
+    uint32_t h = qmsd_wid_hash(name, table->seed);
+    uint16_t d = table->disp[wid_mix(h, 0) & table->bucket_mask];
+    qmsd_wid_t wid = table->slots[wid_mix(h, d) & table->slot_mask];
+    if (wid == QMSD_WID_NONE || strcmp(table->names[wid], name) != 0) {
+        return QMSD_WID_NONE;
+    }
+    return wid;
+}
+
+static uint16_t static_num(void) {
+    return g_table ? g_table->num : 0;
+}
+
+void qmsd_wid_set_table(const qmsd_wid_table_t* table) {
+    for (uint16_t i = 0; i < g_dyn_num; i++) {
+        free(g_dyn_names[i]);
+        g_dyn_names[i] = NULL;
+    }
+    g_dyn_num = 0;
+    memset(g_dyn_slots, 0, sizeof(g_dyn_slots));
+    memset(g_objs, 0, sizeof(g_objs));
+    g_table = table;
+}
+
+// Dynamic slot holding name, or the empty one it would go to.
+static uint16_t dyn_probe(const char* name) {
+    uint16_t slot = qmsd_wid_hash(name, 0) & (QMSD_WID_DYNAMIC - 1);
+    for (uint16_t n = 0; n < QMSD_WID_DYNAMIC; n++) {
+        uint16_t index = g_dyn_slots[slot];
+        if (index == 0 || strcmp(g_dyn_names[index - 1], name) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & (QMSD_WID_DYNAMIC - 1);
+    }
+    return WID_EMPTY;
+}
+
+qmsd_wid_t qmsd_wid_lookup(const char* name) {
+    if (name == NULL) {
+        return QMSD_WID_NONE;
+    }
+    if (g_table) {
+        qmsd_wid_t wid = qmsd_wid_table_lookup(g_table, name);
+        if (wid != QMSD_WID_NONE) {
+            return wid;
+        }
+    }
+    if (g_dyn_num == 0) {
+        return QMSD_WID_NONE;
+    }
+    uint16_t slot = dyn_probe(name);
+    if (slot == WID_EMPTY || g_dyn_slots[slot] == 0) {
+        return QMSD_WID_NONE;
+    }
+    return static_num() + g_dyn_slots[slot] - 1;
+}
+
+qmsd_wid_t qmsd_wid_intern(const char* name) {
+    qmsd_wid_t wid = qmsd_wid_lookup(name);
+    if (wid != QMSD_WID_NONE || name == NULL) {
+        return wid;
+    }
+    if (g_dyn_num >= QMSD_WID_DYNAMIC || static_num() + g_dyn_num >= QMSD_WID_MAX) {
+        return QMSD_WID_NONE;
+    }
+    uint16_t slot = dyn_probe(name);
+    char* copy = strdup(name);
+    if (slot == WID_EMPTY || copy == NULL) {
+        free(copy);
+        return QMSD_WID_NONE;
+    }
+    g_dyn_names[g_dyn_num] = copy;
+    g_dyn_slots[slot] = g_dyn_num + 1;
+    return static_num() + g_dyn_num++;
+}
+
+const char* qmsd_wid_name(qmsd_wid_t wid) {
+    if (wid < static_num()) {
+        return g_table->names[wid];
+    }
+    if (wid != QMSD_WID_NONE && wid - static_num() < g_dyn_num) {
+        return g_dyn_names[wid - static_num()];
+    }
+    return NULL;
+}
+
+void qmsd_wid_bind(qmsd_wid_t wid, void* obj) {
+    if (wid < QMSD_WID_MAX) {
+        g_objs[wid] = obj;
+    }
+}
+
+void* qmsd_wid_get(qmsd_wid_t wid) {
+    return wid < QMSD_WID_MAX ? g_objs[wid] : NULL;
+}
+
+void qmsd_wid_unbind(void* obj) {
+    for (uint16_t i = 0; i < QMSD_WID_MAX; i++) {
+        if (g_objs[i] == obj) {
+            g_objs[i] = NULL;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Widget registry. Widget ids are interned to small integers (qmsd_wid_t)
+// and objects are kept in an array indexed by them, so resolving a bound id
+// is one load. Names known at build time go through a perfect hash table that
+// tools/wid_gen.py generates from the ui headers: one pass over the name, one
+// integer mix, one strcmp to confirm. Names first seen at runtime
+// (qmsd_obj_set_id) are interned after the static ones in a small open
+// addressing table.
+//
+// Lookups of static names are safe from any task. Interning and binding are
+// for the gui task, or before it starts.
+
+#define QMSD_WID_NONE           0xffff
+#define QMSD_WID_MAX            256         // static and dynamic ids together
+#define QMSD_WID_DYNAMIC        64          // runtime interned names, power of two
+
+// Storage the table needs for num names, constant for a constant num.
+#define QMSD_WID_BUCKETS(num)   QMSD_WID_POW2(((num) + 3) / 4)
+#define QMSD_WID_SLOTS(num)     QMSD_WID_POW2(num)
+#define QMSD_WID_POW2(n)        ((n) <= 1 ? 1 : (n) <= 2 ? 2 : (n) <= 4 ? 4 : (n) <= 8 ? 8 : (n) <= 16 ? 16 : \
+                                 (n) <= 32 ? 32 : (n) <= 64 ? 64 : (n) <= 128 ? 128 : 256)
+
+typedef uint16_t qmsd_wid_t;
+
+typedef struct {
+    uint32_t seed;
+    uint16_t num;
+    uint16_t bucket_mask;
+    uint16_t slot_mask;
+    const uint16_t* disp;                   // per bucket displacement
+    const uint16_t* slots;                  // slot -> wid, QMSD_WID_NONE when empty
+    const char* const* names;               // wid -> name
+} qmsd_wid_table_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t qmsd_wid_hash(const char* name, uint32_t seed);
+
+// Builds a table over names at runtime, the same one wid_gen.py emits. disp
+// and slots hold QMSD_WID_BUCKETS(num) and QMSD_WID_SLOTS(num) entries and
+// must outlive the table. Fails on duplicate names.
+int qmsd_wid_build(const char* const* names, uint16_t num, uint16_t* disp, uint16_t* slots, qmsd_wid_table_t* table);
+
+qmsd_wid_t qmsd_wid_table_lookup(const qmsd_wid_table_t* table, const char* name);
+
+// Replaces the static table, drops every binding and dynamic name.
+void qmsd_wid_set_table(const qmsd_wid_table_t* table);
+
+// Static names, then dynamic ones.
+qmsd_wid_t qmsd_wid_lookup(const char* name);
+
+// Like lookup, a name seen for the first time gets a dynamic id.
+qmsd_wid_t qmsd_wid_intern(const char* name);
+
+const char* qmsd_wid_name(qmsd_wid_t wid);
+
+void qmsd_wid_bind(qmsd_wid_t wid, void* obj);
+
+// The object bound to wid, NULL when none.
+void* qmsd_wid_get(qmsd_wid_t wid);
+
+// Clears every binding to obj, for its delete hook.
+void qmsd_wid_unbind(void* obj);
+
+#ifdef __cplusplus
+}
+#endif
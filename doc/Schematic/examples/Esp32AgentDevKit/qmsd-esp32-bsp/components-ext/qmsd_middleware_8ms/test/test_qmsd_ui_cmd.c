@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "qmsd_wid.h"
+#include "qmsd_ui_cmd.h"
+
+// the names of main/ui_code/ui.h and the table tools/wid_gen.py made of them (main/ui_wid.c)
+static const char* const g_ui_names[] = {
+    "ui_Screen1", "ui_Image1", "ui_Button1", "ui_Label1", "ui_Label2", "ui_configwifi", "ui_TextArea1",
+    "ui_TextArea2", "ui_Label3", "ui_Label4", "ui_Keyboard1", "ui_Button3", "ui_Label5", "ui____initial_actions0",
+};
+static const uint16_t g_gen_disp[] = {4, 8, 2, 10};
+static const uint16_t g_gen_slots[] = {10, 0xffff, 9, 5, 4, 12, 3, 0, 11, 1, 0xffff, 7, 6, 2, 13, 8};
+
+#define UI_NUM      (sizeof(g_ui_names) / sizeof(g_ui_names[0]))
+#define BENCH_NUM   200
+#define BENCH_LOOPS 1000000
+
+static double elapsed_ns(const struct timespec* t0, const struct timespec* t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+TEST_CASE("runtime build matches the generated table", "[qmsd_wid]")
+{
+    uint16_t disp[QMSD_WID_BUCKETS(UI_NUM)], slots[QMSD_WID_SLOTS(UI_NUM)];
+    qmsd_wid_table_t table;
+    TEST_ASSERT_EQUAL_INT(0, qmsd_wid_build(g_ui_names, UI_NUM, disp, slots, &table));
+    TEST_ASSERT_EQUAL_UINT32(0, table.seed);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(g_gen_disp) / sizeof(g_gen_disp[0]) - 1, table.bucket_mask);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(g_gen_slots) / sizeof(g_gen_slots[0]) - 1, table.slot_mask);
+    TEST_ASSERT_EQUAL_MEMORY(g_gen_disp, disp, sizeof(g_gen_disp));
+    TEST_ASSERT_EQUAL_MEMORY(g_gen_slots, slots, sizeof(g_gen_slots));
+
+    for (uint16_t i = 0; i < UI_NUM; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, qmsd_wid_table_lookup(&table, g_ui_names[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT16(QMSD_WID_NONE, qmsd_wid_table_lookup(&table, "ui_Label6"));
+    TEST_ASSERT_EQUAL_UINT16(QMSD_WID_NONE, qmsd_wid_table_lookup(&table, ""));
+
+    const char* const dup[] = {"a", "b", "a"};
+    TEST_ASSERT_EQUAL_INT(-1, qmsd_wid_build(dup, 3, disp, slots, &table));
+}
+
+TEST_CASE("dynamic names follow the static ones and bindings resolve", "[qmsd_wid]")
+{
+    static uint16_t disp[QMSD_WID_BUCKETS(UI_NUM)], slots[QMSD_WID_SLOTS(UI_NUM)];
+    static qmsd_wid_table_t table;
+    TEST_ASSERT_EQUAL_INT(0, qmsd_wid_build(g_ui_names, UI_NUM, disp, slots, &table));
+    qmsd_wid_set_table(&table);
+
+    qmsd_wid_t label5 = qmsd_wid_lookup("ui_Label5");
+    TEST_ASSERT_EQUAL_UINT16(12, label5);
+    TEST_ASSERT_EQUAL_UINT16(label5, qmsd_wid_intern("ui_Label5"));
+    TEST_ASSERT_EQUAL_UINT16(QMSD_WID_NONE, qmsd_wid_lookup("status_bar"));
+    qmsd_wid_t bar = qmsd_wid_intern("status_bar");
+    TEST_ASSERT_EQUAL_UINT16(UI_NUM, bar);
+    TEST_ASSERT_EQUAL_UINT16(UI_NUM + 1, qmsd_wid_intern("volume"));
+    TEST_ASSERT_EQUAL_UINT16(bar, qmsd_wid_lookup("status_bar"));
+    TEST_ASSERT_EQUAL_STRING("status_bar", qmsd_wid_name(bar));
+    TEST_ASSERT_EQUAL_STRING("ui_Label5", qmsd_wid_name(label5));
+    TEST_ASSERT_NULL(qmsd_wid_name(UI_NUM + 2));
+
+    int obj_a, obj_b;
+    qmsd_wid_bind(label5, &obj_a);
+    qmsd_wid_bind(bar, &obj_b);
+    qmsd_wid_bind(0, &obj_a);
+    TEST_ASSERT_EQUAL_PTR(&obj_a, qmsd_wid_get(label5));
+    TEST_ASSERT_EQUAL_PTR(&obj_b, qmsd_wid_get(bar));
+    TEST_ASSERT_NULL(qmsd_wid_get(QMSD_WID_NONE));
+    qmsd_wid_unbind(&obj_a);
+    TEST_ASSERT_NULL(qmsd_wid_get(label5));
+    TEST_ASSERT_NULL(qmsd_wid_get(0));
+    TEST_ASSERT_EQUAL_PTR(&obj_b, qmsd_wid_get(bar));
+
+    // a new table starts over
+    qmsd_wid_set_table(&table);
+    TEST_ASSERT_NULL(qmsd_wid_get(bar));
+    TEST_ASSERT_EQUAL_UINT16(QMSD_WID_NONE, qmsd_wid_lookup("status_bar"));
+    for (uint16_t i = 0; i < QMSD_WID_DYNAMIC; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "dyn%u", i);
+        TEST_ASSERT_EQUAL_UINT16(UI_NUM + i, qmsd_wid_intern(name));
+    }
+    TEST_ASSERT_EQUAL_UINT16(QMSD_WID_NONE, qmsd_wid_intern("one_too_many"));
+    TEST_ASSERT_EQUAL_UINT16(UI_NUM + 7, qmsd_wid_lookup("dyn7"));
+    qmsd_wid_set_table(NULL);
+}
+
+typedef struct {
+    char log[256];
+    uint32_t n;
+} recorder_t;
+
+static void rec_text(void* ctx, qmsd_wid_t wid, const char* text)
+{
+    recorder_t* r = (recorder_t *)ctx;
+    r->n += snprintf(r->log + r->n, sizeof(r->log) - r->n, "T%u:%s;", wid, text);
+}
+
+static void rec_value(void* ctx, qmsd_wid_t wid, int32_t value)
+{
+    recorder_t* r = (recorder_t *)ctx;
+    r->n += snprintf(r->log + r->n, sizeof(r->log) - r->n, "V%u:%d;", wid, (int)value);
+}
+
+static void rec_style(void* ctx, qmsd_wid_t wid, uint16_t prop, uint32_t selector, uint32_t value)
+{
+    recorder_t* r = (recorder_t *)ctx;
+    r->n += snprintf(r->log + r->n, sizeof(r->log) - r->n, "S%u:%x/%x=%x;", wid, prop, (unsigned)selector, (unsigned)value);
+}
+
+static void rec_event(void* ctx, qmsd_wid_t wid, uint8_t code)
+{
+    recorder_t* r = (recorder_t *)ctx;
+    r->n += snprintf(r->log + r->n, sizeof(r->log) - r->n, "E%u:%u;", wid, code);
+}
+
+static const qmsd_ui_ops_t g_rec_ops = {rec_text, rec_value, rec_style, rec_event};
+
+TEST_CASE("batches round trip every op", "[qmsd_ui_cmd]")
+{
+    uint8_t buf[128];
+    qmsd_ui_enc_t enc;
+    qmsd_ui_enc_init(&enc, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(qmsd_ui_enc_text(&enc, 12, "connected"));
+    TEST_ASSERT_TRUE(qmsd_ui_enc_value(&enc, 3, -70000));
+    TEST_ASSERT_TRUE(qmsd_ui_enc_value(&enc, 3, 80));
+    TEST_ASSERT_TRUE(qmsd_ui_enc_style(&enc, 300, 0x20 | QMSD_UI_STYLE_COLOR, 0x20000, 0xff8000));
+    TEST_ASSERT_TRUE(qmsd_ui_enc_event(&enc, 2, 7));
+    TEST_ASSERT_TRUE(qmsd_ui_enc_text(&enc, 4, ""));
+    int len = qmsd_ui_enc_finish(&enc);
+    TEST_ASSERT_FALSE(enc.overflow);
+    // header 4, text 3+1+10, values 3+3 and 3+2 (zigzag 160), style 3+2+3+4, event 3+1, empty text 3+1+1
+    TEST_ASSERT_EQUAL_INT(4 + 14 + 6 + 5 + 12 + 4 + 5, len);
+
+    recorder_t rec = {{0}, 0};
+    TEST_ASSERT_EQUAL_INT(6, qmsd_ui_decode(buf, len, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(6, qmsd_ui_decode(buf, len, &g_rec_ops, &rec));
+    TEST_ASSERT_EQUAL_STRING("T12:connected;V3:-70000;V3:80;S300:8020/20000=ff8000;E2:7;T4:;", rec.log);
+
+    // ops left NULL skip their commands
+    qmsd_ui_ops_t text_only = {rec_text, NULL, NULL, NULL};
+    rec.n = 0;
+    TEST_ASSERT_EQUAL_INT(6, qmsd_ui_decode(buf, len, &text_only, &rec));
+    TEST_ASSERT_EQUAL_STRING("T12:connected;T4:;", rec.log);
+}
+
+TEST_CASE("a command that does not fit is dropped whole", "[qmsd_ui_cmd]")
+{
+    uint8_t buf[16];
+    qmsd_ui_enc_t enc;
+    qmsd_ui_enc_init(&enc, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(qmsd_ui_enc_value(&enc, 1, 5));
+    TEST_ASSERT_FALSE(qmsd_ui_enc_text(&enc, 2, "far too long to fit"));
+    TEST_ASSERT_TRUE(enc.overflow);
+    TEST_ASSERT_TRUE(qmsd_ui_enc_event(&enc, 3, 1));
+    int len = qmsd_ui_enc_finish(&enc);
+    TEST_ASSERT_EQUAL_INT(4 + 4 + 4, len);
+
+    recorder_t rec = {{0}, 0};
+    TEST_ASSERT_EQUAL_INT(2, qmsd_ui_decode(buf, len, &g_rec_ops, &rec));
+    TEST_ASSERT_EQUAL_STRING("V1:5;E3:1;", rec.log);
+
+    qmsd_ui_enc_init(&enc, buf, 3);
+    TEST_ASSERT_FALSE(qmsd_ui_enc_event(&enc, 3, 1));
+    TEST_ASSERT_EQUAL_INT(-1, qmsd_ui_enc_finish(&enc));
+}
+
+TEST_CASE("bad batches apply nothing", "[qmsd_ui_cmd]")
+{
+    uint8_t buf[64];
+    qmsd_ui_enc_t enc;
+    qmsd_ui_enc_init(&enc, buf, sizeof(buf));
+    qmsd_ui_enc_value(&enc, 1, 1);
+    qmsd_ui_enc_text(&enc, 2, "abc");
+    int len = qmsd_ui_enc_finish(&enc);
+    recorder_t rec = {{0}, 0};
+
+    // every cut short of the end is truncated, nothing runs
+    for (int cut = QMSD_UI_HEADER_SIZE; cut < len; cut++) {
+        TEST_ASSERT_EQUAL_INT(QMSD_UI_ERR_TRUNCATED, qmsd_ui_decode(buf, cut, &g_rec_ops, &rec));
+    }
+    TEST_ASSERT_EQUAL_INT(QMSD_UI_ERR_HEADER, qmsd_ui_decode(buf, 3, &g_rec_ops, &rec));
+    TEST_ASSERT_EQUAL_UINT32(0, rec.n);
+
+    uint8_t bad[64];
+    memcpy(bad, buf, len);
+    bad[len - 1] = 'x';                     // text without its NUL
+    TEST_ASSERT_EQUAL_INT(QMSD_UI_ERR_TEXT, qmsd_ui_decode(bad, len, &g_rec_ops, &rec));
+    memcpy(bad, buf, len);
+    bad[4 + 4] = 9;                         // second op unknown
+    TEST_ASSERT_EQUAL_INT(QMSD_UI_ERR_OP, qmsd_ui_decode(bad, len, &g_rec_ops, &rec));
+    memcpy(bad, buf, len);
+    bad[0] = 'J';
+    TEST_ASSERT_EQUAL_INT(QMSD_UI_ERR_HEADER, qmsd_ui_decode(bad, len, &g_rec_ops, &rec));
+    memcpy(bad, buf, len);
+    bad[len] = 0;
+    TEST_ASSERT_EQUAL_INT(QMSD_UI_ERR_TRAILING, qmsd_ui_decode(bad, len + 1, &g_rec_ops, &rec));
+    TEST_ASSERT_EQUAL_UINT32(0, rec.n);
+}
+
+TEST_CASE("perfect hash lookup against a linear scan", "[qmsd_wid]")
+{
+    static char names[BENCH_NUM][sizeof("ui_Widget-2147483648")];   // longest any int formats to
+    static const char* ptrs[BENCH_NUM];
+    static uint16_t disp[QMSD_WID_BUCKETS(BENCH_NUM)], slots[QMSD_WID_SLOTS(BENCH_NUM)];
+    for (int i = 0; i < BENCH_NUM; i++) {
+        snprintf(names[i], sizeof(names[i]), "ui_Widget%03d", i);
+        ptrs[i] = names[i];
+    }
+    qmsd_wid_table_t table;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    TEST_ASSERT_EQUAL_INT(0, qmsd_wid_build(ptrs, BENCH_NUM, disp, slots, &table));
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("built %d names in %.1f us, seed %lu\n", BENCH_NUM, elapsed_ns(&t0, &t1) / 1000, (unsigned long)table.seed);
+
+    volatile uint32_t sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+        sum += qmsd_wid_table_lookup(&table, ptrs[i % BENCH_NUM]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double hashed = elapsed_ns(&t0, &t1) / BENCH_LOOPS;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+        const char* name = ptrs[i % BENCH_NUM];
+        for (uint16_t j = 0; j < BENCH_NUM; j++) {
+            if (strcmp(names[j], name) == 0) {
+                sum += j;
+                break;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double linear = elapsed_ns(&t0, &t1) / BENCH_LOOPS;
+    printf("%d names: %.1f ns per hashed lookup, %.1f ns per linear scan\n", BENCH_NUM, hashed, linear);
+
+    for (int i = 0; i < BENCH_NUM; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, qmsd_wid_table_lookup(&table, ptrs[i]));
+    }
+}
+
+TEST_CASE("decode throughput", "[qmsd_ui_cmd]")
+{
+    static uint8_t buf[4096];
+    qmsd_ui_enc_t enc;
+    qmsd_ui_enc_init(&enc, buf, sizeof(buf));
+    while (qmsd_ui_enc_text(&enc, enc.count % 64, "00:42 speaking") && qmsd_ui_enc_value(&enc, enc.count % 64, enc.count)) {
+    }
+    int len = qmsd_ui_enc_finish(&enc);
+    uint32_t loops = 20000;
+    recorder_t rec;
+    qmsd_ui_ops_t ops = {NULL, NULL, NULL, NULL};
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t i = 0; i < loops; i++) {
+        TEST_ASSERT_EQUAL_INT(enc.count, qmsd_ui_decode(buf, len, &ops, &rec));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = elapsed_ns(&t0, &t1) / loops;
+    printf("batch of %u commands, %d B: %.1f ns per command, %.0f MB/s\n", enc.count, len, ns / enc.count, len / ns * 1e3);
+}
@@ -0,0 +1,502 @@
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+#include "qmsd_rec_log.h"
+
+// dir plus "/segNNN"
+#define FILE_PATH_LEN   (QMSD_REC_LOG_PATH_LEN + 16)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t session;
+    uint32_t start_ms;
+} seg_header_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t seg_num;
+    uint32_t seg_size;
+    uint32_t hash;
+} index_header_t;
+
+typedef struct {
+    qmsd_rec_log_config_t config;
+    char dir[QMSD_REC_LOG_PATH_LEN];
+    qmsd_rec_io_t io;
+    qmsd_rec_segment_t seg[QMSD_REC_LOG_MAX_SEGMENTS];
+    int16_t head;               // newest slot, the open one while recording, -1 when empty
+    uint32_t next_seq;
+    // open segment
+    int fd;                     // -1 when no session
+    uint32_t written;           // bytes handed to the fs
+    uint32_t synced_at;
+    uint16_t fill;
+    uint8_t* page;
+    qmsd_rec_log_stats_t stats;
+} rec_log_t;
+
+static uint32_t fnv1a(uint32_t hash, const void* data, uint32_t len)
+{
+    const uint8_t* p = (const uint8_t *)data;
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+static void seg_path(rec_log_t* log, uint16_t slot, char* path)
+{
+    snprintf(path, FILE_PATH_LEN, "%s/seg%03u", log->dir, slot);
+}
+
+static void index_path(rec_log_t* log, char* path)
+{
+    snprintf(path, FILE_PATH_LEN, "%s/index", log->dir);
+}
+
+static int io_write(rec_log_t* log, int fd, const void* data, uint32_t len)
+{
+    int ret = log->io.write(log->io.ctx, fd, data, len);
+    log->stats.io_writes++;
+    if (ret != (int)len) {
+        log->stats.errors++;
+        return -1;
+    }
+    log->stats.io_bytes += len;
+    return 0;
+}
+
+static int index_write(rec_log_t* log)
+{
+    char path[FILE_PATH_LEN];
+    index_header_t header = {
+        .magic = QMSD_REC_INDEX_MAGIC,
+        .version = QMSD_REC_LOG_VERSION,
+        .seg_num = log->config.seg_num,
+        .seg_size = log->config.seg_size,
+    };
+    uint32_t len = log->config.seg_num * sizeof(qmsd_rec_segment_t);
+    header.hash = fnv1a(0x811c9dc5, log->seg, len);
+
+    index_path(log, path);
+    int fd = log->io.open(log->io.ctx, path, QMSD_REC_IO_WRITE_TRUNC);
+    if (fd < 0) {
+        log->stats.errors++;
+        return -1;
+    }
+    int ret = io_write(log, fd, &header, sizeof(header));
+    if (ret == 0) {
+        ret = io_write(log, fd, log->seg, len);
+    }
+    // the fs commits the new index in one go on close
+    log->io.close(log->io.ctx, fd);
+    log->stats.syncs++;
+    return ret;
+}
+
+static int index_load(rec_log_t* log)
+{
+    char path[FILE_PATH_LEN];
+    index_header_t header;
+    uint32_t len = log->config.seg_num * sizeof(qmsd_rec_segment_t);
+
+    index_path(log, path);
+    int fd = log->io.open(log->io.ctx, path, QMSD_REC_IO_READ);
+    if (fd < 0) {
+        return -1;
+    }
+    int ret = -1;
+    if (log->io.read(log->io.ctx, fd, &header, sizeof(header)) != sizeof(header)) {
+        goto exit;
+    }
+    if (header.magic != QMSD_REC_INDEX_MAGIC || header.version != QMSD_REC_LOG_VERSION
+        || header.seg_num != log->config.seg_num || header.seg_size != log->config.seg_size) {
+        goto exit;
+    }
+    if (log->io.read(log->io.ctx, fd, log->seg, len) != (int)len || fnv1a(0x811c9dc5, log->seg, len) != header.hash) {
+        memset(log->seg, 0, sizeof(log->seg));
+        goto exit;
+    }
+    ret = 0;
+exit:
+    log->io.close(log->io.ctx, fd);
+    return ret;
+}
+
+// Rebuild the entry of a slot from the file: every whole record counts.
+static int segment_scan(rec_log_t* log, uint16_t slot, qmsd_rec_segment_t* seg)
+{
+    char path[FILE_PATH_LEN];
+    seg_header_t header;
+    qmsd_rec_record_t record;
+
+    memset(seg, 0, sizeof(qmsd_rec_segment_t));
+    seg_path(log, slot, path);
+    int fd = log->io.open(log->io.ctx, path, QMSD_REC_IO_READ);
+    if (fd < 0) {
+        return -1;
+    }
+    if (log->io.read(log->io.ctx, fd, &header, sizeof(header)) != sizeof(header) || header.magic != QMSD_REC_LOG_MAGIC || header.seq == 0) {
+        log->io.close(log->io.ctx, fd);
+        return -1;
+    }
+    seg->seq = header.seq;
+    seg->session = header.session;
+    seg->start_ms = header.start_ms;
+    seg->end_ms = header.start_ms;
+    seg->bytes = sizeof(header);
+    while (seg->bytes + sizeof(record) <= log->config.seg_size) {
+        if (log->io.read(log->io.ctx, fd, &record, sizeof(record)) != sizeof(record)) {
+            break;
+        }
+        if (record.stream >= QMSD_REC_STREAM_NUM || record.len == 0) {
+            break;
+        }
+        // the page buffer is free while not recording
+        uint32_t left = record.len;
+        while (left) {
+            uint32_t n = left < log->config.page_size ? left : log->config.page_size;
+            if (log->io.read(log->io.ctx, fd, log->page, n) != (int)n) {
+                break;
+            }
+            left -= n;
+        }
+        if (left) {
+            // torn by a reset between two syncs
+            break;
+        }
+        seg->bytes += sizeof(record) + record.len;
+        seg->records++;
+        seg->end_ms = record.timestamp_ms;
+    }
+    log->io.close(log->io.ctx, fd);
+    return 0;
+}
+
+static int recover(rec_log_t* log)
+{
+    uint16_t seg_num = log->config.seg_num;
+    qmsd_rec_segment_t seg;
+    bool dirty = false;
+
+    if (index_load(log) != 0) {
+        // lost or from another layout: read the headers back
+        for (uint16_t i = 0; i < seg_num; i++) {
+            segment_scan(log, i, &log->seg[i]);
+        }
+        dirty = true;
+    }
+
+    log->head = -1;
+    log->next_seq = 1;
+    for (uint16_t i = 0; i < seg_num; i++) {
+        if (log->seg[i].seq && log->seg[i].seq >= log->next_seq) {
+            log->next_seq = log->seg[i].seq + 1;
+            log->head = i;
+        }
+    }
+
+    // the segment after the newest one in the index was open at reset, or had just been truncated
+    uint16_t next = log->head < 0 ? 0 : (log->head + 1) % seg_num;
+    if (segment_scan(log, next, &seg) == 0 && seg.seq == log->next_seq) {
+        log->seg[next] = seg;
+        log->head = next;
+        log->next_seq++;
+        dirty = true;
+    } else if (log->seg[next].seq && seg.seq != log->seg[next].seq) {
+        memset(&log->seg[next], 0, sizeof(qmsd_rec_segment_t));
+        dirty = true;
+    }
+
+    // every slot exists from the start, capture never adds directory entries
+    for (uint16_t i = 0; i < seg_num; i++) {
+        if (log->seg[i].seq) {
+            continue;
+        }
+        char path[FILE_PATH_LEN];
+        seg_path(log, i, path);
+        int fd = log->io.open(log->io.ctx, path, QMSD_REC_IO_READ);
+        if (fd < 0) {
+            fd = log->io.open(log->io.ctx, path, QMSD_REC_IO_WRITE_TRUNC);
+        }
+        if (fd < 0) {
+            return -1;
+        }
+        log->io.close(log->io.ctx, fd);
+    }
+
+    if (dirty) {
+        return index_write(log);
+    }
+    return 0;
+}
+
+qmsd_rec_log_handle_t qmsd_rec_log_open(const qmsd_rec_log_config_t* config, const qmsd_rec_io_t* io)
+{
+    if (config->seg_num == 0 || config->seg_num > QMSD_REC_LOG_MAX_SEGMENTS || config->page_size < sizeof(seg_header_t)
+        || config->seg_size < config->page_size || strlen(config->dir) + 8 >= QMSD_REC_LOG_PATH_LEN) {
+        return NULL;
+    }
+    rec_log_t* log = (rec_log_t *)calloc(1, sizeof(rec_log_t));
+    if (log == NULL) {
+        return NULL;
+    }
+    log->page = (uint8_t *)malloc(config->page_size);
+    if (log->page == NULL) {
+        free(log);
+        return NULL;
+    }
+    log->config = *config;
+    strcpy(log->dir, config->dir);
+    log->config.dir = log->dir;
+    log->io = *io;
+    log->fd = -1;
+    if (recover(log) != 0) {
+        free(log->page);
+        free(log);
+        return NULL;
+    }
+    return (qmsd_rec_log_handle_t)log;
+}
+
+static int page_flush(rec_log_t* log)
+{
+    if (log->fill == 0) {
+        return 0;
+    }
+    int ret = io_write(log, log->fd, log->page, log->fill);
+    log->written += log->fill;
+    log->fill = 0;
+    if (ret == 0 && log->config.sync_bytes && log->written - log->synced_at >= log->config.sync_bytes) {
+        ret = log->io.sync(log->io.ctx, log->fd);
+        log->stats.syncs++;
+        log->synced_at = log->written;
+    }
+    return ret;
+}
+
+static int page_put(rec_log_t* log, const void* data, uint32_t len)
+{
+    const uint8_t* p = (const uint8_t *)data;
+    while (len) {
+        uint32_t n = log->config.page_size - log->fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(log->page + log->fill, p, n);
+        log->fill += n;
+        p += n;
+        len -= n;
+        // only whole pages go out while recording
+        if (log->fill == log->config.page_size && page_flush(log) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int segment_open(rec_log_t* log, uint32_t session, uint32_t now_ms)
+{
+    char path[FILE_PATH_LEN];
+    uint16_t slot = log->head < 0 ? 0 : (log->head + 1) % log->config.seg_num;
+    qmsd_rec_segment_t* seg = &log->seg[slot];
+
+    seg_path(log, slot, path);
+    log->fd = log->io.open(log->io.ctx, path, QMSD_REC_IO_WRITE_TRUNC);
+    if (log->fd < 0) {
+        log->stats.errors++;
+        return -1;
+    }
+    if (seg->seq) {
+        log->stats.recycled++;
+    }
+    seg->seq = log->next_seq++;
+    seg->session = session;
+    seg->start_ms = now_ms;
+    seg->end_ms = now_ms;
+    seg->bytes = sizeof(seg_header_t);
+    seg->records = 0;
+    log->head = slot;
+    log->written = 0;
+    log->synced_at = 0;
+    log->fill = 0;
+
+    seg_header_t header = {
+        .magic = QMSD_REC_LOG_MAGIC,
+        .seq = seg->seq,
+        .session = session,
+        .start_ms = now_ms,
+    };
+    return page_put(log, &header, sizeof(header));
+}
+
+static int segment_close(rec_log_t* log)
+{
+    int ret = page_flush(log);
+    log->io.close(log->io.ctx, log->fd);
+    log->stats.syncs++;
+    log->fd = -1;
+    log->stats.segments++;
+    if (index_write(log) != 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
+void qmsd_rec_log_close(qmsd_rec_log_handle_t handle)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    if (log->fd >= 0) {
+        qmsd_rec_log_end(handle, log->seg[log->head].end_ms);
+    }
+    free(log->page);
+    free(log);
+}
+
+int qmsd_rec_log_begin(qmsd_rec_log_handle_t handle, uint32_t session, uint32_t now_ms)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    if (log->fd >= 0) {
+        qmsd_rec_log_end(handle, now_ms);
+    }
+    return segment_open(log, session, now_ms);
+}
+
+int qmsd_rec_log_append(qmsd_rec_log_handle_t handle, qmsd_rec_stream_t stream, uint8_t codec, uint32_t timestamp_ms, const void* data, uint16_t len)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    uint32_t rec_len = sizeof(qmsd_rec_record_t) + len;
+    if (log->fd < 0 || stream >= QMSD_REC_STREAM_NUM || len == 0 || sizeof(seg_header_t) + rec_len > log->config.seg_size) {
+        log->stats.dropped++;
+        return -1;
+    }
+
+    qmsd_rec_segment_t* seg = &log->seg[log->head];
+    if (seg->bytes + rec_len > log->config.seg_size) {
+        uint32_t session = seg->session;
+        if (segment_close(log) != 0 || segment_open(log, session, timestamp_ms) != 0) {
+            log->stats.dropped++;
+            return -1;
+        }
+        seg = &log->seg[log->head];
+    }
+
+    qmsd_rec_record_t record = {
+        .stream = stream,
+        .codec = codec,
+        .len = len,
+        .timestamp_ms = timestamp_ms,
+    };
+    if (page_put(log, &record, sizeof(record)) != 0 || page_put(log, data, len) != 0) {
+        log->stats.dropped++;
+        return -1;
+    }
+    seg->bytes += rec_len;
+    seg->records++;
+    seg->end_ms = timestamp_ms;
+    log->stats.records++;
+    log->stats.payload_bytes += len;
+    return 0;
+}
+
+int qmsd_rec_log_end(qmsd_rec_log_handle_t handle, uint32_t now_ms)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    if (log->fd < 0) {
+        return 0;
+    }
+    if ((int32_t)(now_ms - log->seg[log->head].end_ms) > 0) {
+        log->seg[log->head].end_ms = now_ms;
+    }
+    return segment_close(log);
+}
+
+bool qmsd_rec_log_is_recording(qmsd_rec_log_handle_t handle)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    return log->fd >= 0;
+}
+
+int qmsd_rec_log_segment(qmsd_rec_log_handle_t handle, uint16_t n, qmsd_rec_segment_t* segment)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    uint16_t seg_num = log->config.seg_num;
+    if (log->head < 0) {
+        return -1;
+    }
+    // head + 1 is the oldest, head the newest
+    for (uint16_t k = 1; k <= seg_num; k++) {
+        uint16_t slot = (log->head + k) % seg_num;
+        if (log->seg[slot].seq == 0 || (log->fd >= 0 && slot == log->head)) {
+            continue;
+        }
+        if (n-- == 0) {
+            *segment = log->seg[slot];
+            return slot;
+        }
+    }
+    return -1;
+}
+
+int qmsd_rec_log_reader_open(qmsd_rec_log_handle_t handle, uint16_t slot, qmsd_rec_log_reader_t* reader)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    char path[FILE_PATH_LEN];
+    seg_header_t header;
+
+    reader->fd = -1;
+    if (slot >= log->config.seg_num || log->seg[slot].seq == 0 || (log->fd >= 0 && slot == log->head)) {
+        return -1;
+    }
+    seg_path(log, slot, path);
+    int fd = log->io.open(log->io.ctx, path, QMSD_REC_IO_READ);
+    if (fd < 0) {
+        return -1;
+    }
+    if (log->io.read(log->io.ctx, fd, &header, sizeof(header)) != sizeof(header) || header.seq != log->seg[slot].seq) {
+        log->io.close(log->io.ctx, fd);
+        return -1;
+    }
+    reader->fd = fd;
+    reader->left = log->seg[slot].bytes - sizeof(header);
+    return 0;
+}
+
+int qmsd_rec_log_reader_next(qmsd_rec_log_handle_t handle, qmsd_rec_log_reader_t* reader, qmsd_rec_record_t* record, void* data, uint16_t data_size)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    if (reader->fd < 0) {
+        return -1;
+    }
+    if (reader->left < sizeof(qmsd_rec_record_t)) {
+        return 0;
+    }
+    if (log->io.read(log->io.ctx, reader->fd, record, sizeof(qmsd_rec_record_t)) != sizeof(qmsd_rec_record_t)) {
+        return -1;
+    }
+    if (record->len > data_size || sizeof(qmsd_rec_record_t) + record->len > reader->left) {
+        return -1;
+    }
+    if (log->io.read(log->io.ctx, reader->fd, data, record->len) != record->len) {
+        return -1;
+    }
+    reader->left -= sizeof(qmsd_rec_record_t) + record->len;
+    return 1;
+}
+
+void qmsd_rec_log_reader_close(qmsd_rec_log_handle_t handle, qmsd_rec_log_reader_t* reader)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    if (reader->fd >= 0) {
+        log->io.close(log->io.ctx, reader->fd);
+        reader->fd = -1;
+    }
+}
+
+void qmsd_rec_log_get_stats(qmsd_rec_log_handle_t handle, qmsd_rec_log_stats_t* stats)
+{
+    rec_log_t* log = (rec_log_t *)handle;
+    *stats = log->stats;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Log structured recorder: encoded audio records go into a ring of segment
+// files, seg000 ~ segNNN, plus a small index. Writes are gathered into one
+// page sized buffer and handed to the file system a full page at a time, a
+// segment is only ever appended to, and the oldest one is truncated and reused
+// when the ring wraps. On LittleFS that is the cheap path: appends program
+// fresh pages, while an overwrite in the middle of a file copies everything
+// behind it.
+//
+// The index is rewritten once per closed segment. After a crash the segment
+// that was open is found by its sequence number and scanned, every record
+// written before the last sync is kept.
+//
+// qmsd_rec_log.c is portable (file ops and time are passed in), qmsd_recorder.c
+// runs it on LittleFS from a background task.
+
+#define QMSD_REC_LOG_MAGIC          0x43455251UL    // "QREC"
+#define QMSD_REC_INDEX_MAGIC        0x58445251UL    // "QRDX"
+#define QMSD_REC_LOG_VERSION        1
+#define QMSD_REC_LOG_MAX_SEGMENTS   64
+#define QMSD_REC_LOG_PATH_LEN       48
+
+typedef enum {
+    QMSD_REC_STREAM_UPLINK = 0,         // microphone -> network
+    QMSD_REC_STREAM_DOWNLINK,           // network -> speaker
+    QMSD_REC_STREAM_NUM,
+} qmsd_rec_stream_t;
+
+typedef enum {
+    QMSD_REC_IO_READ = 0,
+    QMSD_REC_IO_WRITE_TRUNC,            // create or truncate, write only
+} qmsd_rec_io_mode_t;
+
+// Thin file layer, posix on the device, a ram flash model in the test.
+typedef struct {
+    // returns a handle >= 0
+    int (*open)(void* ctx, const char* path, qmsd_rec_io_mode_t mode);
+    // returns bytes done, < 0 on error
+    int (*write)(void* ctx, int fd, const void* data, uint32_t len);
+    int (*read)(void* ctx, int fd, void* data, uint32_t len);
+    // make everything written so far survive a reset
+    int (*sync)(void* ctx, int fd);
+    int (*close)(void* ctx, int fd);
+    void* ctx;
+} qmsd_rec_io_t;
+
+typedef struct {
+    const char* dir;
+    uint16_t seg_num;           // files in the ring
+    uint32_t seg_size;          // bytes per segment, records never straddle two
+    uint16_t page_size;         // write batch, the fs page or block size
+    uint32_t sync_bytes;        // sync at least this often (rounded up to pages), 0: at segment end only
+} qmsd_rec_log_config_t;
+
+typedef struct {
+    uint32_t seq;               // 0: slot never used
+    uint32_t session;
+    uint32_t start_ms;
+    uint32_t end_ms;
+    uint32_t bytes;             // valid bytes in the file
+    uint32_t records;
+} qmsd_rec_segment_t;
+
+typedef struct {
+    uint8_t stream;
+    uint8_t codec;
+    uint16_t len;
+    uint32_t timestamp_ms;
+} qmsd_rec_record_t;
+
+typedef struct {
+    uint32_t payload_bytes;     // audio handed to append
+    uint32_t io_bytes;          // bytes passed to write, segments and index
+    uint32_t io_writes;
+    uint32_t syncs;
+    uint32_t segments;          // segments closed
+    uint32_t recycled;          // of those, ones that overwrote an old segment
+    uint32_t records;
+    uint32_t dropped;           // records not stored: no session, too big or io error
+    uint32_t errors;
+} qmsd_rec_log_stats_t;
+
+typedef struct {
+    int fd;
+    uint32_t left;
+} qmsd_rec_log_reader_t;
+
+typedef void *qmsd_rec_log_handle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Loads the index, recovers the segment that was open at reset and creates
+// missing segment files. NULL on a bad config or io error.
+qmsd_rec_log_handle_t qmsd_rec_log_open(const qmsd_rec_log_config_t* config, const qmsd_rec_io_t* io);
+
+// Ends the session if one is running.
+void qmsd_rec_log_close(qmsd_rec_log_handle_t log);
+
+// Every session starts a new segment.
+int qmsd_rec_log_begin(qmsd_rec_log_handle_t log, uint32_t session, uint32_t now_ms);
+
+int qmsd_rec_log_append(qmsd_rec_log_handle_t log, qmsd_rec_stream_t stream, uint8_t codec, uint32_t timestamp_ms, const void* data, uint16_t len);
+
+// Writes the partial page, closes the segment and updates the index.
+int qmsd_rec_log_end(qmsd_rec_log_handle_t log, uint32_t now_ms);
+
+bool qmsd_rec_log_is_recording(qmsd_rec_log_handle_t log);
+
+// Slots from oldest to newest: n = 0 is the oldest closed segment. -1 past the end.
+int qmsd_rec_log_segment(qmsd_rec_log_handle_t log, uint16_t n, qmsd_rec_segment_t* segment);
+
+int qmsd_rec_log_reader_open(qmsd_rec_log_handle_t log, uint16_t slot, qmsd_rec_log_reader_t* reader);
+
+// 1: record in data, 0: end of segment, < 0: error or data too small
+int qmsd_rec_log_reader_next(qmsd_rec_log_handle_t log, qmsd_rec_log_reader_t* reader, qmsd_rec_record_t* record, void* data, uint16_t data_size);
+
+void qmsd_rec_log_reader_close(qmsd_rec_log_handle_t log, qmsd_rec_log_reader_t* reader);
+
+void qmsd_rec_log_get_stats(qmsd_rec_log_handle_t log, qmsd_rec_log_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
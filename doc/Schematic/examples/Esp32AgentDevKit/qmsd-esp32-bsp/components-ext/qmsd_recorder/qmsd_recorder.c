@@ -0,0 +1,275 @@
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/stat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_littlefs.h"
+#include "qmsd_sched.h"
+#include "qmsd_recorder.h"
+
+#define TAG "QMSD_REC"
+
+#define RECORDER_DIR            "rec"
+#define RECORDER_STACK          4096
+// items in the ring that are not audio
+#define RECORDER_CMD_BEGIN      0x80
+#define RECORDER_CMD_END        0x81
+
+typedef struct {
+    uint8_t type;               // qmsd_rec_stream_t or RECORDER_CMD_*
+    uint8_t codec;
+    uint16_t len;
+    uint32_t timestamp_ms;
+} ring_item_t;
+
+typedef struct {
+    qmsd_rec_log_handle_t log;
+    RingbufHandle_t ring;
+    TaskHandle_t task;
+    volatile uint8_t capturing;
+    volatile uint8_t end_pending;       // the ring was full at the end, the task ends the session once it drained
+    volatile uint32_t end_ms;
+    volatile uint32_t ring_dropped;
+    char dir[QMSD_REC_LOG_PATH_LEN];
+} qmsd_recorder_t;
+
+static qmsd_recorder_t g_rec = {0};
+
+static uint32_t rec_now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static int posix_open(void* ctx, const char* path, qmsd_rec_io_mode_t mode) {
+    if (mode == QMSD_REC_IO_READ) {
+        return open(path, O_RDONLY);
+    }
+    return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+static int posix_write(void* ctx, int fd, const void* data, uint32_t len) {
+    return write(fd, data, len);
+}
+
+static int posix_read(void* ctx, int fd, void* data, uint32_t len) {
+    return read(fd, data, len);
+}
+
+static int posix_sync(void* ctx, int fd) {
+    return fsync(fd);
+}
+
+static int posix_close(void* ctx, int fd) {
+    return close(fd);
+}
+
+static const qmsd_rec_io_t g_posix_io = {
+    .open = posix_open,
+    .write = posix_write,
+    .read = posix_read,
+    .sync = posix_sync,
+    .close = posix_close,
+};
+
+static bool ring_put(uint8_t type, uint8_t codec, uint32_t timestamp_ms, const void* data, uint16_t len) {
+    void* item = NULL;
+    if (g_rec.ring == NULL || xRingbufferSendAcquire(g_rec.ring, &item, sizeof(ring_item_t) + len, 0) != pdTRUE) {
+        return false;
+    }
+    ring_item_t* header = (ring_item_t *)item;
+    header->type = type;
+    header->codec = codec;
+    header->len = len;
+    header->timestamp_ms = timestamp_ms;
+    if (len) {
+        memcpy(header + 1, data, len);
+    }
+    xRingbufferSendComplete(g_rec.ring, item);
+    return true;
+}
+
+static void recorder_end_pending(void) {
+    g_rec.end_pending = 0;
+    qmsd_rec_log_end(g_rec.log, g_rec.end_ms);
+    ESP_LOGI(TAG, "session end");
+}
+
+static void recorder_task(void* arg) {
+    for (;;) {
+        size_t size = 0;
+        ring_item_t* item = (ring_item_t *)xRingbufferReceive(g_rec.ring, &size, g_rec.end_pending ? 0 : portMAX_DELAY);
+        if (item == NULL) {
+            // everything of the session is written
+            if (g_rec.end_pending) {
+                recorder_end_pending();
+            }
+            continue;
+        }
+        if (item->type == RECORDER_CMD_BEGIN && g_rec.end_pending) {
+            // the next call began before the ring drained, the items before it belong to the last one
+            recorder_end_pending();
+        }
+        if (item->type == RECORDER_CMD_BEGIN) {
+            uint32_t session;
+            memcpy(&session, item + 1, sizeof(session));
+            qmsd_rec_log_begin(g_rec.log, session, item->timestamp_ms);
+            ESP_LOGI(TAG, "session %lu begin", (unsigned long)session);
+        } else if (item->type == RECORDER_CMD_END) {
+            qmsd_rec_log_end(g_rec.log, item->timestamp_ms);
+            ESP_LOGI(TAG, "session end");
+        } else {
+            qmsd_rec_log_append(g_rec.log, item->type, item->codec, item->timestamp_ms, item + 1, item->len);
+        }
+        vRingbufferReturnItem(g_rec.ring, item);
+    }
+}
+
+static esp_err_t recorder_mount(const qmsd_recorder_config_t* config, uint16_t* seg_num) {
+    esp_vfs_littlefs_conf_t conf = {
+        .base_path = config->base_path,
+        .partition_label = config->partition_label,
+        .format_if_mount_failed = true,
+        .dont_mount = false,
+    };
+    esp_err_t ret = esp_vfs_littlefs_register(&conf);
+    // already mounted by someone else is fine
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to mount littlefs (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+
+    size_t total = 0, used = 0;
+    if (esp_littlefs_info(config->partition_label, &total, &used) == ESP_OK) {
+        // leave a quarter for metadata, the index and whatever else lives there
+        uint32_t fit = total / 4 * 3 / config->seg_size;
+        if (fit < *seg_num) {
+            ESP_LOGW(TAG, "%u segments do not fit in %u bytes, using %lu", *seg_num, (unsigned)total, (unsigned long)fit);
+            *seg_num = fit;
+        }
+    }
+    return *seg_num ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t qmsd_recorder_start(const qmsd_recorder_config_t* config) {
+    if (g_rec.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint16_t seg_num = config->seg_num;
+    esp_err_t ret = recorder_mount(config, &seg_num);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    snprintf(g_rec.dir, sizeof(g_rec.dir), "%s/%s", config->base_path, RECORDER_DIR);
+    mkdir(g_rec.dir, 0755);
+
+    qmsd_rec_log_config_t log_config = {
+        .dir = g_rec.dir,
+        .seg_num = seg_num,
+        .seg_size = config->seg_size,
+        .page_size = config->page_size,
+        .sync_bytes = config->sync_bytes,
+    };
+    int64_t t = esp_timer_get_time();
+    g_rec.log = qmsd_rec_log_open(&log_config, &g_posix_io);
+    if (g_rec.log == NULL) {
+        ESP_LOGE(TAG, "Failed to open the log in %s", g_rec.dir);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "%u x %lu B segments, opened in %lld ms", seg_num, (unsigned long)config->seg_size, (esp_timer_get_time() - t) / 1000);
+
+    g_rec.ring = xRingbufferCreate(config->ring_size, RINGBUF_TYPE_NOSPLIT);
+    if (g_rec.ring == NULL) {
+        ESP_LOGE(TAG, "Memory allocation failed");
+        goto recorder_start_error;
+    }
+    UBaseType_t prio = config->priority;
+    BaseType_t core = config->core;
+    uint32_t stack_size = RECORDER_STACK;
+    qmsd_sched_place("recorder", &prio, &core, &stack_size);
+    if (xTaskCreatePinnedToCore(recorder_task, "recorder", stack_size, NULL, prio, &g_rec.task, core) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating task");
+        goto recorder_start_error;
+    }
+    return ESP_OK;
+
+recorder_start_error:
+    if (g_rec.ring) {
+        vRingbufferDelete(g_rec.ring);
+        g_rec.ring = NULL;
+    }
+    qmsd_rec_log_close(g_rec.log);
+    g_rec.log = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+static void recorder_event_cb(const qmsd_event_t* event, void* user_data) {
+    if (event->id == QMSD_EVENT_CALL_JOINED) {
+        qmsd_recorder_begin((uint32_t)event->value);
+    } else if (event->id == QMSD_EVENT_CALL_LEFT) {
+        qmsd_recorder_end();
+    }
+}
+
+esp_err_t qmsd_recorder_attach_event_bus(qmsd_event_bus_handle_t bus) {
+    if (bus == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (qmsd_event_bus_subscribe(bus, QMSD_EVENT_TOPIC_BIT(QMSD_EVENT_TOPIC_CALL), recorder_event_cb, NULL) < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void qmsd_recorder_begin(uint32_t session) {
+    if (ring_put(RECORDER_CMD_BEGIN, 0, rec_now_ms(), &session, sizeof(session))) {
+        g_rec.capturing = 1;
+    } else {
+        g_rec.ring_dropped++;
+    }
+}
+
+void qmsd_recorder_end(void) {
+    if (!g_rec.capturing) {
+        return ;
+    }
+    g_rec.capturing = 0;
+    // runs in the event bus dispatcher, so never wait for room: with the ring full
+    // the task is busy draining it and ends the session once it's empty
+    uint32_t now = rec_now_ms();
+    if (!ring_put(RECORDER_CMD_END, 0, now, NULL, 0)) {
+        g_rec.end_ms = now;
+        g_rec.end_pending = 1;
+        // it may have emptied the ring in between and be waiting on it, ending twice is harmless
+        ring_put(RECORDER_CMD_END, 0, now, NULL, 0);
+    }
+}
+
+void qmsd_recorder_push(qmsd_rec_stream_t stream, uint8_t codec, const void* data, uint16_t len) {
+    if (!g_rec.capturing || len == 0) {
+        return ;
+    }
+    if (!ring_put(stream, codec, rec_now_ms(), data, len)) {
+        g_rec.ring_dropped++;
+    }
+}
+
+bool qmsd_recorder_is_recording(void) {
+    return g_rec.capturing;
+}
+
+qmsd_rec_log_handle_t qmsd_recorder_get_log(void) {
+    return g_rec.log;
+}
+
+void qmsd_recorder_get_stats(qmsd_recorder_stats_t* stats) {
+    memset(stats, 0, sizeof(qmsd_recorder_stats_t));
+    if (g_rec.log) {
+        qmsd_rec_log_get_stats(g_rec.log, &stats->log);
+    }
+    stats->ring_dropped = g_rec.ring_dropped;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "esp_err.h"
+#include "qmsd_rec_log.h"
+#include "qmsd_event_bus.h"
+
+// Call recorder on LittleFS. Producers push encoded frames from any task, the
+// push only copies into a ring buffer and never touches flash; a background
+// task drains it into the segment log (qmsd_rec_log.h). Sessions start and stop
+// on QMSD_EVENT_TOPIC_CALL events, or through qmsd_recorder_begin / end, and
+// are ordered with the audio around them.
+
+typedef struct {
+    const char* base_path;          // littlefs mount point
+    const char* partition_label;
+    uint16_t seg_num;               // lowered to fit 3/4 of the partition
+    uint32_t seg_size;
+    uint16_t page_size;
+    uint32_t sync_bytes;
+    uint32_t ring_size;             // bytes buffered between push and flash
+    uint8_t priority;
+    int8_t core;
+} qmsd_recorder_config_t;
+
+// Two way g711 is ~17KB/s with record headers: a 64KB segment holds ~4 s, a sync
+// every 32KB risks ~2 s on a power cut and keeps write amplification under 1.1.
+// The 960KB storage partition fits 11 segments, the last ~40 s of calls.
+#define QMSD_RECORDER_DEFAULT_CONFIG() {    \
+    .base_path = "/littlefs",               \
+    .partition_label = "storage",           \
+    .seg_num = 16,                          \
+    .seg_size = 64 * 1024,                  \
+    .page_size = 4096,                      \
+    .sync_bytes = 32 * 1024,                \
+    .ring_size = 16 * 1024,                 \
+    .priority = 3,                          \
+    .core = 0,                              \
+}
+
+typedef struct {
+    qmsd_rec_log_stats_t log;
+    uint32_t ring_dropped;          // push found the ring full
+} qmsd_recorder_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mounts littlefs (formats it when the mount fails), opens the log and starts the writer task.
+esp_err_t qmsd_recorder_start(const qmsd_recorder_config_t* config);
+
+// Follow QMSD_EVENT_TOPIC_CALL: JOINED begins a session, value is the session id, LEFT ends it.
+esp_err_t qmsd_recorder_attach_event_bus(qmsd_event_bus_handle_t bus);
+
+void qmsd_recorder_begin(uint32_t session);
+
+// Never blocks, it runs in the event bus dispatcher: with the ring full the writer ends the session once it drained it.
+void qmsd_recorder_end(void);
+
+// Any task, never blocks. Ignored while no session runs.
+void qmsd_recorder_push(qmsd_rec_stream_t stream, uint8_t codec, const void* data, uint16_t len);
+
+bool qmsd_recorder_is_recording(void);
+
+// Only while no session runs, the log is not locked against the writer task.
+qmsd_rec_log_handle_t qmsd_recorder_get_log(void);
+
+void qmsd_recorder_get_stats(qmsd_recorder_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
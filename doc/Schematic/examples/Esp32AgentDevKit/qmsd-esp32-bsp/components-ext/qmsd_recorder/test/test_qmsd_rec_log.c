@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "qmsd_rec_log.h"
+
+// Ram flash with the littlefs write path cost model: data is programmed in
+// PROG_SIZE units out of a one unit cache, every new block is erased, a
+// sync pads the cache and commits metadata, and the first append after a
+// sync copies the unfinished block to a fresh one.
+#define PROG_SIZE       256
+#define BLOCK_SIZE      4096
+#define CTZ_SIZE        4           // skip list pointer per data block
+#define MAX_FILES       40
+#define MAX_FDS         8
+#define FILE_CAP        (128 * 1024)
+// typical 4MB nor: 256B page program 0.4 ms, 4KB sector erase 45 ms
+#define T_PROG_US       400
+#define T_ERASE_US      45000
+
+typedef struct {
+    char name[QMSD_REC_LOG_PATH_LEN];
+    uint8_t* data;
+    uint32_t size;
+    uint32_t synced;
+} ram_file_t;
+
+typedef struct {
+    int file;
+    uint32_t pos;
+    uint8_t writing;
+    uint32_t cache_fill;
+    uint32_t block_fill;
+    uint8_t reopen_tail;
+} ram_fd_t;
+
+typedef struct {
+    ram_file_t file[MAX_FILES];
+    ram_fd_t fd[MAX_FDS];
+    uint32_t prog_bytes;
+    uint32_t erases;
+    uint32_t commits;
+} ram_fs_t;
+
+static ram_fs_t s_fs;
+
+static void ram_reset(void) {
+    for (int i = 0; i < MAX_FILES; i++) {
+        free(s_fs.file[i].data);
+    }
+    memset(&s_fs, 0, sizeof(s_fs));
+    for (int i = 0; i < MAX_FDS; i++) {
+        s_fs.fd[i].file = -1;
+    }
+}
+
+static void ram_commit(void) {
+    s_fs.prog_bytes += PROG_SIZE;
+    s_fs.commits++;
+}
+
+static int ram_find(const char* path) {
+    for (int i = 0; i < MAX_FILES; i++) {
+        if (s_fs.file[i].data && strcmp(s_fs.file[i].name, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int ram_open(void* ctx, const char* path, qmsd_rec_io_mode_t mode) {
+    int file = ram_find(path);
+    if (file < 0) {
+        if (mode == QMSD_REC_IO_READ) {
+            return -1;
+        }
+        for (file = 0; file < MAX_FILES && s_fs.file[file].data; file++) {
+        }
+        TEST_ASSERT_LESS_THAN(MAX_FILES, file);
+        s_fs.file[file].data = malloc(FILE_CAP);
+        strcpy(s_fs.file[file].name, path);
+    }
+    int fd;
+    for (fd = 0; fd < MAX_FDS && s_fs.fd[fd].file >= 0; fd++) {
+    }
+    TEST_ASSERT_LESS_THAN(MAX_FDS, fd);
+    memset(&s_fs.fd[fd], 0, sizeof(ram_fd_t));
+    s_fs.fd[fd].file = file;
+    if (mode == QMSD_REC_IO_WRITE_TRUNC) {
+        s_fs.fd[fd].writing = 1;
+        s_fs.file[file].size = 0;
+        s_fs.file[file].synced = 0;
+        ram_commit();
+    }
+    return fd;
+}
+
+static int ram_write(void* ctx, int fd, const void* data, uint32_t len) {
+    ram_fd_t* f = &s_fs.fd[fd];
+    ram_file_t* file = &s_fs.file[f->file];
+    if (file->size + len > FILE_CAP) {
+        return -1;
+    }
+    memcpy(file->data + file->size, data, len);
+    file->size += len;
+
+    if (f->reopen_tail && f->block_fill) {
+        s_fs.erases++;
+        s_fs.prog_bytes += (f->block_fill + PROG_SIZE - 1) / PROG_SIZE * PROG_SIZE;
+    }
+    f->reopen_tail = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        if (f->block_fill == 0) {
+            s_fs.erases++;
+            f->block_fill = CTZ_SIZE;
+            f->cache_fill += CTZ_SIZE;
+        }
+        f->block_fill++;
+        f->cache_fill++;
+        if (f->cache_fill == PROG_SIZE) {
+            s_fs.prog_bytes += PROG_SIZE;
+            f->cache_fill = 0;
+        }
+        if (f->block_fill == BLOCK_SIZE) {
+            f->block_fill = 0;
+        }
+    }
+    return len;
+}
+
+static int ram_read(void* ctx, int fd, void* data, uint32_t len) {
+    ram_fd_t* f = &s_fs.fd[fd];
+    ram_file_t* file = &s_fs.file[f->file];
+    if (f->pos + len > file->size) {
+        len = file->size - f->pos;
+    }
+    memcpy(data, file->data + f->pos, len);
+    f->pos += len;
+    return len;
+}
+
+static int ram_sync(void* ctx, int fd) {
+    ram_fd_t* f = &s_fs.fd[fd];
+    if (!f->writing) {
+        return 0;
+    }
+    if (f->cache_fill) {
+        s_fs.prog_bytes += PROG_SIZE;
+        f->cache_fill = 0;
+    }
+    ram_commit();
+    f->reopen_tail = 1;
+    s_fs.file[f->file].synced = s_fs.file[f->file].size;
+    return 0;
+}
+
+static int ram_close(void* ctx, int fd) {
+    ram_sync(ctx, fd);
+    s_fs.fd[fd].file = -1;
+    return 0;
+}
+
+// power cut: unsynced data is gone, every handle with it
+static void ram_crash(void) {
+    for (int i = 0; i < MAX_FILES; i++) {
+        s_fs.file[i].size = s_fs.file[i].synced;
+    }
+    for (int i = 0; i < MAX_FDS; i++) {
+        s_fs.fd[i].file = -1;
+    }
+}
+
+static const qmsd_rec_io_t s_io = {
+    .open = ram_open,
+    .write = ram_write,
+    .read = ram_read,
+    .sync = ram_sync,
+    .close = ram_close,
+};
+
+static void frame_fill(uint8_t* frame, uint16_t len, uint32_t n) {
+    for (uint16_t i = 0; i < len; i++) {
+        frame[i] = (uint8_t)(n * 7 + i);
+    }
+}
+
+// one 20 ms g711 frame each way
+static void talk(qmsd_rec_log_handle_t log, uint32_t* n, uint32_t frames) {
+    uint8_t frame[160];
+    for (uint32_t i = 0; i < frames; i++, (*n)++) {
+        frame_fill(frame, sizeof(frame), *n);
+        TEST_ASSERT_EQUAL(0, qmsd_rec_log_append(log, QMSD_REC_STREAM_UPLINK, 8, *n * 20, frame, sizeof(frame)));
+        TEST_ASSERT_EQUAL(0, qmsd_rec_log_append(log, QMSD_REC_STREAM_DOWNLINK, 8, *n * 20, frame, sizeof(frame)));
+    }
+}
+
+static const qmsd_rec_log_config_t s_small = {
+    .dir = "/littlefs/rec",
+    .seg_num = 4,
+    .seg_size = 8 * 1024,
+    .page_size = 512,
+    .sync_bytes = 2048,
+};
+
+TEST_CASE("records read back in order, the ring recycles the oldest segment", "[qmsd_recorder]")
+{
+    ram_reset();
+    qmsd_rec_log_handle_t log = qmsd_rec_log_open(&s_small, &s_io);
+    TEST_ASSERT_NOT_NULL(log);
+    TEST_ASSERT_EQUAL(-1, qmsd_rec_log_append(log, QMSD_REC_STREAM_UPLINK, 8, 0, "x", 1));
+
+    // 8KB segments hold 24 frame pairs, 60 pairs span 3 segments, 3 sessions need 9 of 4 slots
+    uint32_t n = 0;
+    for (uint32_t session = 1; session <= 3; session++) {
+        TEST_ASSERT_EQUAL(0, qmsd_rec_log_begin(log, session, n * 20));
+        talk(log, &n, 60);
+        TEST_ASSERT_EQUAL(0, qmsd_rec_log_end(log, n * 20));
+    }
+    TEST_ASSERT_FALSE(qmsd_rec_log_is_recording(log));
+
+    qmsd_rec_log_stats_t stats;
+    qmsd_rec_log_get_stats(log, &stats);
+    TEST_ASSERT_EQUAL(9, stats.segments);
+    TEST_ASSERT_EQUAL(5, stats.recycled);
+    TEST_ASSERT_EQUAL(360, stats.records);
+    // the append before begin
+    TEST_ASSERT_EQUAL(1, stats.dropped);
+
+    // the 4 newest survive, oldest first: the end of session 2 and all of session 3
+    qmsd_rec_segment_t seg, prev = {0};
+    int slot = -1;
+    for (uint16_t i = 0; i < 4; i++) {
+        slot = qmsd_rec_log_segment(log, i, &seg);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, slot);
+        TEST_ASSERT_EQUAL(6 + i, seg.seq);
+        TEST_ASSERT_EQUAL(i == 0 ? 2 : 3, seg.session);
+        if (i) {
+            // no gap: a roll starts at the record that did not fit
+            TEST_ASSERT_GREATER_OR_EQUAL(prev.end_ms, seg.start_ms);
+            TEST_ASSERT_LESS_OR_EQUAL(prev.end_ms + 20, seg.start_ms);
+        }
+        prev = seg;
+    }
+    TEST_ASSERT_EQUAL(-1, qmsd_rec_log_segment(log, 4, &seg));
+
+    // newest segment: the tail of session 3
+    qmsd_rec_log_reader_t reader;
+    qmsd_rec_record_t record;
+    uint8_t data[256], expect[160];
+    TEST_ASSERT_EQUAL(0, qmsd_rec_log_reader_open(log, slot, &reader));
+    uint32_t records = 0;
+    int ret;
+    while ((ret = qmsd_rec_log_reader_next(log, &reader, &record, data, sizeof(data))) == 1) {
+        uint32_t frame_n = record.timestamp_ms / 20;
+        frame_fill(expect, sizeof(expect), frame_n);
+        TEST_ASSERT_EQUAL(records & 1 ? QMSD_REC_STREAM_DOWNLINK : QMSD_REC_STREAM_UPLINK, record.stream);
+        TEST_ASSERT_EQUAL(160, record.len);
+        TEST_ASSERT_EQUAL_MEMORY(expect, data, 160);
+        records++;
+    }
+    TEST_ASSERT_EQUAL(0, ret);
+    TEST_ASSERT_EQUAL(seg.records, records);
+    TEST_ASSERT_EQUAL(179, record.timestamp_ms / 20);
+    qmsd_rec_log_reader_close(log, &reader);
+
+    qmsd_rec_log_close(log);
+}
+
+TEST_CASE("a reset keeps what was synced of the open segment", "[qmsd_recorder]")
+{
+    ram_reset();
+    qmsd_rec_log_handle_t log = qmsd_rec_log_open(&s_small, &s_io);
+    uint32_t n = 0;
+    qmsd_rec_log_begin(log, 7, 0);
+    talk(log, &n, 30);
+    qmsd_rec_log_begin(log, 8, n * 20);
+    talk(log, &n, 10);
+    // power cut in the middle of session 8, the log handle is lost with it
+    ram_crash();
+
+    log = qmsd_rec_log_open(&s_small, &s_io);
+    TEST_ASSERT_NOT_NULL(log);
+    qmsd_rec_segment_t seg;
+    int slot = -1, count = 0;
+    while (qmsd_rec_log_segment(log, count, &seg) >= 0) {
+        slot = qmsd_rec_log_segment(log, count, &seg);
+        count++;
+    }
+    // 30 pairs of session 7 filled one segment and started a second
+    TEST_ASSERT_EQUAL(3, count);
+    TEST_ASSERT_EQUAL(8, seg.session);
+    // syncs every 2KB: 10 pairs are 3360B, everything up to 2048B survives as whole records
+    TEST_ASSERT_GREATER_THAN(0, seg.records);
+    TEST_ASSERT_LESS_THAN(20, seg.records);
+    TEST_ASSERT_LESS_OR_EQUAL(2048 + 512, seg.bytes);
+
+    qmsd_rec_log_reader_t reader;
+    qmsd_rec_record_t record;
+    uint8_t data[256];
+    uint32_t records = 0;
+    TEST_ASSERT_EQUAL(0, qmsd_rec_log_reader_open(log, slot, &reader));
+    while (qmsd_rec_log_reader_next(log, &reader, &record, data, sizeof(data)) == 1) {
+        records++;
+    }
+    qmsd_rec_log_reader_close(log, &reader);
+    TEST_ASSERT_EQUAL(seg.records, records);
+
+    // the next session goes behind the recovered one
+    qmsd_rec_log_begin(log, 9, n * 20);
+    talk(log, &n, 1);
+    qmsd_rec_log_end(log, n * 20);
+    qmsd_rec_log_segment(log, 3, &seg);
+    TEST_ASSERT_EQUAL(9, seg.session);
+    TEST_ASSERT_EQUAL(4, seg.seq);
+    qmsd_rec_log_close(log);
+}
+
+TEST_CASE("a lost index is rebuilt from the segment headers", "[qmsd_recorder]")
+{
+    ram_reset();
+    qmsd_rec_log_handle_t log = qmsd_rec_log_open(&s_small, &s_io);
+    uint32_t n = 0;
+    qmsd_rec_log_begin(log, 1, 0);
+    talk(log, &n, 40);
+    qmsd_rec_log_end(log, n * 20);
+    qmsd_rec_segment_t before[2], after;
+    qmsd_rec_log_segment(log, 0, &before[0]);
+    qmsd_rec_log_segment(log, 1, &before[1]);
+    qmsd_rec_log_close(log);
+
+    int index = ram_find("/littlefs/rec/index");
+    TEST_ASSERT_GREATER_OR_EQUAL(0, index);
+    s_fs.file[index].data[0] ^= 0xff;
+
+    log = qmsd_rec_log_open(&s_small, &s_io);
+    TEST_ASSERT_NOT_NULL(log);
+    for (uint16_t i = 0; i < 2; i++) {
+        TEST_ASSERT_GREATER_OR_EQUAL(0, qmsd_rec_log_segment(log, i, &after));
+        TEST_ASSERT_EQUAL(before[i].seq, after.seq);
+        TEST_ASSERT_EQUAL(before[i].records, after.records);
+        TEST_ASSERT_EQUAL(before[i].bytes, after.bytes);
+        // the scan only sees the last record, not the time the session ended
+        TEST_ASSERT_LESS_OR_EQUAL(before[i].end_ms, after.end_ms);
+        TEST_ASSERT_GREATER_OR_EQUAL(before[i].end_ms - 20, after.end_ms);
+    }
+    TEST_ASSERT_EQUAL(-1, qmsd_rec_log_segment(log, 2, &after));
+    qmsd_rec_log_close(log);
+}
+
+typedef struct {
+    double amplification;
+    double host_mb_s;
+    double flash_kb_s;
+} rec_bench_t;
+
+static void bench(const qmsd_rec_log_config_t* config, uint32_t minutes, rec_bench_t* out) {
+    ram_reset();
+    qmsd_rec_log_handle_t log = qmsd_rec_log_open(config, &s_io);
+    TEST_ASSERT_NOT_NULL(log);
+    uint32_t base_prog = s_fs.prog_bytes, base_erase = s_fs.erases;
+
+    uint32_t n = 0;
+    clock_t t = clock();
+    qmsd_rec_log_begin(log, 1, 0);
+    talk(log, &n, minutes * 60 * 50);
+    qmsd_rec_log_end(log, n * 20);
+    double sec = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    qmsd_rec_log_stats_t stats;
+    qmsd_rec_log_get_stats(log, &stats);
+    uint32_t prog = s_fs.prog_bytes - base_prog, erases = s_fs.erases - base_erase;
+    double flash_s = ((double)prog / PROG_SIZE * T_PROG_US + (double)erases * T_ERASE_US) / 1e6;
+    out->amplification = (double)prog / stats.payload_bytes;
+    out->host_mb_s = sec > 0 ? stats.payload_bytes / sec / 1e6 : 0;
+    out->flash_kb_s = stats.payload_bytes / flash_s / 1024;
+    printf("page %5u sync %6lu: payload %lu B, programmed %lu B, %lu erases, %lu syncs, amplification %.3f, "
+           "host %.1f MB/s, flash model %.1f KB/s\n",
+           config->page_size, (unsigned long)config->sync_bytes, (unsigned long)stats.payload_bytes, (unsigned long)prog,
+           (unsigned long)erases, (unsigned long)stats.syncs, out->amplification, out->host_mb_s, out->flash_kb_s);
+    qmsd_rec_log_close(log);
+}
+
+TEST_CASE("page batching keeps write amplification low at call rate", "[qmsd_recorder]")
+{
+    const qmsd_rec_log_config_t batched = {
+        .dir = "/littlefs/rec",
+        .seg_num = 16,
+        .seg_size = 64 * 1024,
+        .page_size = 4096,
+        .sync_bytes = 32 * 1024,
+    };
+    // what a stream element writing every frame and syncing it does
+    qmsd_rec_log_config_t per_frame = batched;
+    per_frame.page_size = 168;
+    per_frame.sync_bytes = 1;
+
+    rec_bench_t a, b;
+    bench(&batched, 10, &a);
+    bench(&per_frame, 10, &b);
+
+    // 5% are the record headers, the rest skip list pointers, syncs and the index
+    TEST_ASSERT_LESS_THAN(112, (int)(a.amplification * 100));
+    TEST_ASSERT_GREATER_THAN((int)(a.amplification * 400), (int)(b.amplification * 100));
+    // two way g711 is 16KB/s, the flash has to keep up with margin to spare
+    TEST_ASSERT_GREATER_THAN(32, (int)a.flash_kb_s);
+    TEST_ASSERT_GREATER_THAN((int)b.flash_kb_s * 4, (int)a.flash_kb_s);
+}
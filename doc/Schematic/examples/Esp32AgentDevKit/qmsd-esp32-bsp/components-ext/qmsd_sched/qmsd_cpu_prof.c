@@ -0,0 +1,142 @@
+#include "string.h"
+#include "qmsd_cpu_prof.h"
+
+static const char* const g_issue_names[] = {
+    "overload", "inversion", "misplaced", "split",
+};
+
+static void add_issue(qmsd_cpu_report_t* report, uint8_t type, int8_t core, uint16_t task, uint16_t value) {
+    if (report->issue_num >= QMSD_CPU_MAX_ISSUES) {
+        report->issues_dropped++;
+        return;
+    }
+    qmsd_cpu_issue_t* issue = &report->issues[report->issue_num++];
+    issue->type = type;
+    issue->core = core;
+    issue->task = task;
+    issue->value = value;
+}
+
+static uint32_t runtime_delta(const qmsd_cpu_snapshot_t* prev, const qmsd_cpu_task_t* task, uint16_t* hint) {
+    // both snapshots list tasks in about the same order, start where the last match was
+    for (uint16_t n = 0; n < prev->task_num; n++) {
+        uint16_t i = (*hint + n) % prev->task_num;
+        if (prev->tasks[i].id == task->id) {
+            *hint = i + 1;
+            return task->runtime - prev->tasks[i].runtime;
+        }
+    }
+    return task->runtime;
+}
+
+static uint16_t permille(uint32_t part, uint32_t whole) {
+    if (whole == 0) {
+        return 0;
+    }
+    uint64_t pm = (uint64_t)part * 1000 / whole;
+    return pm > 1000 ? 1000 : (uint16_t)pm;
+}
+
+static bool is_idle(const qmsd_cpu_task_t* task) {
+    return task->base_priority == 0 && task->core >= 0 && task->core < QMSD_CPU_CORES && strncmp(task->name, "IDLE", 4) == 0;
+}
+
+static void check_groups(const qmsd_cpu_snapshot_t* cur, qmsd_cpu_report_t* report) {
+    for (uint16_t i = 0; i < report->load_num; i++) {
+        const qmsd_task_place_t* place = report->loads[i].place;
+        int8_t core = cur->tasks[report->loads[i].task].core;
+        if (place == NULL || place->group == NULL || core < 0) {
+            continue;
+        }
+        bool first = true;
+        for (uint16_t j = 0; j < i && first; j++) {
+            const qmsd_task_place_t* other = report->loads[j].place;
+            first = !(other && other->group && cur->tasks[report->loads[j].task].core >= 0 && strcmp(other->group, place->group) == 0);
+        }
+        if (!first) {
+            continue;
+        }
+        // first pinned task of its group, any later one on another core splits it
+        for (uint16_t j = i + 1; j < report->load_num; j++) {
+            const qmsd_task_place_t* other = report->loads[j].place;
+            int8_t other_core = cur->tasks[report->loads[j].task].core;
+            if (other && other->group && other_core >= 0 && other_core != core && strcmp(other->group, place->group) == 0) {
+                add_issue(report, QMSD_CPU_ISSUE_SPLIT, other_core, report->loads[j].task, 0);
+                break;
+            }
+        }
+    }
+}
+
+void qmsd_cpu_prof_analyze(const qmsd_cpu_snapshot_t* prev, const qmsd_cpu_snapshot_t* cur, uint16_t overload,
+                           qmsd_cpu_report_t* report) {
+    uint32_t idle[QMSD_CPU_CORES] = {0};
+    bool idle_seen[QMSD_CPU_CORES] = {false};
+    uint32_t unpinned = 0;
+    uint16_t hint = 0;
+
+    report->elapsed = cur->time - prev->time;
+    report->load_num = 0;
+    report->issue_num = 0;
+    report->issues_dropped = 0;
+    for (uint16_t i = 0; i < cur->task_num; i++) {
+        const qmsd_cpu_task_t* task = &cur->tasks[i];
+        uint32_t delta = runtime_delta(prev, task, &hint);
+        if (is_idle(task)) {
+            idle[task->core] += delta;
+            idle_seen[task->core] = true;
+            continue;
+        }
+        if (task->core < 0) {
+            unpinned += delta;
+        }
+        qmsd_cpu_load_t load = {
+            .task = i,
+            .load = permille(delta, report->elapsed),
+            .place = qmsd_task_plan_find(task->name),
+        };
+        // insertion keeps the heaviest first, task counts are a few dozen
+        uint16_t at = report->load_num++;
+        while (at > 0 && report->loads[at - 1].load < load.load) {
+            report->loads[at] = report->loads[at - 1];
+            at--;
+        }
+        report->loads[at] = load;
+
+        if (task->priority > task->base_priority) {
+            add_issue(report, QMSD_CPU_ISSUE_INVERSION, task->core, i, task->priority);
+        }
+        if (load.place && (load.place->core != task->core || (load.place->priority && load.place->priority != task->base_priority))) {
+            add_issue(report, QMSD_CPU_ISSUE_MISPLACED, task->core, i, (uint16_t)(load.place->core + 1));
+        }
+    }
+    report->unpinned_load = permille(unpinned, report->elapsed);
+
+    for (uint8_t core = 0; core < QMSD_CPU_CORES; core++) {
+        // no idle task: single core build, or a snapshot that missed it
+        report->core_load[core] = idle_seen[core] ? 1000 - permille(idle[core], report->elapsed) : 0;
+        if (idle_seen[core] && report->core_load[core] > overload) {
+            add_issue(report, QMSD_CPU_ISSUE_OVERLOAD, core, 0, report->core_load[core]);
+        }
+    }
+    check_groups(cur, report);
+}
+
+uint32_t qmsd_cpu_prof_group_load(const qmsd_cpu_report_t* report, const qmsd_cpu_snapshot_t* cur, const char* group,
+                                  int8_t core) {
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < report->load_num; i++) {
+        const qmsd_task_place_t* place = report->loads[i].place;
+        if (place == NULL || place->group == NULL || strcmp(place->group, group) != 0) {
+            continue;
+        }
+        if (core == QMSD_TASK_CORE_ANY || cur->tasks[report->loads[i].task].core == core) {
+            sum += report->loads[i].load;
+        }
+    }
+    return sum;
+}
+
+const char* qmsd_cpu_issue_name(qmsd_cpu_issue_type_t type) {
+    return type < sizeof(g_issue_names) / sizeof(g_issue_names[0]) ? g_issue_names[type] : "?";
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "stdint.h"
+#include "qmsd_task_plan.h"
+
+// CPU load per task and per core from two snapshots of the kernel's run time
+// counters, checked against the task plan (qmsd_task_plan.h). Loads are in
+// permille of one core: a task spinning on a core is 1000, a core is as busy
+// as its idle task is not. The analysis raises:
+//
+//   overload   a core busier than the limit
+//   inversion  a task running above its base priority, it holds a mutex a
+//              higher priority task is blocked on
+//   misplaced  a planned task off its planned core or priority
+//   split      one plan group pinned to more than one core
+//
+// Everything here is plain C on the snapshots, taking them is the port's job.
+
+#define QMSD_CPU_CORES          2
+#define QMSD_CPU_MAX_ISSUES     16
+
+typedef struct {
+    uint32_t id;                            // task number, unique for the task's life
+    char name[QMSD_TASK_NAME_LEN];
+    int8_t core;                            // affinity, QMSD_TASK_CORE_ANY for none
+    uint8_t priority;                       // current, above base while it inherits one
+    uint8_t base_priority;
+    uint32_t runtime;                       // run time counter, wraps
+} qmsd_cpu_task_t;
+
+typedef struct {
+    uint32_t time;                          // run time clock when taken, same unit as runtime
+    uint16_t task_num;
+    qmsd_cpu_task_t* tasks;
+} qmsd_cpu_snapshot_t;
+
+typedef enum {
+    QMSD_CPU_ISSUE_OVERLOAD = 0,
+    QMSD_CPU_ISSUE_INVERSION,
+    QMSD_CPU_ISSUE_MISPLACED,
+    QMSD_CPU_ISSUE_SPLIT,
+} qmsd_cpu_issue_type_t;
+
+typedef struct {
+    uint8_t type;                           // qmsd_cpu_issue_type_t
+    int8_t core;                            // overload: the core, split: the second core seen
+    uint16_t task;                          // index in the current snapshot, split: a task on the second core
+    uint16_t value;                         // overload: core load, inversion: priority, misplaced: planned core + 1
+} qmsd_cpu_issue_t;
+
+typedef struct {
+    uint16_t task;                          // index in the current snapshot
+    uint16_t load;
+    const qmsd_task_place_t* place;         // NULL when the plan does not name it
+} qmsd_cpu_load_t;
+
+typedef struct {
+    uint32_t elapsed;
+    uint16_t core_load[QMSD_CPU_CORES];
+    uint16_t unpinned_load;                 // tasks without affinity, whatever core ran them
+    uint16_t load_num;
+    qmsd_cpu_load_t* loads;                 // caller's array of the current task_num, heaviest first
+    uint8_t issue_num;
+    uint8_t issues_dropped;
+    qmsd_cpu_issue_t issues[QMSD_CPU_MAX_ISSUES];
+} qmsd_cpu_report_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// report->loads must hold cur->task_num entries. Tasks missing from prev
+// started in between and count from zero. overload is in permille.
+void qmsd_cpu_prof_analyze(const qmsd_cpu_snapshot_t* prev, const qmsd_cpu_snapshot_t* cur, uint16_t overload,
+                           qmsd_cpu_report_t* report);
+
+// Load of the tasks of a plan group, on one core or on all with QMSD_TASK_CORE_ANY.
+uint32_t qmsd_cpu_prof_group_load(const qmsd_cpu_report_t* report, const qmsd_cpu_snapshot_t* cur, const char* group,
+                                  int8_t core);
+
+const char* qmsd_cpu_issue_name(qmsd_cpu_issue_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,202 @@
+#include "stdlib.h"
+#include "string.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "qmsd_metrics.h"
+#include "qmsd_sched.h"
+
+#define TAG "QMSD_SCHED"
+
+#define PROF_STACK          3072
+#define PROF_PRIORITY       1
+#define PROF_SPARE_TASKS    8           // tasks that may appear between sizing and sampling
+#define PROF_TOP_TASKS      8
+
+QMSD_METRIC_GAUGE(s_core0_load, "cpu.core0.load_pm");
+QMSD_METRIC_GAUGE(s_core1_load, "cpu.core1.load_pm");
+QMSD_METRIC_GAUGE(s_unpinned_load, "cpu.unpinned.load_pm");
+QMSD_METRIC_COUNTER(s_overloads, "cpu.overloads");
+QMSD_METRIC_COUNTER(s_inversions, "cpu.inversions");
+QMSD_METRIC_COUNTER(s_misplaced, "cpu.misplaced");
+
+typedef struct {
+    TaskHandle_t task;
+    uint32_t period_ms;
+    uint16_t overload;
+    uint16_t capacity;
+    TaskStatus_t* status;
+    qmsd_cpu_snapshot_t snap[2];
+    qmsd_cpu_load_t* loads;
+} prof_t;
+
+static prof_t g_prof = {0};
+
+bool qmsd_sched_place(const char* name, UBaseType_t* priority, BaseType_t* core, uint32_t* stack_size) {
+    uint32_t prio = *priority;
+    int32_t plan_core = (*core >= 0 && *core < QMSD_CPU_CORES) ? *core : QMSD_TASK_CORE_ANY;
+    if (!qmsd_task_plan_apply(name, &prio, &plan_core, stack_size)) {
+        return false;
+    }
+    *priority = prio;
+    *core = plan_core == QMSD_TASK_CORE_ANY ? tskNO_AFFINITY : plan_core;
+    return true;
+}
+
+#if (configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1 && configTASKLIST_INCLUDE_COREID == 1)
+
+static void take_snapshot(qmsd_cpu_snapshot_t* snap) {
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t num = uxTaskGetSystemState(g_prof.status, g_prof.capacity, &total);
+    // the counters run on esp_timer microseconds, per core: the clock itself
+    // is the time each core had, not the kernel's total
+    snap->time = (uint32_t)esp_timer_get_time();
+    snap->task_num = num;
+    for (UBaseType_t i = 0; i < num; i++) {
+        const TaskStatus_t* status = &g_prof.status[i];
+        qmsd_cpu_task_t* task = &snap->tasks[i];
+        task->id = status->xTaskNumber;
+        strncpy(task->name, status->pcTaskName, QMSD_TASK_NAME_LEN - 1);
+        task->name[QMSD_TASK_NAME_LEN - 1] = '\0';
+        task->core = (status->xCoreID >= 0 && status->xCoreID < QMSD_CPU_CORES) ? status->xCoreID : QMSD_TASK_CORE_ANY;
+        task->priority = status->uxCurrentPriority;
+        task->base_priority = status->uxBasePriority;
+        task->runtime = status->ulRunTimeCounter;
+    }
+}
+
+static void log_report(const qmsd_cpu_report_t* report, const qmsd_cpu_snapshot_t* cur) {
+    ESP_LOGI(TAG, "core0 %u.%u%%, core1 %u.%u%%, unpinned %u.%u%% over %lu ms",
+             report->core_load[0] / 10, report->core_load[0] % 10, report->core_load[1] / 10, report->core_load[1] % 10,
+             report->unpinned_load / 10, report->unpinned_load % 10, (unsigned long)(report->elapsed / 1000));
+
+    // group totals, each group once, in the order the busiest tasks show them
+    for (uint16_t i = 0; i < report->load_num; i++) {
+        const qmsd_task_place_t* place = report->loads[i].place;
+        if (place == NULL || place->group == NULL) {
+            continue;
+        }
+        bool seen = false;
+        for (uint16_t j = 0; j < i && !seen; j++) {
+            seen = report->loads[j].place && report->loads[j].place->group && strcmp(report->loads[j].place->group, place->group) == 0;
+        }
+        if (seen) {
+            continue;
+        }
+        uint32_t on0 = qmsd_cpu_prof_group_load(report, cur, place->group, 0);
+        uint32_t on1 = qmsd_cpu_prof_group_load(report, cur, place->group, 1);
+        uint32_t all = qmsd_cpu_prof_group_load(report, cur, place->group, QMSD_TASK_CORE_ANY);
+        ESP_LOGI(TAG, "  %-8s core0 %lu.%lu%%, core1 %lu.%lu%%, unpinned %lu.%lu%%", place->group,
+                 (unsigned long)on0 / 10, (unsigned long)on0 % 10, (unsigned long)on1 / 10, (unsigned long)on1 % 10,
+                 (unsigned long)(all - on0 - on1) / 10, (unsigned long)(all - on0 - on1) % 10);
+    }
+
+    for (uint16_t i = 0; i < report->load_num && i < PROF_TOP_TASKS; i++) {
+        const qmsd_cpu_task_t* task = &cur->tasks[report->loads[i].task];
+        if (report->loads[i].load == 0) {
+            break;
+        }
+        ESP_LOGI(TAG, "  %-16s %2d  prio %2u  %3u.%u%%%s", task->name, task->core, task->base_priority,
+                 report->loads[i].load / 10, report->loads[i].load % 10, report->loads[i].place ? "" : "  (unplanned)");
+    }
+
+    for (uint8_t i = 0; i < report->issue_num; i++) {
+        const qmsd_cpu_issue_t* issue = &report->issues[i];
+        const qmsd_cpu_task_t* task = &cur->tasks[issue->task];
+        switch (issue->type) {
+            case QMSD_CPU_ISSUE_OVERLOAD:
+                qmsd_metric_inc(&s_overloads);
+                ESP_LOGW(TAG, "overload: core%d at %u.%u%%", issue->core, issue->value / 10, issue->value % 10);
+                break;
+            case QMSD_CPU_ISSUE_INVERSION:
+                qmsd_metric_inc(&s_inversions);
+                ESP_LOGW(TAG, "inversion: %s runs at %u over its %u", task->name, issue->value, task->base_priority);
+                break;
+            case QMSD_CPU_ISSUE_MISPLACED:
+                qmsd_metric_inc(&s_misplaced);
+                ESP_LOGW(TAG, "misplaced: %s on core %d prio %u, plan says core %d", task->name, task->core,
+                         task->base_priority, issue->value - 1);
+                break;
+            case QMSD_CPU_ISSUE_SPLIT:
+                ESP_LOGW(TAG, "split: %s puts group %s on core%d too", task->name,
+                         qmsd_task_plan_find(task->name)->group, issue->core);
+                break;
+        }
+    }
+    if (report->issues_dropped) {
+        ESP_LOGW(TAG, "%u more issues", report->issues_dropped);
+    }
+}
+
+static void prof_task(void* arg) {
+    uint8_t cur = 0;
+    qmsd_cpu_report_t report;
+    report.loads = g_prof.loads;
+
+    take_snapshot(&g_prof.snap[cur]);
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(g_prof.period_ms));
+        cur ^= 1;
+        take_snapshot(&g_prof.snap[cur]);
+        qmsd_cpu_prof_analyze(&g_prof.snap[cur ^ 1], &g_prof.snap[cur], g_prof.overload, &report);
+        qmsd_metric_set(&s_core0_load, report.core_load[0]);
+        qmsd_metric_set(&s_core1_load, report.core_load[1]);
+        qmsd_metric_set(&s_unpinned_load, report.unpinned_load);
+        log_report(&report, &g_prof.snap[cur]);
+    }
+}
+
+esp_err_t qmsd_cpu_prof_start(uint32_t period_ms, uint16_t overload) {
+    if (g_prof.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_prof.period_ms = period_ms;
+    g_prof.overload = overload ? overload : QMSD_CPU_PROF_OVERLOAD;
+    g_prof.capacity = uxTaskGetNumberOfTasks() + PROF_SPARE_TASKS;
+    g_prof.status = calloc(g_prof.capacity, sizeof(TaskStatus_t));
+    g_prof.snap[0].tasks = calloc(g_prof.capacity, sizeof(qmsd_cpu_task_t));
+    g_prof.snap[1].tasks = calloc(g_prof.capacity, sizeof(qmsd_cpu_task_t));
+    g_prof.loads = calloc(g_prof.capacity, sizeof(qmsd_cpu_load_t));
+    if (g_prof.status == NULL || g_prof.snap[0].tasks == NULL || g_prof.snap[1].tasks == NULL || g_prof.loads == NULL) {
+        ESP_LOGE(TAG, "No memory for %u tasks", g_prof.capacity);
+        goto qmsd_cpu_prof_start_error;
+    }
+
+    UBaseType_t prio = PROF_PRIORITY;
+    BaseType_t core = tskNO_AFFINITY;
+    uint32_t stack_size = PROF_STACK;
+    qmsd_sched_place("cpu_prof", &prio, &core, &stack_size);
+    if (xTaskCreatePinnedToCore(prof_task, "cpu_prof", stack_size, NULL, prio, &g_prof.task, core) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating task");
+        goto qmsd_cpu_prof_start_error;
+    }
+    return ESP_OK;
+
+qmsd_cpu_prof_start_error:
+    qmsd_cpu_prof_stop();
+    return ESP_FAIL;
+}
+
+void qmsd_cpu_prof_stop(void) {
+    if (g_prof.task) {
+        vTaskDelete(g_prof.task);
+    }
+    free(g_prof.status);
+    free(g_prof.snap[0].tasks);
+    free(g_prof.snap[1].tasks);
+    free(g_prof.loads);
+    memset(&g_prof, 0, sizeof(g_prof));
+}
+
+#else
+
+esp_err_t qmsd_cpu_prof_start(uint32_t period_ms, uint16_t overload) {
+    ESP_LOGE(TAG, "Needs CONFIG_FREERTOS_USE_TRACE_FACILITY, GENERATE_RUN_TIME_STATS and VTASKLIST_INCLUDE_COREID");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void qmsd_cpu_prof_stop(void) {
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "stdint.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "qmsd_task_plan.h"
+#include "qmsd_cpu_prof.h"
+
+// FreeRTOS side of the task plan and the cpu profiler. The profiler samples
+// the run time counters every period, logs load per core, per plan group and
+// the busiest tasks, and what the analysis raised (qmsd_cpu_prof.h). Loads go
+// to qmsd_metrics as cpu.core<n>.load_pm, issues count in cpu.overloads,
+// cpu.inversions and cpu.misplaced.
+//
+// Needs CONFIG_FREERTOS_USE_TRACE_FACILITY, CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+// and CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID, start fails without them.
+
+#define QMSD_CPU_PROF_OVERLOAD  900         // permille
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// qmsd_task_plan_apply on FreeRTOS types, core is tskNO_AFFINITY for none.
+bool qmsd_sched_place(const char* name, UBaseType_t* priority, BaseType_t* core, uint32_t* stack_size);
+
+// overload in permille, 0 for QMSD_CPU_PROF_OVERLOAD.
+esp_err_t qmsd_cpu_prof_start(uint32_t period_ms, uint16_t overload);
+
+void qmsd_cpu_prof_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,46 @@
+#include "string.h"
+#include "qmsd_task_plan.h"
+
+static const qmsd_task_place_t* g_plan = NULL;
+static uint16_t g_plan_num = 0;
+
+static bool name_match(const char* pattern, const char* name) {
+    size_t len = strlen(pattern);
+    if (len && pattern[len - 1] == '*') {
+        return strncmp(pattern, name, len - 1) == 0;
+    }
+    // the kernel keeps QMSD_TASK_NAME_LEN - 1 characters of a name
+    return strncmp(pattern, name, QMSD_TASK_NAME_LEN - 1) == 0;
+}
+
+void qmsd_task_plan_set(const qmsd_task_place_t* plan, uint16_t num) {
+    g_plan = plan;
+    g_plan_num = plan ? num : 0;
+}
+
+const qmsd_task_place_t* qmsd_task_plan_find(const char* name) {
+    if (name == NULL) {
+        return NULL;
+    }
+    for (uint16_t i = 0; i < g_plan_num; i++) {
+        if (name_match(g_plan[i].name, name)) {
+            return &g_plan[i];
+        }
+    }
+    return NULL;
+}
+
+bool qmsd_task_plan_apply(const char* name, uint32_t* priority, int32_t* core, uint32_t* stack_size) {
+    const qmsd_task_place_t* place = qmsd_task_plan_find(name);
+    if (place == NULL) {
+        return false;
+    }
+    if (place->priority) {
+        *priority = place->priority;
+    }
+    if (place->stack_size) {
+        *stack_size = place->stack_size;
+    }
+    *core = place->core;
+    return true;
+}
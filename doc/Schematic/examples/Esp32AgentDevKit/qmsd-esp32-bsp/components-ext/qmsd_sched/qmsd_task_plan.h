@@ -0,0 +1,46 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Task placement plan. One table, set at boot before the tasks it names start,
+// says where every known task runs:
+//
+//     static const qmsd_task_place_t plan[] = {
+//         {"mp3player", "audio", 1, 6, 0},
+//         {"gui-*",     "ui",    0, 5, 0},     // trailing '*' matches a prefix
+//     };
+//     qmsd_task_plan_set(plan, sizeof(plan) / sizeof(plan[0]));
+//
+// Creators hand their own defaults to qmsd_task_plan_apply (qmsd_thread_create
+// does it for its callers) and the plan wins where it has a value. The first
+// matching entry counts, so put exact names before prefixes. The cpu profiler
+// checks the running tasks against the same table.
+
+#define QMSD_TASK_NAME_LEN      16          // configMAX_TASK_NAME_LEN, longer names are cut
+#define QMSD_TASK_CORE_ANY      -1
+
+typedef struct {
+    const char* name;
+    const char* group;                      // tasks whose load adds up, "audio", "ui", may be NULL
+    int8_t core;                            // QMSD_TASK_CORE_ANY leaves it unpinned
+    uint8_t priority;                       // 0 keeps the creator's
+    uint16_t stack_size;                    // 0 keeps the creator's
+} qmsd_task_place_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The table is used in place, it must outlive every task creation.
+void qmsd_task_plan_set(const qmsd_task_place_t* plan, uint16_t num);
+
+const qmsd_task_place_t* qmsd_task_plan_find(const char* name);
+
+// Overwrites the values the plan has for name, returns false and leaves all
+// three alone when it has none. core uses QMSD_TASK_CORE_ANY for no affinity.
+bool qmsd_task_plan_apply(const char* name, uint32_t* priority, int32_t* core, uint32_t* stack_size);
+
+#ifdef __cplusplus
+}
+#endif
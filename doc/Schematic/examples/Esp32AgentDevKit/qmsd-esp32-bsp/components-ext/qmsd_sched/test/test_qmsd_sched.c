@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "qmsd_task_plan.h"
+#include "qmsd_cpu_prof.h"
+
+static const qmsd_task_place_t g_plan[] = {
+    {"mp3player",     "audio", 1, 6, 6144},
+    {"byte_rtc_task", "rtc",   1, 5, 0},
+    {"gui-refresh",   "ui",    0, 4, 0},
+    {"gui-*",         "ui",    0, 5, 0},
+    {"mem_report",    NULL,    QMSD_TASK_CORE_ANY, 1, 0},
+};
+
+#define PLAN_NUM    (sizeof(g_plan) / sizeof(g_plan[0]))
+
+static void task_at(qmsd_cpu_task_t* task, uint32_t id, const char* name, int8_t core, uint8_t prio, uint32_t runtime)
+{
+    memset(task, 0, sizeof(*task));
+    task->id = id;
+    strncpy(task->name, name, QMSD_TASK_NAME_LEN - 1);
+    task->core = core;
+    task->priority = prio;
+    task->base_priority = prio;
+    task->runtime = runtime;
+}
+
+static const qmsd_cpu_load_t* load_of(const qmsd_cpu_report_t* report, const qmsd_cpu_snapshot_t* cur, const char* name)
+{
+    for (uint16_t i = 0; i < report->load_num; i++) {
+        if (strcmp(cur->tasks[report->loads[i].task].name, name) == 0) {
+            return &report->loads[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t issues_of(const qmsd_cpu_report_t* report, qmsd_cpu_issue_type_t type)
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < report->issue_num; i++) {
+        n += report->issues[i].type == type;
+    }
+    return n;
+}
+
+TEST_CASE("plan entries override only what they set", "[qmsd_sched]")
+{
+    qmsd_task_plan_set(g_plan, PLAN_NUM);
+
+    uint32_t prio = 3, stack = 4096;
+    int32_t core = 0;
+    TEST_ASSERT_TRUE(qmsd_task_plan_apply("mp3player", &prio, &core, &stack));
+    TEST_ASSERT_EQUAL_UINT32(6, prio);
+    TEST_ASSERT_EQUAL_INT32(1, core);
+    TEST_ASSERT_EQUAL_UINT32(6144, stack);
+
+    prio = 3, stack = 4096, core = 1;
+    TEST_ASSERT_TRUE(qmsd_task_plan_apply("mem_report", &prio, &core, &stack));
+    TEST_ASSERT_EQUAL_UINT32(1, prio);
+    TEST_ASSERT_EQUAL_INT32(QMSD_TASK_CORE_ANY, core);
+    TEST_ASSERT_EQUAL_UINT32(4096, stack);
+
+    // exact entry before the prefix one, the prefix takes the rest
+    TEST_ASSERT_EQUAL_PTR(&g_plan[2], qmsd_task_plan_find("gui-refresh"));
+    TEST_ASSERT_EQUAL_PTR(&g_plan[3], qmsd_task_plan_find("gui-update"));
+    TEST_ASSERT_NULL(qmsd_task_plan_find("gui"));
+
+    prio = 3, stack = 4096, core = 0;
+    TEST_ASSERT_FALSE(qmsd_task_plan_apply("touch", &prio, &core, &stack));
+    TEST_ASSERT_EQUAL_UINT32(3, prio);
+    TEST_ASSERT_EQUAL_INT32(0, core);
+    TEST_ASSERT_EQUAL_UINT32(4096, stack);
+
+    // the kernel cuts names to 15 characters, the plan may keep the full one
+    static const qmsd_task_place_t long_plan[] = {{"a_very_long_task_name", NULL, 1, 2, 0}};
+    qmsd_task_plan_set(long_plan, 1);
+    TEST_ASSERT_EQUAL_PTR(&long_plan[0], qmsd_task_plan_find("a_very_long_tas"));
+    qmsd_task_plan_set(NULL, 0);
+    TEST_ASSERT_NULL(qmsd_task_plan_find("mp3player"));
+}
+
+TEST_CASE("loads come from counter deltas, idle tasks give the core load", "[qmsd_sched]")
+{
+    qmsd_task_plan_set(g_plan, PLAN_NUM);
+    qmsd_cpu_task_t prev_tasks[8], cur_tasks[8];
+    qmsd_cpu_load_t loads[8];
+    qmsd_cpu_report_t report = {.loads = loads};
+
+    // 1 s at 1 MHz, the counters of mp3player wrap in between
+    task_at(&prev_tasks[0], 1, "IDLE0", 0, 0, 5000000);
+    task_at(&prev_tasks[1], 2, "IDLE1", 1, 0, 7000000);
+    task_at(&prev_tasks[2], 3, "mp3player", 1, 6, 0xffffffff - 99999);
+    task_at(&prev_tasks[3], 4, "gui-update", 0, 5, 100);
+    task_at(&prev_tasks[4], 5, "tiT", QMSD_TASK_CORE_ANY, 18, 0);
+    qmsd_cpu_snapshot_t prev = {.time = 0xffffffff - 499999, .task_num = 5, .tasks = prev_tasks};
+
+    // listed in another order, and byte_rtc_task started in between
+    task_at(&cur_tasks[0], 4, "gui-update", 0, 5, 100 + 300000);
+    task_at(&cur_tasks[1], 1, "IDLE0", 0, 0, 5000000 + 700000);
+    task_at(&cur_tasks[2], 3, "mp3player", 1, 6, 350000);
+    task_at(&cur_tasks[3], 2, "IDLE1", 1, 0, 7000000 + 300000);
+    task_at(&cur_tasks[4], 5, "tiT", QMSD_TASK_CORE_ANY, 18, 50000);
+    task_at(&cur_tasks[5], 6, "byte_rtc_task", 1, 5, 200000);
+    qmsd_cpu_snapshot_t cur = {.time = 500000, .task_num = 6, .tasks = cur_tasks};
+
+    qmsd_cpu_prof_analyze(&prev, &cur, 900, &report);
+    TEST_ASSERT_EQUAL_UINT32(1000000, report.elapsed);
+    TEST_ASSERT_EQUAL_UINT16(300, report.core_load[0]);
+    TEST_ASSERT_EQUAL_UINT16(700, report.core_load[1]);
+    TEST_ASSERT_EQUAL_UINT16(50, report.unpinned_load);
+    TEST_ASSERT_EQUAL_UINT16(4, report.load_num);
+    TEST_ASSERT_EQUAL_UINT16(450, load_of(&report, &cur, "mp3player")->load);
+    TEST_ASSERT_EQUAL_UINT16(200, load_of(&report, &cur, "byte_rtc_task")->load);
+    TEST_ASSERT_NULL(load_of(&report, &cur, "IDLE0"));
+    TEST_ASSERT_NULL(load_of(&report, &cur, "tiT")->place);
+    // heaviest first
+    for (uint16_t i = 1; i < report.load_num; i++) {
+        TEST_ASSERT_TRUE(report.loads[i - 1].load >= report.loads[i].load);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(450, qmsd_cpu_prof_group_load(&report, &cur, "audio", 1));
+    TEST_ASSERT_EQUAL_UINT32(0, qmsd_cpu_prof_group_load(&report, &cur, "audio", 0));
+    TEST_ASSERT_EQUAL_UINT32(300, qmsd_cpu_prof_group_load(&report, &cur, "ui", QMSD_TASK_CORE_ANY));
+    // the plan held: nothing to report
+    TEST_ASSERT_EQUAL_UINT8(0, report.issue_num);
+}
+
+TEST_CASE("overload, inversion, misplacement and split groups are raised", "[qmsd_sched]")
+{
+    qmsd_task_plan_set(g_plan, PLAN_NUM);
+    qmsd_cpu_task_t prev_tasks[8], cur_tasks[8];
+    qmsd_cpu_load_t loads[8];
+    qmsd_cpu_report_t report = {.loads = loads};
+
+    task_at(&prev_tasks[0], 1, "IDLE0", 0, 0, 0);
+    task_at(&prev_tasks[1], 2, "IDLE1", 1, 0, 0);
+    qmsd_cpu_snapshot_t prev = {.time = 0, .task_num = 2, .tasks = prev_tasks};
+
+    task_at(&cur_tasks[0], 1, "IDLE0", 0, 0, 500000);
+    task_at(&cur_tasks[1], 2, "IDLE1", 1, 0, 40000);
+    // core 1 at 96 %, mp3player there as planned
+    task_at(&cur_tasks[2], 3, "mp3player", 1, 6, 900000);
+    // planned on core 1 but created on core 0
+    task_at(&cur_tasks[3], 4, "byte_rtc_task", 0, 5, 100000);
+    // gui-update boosted to 6 by a mutex an audio task waits on
+    task_at(&cur_tasks[4], 5, "gui-update", 0, 5, 400000);
+    cur_tasks[4].priority = 6;
+    // right core, wrong priority
+    task_at(&cur_tasks[5], 6, "gui-refresh", 0, 7, 0);
+    // a second audio task pinned away from the first
+    static const qmsd_task_place_t split_plan[] = {
+        {"mp3player", "audio", 1, 6, 0},
+        {"byte_rtc_task", "rtc", 1, 5, 0},
+        {"gui-refresh", "ui", 0, 4, 0},
+        {"gui-*", "ui", 0, 5, 0},
+        {"sd_capture", "audio", QMSD_TASK_CORE_ANY, 0, 0},
+    };
+    qmsd_task_plan_set(split_plan, sizeof(split_plan) / sizeof(split_plan[0]));
+    task_at(&cur_tasks[6], 7, "sd_capture", 0, 6, 10000);
+    qmsd_cpu_snapshot_t cur = {.time = 1000000, .task_num = 7, .tasks = cur_tasks};
+
+    qmsd_cpu_prof_analyze(&prev, &cur, 900, &report);
+    TEST_ASSERT_EQUAL_UINT16(500, report.core_load[0]);
+    TEST_ASSERT_EQUAL_UINT16(960, report.core_load[1]);
+
+    TEST_ASSERT_EQUAL_UINT8(1, issues_of(&report, QMSD_CPU_ISSUE_OVERLOAD));
+    TEST_ASSERT_EQUAL_UINT8(1, issues_of(&report, QMSD_CPU_ISSUE_INVERSION));
+    // byte_rtc_task by core, gui-refresh by priority, sd_capture by affinity
+    TEST_ASSERT_EQUAL_UINT8(3, issues_of(&report, QMSD_CPU_ISSUE_MISPLACED));
+    TEST_ASSERT_EQUAL_UINT8(1, issues_of(&report, QMSD_CPU_ISSUE_SPLIT));
+    for (uint8_t i = 0; i < report.issue_num; i++) {
+        const qmsd_cpu_issue_t* issue = &report.issues[i];
+        const char* name = cur.tasks[issue->task].name;
+        printf("%-9s %-14s core %d value %u\n", qmsd_cpu_issue_name(issue->type),
+               issue->type == QMSD_CPU_ISSUE_OVERLOAD ? "" : name, issue->core, issue->value);
+        if (issue->type == QMSD_CPU_ISSUE_OVERLOAD) {
+            TEST_ASSERT_EQUAL_INT8(1, issue->core);
+            TEST_ASSERT_EQUAL_UINT16(960, issue->value);
+        } else if (issue->type == QMSD_CPU_ISSUE_INVERSION) {
+            TEST_ASSERT_EQUAL_STRING("gui-update", name);
+            TEST_ASSERT_EQUAL_UINT16(6, issue->value);
+        } else if (issue->type == QMSD_CPU_ISSUE_SPLIT) {
+            TEST_ASSERT_EQUAL_STRING("sd_capture", name);
+            TEST_ASSERT_EQUAL_INT8(0, issue->core);
+        }
+    }
+    qmsd_task_plan_set(NULL, 0);
+}
+
+TEST_CASE("issues past the report size are counted, not written", "[qmsd_sched]")
+{
+    static const qmsd_task_place_t pinned[] = {{"w*", NULL, 1, 0, 0}};
+    qmsd_task_plan_set(pinned, 1);
+    qmsd_cpu_task_t cur_tasks[QMSD_CPU_MAX_ISSUES + 4];
+    qmsd_cpu_load_t loads[QMSD_CPU_MAX_ISSUES + 4];
+    qmsd_cpu_report_t report = {.loads = loads};
+    for (uint16_t i = 0; i < QMSD_CPU_MAX_ISSUES + 4; i++) {
+        char name[QMSD_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "w%u", i);
+        task_at(&cur_tasks[i], i + 1, name, 0, 3, i);
+    }
+    qmsd_cpu_snapshot_t prev = {.time = 0, .task_num = 0, .tasks = NULL};
+    qmsd_cpu_snapshot_t cur = {.time = 1000, .task_num = QMSD_CPU_MAX_ISSUES + 4, .tasks = cur_tasks};
+    qmsd_cpu_prof_analyze(&prev, &cur, 900, &report);
+    TEST_ASSERT_EQUAL_UINT8(QMSD_CPU_MAX_ISSUES, report.issue_num);
+    TEST_ASSERT_EQUAL_UINT8(4, report.issues_dropped);
+    // no idle task seen: the core loads stay unknown rather than full
+    TEST_ASSERT_EQUAL_UINT16(0, report.core_load[0]);
+    qmsd_task_plan_set(NULL, 0);
+}
@@ -0,0 +1,216 @@
+#include "stdio.h"
+#include "string.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_vfs_fat.h"
+#include "qmsd_sd_capture.h"
+#include "qmsd_sched.h"
+
+#define TAG "QMSD_SD_CAP"
+
+#define CAPTURE_SECTOR_SIZE     512
+#define CAPTURE_STACK           3072
+#define CAPTURE_PATH_LEN        64
+
+typedef struct {
+    qmsd_sd_capture_config_t config;
+    char base_path[16];
+    char prefix[16];
+    qmsd_sd_writer_handle_t writer;
+    uint8_t* buffers;
+    TaskHandle_t task;
+    SemaphoreHandle_t done;
+    int fd;
+    volatile uint8_t running;
+    volatile uint8_t stopping;
+    int64_t start_us;
+} qmsd_sd_capture_t;
+
+static qmsd_sd_capture_t g_cap = {
+    .fd = -1,
+};
+
+static int cap_write(void* ctx, const void* data, uint32_t len) {
+    return write(g_cap.fd, data, len);
+}
+
+static int cap_next_file(void* ctx, uint32_t index) {
+    if (g_cap.fd >= 0) {
+        close(g_cap.fd);
+        g_cap.fd = -1;
+    }
+    char path[CAPTURE_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s%04lu.raw", g_cap.base_path, g_cap.prefix, (unsigned long)index);
+    unlink(path);
+    int64_t t = esp_timer_get_time();
+    // one cluster run, allocated now: the writes after it only move data
+    esp_err_t ret = esp_vfs_fat_create_contiguous_file(g_cap.base_path, path, g_cap.config.file_size, true);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to preallocate %s (%s)", path, esp_err_to_name(ret));
+        return -1;
+    }
+    g_cap.fd = open(path, O_WRONLY);
+    if (g_cap.fd < 0) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return -1;
+    }
+    ESP_LOGI(TAG, "%s: %lu KB preallocated in %lld ms", path, (unsigned long)(g_cap.config.file_size / 1024), (esp_timer_get_time() - t) / 1000);
+    return 0;
+}
+
+static int cap_finish(void* ctx, uint32_t bytes) {
+    if (g_cap.fd < 0) {
+        return -1;
+    }
+    int ret = ftruncate(g_cap.fd, bytes);
+    ret |= close(g_cap.fd);
+    g_cap.fd = -1;
+    return ret;
+}
+
+static uint32_t cap_now_us(void* ctx) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+static const qmsd_sd_writer_io_t g_cap_io = {
+    .write = cap_write,
+    .next_file = cap_next_file,
+    .finish = cap_finish,
+    .now_us = cap_now_us,
+};
+
+static void capture_task(void* arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (qmsd_sd_writer_drain(g_cap.writer) > 0) {
+        }
+        if (g_cap.stopping) {
+            break;
+        }
+    }
+    if (qmsd_sd_writer_flush(g_cap.writer) != 0) {
+        ESP_LOGE(TAG, "Failed to write the capture tail");
+    }
+    xSemaphoreGive(g_cap.done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t qmsd_sd_capture_start(const qmsd_sd_capture_config_t* config) {
+    if (g_cap.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (strlen(config->base_path) >= sizeof(g_cap.base_path) || strlen(config->prefix) >= sizeof(g_cap.prefix)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_cap.config = *config;
+    strcpy(g_cap.base_path, config->base_path);
+    strcpy(g_cap.prefix, config->prefix);
+    g_cap.stopping = 0;
+
+    // sdmmc dma reads internal ram only, anything else is bounced one sector at a time
+    g_cap.buffers = heap_caps_aligned_alloc(4, QMSD_SD_WRITER_BUFFERS * config->buf_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (g_cap.done == NULL) {
+        g_cap.done = xSemaphoreCreateBinary();
+    }
+    if (g_cap.buffers == NULL || g_cap.done == NULL) {
+        ESP_LOGE(TAG, "Memory allocation failed");
+        goto capture_start_error;
+    }
+    qmsd_sd_writer_config_t writer_config = {
+        .sector_size = CAPTURE_SECTOR_SIZE,
+        .buf_size = config->buf_size,
+        .file_size = config->file_size,
+        .buffers = g_cap.buffers,
+    };
+    g_cap.writer = qmsd_sd_writer_create(&writer_config, &g_cap_io);
+    if (g_cap.writer == NULL) {
+        ESP_LOGE(TAG, "Failed to create the writer");
+        goto capture_start_error;
+    }
+    UBaseType_t prio = config->priority;
+    BaseType_t core = config->core;
+    uint32_t stack_size = CAPTURE_STACK;
+    qmsd_sched_place("sd_capture", &prio, &core, &stack_size);
+    if (xTaskCreatePinnedToCore(capture_task, "sd_capture", stack_size, NULL, prio, &g_cap.task, core) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating task");
+        goto capture_start_error;
+    }
+    g_cap.start_us = esp_timer_get_time();
+    g_cap.running = 1;
+    return ESP_OK;
+
+capture_start_error:
+    if (g_cap.writer) {
+        cap_finish(NULL, 0);
+        qmsd_sd_writer_destroy(g_cap.writer);
+        g_cap.writer = NULL;
+    }
+    heap_caps_free(g_cap.buffers);
+    g_cap.buffers = NULL;
+    return ESP_FAIL;
+}
+
+uint32_t qmsd_sd_capture_write(const void* data, uint32_t len) {
+    if (!g_cap.running) {
+        return 0;
+    }
+    uint32_t done = qmsd_sd_writer_put(g_cap.writer, data, len);
+    if (qmsd_sd_writer_pending(g_cap.writer)) {
+        xTaskNotifyGive(g_cap.task);
+    }
+    return done;
+}
+
+esp_err_t qmsd_sd_capture_stop(void) {
+    if (!g_cap.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_cap.running = 0;
+    g_cap.stopping = 1;
+    xTaskNotifyGive(g_cap.task);
+    xSemaphoreTake(g_cap.done, portMAX_DELAY);
+    g_cap.task = NULL;
+    qmsd_sd_capture_log_stats();
+    qmsd_sd_writer_destroy(g_cap.writer);
+    g_cap.writer = NULL;
+    heap_caps_free(g_cap.buffers);
+    g_cap.buffers = NULL;
+    return ESP_OK;
+}
+
+void qmsd_sd_capture_get_stats(qmsd_sd_writer_stats_t* stats) {
+    if (g_cap.writer == NULL) {
+        memset(stats, 0, sizeof(qmsd_sd_writer_stats_t));
+        return ;
+    }
+    qmsd_sd_writer_get_stats(g_cap.writer, stats);
+}
+
+void qmsd_sd_capture_log_stats(void) {
+    qmsd_sd_writer_stats_t stats;
+    qmsd_sd_capture_get_stats(&stats);
+    int64_t ms = (esp_timer_get_time() - g_cap.start_us) / 1000;
+    const qmsd_sd_writer_hist_t* hist = &stats.latency;
+    ESP_LOGI(TAG, "%llu KB in %lld ms, %lu files, %lu overruns (%llu B dropped), %lu errors",
+             stats.bytes_written / 1024, ms, (unsigned long)stats.files, (unsigned long)stats.overruns, stats.dropped, (unsigned long)stats.errors);
+    ESP_LOGI(TAG, "%lu writes of %lu B: avg %llu us, p50 %lu us, p99 %lu us, max %lu us",
+             (unsigned long)hist->count, (unsigned long)g_cap.config.buf_size, hist->count ? hist->total_us / hist->count : 0,
+             (unsigned long)qmsd_sd_writer_hist_percentile(hist, 50), (unsigned long)qmsd_sd_writer_hist_percentile(hist, 99),
+             (unsigned long)hist->max_us);
+    for (uint8_t bin = 0; bin < QMSD_SD_WRITER_HIST_BINS; bin++) {
+        if (hist->bins[bin] == 0) {
+            continue;
+        }
+        if (bin == QMSD_SD_WRITER_HIST_BINS - 1) {
+            ESP_LOGI(TAG, " >= %7lu us: %lu", (unsigned long)QMSD_SD_WRITER_HIST_MIN_US << bin, (unsigned long)hist->bins[bin]);
+        } else {
+            ESP_LOGI(TAG, "  < %7lu us: %lu", (unsigned long)QMSD_SD_WRITER_HIST_MIN_US << (bin + 1), (unsigned long)hist->bins[bin]);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "stdint.h"
+#include "esp_err.h"
+#include "qmsd_sd_writer.h"
+
+// Raw capture to a FATFS sd card (mounted by periph_sdcard, 4 line high speed
+// preferred), for logging mic channels during AEC tuning. Files are
+// <base_path>/<prefix>NNNN.raw, each one created as a contiguous cluster run
+// before the first write, so writing it never touches the FAT. Producers call
+// qmsd_sd_capture_write from the audio task; a background task writes the
+// double buffers (qmsd_sd_writer.h) and keeps a latency histogram.
+
+typedef struct {
+    const char* base_path;          // fat mount point
+    const char* prefix;
+    uint32_t file_size;             // preallocated per file, a multiple of buf_size
+    uint32_t buf_size;              // two of these in internal dma memory
+    uint8_t priority;
+    int8_t core;
+} qmsd_sd_capture_config_t;
+
+// 2 mics at 16 kHz in 32 bit slots is 128KB/s: a 32KB buffer covers 250 ms of
+// card busy time, longer than the garbage collection stalls of common cards.
+// Four channels need 64KB buffers for the same margin.
+#define QMSD_SD_CAPTURE_DEFAULT_CONFIG() {  \
+    .base_path = "/sdcard",                 \
+    .prefix = "mic",                        \
+    .file_size = 64 * 1024 * 1024,          \
+    .buf_size = 32 * 1024,                  \
+    .priority = 6,                          \
+    .core = 0,                              \
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t qmsd_sd_capture_start(const qmsd_sd_capture_config_t* config);
+
+// Never blocks, returns bytes accepted. Ignored while no capture runs.
+uint32_t qmsd_sd_capture_write(const void* data, uint32_t len);
+
+// Call from the producer, or once it stopped writing: writes what is left,
+// trims the last file and frees the buffers.
+esp_err_t qmsd_sd_capture_stop(void);
+
+void qmsd_sd_capture_get_stats(qmsd_sd_writer_stats_t* stats);
+
+// Throughput, overruns and the write latency histogram.
+void qmsd_sd_capture_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
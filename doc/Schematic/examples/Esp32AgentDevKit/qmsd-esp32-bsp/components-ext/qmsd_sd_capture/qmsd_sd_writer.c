@@ -0,0 +1,185 @@
+#include "stdlib.h"
+#include "string.h"
+#include "qmsd_sd_writer.h"
+
+typedef struct {
+    qmsd_sd_writer_config_t config;
+    qmsd_sd_writer_io_t io;
+    uint8_t* buf[QMSD_SD_WRITER_BUFFERS];
+    uint8_t full[QMSD_SD_WRITER_BUFFERS];   // handed over with acquire / release
+    // producer
+    uint8_t put_idx;
+    uint32_t fill;
+    // writer
+    uint8_t write_idx;
+    uint32_t file_index;
+    uint32_t file_bytes;
+    qmsd_sd_writer_stats_t stats;
+} sd_writer_t;
+
+static bool buf_full(sd_writer_t* w, uint8_t idx)
+{
+    return __atomic_load_n(&w->full[idx], __ATOMIC_ACQUIRE);
+}
+
+static void buf_set_full(sd_writer_t* w, uint8_t idx, uint8_t full)
+{
+    __atomic_store_n(&w->full[idx], full, __ATOMIC_RELEASE);
+}
+
+void qmsd_sd_writer_hist_add(qmsd_sd_writer_hist_t* hist, uint32_t us)
+{
+    uint8_t bin = 0;
+    for (uint32_t edge = QMSD_SD_WRITER_HIST_MIN_US * 2; us >= edge && bin < QMSD_SD_WRITER_HIST_BINS - 1; edge <<= 1) {
+        bin++;
+    }
+    hist->bins[bin]++;
+    hist->count++;
+    hist->total_us += us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+uint32_t qmsd_sd_writer_hist_percentile(const qmsd_sd_writer_hist_t* hist, uint8_t pct)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint64_t want = ((uint64_t)hist->count * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (uint8_t bin = 0; bin < QMSD_SD_WRITER_HIST_BINS - 1; bin++) {
+        seen += hist->bins[bin];
+        if (seen >= want) {
+            uint32_t edge = (uint32_t)QMSD_SD_WRITER_HIST_MIN_US << (bin + 1);
+            return edge < hist->max_us ? edge : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+qmsd_sd_writer_handle_t qmsd_sd_writer_create(const qmsd_sd_writer_config_t* config, const qmsd_sd_writer_io_t* io)
+{
+    if (config->sector_size == 0 || config->buf_size == 0 || config->buf_size % config->sector_size
+        || config->file_size < config->buf_size || config->file_size % config->buf_size || config->buffers == NULL) {
+        return NULL;
+    }
+    sd_writer_t* w = (sd_writer_t *)calloc(1, sizeof(sd_writer_t));
+    if (w == NULL) {
+        return NULL;
+    }
+    w->config = *config;
+    w->io = *io;
+    for (uint8_t i = 0; i < QMSD_SD_WRITER_BUFFERS; i++) {
+        w->buf[i] = config->buffers + i * config->buf_size;
+    }
+    if (w->io.next_file(w->io.ctx, 0) != 0) {
+        free(w);
+        return NULL;
+    }
+    w->stats.files = 1;
+    return (qmsd_sd_writer_handle_t)w;
+}
+
+void qmsd_sd_writer_destroy(qmsd_sd_writer_handle_t writer)
+{
+    free(writer);
+}
+
+uint32_t qmsd_sd_writer_put(qmsd_sd_writer_handle_t writer, const void* data, uint32_t len)
+{
+    sd_writer_t* w = (sd_writer_t *)writer;
+    const uint8_t* src = (const uint8_t *)data;
+    uint32_t done = 0;
+    while (done < len) {
+        if (buf_full(w, w->put_idx)) {
+            w->stats.overruns++;
+            w->stats.dropped += len - done;
+            break;
+        }
+        uint32_t n = w->config.buf_size - w->fill;
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(w->buf[w->put_idx] + w->fill, src + done, n);
+        w->fill += n;
+        done += n;
+        if (w->fill == w->config.buf_size) {
+            buf_set_full(w, w->put_idx, 1);
+            w->put_idx = (w->put_idx + 1) % QMSD_SD_WRITER_BUFFERS;
+            w->fill = 0;
+        }
+    }
+    w->stats.bytes_in += done;
+    return done;
+}
+
+bool qmsd_sd_writer_pending(qmsd_sd_writer_handle_t writer)
+{
+    sd_writer_t* w = (sd_writer_t *)writer;
+    return buf_full(w, w->write_idx);
+}
+
+static int write_out(sd_writer_t* w, const uint8_t* data, uint32_t len)
+{
+    if (w->file_bytes + len > w->config.file_size) {
+        if (w->io.next_file(w->io.ctx, w->file_index + 1) != 0) {
+            w->stats.errors++;
+            return -1;
+        }
+        w->file_index++;
+        w->file_bytes = 0;
+        w->stats.files++;
+    }
+    uint32_t t = w->io.now_us(w->io.ctx);
+    int ret = w->io.write(w->io.ctx, data, len);
+    qmsd_sd_writer_hist_add(&w->stats.latency, w->io.now_us(w->io.ctx) - t);
+    w->stats.writes++;
+    if (ret != (int)len) {
+        w->stats.errors++;
+        return -1;
+    }
+    w->file_bytes += len;
+    w->stats.bytes_written += len;
+    return 0;
+}
+
+int qmsd_sd_writer_drain(qmsd_sd_writer_handle_t writer)
+{
+    sd_writer_t* w = (sd_writer_t *)writer;
+    if (!buf_full(w, w->write_idx)) {
+        return 0;
+    }
+    int ret = write_out(w, w->buf[w->write_idx], w->config.buf_size);
+    // a failed write still frees the buffer, the capture goes on with a gap
+    buf_set_full(w, w->write_idx, 0);
+    w->write_idx = (w->write_idx + 1) % QMSD_SD_WRITER_BUFFERS;
+    return ret == 0 ? 1 : -1;
+}
+
+int qmsd_sd_writer_flush(qmsd_sd_writer_handle_t writer)
+{
+    sd_writer_t* w = (sd_writer_t *)writer;
+    int ret = 0;
+    for (int n; (n = qmsd_sd_writer_drain(writer)) != 0;) {
+        if (n < 0) {
+            ret = -1;
+        }
+    }
+    // the producer is done, its partial buffer is the next one in order
+    if (w->fill && write_out(w, w->buf[w->put_idx], w->fill) != 0) {
+        ret = -1;
+    }
+    w->fill = 0;
+    if (w->io.finish(w->io.ctx, w->file_bytes) != 0) {
+        w->stats.errors++;
+        ret = -1;
+    }
+    return ret;
+}
+
+void qmsd_sd_writer_get_stats(qmsd_sd_writer_handle_t writer, qmsd_sd_writer_stats_t* stats)
+{
+    sd_writer_t* w = (sd_writer_t *)writer;
+    *stats = w->stats;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Double buffered capture writer. The producer copies into one buffer while
+// the writer task empties the other with a single whole buffer write, so the
+// card's busy time (a few ms normally, a few hundred when it collects garbage)
+// only has to fit into one buffer of audio. Buffers are a multiple of the
+// sector size and the file is written strictly in order from offset 0, every
+// write starts on a sector and FATFS hands it to the card as one multi block
+// write straight from the buffer. Capture files are preallocated, when one is
+// full the writer moves on to the next.
+//
+// One producer and one writer, no locks: a buffer belongs to the producer
+// until it is marked full and to the writer until it is marked empty again.
+//
+// qmsd_sd_writer.c is portable (file ops and clock are passed in),
+// qmsd_sd_capture.c runs it on a FATFS sd card from a background task.
+
+#define QMSD_SD_WRITER_BUFFERS      2
+// bin 0: < 256 us, bin n: [128 << n, 256 << n) us, the last one is open ended
+#define QMSD_SD_WRITER_HIST_BINS    16
+#define QMSD_SD_WRITER_HIST_MIN_US  128
+
+typedef struct {
+    // returns bytes written, < 0 on error
+    int (*write)(void* ctx, const void* data, uint32_t len);
+    // close the current file (if any), open capture file index preallocated to file_size
+    int (*next_file)(void* ctx, uint32_t index);
+    // trim the current file to bytes and close it
+    int (*finish)(void* ctx, uint32_t bytes);
+    uint32_t (*now_us)(void* ctx);
+    void* ctx;
+} qmsd_sd_writer_io_t;
+
+typedef struct {
+    uint16_t sector_size;
+    uint32_t buf_size;          // bytes per buffer, a multiple of sector_size
+    uint32_t file_size;         // bytes per capture file, a multiple of buf_size
+    uint8_t* buffers;           // QMSD_SD_WRITER_BUFFERS * buf_size, dma capable on the device
+} qmsd_sd_writer_config_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t bins[QMSD_SD_WRITER_HIST_BINS];
+} qmsd_sd_writer_hist_t;
+
+typedef struct {
+    uint64_t bytes_in;          // accepted by put
+    uint64_t bytes_written;
+    uint32_t writes;
+    uint32_t files;
+    uint32_t overruns;          // puts that found both buffers full
+    uint64_t dropped;           // bytes lost to overruns
+    uint32_t errors;
+    qmsd_sd_writer_hist_t latency;  // per buffer write
+} qmsd_sd_writer_stats_t;
+
+typedef void *qmsd_sd_writer_handle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opens capture file 0. NULL on a bad config or io error.
+qmsd_sd_writer_handle_t qmsd_sd_writer_create(const qmsd_sd_writer_config_t* config, const qmsd_sd_writer_io_t* io);
+
+void qmsd_sd_writer_destroy(qmsd_sd_writer_handle_t writer);
+
+// Producer side, never blocks. Returns bytes accepted, less than len when both
+// buffers are full.
+uint32_t qmsd_sd_writer_put(qmsd_sd_writer_handle_t writer, const void* data, uint32_t len);
+
+// A full buffer waits for the writer.
+bool qmsd_sd_writer_pending(qmsd_sd_writer_handle_t writer);
+
+// Writer side: writes the oldest full buffer. 1: written, 0: none full, < 0: io error.
+int qmsd_sd_writer_drain(qmsd_sd_writer_handle_t writer);
+
+// Writer side, after the producer stopped: writes what is left, the tail may
+// be shorter than a sector, and finishes the last file.
+int qmsd_sd_writer_flush(qmsd_sd_writer_handle_t writer);
+
+void qmsd_sd_writer_get_stats(qmsd_sd_writer_handle_t writer, qmsd_sd_writer_stats_t* stats);
+
+void qmsd_sd_writer_hist_add(qmsd_sd_writer_hist_t* hist, uint32_t us);
+
+// Upper edge of the bin holding the pct percentile, max_us for the last bin.
+uint32_t qmsd_sd_writer_hist_percentile(const qmsd_sd_writer_hist_t* hist, uint8_t pct);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,392 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "qmsd_sd_writer.h"
+
+// File backed block device: capture file n is a contiguous run of sectors at
+// DATA_START + n * file_size in a host image, the way a preallocated cluster
+// run sits on the card. Every write is checked for sector alignment and
+// charged the time an sd card would take for it, on a virtual clock.
+#define SECTOR          512
+#define DATA_START      (8192 * SECTOR)
+// sd bus: 4 bit at 40 MHz moves ~20 bytes/us, 1 bit at 20 MHz ~2.5
+#define T_CMD_US        150
+#define T_MULTI_US      250         // busy after CMD25 + stop
+#define T_SINGLE_US     800         // busy after CMD24, a whole flash page programmed for one sector
+
+typedef struct {
+    FILE* image;
+    uint32_t file_size;
+    int32_t file;                   // -1 before the first next_file
+    uint32_t pos;
+    uint32_t finished_bytes;
+    uint8_t finished;
+    // card model
+    uint32_t bus_bytes_per_ms;
+    uint32_t stall_bytes;           // the card collects garbage once per this many bytes
+    uint32_t stall_us;
+    uint64_t bytes;
+    uint32_t clock_us;
+    // counters
+    uint32_t writes;
+    uint32_t multi_block;
+    uint32_t unaligned;             // writes with a partial sector
+    uint32_t last_len;
+} blockdev_t;
+
+static blockdev_t s_dev;
+
+static uint32_t card_write_us(blockdev_t* dev, uint32_t offset, uint32_t len)
+{
+    uint32_t us = 0;
+    uint32_t head = offset % SECTOR;
+    uint32_t tail = (offset + len) % SECTOR;
+    // partial sectors are read, merged and written back one at a time
+    for (int i = 0; i < 2; i++) {
+        uint32_t partial = i == 0 ? head : tail;
+        if (partial == 0 || (i == 1 && head && (offset + len) / SECTOR == offset / SECTOR)) {
+            continue;
+        }
+        us += 2 * T_CMD_US + 2 * SECTOR * 1000 / dev->bus_bytes_per_ms + T_SINGLE_US;
+    }
+    uint32_t first = (offset + SECTOR - 1) / SECTOR;
+    uint32_t last = (offset + len) / SECTOR;
+    if (last > first) {
+        uint32_t sectors = last - first;
+        us += T_CMD_US + (uint64_t)sectors * SECTOR * 1000 / dev->bus_bytes_per_ms + (sectors > 1 ? T_MULTI_US : T_SINGLE_US);
+    }
+    return us;
+}
+
+static uint32_t card_stall_us(blockdev_t* dev, uint32_t len)
+{
+    if (dev->stall_bytes && dev->bytes / dev->stall_bytes != (dev->bytes + len) / dev->stall_bytes) {
+        return dev->stall_us;
+    }
+    return 0;
+}
+
+static int dev_write(void* ctx, const void* data, uint32_t len)
+{
+    blockdev_t* dev = (blockdev_t *)ctx;
+    TEST_ASSERT_TRUE(dev->file >= 0);
+    TEST_ASSERT_TRUE(dev->pos + len <= dev->file_size);
+    uint32_t offset = DATA_START + dev->file * dev->file_size + dev->pos;
+    dev->writes++;
+    dev->multi_block += len > SECTOR;
+    dev->unaligned += (offset % SECTOR) || (len % SECTOR);
+    dev->last_len = len;
+    dev->clock_us += card_write_us(dev, offset, len);
+    dev->clock_us += card_stall_us(dev, len);
+    dev->bytes += len;
+    fseek(dev->image, offset, SEEK_SET);
+    fwrite(data, 1, len, dev->image);
+    dev->pos += len;
+    return len;
+}
+
+static int dev_next_file(void* ctx, uint32_t index)
+{
+    blockdev_t* dev = (blockdev_t *)ctx;
+    TEST_ASSERT_EQUAL_INT(dev->file + 1, index);
+    // a finished file keeps its size, the next one starts empty
+    TEST_ASSERT_TRUE(dev->file < 0 || dev->pos == dev->file_size);
+    dev->file = index;
+    dev->pos = 0;
+    return 0;
+}
+
+static int dev_finish(void* ctx, uint32_t bytes)
+{
+    blockdev_t* dev = (blockdev_t *)ctx;
+    TEST_ASSERT_EQUAL_UINT32(dev->pos, bytes);
+    dev->finished_bytes = bytes;
+    dev->finished = 1;
+    return 0;
+}
+
+static uint32_t dev_now_us(void* ctx)
+{
+    return ((blockdev_t *)ctx)->clock_us;
+}
+
+static const qmsd_sd_writer_io_t s_io = {
+    .write = dev_write,
+    .next_file = dev_next_file,
+    .finish = dev_finish,
+    .now_us = dev_now_us,
+    .ctx = &s_dev,
+};
+
+static void dev_reset(uint32_t file_size, uint32_t bus_bytes_per_ms)
+{
+    if (s_dev.image) {
+        fclose(s_dev.image);
+    }
+    memset(&s_dev, 0, sizeof(s_dev));
+    s_dev.image = tmpfile();
+    TEST_ASSERT_NOT_NULL(s_dev.image);
+    s_dev.file = -1;
+    s_dev.file_size = file_size;
+    s_dev.bus_bytes_per_ms = bus_bytes_per_ms;
+}
+
+static uint8_t pattern(uint64_t n)
+{
+    return (uint8_t)(n * 2654435761u >> 13);
+}
+
+// capture byte n went to file n / file_size
+static void check_image(uint64_t from, uint64_t to)
+{
+    uint8_t buf[SECTOR];
+    for (uint64_t n = from; n < to; n += sizeof(buf)) {
+        uint32_t len = to - n < sizeof(buf) ? (uint32_t)(to - n) : sizeof(buf);
+        fseek(s_dev.image, DATA_START + n, SEEK_SET);
+        TEST_ASSERT_EQUAL_UINT32(len, fread(buf, 1, len, s_dev.image));
+        for (uint32_t i = 0; i < len; i++) {
+            TEST_ASSERT_EQUAL_UINT8(pattern(n + i), buf[i]);
+        }
+    }
+}
+
+TEST_CASE("buffers reach the card whole and sector aligned", "[qmsd_sd_writer]")
+{
+    const uint32_t buf_size = 16 * 1024, file_size = 256 * 1024;
+    dev_reset(file_size, 20000);
+    uint8_t* buffers = malloc(QMSD_SD_WRITER_BUFFERS * buf_size);
+    qmsd_sd_writer_config_t config = {
+        .sector_size = SECTOR,
+        .buf_size = buf_size,
+        .file_size = file_size,
+        .buffers = buffers,
+    };
+    qmsd_sd_writer_handle_t w = qmsd_sd_writer_create(&config, &s_io);
+    TEST_ASSERT_NOT_NULL(w);
+
+    // odd sized chunks, like frames of an interleaved multi channel stream
+    uint8_t chunk[3000];
+    uint64_t total = 0, target = 3 * file_size + 12345;
+    srand(7);
+    while (total < target) {
+        uint32_t len = 1 + rand() % sizeof(chunk);
+        if (len > target - total) {
+            len = target - total;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            chunk[i] = pattern(total + i);
+        }
+        TEST_ASSERT_EQUAL_UINT32(len, qmsd_sd_writer_put(w, chunk, len));
+        total += len;
+        while (qmsd_sd_writer_drain(w) > 0) {
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(0, qmsd_sd_writer_flush(w));
+
+    qmsd_sd_writer_stats_t stats;
+    qmsd_sd_writer_get_stats(w, &stats);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.files);
+    TEST_ASSERT_EQUAL_UINT64(total, stats.bytes_in);
+    TEST_ASSERT_EQUAL_UINT64(total, stats.bytes_written);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+    // every write but the tail is a whole buffer, one multi block command each
+    TEST_ASSERT_EQUAL_UINT32(total / buf_size + 1, s_dev.writes);
+    TEST_ASSERT_EQUAL_UINT32(s_dev.writes, s_dev.multi_block);
+    TEST_ASSERT_EQUAL_UINT32(1, s_dev.unaligned);
+    TEST_ASSERT_EQUAL_UINT32(total % buf_size, s_dev.last_len);
+    TEST_ASSERT_TRUE(s_dev.finished);
+    TEST_ASSERT_EQUAL_UINT32(total - 3 * file_size, s_dev.finished_bytes);
+    TEST_ASSERT_EQUAL_UINT32(s_dev.writes, stats.latency.count);
+    check_image(0, total);
+
+    qmsd_sd_writer_destroy(w);
+    free(buffers);
+}
+
+TEST_CASE("a writer that falls behind drops, put never waits", "[qmsd_sd_writer]")
+{
+    const uint32_t buf_size = 4096;
+    dev_reset(64 * 1024, 20000);
+    uint8_t* buffers = malloc(QMSD_SD_WRITER_BUFFERS * buf_size);
+    qmsd_sd_writer_config_t config = {
+        .sector_size = SECTOR,
+        .buf_size = buf_size,
+        .file_size = 64 * 1024,
+        .buffers = buffers,
+    };
+    qmsd_sd_writer_handle_t w = qmsd_sd_writer_create(&config, &s_io);
+    TEST_ASSERT_NOT_NULL(w);
+
+    uint8_t chunk[3 * 4096];
+    for (uint32_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = pattern(i);
+    }
+    // both buffers fill, the third one's worth is dropped
+    TEST_ASSERT_EQUAL_UINT32(2 * buf_size, qmsd_sd_writer_put(w, chunk, sizeof(chunk)));
+    TEST_ASSERT_TRUE(qmsd_sd_writer_pending(w));
+    TEST_ASSERT_EQUAL_UINT32(0, qmsd_sd_writer_put(w, chunk, 100));
+    TEST_ASSERT_EQUAL_INT(1, qmsd_sd_writer_drain(w));
+    // one buffer free again: the stream goes on after the gap
+    TEST_ASSERT_EQUAL_UINT32(1000, qmsd_sd_writer_put(w, chunk + 2 * buf_size, 1000));
+    TEST_ASSERT_EQUAL_INT(0, qmsd_sd_writer_flush(w));
+    TEST_ASSERT_FALSE(qmsd_sd_writer_pending(w));
+
+    qmsd_sd_writer_stats_t stats;
+    qmsd_sd_writer_get_stats(w, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.overruns);
+    TEST_ASSERT_EQUAL_UINT64(buf_size + 100, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT64(2 * buf_size + 1000, stats.bytes_written);
+    check_image(0, 2 * buf_size);
+    uint8_t tail[1000];
+    fseek(s_dev.image, DATA_START + 2 * buf_size, SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(tail), fread(tail, 1, sizeof(tail), s_dev.image));
+    TEST_ASSERT_EQUAL_MEMORY(chunk + 2 * buf_size, tail, sizeof(tail));
+
+    qmsd_sd_writer_destroy(w);
+    free(buffers);
+}
+
+TEST_CASE("latency histogram bins and percentiles", "[qmsd_sd_writer]")
+{
+    qmsd_sd_writer_hist_t hist = {0};
+    TEST_ASSERT_EQUAL_UINT32(0, qmsd_sd_writer_hist_percentile(&hist, 99));
+    for (int i = 0; i < 98; i++) {
+        qmsd_sd_writer_hist_add(&hist, 1000);
+    }
+    qmsd_sd_writer_hist_add(&hist, 100);
+    qmsd_sd_writer_hist_add(&hist, 300000);
+    TEST_ASSERT_EQUAL_UINT32(1, hist.bins[0]);
+    // 1000 us is in [512, 1024)
+    TEST_ASSERT_EQUAL_UINT32(98, hist.bins[2]);
+    // 300 ms is in [262144, 524288)
+    TEST_ASSERT_EQUAL_UINT32(1, hist.bins[11]);
+    TEST_ASSERT_EQUAL_UINT32(300000, hist.max_us);
+    TEST_ASSERT_EQUAL_UINT32(1024, qmsd_sd_writer_hist_percentile(&hist, 50));
+    TEST_ASSERT_EQUAL_UINT32(1024, qmsd_sd_writer_hist_percentile(&hist, 99));
+    TEST_ASSERT_EQUAL_UINT32(300000, qmsd_sd_writer_hist_percentile(&hist, 100));
+    // beyond the last edge
+    qmsd_sd_writer_hist_add(&hist, 0xFFFFFFF0u);
+    TEST_ASSERT_EQUAL_UINT32(1, hist.bins[QMSD_SD_WRITER_HIST_BINS - 1]);
+}
+
+typedef struct {
+    uint32_t overruns;
+    uint64_t dropped;
+    uint32_t writes;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t busy_pct;
+} sim_result_t;
+
+// Producer puts one 10 ms chunk per tick. The writer task starts a write when a
+// buffer is full and the card is free, and gives the buffer back when the
+// modelled write is over.
+static sim_result_t simulate(uint32_t buf_size, uint32_t bytes_per_s, uint32_t seconds)
+{
+    const uint32_t tick_us = 10000;
+    const uint32_t chunk = bytes_per_s / 100;
+    dev_reset(1024 * buf_size, 20000);
+    s_dev.stall_bytes = 1024 * 1024;
+    s_dev.stall_us = 180000;
+    uint8_t* buffers = malloc(QMSD_SD_WRITER_BUFFERS * buf_size);
+    uint8_t* data = malloc(chunk);
+    memset(data, 0x5A, chunk);
+    qmsd_sd_writer_config_t config = {
+        .sector_size = SECTOR,
+        .buf_size = buf_size,
+        .file_size = 1024 * buf_size,
+        .buffers = buffers,
+    };
+    qmsd_sd_writer_handle_t w = qmsd_sd_writer_create(&config, &s_io);
+    TEST_ASSERT_NOT_NULL(w);
+
+    uint8_t busy = 0;
+    uint32_t start = 0, done = 0, free_at = 0, busy_us = 0;
+    for (uint32_t t = 0; t < seconds * 1000000; t += tick_us) {
+        for (;;) {
+            if (busy && done <= t) {
+                s_dev.clock_us = start;
+                TEST_ASSERT_EQUAL_INT(1, qmsd_sd_writer_drain(w));
+                TEST_ASSERT_EQUAL_UINT32(done, s_dev.clock_us);
+                busy = 0;
+                free_at = done;
+            }
+            if (busy || !qmsd_sd_writer_pending(w)) {
+                break;
+            }
+            // cost of the next write, taken from the model without doing it
+            // whatever is full now was filled by the put one tick ago
+            uint32_t full_at = t >= tick_us ? t - tick_us : 0;
+            start = free_at > full_at ? free_at : full_at;
+            done = start + card_write_us(&s_dev, 0, buf_size) + card_stall_us(&s_dev, buf_size);
+            busy_us += done - start;
+            busy = 1;
+        }
+        qmsd_sd_writer_put(w, data, chunk);
+    }
+
+    qmsd_sd_writer_stats_t stats;
+    qmsd_sd_writer_get_stats(w, &stats);
+    sim_result_t result = {
+        .overruns = stats.overruns,
+        .dropped = stats.dropped,
+        .writes = stats.writes,
+        .p50_us = qmsd_sd_writer_hist_percentile(&stats.latency, 50),
+        .p99_us = qmsd_sd_writer_hist_percentile(&stats.latency, 99),
+        .max_us = stats.latency.max_us,
+        .busy_pct = (uint32_t)((uint64_t)busy_us * 100 / (seconds * 1000000)),
+    };
+    qmsd_sd_writer_destroy(w);
+    free(data);
+    free(buffers);
+    return result;
+}
+
+TEST_CASE("double buffers ride out card stalls at raw mic rate", "[qmsd_sd_writer]")
+{
+    // 4 mics, 16 kHz, 32 bit slots out of the i2s reader
+    const uint32_t rate = 4 * 16000 * 4;
+    const uint32_t sizes[] = {4096, 16384, 65536};
+    sim_result_t result[3];
+    for (int i = 0; i < 3; i++) {
+        result[i] = simulate(sizes[i], rate, 60);
+        printf("buffers 2 x %5lu B at %lu B/s: %5lu writes, p50 %5lu us, p99 %6lu us, max %6lu us, card busy %2lu%%, %4lu overruns, %7llu B dropped\n",
+               (unsigned long)sizes[i], (unsigned long)rate, (unsigned long)result[i].writes, (unsigned long)result[i].p50_us, (unsigned long)result[i].p99_us,
+               (unsigned long)result[i].max_us, (unsigned long)result[i].busy_pct, (unsigned long)result[i].overruns,
+               (unsigned long long)result[i].dropped);
+    }
+    // a 180 ms stall needs more than one 16 ms buffer to hide behind, 256 ms is plenty
+    TEST_ASSERT_GREATER_THAN_UINT32(0, result[0].overruns);
+    TEST_ASSERT_EQUAL_UINT32(0, result[2].overruns);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(180000, result[2].max_us);
+    // the stalls show in the tail of the histogram, the common case is a few ms
+    TEST_ASSERT_LESS_THAN_UINT32(8192, result[2].p50_us);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(131072, result[2].p99_us);
+}
+
+TEST_CASE("whole buffer writes against per chunk writes", "[qmsd_sd_writer]")
+{
+    // card time for 10 s of 2 mics plus the reference: 10 ms chunks written as
+    // they come on the default 1 bit 20 MHz bus, against 32KB buffers on 4 bit 40 MHz
+    const uint32_t rate = 3 * 16000 * 4, chunk = rate / 100;
+    dev_reset(16 * 1024 * 1024, 2500);
+    uint32_t chunk_us = 0;
+    uint32_t chunk_writes = 0;
+    for (uint32_t off = 0; off < rate * 10; off += chunk) {
+        chunk_us += card_write_us(&s_dev, off, chunk);
+        chunk_writes++;
+    }
+    dev_reset(16 * 1024 * 1024, 20000);
+    uint32_t buf_us = 0;
+    uint32_t buf_writes = 0;
+    for (uint32_t off = 0; off < rate * 10; off += 32768) {
+        buf_us += card_write_us(&s_dev, off, 32768);
+        buf_writes++;
+    }
+    printf("per chunk %lu B, 1 bit: %4lu writes, %6lu ms card time; 32KB buffers, 4 bit: %3lu writes, %4lu ms card time\n",
+           (unsigned long)chunk, (unsigned long)chunk_writes, (unsigned long)chunk_us / 1000,
+           (unsigned long)buf_writes, (unsigned long)buf_us / 1000);
+    TEST_ASSERT_LESS_THAN_UINT32(chunk_us / 8, buf_us);
+}
@@ -0,0 +1,320 @@
+#include "stdlib.h"
+#include "string.h"
+#include "sensor_hub.h"
+
+#define TIME_AFTER_EQ(a, b)     ((int32_t)((a) - (b)) >= 0)
+
+typedef enum {
+    SENSOR_STATE_IDLE = 0,
+    SENSOR_STATE_CONVERTING,
+} sensor_state_t;
+
+typedef struct {
+    const sensor_hub_driver_t* driver;
+    void* ctx;
+    uint32_t period_ms;
+    uint32_t next_due;
+    uint32_t collect_at;
+    uint8_t first_channel;
+    uint8_t value_num;
+    uint8_t state;
+    uint8_t scheduled;
+} sensor_slot_t;
+
+typedef struct {
+    // seqlock: odd while the writer is inside
+    volatile uint32_t seq;
+    float value;
+    uint32_t timestamp_ms;
+    uint8_t valid;
+    // threshold
+    uint8_t level;
+    sensor_hub_threshold_cb_t cb;
+    void* user_data;
+    float low;
+    float high;
+    float hysteresis;
+} channel_slot_t;
+
+typedef struct {
+    sensor_slot_t sensor[SENSOR_HUB_MAX_SENSORS];
+    channel_slot_t channel[SENSOR_HUB_MAX_CHANNELS];
+    uint8_t sensor_num;
+    uint8_t channel_num;
+    sensor_hub_stats_t stats;
+    void (*lock)(void* arg);
+    void (*unlock)(void* arg);
+    void (*wakeup)(void* arg);
+    void* port_arg;
+} sensor_hub_t;
+
+static void hub_lock(sensor_hub_t* hub)
+{
+    if (hub->lock) {
+        hub->lock(hub->port_arg);
+    }
+}
+
+static void hub_unlock(sensor_hub_t* hub)
+{
+    if (hub->unlock) {
+        hub->unlock(hub->port_arg);
+    }
+}
+
+sensor_hub_handle_t sensor_hub_create(void)
+{
+    return (sensor_hub_handle_t)calloc(1, sizeof(sensor_hub_t));
+}
+
+void sensor_hub_delete(sensor_hub_handle_t handle)
+{
+    free(handle);
+}
+
+void sensor_hub_set_port(sensor_hub_handle_t handle, void (*lock)(void* arg), void (*unlock)(void* arg), void (*wakeup)(void* arg), void* arg)
+{
+    sensor_hub_t* hub = (sensor_hub_t*)handle;
+    hub->lock = lock;
+    hub->unlock = unlock;
+    hub->wakeup = wakeup;
+    hub->port_arg = arg;
+}
+
+int sensor_hub_register(sensor_hub_handle_t handle, const sensor_hub_driver_t* driver, void* ctx, uint8_t value_num, uint32_t period_ms)
+{
+    sensor_hub_t* hub = (sensor_hub_t*)handle;
+    if (driver) {
+        value_num = driver->value_num;
+    }
+
+    hub_lock(hub);
+    if (hub->sensor_num >= SENSOR_HUB_MAX_SENSORS || hub->channel_num + value_num > SENSOR_HUB_MAX_CHANNELS) {
+        hub_unlock(hub);
+        return -1;
+    }
+    sensor_slot_t* sensor = &hub->sensor[hub->sensor_num++];
+    sensor->driver = driver;
+    sensor->ctx = ctx;
+    sensor->period_ms = period_ms;
+    sensor->value_num = value_num;
+    sensor->first_channel = hub->channel_num;
+    sensor->state = SENSOR_STATE_IDLE;
+    // due on the next poll, that poll sets the real base time
+    sensor->scheduled = 0;
+    hub->channel_num += value_num;
+    int first_channel = sensor->first_channel;
+    hub_unlock(hub);
+
+    if (hub->wakeup) {
+        hub->wakeup(hub->port_arg);
+    }
+    return first_channel;
+}
+
+static void channel_check_threshold(channel_slot_t* ch, uint8_t channel)
+{
+    if (ch->cb == NULL) {
+        return ;
+    }
+    sensor_hub_level_t level = ch->level;
+    switch (ch->level) {
+        case SENSOR_HUB_LEVEL_ABOVE:
+            if (ch->value < ch->high - ch->hysteresis) {
+                level = SENSOR_HUB_LEVEL_NORMAL;
+            }
+            break;
+        case SENSOR_HUB_LEVEL_BELOW:
+            if (ch->value > ch->low + ch->hysteresis) {
+                level = SENSOR_HUB_LEVEL_NORMAL;
+            }
+            break;
+        default:
+            break;
+    }
+    if (level == SENSOR_HUB_LEVEL_NORMAL) {
+        if (ch->value > ch->high) {
+            level = SENSOR_HUB_LEVEL_ABOVE;
+        } else if (ch->value < ch->low) {
+            level = SENSOR_HUB_LEVEL_BELOW;
+        }
+    }
+    if (level != ch->level) {
+        ch->level = level;
+        sensor_hub_reading_t reading = {
+            .value = ch->value,
+            .timestamp_ms = ch->timestamp_ms,
+            .valid = true,
+        };
+        ch->cb(channel, &reading, level, ch->user_data);
+    }
+}
+
+static void channel_store(sensor_hub_t* hub, uint8_t channel, float value, uint32_t now_ms)
+{
+    channel_slot_t* ch = &hub->channel[channel];
+    __atomic_store_n(&ch->seq, ch->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ch->value = value;
+    ch->timestamp_ms = now_ms;
+    ch->valid = 1;
+    __atomic_store_n(&ch->seq, ch->seq + 1, __ATOMIC_RELEASE);
+    channel_check_threshold(ch, channel);
+}
+
+void sensor_hub_publish(sensor_hub_handle_t handle, uint8_t channel, float value, uint32_t now_ms)
+{
+    sensor_hub_t* hub = (sensor_hub_t*)handle;
+    if (channel >= hub->channel_num) {
+        return ;
+    }
+    hub_lock(hub);
+    channel_store(hub, channel, value, now_ms);
+    hub_unlock(hub);
+}
+
+bool sensor_hub_read(sensor_hub_handle_t handle, uint8_t channel, sensor_hub_reading_t* reading)
+{
+    sensor_hub_t* hub = (sensor_hub_t*)handle;
+    if (channel >= SENSOR_HUB_MAX_CHANNELS) {
+        return false;
+    }
+    channel_slot_t* ch = &hub->channel[channel];
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&ch->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+        reading->value = ch->value;
+        reading->timestamp_ms = ch->timestamp_ms;
+        reading->valid = ch->valid;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&ch->seq, __ATOMIC_RELAXED));
+    return reading->valid;
+}
+
+int sensor_hub_set_threshold(sensor_hub_handle_t handle, uint8_t channel, float low, float high, float hysteresis,
+                             sensor_hub_threshold_cb_t cb, void* user_data)
+{
+    sensor_hub_t* hub = (sensor_hub_t*)handle;
+    if (channel >= hub->channel_num || low > high) {
+        return -1;
+    }
+    hub_lock(hub);
+    channel_slot_t* ch = &hub->channel[channel];
+    ch->low = low;
+    ch->high = high;
+    ch->hysteresis = hysteresis;
+    ch->user_data = user_data;
+    ch->level = SENSOR_HUB_LEVEL_NORMAL;
+    ch->cb = cb;
+    hub_unlock(hub);
+    return 0;
+}
+
+static void sensor_finish(sensor_slot_t* sensor, uint32_t now_ms)
+{
+    sensor->state = SENSOR_STATE_IDLE;
+    sensor->next_due += sensor->period_ms;
+    // fell behind (slow bus, long busy retries): skip, do not burst to catch up
+    if (TIME_AFTER_EQ(now_ms, sensor->next_due)) {
+        sensor->next_due = now_ms + sensor->period_ms;
+    }
+}
+
+static void sensor_collect(sensor_hub_t* hub, sensor_slot_t* sensor, uint32_t now_ms)
+{
+    float values[SENSOR_HUB_MAX_CHANNELS];
+    int ret = sensor->driver->collect(sensor->ctx, values);
+    if (ret > 0) {
+        sensor->collect_at = now_ms + ret;
+        return ;
+    }
+    if (ret == 0) {
+        hub->stats.conversions++;
+        for (uint8_t i = 0; i < sensor->value_num; i++) {
+            channel_store(hub, sensor->first_channel + i, values[i], now_ms);
+        }
+    } else {
+        hub->stats.errors++;
+    }
+    sensor_finish(sensor, now_ms);
+}
+
+uint32_t sensor_hub_poll(sensor_hub_handle_t handle, uint32_t now_ms)
+{
+    sensor_hub_t* hub = (sensor_hub_t*)handle;
+    uint32_t next = SENSOR_HUB_IDLE_MS;
+    bool batch = false;
+
+    hub_lock(hub);
+
+    // 1. collect every conversion that is done
+    for (uint8_t i = 0; i < hub->sensor_num; i++) {
+        sensor_slot_t* sensor = &hub->sensor[i];
+        if (sensor->driver && sensor->state == SENSOR_STATE_CONVERTING && TIME_AFTER_EQ(now_ms, sensor->collect_at)) {
+            sensor_collect(hub, sensor, now_ms);
+        }
+    }
+
+    // 2. one due sensor opens a batch, everything due shortly after joins it
+    for (uint8_t i = 0; i < hub->sensor_num; i++) {
+        sensor_slot_t* sensor = &hub->sensor[i];
+        if (sensor->driver && sensor->state == SENSOR_STATE_IDLE && (!sensor->scheduled || TIME_AFTER_EQ(now_ms, sensor->next_due))) {
+            batch = true;
+            break;
+        }
+    }
+    if (batch) {
+        hub->stats.batches++;
+        for (uint8_t i = 0; i < hub->sensor_num; i++) {
+            sensor_slot_t* sensor = &hub->sensor[i];
+            if (sensor->driver == NULL || sensor->state != SENSOR_STATE_IDLE) {
+                continue;
+            }
+            if (!sensor->scheduled) {
+                sensor->scheduled = 1;
+                sensor->next_due = now_ms;
+            } else if (!TIME_AFTER_EQ(now_ms + SENSOR_HUB_BATCH_WINDOW_MS, sensor->next_due)) {
+                continue;
+            }
+            if (sensor->driver->start && sensor->driver->start(sensor->ctx) < 0) {
+                hub->stats.errors++;
+                sensor_finish(sensor, now_ms);
+                continue;
+            }
+            sensor->state = SENSOR_STATE_CONVERTING;
+            sensor->collect_at = now_ms + sensor->driver->conv_time_ms;
+        }
+        // zero conversion time sensors (always-on ALS...) are read in the same pass
+        for (uint8_t i = 0; i < hub->sensor_num; i++) {
+            sensor_slot_t* sensor = &hub->sensor[i];
+            if (sensor->driver && sensor->state == SENSOR_STATE_CONVERTING && TIME_AFTER_EQ(now_ms, sensor->collect_at)) {
+                sensor_collect(hub, sensor, now_ms);
+            }
+        }
+    }
+
+    // 3. sleep until the next collect or the next due sensor
+    for (uint8_t i = 0; i < hub->sensor_num; i++) {
+        sensor_slot_t* sensor = &hub->sensor[i];
+        if (sensor->driver == NULL) {
+            continue;
+        }
+        uint32_t at = sensor->state == SENSOR_STATE_CONVERTING ? sensor->collect_at : sensor->next_due;
+        uint32_t wait = TIME_AFTER_EQ(now_ms, at) ? 0 : at - now_ms;
+        if (wait < next) {
+            next = wait;
+        }
+    }
+
+    hub_unlock(hub);
+    return next;
+}
+
+void sensor_hub_get_stats(sensor_hub_handle_t handle, sensor_hub_stats_t* stats)
+{
+    sensor_hub_t* hub = (sensor_hub_t*)handle;
+    *stats = hub->stats;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Batched sensor acquisition: every sensor due in the same window gets its
+// conversion started in one go, results are collected once the conversion
+// time has elapsed, so nothing blocks on a sensor. The latest value of every
+// channel is cached with a timestamp and can be read lock free from any task.
+//
+// sensor_hub.c is portable (time is passed in), sensor_hub_task.c runs it on FreeRTOS.
+
+#define SENSOR_HUB_MAX_SENSORS      8
+#define SENSOR_HUB_MAX_CHANNELS     16
+// sensors due within this window are pulled into the same batch
+#define SENSOR_HUB_BATCH_WINDOW_MS  20
+#define SENSOR_HUB_IDLE_MS          0xffffffffUL
+
+typedef void *sensor_hub_handle_t;
+
+typedef struct {
+    const char* name;
+    uint8_t value_num;          // channels produced by one conversion
+    uint16_t conv_time_ms;      // start -> first collect
+    // kick off a conversion, must not wait for it
+    int (*start)(void* ctx);
+    // 0: values are filled in, >0: call again after that many ms (busy or next phase), <0: error
+    int (*collect)(void* ctx, float* values);
+} sensor_hub_driver_t;
+
+typedef struct {
+    float value;
+    uint32_t timestamp_ms;
+    bool valid;
+} sensor_hub_reading_t;
+
+typedef enum {
+    SENSOR_HUB_LEVEL_NORMAL = 0,
+    SENSOR_HUB_LEVEL_ABOVE,
+    SENSOR_HUB_LEVEL_BELOW,
+} sensor_hub_level_t;
+
+typedef void (*sensor_hub_threshold_cb_t)(uint8_t channel, const sensor_hub_reading_t* reading, sensor_hub_level_t level, void* user_data);
+
+typedef struct {
+    uint32_t batches;
+    uint32_t conversions;
+    uint32_t errors;
+} sensor_hub_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+sensor_hub_handle_t sensor_hub_create(void);
+
+void sensor_hub_delete(sensor_hub_handle_t hub);
+
+// Returns the first channel of the sensor, -1 when full. A NULL driver
+// registers push only channels that are fed by sensor_hub_publish.
+int sensor_hub_register(sensor_hub_handle_t hub, const sensor_hub_driver_t* driver, void* ctx, uint8_t value_num, uint32_t period_ms);
+
+// Run due work, returns the ms until it needs to run again (SENSOR_HUB_IDLE_MS when nothing is registered).
+uint32_t sensor_hub_poll(sensor_hub_handle_t hub, uint32_t now_ms);
+
+void sensor_hub_publish(sensor_hub_handle_t hub, uint8_t channel, float value, uint32_t now_ms);
+
+// Lock free, safe from any task while the hub is running.
+bool sensor_hub_read(sensor_hub_handle_t hub, uint8_t channel, sensor_hub_reading_t* reading);
+
+// Edge triggered: cb runs when the channel leaves [low, high] and again when it comes back
+// past the hysteresis. Runs in the hub context, keep it short.
+int sensor_hub_set_threshold(sensor_hub_handle_t hub, uint8_t channel, float low, float high, float hysteresis,
+                             sensor_hub_threshold_cb_t cb, void* user_data);
+
+void sensor_hub_get_stats(sensor_hub_handle_t hub, sensor_hub_stats_t* stats);
+
+// Hooks for the task wrapper: serialize register/poll and wake the poll loop.
+void sensor_hub_set_port(sensor_hub_handle_t hub, void (*lock)(void* arg), void (*unlock)(void* arg), void (*wakeup)(void* arg), void* arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,140 @@
+#include "stddef.h"
+#include "sensor_hub_drivers.h"
+
+#define AHT20_CMD_MEASURE       0xac
+#define AHT20_CMD_STATUS        0x71
+#define AHT20_STATUS_BUSY       0x80
+#define AHT20_CONV_MS           80
+#define AHT20_BUSY_RETRY_MS     10
+
+#define SHT20_CMD_TEMP_NO_HOLD  0xf3
+#define SHT20_CMD_HUM_NO_HOLD   0xf5
+#define SHT20_TEMP_CONV_MS      85
+#define SHT20_HUM_CONV_MS       29
+
+#define LTR303_REG_DATA_CH1_0   0x88
+
+// -------------------- AHT20 --------------------
+static int aht20_start(void* ctx) {
+    sensor_hub_aht20_t* aht20 = (sensor_hub_aht20_t *)ctx;
+    uint8_t data[2] = {0x33, 0x00};
+    return i2c_write_bytes(aht20->dev, AHT20_CMD_MEASURE, data, 2) == I2C_OK ? 0 : -1;
+}
+
+static int aht20_collect(void* ctx, float* values) {
+    sensor_hub_aht20_t* aht20 = (sensor_hub_aht20_t *)ctx;
+    uint8_t data[6] = {0x00};
+    if (i2c_read_bytes(aht20->dev, AHT20_CMD_STATUS, data, 6) != I2C_OK) {
+        return -1;
+    }
+    if (data[0] & AHT20_STATUS_BUSY) {
+        return AHT20_BUSY_RETRY_MS;
+    }
+    uint32_t hum = (data[1] << 12) | (data[2] << 4) | ((data[3] >> 4) & 0x0f);
+    uint32_t temp = ((data[3] & 0x0f) << 16) | (data[4] << 8) | data[5];
+    values[0] = (float)temp / 1048576.0 * 200.0 - 50.0;
+    values[1] = (float)hum / 1048576.0;
+    return 0;
+}
+
+const sensor_hub_driver_t sensor_hub_aht20_driver = {
+    .name = "aht20",
+    .value_num = 2,
+    .conv_time_ms = AHT20_CONV_MS,
+    .start = aht20_start,
+    .collect = aht20_collect,
+};
+
+// -------------------- SHT20 --------------------
+static uint8_t sht20_check_crc(uint8_t* data, uint8_t bytes, uint8_t checksum) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < bytes; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 8; bit > 0; --bit) {
+            if (crc & 0x80) {
+                crc = (crc << 1) ^ 0x131;
+            } else {
+                crc = (crc << 1);
+            }
+        }
+    }
+    return checksum == crc;
+}
+
+void sensor_hub_sht20_init(sensor_hub_sht20_t* sht20, I2CDevice_t dev) {
+    sht20->dev = dev;
+    sht20->phase = 0;
+    i2c_device_set_reg_bits(dev, I2C_NO_REG);
+}
+
+static int sht20_start(void* ctx) {
+    sensor_hub_sht20_t* sht20 = (sensor_hub_sht20_t *)ctx;
+    sht20->phase = 0;
+    return i2c_write_byte(sht20->dev, 0, SHT20_CMD_TEMP_NO_HOLD) == I2C_OK ? 0 : -1;
+}
+
+// temperature and humidity are two conversions, the second one is started from the first collect
+static int sht20_collect(void* ctx, float* values) {
+    sensor_hub_sht20_t* sht20 = (sensor_hub_sht20_t *)ctx;
+    uint8_t data[3];
+    if (i2c_read_bytes(sht20->dev, 0, data, 3) != I2C_OK || !sht20_check_crc(data, 2, data[2])) {
+        return -1;
+    }
+    uint16_t raw = ((data[0] << 8) | data[1]) & ~0x0003;
+    if (sht20->phase == 0) {
+        sht20->temperature = -46.85 + 175.72 / 65536 * (float)raw;
+        if (i2c_write_byte(sht20->dev, 0, SHT20_CMD_HUM_NO_HOLD) != I2C_OK) {
+            return -1;
+        }
+        sht20->phase = 1;
+        return SHT20_HUM_CONV_MS;
+    }
+    values[0] = sht20->temperature;
+    values[1] = -6.0 + 125.0 / 65536.0 * (float)raw;
+    return 0;
+}
+
+const sensor_hub_driver_t sensor_hub_sht20_driver = {
+    .name = "sht20",
+    .value_num = 2,
+    .conv_time_ms = SHT20_TEMP_CONV_MS,
+    .start = sht20_start,
+    .collect = sht20_collect,
+};
+
+// -------------------- LTR303 --------------------
+static int ltr303_collect(void* ctx, float* values) {
+    sensor_hub_ltr303_t* ltr303 = (sensor_hub_ltr303_t *)ctx;
+    uint8_t data[4] = {0x00};
+    // ch1 low/high then ch0 low/high, read in one burst so both come from the same integration
+    if (i2c_read_bytes(ltr303->dev, LTR303_REG_DATA_CH1_0, data, 4) != I2C_OK) {
+        return -1;
+    }
+    float ch1 = (float)(data[0] | (data[1] << 8));
+    float ch0 = (float)(data[2] | (data[3] << 8));
+    values[0] = ch0;
+    values[1] = ch1;
+
+    // lux, LTR-303ALS-01 appendix A
+    float gain = ltr303->gain ? ltr303->gain : 1;
+    float als_int = ltr303->integration_ms ? ltr303->integration_ms / 100.0 : 1.0;
+    float ratio = (ch0 + ch1) > 0 ? ch1 / (ch0 + ch1) : 0;
+    float lux = 0;
+    if (ratio < 0.45) {
+        lux = (1.7743 * ch0 + 1.1059 * ch1) / gain / als_int;
+    } else if (ratio < 0.64) {
+        lux = (4.2785 * ch0 - 1.9548 * ch1) / gain / als_int;
+    } else if (ratio < 0.85) {
+        lux = (0.5926 * ch0 + 0.1185 * ch1) / gain / als_int;
+    }
+    values[2] = lux;
+    return 0;
+}
+
+const sensor_hub_driver_t sensor_hub_ltr303_driver = {
+    .name = "ltr303",
+    .value_num = 3,
+    .conv_time_ms = 0,
+    .start = NULL,
+    .collect = ltr303_collect,
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "stdint.h"
+#include "i2c_device.h"
+#include "sensor_hub.h"
+
+// Non blocking adapters of the qmsd_sensor i2c sensors for the hub.
+// Each takes its own I2CDevice_t, so the hub task is the only one on the bus for them.
+
+typedef struct {
+    I2CDevice_t dev;
+} sensor_hub_aht20_t;
+
+typedef struct {
+    I2CDevice_t dev;
+    uint8_t phase;
+    float temperature;
+} sensor_hub_sht20_t;
+
+typedef struct {
+    I2CDevice_t dev;
+    uint8_t gain;               // ltr303_gain_t factor: 1, 2, 4, 8, 48, 96
+    uint16_t integration_ms;    // 50 ... 400
+} sensor_hub_ltr303_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// channels: temperature (C), humidity (0 - 1)
+extern const sensor_hub_driver_t sensor_hub_aht20_driver;
+
+// channels: temperature (C), humidity (%RH)
+extern const sensor_hub_driver_t sensor_hub_sht20_driver;
+
+// channels: ch0 (visible + ir), ch1 (ir), lux. The chip free runs, collect only reads it.
+extern const sensor_hub_driver_t sensor_hub_ltr303_driver;
+
+void sensor_hub_sht20_init(sensor_hub_sht20_t* sht20, I2CDevice_t dev);
+
+#ifdef __cplusplus
+}
+#endif
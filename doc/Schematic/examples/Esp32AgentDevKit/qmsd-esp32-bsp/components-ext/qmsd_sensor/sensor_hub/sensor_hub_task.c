@@ -0,0 +1,76 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sensor_hub.h"
+#include "sensor_hub_task.h"
+#include "qmsd_sched.h"
+
+#define TAG "SENSOR_HUB"
+
+typedef struct {
+    sensor_hub_handle_t hub;
+    SemaphoreHandle_t mutex;
+    TaskHandle_t task;
+} sensor_hub_port_t;
+
+static void port_lock(void* arg) {
+    xSemaphoreTakeRecursive(((sensor_hub_port_t *)arg)->mutex, portMAX_DELAY);
+}
+
+static void port_unlock(void* arg) {
+    xSemaphoreGiveRecursive(((sensor_hub_port_t *)arg)->mutex);
+}
+
+static void port_wakeup(void* arg) {
+    sensor_hub_port_t* port = (sensor_hub_port_t *)arg;
+    if (port->task) {
+        xTaskNotifyGive(port->task);
+    }
+}
+
+uint32_t sensor_hub_now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void sensor_hub_task(void *arg) {
+    sensor_hub_port_t* port = (sensor_hub_port_t *)arg;
+    for (;;) {
+        uint32_t wait_ms = sensor_hub_poll(port->hub, sensor_hub_now_ms());
+        TickType_t ticks = (wait_ms == SENSOR_HUB_IDLE_MS) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms);
+        // registering a sensor notifies, so an idle hub does not need to wake up at all
+        ulTaskNotifyTake(pdTRUE, ticks);
+    }
+}
+
+sensor_hub_handle_t sensor_hub_task_start(uint8_t priority, int8_t core) {
+    sensor_hub_port_t* port = (sensor_hub_port_t *)calloc(1, sizeof(sensor_hub_port_t));
+    if (port == NULL) {
+        return NULL;
+    }
+    port->hub = sensor_hub_create();
+    port->mutex = xSemaphoreCreateRecursiveMutex();
+    if (port->hub == NULL || port->mutex == NULL) {
+        ESP_LOGE(TAG, "Memory allocation failed");
+        goto sensor_hub_start_error;
+    }
+    sensor_hub_set_port(port->hub, port_lock, port_unlock, port_wakeup, port);
+    UBaseType_t prio = priority;
+    BaseType_t task_core = core;
+    uint32_t stack_size = 3 * 1024;
+    qmsd_sched_place("sensor_hub", &prio, &task_core, &stack_size);
+    if (xTaskCreatePinnedToCore(sensor_hub_task, "sensor_hub", stack_size, port, prio, &port->task, task_core) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating task");
+        goto sensor_hub_start_error;
+    }
+    return port->hub;
+
+sensor_hub_start_error:
+    if (port->mutex) {
+        vSemaphoreDelete(port->mutex);
+    }
+    sensor_hub_delete(port->hub);
+    free(port);
+    return NULL;
+}
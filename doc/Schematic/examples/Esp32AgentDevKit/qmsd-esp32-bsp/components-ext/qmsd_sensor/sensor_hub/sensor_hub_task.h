@@ -0,0 +1,18 @@
+#pragma once
+
+#include "stdint.h"
+#include "sensor_hub.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create a hub and the task that drives it. Sensors can be registered before or after.
+sensor_hub_handle_t sensor_hub_task_start(uint8_t priority, int8_t core);
+
+// Time base used by the task, for sensor_hub_publish from push sources.
+uint32_t sensor_hub_now_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host stand-in for the i2c_bus hal header, only what i2c_device.h users need.
+
+#define I2C_OK              0
+#define I2C_FAIL            -1
+#define I2C_ERR_INVALID_ARG 0x102
@@ -0,0 +1,97 @@
+#include "string.h"
+#include "sim_i2c.h"
+
+#define AHT20_CONV_MS       75
+#define SHT20_TEMP_CONV_MS  85
+#define SHT20_HUM_CONV_MS   29
+
+uint32_t sim_now_ms = 0;
+
+I2CDevice_t sim_i2c_device(sim_device_t* dev, sim_type_t type) {
+    memset(dev, 0, sizeof(sim_device_t));
+    dev->type = type;
+    return (I2CDevice_t)dev;
+}
+
+static uint8_t sht20_crc(uint8_t* data, uint8_t bytes) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < bytes; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 8; bit > 0; --bit) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x131 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+int i2c_device_set_reg_bits(I2CDevice_t i2c_device, uint32_t reg_bit) {
+    ((sim_device_t *)i2c_device)->reg_bit = reg_bit;
+    return I2C_OK;
+}
+
+int i2c_write_bytes(I2CDevice_t i2c_device, uint32_t reg_addr, uint8_t *data, uint16_t length) {
+    sim_device_t* dev = (sim_device_t *)i2c_device;
+    dev->transfers++;
+    uint8_t cmd = dev->reg_bit == I2C_NO_REG ? data[0] : reg_addr;
+    dev->cmd = cmd;
+    dev->started_ms = sim_now_ms;
+    return I2C_OK;
+}
+
+int i2c_write_byte(I2CDevice_t i2c_device, uint32_t reg_addr, uint8_t data) {
+    return i2c_write_bytes(i2c_device, reg_addr, &data, 1);
+}
+
+int i2c_read_bytes(I2CDevice_t i2c_device, uint32_t reg_addr, uint8_t *data, uint16_t length) {
+    sim_device_t* dev = (sim_device_t *)i2c_device;
+    dev->transfers++;
+    switch (dev->type) {
+        case SIM_AHT20: {
+            if (length < 6) {
+                return I2C_FAIL;
+            }
+            uint32_t hum = (uint32_t)(dev->humidity * 1048576.0);
+            uint32_t temp = (uint32_t)((dev->temperature + 50.0) / 200.0 * 1048576.0);
+            data[0] = 0x18;
+            if (dev->cmd == 0xac && sim_now_ms - dev->started_ms < AHT20_CONV_MS) {
+                data[0] |= 0x80;
+            }
+            data[1] = hum >> 12;
+            data[2] = hum >> 4;
+            data[3] = ((hum & 0x0f) << 4) | ((temp >> 16) & 0x0f);
+            data[4] = temp >> 8;
+            data[5] = temp;
+            return I2C_OK;
+        }
+        case SIM_SHT20: {
+            uint16_t raw;
+            if (dev->cmd == 0xf3) {
+                if (sim_now_ms - dev->started_ms < SHT20_TEMP_CONV_MS) {
+                    return I2C_FAIL;    // nack while measuring
+                }
+                raw = (uint16_t)((dev->temperature + 46.85) * 65536.0 / 175.72);
+            } else if (dev->cmd == 0xf5) {
+                if (sim_now_ms - dev->started_ms < SHT20_HUM_CONV_MS) {
+                    return I2C_FAIL;
+                }
+                raw = (uint16_t)((dev->humidity + 6.0) * 65536.0 / 125.0);
+            } else {
+                return I2C_FAIL;
+            }
+            data[0] = raw >> 8;
+            data[1] = raw & 0xfc;
+            data[2] = sht20_crc(data, 2) ^ (dev->corrupt_crc ? 0x5a : 0);
+            return I2C_OK;
+        }
+        case SIM_LTR303: {
+            uint8_t regs[4] = {dev->ch1 & 0xff, dev->ch1 >> 8, dev->ch0 & 0xff, dev->ch0 >> 8};
+            if (reg_addr < 0x88 || reg_addr + length > 0x8c) {
+                return I2C_FAIL;
+            }
+            memcpy(data, &regs[reg_addr - 0x88], length);
+            return I2C_OK;
+        }
+        default:
+            return I2C_FAIL;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "stdint.h"
+#include "i2c_device.h"
+
+// Register level models of the hub sensors behind the i2c_device.h api.
+
+typedef enum {
+    SIM_AHT20,
+    SIM_SHT20,
+    SIM_LTR303,
+} sim_type_t;
+
+typedef struct {
+    sim_type_t type;
+    uint8_t reg_bit;
+    // measured quantity
+    float temperature;
+    float humidity;
+    uint16_t ch0;
+    uint16_t ch1;
+    // conversion in flight
+    uint8_t cmd;
+    uint32_t started_ms;
+    uint8_t corrupt_crc;
+    uint32_t transfers;
+} sim_device_t;
+
+extern uint32_t sim_now_ms;
+
+I2CDevice_t sim_i2c_device(sim_device_t* dev, sim_type_t type);
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "sensor_hub.h"
+#include "sensor_hub_drivers.h"
+#include "sim_i2c.h"
+
+// drive the hub like its task does: sleep for what poll returns, bounded by `until`
+static uint32_t run_until(sensor_hub_handle_t hub, uint32_t until)
+{
+    uint32_t wakeups = 0;
+    while ((int32_t)(until - sim_now_ms) > 0) {
+        uint32_t wait = sensor_hub_poll(hub, sim_now_ms);
+        wakeups++;
+        if (wait == SENSOR_HUB_IDLE_MS || (int32_t)(until - sim_now_ms) < (int32_t)wait) {
+            sim_now_ms = until;
+        } else {
+            sim_now_ms += wait ? wait : 1;
+        }
+    }
+    return wakeups;
+}
+
+TEST_CASE("sensor hub batches conversions and caches values", "[sensor_hub]")
+{
+    sim_device_t aht20_sim, sht20_sim, ltr303_sim;
+    sensor_hub_aht20_t aht20 = { .dev = sim_i2c_device(&aht20_sim, SIM_AHT20) };
+    sensor_hub_sht20_t sht20;
+    sensor_hub_sht20_init(&sht20, sim_i2c_device(&sht20_sim, SIM_SHT20));
+    sensor_hub_ltr303_t ltr303 = { .dev = sim_i2c_device(&ltr303_sim, SIM_LTR303), .gain = 1, .integration_ms = 100 };
+    aht20_sim.temperature = 23.5;
+    aht20_sim.humidity = 0.41;
+    sht20_sim.temperature = 25.0;
+    sht20_sim.humidity = 55.0;
+    ltr303_sim.ch0 = 1000;
+    ltr303_sim.ch1 = 200;
+
+    sim_now_ms = 5000;
+    sensor_hub_handle_t hub = sensor_hub_create();
+    int aht20_ch = sensor_hub_register(hub, &sensor_hub_aht20_driver, &aht20, 0, 1000);
+    int sht20_ch = sensor_hub_register(hub, &sensor_hub_sht20_driver, &sht20, 0, 1000);
+    int ltr303_ch = sensor_hub_register(hub, &sensor_hub_ltr303_driver, &ltr303, 0, 500);
+    TEST_ASSERT_EQUAL(0, aht20_ch);
+    TEST_ASSERT_EQUAL(2, sht20_ch);
+    TEST_ASSERT_EQUAL(4, ltr303_ch);
+
+    sensor_hub_reading_t reading;
+    TEST_ASSERT_FALSE(sensor_hub_read(hub, aht20_ch, &reading));
+
+    // first poll starts both humidity sensors together and reads the free running ltr303 at once
+    uint32_t wait = sensor_hub_poll(hub, sim_now_ms);
+    TEST_ASSERT_EQUAL_UINT32(5000, aht20_sim.started_ms);
+    TEST_ASSERT_EQUAL_UINT32(5000, sht20_sim.started_ms);
+    TEST_ASSERT_EQUAL(80, wait);
+    TEST_ASSERT_TRUE(sensor_hub_read(hub, ltr303_ch + 2, &reading));
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 1995.5, reading.value);
+    TEST_ASSERT_EQUAL_UINT32(5000, reading.timestamp_ms);
+
+    run_until(hub, 5200);
+    TEST_ASSERT_TRUE(sensor_hub_read(hub, aht20_ch, &reading));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 23.5, reading.value);
+    TEST_ASSERT_EQUAL_UINT32(5080, reading.timestamp_ms);
+    TEST_ASSERT_TRUE(sensor_hub_read(hub, aht20_ch + 1, &reading));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.41, reading.value);
+    TEST_ASSERT_TRUE(sensor_hub_read(hub, sht20_ch, &reading));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 25.0, reading.value);
+    TEST_ASSERT_TRUE(sensor_hub_read(hub, sht20_ch + 1, &reading));
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 55.0, reading.value);
+    // temperature at 85 ms, humidity conversion started from that collect
+    TEST_ASSERT_EQUAL_UINT32(5085 + 29, reading.timestamp_ms);
+
+    sensor_hub_stats_t stats;
+    sensor_hub_get_stats(hub, &stats);
+    TEST_ASSERT_EQUAL(1, stats.batches);
+    TEST_ASSERT_EQUAL(3, stats.conversions);
+    TEST_ASSERT_EQUAL(0, stats.errors);
+
+    // 500 ms and 1000 ms periods line up into shared batches
+    run_until(hub, 8000);
+    sensor_hub_get_stats(hub, &stats);
+    TEST_ASSERT_EQUAL(6, stats.batches);
+    TEST_ASSERT_EQUAL(3 + 2 * 3 + 3, stats.conversions);
+    sensor_hub_delete(hub);
+}
+
+TEST_CASE("sensor hub ltr303 lux", "[sensor_hub]")
+{
+    sim_device_t ltr303_sim;
+    sensor_hub_ltr303_t ltr303 = { .dev = sim_i2c_device(&ltr303_sim, SIM_LTR303), .gain = 1, .integration_ms = 100 };
+    ltr303_sim.ch0 = 1000;
+    ltr303_sim.ch1 = 200;
+    float values[3];
+    TEST_ASSERT_EQUAL(0, sensor_hub_ltr303_driver.collect(&ltr303, values));
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 1000, values[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 200, values[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 1774.3 + 221.2, values[2]);
+    // one burst read instead of four single register reads
+    TEST_ASSERT_EQUAL(1, ltr303_sim.transfers);
+}
+
+TEST_CASE("sensor hub retries a busy aht20 without blocking", "[sensor_hub]")
+{
+    sim_device_t aht20_sim;
+    sensor_hub_aht20_t aht20 = { .dev = sim_i2c_device(&aht20_sim, SIM_AHT20) };
+    aht20_sim.temperature = 30.0;
+    float values[2];
+    sim_now_ms = 100;
+    TEST_ASSERT_EQUAL(0, sensor_hub_aht20_driver.start(&aht20));
+    sim_now_ms = 150;
+    TEST_ASSERT_GREATER_THAN(0, sensor_hub_aht20_driver.collect(&aht20, values));
+    sim_now_ms = 180;
+    TEST_ASSERT_EQUAL(0, sensor_hub_aht20_driver.collect(&aht20, values));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 30.0, values[0]);
+}
+
+TEST_CASE("sensor hub keeps the last value on crc error", "[sensor_hub]")
+{
+    sim_device_t sht20_sim;
+    sensor_hub_sht20_t sht20;
+    sensor_hub_sht20_init(&sht20, sim_i2c_device(&sht20_sim, SIM_SHT20));
+    sht20_sim.temperature = 20.0;
+    sht20_sim.humidity = 40.0;
+
+    sim_now_ms = 0;
+    sensor_hub_handle_t hub = sensor_hub_create();
+    int ch = sensor_hub_register(hub, &sensor_hub_sht20_driver, &sht20, 0, 1000);
+    run_until(hub, 500);
+    sensor_hub_reading_t reading;
+    TEST_ASSERT_TRUE(sensor_hub_read(hub, ch, &reading));
+    uint32_t stamp = reading.timestamp_ms;
+
+    sht20_sim.corrupt_crc = 1;
+    sht20_sim.temperature = 60.0;
+    run_until(hub, 1500);
+    TEST_ASSERT_TRUE(sensor_hub_read(hub, ch, &reading));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 20.0, reading.value);
+    TEST_ASSERT_EQUAL_UINT32(stamp, reading.timestamp_ms);
+    sensor_hub_stats_t stats;
+    sensor_hub_get_stats(hub, &stats);
+    TEST_ASSERT_EQUAL(1, stats.errors);
+    sensor_hub_delete(hub);
+}
+
+static int s_level_cnt[3];
+static uint8_t s_level_channel;
+
+static void threshold_cb(uint8_t channel, const sensor_hub_reading_t* reading, sensor_hub_level_t level, void* user_data)
+{
+    s_level_channel = channel;
+    s_level_cnt[level]++;
+}
+
+TEST_CASE("sensor hub threshold is edge triggered with hysteresis", "[sensor_hub]")
+{
+    sensor_hub_handle_t hub = sensor_hub_create();
+    // push only channels, e.g. a uart sensor feeding the hub from its frame callback
+    int ch = sensor_hub_register(hub, NULL, NULL, 2, 0);
+    TEST_ASSERT_EQUAL(0, sensor_hub_set_threshold(hub, ch + 1, 10.0, 30.0, 2.0, threshold_cb, NULL));
+    memset(s_level_cnt, 0, sizeof(s_level_cnt));
+
+    float seq[] = {20, 31, 32, 29, 27.5, 31, 5, 11, 12.5};
+    for (int i = 0; i < sizeof(seq) / sizeof(seq[0]); i++) {
+        sensor_hub_publish(hub, ch + 1, seq[i], i);
+    }
+    // 31 above, 29 still inside hysteresis, 27.5 normal, 31 above, 5 below, 12.5 normal
+    TEST_ASSERT_EQUAL(2, s_level_cnt[SENSOR_HUB_LEVEL_ABOVE]);
+    TEST_ASSERT_EQUAL(1, s_level_cnt[SENSOR_HUB_LEVEL_BELOW]);
+    TEST_ASSERT_EQUAL(2, s_level_cnt[SENSOR_HUB_LEVEL_NORMAL]);
+    TEST_ASSERT_EQUAL(ch + 1, s_level_channel);
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_HUB_IDLE_MS, sensor_hub_poll(hub, 100));
+    sensor_hub_delete(hub);
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "tm1629a_fb.h"
+
+// the whole RAM in one auto increment frame, what every flush used to send
+#define FULL_FLUSH_BYTES    (TM1629A_RAM_SIZE + 1)
+
+static uint8_t s_chip_ram[TM1629A_RAM_SIZE];
+static uint32_t s_wire_bytes;
+static uint32_t s_frames;
+
+// send the frames to a model of the chip, counting what goes over the wire
+static uint16_t flush(tm1629a_fb_t* fb) {
+    tm1629a_fb_frames_t frames;
+    uint16_t bytes = tm1629a_fb_plan(fb, &frames);
+    uint16_t counted = 0;
+    for (uint8_t i = 0; i < frames.num; i++) {
+        uint8_t addr = frames.data[i][0] & 0x0f;
+        TEST_ASSERT_EQUAL_HEX8(0xc0, frames.data[i][0] & 0xf0);
+        for (uint8_t j = 1; j < frames.len[i]; j++) {
+            s_chip_ram[(addr++) & 0x0f] = frames.data[i][j];
+        }
+        counted += frames.len[i];
+    }
+    TEST_ASSERT_EQUAL(counted, bytes);
+    TEST_ASSERT_EQUAL_MEMORY(fb->next, s_chip_ram, TM1629A_RAM_SIZE);
+    s_wire_bytes += bytes;
+    s_frames += frames.num;
+    return bytes;
+}
+
+static void setup(tm1629a_fb_t* fb) {
+    memset(s_chip_ram, 0xa5, sizeof(s_chip_ram));
+    s_wire_bytes = 0;
+    s_frames = 0;
+    tm1629a_fb_init(fb);
+}
+
+TEST_CASE("tm1629a first flush writes the whole RAM, then only changes", "[tm1629a]")
+{
+    tm1629a_fb_t fb;
+    setup(&fb);
+    TEST_ASSERT_EQUAL(FULL_FLUSH_BYTES, flush(&fb));
+    TEST_ASSERT_EQUAL(0, flush(&fb));
+
+    tm1629a_fb_invalidate(&fb);
+    TEST_ASSERT_EQUAL(FULL_FLUSH_BYTES, flush(&fb));
+}
+
+TEST_CASE("tm1629a single led costs one address and one data byte", "[tm1629a]")
+{
+    tm1629a_fb_t fb;
+    setup(&fb);
+    flush(&fb);
+    s_wire_bytes = 0;
+    // the example's chase: one more led per flush, 128 flushes
+    for (uint8_t grid = 0; grid < TM1629A_GRID_NUM; grid++) {
+        for (uint8_t seg = 0; seg < 16; seg++) {
+            tm1629a_fb_set_range(&fb, grid, 1, seg, 1);
+            TEST_ASSERT_EQUAL(2, flush(&fb));
+        }
+    }
+    printf("led chase: %u bytes, full flushes: %u bytes\n", (unsigned)s_wire_bytes, 128 * FULL_FLUSH_BYTES);
+    TEST_ASSERT_EQUAL(128 * 2, s_wire_bytes);
+}
+
+TEST_CASE("tm1629a close changes share a frame, far ones do not", "[tm1629a]")
+{
+    tm1629a_fb_t fb;
+    setup(&fb);
+    flush(&fb);
+
+    // low byte of grid 0 and grid 1: one gap byte is cheaper than a second frame
+    tm1629a_fb_set(&fb, 0, 0x0001);
+    tm1629a_fb_set(&fb, 1, 0x0001);
+    s_frames = 0;
+    TEST_ASSERT_EQUAL(4, flush(&fb));
+    TEST_ASSERT_EQUAL(1, s_frames);
+
+    // grid 0 and grid 7 are too far apart
+    tm1629a_fb_set(&fb, 0, 0x0003);
+    tm1629a_fb_set(&fb, 7, 0x0100);
+    s_frames = 0;
+    TEST_ASSERT_EQUAL(4, flush(&fb));
+    TEST_ASSERT_EQUAL(2, s_frames);
+
+    // everything changed: one frame, same as a full flush
+    for (uint8_t grid = 0; grid < TM1629A_GRID_NUM; grid++) {
+        tm1629a_fb_set(&fb, grid, 0xffff);
+    }
+    s_frames = 0;
+    TEST_ASSERT_EQUAL(FULL_FLUSH_BYTES, flush(&fb));
+    TEST_ASSERT_EQUAL(1, s_frames);
+}
+
+TEST_CASE("tm1629a clock digits update", "[tm1629a]")
+{
+    tm1629a_fb_t fb;
+    setup(&fb);
+    flush(&fb);
+    s_wire_bytes = 0;
+    // 4 digit clock, one digit per grid on SEG1 ~ SEG8, an hour of minute updates
+    char text[5];
+    for (int minute = 0; minute < 60; minute++) {
+        // bounded so -Wformat-truncation sees two digits, not any int
+        snprintf(text, sizeof(text), "12%02u", (unsigned)minute % 100);
+        for (uint8_t i = 0; i < 4; i++) {
+            tm1629a_fb_set_range(&fb, i, tm1629a_font_7seg(text[i]), 0, 8);
+        }
+        flush(&fb);
+    }
+    printf("clock: %u bytes, full flushes: %u bytes\n", (unsigned)s_wire_bytes, 60 * FULL_FLUSH_BYTES);
+    TEST_ASSERT_LESS_THAN(60 * FULL_FLUSH_BYTES / 3, s_wire_bytes);
+}
+
+TEST_CASE("tm1629a set range keeps the other bits", "[tm1629a]")
+{
+    tm1629a_fb_t fb;
+    tm1629a_fb_init(&fb);
+    tm1629a_fb_set(&fb, 2, 0xac);
+    tm1629a_fb_set_range(&fb, 2, 0x05, 4, 3);
+    TEST_ASSERT_EQUAL_HEX16(0xdc, tm1629a_fb_get(&fb, 2));
+    tm1629a_fb_set_range(&fb, 2, 0xff, 8, 8);
+    TEST_ASSERT_EQUAL_HEX16(0xffdc, tm1629a_fb_get(&fb, 2));
+    TEST_ASSERT_EQUAL_HEX8(0xdc, fb.next[4]);
+    TEST_ASSERT_EQUAL_HEX8(0xff, fb.next[5]);
+}
+
+TEST_CASE("tm1629a 7 segment font", "[tm1629a]")
+{
+    TEST_ASSERT_EQUAL_HEX8(0x3f, tm1629a_font_7seg('0'));
+    TEST_ASSERT_EQUAL_HEX8(0x7f, tm1629a_font_7seg('8'));
+    TEST_ASSERT_EQUAL_HEX8(0x77, tm1629a_font_7seg('A'));
+    TEST_ASSERT_EQUAL_HEX8(0x77, tm1629a_font_7seg('a'));
+    TEST_ASSERT_EQUAL_HEX8(0x40, tm1629a_font_7seg('-'));
+    TEST_ASSERT_EQUAL_HEX8(0x00, tm1629a_font_7seg(' '));
+    TEST_ASSERT_EQUAL_HEX8(0x00, tm1629a_font_7seg('#'));
+}
@@ -1,12 +1,20 @@
 #include "driver/gpio.h"
 #include "tm1629a.h"
+#include "tm1629a_fb.h"
 #include "string.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 static spi_device_handle_t g_spi_handle;
 static int g_cs_pin = -1;
-static uint16_t g_led_values[8];
+static tm1629a_fb_t g_fb;
+// setters only touch the framebuffer under the spinlock, the spi traffic runs under the mutex
+static portMUX_TYPE g_fb_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t g_flush_lock = NULL;
+static esp_timer_handle_t g_flush_timer = NULL;
+static uint32_t g_tx_bytes = 0;
 
 static void spi_write_data(uint8_t* data, uint16_t len);
 
@@ -42,7 +50,10 @@ void tm1629a_init(int spi_num, int8_t clk_pin, int8_t data_pin, int8_t cs_pin) {
     };
     ESP_ERROR_CHECK(spi_bus_add_device(spi_num, &devcfg, &g_spi_handle));
 
-    memset(g_led_values, 0x00, 16);
+    tm1629a_fb_init(&g_fb);
+    if (g_flush_lock == NULL) {
+        g_flush_lock = xSemaphoreCreateMutex();
+    }
     spi_write_data(0x00, 1);
 
     tm1629a_set_addr_mode(1);
@@ -94,20 +105,58 @@ void tm1629a_set_brightness(uint8_t brightness) {
     tm1629a_write_bytes(cmd, NULL, 0);
 }
 
+static void tm1629a_flush_timer_cb(void* arg) {
+    tm1629a_flush_leds();
+}
+
 void tm1629a_flush_leds() {
-    uint8_t cmd = 0xc0;
-    tm1629a_write_bytes(cmd, (uint8_t *)g_led_values, 16);
+    tm1629a_fb_frames_t frames;
+    xSemaphoreTake(g_flush_lock, portMAX_DELAY);
+    portENTER_CRITICAL(&g_fb_spinlock);
+    uint16_t bytes = tm1629a_fb_plan(&g_fb, &frames);
+    portEXIT_CRITICAL(&g_fb_spinlock);
+    for (uint8_t i = 0; i < frames.num; i++) {
+        tm1629a_write_bytes(frames.data[i][0], &frames.data[i][1], frames.len[i] - 1);
+    }
+    g_tx_bytes += bytes;
+    xSemaphoreGive(g_flush_lock);
+}
+
+void tm1629a_refresh_all() {
+    portENTER_CRITICAL(&g_fb_spinlock);
+    tm1629a_fb_invalidate(&g_fb);
+    portEXIT_CRITICAL(&g_fb_spinlock);
+}
+
+void tm1629a_set_auto_flush(uint32_t period_ms) {
+    if (g_flush_timer == NULL) {
+        esp_timer_create_args_t timer_args = {
+            .callback = tm1629a_flush_timer_cb,
+            .name = "tm1629a",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &g_flush_timer));
+    }
+    esp_timer_stop(g_flush_timer);
+    if (period_ms) {
+        esp_timer_start_periodic(g_flush_timer, period_ms * 1000);
+    }
+}
+
+uint32_t tm1629a_get_tx_bytes() {
+    return g_tx_bytes;
 }
 
 void tm1629a_set_leds(uint8_t grid, uint16_t value) {
     if (grid == 0) {
         printf("grid need 1 ~ 8  \r\n");
     }
-    if (grid > 8) {
+    if (grid == 0 || grid > 8) {
         return ;
     }
     grid -= 1;
-    g_led_values[grid] = value;
+    portENTER_CRITICAL(&g_fb_spinlock);
+    tm1629a_fb_set(&g_fb, grid, value);
+    portEXIT_CRITICAL(&g_fb_spinlock);
 }
 
 /*
@@ -122,16 +171,13 @@ void tm1629a_set_range_leds(uint8_t grid, uint16_t data, uint8_t bit_pos, uint8_
     if (grid == 0) {
         printf("grid need 1 ~ 8  \r\n");
     }
-    if (grid > 8) {
+    if (grid == 0 || grid > 8) {
         return ;
     }
     grid -= 1;
-
-    uint16_t value = g_led_values[grid];
-    value &= ~(((1UL << bit_length) - 1) << bit_pos);
-    data &= (1 << bit_length) - 1;
-    value |= data << bit_pos;
-    g_led_values[grid] = value;
+    portENTER_CRITICAL(&g_fb_spinlock);
+    tm1629a_fb_set_range(&g_fb, grid, data, bit_pos, bit_length);
+    portEXIT_CRITICAL(&g_fb_spinlock);
 }
 
 void tm1629a_set_led_by_index(uint16_t grid, uint8_t seg, uint8_t enable) {
@@ -143,10 +189,7 @@ void tm1629a_set_led_by_index(uint16_t grid, uint8_t seg, uint8_t enable) {
     if (grid > 8 || seg > 16) {
         return ;
     }
-    grid -= 1;
-    seg -= 1;
-    g_led_values[grid] &= ~(1UL << seg);
-    g_led_values[grid] |= (enable > 0) << seg;
+    tm1629a_set_range_leds(grid, enable > 0, seg - 1, 1);
 }
 
 void tm1629a_set_all_status(uint8_t enable) {
@@ -154,7 +197,25 @@ void tm1629a_set_all_status(uint8_t enable) {
     if (enable) {
         value = 0xffff;
     }
-    for (uint8_t i = 0; i < 8; i++) {
-        g_led_values[i] = value;
+    portENTER_CRITICAL(&g_fb_spinlock);
+    for (uint8_t i = 0; i < TM1629A_GRID_NUM; i++) {
+        tm1629a_fb_set(&g_fb, i, value);
+    }
+    portEXIT_CRITICAL(&g_fb_spinlock);
+}
+
+void tm1629a_set_char(uint8_t grid, uint8_t bit_pos, char c, uint8_t dp) {
+    tm1629a_set_range_leds(grid, tm1629a_font_7seg(c) | (dp ? 0x80 : 0x00), bit_pos, 8);
+}
+
+uint8_t tm1629a_print(uint8_t grid, uint8_t bit_pos, const char* str) {
+    uint8_t digits = 0;
+    while (*str && grid + digits <= TM1629A_GRID_NUM) {
+        // "1.5" takes two digits, the dot rides on the one before it
+        uint8_t dp = str[1] == '.';
+        tm1629a_set_char(grid + digits, bit_pos, *str, dp);
+        str += dp ? 2 : 1;
+        digits++;
     }
+    return digits;
 }
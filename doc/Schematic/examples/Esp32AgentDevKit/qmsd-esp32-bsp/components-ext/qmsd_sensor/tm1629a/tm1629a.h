@@ -8,8 +8,18 @@ void tm1629a_init(int spi_num, int8_t clk_pin, int8_t data_pin, int8_t cs_pin);
 // brightness: 0 ~ 8
 void tm1629a_set_brightness(uint8_t brightness);
 
+// Sends only what changed since the last flush, nothing when the leds did not change.
 void tm1629a_flush_leds();
 
+// Flush from an esp_timer every period_ms, so setters never wait on the spi. 0: stop.
+void tm1629a_set_auto_flush(uint32_t period_ms);
+
+// Rewrite the whole display RAM on the next flush
+void tm1629a_refresh_all();
+
+// Bytes sent to the chip by flushes so far
+uint32_t tm1629a_get_tx_bytes();
+
 // grid: 1 ~ 8
 void tm1629a_set_leds(uint8_t grid, uint16_t value);
 
@@ -28,10 +38,16 @@ void tm1629a_set_led_by_index(uint16_t grid, uint8_t seg, uint8_t enable);
 
 void tm1629a_set_all_status(uint8_t enable);
 
+// 7 segment digit: a ~ g, dp on 8 bits starting at bit_pos of the grid
+void tm1629a_set_char(uint8_t grid, uint8_t bit_pos, char c, uint8_t dp);
+
+// One char per grid from `grid` on, a '.' lights the dp of the char before it. Returns the grids used.
+uint8_t tm1629a_print(uint8_t grid, uint8_t bit_pos, const char* str);
+
 void tm1629a_write_bytes(uint8_t cmd, uint8_t* data, uint16_t len);
 
 void tm1629a_write_byte(uint8_t cmd, uint8_t data);
 
-// Not recommended for use
+// Not recommended for use, flushes rely on auto increase
 void tm1629a_set_addr_mode(uint8_t auto_increase);
 
@@ -0,0 +1,106 @@
+#include "string.h"
+#include "tm1629a_fb.h"
+
+#define TM1629A_CMD_ADDR        0xc0
+
+//   a
+// f   b
+//   g
+// e   c
+//   d   dp
+static const uint8_t g_font_digit[10] = {
+    0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f,
+};
+
+static const uint8_t g_font_alpha[26] = {
+    0x77, 0x7c, 0x39, 0x5e, 0x79, 0x71, 0x3d, 0x76, 0x06, 0x1e, 0x00, 0x38, 0x00,
+    0x54, 0x5c, 0x73, 0x67, 0x50, 0x6d, 0x78, 0x3e, 0x00, 0x00, 0x00, 0x6e, 0x00,
+};
+
+void tm1629a_fb_init(tm1629a_fb_t* fb) {
+    memset(fb, 0, sizeof(tm1629a_fb_t));
+}
+
+uint16_t tm1629a_fb_get(tm1629a_fb_t* fb, uint8_t grid) {
+    return fb->next[grid * 2] | (fb->next[grid * 2 + 1] << 8);
+}
+
+void tm1629a_fb_set(tm1629a_fb_t* fb, uint8_t grid, uint16_t value) {
+    // address 2n is SEG1 ~ SEG8 of grid n, 2n + 1 is SEG9 ~ SEG16
+    fb->next[grid * 2] = value & 0xff;
+    fb->next[grid * 2 + 1] = value >> 8;
+}
+
+void tm1629a_fb_set_range(tm1629a_fb_t* fb, uint8_t grid, uint16_t data, uint8_t bit_pos, uint8_t bit_length) {
+    uint16_t value = tm1629a_fb_get(fb, grid);
+    uint16_t mask = ((1UL << bit_length) - 1) << bit_pos;
+    value = (value & ~mask) | ((data << bit_pos) & mask);
+    tm1629a_fb_set(fb, grid, value);
+}
+
+void tm1629a_fb_invalidate(tm1629a_fb_t* fb) {
+    fb->cur_valid = 0;
+}
+
+static void frames_add(tm1629a_fb_frames_t* frames, const uint8_t* ram, uint8_t start, uint8_t end) {
+    uint8_t* frame = frames->data[frames->num];
+    frame[0] = TM1629A_CMD_ADDR | start;
+    memcpy(frame + 1, ram + start, end - start);
+    frames->len[frames->num] = end - start + 1;
+    frames->num++;
+}
+
+uint16_t tm1629a_fb_plan(tm1629a_fb_t* fb, tm1629a_fb_frames_t* frames) {
+    uint16_t bytes = 0;
+    int16_t start = -1;
+    int16_t end = 0;
+
+    frames->num = 0;
+    for (uint8_t i = 0; i < TM1629A_RAM_SIZE; i++) {
+        if (fb->cur_valid && fb->next[i] == fb->cur[i]) {
+            continue;
+        }
+        // carrying the gap costs one byte each, a new frame costs TM1629A_FRAME_COST
+        if (start >= 0 && i - end > TM1629A_FRAME_COST) {
+            frames_add(frames, fb->next, start, end);
+            bytes += frames->len[frames->num - 1];
+            start = -1;
+        }
+        if (start < 0) {
+            start = i;
+        }
+        end = i + 1;
+    }
+    if (start >= 0) {
+        frames_add(frames, fb->next, start, end);
+        bytes += frames->len[frames->num - 1];
+    }
+
+    memcpy(fb->cur, fb->next, TM1629A_RAM_SIZE);
+    fb->cur_valid = 1;
+    return bytes;
+}
+
+uint8_t tm1629a_font_7seg(char c) {
+    if (c >= '0' && c <= '9') {
+        return g_font_digit[c - '0'];
+    }
+    if (c >= 'a' && c <= 'z') {
+        c -= 'a' - 'A';
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return g_font_alpha[c - 'A'];
+    }
+    switch (c) {
+        case '-':
+            return 0x40;
+        case '_':
+            return 0x08;
+        case '=':
+            return 0x48;
+        case '.':
+            return 0x80;
+        default:
+            return 0x00;
+    }
+}
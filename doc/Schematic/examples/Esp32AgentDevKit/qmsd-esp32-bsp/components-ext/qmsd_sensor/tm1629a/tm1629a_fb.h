@@ -0,0 +1,57 @@
+#pragma once
+
+#include "stdint.h"
+
+// Display RAM images of the tm1629a: `next` is what the setters draw into,
+// `cur` is what the chip shows. A flush only sends the bytes that differ.
+//
+// Every frame is one STB low period: address command + data. In fixed address
+// mode a frame carries one byte, which is exactly what a one byte auto
+// increment frame costs, so the chip stays in auto increment and the planner
+// only decides which changed bytes share a frame: an unchanged gap is sent
+// along when it is cheaper than starting a new frame.
+
+#define TM1629A_GRID_NUM        8
+#define TM1629A_RAM_SIZE        16
+// cost of opening a frame, in byte times: stb toggle + spi transaction setup + address byte
+#define TM1629A_FRAME_COST      3
+#define TM1629A_FB_MAX_FRAMES   (TM1629A_RAM_SIZE / 2)
+
+typedef struct {
+    uint8_t next[TM1629A_RAM_SIZE];
+    uint8_t cur[TM1629A_RAM_SIZE];
+    uint8_t cur_valid;
+} tm1629a_fb_t;
+
+typedef struct {
+    uint8_t num;
+    uint8_t len[TM1629A_FB_MAX_FRAMES];
+    uint8_t data[TM1629A_FB_MAX_FRAMES][TM1629A_RAM_SIZE + 1];
+} tm1629a_fb_frames_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void tm1629a_fb_init(tm1629a_fb_t* fb);
+
+// grid: 0 ~ 7, bit 0 ~ 15 are SEG1 ~ SEG16
+uint16_t tm1629a_fb_get(tm1629a_fb_t* fb, uint8_t grid);
+
+void tm1629a_fb_set(tm1629a_fb_t* fb, uint8_t grid, uint16_t value);
+
+void tm1629a_fb_set_range(tm1629a_fb_t* fb, uint8_t grid, uint16_t data, uint8_t bit_pos, uint8_t bit_length);
+
+// Build the frames that bring the chip from `cur` to `next` and take them as sent.
+// Returns the bytes on the wire, 0 when nothing changed.
+uint16_t tm1629a_fb_plan(tm1629a_fb_t* fb, tm1629a_fb_frames_t* frames);
+
+// Force the next plan to rewrite the whole RAM (chip reset, brownout...)
+void tm1629a_fb_invalidate(tm1629a_fb_t* fb);
+
+// 7 segment font: bit 0 ~ 6 are a ~ g, bit 7 is dp. 0 for unknown chars.
+uint8_t tm1629a_font_7seg(char c);
+
+#ifdef __cplusplus
+}
+#endif
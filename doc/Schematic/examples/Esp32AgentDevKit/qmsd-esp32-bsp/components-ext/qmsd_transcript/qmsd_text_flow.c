@@ -0,0 +1,278 @@
+#include "string.h"
+#include "qmsd_mem.h"
+#include "qmsd_text_flow.h"
+
+#define FLOW_TEXT_MIN       256
+#define FLOW_LINES_MIN      32
+
+static uint32_t utf8_next(const char* s, uint32_t len, uint32_t* i) {
+    uint8_t c = s[*i];
+    uint32_t n = c < 0x80 ? 0 : c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+    if (*i + n >= len) {
+        n = 0;
+    }
+    uint32_t letter = n ? c & (0x3f >> n) : c;
+    (*i)++;
+    for (uint32_t k = 0; k < n; k++) {
+        letter = (letter << 6) | (s[(*i)++] & 0x3f);
+    }
+    return letter;
+}
+
+// ideographs, kana, hangul and their punctuation break on either side
+static bool is_cjk(uint32_t c) {
+    return (c >= 0x2e80 && c <= 0x9fff) || (c >= 0xac00 && c <= 0xd7af) || (c >= 0xf900 && c <= 0xfaff) ||
+           (c >= 0xff00 && c <= 0xffef);
+}
+
+// Start of the line after the one at start, QMSD_TEXT_FLOW_NONE when the
+// text ends in it. x_at gets the x of offset at, or of the line end if that
+// comes first.
+static uint32_t next_line(const qmsd_text_flow_t* flow, uint32_t start, uint32_t at, uint16_t* x_at) {
+    uint32_t x = 0;
+    uint32_t brk = start;
+    uint32_t brk_x = 0;
+    uint32_t i = start;
+    *x_at = 0;
+    while (i < flow->len) {
+        uint32_t ci = i;
+        if (ci <= at) {
+            *x_at = x;
+        }
+        uint32_t letter = utf8_next(flow->text, flow->len, &i);
+        if (letter == '\n') {
+            return i;
+        }
+        if (is_cjk(letter) && ci > start) {
+            brk = ci;
+            brk_x = x;
+        }
+        uint32_t j = i;
+        uint32_t next = j < flow->len ? utf8_next(flow->text, flow->len, &j) : 0;
+        uint16_t w = flow->measure(flow->ctx, letter, next);
+        if (x + w > flow->width && ci > start) {
+            // a space hangs past the edge, anything else starts the next line
+            if (letter == ' ') {
+                brk = i;
+                brk_x = x;
+            }
+            if (brk == start) {
+                brk = ci;
+                brk_x = x;
+            }
+            if (at >= brk) {
+                *x_at = brk_x;
+            }
+            // a space hanging at the end of the text opens no line yet
+            return brk < flow->len ? brk : QMSD_TEXT_FLOW_NONE;
+        }
+        x += w;
+        if (letter == ' ' || is_cjk(letter)) {
+            brk = i;
+            brk_x = x;
+        }
+    }
+    if (at >= flow->len) {
+        *x_at = x;
+    }
+    return QMSD_TEXT_FLOW_NONE;
+}
+
+static int push_line(qmsd_text_flow_t* flow, uint32_t start) {
+    if (flow->line_num == flow->line_cap) {
+        uint32_t* lines = qmsd_mem_realloc(flow->lines, flow->line_cap * 2 * sizeof(uint32_t));
+        if (lines == NULL) {
+            return -1;
+        }
+        flow->lines = lines;
+        flow->line_cap *= 2;
+    }
+    flow->lines[flow->line_num++] = start;
+    return 0;
+}
+
+static uint32_t line_of(const qmsd_text_flow_t* flow, uint32_t offset) {
+    uint32_t i = flow->line_num - 1;
+    while (i > 0 && flow->lines[i] > offset) {
+        i--;
+    }
+    return i;
+}
+
+// Relays out from line on, the text having changed from offset at.
+static int layout(qmsd_text_flow_t* flow, uint32_t line, uint32_t at, qmsd_text_flow_change_t* change) {
+    uint32_t start = flow->lines[line];
+    // the first line keeps its pixels up to the change or its old end
+    if (line + 1 < flow->line_num && flow->lines[line + 1] < at) {
+        at = flow->lines[line + 1];
+    }
+    change->first_line = line;
+    change->old_line_num = flow->line_num;
+    flow->line_num = line;
+    for (;;) {
+        if (push_line(flow, start) != 0) {
+            return -1;
+        }
+        uint16_t x_at;
+        uint32_t next = next_line(flow, start, at, &x_at);
+        if (flow->line_num == line + 1) {
+            change->first_x = x_at;
+        }
+        if (next == QMSD_TEXT_FLOW_NONE) {
+            break;
+        }
+        start = next;
+    }
+    flow->relaid_bytes += flow->len - flow->lines[line];
+    return 0;
+}
+
+// Past max_len the text is cut at a line start down to three quarters of
+// it, whole lines keep their layout so nothing is relaid.
+static void drop_head(qmsd_text_flow_t* flow, qmsd_text_flow_change_t* change) {
+    if (flow->max_len == 0 || flow->len <= flow->max_len) {
+        return;
+    }
+    uint32_t target = flow->len - flow->max_len * 3 / 4;
+    uint32_t l = 1;
+    while (l < flow->line_num - 1 && flow->lines[l] < target) {
+        l++;
+    }
+    if (l >= flow->line_num) {
+        return;
+    }
+    uint32_t cut = flow->lines[l];
+    flow->len -= cut;
+    memmove(flow->text, flow->text + cut, flow->len + 1);
+    flow->line_num -= l;
+    for (uint32_t i = 0; i < flow->line_num; i++) {
+        flow->lines[i] = flow->lines[i + l] - cut;
+    }
+    change->dropped_lines = l;
+    change->old_line_num = change->old_line_num > l ? change->old_line_num - l : 0;
+    if (change->first_line >= l) {
+        change->first_line -= l;
+    } else {
+        change->first_line = 0;
+        change->first_x = 0;
+    }
+}
+
+static int flow_splice(qmsd_text_flow_t* flow, uint32_t at, const char* text, uint32_t n, qmsd_text_flow_change_t* change) {
+    qmsd_text_flow_change_t unused;
+    change = change ? change : &unused;
+    change->dropped_lines = 0;
+    if (at + n + 1 > flow->cap) {
+        uint32_t cap = flow->cap * 2 > at + n + 1 ? flow->cap * 2 : at + n + 1;
+        char* buf = qmsd_mem_realloc(flow->text, cap);
+        if (buf == NULL) {
+            return -1;
+        }
+        flow->text = buf;
+        flow->cap = cap;
+    }
+    memcpy(flow->text + at, text, n);
+    flow->len = at + n;
+    flow->text[flow->len] = '\0';
+
+    // kerning with the new letter can move the old last one back onto the
+    // line before it, unless a '\n' ended that line
+    uint32_t line = line_of(flow, at);
+    if (at > 0 && flow->text[at - 1] != '\n') {
+        line = line_of(flow, at - 1);
+        if (line > 0 && flow->text[flow->lines[line] - 1] != '\n') {
+            line--;
+        }
+    }
+    if (layout(flow, line, at, change) != 0) {
+        return -1;
+    }
+    drop_head(flow, change);
+    return 0;
+}
+
+int qmsd_text_flow_init(qmsd_text_flow_t* flow, uint16_t width, qmsd_text_flow_measure_t measure, void* ctx, uint32_t max_len) {
+    memset(flow, 0, sizeof(*flow));
+    flow->text = qmsd_mem_malloc(QMSD_MEM_TAG_GUI, FLOW_TEXT_MIN, 0);
+    flow->lines = qmsd_mem_malloc(QMSD_MEM_TAG_GUI, FLOW_LINES_MIN * sizeof(uint32_t), 0);
+    if (flow->text == NULL || flow->lines == NULL) {
+        qmsd_text_flow_deinit(flow);
+        return -1;
+    }
+    flow->cap = FLOW_TEXT_MIN;
+    flow->line_cap = FLOW_LINES_MIN;
+    flow->text[0] = '\0';
+    flow->lines[0] = 0;
+    flow->line_num = 1;
+    flow->max_len = max_len;
+    flow->width = width;
+    flow->measure = measure;
+    flow->ctx = ctx;
+    return 0;
+}
+
+void qmsd_text_flow_deinit(qmsd_text_flow_t* flow) {
+    if (flow->text) {
+        qmsd_mem_free(flow->text);
+    }
+    if (flow->lines) {
+        qmsd_mem_free(flow->lines);
+    }
+    memset(flow, 0, sizeof(*flow));
+}
+
+int qmsd_text_flow_append(qmsd_text_flow_t* flow, const char* text, uint32_t n, qmsd_text_flow_change_t* change) {
+    return flow_splice(flow, flow->len, text, n, change);
+}
+
+int qmsd_text_flow_set_tail(qmsd_text_flow_t* flow, const char* text, uint32_t n, qmsd_text_flow_change_t* change) {
+    uint32_t par = flow->len;
+    while (par > 0 && flow->text[par - 1] != '\n') {
+        par--;
+    }
+    uint32_t p = 0;
+    while (p < n && par + p < flow->len && flow->text[par + p] == text[p]) {
+        p++;
+    }
+    if (p == n && par + p == flow->len) {
+        if (change) {
+            memset(change, 0, sizeof(*change));
+            change->first_line = flow->line_num;
+            change->old_line_num = flow->line_num;
+        }
+        return 0;
+    }
+    return flow_splice(flow, par + p, text + p, n - p, change);
+}
+
+void qmsd_text_flow_clear(qmsd_text_flow_t* flow, qmsd_text_flow_change_t* change) {
+    if (change) {
+        memset(change, 0, sizeof(*change));
+        change->old_line_num = flow->line_num;
+    }
+    flow->len = 0;
+    flow->text[0] = '\0';
+    flow->line_num = 1;
+}
+
+void qmsd_text_flow_relayout(qmsd_text_flow_t* flow, uint16_t width, qmsd_text_flow_change_t* change) {
+    qmsd_text_flow_change_t unused;
+    change = change ? change : &unused;
+    change->dropped_lines = 0;
+    flow->width = width;
+    // out of memory leaves the lines laid out so far
+    layout(flow, 0, 0, change);
+}
+
+uint32_t qmsd_text_flow_line(const qmsd_text_flow_t* flow, uint32_t i, const char** start) {
+    if (i >= flow->line_num) {
+        *start = flow->text + flow->len;
+        return 0;
+    }
+    uint32_t end = i + 1 < flow->line_num ? flow->lines[i + 1] : flow->len;
+    if (end > flow->lines[i] && flow->text[end - 1] == '\n') {
+        end--;
+    }
+    *start = flow->text + flow->lines[i];
+    return end - flow->lines[i];
+}
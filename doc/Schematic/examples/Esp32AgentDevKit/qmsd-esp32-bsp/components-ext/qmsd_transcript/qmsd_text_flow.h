@@ -0,0 +1,70 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Line breaking for text that grows at the end. The text is kept as one
+// buffer of '\n' separated paragraphs, the layout as the start offset of
+// every visual line. A line's breaks depend only on where it starts, so an
+// append relays out from the line holding the old last character and every
+// line before it is reused as is: an append costs the length of the tail
+// line, not of the text.
+//
+// Breaks go after spaces and around CJK characters, a word wider than the
+// line is cut where it overflows. Widths come from the measure callback, the
+// font's advance of letter followed by next (0 at the end of the text).
+
+#define QMSD_TEXT_FLOW_NONE     0xffffffff
+
+typedef uint16_t (*qmsd_text_flow_measure_t)(void* ctx, uint32_t letter, uint32_t next);
+
+typedef struct {
+    char* text;                             // NUL terminated
+    uint32_t len;
+    uint32_t cap;
+    uint32_t* lines;                        // start offset of each line, at least one
+    uint32_t line_num;
+    uint32_t line_cap;
+    uint32_t max_len;                       // 0 for no limit, else the oldest lines go past it
+    uint16_t width;
+    qmsd_text_flow_measure_t measure;
+    void* ctx;
+    uint32_t relaid_bytes;                  // bytes laid out since init
+} qmsd_text_flow_t;
+
+// What a change did to the layout. Lines before first_line are untouched and
+// so are the pixels of first_line left of first_x; the rest of first_line
+// and every line after it up to max(line_num, old_line_num) are to redraw.
+typedef struct {
+    uint32_t first_line;
+    uint16_t first_x;
+    uint32_t old_line_num;
+    uint32_t dropped_lines;                 // taken off the head for max_len, indexes moved down by it
+} qmsd_text_flow_change_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int qmsd_text_flow_init(qmsd_text_flow_t* flow, uint16_t width, qmsd_text_flow_measure_t measure, void* ctx, uint32_t max_len);
+
+void qmsd_text_flow_deinit(qmsd_text_flow_t* flow);
+
+// n bytes of text, '\n' starts a paragraph. change may be NULL.
+int qmsd_text_flow_append(qmsd_text_flow_t* flow, const char* text, uint32_t n, qmsd_text_flow_change_t* change);
+
+// Replaces the last paragraph, for sources that resend the whole sentence
+// each time (subtitles). Only the part after the common prefix is relaid.
+int qmsd_text_flow_set_tail(qmsd_text_flow_t* flow, const char* text, uint32_t n, qmsd_text_flow_change_t* change);
+
+void qmsd_text_flow_clear(qmsd_text_flow_t* flow, qmsd_text_flow_change_t* change);
+
+// New width or font: everything is relaid.
+void qmsd_text_flow_relayout(qmsd_text_flow_t* flow, uint16_t width, qmsd_text_flow_change_t* change);
+
+// Bytes of line i without its '\n', start set to its first byte.
+uint32_t qmsd_text_flow_line(const qmsd_text_flow_t* flow, uint32_t i, const char** start);
+
+#ifdef __cplusplus
+}
+#endif
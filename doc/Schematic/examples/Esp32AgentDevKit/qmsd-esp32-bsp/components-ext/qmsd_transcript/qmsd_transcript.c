@@ -0,0 +1,261 @@
+#include "string.h"
+#include "qmsd_mem.h"
+#include "qmsd_transcript.h"
+
+#define TRANSCRIPT_LINE_MAX     512         // bytes of one line, a line is never wider than the view
+#define TRANSCRIPT_SLOT_NONE    QMSD_TEXT_FLOW_NONE
+
+typedef struct {
+    lv_obj_t* obj;
+    qmsd_text_flow_t flow;
+    lv_obj_t** pool;                        // line objects
+    uint32_t* pool_line;                    // the line each one shows, TRANSCRIPT_SLOT_NONE when hidden
+    uint16_t pool_num;
+    lv_coord_t line_h;
+    lv_coord_t letter_space;
+    const lv_font_t* font;
+    lv_draw_label_dsc_t label_dsc;
+} transcript_t;
+
+static uint16_t transcript_measure(void* ctx, uint32_t letter, uint32_t next) {
+    transcript_t* t = (transcript_t *)ctx;
+    return lv_font_get_glyph_width(t->font, letter, next) + t->letter_space;
+}
+
+static transcript_t* transcript_get(lv_obj_t* obj) {
+    return (transcript_t *)lv_obj_get_user_data(obj);
+}
+
+// Runs on the render thread of the band being drawn, two bands can draw lines at once.
+static void line_draw_cb(lv_event_t* e) {
+    transcript_t* t = (transcript_t *)lv_event_get_user_data(e);
+    lv_obj_t* line_obj = lv_event_get_target(e);
+    uint32_t line = t->pool_line[(uintptr_t)lv_obj_get_user_data(line_obj)];
+    const char* start;
+    uint32_t n = qmsd_text_flow_line(&t->flow, line, &start);
+    if (n == 0) {
+        return;
+    }
+    if (n >= TRANSCRIPT_LINE_MAX) {
+        n = TRANSCRIPT_LINE_MAX - 1;
+        while (n > 0 && (start[n] & 0xc0) == 0x80) {
+            n--;
+        }
+    }
+    char line_buf[TRANSCRIPT_LINE_MAX];
+    memcpy(line_buf, start, n);
+    line_buf[n] = '\0';
+    lv_area_t coords;
+    lv_obj_get_coords(line_obj, &coords);
+    lv_draw_label(lv_event_get_draw_ctx(e), &t->label_dsc, &coords, line_buf, NULL);
+}
+
+// Shows the lines in view, a line object keeps its line while it stays in view.
+static void transcript_bind(transcript_t* t) {
+    lv_coord_t scroll_y = lv_obj_get_scroll_y(t->obj);
+    uint32_t first = scroll_y > 0 ? scroll_y / t->line_h : 0;
+    for (uint16_t k = 0; k < t->pool_num; k++) {
+        uint32_t line = first + k;
+        uint16_t slot = line % t->pool_num;
+        lv_obj_t* line_obj = t->pool[slot];
+        if (line >= t->flow.line_num) {
+            if (t->pool_line[slot] != TRANSCRIPT_SLOT_NONE) {
+                lv_obj_add_flag(line_obj, LV_OBJ_FLAG_HIDDEN);
+                t->pool_line[slot] = TRANSCRIPT_SLOT_NONE;
+            }
+            continue;
+        }
+        if (t->pool_line[slot] == line) {
+            continue;
+        }
+        t->pool_line[slot] = line;
+        lv_obj_set_y(line_obj, line * t->line_h);
+        lv_obj_clear_flag(line_obj, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void transcript_free_pool(transcript_t* t) {
+    for (uint16_t i = 0; i < t->pool_num; i++) {
+        lv_obj_del(t->pool[i]);
+    }
+    if (t->pool) {
+        qmsd_mem_free(t->pool);
+        qmsd_mem_free(t->pool_line);
+    }
+    t->pool = NULL;
+    t->pool_line = NULL;
+    t->pool_num = 0;
+}
+
+static void transcript_make_pool(transcript_t* t, uint16_t num) {
+    lv_coord_t content_w = lv_obj_get_content_width(t->obj);
+    if (num != t->pool_num) {
+        transcript_free_pool(t);
+        t->pool = qmsd_mem_malloc(QMSD_MEM_TAG_GUI, num * sizeof(lv_obj_t *), 0);
+        t->pool_line = qmsd_mem_malloc(QMSD_MEM_TAG_GUI, num * sizeof(uint32_t), 0);
+        if (t->pool == NULL || t->pool_line == NULL) {
+            transcript_free_pool(t);
+            return;
+        }
+        for (uint16_t i = 0; i < num; i++) {
+            lv_obj_t* line_obj = lv_obj_create(t->obj);
+            lv_obj_remove_style_all(line_obj);
+            lv_obj_clear_flag(line_obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+            lv_obj_set_user_data(line_obj, (void *)(uintptr_t)i);
+            lv_obj_add_event_cb(line_obj, line_draw_cb, LV_EVENT_DRAW_MAIN, t);
+            t->pool[i] = line_obj;
+        }
+        t->pool_num = num;
+    }
+    for (uint16_t i = 0; i < t->pool_num; i++) {
+        lv_obj_set_size(t->pool[i], content_w, t->line_h);
+        lv_obj_add_flag(t->pool[i], LV_OBJ_FLAG_HIDDEN);
+        t->pool_line[i] = TRANSCRIPT_SLOT_NONE;
+    }
+}
+
+// Styles or size changed. Colors only need a redraw, new metrics or width
+// relay everything.
+static void transcript_refresh(transcript_t* t) {
+    const lv_font_t* font = lv_obj_get_style_text_font(t->obj, LV_PART_MAIN);
+    lv_coord_t letter_space = lv_obj_get_style_text_letter_space(t->obj, LV_PART_MAIN);
+    lv_coord_t line_h = lv_font_get_line_height(font) + lv_obj_get_style_text_line_space(t->obj, LV_PART_MAIN);
+    lv_coord_t content_w = LV_MAX(lv_obj_get_content_width(t->obj), 1);
+    bool relayout = font != t->font || letter_space != t->letter_space || content_w != t->flow.width;
+    uint16_t pool_num = lv_obj_get_content_height(t->obj) / LV_MAX(line_h, 1) + 2;
+
+    t->font = font;
+    t->letter_space = letter_space;
+    t->line_h = LV_MAX(line_h, 1);
+    lv_draw_label_dsc_init(&t->label_dsc);
+    lv_obj_init_draw_label_dsc(t->obj, LV_PART_MAIN, &t->label_dsc);
+    t->label_dsc.flag |= LV_TEXT_FLAG_EXPAND;   // the flow broke the lines already
+    if (relayout) {
+        qmsd_text_flow_relayout(&t->flow, content_w, NULL);
+    }
+    if (relayout || pool_num != t->pool_num) {
+        transcript_make_pool(t, pool_num);
+        transcript_bind(t);
+    }
+    lv_obj_invalidate(t->obj);
+}
+
+// Invalidates what the change redrew: first_line right of first_x, the
+// lines after it in full.
+static void transcript_changed(transcript_t* t, const qmsd_text_flow_change_t* change, bool follow) {
+    if (change->dropped_lines) {
+        // the kept lines moved up, keep what was in view still
+        for (uint16_t i = 0; i < t->pool_num; i++) {
+            lv_obj_add_flag(t->pool[i], LV_OBJ_FLAG_HIDDEN);
+            t->pool_line[i] = TRANSCRIPT_SLOT_NONE;
+        }
+        lv_coord_t scroll_y = lv_obj_get_scroll_y(t->obj) - change->dropped_lines * t->line_h;
+        lv_obj_scroll_to_y(t->obj, LV_MAX(scroll_y, 0), LV_ANIM_OFF);
+        lv_obj_invalidate(t->obj);
+    }
+    uint32_t end = LV_MAX(t->flow.line_num, change->old_line_num);
+    if (change->first_line < end && !change->dropped_lines) {
+        lv_area_t content;
+        lv_obj_get_content_coords(t->obj, &content);
+        lv_coord_t top = content.y1 - lv_obj_get_scroll_y(t->obj);
+        lv_area_t area = {
+            .x1 = content.x1 + change->first_x,
+            .y1 = top + change->first_line * t->line_h,
+            .x2 = content.x2,
+            .y2 = top + (change->first_line + 1) * t->line_h - 1,
+        };
+        lv_obj_invalidate_area(t->obj, &area);
+        if (change->first_line + 1 < end) {
+            area.x1 = content.x1;
+            area.y1 = area.y2 + 1;
+            area.y2 = top + end * t->line_h - 1;
+            lv_obj_invalidate_area(t->obj, &area);
+        }
+    }
+    if (t->flow.line_num != change->old_line_num) {
+        lv_obj_scrollbar_invalidate(t->obj);
+    }
+    transcript_bind(t);
+    if (follow) {
+        lv_obj_scroll_to_y(t->obj, LV_COORD_MAX, LV_ANIM_OFF);
+    }
+}
+
+static void transcript_event_cb(lv_event_t* e) {
+    transcript_t* t = (transcript_t *)lv_event_get_user_data(e);
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_SCROLL:
+            transcript_bind(t);
+            break;
+        case LV_EVENT_SIZE_CHANGED:
+        case LV_EVENT_STYLE_CHANGED:
+            transcript_refresh(t);
+            break;
+        case LV_EVENT_GET_SELF_SIZE: {
+            lv_point_t* p = (lv_point_t *)lv_event_get_param(e);
+            p->y = LV_MAX(p->y, (lv_coord_t)(t->flow.line_num * t->line_h));
+            break;
+        }
+        case LV_EVENT_DELETE:
+            // the line objects go with their parent
+            if (t->pool) {
+                qmsd_mem_free(t->pool);
+                qmsd_mem_free(t->pool_line);
+            }
+            qmsd_text_flow_deinit(&t->flow);
+            qmsd_mem_free(t);
+            break;
+        default:
+            break;
+    }
+}
+
+lv_obj_t* qmsd_transcript_create(lv_obj_t* parent, uint32_t max_len) {
+    transcript_t* t = qmsd_mem_calloc(QMSD_MEM_TAG_GUI, 1, sizeof(transcript_t), 0);
+    if (t == NULL) {
+        return NULL;
+    }
+    if (qmsd_text_flow_init(&t->flow, 1, transcript_measure, t, max_len) != 0) {
+        qmsd_mem_free(t);
+        return NULL;
+    }
+    t->obj = lv_obj_create(parent);
+    lv_obj_set_user_data(t->obj, t);
+    lv_obj_set_scroll_dir(t->obj, LV_DIR_VER);
+    lv_obj_set_scrollbar_mode(t->obj, LV_SCROLLBAR_MODE_AUTO);
+    lv_obj_add_event_cb(t->obj, transcript_event_cb, LV_EVENT_ALL, t);
+    transcript_refresh(t);
+    return t->obj;
+}
+
+static int transcript_update(lv_obj_t* obj, const char* text, bool tail) {
+    transcript_t* t = transcript_get(obj);
+    bool follow = lv_obj_get_scroll_bottom(obj) <= 0;
+    qmsd_text_flow_change_t change;
+    int ret = tail ? qmsd_text_flow_set_tail(&t->flow, text, strlen(text), &change)
+                   : qmsd_text_flow_append(&t->flow, text, strlen(text), &change);
+    if (ret == 0) {
+        transcript_changed(t, &change, follow);
+    }
+    return ret;
+}
+
+int qmsd_transcript_append(lv_obj_t* obj, const char* text) {
+    return transcript_update(obj, text, false);
+}
+
+int qmsd_transcript_set_tail(lv_obj_t* obj, const char* text) {
+    return transcript_update(obj, text, true);
+}
+
+void qmsd_transcript_clear(lv_obj_t* obj) {
+    transcript_t* t = transcript_get(obj);
+    qmsd_text_flow_change_t change;
+    qmsd_text_flow_clear(&t->flow, &change);
+    transcript_changed(t, &change, false);
+    lv_obj_scroll_to_y(obj, 0, LV_ANIM_OFF);
+}
+
+const qmsd_text_flow_t* qmsd_transcript_get_flow(lv_obj_t* obj) {
+    return &transcript_get(obj)->flow;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "stdint.h"
+#include "lvgl.h"
+#include "qmsd_text_flow.h"
+
+// Transcript view for text that streams in (llm replies, subtitles), lvgl v8.
+// A label re-wraps its whole text on every change, this view keeps the line
+// breaks (qmsd_text_flow.h) and relays only the tail:
+//
+//     lv_obj_t* view = qmsd_transcript_create(scr, 8 * 1024);
+//     qmsd_transcript_append(view, "Hello");
+//     qmsd_transcript_append(view, ", world\n");
+//
+// Lines are drawn by a small pool of line objects, as many as fit the view
+// plus one, rebound to other lines as it scrolls. They draw straight from the
+// flow's buffer, so an append touches no object unless a line is added, and
+// only the pixels right of where the change starts are invalidated. While the
+// view is scrolled to the bottom it follows new lines.
+//
+// Font, color and line space are the view's text styles. Like any lvgl call:
+// from the gui task, or with qmsd_gui_lock held.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// max_len: bytes kept, older lines are dropped past it. 0 for no limit.
+lv_obj_t* qmsd_transcript_create(lv_obj_t* parent, uint32_t max_len);
+
+int qmsd_transcript_append(lv_obj_t* obj, const char* text);
+
+// Replaces the last paragraph, see qmsd_text_flow_set_tail.
+int qmsd_transcript_set_tail(lv_obj_t* obj, const char* text);
+
+void qmsd_transcript_clear(lv_obj_t* obj);
+
+const qmsd_text_flow_t* qmsd_transcript_get_flow(lv_obj_t* obj);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+#include "qmsd_text_flow.h"
+#include "qmsd_transcript.h"
+
+// 10 px a letter, 20 for CJK, and an "AV" kerning pair to check that the old
+// last letter is relaid once its next one arrives
+static uint16_t fixed_measure(void* ctx, uint32_t letter, uint32_t next)
+{
+    if (letter >= 0x2e80) {
+        return 20;
+    }
+    return letter == 'A' && next == 'V' ? 4 : 10;
+}
+
+static void line_is(const qmsd_text_flow_t* flow, uint32_t i, const char* expect)
+{
+    const char* start;
+    uint32_t n = qmsd_text_flow_line(flow, i, &start);
+    char buf[128];
+    memcpy(buf, start, n);
+    buf[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING(expect, buf);
+}
+
+TEST_CASE("lines break at spaces, CJK and newlines", "[qmsd_text_flow]")
+{
+    qmsd_text_flow_t flow;
+    TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_init(&flow, 100, fixed_measure, NULL, 0));
+    const char* text = "hello world again\nabcdefghijklmno\n你好世界你好世界 ok";
+    TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_append(&flow, text, strlen(text), NULL));
+    TEST_ASSERT_EQUAL_UINT32(7, flow.line_num);
+    line_is(&flow, 0, "hello ");                // "world" would overflow, it moves
+    line_is(&flow, 1, "world ");                // a space at the edge hangs
+    line_is(&flow, 2, "again");
+    line_is(&flow, 3, "abcdefghij");            // no break in the word: cut where it overflows
+    line_is(&flow, 4, "klmno");
+    line_is(&flow, 5, "你好世界你");            // any two ideographs break
+    line_is(&flow, 6, "好世界 ok");
+    qmsd_text_flow_deinit(&flow);
+}
+
+// The incremental layout has to be the one a full relayout gives.
+static void assert_same_as_full(const qmsd_text_flow_t* flow)
+{
+    qmsd_text_flow_t full;
+    TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_init(&full, flow->width, flow->measure, NULL, 0));
+    qmsd_text_flow_append(&full, flow->text, flow->len, NULL);
+    TEST_ASSERT_EQUAL_UINT32(full.line_num, flow->line_num);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(full.lines, flow->lines, full.line_num);
+    qmsd_text_flow_deinit(&full);
+}
+
+static const char* const g_tokens[] = {
+    "The", " quick", " brown", " fox", " A", "V", "A", "V", " jumps", " over", " the", " lazy", " dog", ".",
+    " Supercalifragilistic", "expialidocious", " ", "  ", "你", "好", "，", "世界", "\n", " ok", "\n\n",
+};
+#define TOKEN_NUM   (sizeof(g_tokens) / sizeof(g_tokens[0]))
+
+TEST_CASE("appending token by token matches a full layout", "[qmsd_text_flow]")
+{
+    qmsd_text_flow_t flow;
+    TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_init(&flow, 120, fixed_measure, NULL, 0));
+    srand(7);
+    uint32_t relaid_max = 0;
+    for (int i = 0; i < 2000; i++) {
+        const char* token = g_tokens[rand() % TOKEN_NUM];
+        uint32_t before = flow.relaid_bytes;
+        uint32_t old_num = flow.line_num;
+        qmsd_text_flow_change_t change;
+        TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_append(&flow, token, strlen(token), &change));
+        assert_same_as_full(&flow);
+        // nothing before the line of the old last letter (and its kerning neighbour) moved
+        TEST_ASSERT_EQUAL_UINT32(old_num, change.old_line_num);
+        TEST_ASSERT_TRUE(change.first_line + 2 >= old_num);
+        relaid_max = LV_MAX(relaid_max, flow.relaid_bytes - before);
+    }
+    printf("%lu bytes in %lu lines, at most %lu bytes relaid by one append\n", (unsigned long)flow.len,
+           (unsigned long)flow.line_num, (unsigned long)relaid_max);
+    TEST_ASSERT_LESS_THAN_UINT32(100, relaid_max);
+    qmsd_text_flow_deinit(&flow);
+}
+
+TEST_CASE("set_tail relays from the first changed letter", "[qmsd_text_flow]")
+{
+    qmsd_text_flow_t flow;
+    TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_init(&flow, 100, fixed_measure, NULL, 0));
+    const char* first = "done.\n";
+    qmsd_text_flow_append(&flow, first, strlen(first), NULL);
+
+    qmsd_text_flow_change_t change;
+    const char* sentences[] = {"how", "how are", "how are you doing", "how are you today", "how"};
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_set_tail(&flow, sentences[i], strlen(sentences[i]), &change));
+        assert_same_as_full(&flow);
+        line_is(&flow, 0, "done.");
+    }
+    // "how are you today" to "how": the change starts after "how" on line 1,
+    // the line that held "today" goes away
+    TEST_ASSERT_EQUAL_UINT32(2, flow.line_num);
+    TEST_ASSERT_EQUAL_UINT32(3, change.old_line_num);
+    TEST_ASSERT_EQUAL_UINT32(1, change.first_line);
+    TEST_ASSERT_EQUAL_UINT16(30, change.first_x);
+
+    // the same text again changes nothing
+    TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_set_tail(&flow, "how", 3, &change));
+    TEST_ASSERT_EQUAL_UINT32(flow.line_num, change.first_line);
+    qmsd_text_flow_deinit(&flow);
+}
+
+TEST_CASE("past max_len whole lines are dropped from the head", "[qmsd_text_flow]")
+{
+    qmsd_text_flow_t flow;
+    TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_init(&flow, 100, fixed_measure, NULL, 200));
+    uint32_t dropped = 0;
+    for (int i = 0; i < 100; i++) {
+        char token[16];
+        int n = snprintf(token, sizeof(token), "w%03d ", i);
+        qmsd_text_flow_change_t change;
+        TEST_ASSERT_EQUAL_INT(0, qmsd_text_flow_append(&flow, token, n, &change));
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(200, flow.len);
+        dropped += change.dropped_lines;
+        assert_same_as_full(&flow);
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, dropped);
+    line_is(&flow, flow.line_num - 1, "w098 w099 ");   // two words fill a line
+    qmsd_text_flow_deinit(&flow);
+}
+
+// Headless lvgl: the flush only counts the pixels it is given.
+#define BENCH_HOR       480
+#define BENCH_VER       480
+#define BENCH_TOKENS    2000
+
+static lv_disp_drv_t g_disp_drv;
+static uint64_t g_flushed_px;
+
+static void bench_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    g_flushed_px += lv_area_get_size(area);
+    lv_disp_flush_ready(drv);
+}
+
+static lv_disp_t* bench_disp(void)
+{
+    static lv_disp_t* disp = NULL;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[BENCH_HOR * 40];
+    if (disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, BENCH_HOR * 40);
+        lv_disp_drv_init(&g_disp_drv);
+        g_disp_drv.hor_res = BENCH_HOR;
+        g_disp_drv.ver_res = BENCH_VER;
+        g_disp_drv.flush_cb = bench_flush;
+        g_disp_drv.draw_buf = &draw_buf;
+        disp = lv_disp_drv_register(&g_disp_drv);
+    }
+    return disp;
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static const char* bench_token(int i)
+{
+    static const char* const words[] = {" the", " model", " answers", " in", " small", " pieces,", " one", " token",
+                                        " at", " a", " time", " and", " the", " view", " keeps", " up."};
+    return i % 97 == 96 ? "\n" : words[i % (sizeof(words) / sizeof(words[0]))];
+}
+
+typedef void (*bench_append_t)(lv_obj_t* obj, const char* token);
+
+static void append_transcript(lv_obj_t* obj, const char* token)
+{
+    qmsd_transcript_append(obj, token);
+}
+
+static void append_label(lv_obj_t* obj, const char* token)
+{
+    lv_obj_t* label = lv_obj_get_child(obj, 0);
+    lv_label_ins_text(label, LV_LABEL_POS_LAST, token);
+    lv_obj_scroll_to_y(obj, LV_COORD_MAX, LV_ANIM_OFF);
+}
+
+static void bench_run(const char* name, lv_obj_t* obj, bench_append_t append, uint32_t tokens)
+{
+    lv_disp_t* disp = bench_disp();
+    lv_refr_now(disp);
+    g_flushed_px = 0;
+    double append_us = 0, refr_us = 0, last_us = 0;
+    for (uint32_t i = 0; i < tokens; i++) {
+        double t0 = now_us();
+        append(obj, bench_token(i));
+        double t1 = now_us();
+        lv_refr_now(disp);
+        double t2 = now_us();
+        append_us += t1 - t0;
+        refr_us += t2 - t1;
+        if (i >= tokens - 100) {
+            last_us += t1 - t0;
+        }
+    }
+    printf("%-10s %lu tokens: append %.1f us avg, %.1f us over the last 100, render %.1f us, %.0f px flushed per token\n",
+           name, (unsigned long)tokens, append_us / tokens, last_us / 100, refr_us / tokens, (double)g_flushed_px / tokens);
+}
+
+TEST_CASE("transcript against a label, 2000 streamed tokens", "[qmsd_transcript]")
+{
+    lv_obj_t* scr = lv_disp_get_scr_act(bench_disp());
+
+    lv_obj_t* view = qmsd_transcript_create(scr, 0);
+    TEST_ASSERT_NOT_NULL(view);
+    lv_obj_set_size(view, 440, 200);
+    lv_obj_center(view);
+    bench_run("transcript", view, append_transcript, BENCH_TOKENS);
+    const qmsd_text_flow_t* flow = qmsd_transcript_get_flow(view);
+    // following the tail: the last line is in view
+    lv_obj_update_layout(view);
+    TEST_ASSERT_EQUAL_INT(0, lv_obj_get_scroll_bottom(view));
+    TEST_ASSERT_GREATER_THAN_UINT32(50, flow->line_num);
+    printf("%lu bytes in %lu lines, %lu line objects\n", (unsigned long)flow->len, (unsigned long)flow->line_num,
+           (unsigned long)lv_obj_get_child_cnt(view));
+    TEST_ASSERT_LESS_THAN_UINT32(20, lv_obj_get_child_cnt(view));
+    lv_obj_del(view);
+
+    // the label has to fit lv_mem: as many tokens as it holds
+    lv_obj_t* box = lv_obj_create(scr);
+    lv_obj_set_size(box, 440, 200);
+    lv_obj_center(box);
+    lv_obj_t* label = lv_label_create(box);
+    lv_obj_set_width(label, lv_pct(100));
+    lv_label_set_text(label, "");
+    bench_run("label", box, append_label, BENCH_TOKENS / 4);
+    lv_obj_del(box);
+}
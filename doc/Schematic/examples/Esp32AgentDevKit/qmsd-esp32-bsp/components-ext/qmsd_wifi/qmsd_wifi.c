@@ -0,0 +1,350 @@
+#include "stdlib.h"
+#include "string.h"
+#include "inttypes.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "nvs.h"
+#include "mbedtls/pkcs5.h"
+#include "qmsd_wifi.h"
+#include "qmsd_metrics.h"
+#include "qmsd_mem.h"
+#include "qmsd_sched.h"
+
+#define TAG "QMSD_WIFI"
+
+#define QMSD_WIFI_NVS_NAMESPACE     "qmsd_wifi"
+#define QMSD_WIFI_NVS_CRED          "cred"
+#define QMSD_WIFI_NVS_CACHE         "cache"
+#define QMSD_WIFI_GOT_IP_BIT        BIT0
+#define QMSD_WIFI_PMK_STACK         3072
+
+QMSD_METRIC_COUNTER(s_wifi_connects, "wifi.connects");
+// of those, with the cached bssid and channel
+QMSD_METRIC_COUNTER(s_wifi_fast_connects, "wifi.fast_connects");
+QMSD_METRIC_COUNTER(s_wifi_disconnects, "wifi.disconnects");
+QMSD_METRIC_HISTOGRAM(s_wifi_time_to_ip_ms, "wifi.time_to_ip_ms", 500, 1000, 2000, 4000, 8000);
+// at the last got ip
+QMSD_METRIC_GAUGE(s_wifi_rssi, "wifi.rssi");
+
+typedef struct {
+    char ssid[33];
+    char password[65];
+} qmsd_wifi_cred_t;
+
+typedef struct {
+    qmsd_wifi_fsm_t fsm;
+    SemaphoreHandle_t lock;
+    EventGroupHandle_t events;
+    esp_timer_handle_t timer;
+    esp_netif_t* netif;
+    qmsd_wifi_cred_t cred;
+    uint8_t started;
+    uint8_t pmk_busy;
+    qmsd_wifi_state_cb_t cb;
+    void* user_data;
+} qmsd_wifi_t;
+
+static qmsd_wifi_t g_wifi = {0};
+
+static uint32_t wifi_now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void nvs_save(const char* key, const void* data, size_t len) {
+    nvs_handle_t nvs;
+    if (nvs_open(QMSD_WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return ;
+    }
+    if (nvs_set_blob(nvs, key, data, len) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+static bool nvs_load(const char* key, void* data, size_t len) {
+    nvs_handle_t nvs;
+    if (nvs_open(QMSD_WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    size_t size = len;
+    esp_err_t err = nvs_get_blob(nvs, key, data, &size);
+    nvs_close(nvs);
+    return err == ESP_OK && size == len;
+}
+
+static int port_connect(void* ctx, const qmsd_wifi_target_t* target) {
+    wifi_config_t cfg = {
+        .sta = {
+            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+            .pmf_cfg = {
+                .capable = true,
+                .required = false,
+            },
+        },
+    };
+    strncpy((char *)cfg.sta.ssid, target->ssid, sizeof(cfg.sta.ssid));
+    if (target->pmk) {
+        // 64 hex digits are taken as the psk itself, skips the 4096 round pbkdf2 in the supplicant
+        static const char hex[] = "0123456789abcdef";
+        for (int i = 0; i < 32; i++) {
+            cfg.sta.password[i * 2] = hex[target->pmk[i] >> 4];
+            cfg.sta.password[i * 2 + 1] = hex[target->pmk[i] & 0x0f];
+        }
+    } else {
+        strncpy((char *)cfg.sta.password, target->password, sizeof(cfg.sta.password));
+    }
+    if (target->bssid) {
+        cfg.sta.bssid_set = true;
+        memcpy(cfg.sta.bssid, target->bssid, sizeof(cfg.sta.bssid));
+        cfg.sta.channel = target->channel;
+        cfg.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        cfg.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    if (err == ESP_OK) {
+        err = esp_wifi_connect();
+    }
+    if (err != ESP_OK) {
+        // the attempt timer still runs and turns this into a retry
+        ESP_LOGW(TAG, "connect failed: %s", esp_err_to_name(err));
+        return -1;
+    }
+    return 0;
+}
+
+static void port_disconnect(void* ctx) {
+    esp_wifi_disconnect();
+}
+
+static void port_set_timer(void* ctx, uint32_t ms) {
+    esp_timer_stop(g_wifi.timer);
+    if (ms) {
+        esp_timer_start_once(g_wifi.timer, (uint64_t)ms * 1000);
+    }
+}
+
+static void port_save_cache(void* ctx, const qmsd_wifi_cache_t* cache) {
+    nvs_save(QMSD_WIFI_NVS_CACHE, cache, sizeof(qmsd_wifi_cache_t));
+}
+
+static uint32_t port_random(void* ctx) {
+    return esp_random();
+}
+
+static const qmsd_wifi_ops_t g_ops = {
+    .connect = port_connect,
+    .disconnect = port_disconnect,
+    .set_timer = port_set_timer,
+    .save_cache = port_save_cache,
+    .random = port_random,
+};
+
+static qmsd_wifi_state_t wifi_lock(void) {
+    xSemaphoreTake(g_wifi.lock, portMAX_DELAY);
+    return g_wifi.fsm.state;
+}
+
+// callbacks and the event bit only see the state once the fsm is done with it
+static void wifi_unlock_notify(qmsd_wifi_state_t old_state, bool notify) {
+    qmsd_wifi_state_t state = g_wifi.fsm.state;
+    xSemaphoreGive(g_wifi.lock);
+    if (state == old_state) {
+        return ;
+    }
+    if (state == QMSD_WIFI_STATE_CONNECTED) {
+        xEventGroupSetBits(g_wifi.events, QMSD_WIFI_GOT_IP_BIT);
+    } else {
+        xEventGroupClearBits(g_wifi.events, QMSD_WIFI_GOT_IP_BIT);
+    }
+    if (notify && g_wifi.cb) {
+        g_wifi.cb(state, g_wifi.user_data);
+    }
+}
+
+static void wifi_unlock(qmsd_wifi_state_t old_state) {
+    wifi_unlock_notify(old_state, true);
+}
+
+static void wifi_timer_cb(void* arg) {
+    qmsd_wifi_state_t old_state = wifi_lock();
+    qmsd_wifi_fsm_on_timer(&g_wifi.fsm, wifi_now_ms());
+    wifi_unlock(old_state);
+}
+
+static void wifi_pmk_task(void* arg) {
+    qmsd_wifi_cred_t* cred = (qmsd_wifi_cred_t *)arg;
+    uint8_t pmk[32];
+    int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1, (const unsigned char *)cred->password, strlen(cred->password),
+                                            (const unsigned char *)cred->ssid, strlen(cred->ssid), 4096, sizeof(pmk), pmk);
+    if (ret == 0) {
+        qmsd_wifi_state_t old_state = wifi_lock();
+        qmsd_wifi_fsm_set_pmk(&g_wifi.fsm, cred->ssid, cred->password, pmk);
+        wifi_unlock(old_state);
+    }
+    qmsd_mem_free(cred);
+    g_wifi.pmk_busy = 0;
+    vTaskDelete(NULL);
+}
+
+// The pmk for the next boot is derived once per network, at low priority after the connect
+static void wifi_derive_pmk(void) {
+    // a 64 digit password already is the psk, open networks have none
+    size_t len = strlen(g_wifi.fsm.password);
+    if (g_wifi.pmk_busy || g_wifi.fsm.cache.pmk_valid || len < 8 || len > 63) {
+        return ;
+    }
+    qmsd_wifi_cred_t* cred = (qmsd_wifi_cred_t *)qmsd_mem_malloc(QMSD_MEM_TAG_NET, sizeof(qmsd_wifi_cred_t), 0);
+    if (cred == NULL) {
+        return ;
+    }
+    strcpy(cred->ssid, g_wifi.fsm.ssid);
+    strcpy(cred->password, g_wifi.fsm.password);
+    g_wifi.pmk_busy = 1;
+    UBaseType_t prio = 1;
+    BaseType_t core = tskNO_AFFINITY;
+    uint32_t stack_size = QMSD_WIFI_PMK_STACK;
+    qmsd_sched_place("wifi_pmk", &prio, &core, &stack_size);
+    if (xTaskCreatePinnedToCore(wifi_pmk_task, "wifi_pmk", stack_size, cred, prio, NULL, core) != pdPASS) {
+        g_wifi.pmk_busy = 0;
+        qmsd_mem_free(cred);
+    }
+}
+
+static qmsd_wifi_fail_t wifi_classify(uint8_t reason) {
+    switch (reason) {
+        case WIFI_REASON_NO_AP_FOUND:
+            return QMSD_WIFI_FAIL_NO_AP;
+        case WIFI_REASON_AUTH_EXPIRE:
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_AUTH_FAIL:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:
+            return QMSD_WIFI_FAIL_AUTH;
+        default:
+            return QMSD_WIFI_FAIL_OTHER;
+    }
+}
+
+static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+    uint32_t now = wifi_now_ms();
+    qmsd_wifi_state_t old_state = wifi_lock();
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        qmsd_wifi_fsm_start(&g_wifi.fsm, g_wifi.cred.ssid, g_wifi.cred.password, now);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t *)event_data;
+        qmsd_wifi_fsm_on_connected(&g_wifi.fsm, event->bssid, event->channel, now);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t *)event_data;
+        ESP_LOGI(TAG, "disconnected, reason %d", event->reason);
+        qmsd_metric_inc(&s_wifi_disconnects);
+        qmsd_wifi_fsm_on_disconnected(&g_wifi.fsm, wifi_classify(event->reason), now);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t *)event_data;
+        qmsd_wifi_fsm_on_got_ip(&g_wifi.fsm, event->ip_info.ip.addr, event->ip_info.netmask.addr, event->ip_info.gw.addr, now);
+        ESP_LOGI(TAG, "got ip " IPSTR " in %" PRIu32 " ms (%s)", IP2STR(&event->ip_info.ip), g_wifi.fsm.stats.last_time_to_ip_ms,
+                 g_wifi.fsm.attempt_fast ? "fast" : "scan");
+        qmsd_metric_inc(&s_wifi_connects);
+        if (g_wifi.fsm.attempt_fast) {
+            qmsd_metric_inc(&s_wifi_fast_connects);
+        }
+        qmsd_metric_observe(&s_wifi_time_to_ip_ms, g_wifi.fsm.stats.last_time_to_ip_ms);
+        wifi_ap_record_t ap_info;
+        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+            qmsd_metric_set(&s_wifi_rssi, ap_info.rssi);
+        }
+        wifi_derive_pmk();
+    }
+    wifi_unlock(old_state);
+}
+
+esp_err_t qmsd_wifi_start(const char* default_ssid, const char* default_password) {
+    if (g_wifi.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_wifi.lock = xSemaphoreCreateMutex();
+    g_wifi.events = xEventGroupCreate();
+    if (g_wifi.lock == NULL || g_wifi.events == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_timer_create_args_t timer_args = {
+        .callback = wifi_timer_cb,
+        .name = "qmsd_wifi",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &g_wifi.timer));
+
+    if (!nvs_load(QMSD_WIFI_NVS_CRED, &g_wifi.cred, sizeof(qmsd_wifi_cred_t)) || g_wifi.cred.ssid[0] == '\0') {
+        strncpy(g_wifi.cred.ssid, default_ssid, sizeof(g_wifi.cred.ssid) - 1);
+        strncpy(g_wifi.cred.password, default_password, sizeof(g_wifi.cred.password) - 1);
+    }
+    g_wifi.cred.ssid[sizeof(g_wifi.cred.ssid) - 1] = '\0';
+    g_wifi.cred.password[sizeof(g_wifi.cred.password) - 1] = '\0';
+
+    qmsd_wifi_cache_t cache;
+    bool has_cache = nvs_load(QMSD_WIFI_NVS_CACHE, &cache, sizeof(qmsd_wifi_cache_t));
+    qmsd_wifi_fsm_init(&g_wifi.fsm, &g_ops, has_cache ? &cache : NULL);
+
+    g_wifi.netif = esp_netif_create_default_wifi_sta();
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    // the cache above is what gets persisted, the driver's own copy would be a second flash write per connect
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    g_wifi.started = 1;
+    ESP_LOGI(TAG, "start, ssid %s, cache %s", g_wifi.cred.ssid, has_cache ? "hit" : "none");
+    // the fsm starts from WIFI_EVENT_STA_START
+    return esp_wifi_start();
+}
+
+esp_err_t qmsd_wifi_set_credentials(const char* ssid, const char* password) {
+    if (!g_wifi.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    qmsd_wifi_state_t old_state = wifi_lock();
+    memset(&g_wifi.cred, 0, sizeof(qmsd_wifi_cred_t));
+    strncpy(g_wifi.cred.ssid, ssid, sizeof(g_wifi.cred.ssid) - 1);
+    strncpy(g_wifi.cred.password, password, sizeof(g_wifi.cred.password) - 1);
+    nvs_save(QMSD_WIFI_NVS_CRED, &g_wifi.cred, sizeof(qmsd_wifi_cred_t));
+    qmsd_wifi_fsm_start(&g_wifi.fsm, g_wifi.cred.ssid, g_wifi.cred.password, wifi_now_ms());
+    // usually called from a gui event, a callback taking the gui lock from here would deadlock;
+    // the disconnect event that follows reports the new state
+    wifi_unlock_notify(old_state, false);
+    return ESP_OK;
+}
+
+bool qmsd_wifi_wait_ip(uint32_t timeout_ms) {
+    if (g_wifi.events == NULL) {
+        return false;
+    }
+    EventBits_t bits = xEventGroupWaitBits(g_wifi.events, QMSD_WIFI_GOT_IP_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return bits & QMSD_WIFI_GOT_IP_BIT;
+}
+
+bool qmsd_wifi_is_connected(void) {
+    return g_wifi.events && (xEventGroupGetBits(g_wifi.events) & QMSD_WIFI_GOT_IP_BIT);
+}
+
+void qmsd_wifi_register_cb(qmsd_wifi_state_cb_t cb, void* user_data) {
+    g_wifi.user_data = user_data;
+    g_wifi.cb = cb;
+}
+
+void qmsd_wifi_get_stats(qmsd_wifi_stats_t* stats) {
+    if (!g_wifi.started) {
+        memset(stats, 0, sizeof(qmsd_wifi_stats_t));
+        return ;
+    }
+    xSemaphoreTake(g_wifi.lock, portMAX_DELAY);
+    *stats = g_wifi.fsm.stats;
+    xSemaphoreGive(g_wifi.lock);
+}
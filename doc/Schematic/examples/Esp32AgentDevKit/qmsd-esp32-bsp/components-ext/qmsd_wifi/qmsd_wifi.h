@@ -0,0 +1,35 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "esp_err.h"
+#include "qmsd_wifi_fsm.h"
+
+// Station bring up with fast reconnect, see qmsd_wifi_fsm.h for the policy.
+// Needs nvs_flash_init, esp_netif_init and the default event loop first.
+
+typedef void (*qmsd_wifi_state_cb_t)(qmsd_wifi_state_t state, void* user_data);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Credentials saved by qmsd_wifi_set_credentials win over the defaults
+esp_err_t qmsd_wifi_start(const char* default_ssid, const char* default_password);
+
+// Stored in nvs and connected to right away, the current network is left first
+esp_err_t qmsd_wifi_set_credentials(const char* ssid, const char* password);
+
+// true once the station has an ip, false on timeout
+bool qmsd_wifi_wait_ip(uint32_t timeout_ms);
+
+bool qmsd_wifi_is_connected(void);
+
+// Runs in the event loop or esp_timer task on state changes, outside any qmsd_wifi lock
+void qmsd_wifi_register_cb(qmsd_wifi_state_cb_t cb, void* user_data);
+
+void qmsd_wifi_get_stats(qmsd_wifi_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
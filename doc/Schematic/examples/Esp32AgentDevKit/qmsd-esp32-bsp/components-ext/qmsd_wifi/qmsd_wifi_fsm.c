@@ -0,0 +1,250 @@
+#include "string.h"
+#include "qmsd_wifi_fsm.h"
+
+#define QMSD_WIFI_CACHE_VERSION     1
+
+uint32_t qmsd_wifi_password_hash(const char* password) {
+    // fnv-1a, only tells passwords apart, the pmk itself is what needs protecting
+    uint32_t hash = 0x811c9dc5;
+    while (*password) {
+        hash ^= (uint8_t)*password++;
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+static bool cache_usable(qmsd_wifi_fsm_t* fsm) {
+    return fsm->cache.valid && strcmp(fsm->cache.ssid, fsm->ssid) == 0;
+}
+
+static bool pmk_usable(qmsd_wifi_fsm_t* fsm) {
+    return cache_usable(fsm) && fsm->cache.pmk_valid && fsm->cache.password_hash == qmsd_wifi_password_hash(fsm->password);
+}
+
+static void fsm_save(qmsd_wifi_fsm_t* fsm) {
+    if (fsm->ops->save_cache) {
+        fsm->ops->save_cache(fsm->ops->ctx, &fsm->cache);
+    }
+}
+
+static void connect_fast(qmsd_wifi_fsm_t* fsm) {
+    qmsd_wifi_target_t target = {
+        .ssid = fsm->ssid,
+        .password = fsm->password,
+        .bssid = fsm->cache.bssid,
+        .channel = fsm->cache.channel,
+        .pmk = pmk_usable(fsm) ? fsm->cache.pmk : NULL,
+    };
+    fsm->state = QMSD_WIFI_STATE_FAST_CONNECT;
+    fsm->attempt_fast = 1;
+    fsm->ops->set_timer(fsm->ops->ctx, QMSD_WIFI_FAST_TIMEOUT_MS);
+    fsm->ops->connect(fsm->ops->ctx, &target);
+}
+
+static void connect_scan(qmsd_wifi_fsm_t* fsm) {
+    qmsd_wifi_target_t target = {
+        .ssid = fsm->ssid,
+        .password = fsm->password,
+    };
+    fsm->state = QMSD_WIFI_STATE_SCAN_CONNECT;
+    fsm->attempt_fast = 0;
+    fsm->stats.scans++;
+    fsm->ops->set_timer(fsm->ops->ctx, QMSD_WIFI_SCAN_TIMEOUT_MS);
+    fsm->ops->connect(fsm->ops->ctx, &target);
+}
+
+static void connect_first(qmsd_wifi_fsm_t* fsm) {
+    if (cache_usable(fsm)) {
+        connect_fast(fsm);
+    } else {
+        connect_scan(fsm);
+    }
+}
+
+static void enter_backoff(qmsd_wifi_fsm_t* fsm) {
+    // equal jitter: half the exponential step fixed, half random, so a room of devices spreads out
+    uint32_t step = QMSD_WIFI_BACKOFF_MIN_MS << (fsm->retry < 6 ? fsm->retry : 6);
+    if (step > QMSD_WIFI_BACKOFF_MAX_MS) {
+        step = QMSD_WIFI_BACKOFF_MAX_MS;
+    }
+    uint32_t delay = step / 2 + fsm->ops->random(fsm->ops->ctx) % (step / 2 + 1);
+    if (fsm->retry < 0xff) {
+        fsm->retry++;
+    }
+    fsm->state = QMSD_WIFI_STATE_BACKOFF;
+    fsm->ops->set_timer(fsm->ops->ctx, delay);
+}
+
+// the current attempt failed: fast falls back to a scan right away, a failed scan backs off
+static void attempt_failed(qmsd_wifi_fsm_t* fsm, qmsd_wifi_fail_t fail) {
+    if (fsm->attempt_fast) {
+        fsm->stats.fast_misses++;
+        if (fail == QMSD_WIFI_FAIL_AUTH && pmk_usable(fsm)) {
+            // a cached pmk the ap does not take (password changed, wpa3 only...): derive it again
+            fsm->cache.pmk_valid = 0;
+            fsm_save(fsm);
+        }
+        connect_scan(fsm);
+    } else {
+        enter_backoff(fsm);
+    }
+}
+
+// drop the current attempt, the disconnect this causes must not count as a failure
+static void abort_attempt(qmsd_wifi_fsm_t* fsm) {
+    fsm->state = QMSD_WIFI_STATE_ABORTING;
+    fsm->ops->set_timer(fsm->ops->ctx, QMSD_WIFI_ABORT_TIMEOUT_MS);
+    fsm->ops->disconnect(fsm->ops->ctx);
+}
+
+static void abort_done(qmsd_wifi_fsm_t* fsm) {
+    if (fsm->restart) {
+        fsm->restart = 0;
+        connect_first(fsm);
+    } else {
+        attempt_failed(fsm, QMSD_WIFI_FAIL_OTHER);
+    }
+}
+
+void qmsd_wifi_fsm_init(qmsd_wifi_fsm_t* fsm, const qmsd_wifi_ops_t* ops, const qmsd_wifi_cache_t* cache) {
+    memset(fsm, 0, sizeof(qmsd_wifi_fsm_t));
+    fsm->ops = ops;
+    if (cache && cache->version == QMSD_WIFI_CACHE_VERSION && cache->valid) {
+        fsm->cache = *cache;
+        fsm->cache.ssid[sizeof(fsm->cache.ssid) - 1] = '\0';
+    }
+    fsm->cache.version = QMSD_WIFI_CACHE_VERSION;
+}
+
+void qmsd_wifi_fsm_start(qmsd_wifi_fsm_t* fsm, const char* ssid, const char* password, uint32_t now_ms) {
+    strncpy(fsm->ssid, ssid, sizeof(fsm->ssid) - 1);
+    fsm->ssid[sizeof(fsm->ssid) - 1] = '\0';
+    strncpy(fsm->password, password, sizeof(fsm->password) - 1);
+    fsm->password[sizeof(fsm->password) - 1] = '\0';
+    fsm->retry = 0;
+    fsm->restart = 0;
+    fsm->cycle_start_ms = now_ms;
+    switch (fsm->state) {
+        case QMSD_WIFI_STATE_IDLE:
+        case QMSD_WIFI_STATE_BACKOFF:
+            connect_first(fsm);
+            break;
+        case QMSD_WIFI_STATE_ABORTING:
+            fsm->restart = 1;
+            break;
+        default:
+            // leave the current network first, the new one starts from its disconnect
+            fsm->restart = 1;
+            abort_attempt(fsm);
+            break;
+    }
+}
+
+void qmsd_wifi_fsm_stop(qmsd_wifi_fsm_t* fsm) {
+    fsm->ops->set_timer(fsm->ops->ctx, 0);
+    if (fsm->state != QMSD_WIFI_STATE_IDLE && fsm->state != QMSD_WIFI_STATE_BACKOFF) {
+        fsm->ops->disconnect(fsm->ops->ctx);
+    }
+    fsm->state = QMSD_WIFI_STATE_IDLE;
+    fsm->restart = 0;
+}
+
+void qmsd_wifi_fsm_on_connected(qmsd_wifi_fsm_t* fsm, const uint8_t* bssid, uint8_t channel, uint32_t now_ms) {
+    if (fsm->state != QMSD_WIFI_STATE_FAST_CONNECT && fsm->state != QMSD_WIFI_STATE_SCAN_CONNECT) {
+        return ;
+    }
+    memcpy(fsm->bssid, bssid, sizeof(fsm->bssid));
+    fsm->channel = channel;
+    fsm->state = QMSD_WIFI_STATE_WAIT_IP;
+    fsm->ops->set_timer(fsm->ops->ctx, QMSD_WIFI_IP_TIMEOUT_MS);
+}
+
+void qmsd_wifi_fsm_on_disconnected(qmsd_wifi_fsm_t* fsm, qmsd_wifi_fail_t fail, uint32_t now_ms) {
+    switch (fsm->state) {
+        case QMSD_WIFI_STATE_FAST_CONNECT:
+        case QMSD_WIFI_STATE_SCAN_CONNECT:
+        case QMSD_WIFI_STATE_WAIT_IP:
+            attempt_failed(fsm, fail);
+            break;
+        case QMSD_WIFI_STATE_CONNECTED:
+            // the ap is most likely still where it was, go straight back to it
+            fsm->stats.drops++;
+            fsm->retry = 0;
+            fsm->cycle_start_ms = now_ms;
+            connect_first(fsm);
+            break;
+        case QMSD_WIFI_STATE_ABORTING:
+            abort_done(fsm);
+            break;
+        default:
+            break;
+    }
+}
+
+void qmsd_wifi_fsm_on_got_ip(qmsd_wifi_fsm_t* fsm, uint32_t ip, uint32_t netmask, uint32_t gw, uint32_t now_ms) {
+    if (fsm->state != QMSD_WIFI_STATE_WAIT_IP && fsm->state != QMSD_WIFI_STATE_CONNECTED) {
+        return ;
+    }
+    fsm->ops->set_timer(fsm->ops->ctx, 0);
+    if (fsm->state == QMSD_WIFI_STATE_WAIT_IP) {
+        uint32_t time_to_ip = now_ms - fsm->cycle_start_ms;
+        fsm->stats.connects++;
+        fsm->stats.fast_hits += fsm->attempt_fast;
+        fsm->stats.lease_reused += cache_usable(fsm) && fsm->cache.ip == ip;
+        fsm->stats.last_time_to_ip_ms = time_to_ip;
+        fsm->stats.total_time_to_ip_ms += time_to_ip;
+        if (time_to_ip > fsm->stats.max_time_to_ip_ms) {
+            fsm->stats.max_time_to_ip_ms = time_to_ip;
+        }
+    }
+    fsm->state = QMSD_WIFI_STATE_CONNECTED;
+    fsm->retry = 0;
+
+    qmsd_wifi_cache_t cache = fsm->cache;
+    if (!cache_usable(fsm) || cache.password_hash != qmsd_wifi_password_hash(fsm->password)) {
+        cache.pmk_valid = 0;
+    }
+    cache.valid = 1;
+    strcpy(cache.ssid, fsm->ssid);
+    memcpy(cache.bssid, fsm->bssid, sizeof(cache.bssid));
+    cache.channel = fsm->channel;
+    cache.password_hash = qmsd_wifi_password_hash(fsm->password);
+    cache.ip = ip;
+    cache.netmask = netmask;
+    cache.gw = gw;
+    // flash only sees a write when something moved
+    if (memcmp(&cache, &fsm->cache, sizeof(cache)) != 0) {
+        fsm->cache = cache;
+        fsm_save(fsm);
+    }
+}
+
+void qmsd_wifi_fsm_on_timer(qmsd_wifi_fsm_t* fsm, uint32_t now_ms) {
+    switch (fsm->state) {
+        case QMSD_WIFI_STATE_FAST_CONNECT:
+        case QMSD_WIFI_STATE_SCAN_CONNECT:
+        case QMSD_WIFI_STATE_WAIT_IP:
+            abort_attempt(fsm);
+            break;
+        case QMSD_WIFI_STATE_ABORTING:
+            // the driver never reported the drop, do not wait forever
+            abort_done(fsm);
+            break;
+        case QMSD_WIFI_STATE_BACKOFF:
+            connect_first(fsm);
+            break;
+        default:
+            break;
+    }
+}
+
+void qmsd_wifi_fsm_set_pmk(qmsd_wifi_fsm_t* fsm, const char* ssid, const char* password, const uint8_t* pmk) {
+    // the credentials may have changed while the port was deriving it
+    if (!cache_usable(fsm) || strcmp(ssid, fsm->ssid) != 0 || strcmp(password, fsm->password) != 0) {
+        return ;
+    }
+    memcpy(fsm->cache.pmk, pmk, sizeof(fsm->cache.pmk));
+    fsm->cache.password_hash = qmsd_wifi_password_hash(password);
+    fsm->cache.pmk_valid = 1;
+    fsm_save(fsm);
+}
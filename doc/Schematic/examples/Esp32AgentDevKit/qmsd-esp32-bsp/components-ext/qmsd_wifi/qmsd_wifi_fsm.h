@@ -0,0 +1,123 @@
+#pragma once
+
+#include "stdint.h"
+#include "stdbool.h"
+
+// Station connection state machine, portable: the wifi driver, timer and
+// storage are behind qmsd_wifi_ops_t, time is passed in.
+//
+// With a cache from the last good connect it first goes straight for the
+// cached bssid on its channel with the cached PMK (no scan, no PBKDF2), then
+// falls back to a full scan, then retries with jittered exponential backoff.
+
+#define QMSD_WIFI_FAST_TIMEOUT_MS       3000
+#define QMSD_WIFI_SCAN_TIMEOUT_MS       15000
+#define QMSD_WIFI_IP_TIMEOUT_MS         10000
+#define QMSD_WIFI_ABORT_TIMEOUT_MS      1000
+#define QMSD_WIFI_BACKOFF_MIN_MS        500
+#define QMSD_WIFI_BACKOFF_MAX_MS        30000
+
+typedef enum {
+    QMSD_WIFI_STATE_IDLE = 0,
+    QMSD_WIFI_STATE_FAST_CONNECT,       // cached bssid + channel
+    QMSD_WIFI_STATE_SCAN_CONNECT,       // all channel scan
+    QMSD_WIFI_STATE_WAIT_IP,
+    QMSD_WIFI_STATE_CONNECTED,
+    QMSD_WIFI_STATE_BACKOFF,
+    QMSD_WIFI_STATE_ABORTING,           // gave up on an attempt, waiting for the driver to drop it
+} qmsd_wifi_state_t;
+
+typedef enum {
+    QMSD_WIFI_FAIL_OTHER = 0,
+    QMSD_WIFI_FAIL_NO_AP,
+    QMSD_WIFI_FAIL_AUTH,
+} qmsd_wifi_fail_t;
+
+// What the last good connect learned, stored as is
+typedef struct {
+    uint8_t version;
+    uint8_t valid;
+    uint8_t pmk_valid;
+    uint8_t channel;
+    char ssid[33];
+    uint8_t bssid[6];
+    uint32_t password_hash;     // the pmk only holds for this password
+    uint8_t pmk[32];
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+} qmsd_wifi_cache_t;
+
+typedef struct {
+    const char* ssid;
+    const char* password;
+    const uint8_t* bssid;       // NULL: any
+    uint8_t channel;            // 0: all channels
+    const uint8_t* pmk;         // NULL: derive it from the password
+} qmsd_wifi_target_t;
+
+typedef struct {
+    int (*connect)(void* ctx, const qmsd_wifi_target_t* target);
+    void (*disconnect)(void* ctx);
+    // one shot, replaces the pending one, 0 cancels
+    void (*set_timer)(void* ctx, uint32_t ms);
+    void (*save_cache)(void* ctx, const qmsd_wifi_cache_t* cache);
+    uint32_t (*random)(void* ctx);
+    void* ctx;
+} qmsd_wifi_ops_t;
+
+typedef struct {
+    uint32_t connects;
+    uint32_t fast_hits;
+    uint32_t fast_misses;
+    uint32_t scans;
+    uint32_t drops;             // lost the connection after getting an ip
+    uint32_t lease_reused;      // got the cached ip back
+    uint32_t last_time_to_ip_ms;
+    uint32_t max_time_to_ip_ms;
+    uint32_t total_time_to_ip_ms;
+} qmsd_wifi_stats_t;
+
+typedef struct {
+    const qmsd_wifi_ops_t* ops;
+    qmsd_wifi_state_t state;
+    // ABORTING was entered for new credentials, not because the attempt timed out
+    uint8_t restart;
+    uint8_t attempt_fast;
+    uint8_t retry;
+    char ssid[33];
+    char password[65];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t cycle_start_ms;    // time to ip counts from here: boot, drop or new credentials
+    qmsd_wifi_cache_t cache;
+    qmsd_wifi_stats_t stats;
+} qmsd_wifi_fsm_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t qmsd_wifi_password_hash(const char* password);
+
+// cache: what the port loaded from storage, NULL when there is none
+void qmsd_wifi_fsm_init(qmsd_wifi_fsm_t* fsm, const qmsd_wifi_ops_t* ops, const qmsd_wifi_cache_t* cache);
+
+void qmsd_wifi_fsm_start(qmsd_wifi_fsm_t* fsm, const char* ssid, const char* password, uint32_t now_ms);
+
+void qmsd_wifi_fsm_stop(qmsd_wifi_fsm_t* fsm);
+
+void qmsd_wifi_fsm_on_connected(qmsd_wifi_fsm_t* fsm, const uint8_t* bssid, uint8_t channel, uint32_t now_ms);
+
+void qmsd_wifi_fsm_on_disconnected(qmsd_wifi_fsm_t* fsm, qmsd_wifi_fail_t fail, uint32_t now_ms);
+
+void qmsd_wifi_fsm_on_got_ip(qmsd_wifi_fsm_t* fsm, uint32_t ip, uint32_t netmask, uint32_t gw, uint32_t now_ms);
+
+void qmsd_wifi_fsm_on_timer(qmsd_wifi_fsm_t* fsm, uint32_t now_ms);
+
+// The port derives the pmk of a connected network off the event path and hands it back
+void qmsd_wifi_fsm_set_pmk(qmsd_wifi_fsm_t* fsm, const char* ssid, const char* password, const uint8_t* pmk);
+
+#ifdef __cplusplus
+}
+#endif
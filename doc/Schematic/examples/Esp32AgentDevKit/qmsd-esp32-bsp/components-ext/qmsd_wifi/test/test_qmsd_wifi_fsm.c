@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "qmsd_wifi_fsm.h"
+
+typedef struct {
+    uint32_t connects;
+    qmsd_wifi_target_t last;
+    uint8_t last_bssid_set;
+    uint8_t last_pmk_set;
+    uint32_t disconnects;
+    uint32_t timer_ms;
+    uint32_t saves;
+    qmsd_wifi_cache_t saved;
+    uint32_t random;
+} mock_driver_t;
+
+static mock_driver_t s_drv;
+
+static int mock_connect(void* ctx, const qmsd_wifi_target_t* target) {
+    s_drv.connects++;
+    s_drv.last = *target;
+    s_drv.last_bssid_set = target->bssid != NULL;
+    s_drv.last_pmk_set = target->pmk != NULL;
+    return 0;
+}
+
+static void mock_disconnect(void* ctx) {
+    s_drv.disconnects++;
+}
+
+static void mock_set_timer(void* ctx, uint32_t ms) {
+    s_drv.timer_ms = ms;
+}
+
+static void mock_save_cache(void* ctx, const qmsd_wifi_cache_t* cache) {
+    s_drv.saves++;
+    s_drv.saved = *cache;
+}
+
+static uint32_t mock_random(void* ctx) {
+    return s_drv.random;
+}
+
+static const qmsd_wifi_ops_t s_ops = {
+    .connect = mock_connect,
+    .disconnect = mock_disconnect,
+    .set_timer = mock_set_timer,
+    .save_cache = mock_save_cache,
+    .random = mock_random,
+};
+
+static const uint8_t s_bssid[6] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+
+static void driver_reset(void) {
+    memset(&s_drv, 0, sizeof(s_drv));
+}
+
+// first boot: full scan, then the cache gets written
+static void connect_cold(qmsd_wifi_fsm_t* fsm, qmsd_wifi_cache_t* cache) {
+    driver_reset();
+    qmsd_wifi_fsm_init(fsm, &s_ops, NULL);
+    qmsd_wifi_fsm_start(fsm, "office", "secret123", 0);
+    qmsd_wifi_fsm_on_connected(fsm, s_bssid, 6, 2500);
+    qmsd_wifi_fsm_on_got_ip(fsm, 0x0a00000a, 0xffffff00, 0x0a000001, 3000);
+    uint8_t pmk[32];
+    memset(pmk, 0xa5, sizeof(pmk));
+    qmsd_wifi_fsm_set_pmk(fsm, "office", "secret123", pmk);
+    *cache = s_drv.saved;
+}
+
+TEST_CASE("qmsd wifi first connect scans and fills the cache", "[qmsd_wifi]") {
+    qmsd_wifi_fsm_t fsm;
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, NULL);
+    qmsd_wifi_fsm_start(&fsm, "office", "secret123", 0);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_SCAN_CONNECT, fsm.state);
+    TEST_ASSERT_EQUAL(1, s_drv.connects);
+    TEST_ASSERT_FALSE(s_drv.last_bssid_set);
+    TEST_ASSERT_EQUAL(0, s_drv.last.channel);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_SCAN_TIMEOUT_MS, s_drv.timer_ms);
+
+    qmsd_wifi_fsm_on_connected(&fsm, s_bssid, 6, 2500);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_WAIT_IP, fsm.state);
+    qmsd_wifi_fsm_on_got_ip(&fsm, 0x0a00000a, 0xffffff00, 0x0a000001, 3000);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_CONNECTED, fsm.state);
+    TEST_ASSERT_EQUAL(0, s_drv.timer_ms);
+    TEST_ASSERT_EQUAL(1, s_drv.saves);
+    TEST_ASSERT_TRUE(s_drv.saved.valid);
+    TEST_ASSERT_FALSE(s_drv.saved.pmk_valid);
+    TEST_ASSERT_EQUAL_STRING("office", s_drv.saved.ssid);
+    TEST_ASSERT_EQUAL_MEMORY(s_bssid, s_drv.saved.bssid, 6);
+    TEST_ASSERT_EQUAL(6, s_drv.saved.channel);
+    TEST_ASSERT_EQUAL_HEX32(0x0a00000a, s_drv.saved.ip);
+
+    uint8_t pmk[32];
+    memset(pmk, 0xa5, sizeof(pmk));
+    // stale derivation for other credentials is dropped
+    qmsd_wifi_fsm_set_pmk(&fsm, "office", "old", pmk);
+    TEST_ASSERT_EQUAL(1, s_drv.saves);
+    qmsd_wifi_fsm_set_pmk(&fsm, "office", "secret123", pmk);
+    TEST_ASSERT_EQUAL(2, s_drv.saves);
+    TEST_ASSERT_TRUE(s_drv.saved.pmk_valid);
+
+    // same network, same lease: no flash write
+    qmsd_wifi_fsm_on_got_ip(&fsm, 0x0a00000a, 0xffffff00, 0x0a000001, 4000);
+    TEST_ASSERT_EQUAL(2, s_drv.saves);
+    TEST_ASSERT_EQUAL(1, fsm.stats.connects);
+    TEST_ASSERT_EQUAL(3000, fsm.stats.last_time_to_ip_ms);
+}
+
+TEST_CASE("qmsd wifi warm boot goes straight to the cached ap", "[qmsd_wifi]") {
+    qmsd_wifi_fsm_t fsm;
+    qmsd_wifi_cache_t cache;
+    connect_cold(&fsm, &cache);
+
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, &cache);
+    qmsd_wifi_fsm_start(&fsm, "office", "secret123", 100);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_FAST_CONNECT, fsm.state);
+    TEST_ASSERT_TRUE(s_drv.last_bssid_set);
+    TEST_ASSERT_EQUAL_MEMORY(s_bssid, s_drv.last.bssid, 6);
+    TEST_ASSERT_EQUAL(6, s_drv.last.channel);
+    TEST_ASSERT_TRUE(s_drv.last_pmk_set);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_FAST_TIMEOUT_MS, s_drv.timer_ms);
+
+    qmsd_wifi_fsm_on_connected(&fsm, s_bssid, 6, 400);
+    qmsd_wifi_fsm_on_got_ip(&fsm, 0x0a00000a, 0xffffff00, 0x0a000001, 600);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_CONNECTED, fsm.state);
+    TEST_ASSERT_EQUAL(1, fsm.stats.fast_hits);
+    TEST_ASSERT_EQUAL(0, fsm.stats.scans);
+    TEST_ASSERT_EQUAL(1, fsm.stats.lease_reused);
+    TEST_ASSERT_EQUAL(500, fsm.stats.last_time_to_ip_ms);
+    // nothing changed, nothing written
+    TEST_ASSERT_EQUAL(0, s_drv.saves);
+
+    // a changed password does not reuse the pmk but still tries the cached ap
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, &cache);
+    qmsd_wifi_fsm_start(&fsm, "office", "newpass", 0);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_FAST_CONNECT, fsm.state);
+    TEST_ASSERT_FALSE(s_drv.last_pmk_set);
+
+    // another network scans
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, &cache);
+    qmsd_wifi_fsm_start(&fsm, "home", "secret123", 0);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_SCAN_CONNECT, fsm.state);
+}
+
+TEST_CASE("qmsd wifi fast connect falls back to a scan", "[qmsd_wifi]") {
+    qmsd_wifi_fsm_t fsm;
+    qmsd_wifi_cache_t cache;
+    connect_cold(&fsm, &cache);
+
+    // ap moved: no ap found on the cached channel
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, &cache);
+    qmsd_wifi_fsm_start(&fsm, "office", "secret123", 0);
+    qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_NO_AP, 200);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_SCAN_CONNECT, fsm.state);
+    TEST_ASSERT_EQUAL(2, s_drv.connects);
+    TEST_ASSERT_FALSE(s_drv.last_bssid_set);
+    TEST_ASSERT_EQUAL(1, fsm.stats.fast_misses);
+    TEST_ASSERT_EQUAL(0, s_drv.saves);
+
+    static const uint8_t moved[6] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x77};
+    qmsd_wifi_fsm_on_connected(&fsm, moved, 11, 2000);
+    qmsd_wifi_fsm_on_got_ip(&fsm, 0x0a00000a, 0xffffff00, 0x0a000001, 2300);
+    TEST_ASSERT_EQUAL(0, fsm.stats.fast_hits);
+    TEST_ASSERT_EQUAL(1, s_drv.saves);
+    TEST_ASSERT_EQUAL_MEMORY(moved, s_drv.saved.bssid, 6);
+    TEST_ASSERT_EQUAL(11, s_drv.saved.channel);
+    // same network and password, the pmk still holds
+    TEST_ASSERT_TRUE(s_drv.saved.pmk_valid);
+
+    // fast connect silently hanging also falls back, after its own short timeout
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, &cache);
+    qmsd_wifi_fsm_start(&fsm, "office", "secret123", 0);
+    qmsd_wifi_fsm_on_timer(&fsm, QMSD_WIFI_FAST_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_ABORTING, fsm.state);
+    TEST_ASSERT_EQUAL(1, s_drv.disconnects);
+    TEST_ASSERT_EQUAL(1, s_drv.connects);
+    // the disconnect we caused is the go ahead, not a second failure
+    qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_OTHER, QMSD_WIFI_FAST_TIMEOUT_MS + 10);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_SCAN_CONNECT, fsm.state);
+    TEST_ASSERT_EQUAL(2, s_drv.connects);
+    TEST_ASSERT_EQUAL(1, fsm.stats.fast_misses);
+}
+
+TEST_CASE("qmsd wifi auth failure drops the cached pmk", "[qmsd_wifi]") {
+    qmsd_wifi_fsm_t fsm;
+    qmsd_wifi_cache_t cache;
+    connect_cold(&fsm, &cache);
+    TEST_ASSERT_TRUE(cache.pmk_valid);
+
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, &cache);
+    qmsd_wifi_fsm_start(&fsm, "office", "secret123", 0);
+    TEST_ASSERT_TRUE(s_drv.last_pmk_set);
+    qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_AUTH, 300);
+    TEST_ASSERT_EQUAL(1, s_drv.saves);
+    TEST_ASSERT_FALSE(s_drv.saved.pmk_valid);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_SCAN_CONNECT, fsm.state);
+    TEST_ASSERT_FALSE(s_drv.last_pmk_set);
+
+    // failing the scan as well backs off
+    qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_AUTH, 3000);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_BACKOFF, fsm.state);
+    // the next round still tries the cached ap first, now without the pmk
+    qmsd_wifi_fsm_on_timer(&fsm, 3500);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_FAST_CONNECT, fsm.state);
+    TEST_ASSERT_FALSE(s_drv.last_pmk_set);
+}
+
+TEST_CASE("qmsd wifi backoff grows, is capped and jittered", "[qmsd_wifi]") {
+    qmsd_wifi_fsm_t fsm;
+    driver_reset();
+    qmsd_wifi_fsm_init(&fsm, &s_ops, NULL);
+    qmsd_wifi_fsm_start(&fsm, "office", "secret123", 0);
+
+    uint32_t step = QMSD_WIFI_BACKOFF_MIN_MS;
+    for (int i = 0; i < 10; i++) {
+        // random at both ends of the range
+        s_drv.random = i & 1 ? 0xffffffff : 0;
+        qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_NO_AP, 0);
+        TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_BACKOFF, fsm.state);
+        TEST_ASSERT_GREATER_OR_EQUAL(step / 2, s_drv.timer_ms);
+        TEST_ASSERT_LESS_OR_EQUAL(step, s_drv.timer_ms);
+        TEST_ASSERT_LESS_OR_EQUAL(QMSD_WIFI_BACKOFF_MAX_MS, s_drv.timer_ms);
+        qmsd_wifi_fsm_on_timer(&fsm, 0);
+        TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_SCAN_CONNECT, fsm.state);
+        step = step * 2 > QMSD_WIFI_BACKOFF_MAX_MS ? QMSD_WIFI_BACKOFF_MAX_MS : step * 2;
+    }
+    TEST_ASSERT_EQUAL(11, fsm.stats.scans);
+
+    // a timed out scan backs off the same way, through the abort
+    qmsd_wifi_fsm_on_timer(&fsm, 0);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_ABORTING, fsm.state);
+    qmsd_wifi_fsm_on_timer(&fsm, 0);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_BACKOFF, fsm.state);
+
+    // success resets the ladder
+    qmsd_wifi_fsm_on_timer(&fsm, 0);
+    qmsd_wifi_fsm_on_connected(&fsm, s_bssid, 1, 0);
+    qmsd_wifi_fsm_on_got_ip(&fsm, 1, 2, 3, 0);
+    TEST_ASSERT_EQUAL(0, fsm.retry);
+}
+
+TEST_CASE("qmsd wifi reconnects after a drop and tracks time to ip", "[qmsd_wifi]") {
+    qmsd_wifi_fsm_t fsm;
+    qmsd_wifi_cache_t cache;
+    connect_cold(&fsm, &cache);
+    TEST_ASSERT_EQUAL(3000, fsm.stats.max_time_to_ip_ms);
+
+    uint32_t connects = s_drv.connects;
+    qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_OTHER, 60000);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_FAST_CONNECT, fsm.state);
+    TEST_ASSERT_EQUAL(connects + 1, s_drv.connects);
+    TEST_ASSERT_EQUAL(1, fsm.stats.drops);
+    qmsd_wifi_fsm_on_connected(&fsm, s_bssid, 6, 60200);
+    qmsd_wifi_fsm_on_got_ip(&fsm, 0x0a00000a, 0xffffff00, 0x0a000001, 60400);
+    TEST_ASSERT_EQUAL(2, fsm.stats.connects);
+    TEST_ASSERT_EQUAL(400, fsm.stats.last_time_to_ip_ms);
+    TEST_ASSERT_EQUAL(3000, fsm.stats.max_time_to_ip_ms);
+    TEST_ASSERT_EQUAL(3400, fsm.stats.total_time_to_ip_ms);
+
+    // new credentials while connected: leave first, the disconnect starts the new network
+    driver_reset();
+    qmsd_wifi_fsm_start(&fsm, "home", "pw", 70000);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_ABORTING, fsm.state);
+    TEST_ASSERT_EQUAL(1, s_drv.disconnects);
+    TEST_ASSERT_EQUAL(0, s_drv.connects);
+    qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_OTHER, 70010);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_SCAN_CONNECT, fsm.state);
+    TEST_ASSERT_EQUAL_STRING("home", s_drv.last.ssid);
+    TEST_ASSERT_EQUAL(0, fsm.stats.fast_misses);
+
+    // stop: the late disconnect event is ignored
+    qmsd_wifi_fsm_stop(&fsm);
+    qmsd_wifi_fsm_on_disconnected(&fsm, QMSD_WIFI_FAIL_OTHER, 70020);
+    TEST_ASSERT_EQUAL(QMSD_WIFI_STATE_IDLE, fsm.state);
+    TEST_ASSERT_EQUAL(1, s_drv.connects);
+}
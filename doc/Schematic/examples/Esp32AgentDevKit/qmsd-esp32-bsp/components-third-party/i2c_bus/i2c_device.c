@@ -2,12 +2,25 @@
 #include "string.h"
 #include "i2c_device_hal.h"
 #include "i2c_device.h"
+#include "esp_timer.h"
+#include "qmsd_metrics.h"
+#include "qmsd_mem.h"
 
 static I2C_MUTEX_TYPE_T i2c_mutex[I2C_NUM_MAX];
 static i2c_port_obj_t *i2c_port_used[I2C_NUM_MAX] = { NULL };
 // used for freq or timeout update
 static i2c_port_obj_t i2c_port_temp;
 
+QMSD_METRIC_COUNTER(s_i2c_transfers, "i2c.transfers");
+QMSD_METRIC_COUNTER(s_i2c_errors, "i2c.errors");
+// bus held, waiting for the bus lock not included
+QMSD_METRIC_HISTOGRAM(s_i2c_xfer_us, "i2c.xfer_us", 100, 250, 500, 1000, 5000);
+
+static void i2c_account(int err, int64_t start_us) {
+    qmsd_metric_observe(&s_i2c_xfer_us, esp_timer_get_time() - start_us);
+    qmsd_metric_inc(err == I2C_OK ? &s_i2c_transfers : &s_i2c_errors);
+}
+
 I2CDevice_t i2c_malloc_device(int i2c_num, int8_t sda, int8_t scl, uint32_t freq, uint8_t device_addr) {
     if (i2c_num > I2C_NUM_MAX) {
         i2c_num = I2C_NUM_MAX;
@@ -17,7 +30,7 @@ I2CDevice_t i2c_malloc_device(int i2c_num, int8_t sda, int8_t scl, uint32_t freq
         i2c_mutex[i] = I2C_MUTEX_CREATE();
     }
 
-    i2c_port_obj_t* new_device_port = (i2c_port_obj_t *)malloc(sizeof(i2c_port_obj_t));
+    i2c_port_obj_t* new_device_port = (i2c_port_obj_t *)qmsd_mem_malloc(QMSD_MEM_TAG_DRIVER, sizeof(i2c_port_obj_t), 0);
     if (new_device_port == NULL) {
         return NULL;
     }
@@ -29,8 +42,9 @@ I2CDevice_t i2c_malloc_device(int i2c_num, int8_t sda, int8_t scl, uint32_t freq
     new_device_port->timeout = -1;
     new_device_port->port = I2C_PORT_NO_INIT;
 
-    i2c_device_t* device = (i2c_device_t *)malloc(sizeof(i2c_device_t));
+    i2c_device_t* device = (i2c_device_t *)qmsd_mem_malloc(QMSD_MEM_TAG_DRIVER, sizeof(i2c_device_t), 0);
     if (device == NULL) {
+        qmsd_mem_free(new_device_port);
         return NULL;
     }
 
@@ -53,8 +67,8 @@ void i2c_free_device(I2CDevice_t i2c_device) {
         memcpy(&i2c_port_temp, device->i2c_port, sizeof(i2c_port_obj_t));
         i2c_port_used[device->i2c_port->i2c_num] = &i2c_port_temp;
     }
-    free(device->i2c_port);
-    free(i2c_device);
+    qmsd_mem_free(device->i2c_port);
+    qmsd_mem_free(i2c_device);
 }
 
 int i2c_apply_bus(I2CDevice_t i2c_device) {
@@ -153,7 +167,9 @@ int i2c_read_bytes(I2CDevice_t i2c_device, uint32_t reg_addr, uint8_t *data, uin
         i2c_free_bus(i2c_device);
         return I2C_FAIL;
     }
+    int64_t start_us = esp_timer_get_time();
     err = i2c_dev_read_bytes(device->i2c_port->port, device->addr, reg_addr, reg_len, data, length);
+    i2c_account(err, start_us);
     i2c_free_bus(i2c_device);
 
     if (err != I2C_OK) {
@@ -219,7 +235,9 @@ int i2c_write_bytes(I2CDevice_t i2c_device, uint32_t reg_addr, uint8_t *data, ui
         i2c_free_bus(i2c_device);
         return I2C_FAIL;
     }
+    int64_t start_us = esp_timer_get_time();
     err = i2c_dev_write_bytes(device->i2c_port->port, device->addr, reg_addr, reg_len, data, length);
+    i2c_account(err, start_us);
     i2c_free_bus(i2c_device);
 
     if (err != I2C_OK) {
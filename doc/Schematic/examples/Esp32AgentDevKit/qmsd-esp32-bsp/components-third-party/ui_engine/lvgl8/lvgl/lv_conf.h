@@ -91,6 +91,15 @@
     #define LV_TICK_CUSTOM_SYS_TIME_EXPR (millis())    /*Expression evaluating to current system time in ms*/
 #endif   /*LV_TICK_CUSTOM*/
 
+/*Render the invalidated areas in horizontal bands on several threads (cores) at once.
+ *The display driver runs the extra threads, see `render_bands_start_cb` in `lv_disp_drv_t`.
+ *Needs a thread safe allocator (`LV_MEM_CUSTOM`) and `__thread` support.*/
+#define LV_USE_REFR_PARALLEL 0
+#if LV_USE_REFR_PARALLEL
+    #define LV_REFR_PARALLEL_THREADS 2      /*Render threads, the one running `lv_timer_handler()` included*/
+    #define LV_REFR_PARALLEL_BANDS   4      /*Bands an area is cut into, the threads take them as they get free*/
+#endif   /*LV_USE_REFR_PARALLEL*/
+
 /*Default Dot Per Inch. Used to initialize default sizes such as widgets sized, style paddings.
  *(Not so important, you can adjust it to modify default sizes and spaces)*/
 #define LV_DPI_DEF 130     /*[px/inch]*/
@@ -120,6 +129,27 @@
     #define LV_CIRCLE_CACHE_SIZE 4
 #endif /*LV_DRAW_COMPLEX*/
 
+/*Keep glyphs expanded to A8 masks (one opacity byte a pixel), keyed by font, letter and bpp,
+ *so drawing a letter again is a plain masked blend. Every render thread has its own cache:
+ *a main tier of LV_GLYPH_CACHE_SIZE bytes (PSRAM is fine) and a hot tier of
+ *LV_GLYPH_CACHE_FAST_SIZE bytes (internal RAM) for the glyphs hit again.
+ *See `lv_draw_sw_glyph_cache_set_alloc_cb()` to place them.*/
+#define LV_USE_GLYPH_CACHE 0
+#if LV_USE_GLYPH_CACHE
+    #define LV_GLYPH_CACHE_SIZE (128 * 1024)
+    #define LV_GLYPH_CACHE_FAST_SIZE (16 * 1024)
+#endif
+
+/*Keep shadow corners, gradients, radius mask circles and decoded images in one cache of
+ *LV_DRAW_CACHE_SIZE bytes, split evenly among the render threads, instead of their own caches
+ *(LV_SHADOW_CACHE_SIZE, LV_GRAD_CACHE_DEF_SIZE, LV_CIRCLE_CACHE_SIZE and LV_IMG_CACHE_DEF_SIZE
+ *are ignored then). What's cheap to make again a byte goes first.
+ *See `lv_draw_cache_set_alloc_cb()` to place it (PSRAM is fine).*/
+#define LV_USE_DRAW_CACHE 0
+#if LV_USE_DRAW_CACHE
+    #define LV_DRAW_CACHE_SIZE (256 * 1024)
+#endif
+
 /**
  * "Simple layers" are used when a widget has `style_opa < 255` to buffer the widget into a layer
  * and blend it as an image with the given opacity.
@@ -190,6 +220,9 @@
     #define LV_GPU_SWM341_DMA2D_INCLUDE "SWM341.h"
 #endif
 
+/*Use the ESP32-S3 PIE (SIMD) instructions for blending*/
+#define LV_USE_GPU_ESP_PIE 0
+
 /*Use NXP's PXP GPU iMX RTxxx platforms*/
 #define LV_USE_GPU_NXP_PXP 0
 #if LV_USE_GPU_NXP_PXP
@@ -295,6 +328,10 @@
 
 #define LV_USE_USER_DATA 1
 
+/*Keep what the styles of an object give for the paddings, radius, opacities, colors and font
+ *in the object (about 300 bytes a part), until its styles or any style are changed*/
+#define LV_USE_STYLE_CACHE 0
+
 /*Garbage Collector settings
  *Used if lvgl is bound to higher level language and the memory is managed by that language*/
 #define LV_ENABLE_GC 0
@@ -480,6 +517,7 @@
 #if LV_USE_LABEL
     #define LV_LABEL_TEXT_SELECTION 1 /*Enable selecting text of the label*/
     #define LV_LABEL_LONG_TXT_HINT 1  /*Store some extra info in labels to speed up drawing of very long texts*/
+    #define LV_LABEL_METRICS_CACHE 0  /*Keep the line starts and widths of long texts (12 bytes a line)*/
 #endif
 
 #define LV_USE_LINE       1
@@ -555,6 +593,8 @@
 
 #define LV_USE_TILEVIEW   1
 
+#define LV_USE_VLIST      1
+
 #define LV_USE_WIN        1
 
 /*-----------
@@ -591,6 +631,10 @@
 /*A layout similar to Grid in CSS.*/
 #define LV_USE_GRID 1
 
+/*Lay out again only the children changed since the last layout (and the ones after them)
+ *and walk only the ancestors of the changed objects. About 40 bytes a laid out container*/
+#define LV_USE_LAYOUT_INCREMENTAL 0
+
 /*---------------------
  * 3rd party libraries
  *--------------------*/
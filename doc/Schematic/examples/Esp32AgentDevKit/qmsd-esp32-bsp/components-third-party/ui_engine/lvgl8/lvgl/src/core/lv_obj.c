@@ -57,6 +57,7 @@ static void lv_obj_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void lv_obj_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void lv_obj_draw(lv_event_t * e);
 static void lv_obj_event(const lv_obj_class_t * class_p, lv_event_t * e);
+static const lv_area_t * get_draw_coords(const lv_obj_t * obj);
 static void draw_scrollbar(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
 static lv_res_t scrollbar_init_draw_dsc(lv_obj_t * obj, lv_draw_rect_dsc_t * dsc);
 static bool obj_valid_child(const lv_obj_t * parent, const lv_obj_t * obj_to_find);
@@ -136,7 +137,7 @@ void lv_init(void)
     _lv_refr_init();
 
     _lv_img_decoder_init();
-#if LV_IMG_CACHE_DEF_SIZE
+#if LV_IMG_CACHE_DEF
     lv_img_cache_set_size(LV_IMG_CACHE_DEF_SIZE);
 #endif
     /*Test if the IDE has UTF-8 encoding*/
@@ -232,7 +233,7 @@ void lv_obj_add_flag(lv_obj_t * obj, lv_obj_flag_t f)
     }
 
     if((was_on_layout != lv_obj_is_layout_positioned(obj)) || (f & (LV_OBJ_FLAG_LAYOUT_1 |  LV_OBJ_FLAG_LAYOUT_2))) {
-        lv_obj_mark_layout_as_dirty(lv_obj_get_parent(obj));
+        _lv_obj_mark_layout_dirty_by_child(lv_obj_get_parent(obj), obj);
         lv_obj_mark_layout_as_dirty(obj);
     }
 
@@ -261,13 +262,13 @@ void lv_obj_clear_flag(lv_obj_t * obj, lv_obj_flag_t f)
     if(f & LV_OBJ_FLAG_HIDDEN) {
         lv_obj_invalidate(obj);
         if(lv_obj_is_layout_positioned(obj)) {
-            lv_obj_mark_layout_as_dirty(lv_obj_get_parent(obj));
+            _lv_obj_mark_layout_dirty_by_child(lv_obj_get_parent(obj), obj);
             lv_obj_mark_layout_as_dirty(obj);
         }
     }
 
     if((was_on_layout != lv_obj_is_layout_positioned(obj)) || (f & (LV_OBJ_FLAG_LAYOUT_1 |  LV_OBJ_FLAG_LAYOUT_2))) {
-        lv_obj_mark_layout_as_dirty(lv_obj_get_parent(obj));
+        _lv_obj_mark_layout_dirty_by_child(lv_obj_get_parent(obj), obj);
     }
 
 }
@@ -438,6 +439,9 @@ static void lv_obj_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     lv_obj_enable_style_refresh(false); /*No need to refresh the style because the object will be deleted*/
     lv_obj_remove_style_all(obj);
     lv_obj_enable_style_refresh(true);
+#if LV_USE_STYLE_CACHE
+    _lv_obj_style_cache_free(obj);
+#endif
 
     /*Remove the animations from this object*/
     lv_anim_del(obj, NULL);
@@ -455,6 +459,12 @@ static void lv_obj_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
             lv_mem_free(obj->spec_attr->event_dsc);
             obj->spec_attr->event_dsc = NULL;
         }
+#if LV_USE_LAYOUT_INCREMENTAL
+        if(obj->spec_attr->layout_cache) {
+            lv_mem_free(obj->spec_attr->layout_cache);
+            obj->spec_attr->layout_cache = NULL;
+        }
+#endif
 
         lv_mem_free(obj->spec_attr);
         obj->spec_attr = NULL;
@@ -509,8 +519,9 @@ static void lv_obj_draw(lv_event_t * e)
         lv_obj_init_draw_rect_dsc(obj, LV_PART_MAIN, &draw_dsc);
         lv_coord_t w = lv_obj_get_style_transform_width(obj, LV_PART_MAIN);
         lv_coord_t h = lv_obj_get_style_transform_height(obj, LV_PART_MAIN);
+        const lv_area_t * obj_coords = get_draw_coords(obj);
         lv_area_t coords;
-        lv_area_copy(&coords, &obj->coords);
+        lv_area_copy(&coords, obj_coords);
         coords.x1 -= w;
         coords.x2 += w;
         coords.y1 -= h;
@@ -540,7 +551,7 @@ static void lv_obj_draw(lv_event_t * e)
 #if LV_DRAW_COMPLEX
         if(clip_corner) {
             lv_draw_mask_radius_param_t * mp = lv_mem_buf_get(sizeof(lv_draw_mask_radius_param_t));
-            lv_draw_mask_radius_init(mp, &obj->coords, draw_dsc.radius, false);
+            lv_draw_mask_radius_init(mp, obj_coords, draw_dsc.radius, false);
             /*Add the mask and use `obj+8` as custom id. Don't use `obj` directly because it might be used by the user*/
             lv_draw_mask_add(mp, obj + 8);
 
@@ -584,7 +595,7 @@ static void lv_obj_draw(lv_event_t * e)
             lv_coord_t w = lv_obj_get_style_transform_width(obj, LV_PART_MAIN);
             lv_coord_t h = lv_obj_get_style_transform_height(obj, LV_PART_MAIN);
             lv_area_t coords;
-            lv_area_copy(&coords, &obj->coords);
+            lv_area_copy(&coords, get_draw_coords(obj));
             coords.x1 -= w;
             coords.x2 += w;
             coords.y1 -= h;
@@ -605,6 +616,17 @@ static void lv_obj_draw(lv_event_t * e)
     }
 }
 
+/**
+ * Get the area to draw the main part of an object on
+ * @param obj       pointer to the object being drawn
+ * @return          the area a widget set in `_lv_obj_draw_coords` (e.g. a transformed image), else its coords
+ */
+static const lv_area_t * get_draw_coords(const lv_obj_t * obj)
+{
+    const lv_area_t * coords = LV_GC_DRAW_ROOT(_lv_obj_draw_coords);
+    return coords ? coords : &obj->coords;
+}
+
 static void draw_scrollbar(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
 {
 
@@ -818,6 +840,27 @@ static void lv_obj_event(const lv_obj_class_t * class_p, lv_event_t * e)
     else if(code == LV_EVENT_SIZE_CHANGED) {
         lv_coord_t align = lv_obj_get_style_align(obj, LV_PART_MAIN);
         uint16_t layout = lv_obj_get_style_layout(obj, LV_PART_MAIN);
+#if LV_USE_LAYOUT_INCREMENTAL
+        /*If it grew from its top left corner the children stay where they were:
+         *only the ones sized or aligned to it have to be refreshed*/
+        const lv_area_t * ori = lv_event_get_param(e);
+        bool moved = ori == NULL || ori->x1 != obj->coords.x1 || ori->y1 != obj->coords.y1;
+        bool w_changed = moved || lv_area_get_width(ori) != lv_obj_get_width(obj);
+        bool h_changed = moved || lv_area_get_height(ori) != lv_obj_get_height(obj);
+        if(layout || align) {
+            _lv_obj_mark_layout_dirty_from(obj, moved ? 0 : lv_obj_get_child_cnt(obj));
+        }
+
+        uint32_t i;
+        uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+        for(i = 0; i < child_cnt; i++) {
+            lv_obj_t * child = obj->spec_attr->children[i];
+            if((w_changed && (child->size_dep_w || child->pos_dep_w)) ||
+               (h_changed && (child->size_dep_h || child->pos_dep_h))) {
+                lv_obj_mark_layout_as_dirty(child);
+            }
+        }
+#else
         if(layout || align) {
             lv_obj_mark_layout_as_dirty(obj);
         }
@@ -828,6 +871,7 @@ static void lv_obj_event(const lv_obj_class_t * class_p, lv_event_t * e)
             lv_obj_t * child = obj->spec_attr->children[i];
             lv_obj_mark_layout_as_dirty(child);
         }
+#endif
     }
     else if(code == LV_EVENT_CHILD_CHANGED) {
         lv_coord_t w = lv_obj_get_style_width(obj, LV_PART_MAIN);
@@ -835,7 +879,7 @@ static void lv_obj_event(const lv_obj_class_t * class_p, lv_event_t * e)
         lv_coord_t align = lv_obj_get_style_align(obj, LV_PART_MAIN);
         uint16_t layout = lv_obj_get_style_layout(obj, LV_PART_MAIN);
         if(layout || align || w == LV_SIZE_CONTENT || h == LV_SIZE_CONTENT) {
-            lv_obj_mark_layout_as_dirty(obj);
+            _lv_obj_mark_layout_dirty_by_child(obj, lv_event_get_param(e));
         }
     }
     else if(code == LV_EVENT_REFR_EXT_DRAW_SIZE) {
@@ -138,6 +138,7 @@ typedef enum {
 #include "lv_obj_pos.h"
 #include "lv_obj_scroll.h"
 #include "lv_obj_style.h"
+#include "lv_obj_style_cache.h"
 #include "lv_obj_draw.h"
 #include "lv_obj_class.h"
 #include "lv_event.h"
@@ -169,6 +170,11 @@ typedef struct {
     lv_dir_t scroll_dir : 4;                /**< The allowed scroll direction(s)*/
     uint8_t event_dsc_cnt : 6;              /**< Number of event callbacks stored in `event_dsc` array*/
     uint8_t layer_type : 2;    /**< Cache the layer type here. Element of @lv_intermediate_layer_type_t */
+
+#if LV_USE_LAYOUT_INCREMENTAL
+    uint32_t layout_inv_from;           /**< The first child changed since the last layout, if `layout_inv` is set*/
+    void * layout_cache;                /**< What the layout kept to lay out only the changed children again*/
+#endif
 } _lv_obj_spec_attr_t;
 
 typedef struct _lv_obj_t {
@@ -178,6 +184,9 @@ typedef struct _lv_obj_t {
     _lv_obj_style_t * styles;
 #if LV_USE_USER_DATA
     void * user_data;
+#endif
+#if LV_USE_STYLE_CACHE
+    struct _lv_obj_style_cache_t * style_cache;   /**< What the styles gave for the hot properties*/
 #endif
     lv_area_t coords;
     lv_obj_flag_t flags;
@@ -188,6 +197,13 @@ typedef struct _lv_obj_t {
     uint16_t style_cnt  : 6;
     uint16_t h_layout   : 1;
     uint16_t w_layout   : 1;
+#if LV_USE_LAYOUT_INCREMENTAL
+    uint16_t layout_child_inv : 1;      /**< The layout of a descendant is to be updated*/
+    uint16_t size_dep_w : 1;            /**< The size depends on the width of the parent*/
+    uint16_t size_dep_h : 1;            /**< The size depends on the height of the parent*/
+    uint16_t pos_dep_w : 1;             /**< The position depends on the width of the parent*/
+    uint16_t pos_dep_h : 1;             /**< The position depends on the height of the parent*/
+#endif
 } lv_obj_t;
 
 
@@ -26,12 +26,17 @@
 static lv_coord_t calc_content_width(lv_obj_t * obj);
 static lv_coord_t calc_content_height(lv_obj_t * obj);
 static void layout_update_core(lv_obj_t * obj);
+static void layout_mark(lv_obj_t * obj);
 static void transform_point(const lv_obj_t * obj, lv_point_t * p, bool inv);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static uint32_t layout_cnt;
+#if LV_USE_LAYOUT_INCREMENTAL
+static const lv_obj_t * layout_obj;     /*Whose layout callback is running*/
+static uint32_t layout_from;            /*And the first of its children changed*/
+#endif
 
 /**********************
  *      MACROS
@@ -82,7 +87,13 @@ bool lv_obj_refr_size(lv_obj_t * obj)
     LV_ASSERT_OBJ(obj, MY_CLASS);
 
     /*If the width or height is set by a layout do not modify them*/
-    if(obj->w_layout && obj->h_layout) return false;
+    if(obj->w_layout && obj->h_layout) {
+#if LV_USE_LAYOUT_INCREMENTAL
+        obj->size_dep_w = 0;
+        obj->size_dep_h = 0;
+#endif
+        return false;
+    }
 
     lv_obj_t * parent = lv_obj_get_parent(obj);
     if(parent == NULL) return false;
@@ -94,6 +105,9 @@ bool lv_obj_refr_size(lv_obj_t * obj)
     lv_coord_t w;
     if(obj->w_layout) {
         w = lv_obj_get_width(obj);
+#if LV_USE_LAYOUT_INCREMENTAL
+        obj->size_dep_w = 0;
+#endif
     }
     else {
         w = lv_obj_get_style_width(obj, LV_PART_MAIN);
@@ -120,6 +134,10 @@ bool lv_obj_refr_size(lv_obj_t * obj)
         lv_coord_t minw = lv_obj_get_style_min_width(obj, LV_PART_MAIN);
         lv_coord_t maxw = lv_obj_get_style_max_width(obj, LV_PART_MAIN);
         w = lv_clamp_width(w, minw, maxw, parent_w);
+#if LV_USE_LAYOUT_INCREMENTAL
+        /*Refresh it on the parent's resize only if it matters (see `LV_EVENT_SIZE_CHANGED`)*/
+        obj->size_dep_w = w_is_pct || LV_COORD_IS_PCT(minw) || LV_COORD_IS_PCT(maxw);
+#endif
     }
 
     lv_coord_t st_ori = lv_obj_get_scroll_top(obj);
@@ -128,6 +146,9 @@ bool lv_obj_refr_size(lv_obj_t * obj)
     bool h_is_pct = false;
     if(obj->h_layout) {
         h = lv_obj_get_height(obj);
+#if LV_USE_LAYOUT_INCREMENTAL
+        obj->size_dep_h = 0;
+#endif
     }
     else {
         h = lv_obj_get_style_height(obj, LV_PART_MAIN);
@@ -154,6 +175,9 @@ bool lv_obj_refr_size(lv_obj_t * obj)
         lv_coord_t minh = lv_obj_get_style_min_height(obj, LV_PART_MAIN);
         lv_coord_t maxh = lv_obj_get_style_max_height(obj, LV_PART_MAIN);
         h = lv_clamp_height(h, minh, maxh, parent_h);
+#if LV_USE_LAYOUT_INCREMENTAL
+        obj->size_dep_h = h_is_pct || LV_COORD_IS_PCT(minh) || LV_COORD_IS_PCT(maxh);
+#endif
     }
 
     /*calc_auto_size set the scroll x/y to 0 so revert the original value*/
@@ -287,16 +311,69 @@ bool lv_obj_is_layout_positioned(const lv_obj_t * obj)
 
 void lv_obj_mark_layout_as_dirty(lv_obj_t * obj)
 {
-    obj->layout_inv = 1;
+#if LV_USE_LAYOUT_INCREMENTAL
+    if(obj->spec_attr) obj->spec_attr->layout_inv_from = 0;
+#endif
+    layout_mark(obj);
+}
 
-    /*Mark the screen as dirty too to mark that there is something to do on this screen*/
-    lv_obj_t * scr = lv_obj_get_screen(obj);
-    scr->scr_layout_inv = 1;
+void _lv_obj_mark_layout_dirty_by_child(lv_obj_t * obj, const lv_obj_t * child)
+{
+#if LV_USE_LAYOUT_INCREMENTAL
+    uint32_t id = 0;
+    if(child && child->parent == obj && obj->spec_attr &&
+       (obj->layout_inv == 0 || obj->spec_attr->layout_inv_from > 0)) {
+        /*Mostly the last children change: look for it from the end*/
+        id = obj->spec_attr->child_cnt;
+        while(id > 0 && obj->spec_attr->children[id - 1] != child) id--;
+        if(id > 0) id--;
+    }
+    _lv_obj_mark_layout_dirty_from(obj, id);
+#else
+    LV_UNUSED(child);
+    lv_obj_mark_layout_as_dirty(obj);
+#endif
+}
 
-    /*Make the display refreshing*/
-    lv_disp_t * disp = lv_obj_get_disp(scr);
-    if(disp->refr_timer) lv_timer_resume(disp->refr_timer);
+void _lv_obj_mark_layout_dirty_from(lv_obj_t * obj, uint32_t id)
+{
+#if LV_USE_LAYOUT_INCREMENTAL
+    if(obj->spec_attr) {
+        if(obj->layout_inv == 0 || id < obj->spec_attr->layout_inv_from) obj->spec_attr->layout_inv_from = id;
+    }
+    layout_mark(obj);
+#else
+    LV_UNUSED(id);
+    lv_obj_mark_layout_as_dirty(obj);
+#endif
+}
+
+#if LV_USE_LAYOUT_INCREMENTAL
+uint32_t _lv_obj_get_layout_dirty_from(const lv_obj_t * obj)
+{
+    return obj == layout_obj ? layout_from : 0;
+}
+
+void * _lv_obj_get_layout_cache(lv_obj_t * obj, uint32_t layout, uint32_t size)
+{
+    lv_obj_allocate_spec_attr(obj);
+    if(obj->spec_attr == NULL) return NULL;
+
+    _lv_layout_cache_t * cache = obj->spec_attr->layout_cache;
+    if(cache && cache->layout == layout && cache->size == size) return cache;
+
+    lv_mem_free(cache);
+    cache = lv_mem_alloc(size);
+    LV_ASSERT_MALLOC(cache);
+    obj->spec_attr->layout_cache = cache;
+    if(cache == NULL) return NULL;
+
+    lv_memset_00(cache, size);
+    cache->layout = layout;
+    cache->size = size;
+    return cache;
 }
+#endif
 
 void lv_obj_update_layout(const lv_obj_t * obj)
 {
@@ -628,7 +705,13 @@ bool lv_obj_refresh_self_size(lv_obj_t * obj)
 
 void lv_obj_refr_pos(lv_obj_t * obj)
 {
-    if(lv_obj_is_layout_positioned(obj)) return;
+    if(lv_obj_is_layout_positioned(obj)) {
+#if LV_USE_LAYOUT_INCREMENTAL
+        obj->pos_dep_w = 0;
+        obj->pos_dep_h = 0;
+#endif
+        return;
+    }
 
 
     lv_obj_t * parent = lv_obj_get_parent(obj);
@@ -643,6 +726,11 @@ void lv_obj_refr_pos(lv_obj_t * obj)
     /*Handle percentage value*/
     lv_coord_t pw = lv_obj_get_content_width(parent);
     lv_coord_t ph = lv_obj_get_content_height(parent);
+#if LV_USE_LAYOUT_INCREMENTAL
+    /*Refresh it on the parent's resize only if it matters (see `LV_EVENT_SIZE_CHANGED`)*/
+    obj->pos_dep_w = LV_COORD_IS_PCT(x);
+    obj->pos_dep_h = LV_COORD_IS_PCT(y);
+#endif
     if(LV_COORD_IS_PCT(x)) x = (pw * LV_COORD_GET_PCT(x)) / 100;
     if(LV_COORD_IS_PCT(y)) y = (ph * LV_COORD_GET_PCT(y)) / 100;
 
@@ -665,6 +753,11 @@ void lv_obj_refr_pos(lv_obj_t * obj)
         else align = LV_ALIGN_TOP_LEFT;
     }
 
+#if LV_USE_LAYOUT_INCREMENTAL
+    if(align != LV_ALIGN_TOP_LEFT && align != LV_ALIGN_LEFT_MID && align != LV_ALIGN_BOTTOM_LEFT) obj->pos_dep_w = 1;
+    if(align != LV_ALIGN_TOP_LEFT && align != LV_ALIGN_TOP_MID && align != LV_ALIGN_TOP_RIGHT) obj->pos_dep_h = 1;
+#endif
+
     if(align == LV_ALIGN_TOP_LEFT) {
         lv_obj_move_to(obj, x, y);
     }
@@ -1005,13 +1098,15 @@ static lv_coord_t calc_content_width(lv_obj_t * obj)
     lv_coord_t child_res = LV_COORD_MIN;
     uint32_t i;
     uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    /*Look up the layout once, not in `lv_obj_is_layout_positioned()` for every child*/
+    bool has_layout = lv_obj_get_style_layout(obj, LV_PART_MAIN) != 0;
     /*With RTL find the left most coordinate*/
     if(lv_obj_get_style_base_dir(obj, LV_PART_MAIN) == LV_BASE_DIR_RTL) {
         for(i = 0; i < child_cnt; i++) {
             lv_obj_t * child = obj->spec_attr->children[i];
             if(lv_obj_has_flag_any(child,  LV_OBJ_FLAG_HIDDEN | LV_OBJ_FLAG_FLOATING)) continue;
 
-            if(!lv_obj_is_layout_positioned(child)) {
+            if(!has_layout || lv_obj_has_flag(child, LV_OBJ_FLAG_IGNORE_LAYOUT)) {
                 lv_align_t align = lv_obj_get_style_align(child, 0);
                 switch(align) {
                     case LV_ALIGN_DEFAULT:
@@ -1043,7 +1138,7 @@ static lv_coord_t calc_content_width(lv_obj_t * obj)
             lv_obj_t * child = obj->spec_attr->children[i];
             if(lv_obj_has_flag_any(child,  LV_OBJ_FLAG_HIDDEN | LV_OBJ_FLAG_FLOATING)) continue;
 
-            if(!lv_obj_is_layout_positioned(child)) {
+            if(!has_layout || lv_obj_has_flag(child, LV_OBJ_FLAG_IGNORE_LAYOUT)) {
                 lv_align_t align = lv_obj_get_style_align(child, 0);
                 switch(align) {
                     case LV_ALIGN_DEFAULT:
@@ -1089,12 +1184,14 @@ static lv_coord_t calc_content_height(lv_obj_t * obj)
     lv_coord_t child_res = LV_COORD_MIN;
     uint32_t i;
     uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    /*Look up the layout once, not in `lv_obj_is_layout_positioned()` for every child*/
+    bool has_layout = lv_obj_get_style_layout(obj, LV_PART_MAIN) != 0;
     for(i = 0; i < child_cnt; i++) {
         lv_obj_t * child = obj->spec_attr->children[i];
         if(lv_obj_has_flag_any(child,  LV_OBJ_FLAG_HIDDEN | LV_OBJ_FLAG_FLOATING)) continue;
 
 
-        if(!lv_obj_is_layout_positioned(child)) {
+        if(!has_layout || lv_obj_has_flag(child, LV_OBJ_FLAG_IGNORE_LAYOUT)) {
             lv_align_t align = lv_obj_get_style_align(child, 0);
             switch(align) {
                 case LV_ALIGN_DEFAULT:
@@ -1132,13 +1229,27 @@ static void layout_update_core(lv_obj_t * obj)
 {
     uint32_t i;
     uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+#if LV_USE_LAYOUT_INCREMENTAL
+    /*Walk only the way to the changed objects*/
+    if(obj->layout_child_inv) {
+        obj->layout_child_inv = 0;
+        for(i = 0; i < child_cnt; i++) {
+            lv_obj_t * child = obj->spec_attr->children[i];
+            if(child->layout_inv || child->layout_child_inv) layout_update_core(child);
+        }
+    }
+#else
     for(i = 0; i < child_cnt; i++) {
         lv_obj_t * child = obj->spec_attr->children[i];
         layout_update_core(child);
     }
+#endif
 
     if(obj->layout_inv == 0) return;
 
+#if LV_USE_LAYOUT_INCREMENTAL
+    uint32_t from = obj->spec_attr ? obj->spec_attr->layout_inv_from : 0;
+#endif
     obj->layout_inv = 0;
 
     lv_obj_refr_size(obj);
@@ -1148,11 +1259,46 @@ static void layout_update_core(lv_obj_t * obj)
         uint32_t layout_id = lv_obj_get_style_layout(obj, LV_PART_MAIN);
         if(layout_id > 0 && layout_id <= layout_cnt) {
             void  * user_data = LV_GC_ROOT(_lv_layout_list)[layout_id - 1].user_data;
+#if LV_USE_LAYOUT_INCREMENTAL
+            /*The new size might have marked some children too*/
+            if(obj->layout_inv) from = LV_MIN(from, obj->spec_attr->layout_inv_from);
+            layout_obj = obj;
+            layout_from = from;
+#endif
             LV_GC_ROOT(_lv_layout_list)[layout_id - 1].cb(obj, user_data);
+#if LV_USE_LAYOUT_INCREMENTAL
+            layout_obj = NULL;
+#endif
         }
     }
 }
 
+/**
+ * Mark an object and its screen for layout update
+ * @param obj       pointer to an object
+ */
+static void layout_mark(lv_obj_t * obj)
+{
+    obj->layout_inv = 1;
+
+    /*Mark the screen as dirty too to mark that there is something to do on this screen*/
+#if LV_USE_LAYOUT_INCREMENTAL
+    /*And the parents on the way, to not walk the rest*/
+    lv_obj_t * scr = obj;
+    while(scr->parent) {
+        scr = scr->parent;
+        scr->layout_child_inv = 1;
+    }
+#else
+    lv_obj_t * scr = lv_obj_get_screen(obj);
+#endif
+    scr->scr_layout_inv = 1;
+
+    /*Make the display refreshing*/
+    lv_disp_t * disp = lv_obj_get_disp(scr);
+    if(disp->refr_timer) lv_timer_resume(disp->refr_timer);
+}
+
 static void transform_point(const lv_obj_t * obj, lv_point_t * p, bool inv)
 {
     int16_t angle = lv_obj_get_style_transform_angle(obj, 0);
@@ -30,6 +30,16 @@ typedef struct {
     void * user_data;
 } lv_layout_dsc_t;
 
+#if LV_USE_LAYOUT_INCREMENTAL
+/**
+ * The start of what a layout keeps in a container to lay out only its changed children again
+ */
+typedef struct {
+    uint32_t layout;        /**< ID of the layout keeping it*/
+    uint32_t size;          /**< Its size in bytes*/
+} _lv_layout_cache_t;
+#endif
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -146,6 +156,40 @@ bool lv_obj_is_layout_positioned(const struct _lv_obj_t * obj);
  */
 void lv_obj_mark_layout_as_dirty(struct _lv_obj_t * obj);
 
+/**
+ * Mark the object for layout update because one of its children changed.
+ * The children before it are not laid out again if the layout doesn't need it.
+ * @param obj      pointer to an object whose children needs to be updated
+ * @param child    the child that changed, NULL if unknown or if it's not a child of `obj` anymore
+ */
+void _lv_obj_mark_layout_dirty_by_child(struct _lv_obj_t * obj, const struct _lv_obj_t * child);
+
+/**
+ * Mark the object for layout update from a child on.
+ * @param obj      pointer to an object whose children needs to be updated
+ * @param id       index of the first changed child, the number of children if only `obj` changed
+ */
+void _lv_obj_mark_layout_dirty_from(struct _lv_obj_t * obj, uint32_t id);
+
+#if LV_USE_LAYOUT_INCREMENTAL
+/**
+ * Tell a layout callback which children of the object changed since its last call.
+ * @param obj      pointer to the object whose layout is being updated
+ * @return         index of the first changed child, the number of children if only `obj` changed.
+ *                 The children before it and the layout's cache are as the last call left them.
+ */
+uint32_t _lv_obj_get_layout_dirty_from(const struct _lv_obj_t * obj);
+
+/**
+ * Get the cache of a layout in an object.
+ * @param obj      pointer to an object
+ * @param layout   ID of the layout
+ * @param size     size of the cache in bytes, starting with an `_lv_layout_cache_t`
+ * @return         the cache, zeroed if the object had none of this layout and size; NULL on out of memory
+ */
+void * _lv_obj_get_layout_cache(struct _lv_obj_t * obj, uint32_t layout, uint32_t size);
+#endif
+
 /**
  * Update the layout of an object.
  * @param obj      pointer to an object whose children needs to be updated
@@ -45,6 +45,10 @@ typedef enum {
 static lv_style_t * get_local_style(lv_obj_t * obj, lv_style_selector_t selector);
 static _lv_obj_style_t * get_trans_style(lv_obj_t * obj, uint32_t part);
 static lv_style_res_t get_prop_core(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop, lv_style_value_t * v);
+#if LV_USE_STYLE_CACHE
+static lv_style_res_t get_prop_cached(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop,
+                                      lv_style_value_t * v);
+#endif
 static void report_style_change_core(void * style, lv_obj_t * obj);
 static void refresh_children_style(lv_obj_t * obj);
 static bool trans_del(lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop, trans_t * tr_limit);
@@ -142,6 +146,9 @@ void lv_obj_remove_style(lv_obj_t * obj, lv_style_t * style, lv_style_selector_t
         obj->styles = lv_mem_realloc(obj->styles, obj->style_cnt * sizeof(_lv_obj_style_t));
 
         deleted = true;
+#if LV_USE_STYLE_CACHE
+        _lv_obj_style_cache_invalidate(obj);
+#endif
         /*The style from the current `i` index is removed, so `i` points to the next style.
          *Therefore it doesn't needs to be incremented*/
     }
@@ -168,6 +175,10 @@ void lv_obj_refresh_style(lv_obj_t * obj, lv_style_selector_t selector, lv_style
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
 
+#if LV_USE_STYLE_CACHE
+    _lv_obj_style_cache_invalidate(obj);
+#endif
+
     if(!style_refr) return;
 
     lv_obj_invalidate(obj);
@@ -190,7 +201,7 @@ void lv_obj_refresh_style(lv_obj_t * obj, lv_style_selector_t selector, lv_style
     }
     if((part == LV_PART_ANY || part == LV_PART_MAIN) && (prop == LV_STYLE_PROP_ANY || is_layout_refr)) {
         lv_obj_t * parent = lv_obj_get_parent(obj);
-        if(parent) lv_obj_mark_layout_as_dirty(parent);
+        if(parent) _lv_obj_mark_layout_dirty_by_child(parent, obj);
     }
 
     /*Cache the layer type*/
@@ -226,7 +237,11 @@ lv_style_value_t lv_obj_get_style_prop(const lv_obj_t * obj, lv_part_t part, lv_
     bool inheritable = lv_style_prop_has_flag(prop, LV_STYLE_PROP_INHERIT);
     lv_style_res_t found = LV_STYLE_RES_NOT_FOUND;
     while(obj) {
+#if LV_USE_STYLE_CACHE
+        found = get_prop_cached(obj, part, prop, &value_act);
+#else
         found = get_prop_core(obj, part, prop, &value_act);
+#endif
         if(found == LV_STYLE_RES_FOUND) break;
         if(!inheritable) break;
 
@@ -631,6 +646,31 @@ static lv_style_res_t get_prop_core(const lv_obj_t * obj, lv_part_t part, lv_sty
     else return LV_STYLE_RES_NOT_FOUND;
 }
 
+#if LV_USE_STYLE_CACHE
+/**
+ * `get_prop_core()` through the style cache of the object
+ * @param obj   pointer to an object
+ * @param part  the part
+ * @param prop  the property
+ * @param v     set to the value if found
+ * @return      what the styles of the object gave
+ */
+static lv_style_res_t get_prop_cached(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop,
+                                      lv_style_value_t * v)
+{
+    /*Only while a transition is being created, not what the object shows*/
+    if(obj->skip_trans) return get_prop_core(obj, part, prop, v);
+
+    lv_style_res_t res;
+    if(_lv_obj_style_cache_get(obj, part, prop, &res, v)) return res;
+
+    res = get_prop_core(obj, part, prop, v);
+    if(res != LV_STYLE_RES_FOUND) v->ptr = NULL;
+    _lv_obj_style_cache_add(obj, part, prop, res, *v);
+    return res;
+}
+#endif
+
 /**
  * Refresh the style of all children of an object. (Called recursively)
  * @param style refresh objects only with this
@@ -0,0 +1,257 @@
+/**
+ * @file lv_obj_style_cache.c
+ *
+ * What the styles of an object gave for the properties the drawing and the layout
+ * ask for all the time, kept in the object: a block of a slot a property for every
+ * part looked up. The key holds the object's state, so a pressed button keeps what
+ * it had released in the slots the pressed values didn't take.
+ *
+ * The styles change only between the refreshes, but the render threads look up and
+ * fill the same object's slots together: a slot is a sequence lock, odd while it's
+ * being written, and a writer that doesn't get it just leaves it.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_obj.h"
+#if LV_USE_STYLE_CACHE
+
+#include "../misc/lv_gc.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SLOT_NUM        24
+
+#define KEY_RES_SHIFT   8
+#define KEY_RES_MASK    (0x3 << KEY_RES_SHIFT)
+#define KEY_STATE_SHIFT 10
+
+/*The tag of a block: the style edit its slots are valid for, odd, or one of these*/
+#define TAG_STALE       0       /*The object's styles changed*/
+#define TAG_CLEARING    2       /*A thread is emptying the slots*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint32_t seq;               /*Odd while it's being written*/
+    uint32_t key;               /*The property, state and `lv_style_res_t`. 0: empty*/
+    lv_style_value_t value;
+} cache_slot_t;
+
+/*The slots of a part. The object has a list of them, the first part looked up first*/
+typedef struct _lv_obj_style_cache_t {
+    struct _lv_obj_style_cache_t * next;
+    uint32_t part;
+    uint32_t tag;
+    cache_slot_t slots[SLOT_NUM];
+} lv_obj_style_cache_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static int32_t prop_slot(lv_style_prop_t prop);
+static lv_obj_style_cache_t * block_find(const lv_obj_t * obj, uint32_t part);
+static bool block_validate(lv_obj_style_cache_t * b);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static bool cache_en = true;
+
+/**********************
+ *      MACROS
+ **********************/
+#define CUR_TAG()       ((_lv_style_gen << 1) | 1)
+#define KEY_OF(prop, state) ((prop) | ((uint32_t)(state) << KEY_STATE_SHIFT))
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_obj_enable_style_cache(bool en)
+{
+    cache_en = en;
+}
+
+void lv_obj_style_cache_get_stats(lv_obj_style_cache_stats_t * stats)
+{
+    *stats = LV_GC_DRAW_ROOT(_lv_obj_style_cache_stats);
+}
+
+void lv_obj_style_cache_reset_stats(void)
+{
+    lv_memset_00(&LV_GC_DRAW_ROOT(_lv_obj_style_cache_stats), sizeof(lv_obj_style_cache_stats_t));
+}
+
+bool _lv_obj_style_cache_get(const lv_obj_t * obj, uint32_t part, lv_style_prop_t prop,
+                             lv_style_res_t * res, lv_style_value_t * v)
+{
+    lv_obj_style_cache_stats_t * stats = &LV_GC_DRAW_ROOT(_lv_obj_style_cache_stats);
+    int32_t idx = prop_slot(prop);
+    if(idx < 0 || !cache_en) {
+        stats->uncached++;
+        return false;
+    }
+
+    lv_obj_style_cache_t * b = block_find(obj, part);
+    if(b == NULL || !block_validate(b)) {
+        stats->misses++;
+        return false;
+    }
+
+    cache_slot_t * s = &b->slots[idx];
+    uint32_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+    uint32_t key = __atomic_load_n(&s->key, __ATOMIC_RELAXED);
+    const void * value = __atomic_load_n(&s->value.ptr, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if((seq & 1) || __atomic_load_n(&s->seq, __ATOMIC_RELAXED) != seq ||
+       (key & ~KEY_RES_MASK) != KEY_OF(prop, obj->state)) {
+        stats->misses++;
+        return false;
+    }
+
+    stats->hits++;
+    *res = (key & KEY_RES_MASK) >> KEY_RES_SHIFT;
+    v->ptr = value;
+    return true;
+}
+
+void _lv_obj_style_cache_add(const lv_obj_t * obj, uint32_t part, lv_style_prop_t prop,
+                             lv_style_res_t res, lv_style_value_t v)
+{
+    int32_t idx = prop_slot(prop);
+    if(idx < 0 || !cache_en) return;
+
+    lv_obj_style_cache_t * b = block_find(obj, part);
+    if(b == NULL) {
+        b = lv_mem_alloc(sizeof(lv_obj_style_cache_t));
+        LV_ASSERT_MALLOC(b);
+        if(b == NULL) return;
+        lv_memset_00(b, sizeof(lv_obj_style_cache_t));
+        b->part = part;
+        b->tag = CUR_TAG();
+
+        /*Caching doesn't change the object. Append the block: another render thread
+         *might be appending one too, maybe for the same part (then it's never found)*/
+        lv_obj_style_cache_t ** link = &((lv_obj_t *)obj)->style_cache;
+        lv_obj_style_cache_t * last = NULL;
+        while(!__atomic_compare_exchange_n(link, &last, b, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            link = &last->next;
+            last = NULL;
+        }
+    }
+    if(__atomic_load_n(&b->tag, __ATOMIC_ACQUIRE) != CUR_TAG()) return;
+
+    cache_slot_t * s = &b->slots[idx];
+    uint32_t seq = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+    if(seq & 1) return;
+    if(!__atomic_compare_exchange_n(&s->seq, &seq, seq + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) return;
+
+    __atomic_store_n(&s->key, KEY_OF(prop, obj->state) | ((uint32_t)res << KEY_RES_SHIFT), __ATOMIC_RELAXED);
+    __atomic_store_n(&s->value.ptr, v.ptr, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void _lv_obj_style_cache_invalidate(lv_obj_t * obj)
+{
+    lv_obj_style_cache_t * b;
+    for(b = obj->style_cache; b; b = b->next) {
+        __atomic_store_n(&b->tag, TAG_STALE, __ATOMIC_RELAXED);
+    }
+}
+
+void _lv_obj_style_cache_free(lv_obj_t * obj)
+{
+    lv_obj_style_cache_t * b = obj->style_cache;
+    while(b) {
+        lv_obj_style_cache_t * next = b->next;
+        lv_mem_free(b);
+        b = next;
+    }
+    obj->style_cache = NULL;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Get the slot of a property
+ * @param prop      a property
+ * @return          its slot in the block of a part, -1 if it isn't cached
+ */
+static int32_t prop_slot(lv_style_prop_t prop)
+{
+    switch(prop) {
+        case LV_STYLE_PAD_TOP:      return 0;
+        case LV_STYLE_PAD_BOTTOM:   return 1;
+        case LV_STYLE_PAD_LEFT:     return 2;
+        case LV_STYLE_PAD_RIGHT:    return 3;
+        case LV_STYLE_PAD_ROW:      return 4;
+        case LV_STYLE_PAD_COLUMN:   return 5;
+        case LV_STYLE_RADIUS:       return 6;
+        case LV_STYLE_OPA:          return 7;
+        case LV_STYLE_BG_COLOR:     return 8;
+        case LV_STYLE_BG_OPA:       return 9;
+        case LV_STYLE_BORDER_COLOR: return 10;
+        case LV_STYLE_BORDER_OPA:   return 11;
+        case LV_STYLE_BORDER_WIDTH: return 12;
+        case LV_STYLE_TEXT_COLOR:   return 13;
+        case LV_STYLE_TEXT_OPA:     return 14;
+        case LV_STYLE_TEXT_FONT:    return 15;
+        /*Asked for by every draw too, the inherited ones through all the parents*/
+        case LV_STYLE_COLOR_FILTER_DSC:     return 16;
+        case LV_STYLE_BASE_DIR:             return 17;
+        case LV_STYLE_TEXT_LETTER_SPACE:    return 18;
+        case LV_STYLE_TEXT_LINE_SPACE:      return 19;
+        case LV_STYLE_TEXT_ALIGN:           return 20;
+        case LV_STYLE_TEXT_DECOR:           return 21;
+        case LV_STYLE_CLIP_CORNER:          return 22;
+        case LV_STYLE_BORDER_POST:          return 23;
+        default:                    return -1;
+    }
+}
+
+/**
+ * Find the block of a part
+ * @param obj       pointer to an object
+ * @param part      the part
+ * @return          the block, or NULL if the part has none yet
+ */
+static lv_obj_style_cache_t * block_find(const lv_obj_t * obj, uint32_t part)
+{
+    lv_obj_style_cache_t * b = __atomic_load_n(&obj->style_cache, __ATOMIC_ACQUIRE);
+    while(b && b->part != part) {
+        b = __atomic_load_n(&b->next, __ATOMIC_ACQUIRE);
+    }
+    return b;
+}
+
+/**
+ * Be sure the slots of a block are valid for the styles as they are, emptying them if they aren't
+ * @param b         a block
+ * @return          false if another thread is emptying them
+ */
+static bool block_validate(lv_obj_style_cache_t * b)
+{
+    uint32_t tag = __atomic_load_n(&b->tag, __ATOMIC_ACQUIRE);
+    uint32_t cur = CUR_TAG();
+    if(tag == cur) return true;
+    if(tag == TAG_CLEARING) return false;
+
+    /*Stale: the styles can't change while it's drawn, only the other render threads are here*/
+    if(!__atomic_compare_exchange_n(&b->tag, &tag, TAG_CLEARING, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    uint32_t i;
+    for(i = 0; i < SLOT_NUM; i++) {
+        __atomic_store_n(&b->slots[i].key, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&b->tag, cur, __ATOMIC_RELEASE);
+    return true;
+}
+
+#endif /*LV_USE_STYLE_CACHE*/
@@ -0,0 +1,106 @@
+/**
+ * @file lv_obj_style_cache.h
+ *
+ */
+
+#ifndef LV_OBJ_STYLE_CACHE_H
+#define LV_OBJ_STYLE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_conf_internal.h"
+#include "../misc/lv_style.h"
+
+#if LV_USE_STYLE_CACHE
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/*Can't include lv_obj.h because it includes this header file*/
+struct _lv_obj_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;            /**< Lookups of the cached properties resolved from the styles*/
+    uint32_t uncached;          /**< Lookups of the other properties, or while the cache is off*/
+} lv_obj_style_cache_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Turn the style cache of the objects on or off (it's on by default).
+ * Off, every lookup goes through the styles as without `LV_USE_STYLE_CACHE`.
+ * @param en    true: use the cache
+ */
+void lv_obj_enable_style_cache(bool en);
+
+/**
+ * Get the statistics of the calling render thread's lookups
+ * @param stats     filled with the counters since the last reset
+ */
+void lv_obj_style_cache_get_stats(lv_obj_style_cache_stats_t * stats);
+
+/** Zero the counters of the calling render thread*/
+void lv_obj_style_cache_reset_stats(void);
+
+/**
+ * Find what the styles of an object gave for a property, without its parents.
+ * @param obj       pointer to an object
+ * @param part      the part the property was looked up for
+ * @param prop      the property
+ * @param res       set to what the lookup found: `LV_STYLE_RES_FOUND/INHERIT/NOT_FOUND`
+ * @param v         set to the value if `*res` is `LV_STYLE_RES_FOUND`
+ * @return          true on a hit, else resolve it and add it with `_lv_obj_style_cache_add()`
+ */
+bool _lv_obj_style_cache_get(const struct _lv_obj_t * obj, uint32_t part, lv_style_prop_t prop,
+                             lv_style_res_t * res, lv_style_value_t * v);
+
+/**
+ * Keep what the styles of an object gave for a property. Does nothing for the properties not cached.
+ * @param obj       pointer to an object
+ * @param part      the part the property was looked up for
+ * @param prop      the property
+ * @param res       what the lookup found
+ * @param v         the value if `res` is `LV_STYLE_RES_FOUND`
+ */
+void _lv_obj_style_cache_add(const struct _lv_obj_t * obj, uint32_t part, lv_style_prop_t prop,
+                             lv_style_res_t res, lv_style_value_t v);
+
+/**
+ * Drop what's cached for an object, because its styles changed.
+ * The edits of the styles themselves (`lv_style_set_prop()`...) drop every object's.
+ * @param obj       pointer to an object
+ */
+void _lv_obj_style_cache_invalidate(struct _lv_obj_t * obj);
+
+/**
+ * Free the cache of an object
+ * @param obj       pointer to an object being deleted
+ */
+void _lv_obj_style_cache_free(struct _lv_obj_t * obj);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif  /*LV_USE_STYLE_CACHE*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_OBJ_STYLE_CACHE_H*/
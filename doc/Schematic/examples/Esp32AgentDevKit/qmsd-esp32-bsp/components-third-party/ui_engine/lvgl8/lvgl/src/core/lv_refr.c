@@ -26,10 +26,33 @@
 /*********************
  *      DEFINES
  *********************/
+#if LV_USE_REFR_PARALLEL
+#if LV_MEM_CUSTOM == 0
+    #error "LV_USE_REFR_PARALLEL: the render threads allocate concurrently, set a thread safe LV_MEM_CUSTOM allocator"
+#endif
+#if LV_COLOR_SCREEN_TRANSP
+    #error "LV_USE_REFR_PARALLEL: the render threads would race on `screen_transp`, disable LV_COLOR_SCREEN_TRANSP"
+#endif
+
+/*A band is at least this high, lower ones cost more in setup than they save*/
+#define REFR_BAND_MIN_ROWS  8
+#endif /*LV_USE_REFR_PARALLEL*/
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_USE_REFR_PARALLEL
+/*The part being rendered in bands*/
+typedef struct {
+    void * buf;
+    lv_area_t buf_area;
+    lv_area_t clip_area;
+    uint32_t cnt;       /*Number of bands*/
+    uint32_t next;      /*The next band to take, atomic*/
+    bool last;          /*Last part of the frame: the render threads clean up after it*/
+} refr_bands_t;
+#endif
+
 typedef struct {
     uint32_t    perf_last_time;
     uint32_t    elaps_sum;
@@ -55,6 +78,10 @@ static void lv_refr_join_area(void);
 static void refr_invalid_areas(void);
 static void refr_area(const lv_area_t * area_p);
 static void refr_area_part(lv_draw_ctx_t * draw_ctx);
+static void refr_area_draw(lv_draw_ctx_t * draw_ctx);
+#if LV_USE_REFR_PARALLEL
+    static void refr_bands(lv_draw_ctx_t * draw_ctx);
+#endif
 static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj);
 static void refr_obj_and_children(lv_draw_ctx_t * draw_ctx, lv_obj_t * top_obj);
 static void refr_obj(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj);
@@ -83,6 +110,11 @@ static lv_disp_t * disp_refr; /*Display being refreshed*/
     static mem_monitor_t    mem_monitor;
 #endif
 
+#if LV_USE_REFR_PARALLEL
+    static refr_bands_t bands;
+    static lv_draw_roots_t band_roots[LV_REFR_PARALLEL_THREADS - 1];
+#endif
+
 /**********************
  *      MACROS
  **********************/
@@ -279,6 +311,48 @@ void _lv_refr_set_disp_refreshing(lv_disp_t * disp)
     disp_refr = disp;
 }
 
+#if LV_USE_REFR_PARALLEL
+/**
+ * Render bands of the part being refreshed until none is left.
+ * @param drv pointer to the driver of the display being refreshed
+ * @param thread_id 0 for the thread running `lv_timer_handler()`,
+ *                  `1..LV_REFR_PARALLEL_THREADS-1` for the threads started by `render_bands_start_cb`
+ */
+void lv_refr_render_bands(lv_disp_drv_t * drv, uint32_t thread_id)
+{
+    LV_ASSERT(thread_id < LV_REFR_PARALLEL_THREADS);
+
+    lv_draw_ctx_t * draw_ctx = drv->draw_ctx;
+    if(thread_id > 0) {
+        draw_ctx = drv->band_draw_ctx[thread_id - 1];
+        _lv_draw_roots = &band_roots[thread_id - 1];
+    }
+
+    lv_coord_t h = lv_area_get_height(&bands.clip_area);
+    lv_area_t buf_area;
+    lv_area_t band_area = bands.clip_area;
+    uint32_t i;
+    while((i = __atomic_fetch_add(&bands.next, 1, __ATOMIC_RELAXED)) < bands.cnt) {
+        band_area.y1 = bands.clip_area.y1 + (h * i) / bands.cnt;
+        band_area.y2 = bands.clip_area.y1 + (h * (i + 1)) / bands.cnt - 1;
+        buf_area = bands.buf_area;
+        draw_ctx->buf = bands.buf;
+        draw_ctx->buf_area = &buf_area;
+        draw_ctx->clip_area = &band_area;
+        refr_area_draw(draw_ctx);
+    }
+
+    /*The thread of `lv_timer_handler()` cleans up in `_lv_disp_refr_timer`*/
+    if(thread_id > 0 && bands.last) {
+        lv_mem_buf_free_all();
+        _lv_font_clean_up_fmt_txt();
+#if LV_DRAW_COMPLEX
+        _lv_draw_mask_cleanup();
+#endif
+    }
+}
+#endif /*LV_USE_REFR_PARALLEL*/
+
 /**
  * Called periodically to handle the refreshing
  * @param tmr pointer to the timer itself
@@ -640,6 +714,61 @@ static void refr_area_part(lv_draw_ctx_t * draw_ctx)
 #endif
     }
 
+#if LV_USE_REFR_PARALLEL
+    refr_bands(draw_ctx);
+#else
+    refr_area_draw(draw_ctx);
+#endif
+
+    /*In true double buffered mode flush only once when all areas were rendered.
+     *In normal mode flush after every area*/
+    if(disp_refr->driver->full_refresh == false) {
+        draw_buf_flush(disp_refr);
+    }
+}
+
+#if LV_USE_REFR_PARALLEL
+/**
+ * Draw the part in bands on the render threads, or at once without them
+ * @param draw_ctx the draw context of the display, set up for the part
+ */
+static void refr_bands(lv_draw_ctx_t * draw_ctx)
+{
+    lv_disp_drv_t * drv = disp_refr->driver;
+    uint32_t cnt = LV_MIN(LV_REFR_PARALLEL_BANDS, lv_area_get_height(draw_ctx->clip_area) / REFR_BAND_MIN_ROWS);
+    if(drv->render_bands_start_cb == NULL || cnt < 2) {
+        refr_area_draw(draw_ctx);
+        return;
+    }
+
+    void * buf = draw_ctx->buf;
+    lv_area_t * buf_area = draw_ctx->buf_area;
+    const lv_area_t * clip_area = draw_ctx->clip_area;
+
+    bands.buf = buf;
+    bands.buf_area = *buf_area;
+    bands.clip_area = *clip_area;
+    bands.cnt = cnt;
+    bands.next = 0;
+    bands.last = drv->draw_buf->last_area && drv->draw_buf->last_part;
+
+    drv->render_bands_start_cb(drv);
+    lv_refr_render_bands(drv, 0);
+    if(drv->render_bands_wait_cb) drv->render_bands_wait_cb(drv);
+    bands.cnt = 0;
+
+    draw_ctx->buf = buf;
+    draw_ctx->buf_area = buf_area;
+    draw_ctx->clip_area = clip_area;
+}
+#endif /*LV_USE_REFR_PARALLEL*/
+
+/**
+ * Draw the screens and layers on the clip area of a draw context
+ * @param draw_ctx the draw context
+ */
+static void refr_area_draw(lv_draw_ctx_t * draw_ctx)
+{
     lv_obj_t * top_act_scr = NULL;
     lv_obj_t * top_prev_scr = NULL;
 
@@ -709,12 +838,6 @@ static void refr_area_part(lv_draw_ctx_t * draw_ctx)
     /*Also refresh top and sys layer unconditionally*/
     refr_obj_and_children(draw_ctx, lv_disp_get_layer_top(disp_refr));
     refr_obj_and_children(draw_ctx, lv_disp_get_layer_sys(disp_refr));
-
-    /*In true double buffered mode flush only once when all areas were rendered.
-     *In normal mode flush after every area*/
-    if(disp_refr->driver->full_refresh == false) {
-        draw_buf_flush(disp_refr);
-    }
 }
 
 /**
@@ -85,6 +85,17 @@ lv_disp_t * _lv_refr_get_disp_refreshing(void);
  */
 void _lv_refr_set_disp_refreshing(lv_disp_t * disp);
 
+#if LV_USE_REFR_PARALLEL
+/**
+ * Render bands of the part being refreshed until none is left.
+ * Called by the render threads `render_bands_start_cb` starts.
+ * @param drv pointer to the driver of the display being refreshed
+ * @param thread_id 0 for the thread running `lv_timer_handler()`,
+ *                  `1..LV_REFR_PARALLEL_THREADS-1` for the threads started by `render_bands_start_cb`
+ */
+void lv_refr_render_bands(lv_disp_drv_t * drv, uint32_t thread_id);
+#endif
+
 #if LV_USE_PERF_MONITOR
 /**
  * Reset FPS counter
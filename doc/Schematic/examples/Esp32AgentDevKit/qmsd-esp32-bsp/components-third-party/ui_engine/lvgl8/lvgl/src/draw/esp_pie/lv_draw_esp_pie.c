@@ -0,0 +1,435 @@
+/**
+ * @file lv_draw_esp_pie.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_draw_esp_pie.h"
+#include "../../core/lv_refr.h"
+
+#if LV_USE_GPU_ESP_PIE
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && defined(__XTENSA__) && !defined(LV_DRAW_ESP_PIE_EMULATE)
+    #define ESP_PIE_ASM 1
+#else
+    #define ESP_PIE_ASM 0
+    #include "lv_draw_esp_pie_emu.h"
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_COLOR_DEPTH != 16 || LV_COLOR_16_SWAP
+    #error "Can't use ESP PIE blending without LV_COLOR_DEPTH 16 and LV_COLOR_16_SWAP 0"
+#endif
+
+#if LV_COLOR_MIX_ROUND_OFS == 0
+    /*lv_color_mix takes a 5 bit ratio shortcut then, the kernels follow the per channel mix*/
+    #error "Can't use ESP PIE blending with LV_COLOR_MIX_ROUND_OFS 0"
+#endif
+
+/*Pixels per kernel call: the foreground and the ratios are staged in aligned buffers of this size*/
+#define CHUNK_PX        64
+
+#define PIE_ALIGNED     __attribute__((aligned(16)))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void fill_row(lv_color_t * dest_buf, lv_color_t color, int32_t w);
+
+static void copy_row(lv_color_t * dest_buf, const lv_color_t * src_buf, int32_t w);
+
+static void mix_row(lv_color_t * dest_buf, const lv_color_t * src_buf, lv_color_t color, const lv_opa_t * mask,
+                    lv_opa_t opa, lv_opa_t mask_cover, int32_t w);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/*Read in this order by one iteration of pie_mix: 255 for the inverse ratio, then per channel
+ *its mask, the rounding and the LV_UDIV255 multiplier (x * 0x8081 >> 23 is x / 255 for x < 16384)*/
+static const uint16_t mix_consts[10] = {
+    255,
+    0x1f, LV_COLOR_MIX_ROUND_OFS, 0x8081,
+    0x3f, LV_COLOR_MIX_ROUND_OFS, 0x8081,
+    0x1f, LV_COLOR_MIX_ROUND_OFS, 0x8081,
+};
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_draw_esp_pie_ctx_init(lv_disp_drv_t * drv, lv_draw_ctx_t * draw_ctx)
+{
+    lv_draw_sw_init_ctx(drv, draw_ctx);
+
+    lv_draw_esp_pie_ctx_t * pie_draw_ctx = (lv_draw_sw_ctx_t *)draw_ctx;
+
+    pie_draw_ctx->blend = lv_draw_esp_pie_blend;
+}
+
+void lv_draw_esp_pie_ctx_deinit(lv_disp_drv_t * drv, lv_draw_ctx_t * draw_ctx)
+{
+    lv_draw_sw_deinit_ctx(drv, draw_ctx);
+}
+
+LV_ATTRIBUTE_FAST_MEM void lv_draw_esp_pie_blend(lv_draw_ctx_t * draw_ctx, const lv_draw_sw_blend_dsc_t * dsc)
+{
+    lv_area_t blend_area;
+    if(!_lv_area_intersect(&blend_area, dsc->blend_area, draw_ctx->clip_area)) return;
+
+    lv_disp_t * disp = _lv_refr_get_disp_refreshing();
+    if(dsc->blend_mode != LV_BLEND_MODE_NORMAL || disp->driver->set_px_cb || disp->driver->screen_transp ||
+       lv_area_get_width(&blend_area) < LV_DRAW_ESP_PIE_MIN_WIDTH) {
+        lv_draw_sw_blend_basic(draw_ctx, dsc);
+        return;
+    }
+
+    const lv_opa_t * mask = dsc->mask_buf;
+    if(mask && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) return;
+    if(dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER) mask = NULL;
+
+    lv_coord_t dest_stride = lv_area_get_width(draw_ctx->buf_area);
+    lv_color_t * dest_buf = draw_ctx->buf;
+    dest_buf += dest_stride * (blend_area.y1 - draw_ctx->buf_area->y1) + (blend_area.x1 - draw_ctx->buf_area->x1);
+
+    const lv_color_t * src_buf = dsc->src_buf;
+    lv_coord_t src_stride = 0;
+    if(src_buf) {
+        src_stride = lv_area_get_width(dsc->blend_area);
+        src_buf += src_stride * (blend_area.y1 - dsc->blend_area->y1) + (blend_area.x1 - dsc->blend_area->x1);
+    }
+
+    lv_coord_t mask_stride = 0;
+    if(mask) {
+        mask_stride = lv_area_get_width(dsc->mask_area);
+        mask += mask_stride * (blend_area.y1 - dsc->mask_area->y1) + (blend_area.x1 - dsc->mask_area->x1);
+    }
+
+    /*The ratios of fill_normal and map_normal: with a mask "only the mask matters" from
+     *opa >= LV_OPA_MAX for a fill but opa > LV_OPA_MAX for a map, below that a mask value
+     *counts as full from LV_OPA_COVER for a fill but LV_OPA_MAX for a map.
+     *opa LV_OPA_COVER tells mix_row to take the mask value itself.*/
+    lv_opa_t opa = dsc->opa;
+    lv_opa_t mask_cover = src_buf ? LV_OPA_MAX : LV_OPA_COVER;
+    if(mask && (src_buf ? opa > LV_OPA_MAX : opa >= LV_OPA_MAX)) opa = LV_OPA_COVER;
+
+    int32_t w = lv_area_get_width(&blend_area);
+    int32_t h = lv_area_get_height(&blend_area);
+    for(int32_t y = 0; y < h; y++) {
+        if(mask == NULL && opa >= LV_OPA_MAX) {
+            if(src_buf) copy_row(dest_buf, src_buf, w);
+            else fill_row(dest_buf, dsc->color, w);
+        }
+        else {
+            mix_row(dest_buf, src_buf, dsc->color, mask, opa, mask_cover, w);
+        }
+        dest_buf += dest_stride;
+        if(src_buf) src_buf += src_stride;
+        if(mask) mask += mask_stride;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/*Kernels: dest_buf is 16 byte aligned, n8 > 0 blocks of 8 pixels*/
+
+#if ESP_PIE_ASM
+
+/*One channel of lv_color_mix, q5/q6 the foreground/background channel, q2/q3 the ratio
+ *and its inverse: q5 = LV_UDIV255(q5 * q2 + q6 * q3 + LV_COLOR_MIX_ROUND_OFS)*/
+#define PIE_MIX_CHANNEL                 \
+    "ssai 0\n"                          \
+    "ee.vmul.u16 q5, q5, q2\n"          \
+    "ee.vmul.u16 q6, q6, q3\n"          \
+    "ee.vadds.s16 q5, q5, q6\n"         \
+    "ee.vldbc.16.ip q4, %[k], 2\n"      \
+    "ee.vadds.s16 q5, q5, q4\n"         \
+    "ee.vldbc.16.ip q4, %[k], 2\n"      \
+    "ssai 23\n"                         \
+    "ee.vmul.u16 q5, q5, q4\n"
+
+static inline void pie_fill(lv_color_t * dest_buf, const lv_color_t * color, uint32_t n8)
+{
+    __asm__ volatile(
+        "ee.vldbc.16 q0, %[c]\n"
+        "1:\n"
+        "ee.vst.128.ip q0, %[d], 16\n"
+        "addi %[n], %[n], -1\n"
+        "bnez %[n], 1b\n"
+        : [d] "+r"(dest_buf), [n] "+r"(n8)
+        : [c] "r"(color)
+        : "memory");
+}
+
+static inline void pie_copy(lv_color_t * dest_buf, const lv_color_t * src_buf, uint32_t n8)
+{
+    if(((uintptr_t)src_buf & 0xf) == 0) {
+        __asm__ volatile(
+            "1:\n"
+            "ee.vld.128.ip q0, %[s], 16\n"
+            "ee.vst.128.ip q0, %[d], 16\n"
+            "addi %[n], %[n], -1\n"
+            "bnez %[n], 1b\n"
+            : [d] "+r"(dest_buf), [s] "+r"(src_buf), [n] "+r"(n8)
+            :
+            : "memory");
+    }
+    else {
+        /*Aligned loads around the source, ee.src.q shifts each pair by the offset.
+         *The blocks touched are the ones holding the n8 * 16 bytes, nothing past them.*/
+        __asm__ volatile(
+            "ee.ld.128.usar.ip q0, %[s], 16\n"
+            "1:\n"
+            "ee.ld.128.usar.ip q1, %[s], 16\n"
+            "ee.src.q.qup q2, q0, q1\n"
+            "ee.vst.128.ip q2, %[d], 16\n"
+            "addi %[n], %[n], -1\n"
+            "bnez %[n], 1b\n"
+            : [d] "+r"(dest_buf), [s] "+r"(src_buf), [n] "+r"(n8)
+            :
+            : "memory", "sar");
+    }
+}
+
+/*dest_buf[i] = lv_color_mix(fg[i], dest_buf[i], ratio[i]). fg and ratio are aligned and
+ *advance by fg_step and ratio_step bytes a block: 16, or 0 to repeat one block.*/
+static inline void pie_mix(lv_color_t * dest_buf, const lv_color_t * fg, uint32_t fg_step,
+                           const uint16_t * ratio, uint32_t ratio_step, uint32_t n8)
+{
+    const uint16_t * k = mix_consts;
+    __asm__ volatile(
+        "1:\n"
+        "ee.vld.128.xp q0, %[fg], %[fs]\n"
+        "ee.vld.128.xp q2, %[m], %[ms]\n"
+        "ee.vld.128.ip q1, %[d], 0\n"
+        "ee.vldbc.16.ip q4, %[k], 2\n"
+        "ee.vsubs.s16 q3, q4, q2\n"
+        "ee.zero.q q7\n"
+        /*red, bits 11..15*/
+        "ssai 11\n"
+        "ee.vsr.32 q5, q0\n"
+        "ee.vsr.32 q6, q1\n"
+        "ee.vldbc.16.ip q4, %[k], 2\n"
+        "ee.andq q5, q5, q4\n"
+        "ee.andq q6, q6, q4\n"
+        PIE_MIX_CHANNEL
+        "ssai 11\n"
+        "ee.vsl.32 q5, q5\n"
+        "ee.orq q7, q7, q5\n"
+        /*green, bits 5..10*/
+        "ssai 5\n"
+        "ee.vsr.32 q5, q0\n"
+        "ee.vsr.32 q6, q1\n"
+        "ee.vldbc.16.ip q4, %[k], 2\n"
+        "ee.andq q5, q5, q4\n"
+        "ee.andq q6, q6, q4\n"
+        PIE_MIX_CHANNEL
+        "ssai 5\n"
+        "ee.vsl.32 q5, q5\n"
+        "ee.orq q7, q7, q5\n"
+        /*blue, bits 0..4*/
+        "ee.vldbc.16.ip q4, %[k], 2\n"
+        "ee.andq q5, q0, q4\n"
+        "ee.andq q6, q1, q4\n"
+        PIE_MIX_CHANNEL
+        "ee.orq q7, q7, q5\n"
+        "ee.vst.128.ip q7, %[d], 16\n"
+        "addi %[k], %[k], -20\n"
+        "addi %[n], %[n], -1\n"
+        "bnez %[n], 1b\n"
+        : [d] "+r"(dest_buf), [fg] "+r"(fg), [m] "+r"(ratio), [k] "+r"(k), [n] "+r"(n8)
+        : [fs] "r"(fg_step), [ms] "r"(ratio_step)
+        : "memory", "sar");
+}
+
+#else /*ESP_PIE_ASM*/
+
+/*The same instruction sequences on the portable model, see lv_draw_esp_pie_emu.h*/
+
+static inline void pie_fill(lv_color_t * dest_buf, const lv_color_t * color, uint32_t n8)
+{
+    lv_pie_q_t q0 = ee_vldbc_16(&color->full);
+    do {
+        ee_vst_128(dest_buf, q0);
+        dest_buf += 8;
+    } while(--n8);
+}
+
+static inline void pie_copy(lv_color_t * dest_buf, const lv_color_t * src_buf, uint32_t n8)
+{
+    if(((uintptr_t)src_buf & 0xf) == 0) {
+        do {
+            ee_vst_128(dest_buf, ee_vld_128(src_buf));
+            src_buf += 8;
+            dest_buf += 8;
+        } while(--n8);
+    }
+    else {
+        uint32_t sar_byte;
+        lv_pie_q_t q0 = ee_ld_128_usar(src_buf, &sar_byte);
+        src_buf += 8;
+        do {
+            lv_pie_q_t q1 = ee_ld_128_usar(src_buf, &sar_byte);
+            src_buf += 8;
+            ee_vst_128(dest_buf, ee_src_q(q0, q1, sar_byte));
+            q0 = q1;
+            dest_buf += 8;
+        } while(--n8);
+    }
+}
+
+static inline lv_pie_q_t pie_mix_channel(lv_pie_q_t q5, lv_pie_q_t q6, lv_pie_q_t q2, lv_pie_q_t q3,
+                                         const uint16_t ** k)
+{
+    q5 = ee_vmul_u16(q5, q2, 0);
+    q6 = ee_vmul_u16(q6, q3, 0);
+    q5 = ee_vadds_s16(q5, q6);
+    q5 = ee_vadds_s16(q5, ee_vldbc_16((*k)++));
+    return ee_vmul_u16(q5, ee_vldbc_16((*k)++), 23);
+}
+
+static inline void pie_mix(lv_color_t * dest_buf, const lv_color_t * fg, uint32_t fg_step,
+                           const uint16_t * ratio, uint32_t ratio_step, uint32_t n8)
+{
+    do {
+        const uint16_t * k = mix_consts;
+        lv_pie_q_t q0 = ee_vld_128(fg);
+        lv_pie_q_t q2 = ee_vld_128(ratio);
+        lv_pie_q_t q1 = ee_vld_128(dest_buf);
+        fg = (const lv_color_t *)((const uint8_t *)fg + fg_step);
+        ratio = (const uint16_t *)((const uint8_t *)ratio + ratio_step);
+        lv_pie_q_t q3 = ee_vsubs_s16(ee_vldbc_16(k++), q2);
+        lv_pie_q_t q7 = ee_zero_q();
+        lv_pie_q_t q4;
+        lv_pie_q_t q5;
+        lv_pie_q_t q6;
+        /*red, bits 11..15*/
+        q4 = ee_vldbc_16(k++);
+        q5 = ee_andq(ee_vsr_32(q0, 11), q4);
+        q6 = ee_andq(ee_vsr_32(q1, 11), q4);
+        q5 = pie_mix_channel(q5, q6, q2, q3, &k);
+        q7 = ee_orq(q7, ee_vsl_32(q5, 11));
+        /*green, bits 5..10*/
+        q4 = ee_vldbc_16(k++);
+        q5 = ee_andq(ee_vsr_32(q0, 5), q4);
+        q6 = ee_andq(ee_vsr_32(q1, 5), q4);
+        q5 = pie_mix_channel(q5, q6, q2, q3, &k);
+        q7 = ee_orq(q7, ee_vsl_32(q5, 5));
+        /*blue, bits 0..4*/
+        q4 = ee_vldbc_16(k++);
+        q5 = ee_andq(q0, q4);
+        q6 = ee_andq(q1, q4);
+        q5 = pie_mix_channel(q5, q6, q2, q3, &k);
+        q7 = ee_orq(q7, q5);
+        ee_vst_128(dest_buf, q7);
+        dest_buf += 8;
+    } while(--n8);
+}
+
+#endif /*ESP_PIE_ASM*/
+
+/*Pixels before dest_buf reaches a 16 byte boundary*/
+static inline int32_t head_px(const lv_color_t * dest_buf, int32_t w)
+{
+    int32_t head = (int32_t)((16 - ((uintptr_t)dest_buf & 0xf)) & 0xf) / (int32_t)sizeof(lv_color_t);
+    return LV_MIN(head, w);
+}
+
+LV_ATTRIBUTE_FAST_MEM static void fill_row(lv_color_t * dest_buf, lv_color_t color, int32_t w)
+{
+    /*lv_color_fill writes a pixel before looking at the count*/
+    int32_t x = head_px(dest_buf, w);
+    if(x) lv_color_fill(dest_buf, color, x);
+    int32_t n8 = (w - x) / 8;
+    if(n8) pie_fill(dest_buf + x, &color, n8);
+    x += n8 * 8;
+    if(x < w) lv_color_fill(dest_buf + x, color, w - x);
+}
+
+LV_ATTRIBUTE_FAST_MEM static void copy_row(lv_color_t * dest_buf, const lv_color_t * src_buf, int32_t w)
+{
+    int32_t x = head_px(dest_buf, w);
+    lv_memcpy(dest_buf, src_buf, x * sizeof(lv_color_t));
+    int32_t n8 = (w - x) / 8;
+    if(n8) pie_copy(dest_buf + x, src_buf + x, n8);
+    x += n8 * 8;
+    lv_memcpy(dest_buf + x, src_buf + x, (w - x) * sizeof(lv_color_t));
+}
+
+static inline lv_opa_t mask_ratio(lv_opa_t mask, lv_opa_t opa, lv_opa_t mask_cover)
+{
+    if(opa == LV_OPA_COVER) return mask;
+    return mask >= mask_cover ? opa : (lv_opa_t)((mask * opa) >> 8);
+}
+
+/*dest_buf[x] = lv_color_mix(src_buf ? src_buf[x] : color, dest_buf[x], ratio of mask[x] and opa)*/
+LV_ATTRIBUTE_FAST_MEM static void mix_row(lv_color_t * dest_buf, const lv_color_t * src_buf, lv_color_t color,
+                                          const lv_opa_t * mask, lv_opa_t opa, lv_opa_t mask_cover, int32_t w)
+{
+    PIE_ALIGNED lv_color_t fg[CHUNK_PX];
+    PIE_ALIGNED uint16_t ratio[CHUNK_PX];
+    int32_t x;
+    int32_t head = head_px(dest_buf, w);
+
+    for(x = 0; x < head; x++) {
+        lv_opa_t m = mask ? mask_ratio(mask[x], opa, mask_cover) : opa;
+        if(m) dest_buf[x] = lv_color_mix(src_buf ? src_buf[x] : color, dest_buf[x], m);
+    }
+
+    /*A fill repeats one block of the color, no mask one block of opa*/
+    if(src_buf == NULL) lv_color_fill(fg, color, 8);
+    if(mask == NULL) {
+        for(int32_t i = 0; i < 8; i++) ratio[i] = opa;
+    }
+
+    while(w - x >= 8) {
+        int32_t n = LV_MIN(w - x, CHUNK_PX) & ~7;
+
+        const lv_color_t * fg_p = fg;
+        uint32_t fg_step = 16;
+        if(src_buf == NULL) fg_step = 0;
+        else if(((uintptr_t)(src_buf + x) & 0xf) == 0) fg_p = src_buf + x;
+        else lv_memcpy(fg, src_buf + x, n * sizeof(lv_color_t));
+
+        uint32_t ratio_step = 0;
+        if(mask) {
+            uint32_t any = 0;
+            for(int32_t i = 0; i < n; i++) {
+                ratio[i] = mask_ratio(mask[x + i], opa, mask_cover);
+                any |= ratio[i];
+            }
+            ratio_step = 16;
+            /*Nothing to draw here, common at the edges of masks*/
+            if(any == 0) {
+                x += n;
+                continue;
+            }
+        }
+
+        pie_mix(dest_buf + x, fg_p, fg_step, ratio, ratio_step, n / 8);
+        x += n;
+    }
+
+    for(; x < w; x++) {
+        lv_opa_t m = mask ? mask_ratio(mask[x], opa, mask_cover) : opa;
+        if(m) dest_buf[x] = lv_color_mix(src_buf ? src_buf[x] : color, dest_buf[x], m);
+    }
+}
+
+#endif /*LV_USE_GPU_ESP_PIE*/
@@ -0,0 +1,63 @@
+/**
+ * @file lv_draw_esp_pie.h
+ *
+ */
+
+#ifndef LV_DRAW_ESP_PIE_H
+#define LV_DRAW_ESP_PIE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../misc/lv_color.h"
+#include "../../hal/lv_hal_disp.h"
+#include "../sw/lv_draw_sw.h"
+
+#if LV_USE_GPU_ESP_PIE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*Narrower blends stay on the software path, the vector setup doesn't pay off*/
+#define LV_DRAW_ESP_PIE_MIN_WIDTH   16
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef lv_draw_sw_ctx_t lv_draw_esp_pie_ctx_t;
+
+struct _lv_disp_drv_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void lv_draw_esp_pie_ctx_init(struct _lv_disp_drv_t * drv, lv_draw_ctx_t * draw_ctx);
+
+void lv_draw_esp_pie_ctx_deinit(struct _lv_disp_drv_t * drv, lv_draw_ctx_t * draw_ctx);
+
+/**
+ * Blend with the ESP32-S3 PIE (128 bit SIMD) kernels: RGB565 fill, copy and
+ * mix with a per pixel ratio, 8 pixels at a time. The result is bit exact with
+ * `lv_draw_sw_blend_basic`, which handles what the kernels don't (other blend
+ * modes, `set_px_cb`, `screen_transp`, narrow areas).
+ * On other targets the same kernels run on a portable model of the instructions.
+ */
+void lv_draw_esp_pie_blend(lv_draw_ctx_t * draw_ctx, const lv_draw_sw_blend_dsc_t * dsc);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif  /*LV_USE_GPU_ESP_PIE*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_DRAW_ESP_PIE_H*/
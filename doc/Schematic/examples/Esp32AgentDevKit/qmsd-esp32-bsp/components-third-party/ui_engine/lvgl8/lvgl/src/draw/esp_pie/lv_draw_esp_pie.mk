@@ -0,0 +1,6 @@
+CSRCS += lv_draw_esp_pie.c
+
+DEPPATH += --dep-path $(LVGL_DIR)/$(LVGL_DIR_NAME)/src/draw/esp_pie
+VPATH += :$(LVGL_DIR)/$(LVGL_DIR_NAME)/src/draw/esp_pie
+
+CFLAGS += "-I$(LVGL_DIR)/$(LVGL_DIR_NAME)/src/draw/esp_pie"
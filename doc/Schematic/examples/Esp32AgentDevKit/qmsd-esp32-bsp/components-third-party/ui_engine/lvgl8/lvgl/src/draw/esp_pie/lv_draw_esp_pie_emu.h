@@ -0,0 +1,153 @@
+/**
+ * @file lv_draw_esp_pie_emu.h
+ * Portable model of the ESP32-S3 PIE instructions used by the blend kernels.
+ * One function per instruction, same operands, so the emulated kernels read
+ * like their assembly and both can be checked on a host. SAR is passed
+ * explicitly where the instruction reads it.
+ */
+
+#ifndef LV_DRAW_ESP_PIE_EMU_H
+#define LV_DRAW_ESP_PIE_EMU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <string.h>
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*A q register: 128 bits, seen here as 8 lanes of 16 bits*/
+typedef struct {
+    uint16_t h[8];
+} lv_pie_q_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/*The loops have a fixed trip count of 8 or 4, compilers turn them into host SIMD*/
+
+/*ee.vld.128.ip / .xp, the low 4 address bits are ignored*/
+static inline lv_pie_q_t ee_vld_128(const void * p)
+{
+    lv_pie_q_t q;
+    memcpy(&q, (const void *)((uintptr_t)p & ~(uintptr_t)0xf), sizeof(q));
+    return q;
+}
+
+/*ee.vst.128.ip / .xp, the low 4 address bits are ignored*/
+static inline void ee_vst_128(void * p, lv_pie_q_t q)
+{
+    memcpy((void *)((uintptr_t)p & ~(uintptr_t)0xf), &q, sizeof(q));
+}
+
+/*ee.ld.128.usar.ip: an aligned load that keeps the address offset in SAR_BYTE*/
+static inline lv_pie_q_t ee_ld_128_usar(const void * p, uint32_t * sar_byte)
+{
+    *sar_byte = (uintptr_t)p & 0xf;
+    return ee_vld_128(p);
+}
+
+/*ee.src.q.qup: 16 bytes of {q1, q0} from SAR_BYTE on, q0 takes q1 (done by the caller)*/
+static inline lv_pie_q_t ee_src_q(lv_pie_q_t q0, lv_pie_q_t q1, uint32_t sar_byte)
+{
+    uint8_t b[32];
+    lv_pie_q_t q;
+    memcpy(b, &q0, 16);
+    memcpy(b + 16, &q1, 16);
+    memcpy(&q, b + sar_byte, 16);
+    return q;
+}
+
+/*ee.vldbc.16: one 16 bit value to every lane*/
+static inline lv_pie_q_t ee_vldbc_16(const uint16_t * p)
+{
+    lv_pie_q_t q;
+    for(int i = 0; i < 8; i++) q.h[i] = *p;
+    return q;
+}
+
+/*ee.zero.q*/
+static inline lv_pie_q_t ee_zero_q(void)
+{
+    lv_pie_q_t q;
+    memset(&q, 0, sizeof(q));
+    return q;
+}
+
+/*ee.andq*/
+static inline lv_pie_q_t ee_andq(lv_pie_q_t x, lv_pie_q_t y)
+{
+    for(int i = 0; i < 8; i++) x.h[i] &= y.h[i];
+    return x;
+}
+
+/*ee.orq*/
+static inline lv_pie_q_t ee_orq(lv_pie_q_t x, lv_pie_q_t y)
+{
+    for(int i = 0; i < 8; i++) x.h[i] |= y.h[i];
+    return x;
+}
+
+/*ee.vsr.32: arithmetic shift right of the 4 32 bit lanes (little endian pairs of 16)*/
+static inline lv_pie_q_t ee_vsr_32(lv_pie_q_t x, uint32_t sar)
+{
+    for(int i = 0; i < 4; i++) {
+        int32_t w = (int32_t)((uint32_t)x.h[2 * i] | ((uint32_t)x.h[2 * i + 1] << 16));
+        w >>= sar;
+        x.h[2 * i] = (uint16_t)w;
+        x.h[2 * i + 1] = (uint16_t)((uint32_t)w >> 16);
+    }
+    return x;
+}
+
+/*ee.vsl.32: shift left of the 4 32 bit lanes*/
+static inline lv_pie_q_t ee_vsl_32(lv_pie_q_t x, uint32_t sar)
+{
+    for(int i = 0; i < 4; i++) {
+        uint32_t w = (uint32_t)x.h[2 * i] | ((uint32_t)x.h[2 * i + 1] << 16);
+        w <<= sar;
+        x.h[2 * i] = (uint16_t)w;
+        x.h[2 * i + 1] = (uint16_t)(w >> 16);
+    }
+    return x;
+}
+
+/*ee.vmul.u16: 32 bit products shifted right by SAR, low 16 bits kept*/
+static inline lv_pie_q_t ee_vmul_u16(lv_pie_q_t x, lv_pie_q_t y, uint32_t sar)
+{
+    for(int i = 0; i < 8; i++) x.h[i] = (uint16_t)(((uint32_t)x.h[i] * y.h[i]) >> sar);
+    return x;
+}
+
+static inline uint16_t ee_sat_s16(int32_t v)
+{
+    return (uint16_t)(v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v);
+}
+
+/*ee.vadds.s16: signed saturating add*/
+static inline lv_pie_q_t ee_vadds_s16(lv_pie_q_t x, lv_pie_q_t y)
+{
+    for(int i = 0; i < 8; i++) x.h[i] = ee_sat_s16((int32_t)(int16_t)x.h[i] + (int16_t)y.h[i]);
+    return x;
+}
+
+/*ee.vsubs.s16: signed saturating subtract, x - y*/
+static inline lv_pie_q_t ee_vsubs_s16(lv_pie_q_t x, lv_pie_q_t y)
+{
+    for(int i = 0; i < 8; i++) x.h[i] = ee_sat_s16((int32_t)(int16_t)x.h[i] - (int16_t)y.h[i]);
+    return x;
+}
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_DRAW_ESP_PIE_EMU_H*/
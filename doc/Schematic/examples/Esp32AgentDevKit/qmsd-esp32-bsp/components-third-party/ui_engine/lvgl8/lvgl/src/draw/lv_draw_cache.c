@@ -0,0 +1,326 @@
+/**
+ * @file lv_draw_cache.c
+ *
+ * One budget for the caches of the drawing. An entry's priority is the clock
+ * when it was last used plus its cost a byte; the entry with the lowest
+ * priority (the least recently used of them on a tie) is evicted and moves the
+ * clock to its priority. So what's cheap to make again for its size goes
+ * first, and an expensive entry not used for long goes eventually too.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_draw_cache.h"
+#if LV_USE_DRAW_CACHE
+
+#include "../misc/lv_gc.h"
+#include "../misc/lv_mem.h"
+#include "../misc/lv_assert.h"
+#include "../misc/lv_math.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define BUCKET_BITS     7
+#define CREDIT_SHIFT    8       /*Fraction bits of the cost a byte*/
+
+#if LV_USE_REFR_PARALLEL
+    #define THREAD_NUM  LV_REFR_PARALLEL_THREADS
+#else
+    #define THREAD_NUM  1
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct _cache_entry_t {
+    struct _cache_entry_t * prev;       /*All entries, the most recently used first*/
+    struct _cache_entry_t * next;
+    struct _cache_entry_t * hash_next;
+    lv_draw_cache_drop_cb_t drop_cb;
+    uint64_t prio;
+    uint32_t key;
+    uint32_t charge;                    /*The entry and what it holds*/
+    uint32_t credit;                    /*The cost a byte, added to the clock on every use*/
+    uint16_t ref_cnt;
+    uint8_t type;
+    uint8_t dead;                       /*Dropped while held, freed on release*/
+} cache_entry_t;
+
+typedef struct {
+    cache_entry_t * head;
+    cache_entry_t * tail;
+    cache_entry_t * buckets[1 << BUCKET_BITS];
+    uint64_t clock;
+    uint32_t bytes;
+    uint32_t gen[_LV_DRAW_CACHE_TYPE_NUM];
+    uint32_t type_entries[_LV_DRAW_CACHE_TYPE_NUM];
+    uint32_t type_bytes[_LV_DRAW_CACHE_TYPE_NUM];
+    lv_draw_cache_stats_t stats[_LV_DRAW_CACHE_TYPE_NUM];
+} draw_cache_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static draw_cache_t * cache_get(void);
+static bool make_room(draw_cache_t * c, uint32_t charge, uint32_t cap);
+static void entry_unhash(draw_cache_t * c, cache_entry_t * e);
+static void entry_free(draw_cache_t * c, cache_entry_t * e);
+static void entry_drop(draw_cache_t * c, cache_entry_t * e);
+static void list_remove(draw_cache_t * c, cache_entry_t * e);
+static void list_push(draw_cache_t * c, cache_entry_t * e);
+static uint32_t bucket_of(lv_draw_cache_type_t type, uint32_t key);
+static void * default_alloc(size_t size);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+/*Shared by the render threads*/
+static lv_draw_cache_alloc_cb_t alloc_cb = default_alloc;
+static lv_draw_cache_free_cb_t free_cb = lv_mem_free;
+static uint32_t cache_size = LV_DRAW_CACHE_SIZE;
+static uint32_t type_gen[_LV_DRAW_CACHE_TYPE_NUM];
+
+/**********************
+ *      MACROS
+ **********************/
+#define HDR_SIZE        ((sizeof(cache_entry_t) + 7) & ~7)
+#define ENTRY_DATA(e)   ((void *)((uint8_t *)(e) + HDR_SIZE))
+#define DATA_ENTRY(d)   ((cache_entry_t *)((uint8_t *)(d) - HDR_SIZE))
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_draw_cache_set_alloc_cb(lv_draw_cache_alloc_cb_t new_alloc_cb, lv_draw_cache_free_cb_t new_free_cb)
+{
+    alloc_cb = new_alloc_cb ? new_alloc_cb : default_alloc;
+    free_cb = new_free_cb ? new_free_cb : lv_mem_free;
+}
+
+void lv_draw_cache_set_size(uint32_t size)
+{
+    __atomic_store_n(&cache_size, size, __ATOMIC_RELAXED);
+}
+
+void lv_draw_cache_invalidate(lv_draw_cache_type_t type)
+{
+    __atomic_add_fetch(&type_gen[type], 1, __ATOMIC_RELAXED);
+}
+
+void lv_draw_cache_get_stats(lv_draw_cache_type_t type, lv_draw_cache_stats_t * stats)
+{
+    lv_memset_00(stats, sizeof(lv_draw_cache_stats_t));
+    draw_cache_t * c = LV_GC_DRAW_ROOT(_lv_draw_cache);
+    if(c == NULL) return;
+
+    *stats = c->stats[type];
+    stats->entries = c->type_entries[type];
+    stats->bytes = c->type_bytes[type];
+}
+
+void lv_draw_cache_reset_stats(void)
+{
+    draw_cache_t * c = LV_GC_DRAW_ROOT(_lv_draw_cache);
+    if(c) lv_memset_00(c->stats, sizeof(c->stats));
+}
+
+void * _lv_draw_cache_get(lv_draw_cache_type_t type, uint32_t key)
+{
+    draw_cache_t * c = cache_get();
+    if(c == NULL) return NULL;
+
+    cache_entry_t * e;
+    for(e = c->buckets[bucket_of(type, key)]; e; e = e->hash_next) {
+        if(e->key == key && e->type == type) break;
+    }
+    if(e == NULL) return NULL;
+
+    e->ref_cnt++;
+    e->prio = c->clock + e->credit;
+    list_remove(c, e);
+    list_push(c, e);
+    c->stats[type].hits++;
+    return ENTRY_DATA(e);
+}
+
+void * _lv_draw_cache_add(lv_draw_cache_type_t type, uint32_t key, uint32_t size, uint32_t held_size,
+                          uint32_t cost, lv_draw_cache_drop_cb_t drop_cb)
+{
+    draw_cache_t * c = cache_get();
+    if(c == NULL) return NULL;
+
+    uint32_t charge = HDR_SIZE + size + held_size;
+    uint32_t cap = __atomic_load_n(&cache_size, __ATOMIC_RELAXED) / THREAD_NUM;
+    if(charge > cap || !make_room(c, charge, cap)) {
+        c->stats[type].rejects++;
+        return NULL;
+    }
+
+    cache_entry_t * e = alloc_cb(HDR_SIZE + size);
+    if(e == NULL) {
+        c->stats[type].rejects++;
+        return NULL;
+    }
+
+    e->key = key;
+    e->type = type;
+    e->charge = charge;
+    e->credit = (uint32_t)LV_MIN(((uint64_t)cost << CREDIT_SHIFT) / charge, UINT32_MAX);
+    e->prio = c->clock + e->credit;
+    e->ref_cnt = 1;
+    e->dead = 0;
+    e->drop_cb = drop_cb;
+
+    uint32_t b = bucket_of(type, key);
+    e->hash_next = c->buckets[b];
+    c->buckets[b] = e;
+    list_push(c, e);
+    c->bytes += charge;
+    c->type_entries[type]++;
+    c->type_bytes[type] += charge;
+    c->stats[type].misses++;
+    return ENTRY_DATA(e);
+}
+
+void _lv_draw_cache_release(void * data)
+{
+    cache_entry_t * e = DATA_ENTRY(data);
+    LV_ASSERT(e->ref_cnt > 0);
+    e->ref_cnt--;
+    if(e->ref_cnt == 0 && e->dead) entry_free(LV_GC_DRAW_ROOT(_lv_draw_cache), e);
+}
+
+void _lv_draw_cache_drop(void * data)
+{
+    entry_drop(LV_GC_DRAW_ROOT(_lv_draw_cache), DATA_ENTRY(data));
+}
+
+void _lv_draw_cache_drop_matching(lv_draw_cache_type_t type, bool (*match_cb)(void * data, const void * ctx),
+                                  const void * ctx)
+{
+    draw_cache_t * c = LV_GC_DRAW_ROOT(_lv_draw_cache);
+    if(c == NULL) return;
+
+    cache_entry_t * e = c->head;
+    while(e) {
+        cache_entry_t * next = e->next;
+        if(e->type == type && !e->dead && match_cb(ENTRY_DATA(e), ctx)) entry_drop(c, e);
+        e = next;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/*The calling thread's cache, created on first use, the invalidated types emptied, trimmed to the budget*/
+static draw_cache_t * cache_get(void)
+{
+    if(__atomic_load_n(&cache_size, __ATOMIC_RELAXED) == 0) return NULL;
+
+    draw_cache_t * c = LV_GC_DRAW_ROOT(_lv_draw_cache);
+    if(c == NULL) {
+        c = lv_mem_alloc(sizeof(draw_cache_t));
+        LV_ASSERT_MALLOC(c);
+        if(c == NULL) return NULL;
+        lv_memset_00(c, sizeof(draw_cache_t));
+        uint32_t t;
+        for(t = 0; t < _LV_DRAW_CACHE_TYPE_NUM; t++) c->gen[t] = __atomic_load_n(&type_gen[t], __ATOMIC_RELAXED);
+        LV_GC_DRAW_ROOT(_lv_draw_cache) = c;
+    }
+
+    uint32_t t;
+    for(t = 0; t < _LV_DRAW_CACHE_TYPE_NUM; t++) {
+        uint32_t gen = __atomic_load_n(&type_gen[t], __ATOMIC_RELAXED);
+        if(c->gen[t] == gen) continue;
+        c->gen[t] = gen;
+        cache_entry_t * e = c->head;
+        while(e) {
+            cache_entry_t * next = e->next;
+            if(e->type == t) entry_drop(c, e);
+            e = next;
+        }
+    }
+
+    /*The budget got smaller*/
+    uint32_t cap = __atomic_load_n(&cache_size, __ATOMIC_RELAXED) / THREAD_NUM;
+    if(c->bytes > cap) make_room(c, 0, cap);
+    return c;
+}
+
+/*Evict until `charge` more bytes fit, the lowest priority first*/
+static bool make_room(draw_cache_t * c, uint32_t charge, uint32_t cap)
+{
+    while(c->bytes + charge > cap) {
+        cache_entry_t * victim = NULL;
+        cache_entry_t * e;
+        for(e = c->tail; e; e = e->prev) {
+            if(e->ref_cnt == 0 && (victim == NULL || e->prio < victim->prio)) victim = e;
+        }
+        /*Everything left is in use*/
+        if(victim == NULL) return false;
+
+        if(victim->prio > c->clock) c->clock = victim->prio;
+        c->stats[victim->type].evictions++;
+        entry_unhash(c, victim);
+        entry_free(c, victim);
+    }
+    return true;
+}
+
+static void entry_unhash(draw_cache_t * c, cache_entry_t * e)
+{
+    cache_entry_t ** p = &c->buckets[bucket_of(e->type, e->key)];
+    while(*p != e) p = &(*p)->hash_next;
+    *p = e->hash_next;
+}
+
+static void entry_free(draw_cache_t * c, cache_entry_t * e)
+{
+    list_remove(c, e);
+    c->bytes -= e->charge;
+    c->type_entries[e->type]--;
+    c->type_bytes[e->type] -= e->charge;
+    if(e->drop_cb) e->drop_cb(ENTRY_DATA(e));
+    free_cb(e);
+}
+
+/*Out of the lookups now, freed now or on its last release*/
+static void entry_drop(draw_cache_t * c, cache_entry_t * e)
+{
+    if(e->dead) return;
+    entry_unhash(c, e);
+    if(e->ref_cnt) e->dead = 1;
+    else entry_free(c, e);
+}
+
+static void list_remove(draw_cache_t * c, cache_entry_t * e)
+{
+    if(e->prev) e->prev->next = e->next;
+    else c->head = e->next;
+    if(e->next) e->next->prev = e->prev;
+    else c->tail = e->prev;
+}
+
+static void list_push(draw_cache_t * c, cache_entry_t * e)
+{
+    e->prev = NULL;
+    e->next = c->head;
+    if(e->next) e->next->prev = e;
+    else c->tail = e;
+    c->head = e;
+}
+
+static uint32_t bucket_of(lv_draw_cache_type_t type, uint32_t key)
+{
+    return ((key ^ (type * 0x9E3779B1u)) * 2654435761u) >> (32 - BUCKET_BITS);
+}
+
+static void * default_alloc(size_t size)
+{
+    return lv_mem_alloc(size);
+}
+
+#endif /*LV_USE_DRAW_CACHE*/
@@ -0,0 +1,146 @@
+/**
+ * @file lv_draw_cache.h
+ *
+ */
+
+#ifndef LV_DRAW_CACHE_H
+#define LV_DRAW_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_conf_internal.h"
+#include "../misc/lv_types.h"
+
+#if LV_USE_DRAW_CACHE
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/** The caches sharing the budget*/
+typedef enum {
+    LV_DRAW_CACHE_SHADOW,       /**< Blurred shadow corners*/
+    LV_DRAW_CACHE_GRAD,         /**< Gradient color maps*/
+    LV_DRAW_CACHE_CIRCLE,       /**< Anti-aliased quarter circles of the radius masks*/
+    LV_DRAW_CACHE_IMG,          /**< Opened (decoded) images*/
+    _LV_DRAW_CACHE_TYPE_NUM,
+} lv_draw_cache_type_t;
+
+typedef void * (*lv_draw_cache_alloc_cb_t)(size_t size);
+typedef void (*lv_draw_cache_free_cb_t)(void * p);
+
+/** Called with an entry's data before the entry is freed, to free what it holds*/
+typedef void (*lv_draw_cache_drop_cb_t)(void * data);
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;            /**< Entries made (added)*/
+    uint32_t rejects;           /**< Entries that didn't fit, made for one use*/
+    uint32_t evictions;         /**< Entries dropped to make room*/
+    uint32_t entries;           /**< Entries now*/
+    uint32_t bytes;             /**< Bytes charged now, what the entries hold included*/
+} lv_draw_cache_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Set where the entries are allocated, by default `lv_mem_alloc`.
+ * Call it before the first draw.
+ * @param alloc_cb  allocate an entry
+ * @param free_cb   free what `alloc_cb` gave
+ */
+void lv_draw_cache_set_alloc_cb(lv_draw_cache_alloc_cb_t alloc_cb, lv_draw_cache_free_cb_t free_cb);
+
+/**
+ * Set the budget of all the render threads together, split evenly among them.
+ * It starts with `LV_DRAW_CACHE_SIZE`; a smaller budget evicts on the next lookup, 0 turns the cache off.
+ * @param size      bytes
+ */
+void lv_draw_cache_set_size(uint32_t size);
+
+/**
+ * Drop every entry of a type, of every render thread (they see it on their next lookup).
+ * @param type      the cache to empty
+ */
+void lv_draw_cache_invalidate(lv_draw_cache_type_t type);
+
+/**
+ * Get the statistics of a type in the calling render thread's cache
+ * @param type      the cache
+ * @param stats     filled with the counters since the last reset and the current use
+ */
+void lv_draw_cache_get_stats(lv_draw_cache_type_t type, lv_draw_cache_stats_t * stats);
+
+/** Zero the counters of the calling render thread's cache*/
+void lv_draw_cache_reset_stats(void);
+
+/**
+ * Find an entry and hold it: it isn't evicted until released.
+ * Keys are hashes, compare what the entry was made from before using it.
+ * @param type      the cache
+ * @param key       the key the entry was added with
+ * @return          the entry's data or NULL
+ */
+void * _lv_draw_cache_get(lv_draw_cache_type_t type, uint32_t key);
+
+/**
+ * Add an entry, held, evicting others (the ones cheap to make again for their size first) to make room.
+ * @param type      the cache
+ * @param key       the key to find it with
+ * @param size      bytes of data to allocate in the entry
+ * @param held_size bytes the data refers to and holds, allocated by others, charged to the budget too
+ * @param cost      about the work to make the entry again, in pixels (the cost of a byte of the entry
+ *                  decides what's evicted first)
+ * @param drop_cb   called before the entry is freed, or NULL
+ * @return          the entry's data to fill, or NULL if the cache is off or it doesn't fit
+ */
+void * _lv_draw_cache_add(lv_draw_cache_type_t type, uint32_t key, uint32_t size, uint32_t held_size,
+                          uint32_t cost, lv_draw_cache_drop_cb_t drop_cb);
+
+/**
+ * Release an entry got or added
+ * @param data      the entry's data
+ */
+void _lv_draw_cache_release(void * data);
+
+/**
+ * Drop an entry of the calling thread's cache now, or when released if it's held
+ * @param data      the entry's data
+ */
+void _lv_draw_cache_drop(void * data);
+
+/**
+ * Drop the entries of a type in the calling thread's cache that `match_cb` accepts
+ * @param type      the cache
+ * @param match_cb  called with the data of every entry of the type
+ * @param ctx       passed to `match_cb`
+ */
+void _lv_draw_cache_drop_matching(lv_draw_cache_type_t type, bool (*match_cb)(void * data, const void * ctx),
+                                  const void * ctx);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif  /*LV_USE_DRAW_CACHE*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_DRAW_CACHE_H*/
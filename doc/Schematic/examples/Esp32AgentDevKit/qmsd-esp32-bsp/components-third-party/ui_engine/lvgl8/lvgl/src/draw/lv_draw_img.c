@@ -356,9 +356,5 @@ static void show_error(lv_draw_ctx_t * draw_ctx, const lv_area_t * coords, const
 static void draw_cleanup(_lv_img_cache_entry_t * cache)
 {
     /*Automatically close images with no caching*/
-#if LV_IMG_CACHE_DEF_SIZE == 0
-    lv_img_decoder_close(&cache->dec_dsc);
-#else
-    LV_UNUSED(cache);
-#endif
+    _lv_img_cache_release(cache);
 }
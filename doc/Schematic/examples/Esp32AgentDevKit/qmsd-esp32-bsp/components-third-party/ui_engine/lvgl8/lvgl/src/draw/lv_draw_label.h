@@ -17,6 +17,7 @@ extern "C" {
 #include "../misc/lv_txt.h"
 #include "../misc/lv_color.h"
 #include "../misc/lv_style.h"
+#include "sw/lv_draw_sw_glyph_cache.h"
 
 /*********************
  *      DEFINES
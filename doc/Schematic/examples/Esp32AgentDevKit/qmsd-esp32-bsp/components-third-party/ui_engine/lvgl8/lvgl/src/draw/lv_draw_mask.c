@@ -18,6 +18,7 @@
  *********************/
 #define CIRCLE_CACHE_LIFE_MAX   1000
 #define CIRCLE_CACHE_AGING(life, r)   life = LV_MIN(life + (r < 16 ? 1 : (r >> 4)), 1000)
+#define CIRCLE_CACHE_COST       16      /*Draw cache: the work to make a circle a px of radius, in pixels*/
 
 /**********************
  *      TYPEDEFS
@@ -83,7 +84,7 @@ int16_t lv_draw_mask_add(void * param, void * custom_id)
     /*Look for a free entry*/
     uint8_t i;
     for(i = 0; i < _LV_MASK_MAX_NUM; i++) {
-        if(LV_GC_ROOT(_lv_draw_mask_list[i]).param == NULL) break;
+        if(LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).param == NULL) break;
     }
 
     if(i >= _LV_MASK_MAX_NUM) {
@@ -91,8 +92,8 @@ int16_t lv_draw_mask_add(void * param, void * custom_id)
         return LV_MASK_ID_INV;
     }
 
-    LV_GC_ROOT(_lv_draw_mask_list[i]).param = param;
-    LV_GC_ROOT(_lv_draw_mask_list[i]).custom_id = custom_id;
+    LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).param = param;
+    LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).custom_id = custom_id;
 
     return i;
 }
@@ -114,7 +115,7 @@ LV_ATTRIBUTE_FAST_MEM lv_draw_mask_res_t lv_draw_mask_apply(lv_opa_t * mask_buf,
     bool changed = false;
     _lv_draw_mask_common_dsc_t * dsc;
 
-    _lv_draw_mask_saved_t * m = LV_GC_ROOT(_lv_draw_mask_list);
+    _lv_draw_mask_saved_t * m = LV_GC_DRAW_ROOT(_lv_draw_mask_list);
 
     while(m->param) {
         dsc = m->param;
@@ -151,7 +152,7 @@ LV_ATTRIBUTE_FAST_MEM lv_draw_mask_res_t lv_draw_mask_apply_ids(lv_opa_t * mask_
     for(int i = 0; i < ids_count; i++) {
         int16_t id = ids[i];
         if(id == LV_MASK_ID_INV) continue;
-        dsc = LV_GC_ROOT(_lv_draw_mask_list[id]).param;
+        dsc = LV_GC_DRAW_ROOT(_lv_draw_mask_list[id]).param;
         if(!dsc) continue;
         lv_draw_mask_res_t res = LV_DRAW_MASK_RES_FULL_COVER;
         res = dsc->cb(mask_buf, abs_x, abs_y, len, dsc);
@@ -173,9 +174,9 @@ void * lv_draw_mask_remove_id(int16_t id)
     _lv_draw_mask_common_dsc_t * p = NULL;
 
     if(id != LV_MASK_ID_INV) {
-        p = LV_GC_ROOT(_lv_draw_mask_list[id]).param;
-        LV_GC_ROOT(_lv_draw_mask_list[id]).param = NULL;
-        LV_GC_ROOT(_lv_draw_mask_list[id]).custom_id = NULL;
+        p = LV_GC_DRAW_ROOT(_lv_draw_mask_list[id]).param;
+        LV_GC_DRAW_ROOT(_lv_draw_mask_list[id]).param = NULL;
+        LV_GC_DRAW_ROOT(_lv_draw_mask_list[id]).custom_id = NULL;
     }
 
     return p;
@@ -192,8 +193,8 @@ void * lv_draw_mask_remove_custom(void * custom_id)
     _lv_draw_mask_common_dsc_t * p = NULL;
     uint8_t i;
     for(i = 0; i < _LV_MASK_MAX_NUM; i++) {
-        if(LV_GC_ROOT(_lv_draw_mask_list[i]).custom_id == custom_id) {
-            p = LV_GC_ROOT(_lv_draw_mask_list[i]).param;
+        if(LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).custom_id == custom_id) {
+            p = LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).param;
             lv_draw_mask_remove_id(i);
         }
     }
@@ -213,6 +214,10 @@ void lv_draw_mask_free_param(void * p)
     if(pdsc->type == LV_DRAW_MASK_TYPE_RADIUS) {
         lv_draw_mask_radius_param_t * radius_p = (lv_draw_mask_radius_param_t *) p;
         if(radius_p->circle) {
+#if LV_USE_DRAW_CACHE
+            if(radius_p->circle->life < 0) lv_mem_free(radius_p->circle);
+            else _lv_draw_cache_release(radius_p->circle);
+#else
             if(radius_p->circle->life < 0) {
                 lv_mem_free(radius_p->circle->cir_opa);
                 lv_mem_free(radius_p->circle);
@@ -220,6 +225,7 @@ void lv_draw_mask_free_param(void * p)
             else {
                 radius_p->circle->used_cnt--;
             }
+#endif
         }
     }
     else if(pdsc->type == LV_DRAW_MASK_TYPE_POLYGON) {
@@ -230,13 +236,15 @@ void lv_draw_mask_free_param(void * p)
 
 void _lv_draw_mask_cleanup(void)
 {
+#if LV_CIRCLE_CACHE_DEF
     uint8_t i;
     for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
-        if(LV_GC_ROOT(_lv_circle_cache[i]).buf) {
-            lv_mem_free(LV_GC_ROOT(_lv_circle_cache[i]).buf);
+        if(LV_GC_DRAW_ROOT(_lv_circle_cache[i]).buf) {
+            lv_mem_free(LV_GC_DRAW_ROOT(_lv_circle_cache[i]).buf);
         }
-        lv_memset_00(&LV_GC_ROOT(_lv_circle_cache[i]), sizeof(LV_GC_ROOT(_lv_circle_cache[i])));
+        lv_memset_00(&LV_GC_DRAW_ROOT(_lv_circle_cache[i]), sizeof(LV_GC_DRAW_ROOT(_lv_circle_cache[i])));
     }
+#endif
 }
 
 /**
@@ -248,21 +256,21 @@ LV_ATTRIBUTE_FAST_MEM uint8_t lv_draw_mask_get_cnt(void)
     uint8_t cnt = 0;
     uint8_t i;
     for(i = 0; i < _LV_MASK_MAX_NUM; i++) {
-        if(LV_GC_ROOT(_lv_draw_mask_list[i]).param) cnt++;
+        if(LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).param) cnt++;
     }
     return cnt;
 }
 
 bool lv_draw_mask_is_any(const lv_area_t * a)
 {
-    if(a == NULL) return LV_GC_ROOT(_lv_draw_mask_list[0]).param ? true : false;
+    if(a == NULL) return LV_GC_DRAW_ROOT(_lv_draw_mask_list[0]).param ? true : false;
 
     uint8_t i;
     for(i = 0; i < _LV_MASK_MAX_NUM; i++) {
-        _lv_draw_mask_common_dsc_t * comm_param = LV_GC_ROOT(_lv_draw_mask_list[i]).param;
+        _lv_draw_mask_common_dsc_t * comm_param = LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).param;
         if(comm_param == NULL) continue;
         if(comm_param->type == LV_DRAW_MASK_TYPE_RADIUS) {
-            lv_draw_mask_radius_param_t * radius_param = LV_GC_ROOT(_lv_draw_mask_list[i]).param;
+            lv_draw_mask_radius_param_t * radius_param = LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).param;
             if(radius_param->cfg.outer) {
                 if(!_lv_area_is_out(a, &radius_param->cfg.rect, radius_param->cfg.radius)) return true;
             }
@@ -490,14 +498,32 @@ void lv_draw_mask_radius_init(lv_draw_mask_radius_param_t * param, const lv_area
         return;
     }
 
+#if LV_USE_DRAW_CACHE
+    /*The quarter circle is after its descriptor, in one draw cache entry*/
+    _lv_draw_mask_radius_circle_dsc_t * entry = _lv_draw_cache_get(LV_DRAW_CACHE_CIRCLE, radius);
+    if(entry == NULL) {
+        uint32_t entry_size = sizeof(_lv_draw_mask_radius_circle_dsc_t) + radius * 6 + 6;
+        entry = _lv_draw_cache_add(LV_DRAW_CACHE_CIRCLE, radius, entry_size, 0, radius * CIRCLE_CACHE_COST, NULL);
+        int32_t life = 0;
+        if(entry == NULL) {
+            entry = lv_mem_alloc(entry_size);
+            LV_ASSERT_MALLOC(entry);
+            life = -1;
+        }
+        lv_memset_00(entry, sizeof(_lv_draw_mask_radius_circle_dsc_t));
+        entry->life = life;
+        circ_calc_aa4(entry, radius);
+    }
+    param->circle = entry;
+#else
     uint32_t i;
 
     /*Try to reuse a circle cache entry*/
     for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
-        if(LV_GC_ROOT(_lv_circle_cache[i]).radius == radius) {
-            LV_GC_ROOT(_lv_circle_cache[i]).used_cnt++;
-            CIRCLE_CACHE_AGING(LV_GC_ROOT(_lv_circle_cache[i]).life, radius);
-            param->circle = &LV_GC_ROOT(_lv_circle_cache[i]);
+        if(LV_GC_DRAW_ROOT(_lv_circle_cache[i]).radius == radius) {
+            LV_GC_DRAW_ROOT(_lv_circle_cache[i]).used_cnt++;
+            CIRCLE_CACHE_AGING(LV_GC_DRAW_ROOT(_lv_circle_cache[i]).life, radius);
+            param->circle = &LV_GC_DRAW_ROOT(_lv_circle_cache[i]);
             return;
         }
     }
@@ -505,9 +531,9 @@ void lv_draw_mask_radius_init(lv_draw_mask_radius_param_t * param, const lv_area
     /*If not found find a free entry with lowest life*/
     _lv_draw_mask_radius_circle_dsc_t * entry = NULL;
     for(i = 0; i < LV_CIRCLE_CACHE_SIZE; i++) {
-        if(LV_GC_ROOT(_lv_circle_cache[i]).used_cnt == 0) {
-            if(!entry) entry = &LV_GC_ROOT(_lv_circle_cache[i]);
-            else if(LV_GC_ROOT(_lv_circle_cache[i]).life < entry->life) entry = &LV_GC_ROOT(_lv_circle_cache[i]);
+        if(LV_GC_DRAW_ROOT(_lv_circle_cache[i]).used_cnt == 0) {
+            if(!entry) entry = &LV_GC_DRAW_ROOT(_lv_circle_cache[i]);
+            else if(LV_GC_DRAW_ROOT(_lv_circle_cache[i]).life < entry->life) entry = &LV_GC_DRAW_ROOT(_lv_circle_cache[i]);
         }
     }
 
@@ -526,6 +552,7 @@ void lv_draw_mask_radius_init(lv_draw_mask_radius_param_t * param, const lv_area
     param->circle = entry;
 
     circ_calc_aa4(param->circle, radius);
+#endif
 }
 
 /**
@@ -1367,10 +1394,15 @@ static void circ_calc_aa4(_lv_draw_mask_radius_circle_dsc_t * c, lv_coord_t radi
     c->radius = radius;
 
     /*Allocate buffers*/
+#if LV_USE_DRAW_CACHE
+    /*Right after the descriptor*/
+    c->buf = (uint8_t *)(c + 1);
+#else
     if(c->buf) lv_mem_free(c->buf);
 
     c->buf = lv_mem_alloc(radius * 6 + 6);  /*Use uint16_t for opa_start_on_y and x_start_on_y*/
     LV_ASSERT_MALLOC(c->buf);
+#endif
     c->cir_opa = c->buf;
     c->opa_start_on_y = (uint16_t *)(c->buf + 2 * radius + 2);
     c->x_start_on_y = (uint16_t *)(c->buf + 4 * radius + 4);
@@ -12,6 +12,7 @@
 #include "lv_draw_img.h"
 #include "../hal/lv_hal_tick.h"
 #include "../misc/lv_gc.h"
+#include "lv_draw_cache.h"
 
 /*********************
  *      DEFINES
@@ -26,6 +27,9 @@
  * "die" from very high values*/
 #define LV_IMG_CACHE_LIFE_LIMIT 1000
 
+/*Draw cache: the cost of an image a millisecond it took to open, in pixels drawn meanwhile*/
+#define LV_IMG_CACHE_COST_MS    100000
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -33,15 +37,33 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-#if LV_IMG_CACHE_DEF_SIZE
+#if LV_IMG_CACHE_DEF
+    static bool lv_img_cache_match(const void * src1, const void * src2);
+    static void cache_resize(uint16_t new_entry_cnt);
+    static void cache_invalidate(const void * src);
+#if LV_USE_REFR_PARALLEL
+    static void cache_sync(void);
+#endif
+#endif
+#if LV_USE_DRAW_CACHE
+    static _lv_img_cache_entry_t * draw_cache_open(const void * src, lv_color_t color, int32_t frame_id);
+    static bool draw_cache_match(void * data, const void * src);
+    static void draw_cache_drop(void * data);
     static bool lv_img_cache_match(const void * src1, const void * src2);
 #endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
-#if LV_IMG_CACHE_DEF_SIZE
-    static uint16_t entry_cnt;
+#if LV_IMG_CACHE_DEF
+    static LV_DRAW_LOCAL uint16_t entry_cnt;
+#if LV_USE_REFR_PARALLEL
+    /*Every render thread has its own cache. The API changes the shared size and generation,
+     *a thread brings its cache in line on its next open*/
+    static uint16_t shared_entry_cnt;
+    static uint32_t shared_gen = 1;
+    static LV_DRAW_LOCAL uint32_t local_gen;
+#endif
 #endif
 
 /**********************
@@ -65,13 +87,16 @@ _lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color, i
     /*Is the image cached?*/
     _lv_img_cache_entry_t * cached_src = NULL;
 
-#if LV_IMG_CACHE_DEF_SIZE
+#if LV_IMG_CACHE_DEF
+#if LV_USE_REFR_PARALLEL
+    cache_sync();
+#endif
     if(entry_cnt == 0) {
         LV_LOG_WARN("lv_img_cache_open: the cache size is 0");
         return NULL;
     }
 
-    _lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+    _lv_img_cache_entry_t * cache = LV_GC_DRAW_ROOT(_lv_img_cache_array);
 
     /*Decrement all lifes. Make the entries older*/
     uint16_t i;
@@ -115,8 +140,10 @@ _lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color, i
     else {
         LV_LOG_INFO("image draw: cache miss, cached to an empty entry");
     }
+#elif LV_USE_DRAW_CACHE
+    return draw_cache_open(src, color, frame_id);
 #else
-    cached_src = &LV_GC_ROOT(_lv_img_cache_single);
+    cached_src = &LV_GC_DRAW_ROOT(_lv_img_cache_single);
 #endif
     /*Open the image and measure the time to open*/
     uint32_t t_start  = lv_tick_get();
@@ -148,40 +175,110 @@ _lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color, i
  */
 void lv_img_cache_set_size(uint16_t new_entry_cnt)
 {
-#if LV_IMG_CACHE_DEF_SIZE == 0
+#if LV_USE_DRAW_CACHE
+    LV_UNUSED(new_entry_cnt);
+    LV_LOG_WARN("The images are in the draw cache, see `lv_draw_cache_set_size()`");
+#elif LV_IMG_CACHE_DEF_SIZE == 0
     LV_UNUSED(new_entry_cnt);
     LV_LOG_WARN("Can't change cache size because it's disabled by LV_IMG_CACHE_DEF_SIZE = 0");
 #else
-    if(LV_GC_ROOT(_lv_img_cache_array) != NULL) {
+    cache_resize(new_entry_cnt);
+#if LV_USE_REFR_PARALLEL
+    shared_entry_cnt = entry_cnt;
+    shared_gen++;
+    local_gen = shared_gen;
+#endif
+#endif
+}
+
+/**
+ * Invalidate an image source in the cache.
+ * Useful if the image source is updated therefore it needs to be cached again.
+ * @param src an image source path to a file or pointer to an `lv_img_dsc_t` variable.
+ */
+void lv_img_cache_invalidate_src(const void * src)
+{
+    LV_UNUSED(src);
+#if LV_USE_DRAW_CACHE
+#if LV_USE_REFR_PARALLEL
+    /*The other render threads don't know `src`, they drop their images*/
+    lv_draw_cache_invalidate(LV_DRAW_CACHE_IMG);
+#else
+    _lv_draw_cache_drop_matching(LV_DRAW_CACHE_IMG, draw_cache_match, src);
+#endif
+#endif
+#if LV_IMG_CACHE_DEF
+#if LV_USE_REFR_PARALLEL
+    cache_sync();
+    /*The other render threads don't know `src`, they drop their whole cache*/
+    shared_gen++;
+    local_gen = shared_gen;
+#endif
+    cache_invalidate(src);
+#endif
+}
+
+/**
+ * Invalidate an image source in the cache of the calling thread only.
+ * For the sources a render thread creates and drops while drawing.
+ * @param src an image source path to a file or pointer to an `lv_img_dsc_t` variable.
+ */
+void _lv_img_cache_invalidate_local(const void * src)
+{
+    LV_UNUSED(src);
+#if LV_USE_DRAW_CACHE
+    _lv_draw_cache_drop_matching(LV_DRAW_CACHE_IMG, draw_cache_match, src);
+#elif LV_IMG_CACHE_DEF
+    cache_invalidate(src);
+#endif
+}
+
+/**
+ * Done with an image opened by `_lv_img_cache_open()`.
+ * Closes the images not cached, lets the draw cache evict the others again.
+ * @param entry the entry `_lv_img_cache_open()` gave
+ */
+void _lv_img_cache_release(_lv_img_cache_entry_t * entry)
+{
+#if LV_IMG_CACHE_DEF
+    LV_UNUSED(entry);
+#else
+    if(entry == &LV_GC_DRAW_ROOT(_lv_img_cache_single)) lv_img_decoder_close(&entry->dec_dsc);
+#if LV_USE_DRAW_CACHE
+    else _lv_draw_cache_release(entry);
+#endif
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if LV_IMG_CACHE_DEF
+static void cache_resize(uint16_t new_entry_cnt)
+{
+    if(LV_GC_DRAW_ROOT(_lv_img_cache_array) != NULL) {
         /*Clean the cache before free it*/
-        lv_img_cache_invalidate_src(NULL);
-        lv_mem_free(LV_GC_ROOT(_lv_img_cache_array));
+        cache_invalidate(NULL);
+        lv_mem_free(LV_GC_DRAW_ROOT(_lv_img_cache_array));
     }
 
     /*Reallocate the cache*/
-    LV_GC_ROOT(_lv_img_cache_array) = lv_mem_alloc(sizeof(_lv_img_cache_entry_t) * new_entry_cnt);
-    LV_ASSERT_MALLOC(LV_GC_ROOT(_lv_img_cache_array));
-    if(LV_GC_ROOT(_lv_img_cache_array) == NULL) {
+    LV_GC_DRAW_ROOT(_lv_img_cache_array) = lv_mem_alloc(sizeof(_lv_img_cache_entry_t) * new_entry_cnt);
+    LV_ASSERT_MALLOC(LV_GC_DRAW_ROOT(_lv_img_cache_array));
+    if(LV_GC_DRAW_ROOT(_lv_img_cache_array) == NULL) {
         entry_cnt = 0;
         return;
     }
     entry_cnt = new_entry_cnt;
 
     /*Clean the cache*/
-    lv_memset_00(LV_GC_ROOT(_lv_img_cache_array), entry_cnt * sizeof(_lv_img_cache_entry_t));
-#endif
+    lv_memset_00(LV_GC_DRAW_ROOT(_lv_img_cache_array), entry_cnt * sizeof(_lv_img_cache_entry_t));
 }
 
-/**
- * Invalidate an image source in the cache.
- * Useful if the image source is updated therefore it needs to be cached again.
- * @param src an image source path to a file or pointer to an `lv_img_dsc_t` variable.
- */
-void lv_img_cache_invalidate_src(const void * src)
+static void cache_invalidate(const void * src)
 {
-    LV_UNUSED(src);
-#if LV_IMG_CACHE_DEF_SIZE
-    _lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+    _lv_img_cache_entry_t * cache = LV_GC_DRAW_ROOT(_lv_img_cache_array);
 
     uint16_t i;
     for(i = 0; i < entry_cnt; i++) {
@@ -193,14 +290,91 @@ void lv_img_cache_invalidate_src(const void * src)
             lv_memset_00(&cache[i], sizeof(_lv_img_cache_entry_t));
         }
     }
+}
+
+#if LV_USE_REFR_PARALLEL
+static void cache_sync(void)
+{
+    if(local_gen == shared_gen) return;
+    local_gen = shared_gen;
+    if(entry_cnt != shared_entry_cnt) cache_resize(shared_entry_cnt);
+    else cache_invalidate(NULL);
+}
 #endif
+
+#endif
+
+#if LV_USE_DRAW_CACHE
+static _lv_img_cache_entry_t * draw_cache_open(const void * src, lv_color_t color, int32_t frame_id)
+{
+    /*Hash the source, its path for files*/
+    uint32_t key = 2166136261u;
+    if(lv_img_src_get_type(src) == LV_IMG_SRC_FILE) {
+        const char * p;
+        for(p = src; *p; p++) key = (key ^ (uint8_t)*p) * 16777619u;
+    }
+    else {
+        key ^= (uint32_t)(uintptr_t)src;
+    }
+    key = (key ^ color.full) * 16777619u;
+    key = (key ^ (uint32_t)frame_id) * 16777619u;
+
+    _lv_img_cache_entry_t * entry = _lv_draw_cache_get(LV_DRAW_CACHE_IMG, key);
+    if(entry) {
+        if(color.full == entry->dec_dsc.color.full && frame_id == entry->dec_dsc.frame_id &&
+           lv_img_cache_match(src, entry->dec_dsc.src)) {
+            LV_LOG_TRACE("image source found in the cache");
+            return entry;
+        }
+        /*Another image with the same key*/
+        _lv_draw_cache_release(entry);
+        _lv_draw_cache_drop(entry);
+    }
+
+    /*Open the image and measure the time to open*/
+    lv_img_decoder_dsc_t dec_dsc;
+    uint32_t t_start  = lv_tick_get();
+    if(lv_img_decoder_open(&dec_dsc, src, color, frame_id) == LV_RES_INV) {
+        LV_LOG_WARN("Image draw cannot open the image resource");
+        return NULL;
+    }
+    if(dec_dsc.time_to_open == 0) dec_dsc.time_to_open = lv_tick_elaps(t_start);
+    if(dec_dsc.time_to_open == 0) dec_dsc.time_to_open = 1;
+
+    /*Charge the decoded pixels too, unless they are the variable's own*/
+    uint32_t held_size = 0;
+    if(dec_dsc.img_data && !(lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE &&
+                             dec_dsc.img_data == ((const lv_img_dsc_t *)src)->data)) {
+        held_size = lv_img_buf_get_img_size(dec_dsc.header.w, dec_dsc.header.h, dec_dsc.header.cf);
+    }
+    uint32_t cost = dec_dsc.time_to_open * LV_IMG_CACHE_COST_MS + (uint32_t)dec_dsc.header.w * dec_dsc.header.h;
+
+    entry = _lv_draw_cache_add(LV_DRAW_CACHE_IMG, key, sizeof(_lv_img_cache_entry_t), held_size, cost,
+                               draw_cache_drop);
+    if(entry == NULL) {
+        /*It doesn't fit, `_lv_img_cache_release()` closes it after this draw*/
+        LV_LOG_INFO("image draw: doesn't fit the draw cache, opened for one draw");
+        entry = &LV_GC_DRAW_ROOT(_lv_img_cache_single);
+    }
+    entry->dec_dsc = dec_dsc;
+    entry->life = 0;
+    return entry;
 }
 
-/**********************
- *   STATIC FUNCTIONS
- **********************/
+static bool draw_cache_match(void * data, const void * src)
+{
+    _lv_img_cache_entry_t * entry = data;
+    return src == NULL || lv_img_cache_match(src, entry->dec_dsc.src);
+}
+
+static void draw_cache_drop(void * data)
+{
+    _lv_img_cache_entry_t * entry = data;
+    lv_img_decoder_close(&entry->dec_dsc);
+}
+#endif
 
-#if LV_IMG_CACHE_DEF_SIZE
+#if LV_IMG_CACHE_DEF || LV_USE_DRAW_CACHE
 static bool lv_img_cache_match(const void * src1, const void * src2)
 {
     lv_img_src_t src_type = lv_img_src_get_type(src1);
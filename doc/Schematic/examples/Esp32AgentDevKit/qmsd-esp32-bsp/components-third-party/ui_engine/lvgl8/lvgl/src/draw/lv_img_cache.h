@@ -67,6 +67,20 @@ void lv_img_cache_set_size(uint16_t new_slot_num);
  */
 void lv_img_cache_invalidate_src(const void * src);
 
+/**
+ * Invalidate an image source in the cache of the calling thread only.
+ * For the sources a render thread creates and drops while drawing.
+ * @param src an image source path to a file or pointer to an `lv_img_dsc_t` variable.
+ */
+void _lv_img_cache_invalidate_local(const void * src);
+
+/**
+ * Done with an image opened by `_lv_img_cache_open()`.
+ * Closes the images not cached, lets the draw cache evict the others again.
+ * @param entry the entry `_lv_img_cache_open()` gave
+ */
+void _lv_img_cache_release(_lv_img_cache_entry_t * entry);
+
 /**********************
  *      MACROS
  **********************/
@@ -205,9 +205,7 @@ bool lv_draw_sdl_img_load_texture(lv_draw_sdl_ctx_t * ctx, lv_draw_sdl_cache_key
         else {
             *texture = upload_img_texture(ctx->renderer, dsc);
         }
-#if LV_IMG_CACHE_DEF_SIZE == 0
-        lv_img_decoder_close(dsc);
-#endif
+        _lv_img_cache_release(cdsc);
     }
     if(texture && cdsc) {
         *header = SDL_malloc(sizeof(lv_draw_sdl_img_header_t));
@@ -280,7 +278,7 @@ static bool check_mask_simple_radius(const lv_area_t * coords, lv_coord_t * radi
 {
     if(lv_draw_mask_get_cnt() != 1) return false;
     for(uint8_t i = 0; i < _LV_MASK_MAX_NUM; i++) {
-        _lv_draw_mask_common_dsc_t * param = LV_GC_ROOT(_lv_draw_mask_list[i]).param;
+        _lv_draw_mask_common_dsc_t * param = LV_GC_DRAW_ROOT(_lv_draw_mask_list[i]).param;
         if(param->type == LV_DRAW_MASK_TYPE_RADIUS) {
             lv_draw_mask_radius_param_t * rparam = (lv_draw_mask_radius_param_t *) param;
             if(rparam->cfg.outer) return false;
@@ -78,6 +78,11 @@ void lv_draw_sw_transform(lv_draw_ctx_t * draw_ctx, const lv_area_t * dest_area,
                           lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
                           const lv_draw_img_dsc_t * draw_dsc, lv_img_cf_t cf, lv_color_t * cbuf, lv_opa_t * abuf);
 
+/*Transform pixel by pixel, what the kernels of `lv_draw_sw_transform` must match*/
+void lv_draw_sw_transform_basic(lv_draw_ctx_t * draw_ctx, const lv_area_t * dest_area, const void * src_buf,
+                                lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
+                                const lv_draw_img_dsc_t * draw_dsc, lv_img_cf_t cf, lv_color_t * cbuf, lv_opa_t * abuf);
+
 struct _lv_draw_layer_ctx_t * lv_draw_sw_layer_create(struct _lv_draw_ctx_t * draw_ctx, lv_draw_layer_ctx_t * layer_ctx,
                                                       lv_draw_layer_flags_t flags);
 
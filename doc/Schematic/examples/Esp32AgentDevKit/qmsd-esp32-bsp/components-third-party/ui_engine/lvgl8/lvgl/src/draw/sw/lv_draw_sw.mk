@@ -2,6 +2,7 @@ CSRCS += lv_draw_sw.c
 CSRCS += lv_draw_sw_arc.c
 CSRCS += lv_draw_sw_blend.c
 CSRCS += lv_draw_sw_dither.c
+CSRCS += lv_draw_sw_glyph_cache.c
 CSRCS += lv_draw_sw_gradient.c
 CSRCS += lv_draw_sw_img.c
 CSRCS += lv_draw_sw_letter.c
@@ -0,0 +1,535 @@
+/**
+ * @file lv_draw_sw_glyph_cache.c
+ *
+ * Glyphs expanded to A8 coverage masks, keyed by (font, letter, bpp).
+ * A tier is cut into pages, a page into the slots of one size class. When a
+ * class has no free slot and no page is left, its least recently used glyph
+ * makes room, or if it has none, the page of another class's least recently
+ * used glyph is emptied and given over. Every cached glyph is in the main
+ * tier; the ones hit again also get a copy in the (small, fast) hot tier if
+ * they fit its smaller pages, which is what the blend then reads.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_draw_sw_glyph_cache.h"
+#if LV_USE_GLYPH_CACHE
+
+#include "../../misc/lv_gc.h"
+#include "../../misc/lv_mem.h"
+#include "../../misc/lv_assert.h"
+#include "../../misc/lv_log.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define CLASS_CNT       14
+#define PROMOTE_HITS    2       /*A glyph is copied into the hot tier on its second hit*/
+#define BUCKET_BYTES    512     /*Main tier bytes a hash bucket, about two glyphs of a 16 px font*/
+#define FAST_PAGE_SIZE  1024    /*Small pages, so the classes in use share a small hot tier*/
+
+#if LV_GLYPH_CACHE_SIZE != 0 && LV_GLYPH_CACHE_SIZE < LV_GLYPH_CACHE_PAGE_SIZE
+    #error "LV_GLYPH_CACHE_SIZE is smaller than a page"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct _glyph_entry_t {
+    struct _glyph_entry_t * prev;       /*LRU list of the class, the most recent first*/
+    struct _glyph_entry_t * next;       /*Also the free list of the class*/
+    struct _glyph_entry_t * hash_next;  /*Main tier only*/
+    struct _glyph_entry_t * twin;       /*Main tier: the hot copy, hot tier: the main entry*/
+    const lv_font_t * font;
+    uint32_t letter;
+    uint16_t w;
+    uint16_t h;
+    uint8_t bpp;
+    uint8_t cls;
+    uint8_t hits;
+} glyph_entry_t;
+
+typedef struct {
+    uint8_t * mem;
+    uint32_t size;
+    uint32_t page_size;
+    uint32_t page_cnt;
+    uint32_t page_used;
+    uint32_t entries;
+    uint32_t bytes;
+    uint16_t class_pages[CLASS_CNT];
+    glyph_entry_t * free[CLASS_CNT];
+    glyph_entry_t * lru_head[CLASS_CNT];
+    glyph_entry_t * lru_tail[CLASS_CNT];
+} glyph_tier_t;
+
+typedef struct {
+    glyph_tier_t main;
+    glyph_tier_t fast;
+    glyph_entry_t ** buckets;
+    uint32_t bucket_mask;
+    uint32_t gen;
+    lv_glyph_cache_stats_t stats;
+} glyph_cache_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static glyph_cache_t * cache_get(void);
+static void cache_clear(glyph_cache_t * c);
+static bool tier_init(glyph_tier_t * tier, uint32_t size, uint32_t page_size, lv_glyph_cache_mem_t mem);
+static glyph_entry_t * slot_alloc(glyph_cache_t * c, glyph_tier_t * tier, uint8_t cls);
+static void slot_free(glyph_tier_t * tier, glyph_entry_t * e);
+static void slot_evict(glyph_cache_t * c, glyph_tier_t * tier, glyph_entry_t * e);
+static void page_carve(glyph_tier_t * tier, uint8_t * page, uint8_t cls);
+static bool page_steal(glyph_cache_t * c, glyph_tier_t * tier, uint8_t cls);
+static void entry_drop(glyph_cache_t * c, glyph_entry_t * e);
+static void lru_remove(glyph_tier_t * tier, glyph_entry_t * e);
+static void lru_push(glyph_tier_t * tier, glyph_entry_t * e);
+static glyph_entry_t * promote(glyph_cache_t * c, glyph_entry_t * e);
+static void expand(const uint8_t * map_p, lv_opa_t * a8, uint32_t w, uint32_t h, uint32_t bpp);
+static uint32_t hash(const lv_font_t * font, uint32_t letter, uint32_t mask);
+static void * default_alloc(size_t size, lv_glyph_cache_mem_t mem);
+static void default_free(void * p, lv_glyph_cache_mem_t mem);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+/*Slot sizes, steps of 1.5x so no more than a third of a slot is lost*/
+static const uint16_t class_size[CLASS_CNT] = {48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096};
+
+/*Shared by the render threads*/
+static lv_glyph_cache_alloc_cb_t alloc_cb = default_alloc;
+static lv_glyph_cache_free_cb_t free_cb = default_free;
+static uint32_t cache_gen;
+
+/*The sizes the calling thread's cache is created with on its next letter*/
+static LV_DRAW_LOCAL bool inited;
+static LV_DRAW_LOCAL uint32_t cache_size = LV_GLYPH_CACHE_SIZE;
+static LV_DRAW_LOCAL uint32_t cache_fast_size = LV_GLYPH_CACHE_FAST_SIZE;
+
+extern const uint8_t _lv_bpp1_opa_table[2];
+extern const uint8_t _lv_bpp2_opa_table[4];
+extern const uint8_t _lv_bpp4_opa_table[16];
+
+/**********************
+ *      MACROS
+ **********************/
+#define ENTRY_DATA(e) ((lv_opa_t *)((glyph_entry_t *)(e) + 1))
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_draw_sw_glyph_cache_set_alloc_cb(lv_glyph_cache_alloc_cb_t new_alloc_cb, lv_glyph_cache_free_cb_t new_free_cb)
+{
+    alloc_cb = new_alloc_cb ? new_alloc_cb : default_alloc;
+    free_cb = new_free_cb ? new_free_cb : default_free;
+}
+
+void lv_draw_sw_glyph_cache_set_size(uint32_t size, uint32_t fast_size)
+{
+    glyph_cache_t * c = LV_GC_DRAW_ROOT(_lv_glyph_cache);
+    if(c) {
+        if(c->main.mem) free_cb(c->main.mem, LV_GLYPH_CACHE_MEM_MAIN);
+        if(c->fast.mem) free_cb(c->fast.mem, LV_GLYPH_CACHE_MEM_FAST);
+        lv_mem_free(c->buckets);
+        lv_mem_free(c);
+        LV_GC_DRAW_ROOT(_lv_glyph_cache) = NULL;
+    }
+    inited = false;
+    cache_size = size;
+    cache_fast_size = fast_size;
+}
+
+void lv_draw_sw_glyph_cache_invalidate(void)
+{
+    __atomic_add_fetch(&cache_gen, 1, __ATOMIC_RELAXED);
+}
+
+void lv_draw_sw_glyph_cache_get_stats(lv_glyph_cache_stats_t * stats)
+{
+    lv_memset_00(stats, sizeof(lv_glyph_cache_stats_t));
+    glyph_cache_t * c = LV_GC_DRAW_ROOT(_lv_glyph_cache);
+    if(c == NULL) return;
+
+    *stats = c->stats;
+    stats->entries = c->main.entries;
+    stats->fast_entries = c->fast.entries;
+    stats->bytes = c->main.bytes;
+    stats->fast_bytes = c->fast.bytes;
+    stats->size = c->main.size;
+    stats->fast_size = c->fast.size;
+}
+
+void lv_draw_sw_glyph_cache_reset_stats(void)
+{
+    glyph_cache_t * c = LV_GC_DRAW_ROOT(_lv_glyph_cache);
+    if(c) lv_memset_00(&c->stats, sizeof(c->stats));
+}
+
+const lv_opa_t * _lv_draw_sw_glyph_cache_get(const lv_font_glyph_dsc_t * g, uint32_t letter)
+{
+#if LV_USE_IMGFONT
+    if(g->bpp == LV_IMGFONT_BPP) return NULL;
+#endif
+    glyph_cache_t * c = cache_get();
+    if(c == NULL) return NULL;
+
+    const lv_font_t * font = g->resolved_font;
+    glyph_entry_t ** bucket = &c->buckets[hash(font, letter, c->bucket_mask)];
+    glyph_entry_t * e;
+    for(e = *bucket; e; e = e->hash_next) {
+        if(e->letter == letter && e->font == font && e->bpp == g->bpp) break;
+    }
+
+    if(e) {
+        /*A font changed without an invalidate, don't trust the mask*/
+        if(e->w != g->box_w || e->h != g->box_h) {
+            entry_drop(c, e);
+        }
+        else {
+            c->stats.hits++;
+            lru_remove(&c->main, e);
+            lru_push(&c->main, e);
+            if(e->twin) {
+                c->stats.fast_hits++;
+                e->twin->hits = 1;
+                lru_remove(&c->fast, e->twin);
+                lru_push(&c->fast, e->twin);
+                return ENTRY_DATA(e->twin);
+            }
+            if(e->hits < PROMOTE_HITS) e->hits++;
+            if(c->fast.page_cnt && e->hits >= PROMOTE_HITS) {
+                glyph_entry_t * hot = promote(c, e);
+                if(hot) return ENTRY_DATA(hot);
+            }
+            return ENTRY_DATA(e);
+        }
+    }
+
+    uint32_t slot_size = sizeof(glyph_entry_t) + (uint32_t)g->box_w * g->box_h;
+    if(slot_size > LV_GLYPH_CACHE_PAGE_SIZE) {
+        c->stats.uncached++;
+        return NULL;
+    }
+
+    const uint8_t * map_p = lv_font_get_glyph_bitmap(font, letter);
+    if(map_p == NULL) {
+        c->stats.uncached++;
+        return NULL;
+    }
+
+    uint8_t cls = 0;
+    while(class_size[cls] < slot_size) cls++;
+    e = slot_alloc(c, &c->main, cls);
+    if(e == NULL) {
+        c->stats.uncached++;
+        return NULL;
+    }
+
+    e->font = font;
+    e->letter = letter;
+    e->w = g->box_w;
+    e->h = g->box_h;
+    e->bpp = g->bpp;
+    e->hits = 0;
+    e->twin = NULL;
+    expand(map_p, ENTRY_DATA(e), e->w, e->h, e->bpp == 3 ? 4 : e->bpp);
+
+    e->hash_next = *bucket;
+    *bucket = e;
+    lru_push(&c->main, e);
+    c->stats.misses++;
+    return ENTRY_DATA(e);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/*The calling thread's cache, created on first use, emptied when invalidated*/
+static glyph_cache_t * cache_get(void)
+{
+    if(!inited) {
+        inited = true;
+        if(cache_size >= LV_GLYPH_CACHE_PAGE_SIZE) {
+            glyph_cache_t * c = lv_mem_alloc(sizeof(glyph_cache_t));
+            LV_ASSERT_MALLOC(c);
+            if(c == NULL) return NULL;
+            lv_memset_00(c, sizeof(glyph_cache_t));
+
+            uint32_t bucket_cnt = 64;
+            while(bucket_cnt * BUCKET_BYTES < cache_size) bucket_cnt <<= 1;
+            c->buckets = lv_mem_alloc(bucket_cnt * sizeof(glyph_entry_t *));
+            LV_ASSERT_MALLOC(c->buckets);
+            if(c->buckets == NULL || !tier_init(&c->main, cache_size, LV_GLYPH_CACHE_PAGE_SIZE, LV_GLYPH_CACHE_MEM_MAIN)) {
+                LV_LOG_WARN("glyph cache: couldn't allocate %" LV_PRIu32 " bytes", cache_size);
+                lv_mem_free(c->buckets);
+                lv_mem_free(c);
+                return NULL;
+            }
+            c->bucket_mask = bucket_cnt - 1;
+            lv_memset_00(c->buckets, bucket_cnt * sizeof(glyph_entry_t *));
+            /*The hot tier is optional, without it the main tier is read*/
+            if(cache_fast_size >= FAST_PAGE_SIZE) tier_init(&c->fast, cache_fast_size, FAST_PAGE_SIZE, LV_GLYPH_CACHE_MEM_FAST);
+            c->gen = __atomic_load_n(&cache_gen, __ATOMIC_RELAXED);
+            LV_GC_DRAW_ROOT(_lv_glyph_cache) = c;
+        }
+    }
+
+    glyph_cache_t * c = LV_GC_DRAW_ROOT(_lv_glyph_cache);
+    if(c == NULL) return NULL;
+
+    uint32_t gen = __atomic_load_n(&cache_gen, __ATOMIC_RELAXED);
+    if(c->gen != gen) {
+        cache_clear(c);
+        c->gen = gen;
+    }
+    return c;
+}
+
+/*Hand every page back, the pages are given out to the classes again*/
+static void cache_clear(glyph_cache_t * c)
+{
+    glyph_tier_t * tiers[2] = {&c->main, &c->fast};
+    uint32_t i;
+    for(i = 0; i < 2; i++) {
+        glyph_tier_t * tier = tiers[i];
+        tier->page_used = 0;
+        tier->entries = 0;
+        tier->bytes = 0;
+        lv_memset_00(tier->class_pages, sizeof(tier->class_pages));
+        lv_memset_00(tier->free, sizeof(tier->free));
+        lv_memset_00(tier->lru_head, sizeof(tier->lru_head));
+        lv_memset_00(tier->lru_tail, sizeof(tier->lru_tail));
+    }
+    lv_memset_00(c->buckets, (c->bucket_mask + 1) * sizeof(glyph_entry_t *));
+}
+
+static bool tier_init(glyph_tier_t * tier, uint32_t size, uint32_t page_size, lv_glyph_cache_mem_t mem)
+{
+    size -= size % page_size;
+    tier->mem = alloc_cb(size, mem);
+    if(tier->mem == NULL) return false;
+    tier->size = size;
+    tier->page_size = page_size;
+    tier->page_cnt = size / page_size;
+    return true;
+}
+
+/*A free slot of the class: from its free list, a new page, its least recently used glyph
+ *or a page of another class. The caller sets `font`, which marks the slot used.*/
+static glyph_entry_t * slot_alloc(glyph_cache_t * c, glyph_tier_t * tier, uint8_t cls)
+{
+    if(tier->free[cls] == NULL && tier->page_used < tier->page_cnt) {
+        page_carve(tier, tier->mem + tier->page_used * tier->page_size, cls);
+        tier->page_used++;
+    }
+
+    if(tier->free[cls] == NULL) {
+        if(tier->lru_tail[cls]) slot_evict(c, tier, tier->lru_tail[cls]);
+        else if(!page_steal(c, tier, cls)) return NULL;
+    }
+
+    glyph_entry_t * e = tier->free[cls];
+    tier->free[cls] = e->next;
+    tier->entries++;
+    tier->bytes += class_size[cls];
+    return e;
+}
+
+static void slot_free(glyph_tier_t * tier, glyph_entry_t * e)
+{
+    e->font = NULL;
+    e->next = tier->free[e->cls];
+    tier->free[e->cls] = e;
+    tier->entries--;
+    tier->bytes -= class_size[e->cls];
+}
+
+static void slot_evict(glyph_cache_t * c, glyph_tier_t * tier, glyph_entry_t * e)
+{
+    if(tier == &c->main) {
+        entry_drop(c, e);
+        c->stats.evictions++;
+    }
+    else {
+        /*Back in the main tier, it's copied again after as many hits as the first time*/
+        e->twin->twin = NULL;
+        e->twin->hits = 0;
+        lru_remove(tier, e);
+        slot_free(tier, e);
+    }
+}
+
+static void page_carve(glyph_tier_t * tier, uint8_t * page, uint8_t cls)
+{
+    uint32_t n = tier->page_size / class_size[cls];
+    while(n--) {
+        glyph_entry_t * s = (glyph_entry_t *)(page + n * class_size[cls]);
+        s->font = NULL;
+        s->cls = cls;
+        s->next = tier->free[cls];
+        tier->free[cls] = s;
+    }
+    tier->class_pages[cls]++;
+}
+
+/*Empty the page of the least recently used glyph of the class with the most pages, for `cls`.
+ *In the hot tier a page whose least recently used glyph was hit since the last look is spared.*/
+static bool page_steal(glyph_cache_t * c, glyph_tier_t * tier, uint8_t cls)
+{
+    uint8_t victim_cls = CLASS_CNT;
+    uint8_t i;
+    for(i = 0; i < CLASS_CNT; i++) {
+        if(i == cls || tier->lru_tail[i] == NULL) continue;
+        if(tier == &c->fast && tier->lru_tail[i]->hits) {
+            tier->lru_tail[i]->hits = 0;
+            continue;
+        }
+        if(victim_cls == CLASS_CNT || tier->class_pages[i] > tier->class_pages[victim_cls]) victim_cls = i;
+    }
+    if(victim_cls == CLASS_CNT) return false;
+
+    uint32_t page_ofs = (uint8_t *)tier->lru_tail[victim_cls] - tier->mem;
+    uint8_t * page = tier->mem + page_ofs - page_ofs % tier->page_size;
+    uint32_t size = class_size[victim_cls];
+    uint32_t n;
+    for(n = 0; n < tier->page_size / size; n++) {
+        glyph_entry_t * s = (glyph_entry_t *)(page + n * size);
+        if(s->font) slot_evict(c, tier, s);
+    }
+
+    /*Every slot of the page is free now, take them off the free list*/
+    glyph_entry_t ** p = &tier->free[victim_cls];
+    while(*p) {
+        if((uint8_t *)*p >= page && (uint8_t *)*p < page + tier->page_size) *p = (*p)->next;
+        else p = &(*p)->next;
+    }
+    tier->class_pages[victim_cls]--;
+    page_carve(tier, page, cls);
+    return true;
+}
+
+/*Remove a main tier glyph, with its hot copy*/
+static void entry_drop(glyph_cache_t * c, glyph_entry_t * e)
+{
+    glyph_entry_t ** p = &c->buckets[hash(e->font, e->letter, c->bucket_mask)];
+    while(*p != e) p = &(*p)->hash_next;
+    *p = e->hash_next;
+
+    if(e->twin) {
+        lru_remove(&c->fast, e->twin);
+        slot_free(&c->fast, e->twin);
+    }
+    lru_remove(&c->main, e);
+    slot_free(&c->main, e);
+}
+
+static void lru_remove(glyph_tier_t * tier, glyph_entry_t * e)
+{
+    if(e->prev) e->prev->next = e->next;
+    else tier->lru_head[e->cls] = e->next;
+    if(e->next) e->next->prev = e->prev;
+    else tier->lru_tail[e->cls] = e->prev;
+}
+
+static void lru_push(glyph_tier_t * tier, glyph_entry_t * e)
+{
+    e->prev = NULL;
+    e->next = tier->lru_head[e->cls];
+    if(e->next) e->next->prev = e;
+    else tier->lru_tail[e->cls] = e;
+    tier->lru_head[e->cls] = e;
+}
+
+static glyph_entry_t * promote(glyph_cache_t * c, glyph_entry_t * e)
+{
+    /*With the class full, only a hot glyph not hit since it came in or was spared makes room:
+     *a working set bigger than the hot tier would copy glyphs in and out on every hit otherwise*/
+    glyph_tier_t * fast = &c->fast;
+    if(class_size[e->cls] > fast->page_size) return NULL;
+    glyph_entry_t * tail = fast->lru_tail[e->cls];
+    if(fast->free[e->cls] == NULL && fast->page_used == fast->page_cnt && tail && tail->hits) {
+        tail->hits = 0;
+        lru_remove(fast, tail);
+        lru_push(fast, tail);
+        e->hits = 0;
+        return NULL;
+    }
+
+    glyph_entry_t * hot = slot_alloc(c, fast, e->cls);
+    if(hot == NULL) return NULL;
+
+    lv_memcpy(ENTRY_DATA(hot), ENTRY_DATA(e), (uint32_t)e->w * e->h);
+    hot->font = e->font;
+    hot->hits = 0;
+    hot->twin = e;
+    e->twin = hot;
+    lru_push(fast, hot);
+    c->stats.promotions++;
+    return hot;
+}
+
+/*The bitmap of a glyph to one opacity byte a pixel, the rows of the bitmap aren't padded*/
+static void expand(const uint8_t * map_p, lv_opa_t * a8, uint32_t w, uint32_t h, uint32_t bpp)
+{
+    const uint8_t * opa_table;
+    switch(bpp) {
+        case 1:
+            opa_table = _lv_bpp1_opa_table;
+            break;
+        case 2:
+            opa_table = _lv_bpp2_opa_table;
+            break;
+        case 4:
+            opa_table = _lv_bpp4_opa_table;
+            break;
+        default:
+            lv_memcpy(a8, map_p, w * h);
+            return;
+    }
+
+    uint32_t px_per_byte = 8 / bpp;
+    uint32_t mask = (1 << bpp) - 1;
+    uint32_t px_cnt = w * h;
+    uint32_t i;
+    for(i = 0; i + px_per_byte <= px_cnt; i += px_per_byte) {
+        uint32_t byte = *map_p++;
+        uint32_t shift = 8;
+        uint32_t k;
+        for(k = 0; k < px_per_byte; k++) {
+            shift -= bpp;
+            a8[i + k] = opa_table[(byte >> shift) & mask];
+        }
+    }
+    /*The last pixels share a byte with the padding*/
+    uint32_t shift = 8;
+    for(; i < px_cnt; i++) {
+        shift -= bpp;
+        a8[i] = opa_table[(*map_p >> shift) & mask];
+    }
+}
+
+static uint32_t hash(const lv_font_t * font, uint32_t letter, uint32_t mask)
+{
+    uint32_t h = (uint32_t)((uintptr_t)font >> 2) * 2654435761u;
+    h ^= letter * 0x9E3779B1u;
+    return (h ^ (h >> 15)) & mask;
+}
+
+static void * default_alloc(size_t size, lv_glyph_cache_mem_t mem)
+{
+    LV_UNUSED(mem);
+    return lv_mem_alloc(size);
+}
+
+static void default_free(void * p, lv_glyph_cache_mem_t mem)
+{
+    LV_UNUSED(mem);
+    lv_mem_free(p);
+}
+
+#endif /*LV_USE_GLYPH_CACHE*/
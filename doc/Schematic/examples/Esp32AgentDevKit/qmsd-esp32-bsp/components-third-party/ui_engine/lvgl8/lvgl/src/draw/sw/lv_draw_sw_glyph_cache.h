@@ -0,0 +1,113 @@
+/**
+ * @file lv_draw_sw_glyph_cache.h
+ *
+ */
+
+#ifndef LV_DRAW_SW_GLYPH_CACHE_H
+#define LV_DRAW_SW_GLYPH_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lv_conf_internal.h"
+#include "../../misc/lv_types.h"
+#include "../../misc/lv_color.h"
+#include "../../font/lv_font.h"
+
+#if LV_USE_GLYPH_CACHE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*Glyphs whose A8 mask (and entry header) doesn't fit a page are drawn from the font as before*/
+#define LV_GLYPH_CACHE_PAGE_SIZE    4096
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/** Where the memory of a tier comes from*/
+typedef enum {
+    LV_GLYPH_CACHE_MEM_MAIN,      /**< The big tier, every cached glyph, PSRAM is fine*/
+    LV_GLYPH_CACHE_MEM_FAST,      /**< The hot tier, copies of the glyphs hit again, internal RAM*/
+} lv_glyph_cache_mem_t;
+
+typedef void * (*lv_glyph_cache_alloc_cb_t)(size_t size, lv_glyph_cache_mem_t mem);
+typedef void (*lv_glyph_cache_free_cb_t)(void * p, lv_glyph_cache_mem_t mem);
+
+typedef struct {
+    uint32_t hits;              /**< Lookups served by the cache, `fast_hits` included*/
+    uint32_t fast_hits;         /**< Lookups served by the hot tier*/
+    uint32_t misses;            /**< Glyphs expanded and added*/
+    uint32_t uncached;          /**< Glyphs too big for a page or not in the font, drawn the old way*/
+    uint32_t evictions;         /**< Glyphs dropped from the main tier to make room*/
+    uint32_t promotions;        /**< Glyphs copied into the hot tier*/
+    uint32_t entries;           /**< Glyphs in the main tier now*/
+    uint32_t fast_entries;      /**< Glyphs in the hot tier now*/
+    uint32_t bytes;             /**< Slot bytes in use in the main tier*/
+    uint32_t fast_bytes;        /**< Slot bytes in use in the hot tier*/
+    uint32_t size;              /**< Size of the main tier*/
+    uint32_t fast_size;         /**< Size of the hot tier*/
+} lv_glyph_cache_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Set where the tiers are allocated, by default both come from `lv_mem_alloc`.
+ * Call it before the first letter is drawn, the tiers are allocated on first use
+ * (by every render thread with `LV_USE_REFR_PARALLEL`).
+ * @param alloc_cb  allocate `size` bytes for the tier `mem`
+ * @param free_cb   free what `alloc_cb` gave
+ */
+void lv_draw_sw_glyph_cache_set_alloc_cb(lv_glyph_cache_alloc_cb_t alloc_cb, lv_glyph_cache_free_cb_t free_cb);
+
+/**
+ * Resize the glyph cache of the calling render thread, dropping what it holds.
+ * It starts with `LV_GLYPH_CACHE_SIZE` and `LV_GLYPH_CACHE_FAST_SIZE`.
+ * @param size      bytes of the main tier, 0 turns the cache off
+ * @param fast_size bytes of the hot tier, 0 for none
+ */
+void lv_draw_sw_glyph_cache_set_size(uint32_t size, uint32_t fast_size);
+
+/**
+ * Drop every cached glyph, of every render thread (they see it on their next letter).
+ * Call it when a font is freed or its glyphs change. `lv_font_free()` does.
+ */
+void lv_draw_sw_glyph_cache_invalidate(void);
+
+/**
+ * Get the statistics of the calling render thread's cache
+ * @param stats     filled with the counters since the last reset and the current use
+ */
+void lv_draw_sw_glyph_cache_get_stats(lv_glyph_cache_stats_t * stats);
+
+/** Zero the counters of the calling render thread's cache*/
+void lv_draw_sw_glyph_cache_reset_stats(void);
+
+/**
+ * Get the A8 coverage mask of a glyph (`g->box_w` x `g->box_h`, one byte a pixel),
+ * expanding it from the font on a miss.
+ * @param g         the glyph's descriptor, `resolved_font` is the key with `letter`
+ * @param letter    the code point
+ * @return          the mask, valid until the next call, or NULL to draw from the font
+ */
+const lv_opa_t * _lv_draw_sw_glyph_cache_get(const lv_font_glyph_dsc_t * g, uint32_t letter);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif  /*LV_USE_GLYPH_CACHE*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_DRAW_SW_GLYPH_CACHE_H*/
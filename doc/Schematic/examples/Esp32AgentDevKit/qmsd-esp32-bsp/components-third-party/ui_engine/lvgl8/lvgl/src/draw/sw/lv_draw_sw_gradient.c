@@ -9,6 +9,7 @@
 #include "lv_draw_sw_gradient.h"
 #include "../../misc/lv_gc.h"
 #include "../../misc/lv_types.h"
+#include "../lv_draw_cache.h"
 
 /*********************
  *      DEFINES
@@ -32,27 +33,49 @@
     #error "LV_GRAD_CACHE_DEF_SIZE is too small"
 #endif
 
+/*Draw cache: the work to make a color of the map, in pixels*/
+#define GRAD_CACHE_COST 8
+
+/*Draw cache: what an item was made of is before it, in the same entry*/
+#define MADE_OF_SIZE    ALIGN(sizeof(grad_made_of_t))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    lv_grad_dsc_t dsc;
+    lv_coord_t w;
+    lv_coord_t h;
+} grad_made_of_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+#if LV_USE_DRAW_CACHE
+static uint32_t made_of_key(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
+static bool made_of_match(const grad_made_of_t * m, const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
+#else
 static lv_grad_t * next_in_cache(lv_grad_t * item);
 
 typedef lv_res_t (*op_cache_t)(lv_grad_t * c, void * ctx);
 static lv_res_t iterate_cache(op_cache_t func, void * ctx, lv_grad_t ** out);
 static size_t get_cache_item_size(lv_grad_t * c);
-static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
 static lv_res_t find_oldest_item_life(lv_grad_t * c, void * ctx);
 static lv_res_t kill_oldest_item(lv_grad_t * c, void * ctx);
 static lv_res_t find_item(lv_grad_t * c, void * ctx);
 static void free_item(lv_grad_t * c);
+#endif
+static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
 static  uint32_t compute_key(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
 
 
 /**********************
  *   STATIC VARIABLE
  **********************/
-static size_t    grad_cache_size = 0;
-static uint8_t * grad_cache_end = 0;
+#if !LV_USE_DRAW_CACHE
+static LV_DRAW_LOCAL size_t    grad_cache_size = 0;
+static LV_DRAW_LOCAL uint8_t * grad_cache_end = 0;
+#endif
 
 /**********************
  *   STATIC FUNCTIONS
@@ -69,6 +92,33 @@ static uint32_t compute_key(const lv_grad_dsc_t * g, lv_coord_t size, lv_coord_t
     return (v.value ^ size ^ (w >> 1)); /*Yes, this is correct, it's like a hash that changes if the width changes*/
 }
 
+#if LV_USE_DRAW_CACHE
+/*Hash the stops, not `g`'s address: the descriptors are often on the stack*/
+static uint32_t made_of_key(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
+{
+    uint32_t k = 2166136261u;
+    uint8_t i;
+    for(i = 0; i < g->stops_count; i++) {
+        k = (k ^ lv_color_to32(g->stops[i].color)) * 16777619u;
+        k = (k ^ g->stops[i].frac) * 16777619u;
+    }
+    k = (k ^ (g->dir | (g->dither << 3) | (g->stops_count << 6))) * 16777619u;
+    k = (k ^ (uint16_t)w) * 16777619u;
+    return (k ^ ((uint32_t)(uint16_t)h << 16)) * 16777619u;
+}
+
+static bool made_of_match(const grad_made_of_t * m, const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
+{
+    if(m->w != w || m->h != h) return false;
+    if(m->dsc.stops_count != g->stops_count || m->dsc.dir != g->dir || m->dsc.dither != g->dither) return false;
+    uint8_t i;
+    for(i = 0; i < g->stops_count; i++) {
+        if(m->dsc.stops[i].color.full != g->stops[i].color.full) return false;
+        if(m->dsc.stops[i].frac != g->stops[i].frac) return false;
+    }
+    return true;
+}
+#else
 static size_t get_cache_item_size(lv_grad_t * c)
 {
     size_t s = ALIGN(sizeof(*c)) + ALIGN(c->alloc_size * sizeof(lv_color_t));
@@ -86,7 +136,7 @@ static lv_grad_t * next_in_cache(lv_grad_t * item)
     if(grad_cache_size == 0) return NULL;
 
     if(item == NULL)
-        return (lv_grad_t *)LV_GC_ROOT(_lv_grad_cache_mem);
+        return (lv_grad_t *)LV_GC_DRAW_ROOT(_lv_grad_cache_mem);
 
     size_t s = get_cache_item_size(item);
     /*Compute the size for this cache item*/
@@ -154,6 +204,7 @@ static lv_res_t find_item(lv_grad_t * c, void * ctx)
     if(c->key == *k) return LV_RES_OK;
     return LV_RES_INV;
 }
+#endif /*LV_USE_DRAW_CACHE*/
 
 static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
 {
@@ -169,7 +220,25 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
 #endif
 #endif
 
-    size_t act_size = (size_t)(grad_cache_end - LV_GC_ROOT(_lv_grad_cache_mem));
+#if LV_USE_DRAW_CACHE
+    lv_grad_t * item;
+    uint8_t * block = _lv_draw_cache_add(LV_DRAW_CACHE_GRAD, made_of_key(g, w, h), MADE_OF_SIZE + req_size, 0,
+                                         size * GRAD_CACHE_COST, NULL);
+    bool not_cached = block == NULL;
+    if(not_cached) {
+        /*It doesn't fit, free it after this draw*/
+        block = lv_mem_alloc(MADE_OF_SIZE + req_size);
+        LV_ASSERT_MALLOC(block);
+        if(block == NULL) return NULL;
+    }
+    grad_made_of_t * made_of = (grad_made_of_t *)block;
+    made_of->dsc = *g;
+    made_of->w = w;
+    made_of->h = h;
+    item = (lv_grad_t *)(block + MADE_OF_SIZE);
+    item->not_cached = not_cached;
+#else
+    size_t act_size = (size_t)(grad_cache_end - LV_GC_DRAW_ROOT(_lv_grad_cache_mem));
     lv_grad_t * item = NULL;
     if(req_size + act_size < grad_cache_size) {
         item = (lv_grad_t *)grad_cache_end;
@@ -182,7 +251,7 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
                 uint32_t oldest_life = UINT32_MAX;
                 iterate_cache(&find_oldest_item_life, &oldest_life, NULL);
                 iterate_cache(&kill_oldest_item, &oldest_life, NULL);
-                act_size = (size_t)(grad_cache_end - LV_GC_ROOT(_lv_grad_cache_mem));
+                act_size = (size_t)(grad_cache_end - LV_GC_DRAW_ROOT(_lv_grad_cache_mem));
             }
             item = (lv_grad_t *)grad_cache_end;
             item->not_cached = 0;
@@ -195,13 +264,19 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
             item->not_cached = 1;
         }
     }
+#endif
 
     item->key = compute_key(g, size, w);
     item->life = 1;
     item->filled = 0;
     item->alloc_size = map_size;
     item->size = size;
+#if !LV_USE_DRAW_CACHE
     if(item->not_cached) {
+#else
+    /*In the draw cache every item has its own block*/
+    {
+#endif
         uint8_t * p = (uint8_t *)item;
         item->map = (lv_color_t *)(p + ALIGN(sizeof(*item)));
 #if _DITHER_GRADIENT
@@ -213,6 +288,7 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
 #endif
 #endif
     }
+#if !LV_USE_DRAW_CACHE
     else {
         item->map = (lv_color_t *)(grad_cache_end + ALIGN(sizeof(*item)));
 #if _DITHER_GRADIENT
@@ -225,6 +301,7 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
 #endif
         grad_cache_end += req_size;
     }
+#endif
     return item;
 }
 
@@ -234,18 +311,27 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
  **********************/
 void lv_gradient_free_cache(void)
 {
-    lv_mem_free(LV_GC_ROOT(_lv_grad_cache_mem));
-    LV_GC_ROOT(_lv_grad_cache_mem) = grad_cache_end = NULL;
+#if LV_USE_DRAW_CACHE
+    lv_draw_cache_invalidate(LV_DRAW_CACHE_GRAD);
+#else
+    lv_mem_free(LV_GC_DRAW_ROOT(_lv_grad_cache_mem));
+    LV_GC_DRAW_ROOT(_lv_grad_cache_mem) = grad_cache_end = NULL;
     grad_cache_size = 0;
+#endif
 }
 
 void lv_gradient_set_cache_size(size_t max_bytes)
 {
-    lv_mem_free(LV_GC_ROOT(_lv_grad_cache_mem));
-    grad_cache_end = LV_GC_ROOT(_lv_grad_cache_mem) = lv_mem_alloc(max_bytes);
-    LV_ASSERT_MALLOC(LV_GC_ROOT(_lv_grad_cache_mem));
-    lv_memset_00(LV_GC_ROOT(_lv_grad_cache_mem), max_bytes);
+#if LV_USE_DRAW_CACHE
+    LV_UNUSED(max_bytes);
+    LV_LOG_WARN("The gradients are in the draw cache, see `lv_draw_cache_set_size()`");
+#else
+    lv_mem_free(LV_GC_DRAW_ROOT(_lv_grad_cache_mem));
+    grad_cache_end = LV_GC_DRAW_ROOT(_lv_grad_cache_mem) = lv_mem_alloc(max_bytes);
+    LV_ASSERT_MALLOC(LV_GC_DRAW_ROOT(_lv_grad_cache_mem));
+    lv_memset_00(LV_GC_DRAW_ROOT(_lv_grad_cache_mem), max_bytes);
     grad_cache_size = max_bytes;
+#endif
 }
 
 lv_grad_t * lv_gradient_get(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
@@ -253,8 +339,20 @@ lv_grad_t * lv_gradient_get(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
     /* No gradient, no cache */
     if(g->dir == LV_GRAD_DIR_NONE) return NULL;
 
+#if LV_USE_DRAW_CACHE
+    /* Step 1: Search the draw cache for what the map is made of */
+    grad_made_of_t * made_of = _lv_draw_cache_get(LV_DRAW_CACHE_GRAD, made_of_key(g, w, h));
+    lv_grad_t * item = NULL;
+    if(made_of) {
+        item = (lv_grad_t *)((uint8_t *)made_of + MADE_OF_SIZE);
+        if(made_of_match(made_of, g, w, h)) return item;
+        /*Another gradient with the same key*/
+        _lv_draw_cache_release(made_of);
+        _lv_draw_cache_drop(made_of);
+    }
+#else
     /* Step 0: Check if the cache exist (else create it) */
-    static bool inited = false;
+    static LV_DRAW_LOCAL bool inited = false;
     if(!inited) {
         lv_gradient_set_cache_size(LV_GRAD_CACHE_DEF_SIZE);
         inited = true;
@@ -268,6 +366,7 @@ lv_grad_t * lv_gradient_get(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
         item->life++; /* Don't forget to bump the counter */
         return item;
     }
+#endif
 
     /* Step 2: Need to allocate an item for it */
     item = allocate_item(g, w, h);
@@ -340,7 +439,13 @@ LV_ATTRIBUTE_FAST_MEM lv_grad_color_t lv_gradient_calculate(const lv_grad_dsc_t
 
 void lv_gradient_cleanup(lv_grad_t * grad)
 {
+#if LV_USE_DRAW_CACHE
+    uint8_t * block = (uint8_t *)grad - MADE_OF_SIZE;
+    if(grad->not_cached) lv_mem_free(block);
+    else _lv_draw_cache_release(block);
+#else
     if(grad->not_cached) {
         lv_mem_free(grad);
     }
+#endif
 }
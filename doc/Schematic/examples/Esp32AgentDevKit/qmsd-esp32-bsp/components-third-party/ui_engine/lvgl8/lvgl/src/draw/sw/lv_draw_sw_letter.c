@@ -14,6 +14,7 @@
 #include "../../misc/lv_style.h"
 #include "../../font/lv_font.h"
 #include "../../core/lv_refr.h"
+#include "lv_draw_sw_glyph_cache.h"
 
 /*********************
  *      DEFINES
@@ -30,6 +31,10 @@
 LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc,
                                                      const lv_point_t * pos, lv_font_glyph_dsc_t * g, const uint8_t * map_p);
 
+#if LV_USE_GLYPH_CACHE
+LV_ATTRIBUTE_FAST_MEM static void draw_letter_a8(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc,
+                                                 const lv_point_t * pos, lv_font_glyph_dsc_t * g, const lv_opa_t * a8);
+#endif /*LV_USE_GLYPH_CACHE*/
 
 #if LV_DRAW_COMPLEX && LV_USE_FONT_SUBPX
 static void draw_letter_subpx(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc, const lv_point_t * pos,
@@ -140,6 +145,16 @@ void lv_draw_sw_letter(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc
         return;
     }
 
+#if LV_USE_GLYPH_CACHE
+    if(!g.resolved_font->subpx) {
+        const lv_opa_t * a8 = _lv_draw_sw_glyph_cache_get(&g, letter);
+        if(a8) {
+            draw_letter_a8(draw_ctx, dsc, &gpos, &g, a8);
+            return;
+        }
+    }
+#endif
+
     const uint8_t * map_p = lv_font_get_glyph_bitmap(g.resolved_font, letter);
     if(map_p == NULL) {
         LV_LOG_WARN("lv_draw_letter: character's bitmap not found");
@@ -218,6 +233,17 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, c
             return; /*Invalid bpp. Can't render the letter*/
     }
 
+#if LV_USE_REFR_PARALLEL
+    /*On the stack: as thread local storage the table would cost 256 bytes on every task*/
+    lv_opa_t opa_table[256];
+    if(opa < LV_OPA_MAX) {
+        uint32_t i;
+        for(i = 0; i < shades; i++) {
+            opa_table[i] = bpp_opa_table_p[i] == LV_OPA_COVER ? opa : ((bpp_opa_table_p[i] * opa) >> 8);
+        }
+        bpp_opa_table_p = opa_table;
+    }
+#else
     static lv_opa_t opa_table[256];
     static lv_opa_t prev_opa = LV_OPA_TRANSP;
     static uint32_t prev_bpp = 0;
@@ -232,6 +258,7 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, c
         prev_opa = opa;
         prev_bpp = bpp;
     }
+#endif /*LV_USE_REFR_PARALLEL*/
 
     int32_t col, row;
     int32_t box_w = g->box_w;
@@ -351,6 +378,98 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, c
     lv_mem_buf_release(mask_buf);
 }
 
+#if LV_USE_GLYPH_CACHE
+/*A glyph from the cache, already one opacity byte a pixel. Without opacity or masks
+ *to apply the blend reads the cached mask directly, else it goes through a buffer
+ *the way `draw_letter_normal` does it.*/
+LV_ATTRIBUTE_FAST_MEM static void draw_letter_a8(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc,
+                                                 const lv_point_t * pos, lv_font_glyph_dsc_t * g, const lv_opa_t * a8)
+{
+    int32_t box_w = g->box_w;
+    int32_t box_h = g->box_h;
+    lv_opa_t opa = dsc->opa;
+
+    int32_t col_start = pos->x >= draw_ctx->clip_area->x1 ? 0 : draw_ctx->clip_area->x1 - pos->x;
+    int32_t col_end   = pos->x + box_w <= draw_ctx->clip_area->x2 ? box_w : draw_ctx->clip_area->x2 - pos->x + 1;
+    int32_t row_start = pos->y >= draw_ctx->clip_area->y1 ? 0 : draw_ctx->clip_area->y1 - pos->y;
+    int32_t row_end   = pos->y + box_h <= draw_ctx->clip_area->y2 ? box_h : draw_ctx->clip_area->y2 - pos->y + 1;
+    if(col_start >= col_end || row_start >= row_end) return;
+
+    lv_draw_sw_blend_dsc_t blend_dsc;
+    lv_memset_00(&blend_dsc, sizeof(blend_dsc));
+    blend_dsc.color = dsc->color;
+    blend_dsc.opa = dsc->opa;
+    blend_dsc.blend_mode = dsc->blend_mode;
+    blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
+
+    lv_area_t fill_area;
+    fill_area.x1 = col_start + pos->x;
+    fill_area.x2 = col_end  + pos->x - 1;
+    fill_area.y1 = row_start + pos->y;
+#if LV_DRAW_COMPLEX
+    /*The same area the bitmap path asks about*/
+    fill_area.y2 = fill_area.y1 + row_end;
+    bool mask_any = lv_draw_mask_is_any(&fill_area);
+#else
+    bool mask_any = false;
+#endif
+
+    if(opa >= LV_OPA_MAX && !mask_any) {
+        lv_area_t letter_area;
+        letter_area.x1 = pos->x;
+        letter_area.y1 = pos->y;
+        letter_area.x2 = pos->x + box_w - 1;
+        letter_area.y2 = pos->y + box_h - 1;
+        blend_dsc.blend_area = &letter_area;
+        blend_dsc.mask_area = &letter_area;
+        blend_dsc.mask_buf = (lv_opa_t *)a8;
+        lv_draw_sw_blend(draw_ctx, &blend_dsc);
+        return;
+    }
+
+    int32_t fill_w = col_end - col_start;
+    lv_coord_t hor_res = lv_disp_get_hor_res(_lv_refr_get_disp_refreshing());
+    uint32_t mask_buf_size = box_w * box_h > hor_res ? hor_res : box_w * box_h;
+    lv_opa_t * mask_buf = lv_mem_buf_get(mask_buf_size);
+    int32_t rows_max = LV_MAX(mask_buf_size / fill_w, 1);
+    blend_dsc.mask_buf = mask_buf;
+    blend_dsc.blend_area = &fill_area;
+    blend_dsc.mask_area = &fill_area;
+
+    int32_t row = row_start;
+    while(row < row_end) {
+        int32_t rows = LV_MIN(rows_max, row_end - row);
+        fill_area.y1 = pos->y + row;
+        fill_area.y2 = fill_area.y1 + rows - 1;
+        lv_opa_t * mask_p = mask_buf;
+        int32_t r;
+        for(r = 0; r < rows; r++) {
+            const lv_opa_t * src = a8 + (row + r) * box_w + col_start;
+            if(opa < LV_OPA_MAX) {
+                int32_t x;
+                for(x = 0; x < fill_w; x++) {
+                    mask_p[x] = src[x] == LV_OPA_COVER ? opa : ((src[x] * opa) >> 8);
+                }
+            }
+            else {
+                lv_memcpy(mask_p, src, fill_w);
+            }
+#if LV_DRAW_COMPLEX
+            if(mask_any) {
+                lv_draw_mask_res_t res = lv_draw_mask_apply(mask_p, fill_area.x1, fill_area.y1 + r, fill_w);
+                if(res == LV_DRAW_MASK_RES_TRANSP) lv_memset_00(mask_p, fill_w);
+            }
+#endif
+            mask_p += fill_w;
+        }
+        lv_draw_sw_blend(draw_ctx, &blend_dsc);
+        row += rows;
+    }
+
+    lv_mem_buf_release(mask_buf);
+}
+#endif /*LV_USE_GLYPH_CACHE*/
+
 #if LV_DRAW_COMPLEX && LV_USE_FONT_SUBPX
 static void draw_letter_subpx(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc, const lv_point_t * pos,
                               lv_font_glyph_dsc_t * g, const uint8_t * map_p)
@@ -20,10 +20,30 @@
 #define SHADOW_ENHANCE          1
 #define SPLIT_LIMIT             50
 
+/*The shadow cache is one shared corner, the render threads would race on it.
+ *The draw cache keeps the corners of every thread instead*/
+#if defined(LV_SHADOW_CACHE_SIZE) && LV_SHADOW_CACHE_SIZE > 0 && !LV_USE_REFR_PARALLEL && !LV_USE_DRAW_CACHE
+    #define SHADOW_CACHE            1
+#else
+    #define SHADOW_CACHE            0
+#endif
+
+/*Draw cache: the work to blur a pixel of the corner*/
+#define SHADOW_CACHE_COST       16
+
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_USE_DRAW_CACHE && LV_DRAW_COMPLEX
+/*What a cached corner is made of, the corner follows it*/
+typedef struct {
+    int32_t corner_size;
+    int32_t r;
+    lv_coord_t w;
+    lv_coord_t h;
+} shadow_made_of_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -52,7 +72,7 @@ static void draw_border_simple(lv_draw_ctx_t * draw_ctx, const lv_area_t * outer
 /**********************
  *  STATIC VARIABLES
  **********************/
-#if defined(LV_SHADOW_CACHE_SIZE) && LV_SHADOW_CACHE_SIZE > 0
+#if SHADOW_CACHE
     static uint8_t sh_cache[LV_SHADOW_CACHE_SIZE * LV_SHADOW_CACHE_SIZE];
     static int32_t sh_cache_size = -1;
     static int32_t sh_cache_r = -1;
@@ -485,7 +505,7 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
 
     lv_opa_t * sh_buf;
 
-#if LV_SHADOW_CACHE_SIZE
+#if SHADOW_CACHE
     if(sh_cache_size == corner_size && sh_cache_r == r_sh) {
         /*Use the cache if available*/
         sh_buf = lv_mem_buf_get(corner_size * corner_size);
@@ -503,6 +523,43 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
             sh_cache_r = r_sh;
         }
     }
+#elif LV_USE_DRAW_CACHE
+    /*The far edges of a larger core area don't reach the corner*/
+    shadow_made_of_t made_of;
+    made_of.corner_size = corner_size;
+    made_of.r = r_sh;
+    made_of.w = LV_MIN(lv_area_get_width(&core_area), 2 * corner_size + 2);
+    made_of.h = LV_MIN(lv_area_get_height(&core_area), 2 * corner_size + 2);
+    uint32_t key = ((((uint32_t)corner_size * 16777619u) ^ (uint32_t)r_sh) * 16777619u ^ (uint16_t)made_of.w) *
+                   16777619u ^ ((uint32_t)(uint16_t)made_of.h << 16);
+
+    shadow_made_of_t * cached = _lv_draw_cache_get(LV_DRAW_CACHE_SHADOW, key);
+    if(cached && (cached->corner_size != corner_size || cached->r != r_sh ||
+                  cached->w != made_of.w || cached->h != made_of.h)) {
+        /*Another corner with the same key*/
+        _lv_draw_cache_release(cached);
+        _lv_draw_cache_drop(cached);
+        cached = NULL;
+    }
+
+    if(cached) {
+        /*Copy it, the corner is mirrored in the buffer while drawing*/
+        sh_buf = lv_mem_buf_get(corner_size * corner_size);
+        lv_memcpy(sh_buf, cached + 1, corner_size * corner_size);
+        _lv_draw_cache_release(cached);
+    }
+    else {
+        sh_buf = lv_mem_buf_get(corner_size * corner_size * sizeof(uint16_t));
+        shadow_draw_corner_buf(&core_area, (uint16_t *)sh_buf, dsc->shadow_width, r_sh);
+
+        cached = _lv_draw_cache_add(LV_DRAW_CACHE_SHADOW, key, sizeof(made_of) + corner_size * corner_size, 0,
+                                    corner_size * corner_size * SHADOW_CACHE_COST, NULL);
+        if(cached) {
+            *cached = made_of;
+            lv_memcpy(cached + 1, sh_buf, corner_size * corner_size);
+            _lv_draw_cache_release(cached);
+        }
+    }
 #else
     sh_buf = lv_mem_buf_get(corner_size * corner_size * sizeof(uint16_t));
     shadow_draw_corner_buf(&core_area, (uint16_t *)sh_buf, dsc->shadow_width, r_sh);
@@ -571,7 +628,7 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
                 blend_area.y2 = y;
 
                 if(!simple_sub) {
-                    lv_memcpy(mask_buf, sh_buf_tmp, corner_size);
+                    lv_memcpy(mask_buf, sh_buf_tmp, w);
                     blend_dsc.mask_res = lv_draw_mask_apply(mask_buf, clip_area_sub.x1, y, w);
                     if(blend_dsc.mask_res == LV_DRAW_MASK_RES_FULL_COVER) blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
                 }
@@ -614,7 +671,7 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
                 blend_area.y2 = y;
 
                 if(!simple_sub) {
-                    lv_memcpy(mask_buf, sh_buf_tmp, corner_size);
+                    lv_memcpy(mask_buf, sh_buf_tmp, w);
                     blend_dsc.mask_res = lv_draw_mask_apply(mask_buf, clip_area_sub.x1, y, w);
                     if(blend_dsc.mask_res == LV_DRAW_MASK_RES_FULL_COVER) blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
                 }
@@ -854,7 +911,7 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
                 blend_area.y2 = y;
 
                 if(!simple_sub) {
-                    lv_memcpy(mask_buf, sh_buf_tmp, corner_size);
+                    lv_memcpy(mask_buf, sh_buf_tmp, w);
                     blend_dsc.mask_res = lv_draw_mask_apply(mask_buf, clip_area_sub.x1, y, w);
                     if(blend_dsc.mask_res == LV_DRAW_MASK_RES_FULL_COVER) blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
                 }
@@ -898,7 +955,7 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
                 blend_area.y2 = y;
 
                 if(!simple_sub) {
-                    lv_memcpy(mask_buf, sh_buf_tmp, corner_size);
+                    lv_memcpy(mask_buf, sh_buf_tmp, w);
                     blend_dsc.mask_res = lv_draw_mask_apply(mask_buf, clip_area_sub.x1, y, w);
                     if(blend_dsc.mask_res == LV_DRAW_MASK_RES_FULL_COVER) blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
                 }
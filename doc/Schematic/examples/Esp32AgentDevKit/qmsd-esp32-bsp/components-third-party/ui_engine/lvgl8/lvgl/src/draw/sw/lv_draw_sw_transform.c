@@ -33,6 +33,20 @@ typedef struct {
     lv_point_t pivot;
 } point_transform_dsc_t;
 
+#if LV_COLOR_DEPTH == 16
+/*The source of the kernels, RGB565, ARGB8565 or RGB565A8*/
+typedef struct {
+    const uint8_t * src;
+    const lv_opa_t * src_a;     /*The alpha plane of RGB565A8*/
+    lv_coord_t src_w;
+    lv_coord_t src_h;
+    lv_coord_t src_stride;
+    int32_t px_size;
+    lv_img_cf_t cf;
+    bool aa;
+} transform_src_t;
+#endif
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -44,7 +58,7 @@ typedef struct {
  * @param xout      upscaled, transformed X
  * @param yout      upscaled, transformed Y
  */
-static void transform_point_upscaled(point_transform_dsc_t * t, int32_t xin, int32_t yin, int32_t * xout,
+static void transform_point_upscaled(const point_transform_dsc_t * t, int32_t xin, int32_t yin, int32_t * xout,
                                      int32_t * yout);
 
 static void argb_no_aa(const uint8_t * src, lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
@@ -65,6 +79,34 @@ static void argb_and_rgb_aa(const uint8_t * src, lv_coord_t src_w, lv_coord_t sr
                             int32_t xs_ups, int32_t ys_ups, int32_t xs_step, int32_t ys_step,
                             int32_t x_end, lv_color_t * cbuf, uint8_t * abuf, lv_img_cf_t cf);
 
+static inline void aa_px(const uint8_t * src, lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
+                         int32_t xs_ups, int32_t ys_ups, int32_t px_size, bool has_alpha, lv_img_cf_t cf,
+                         lv_color_t ck, lv_color_t * cbuf, lv_opa_t * abuf);
+
+static void transform_dsc_init(point_transform_dsc_t * tr_dsc, const lv_draw_img_dsc_t * draw_dsc);
+
+#if LV_COLOR_DEPTH == 16
+static void transform_right_angle(const point_transform_dsc_t * tr_dsc, const transform_src_t * s,
+                                  const lv_area_t * dest_area, lv_color_t * cbuf, lv_opa_t * abuf);
+
+static void transform_rotated(const point_transform_dsc_t * tr_dsc, const transform_src_t * s,
+                              const lv_area_t * dest_area, lv_color_t * cbuf, lv_opa_t * abuf);
+
+static void gather(const transform_src_t * s, int32_t base, const int32_t * ofs, int32_t n,
+                   lv_color_t * cbuf, lv_opa_t * abuf);
+
+static void gather_rotated(const transform_src_t * s, int32_t xs_ups, int32_t ys_ups, int32_t xs_step_256,
+                           int32_t ys_step_256, int32_t from, int32_t to, lv_color_t * cbuf, lv_opa_t * abuf);
+
+static void aa_row(const transform_src_t * s, const int32_t * walk, const int32_t * walk_nb, const int32_t * walk_fract,
+                   int32_t walk_px, bool walk_x, int32_t base, int32_t fixed_nb, int32_t fixed_fract, int32_t n,
+                   lv_color_t * cbuf, lv_opa_t * abuf);
+
+static bool aa_neighbor(int32_t ups, int32_t len, int32_t * next, int32_t * fract);
+
+static void axis_span(int32_t start_ups, int32_t step_256, int32_t len, int32_t dest_w, int32_t * from, int32_t * to);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -81,29 +123,46 @@ void lv_draw_sw_transform(lv_draw_ctx_t * draw_ctx, const lv_area_t * dest_area,
                           lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
                           const lv_draw_img_dsc_t * draw_dsc, lv_img_cf_t cf, lv_color_t * cbuf, lv_opa_t * abuf)
 {
-    LV_UNUSED(draw_ctx);
+#if LV_COLOR_DEPTH == 16
+    transform_src_t s;
+    switch(cf) {
+        case LV_IMG_CF_TRUE_COLOR:
+        case LV_IMG_CF_RGB565A8:
+            s.px_size = sizeof(lv_color_t);
+            break;
+        case LV_IMG_CF_TRUE_COLOR_ALPHA:
+            s.px_size = LV_IMG_PX_SIZE_ALPHA_BYTE;
+            break;
+        default:
+            /*Chroma keyed, pixel by pixel*/
+            lv_draw_sw_transform_basic(draw_ctx, dest_area, src_buf, src_w, src_h, src_stride, draw_dsc, cf, cbuf, abuf);
+            return;
+    }
+    s.src = src_buf;
+    s.src_a = s.src + src_stride * src_h * sizeof(lv_color_t);
+    s.src_w = src_w;
+    s.src_h = src_h;
+    s.src_stride = src_stride;
+    s.cf = cf;
+    s.aa = draw_dsc->antialias;
 
     point_transform_dsc_t tr_dsc;
-    tr_dsc.angle = -draw_dsc->angle;
-    tr_dsc.zoom = (256 * 256) / draw_dsc->zoom;
-    tr_dsc.pivot = draw_dsc->pivot;
-
-    int32_t angle_low = tr_dsc.angle / 10;
-    int32_t angle_high = angle_low + 1;
-    int32_t angle_rem = tr_dsc.angle  - (angle_low * 10);
-
-    int32_t s1 = lv_trigo_sin(angle_low);
-    int32_t s2 = lv_trigo_sin(angle_high);
+    transform_dsc_init(&tr_dsc, draw_dsc);
+    if(tr_dsc.angle % 900 == 0) transform_right_angle(&tr_dsc, &s, dest_area, cbuf, abuf);
+    else transform_rotated(&tr_dsc, &s, dest_area, cbuf, abuf);
+#else
+    lv_draw_sw_transform_basic(draw_ctx, dest_area, src_buf, src_w, src_h, src_stride, draw_dsc, cf, cbuf, abuf);
+#endif
+}
 
-    int32_t c1 = lv_trigo_sin(angle_low + 90);
-    int32_t c2 = lv_trigo_sin(angle_high + 90);
+void lv_draw_sw_transform_basic(lv_draw_ctx_t * draw_ctx, const lv_area_t * dest_area, const void * src_buf,
+                                lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
+                                const lv_draw_img_dsc_t * draw_dsc, lv_img_cf_t cf, lv_color_t * cbuf, lv_opa_t * abuf)
+{
+    LV_UNUSED(draw_ctx);
 
-    tr_dsc.sinma = (s1 * (10 - angle_rem) + s2 * angle_rem) / 10;
-    tr_dsc.cosma = (c1 * (10 - angle_rem) + c2 * angle_rem) / 10;
-    tr_dsc.sinma = tr_dsc.sinma >> (LV_TRIGO_SHIFT - 10);
-    tr_dsc.cosma = tr_dsc.cosma >> (LV_TRIGO_SHIFT - 10);
-    tr_dsc.pivot_x_256 = tr_dsc.pivot.x * 256;
-    tr_dsc.pivot_y_256 = tr_dsc.pivot.y * 256;
+    point_transform_dsc_t tr_dsc;
+    transform_dsc_init(&tr_dsc, draw_dsc);
 
     lv_coord_t dest_w = lv_area_get_width(dest_area);
     lv_coord_t dest_h = lv_area_get_height(dest_area);
@@ -157,6 +216,367 @@ void lv_draw_sw_transform(lv_draw_ctx_t * draw_ctx, const lv_area_t * dest_area,
  *   STATIC FUNCTIONS
  **********************/
 
+static void transform_dsc_init(point_transform_dsc_t * tr_dsc, const lv_draw_img_dsc_t * draw_dsc)
+{
+    tr_dsc->angle = -draw_dsc->angle;
+    tr_dsc->zoom = (256 * 256) / draw_dsc->zoom;
+    tr_dsc->pivot = draw_dsc->pivot;
+
+    int32_t angle_low = tr_dsc->angle / 10;
+    int32_t angle_high = angle_low + 1;
+    int32_t angle_rem = tr_dsc->angle  - (angle_low * 10);
+
+    int32_t s1 = lv_trigo_sin(angle_low);
+    int32_t s2 = lv_trigo_sin(angle_high);
+
+    int32_t c1 = lv_trigo_sin(angle_low + 90);
+    int32_t c2 = lv_trigo_sin(angle_high + 90);
+
+    tr_dsc->sinma = (s1 * (10 - angle_rem) + s2 * angle_rem) / 10;
+    tr_dsc->cosma = (c1 * (10 - angle_rem) + c2 * angle_rem) / 10;
+    tr_dsc->sinma = tr_dsc->sinma >> (LV_TRIGO_SHIFT - 10);
+    tr_dsc->cosma = tr_dsc->cosma >> (LV_TRIGO_SHIFT - 10);
+    tr_dsc->pivot_x_256 = tr_dsc->pivot.x * 256;
+    tr_dsc->pivot_y_256 = tr_dsc->pivot.y * 256;
+
+    /*The table tops out at 32767: make the right angles exact so they move whole pixels*/
+    if(tr_dsc->angle % 900 == 0) {
+        if(tr_dsc->sinma) tr_dsc->sinma = tr_dsc->sinma > 0 ? 1024 : -1024;
+        if(tr_dsc->cosma) tr_dsc->cosma = tr_dsc->cosma > 0 ? 1024 : -1024;
+    }
+}
+
+#if LV_COLOR_DEPTH == 16
+/*Rotated by 0, 90, 180 or 270 degrees and zoomed: a row of the destination walks along a row
+ *(or a column) of the source, the same way for every row. So the walk is computed once and
+ *only the source row (or column) changes from row to row*/
+static void transform_right_angle(const point_transform_dsc_t * tr_dsc, const transform_src_t * s,
+                                  const lv_area_t * dest_area, lv_color_t * cbuf, lv_opa_t * abuf)
+{
+    lv_coord_t dest_w = lv_area_get_width(dest_area);
+    lv_coord_t dest_h = lv_area_get_height(dest_area);
+
+    int32_t xs1_ups, ys1_ups, xs2_ups, ys2_ups;
+    transform_point_upscaled(tr_dsc, dest_area->x1, dest_area->y1, &xs1_ups, &ys1_ups);
+    transform_point_upscaled(tr_dsc, dest_area->x2, dest_area->y1, &xs2_ups, &ys2_ups);
+
+    /*0 and 180 degrees walk a source row, 90 and 270 a column*/
+    bool walk_x = tr_dsc->sinma == 0;
+    int32_t start_ups = walk_x ? xs1_ups : ys1_ups;
+    int32_t step_256 = 0;
+    if(dest_w > 1) step_256 = (256 * (walk_x ? xs2_ups - xs1_ups : ys2_ups - ys1_ups)) / (dest_w - 1);
+
+    int32_t from;
+    int32_t to;
+    axis_span(start_ups, step_256, walk_x ? s->src_w : s->src_h, dest_w, &from, &to);
+
+    /*Where the walk is: upscaled coordinates to anti-alias, else pixel offsets.
+     *To anti-alias also the offset of the neighbor to mix (0 if it's out of the image) and its weight*/
+    int32_t * walk = lv_mem_buf_get(dest_w * sizeof(int32_t) * (s->aa ? 3 : 1));
+    int32_t * walk_nb = walk + dest_w;
+    int32_t * walk_fract = walk + 2 * dest_w;
+    int32_t walk_len = walk_x ? s->src_w : s->src_h;
+    int32_t walk_px = walk_x ? 1 : s->src_stride;
+    int32_t acc = step_256 * from;
+    lv_coord_t x;
+    for(x = from; x < to; x++) {
+        int32_t ups = start_ups + (acc >> 8);
+        if(s->aa) {
+            int32_t next;
+            walk[x] = ups;
+            walk_nb[x] = aa_neighbor(ups, walk_len, &next, &walk_fract[x]) ? next * walk_px : 0;
+        }
+        else {
+            walk[x] = (ups >> 8) * walk_px;
+        }
+        acc += step_256;
+    }
+
+    /*The neighbors are out of the image only at the ends of the walk*/
+    int32_t in_from = from;
+    int32_t in_to = to;
+    if(s->aa) {
+        while(in_from < to && walk_nb[in_from] == 0) in_from++;
+        while(in_to > in_from && walk_nb[in_to - 1] == 0) in_to--;
+    }
+
+    lv_disp_t * d = _lv_refr_get_disp_refreshing();
+    lv_color_t ck = d->driver->color_chroma_key;
+    bool has_alpha = s->cf != LV_IMG_CF_TRUE_COLOR;
+    int32_t fixed_len = walk_x ? s->src_h : s->src_w;
+    lv_coord_t y;
+    for(y = 0; y < dest_h; y++) {
+        int32_t xs_ups, ys_ups;
+        transform_point_upscaled(tr_dsc, dest_area->x1, dest_area->y1 + y, &xs_ups, &ys_ups);
+        int32_t fixed_ups = walk_x ? ys_ups : xs_ups;
+        int32_t fixed_int = fixed_ups >> 8;
+        if(fixed_int < 0 || fixed_int >= fixed_len || from >= to) {
+            lv_memset_00(abuf, dest_w);
+        }
+        else {
+            lv_memset_00(abuf, from);
+            lv_memset_00(abuf + to, dest_w - to);
+            if(s->aa) {
+                int32_t fixed_next;
+                int32_t fixed_fract;
+                bool fixed_in = aa_neighbor(fixed_ups, fixed_len, &fixed_next, &fixed_fract);
+                for(x = from; x < to; x++) {
+                    /*Skip to the end of the walk where both neighbors are in the image*/
+                    if(fixed_in && x == in_from) x = in_to;
+                    if(x >= to) break;
+                    aa_px(s->src, s->src_w, s->src_h, s->src_stride, walk_x ? walk[x] : fixed_ups, walk_x ? fixed_ups : walk[x],
+                          s->px_size, has_alpha, s->cf, ck, &cbuf[x], &abuf[x]);
+                }
+                if(fixed_in) {
+                    aa_row(s, walk + in_from, walk_nb + in_from, walk_fract + in_from, walk_px, walk_x,
+                           fixed_int * (walk_x ? s->src_stride : 1), fixed_next * (walk_x ? s->src_stride : 1), fixed_fract,
+                           in_to - in_from, cbuf + in_from, abuf + in_from);
+                }
+            }
+            else {
+                gather(s, fixed_int * (walk_x ? s->src_stride : 1), walk + from, to - from, cbuf + from, abuf + from);
+            }
+        }
+
+        cbuf += dest_w;
+        abuf += dest_w;
+    }
+
+    lv_mem_buf_release(walk);
+}
+
+/*Any other angle: the source coordinates step the same amount from pixel to pixel of a row,
+ *so they are added up instead of multiplied, only where they are in the source*/
+static void transform_rotated(const point_transform_dsc_t * tr_dsc, const transform_src_t * s,
+                              const lv_area_t * dest_area, lv_color_t * cbuf, lv_opa_t * abuf)
+{
+    lv_coord_t dest_w = lv_area_get_width(dest_area);
+    lv_coord_t dest_h = lv_area_get_height(dest_area);
+
+    lv_disp_t * d = _lv_refr_get_disp_refreshing();
+    lv_color_t ck = d->driver->color_chroma_key;
+    bool has_alpha = s->cf != LV_IMG_CF_TRUE_COLOR;
+    lv_coord_t y;
+    for(y = 0; y < dest_h; y++) {
+        int32_t xs1_ups, ys1_ups, xs2_ups, ys2_ups;
+
+        transform_point_upscaled(tr_dsc, dest_area->x1, dest_area->y1 + y, &xs1_ups, &ys1_ups);
+        transform_point_upscaled(tr_dsc, dest_area->x2, dest_area->y1 + y, &xs2_ups, &ys2_ups);
+
+        int32_t xs_step_256 = 0;
+        int32_t ys_step_256 = 0;
+        if(dest_w > 1) {
+            xs_step_256 = (256 * (xs2_ups - xs1_ups)) / (dest_w - 1);
+            ys_step_256 = (256 * (ys2_ups - ys1_ups)) / (dest_w - 1);
+        }
+
+        int32_t from, to, y_from, y_to;
+        axis_span(xs1_ups, xs_step_256, s->src_w, dest_w, &from, &to);
+        axis_span(ys1_ups, ys_step_256, s->src_h, dest_w, &y_from, &y_to);
+        from = LV_MAX(from, y_from);
+        to = LV_MAX(LV_MIN(to, y_to), from);
+        lv_memset_00(abuf, from);
+        lv_memset_00(abuf + to, dest_w - to);
+
+        int32_t xs_acc = xs_step_256 * from;
+        int32_t ys_acc = ys_step_256 * from;
+        lv_coord_t x;
+        if(s->aa) {
+            for(x = from; x < to; x++) {
+                aa_px(s->src, s->src_w, s->src_h, s->src_stride, xs1_ups + (xs_acc >> 8), ys1_ups + (ys_acc >> 8),
+                      s->px_size, has_alpha, s->cf, ck, &cbuf[x], &abuf[x]);
+                xs_acc += xs_step_256;
+                ys_acc += ys_step_256;
+            }
+        }
+        else {
+            gather_rotated(s, xs1_ups, ys1_ups, xs_step_256, ys_step_256, from, to, cbuf, abuf);
+        }
+
+        cbuf += dest_w;
+        abuf += dest_w;
+    }
+}
+
+/*Copy the pixels `base + ofs[i]` of the source, no checks in the loops*/
+static void gather(const transform_src_t * s, int32_t base, const int32_t * ofs, int32_t n,
+                   lv_color_t * cbuf, lv_opa_t * abuf)
+{
+    const lv_color_t * src_c = (const lv_color_t *)s->src + base;
+    const uint8_t * src_argb = s->src + base * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    const lv_opa_t * src_a = s->src_a + base;
+    int32_t i;
+    switch(s->cf) {
+        case LV_IMG_CF_TRUE_COLOR:
+            for(i = 0; i < n; i++) cbuf[i] = src_c[ofs[i]];
+            lv_memset_ff(abuf, n);
+            break;
+        case LV_IMG_CF_TRUE_COLOR_ALPHA:
+            for(i = 0; i < n; i++) {
+                const uint8_t * px = src_argb + ofs[i] * LV_IMG_PX_SIZE_ALPHA_BYTE;
+                cbuf[i].full = px[0] + (px[1] << 8);
+                abuf[i] = px[2];
+            }
+            break;
+        case LV_IMG_CF_RGB565A8:
+            for(i = 0; i < n; i++) {
+                cbuf[i] = src_c[ofs[i]];
+                abuf[i] = src_a[ofs[i]];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*Copy the pixels [from, to) of a rotated row, the source coordinates added up as they go*/
+static void gather_rotated(const transform_src_t * s, int32_t xs_ups, int32_t ys_ups, int32_t xs_step_256,
+                           int32_t ys_step_256, int32_t from, int32_t to, lv_color_t * cbuf, lv_opa_t * abuf)
+{
+    const lv_color_t * src_c = (const lv_color_t *)s->src;
+    int32_t stride = s->src_stride;
+    int32_t xs_acc = xs_step_256 * from;
+    int32_t ys_acc = ys_step_256 * from;
+    int32_t x;
+
+#define ROTATED_OFS() ((((ys_ups + (ys_acc >> 8)) >> 8) * stride) + ((xs_ups + (xs_acc >> 8)) >> 8))
+    switch(s->cf) {
+        case LV_IMG_CF_TRUE_COLOR:
+            for(x = from; x < to; x++) {
+                cbuf[x] = src_c[ROTATED_OFS()];
+                xs_acc += xs_step_256;
+                ys_acc += ys_step_256;
+            }
+            lv_memset_ff(abuf + from, to - from);
+            break;
+        case LV_IMG_CF_TRUE_COLOR_ALPHA:
+            for(x = from; x < to; x++) {
+                const uint8_t * px = s->src + ROTATED_OFS() * LV_IMG_PX_SIZE_ALPHA_BYTE;
+                cbuf[x].full = px[0] + (px[1] << 8);
+                abuf[x] = px[2];
+                xs_acc += xs_step_256;
+                ys_acc += ys_step_256;
+            }
+            break;
+        case LV_IMG_CF_RGB565A8:
+            for(x = from; x < to; x++) {
+                int32_t ofs = ROTATED_OFS();
+                cbuf[x] = src_c[ofs];
+                abuf[x] = s->src_a[ofs];
+                xs_acc += xs_step_256;
+                ys_acc += ys_step_256;
+            }
+            break;
+        default:
+            break;
+    }
+#undef ROTATED_OFS
+}
+
+/*Anti-alias `n` pixels the way `aa_px` does, both neighbors of each in the image. The neighbor along
+ *the walk comes from the tables, the other one is the same for the whole row*/
+static void aa_row(const transform_src_t * s, const int32_t * walk, const int32_t * walk_nb, const int32_t * walk_fract,
+                   int32_t walk_px, bool walk_x, int32_t base, int32_t fixed_nb, int32_t fixed_fract, int32_t n,
+                   lv_color_t * cbuf, lv_opa_t * abuf)
+{
+    /*The horizontal and vertical neighbors: a table indexed by the pixel or one value (`inc` 0)*/
+    const int32_t * hor_nb = walk_x ? walk_nb : &fixed_nb;
+    const int32_t * hor_fract = walk_x ? walk_fract : &fixed_fract;
+    const int32_t * ver_nb = walk_x ? &fixed_nb : walk_nb;
+    const int32_t * ver_fract = walk_x ? &fixed_fract : walk_fract;
+    int32_t hor_inc = walk_x ? 1 : 0;
+    int32_t ver_inc = walk_x ? 0 : 1;
+
+    const uint8_t * src_a = s->cf == LV_IMG_CF_RGB565A8 ? s->src_a : s->src + LV_IMG_PX_SIZE_ALPHA_BYTE - 1;
+    int32_t a_size = s->cf == LV_IMG_CF_RGB565A8 ? 1 : LV_IMG_PX_SIZE_ALPHA_BYTE;
+    bool has_alpha = s->cf != LV_IMG_CF_TRUE_COLOR;
+    int32_t px_size = s->px_size;
+    int32_t i;
+    for(i = 0; i < n; i++) {
+        int32_t i_base = base + (walk[i] >> 8) * walk_px;
+        int32_t i_hor = i_base + hor_nb[i * hor_inc];
+        int32_t i_ver = i_base + ver_nb[i * ver_inc];
+        int32_t xs_fract = hor_fract[i * hor_inc];
+        int32_t ys_fract = ver_fract[i * ver_inc];
+
+        if(has_alpha) {
+            lv_opa_t a_base = src_a[i_base * a_size];
+            lv_opa_t a_ver = src_a[i_ver * a_size];
+            lv_opa_t a_hor = src_a[i_hor * a_size];
+            if(a_ver != a_base) a_ver = ((a_ver * ys_fract) + (a_base * (0x100 - ys_fract))) >> 8;
+            if(a_hor != a_base) a_hor = ((a_hor * xs_fract) + (a_base * (0x100 - xs_fract))) >> 8;
+            abuf[i] = (a_ver + a_hor) >> 1;
+            if(abuf[i] == 0x00) continue;
+        }
+        else {
+            abuf[i] = 0xff;
+        }
+
+        const uint8_t * px_base = s->src + i_base * px_size;
+        const uint8_t * px_ver = s->src + i_ver * px_size;
+        const uint8_t * px_hor = s->src + i_hor * px_size;
+        lv_color_t c_base;
+        lv_color_t c_ver;
+        lv_color_t c_hor;
+        c_base.full = px_base[0] + (px_base[1] << 8);
+        c_ver.full = px_ver[0] + (px_ver[1] << 8);
+        c_hor.full = px_hor[0] + (px_hor[1] << 8);
+        if(c_base.full == c_ver.full && c_base.full == c_hor.full) {
+            cbuf[i] = c_base;
+        }
+        else {
+            c_ver = lv_color_mix(c_ver, c_base, ys_fract);
+            c_hor = lv_color_mix(c_hor, c_base, xs_fract);
+            cbuf[i] = lv_color_mix(c_hor, c_ver, LV_OPA_50);
+        }
+    }
+}
+
+/*The direction (+/-1) of the neighbor `aa_px` mixes on an axis and its weight, false if it's out of [0, len)*/
+static bool aa_neighbor(int32_t ups, int32_t len, int32_t * next, int32_t * fract)
+{
+    int32_t f = ups & 0xFF;
+    if(f < 0x80) {
+        *next = -1;
+        *fract = (0x7F - f) * 2;
+    }
+    else {
+        *next = 1;
+        *fract = (f - 0x80) * 2;
+    }
+    int32_t n = (ups >> 8) + *next;
+    return n >= 0 && n < len;
+}
+
+/*The first pixel of a row where the source coordinate `(start_ups + ((step_256 * x) >> 8)) >> 8`
+ *is at least `bound` (`ge`) or below it, `dest_w` if none. It's monotonic in x, so bisect*/
+static int32_t first_x(int32_t start_ups, int32_t step_256, int32_t bound, bool ge, int32_t dest_w)
+{
+    int32_t lo = 0;
+    int32_t hi = dest_w;
+    while(lo < hi) {
+        int32_t mid = (lo + hi) >> 1;
+        int32_t v = (start_ups + ((step_256 * mid) >> 8)) >> 8;
+        if((v >= bound) == ge) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+/*The pixels [from, to) of a row whose source coordinate on an axis is in [0, len)*/
+static void axis_span(int32_t start_ups, int32_t step_256, int32_t len, int32_t dest_w, int32_t * from, int32_t * to)
+{
+    if(step_256 >= 0) {
+        *from = first_x(start_ups, step_256, 0, true, dest_w);
+        *to = first_x(start_ups, step_256, len, true, dest_w);
+    }
+    else {
+        *from = first_x(start_ups, step_256, len, false, dest_w);
+        *to = first_x(start_ups, step_256, 0, false, dest_w);
+    }
+}
+#endif /*LV_COLOR_DEPTH == 16*/
+
 static void rgb_no_aa(const uint8_t * src, lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
                       int32_t xs_ups, int32_t ys_ups, int32_t xs_step, int32_t ys_step,
                       int32_t x_end, lv_color_t * cbuf, uint8_t * abuf, lv_img_cf_t cf)
@@ -304,169 +724,175 @@ static void argb_and_rgb_aa(const uint8_t * src, lv_coord_t src_w, lv_coord_t sr
     for(x = 0; x < x_end; x++) {
         xs_ups = xs_ups_start + ((xs_step * x) >> 8);
         ys_ups = ys_ups_start + ((ys_step * x) >> 8);
+        aa_px(src, src_w, src_h, src_stride, xs_ups, ys_ups, px_size, has_alpha, cf, ck, &cbuf[x], &abuf[x]);
+    }
+}
 
-        int32_t xs_int = xs_ups >> 8;
-        int32_t ys_int = ys_ups >> 8;
+static inline void aa_px(const uint8_t * src, lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
+                         int32_t xs_ups, int32_t ys_ups, int32_t px_size, bool has_alpha, lv_img_cf_t cf,
+                         lv_color_t ck, lv_color_t * cbuf, lv_opa_t * abuf)
+{
+    int32_t xs_int = xs_ups >> 8;
+    int32_t ys_int = ys_ups >> 8;
 
-        /*Fully out of the image*/
-        if(xs_int < 0 || xs_int >= src_w || ys_int < 0 || ys_int >= src_h) {
-            abuf[x] = 0x00;
-            continue;
-        }
+    /*Fully out of the image*/
+    if(xs_int < 0 || xs_int >= src_w || ys_int < 0 || ys_int >= src_h) {
+        *abuf = 0x00;
+        return;
+    }
 
-        /*Get the direction the hor and ver neighbor
-         *`fract` will be in range of 0x00..0xFF and `next` (+/-1) indicates the direction*/
-        int32_t xs_fract = xs_ups & 0xFF;
-        int32_t ys_fract = ys_ups & 0xFF;
+    /*Get the direction the hor and ver neighbor
+     *`fract` will be in range of 0x00..0xFF and `next` (+/-1) indicates the direction*/
+    int32_t xs_fract = xs_ups & 0xFF;
+    int32_t ys_fract = ys_ups & 0xFF;
 
-        int32_t x_next;
-        int32_t y_next;
-        if(xs_fract < 0x80) {
-            x_next = -1;
-            xs_fract = (0x7F - xs_fract) * 2;
-        }
-        else {
-            x_next = 1;
-            xs_fract = (xs_fract - 0x80) * 2;
-        }
-        if(ys_fract < 0x80) {
-            y_next = -1;
-            ys_fract = (0x7F - ys_fract) * 2;
-        }
-        else {
-            y_next = 1;
-            ys_fract = (ys_fract - 0x80) * 2;
-        }
+    int32_t x_next;
+    int32_t y_next;
+    if(xs_fract < 0x80) {
+        x_next = -1;
+        xs_fract = (0x7F - xs_fract) * 2;
+    }
+    else {
+        x_next = 1;
+        xs_fract = (xs_fract - 0x80) * 2;
+    }
+    if(ys_fract < 0x80) {
+        y_next = -1;
+        ys_fract = (0x7F - ys_fract) * 2;
+    }
+    else {
+        y_next = 1;
+        ys_fract = (ys_fract - 0x80) * 2;
+    }
 
-        const uint8_t * src_tmp = src;
-        src_tmp += (ys_int * src_stride * px_size) + xs_int * px_size;
-
-
-        if(xs_int + x_next >= 0 &&
-           xs_int + x_next <= src_w - 1 &&
-           ys_int + y_next >= 0 &&
-           ys_int + y_next <= src_h - 1) {
-
-            const uint8_t * px_base = src_tmp;
-            const uint8_t * px_hor = src_tmp + x_next * px_size;
-            const uint8_t * px_ver = src_tmp + y_next * src_stride * px_size;
-            lv_color_t c_base;
-            lv_color_t c_ver;
-            lv_color_t c_hor;
-
-            if(has_alpha) {
-                lv_opa_t a_base;
-                lv_opa_t a_ver;
-                lv_opa_t a_hor;
-                if(cf == LV_IMG_CF_TRUE_COLOR_ALPHA) {
-                    a_base = px_base[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
-                    a_ver = px_ver[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
-                    a_hor = px_hor[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
-                }
+    const uint8_t * src_tmp = src;
+    src_tmp += (ys_int * src_stride * px_size) + xs_int * px_size;
+
+
+    if(xs_int + x_next >= 0 &&
+       xs_int + x_next <= src_w - 1 &&
+       ys_int + y_next >= 0 &&
+       ys_int + y_next <= src_h - 1) {
+
+        const uint8_t * px_base = src_tmp;
+        const uint8_t * px_hor = src_tmp + x_next * px_size;
+        const uint8_t * px_ver = src_tmp + y_next * src_stride * px_size;
+        lv_color_t c_base;
+        lv_color_t c_ver;
+        lv_color_t c_hor;
+
+        if(has_alpha) {
+            lv_opa_t a_base;
+            lv_opa_t a_ver;
+            lv_opa_t a_hor;
+            if(cf == LV_IMG_CF_TRUE_COLOR_ALPHA) {
+                a_base = px_base[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+                a_ver = px_ver[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+                a_hor = px_hor[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+            }
 #if LV_COLOR_DEPTH == 16
-                else if(cf == LV_IMG_CF_RGB565A8) {
-                    const lv_opa_t * a_tmp = src + src_stride * src_h * sizeof(lv_color_t);
-                    a_base = *(a_tmp + (ys_int * src_stride) + xs_int);
-                    a_hor = *(a_tmp + (ys_int * src_stride) + xs_int + x_next);
-                    a_ver = *(a_tmp + ((ys_int + y_next) * src_stride) + xs_int);
-                }
+            else if(cf == LV_IMG_CF_RGB565A8) {
+                const lv_opa_t * a_tmp = src + src_stride * src_h * sizeof(lv_color_t);
+                a_base = *(a_tmp + (ys_int * src_stride) + xs_int);
+                a_hor = *(a_tmp + (ys_int * src_stride) + xs_int + x_next);
+                a_ver = *(a_tmp + ((ys_int + y_next) * src_stride) + xs_int);
+            }
 #endif
-                else if(cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED) {
-                    if(((lv_color_t *)px_base)->full == ck.full ||
-                       ((lv_color_t *)px_ver)->full == ck.full ||
-                       ((lv_color_t *)px_hor)->full == ck.full) {
-                        abuf[x] = 0x00;
-                        continue;
-                    }
-                    else {
-                        a_base = 0xff;
-                        a_ver = 0xff;
-                        a_hor = 0xff;
-                    }
+            else if(cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED) {
+                if(((lv_color_t *)px_base)->full == ck.full ||
+                   ((lv_color_t *)px_ver)->full == ck.full ||
+                   ((lv_color_t *)px_hor)->full == ck.full) {
+                    *abuf = 0x00;
+                    return;
                 }
                 else {
                     a_base = 0xff;
                     a_ver = 0xff;
                     a_hor = 0xff;
                 }
+            }
+            else {
+                a_base = 0xff;
+                a_ver = 0xff;
+                a_hor = 0xff;
+            }
 
-                if(a_ver != a_base) a_ver = ((a_ver * ys_fract) + (a_base * (0x100 - ys_fract))) >> 8;
-                if(a_hor != a_base) a_hor = ((a_hor * xs_fract) + (a_base * (0x100 - xs_fract))) >> 8;
-                abuf[x] = (a_ver + a_hor) >> 1;
+            if(a_ver != a_base) a_ver = ((a_ver * ys_fract) + (a_base * (0x100 - ys_fract))) >> 8;
+            if(a_hor != a_base) a_hor = ((a_hor * xs_fract) + (a_base * (0x100 - xs_fract))) >> 8;
+            *abuf = (a_ver + a_hor) >> 1;
 
-                if(abuf[x] == 0x00) continue;
+            if(*abuf == 0x00) return;
 
 #if LV_COLOR_DEPTH == 8
-                c_base.full = px_base[0];
-                c_ver.full = px_ver[0];
-                c_hor.full = px_hor[0];
+            c_base.full = px_base[0];
+            c_ver.full = px_ver[0];
+            c_hor.full = px_hor[0];
 #elif LV_COLOR_DEPTH == 16
-                c_base.full = px_base[0] + (px_base[1] << 8);
-                c_ver.full = px_ver[0] + (px_ver[1] << 8);
-                c_hor.full = px_hor[0] + (px_hor[1] << 8);
+            c_base.full = px_base[0] + (px_base[1] << 8);
+            c_ver.full = px_ver[0] + (px_ver[1] << 8);
+            c_hor.full = px_hor[0] + (px_hor[1] << 8);
 #elif LV_COLOR_DEPTH == 32
-                c_base.full = *((uint32_t *)px_base);
-                c_ver.full = *((uint32_t *)px_ver);
-                c_hor.full = *((uint32_t *)px_hor);
+            c_base.full = *((uint32_t *)px_base);
+            c_ver.full = *((uint32_t *)px_ver);
+            c_hor.full = *((uint32_t *)px_hor);
 #endif
-            }
-            /*No alpha channel -> RGB*/
-            else {
-                c_base = *((const lv_color_t *) px_base);
-                c_hor = *((const lv_color_t *) px_hor);
-                c_ver = *((const lv_color_t *) px_ver);
-                abuf[x] = 0xff;
-            }
+        }
+        /*No alpha channel -> RGB*/
+        else {
+            c_base = *((const lv_color_t *) px_base);
+            c_hor = *((const lv_color_t *) px_hor);
+            c_ver = *((const lv_color_t *) px_ver);
+            *abuf = 0xff;
+        }
 
-            if(c_base.full == c_ver.full && c_base.full == c_hor.full) {
-                cbuf[x] = c_base;
-            }
-            else {
-                c_ver = lv_color_mix(c_ver, c_base, ys_fract);
-                c_hor = lv_color_mix(c_hor, c_base, xs_fract);
-                cbuf[x] = lv_color_mix(c_hor, c_ver, LV_OPA_50);
-            }
+        if(c_base.full == c_ver.full && c_base.full == c_hor.full) {
+            *cbuf = c_base;
         }
-        /*Partially out of the image*/
         else {
+            c_ver = lv_color_mix(c_ver, c_base, ys_fract);
+            c_hor = lv_color_mix(c_hor, c_base, xs_fract);
+            *cbuf = lv_color_mix(c_hor, c_ver, LV_OPA_50);
+        }
+    }
+    /*Partially out of the image*/
+    else {
 #if LV_COLOR_DEPTH == 8
-            cbuf[x].full = src_tmp[0];
+        cbuf->full = src_tmp[0];
 #elif LV_COLOR_DEPTH == 16
-            cbuf[x].full = src_tmp[0] + (src_tmp[1] << 8);
+        cbuf->full = src_tmp[0] + (src_tmp[1] << 8);
 #elif LV_COLOR_DEPTH == 32
-            cbuf[x].full = *((uint32_t *)src_tmp);
+        cbuf->full = *((uint32_t *)src_tmp);
 #endif
-            lv_opa_t a;
-            switch(cf) {
-                case LV_IMG_CF_TRUE_COLOR_ALPHA:
-                    a = src_tmp[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
-                    break;
-                case LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED:
-                    a = cbuf[x].full == ck.full ? 0x00 : 0xff;
-                    break;
+        lv_opa_t a;
+        switch(cf) {
+            case LV_IMG_CF_TRUE_COLOR_ALPHA:
+                a = src_tmp[LV_IMG_PX_SIZE_ALPHA_BYTE - 1];
+                break;
+            case LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED:
+                a = cbuf->full == ck.full ? 0x00 : 0xff;
+                break;
 #if LV_COLOR_DEPTH == 16
-                case LV_IMG_CF_RGB565A8:
-                    a = *(src + src_stride * src_h * sizeof(lv_color_t) + (ys_int * src_stride) + xs_int);
-                    break;
+            case LV_IMG_CF_RGB565A8:
+                a = *(src + src_stride * src_h * sizeof(lv_color_t) + (ys_int * src_stride) + xs_int);
+                break;
 #endif
-                default:
-                    a = 0xff;
-            }
+            default:
+                a = 0xff;
+        }
 
-            if((xs_int == 0 && x_next < 0) || (xs_int == src_w - 1 && x_next > 0))  {
-                abuf[x] = (a * (0xFF - xs_fract)) >> 8;
-            }
-            else if((ys_int == 0 && y_next < 0) || (ys_int == src_h - 1 && y_next > 0))  {
-                abuf[x] = (a * (0xFF - ys_fract)) >> 8;
-            }
-            else {
-                abuf[x] = 0x00;
-            }
+        if((xs_int == 0 && x_next < 0) || (xs_int == src_w - 1 && x_next > 0))  {
+            *abuf = (a * (0xFF - xs_fract)) >> 8;
+        }
+        else if((ys_int == 0 && y_next < 0) || (ys_int == src_h - 1 && y_next > 0))  {
+            *abuf = (a * (0xFF - ys_fract)) >> 8;
+        }
+        else {
+            *abuf = 0x00;
         }
     }
 }
 
-static void transform_point_upscaled(point_transform_dsc_t * t, int32_t xin, int32_t yin, int32_t * xout,
+static void transform_point_upscaled(const point_transform_dsc_t * t, int32_t xin, int32_t yin, int32_t * xout,
                                      int32_t * yout)
 {
     if(t->angle == 0 && t->zoom == LV_IMG_ZOOM_NONE) {
@@ -45,6 +45,25 @@ typedef struct {
     uint32_t grow_dsc_calc : 1;
 } track_t;
 
+#if LV_USE_LAYOUT_INCREMENTAL
+/*What `flex_update` keeps in the container to place only the changed children next time*/
+typedef struct {
+    _lv_layout_cache_t head;
+    flex_t f;
+    lv_coord_t item_gap;
+    lv_coord_t track_gap;
+    lv_coord_t max_main_size;
+    lv_coord_t track_cross_pos;     /*Where the last track is from the start of the content*/
+    lv_coord_t track_cross_size;    /*The cross size of the last track*/
+    int32_t track_first_item;       /*The first item of the last track*/
+    uint32_t item_cnt;              /*The number of children placed*/
+    uint8_t valid : 1;
+    uint8_t main_size_dep : 1;      /*The tracks before the last one depend on `max_main_size`*/
+    uint8_t track_grow : 1;         /*The last track has grow items*/
+    uint8_t cross_exact : 1;        /*`track_cross_size` is of the items as they are, not just at least that*/
+} flex_cache_t;
+#endif
+
 
 /**********************
  *  GLOBAL PROTOTYPES
@@ -61,6 +80,12 @@ static void children_repos(lv_obj_t * cont, flex_t * f, int32_t item_first_id, i
 static void place_content(lv_flex_align_t place, lv_coord_t max_size, lv_coord_t content_size, lv_coord_t item_cnt,
                           lv_coord_t * start_pos, lv_coord_t * gap);
 static lv_obj_t * get_next_item(lv_obj_t * cont, bool rev, int32_t * item_id);
+static lv_coord_t item_cross_pos(lv_flex_align_t place, lv_coord_t track_cross_size, lv_coord_t item_cross_size);
+static void item_move(lv_obj_t * item, lv_coord_t x, lv_coord_t y);
+#if LV_USE_LAYOUT_INCREMENTAL
+static int32_t place_changed(lv_obj_t * cont, flex_t * f, flex_cache_t * c, lv_coord_t abs_x, lv_coord_t abs_y,
+                             lv_coord_t max_main_size, lv_coord_t item_gap, lv_coord_t track_gap, lv_coord_t * cross_pos);
+#endif
 
 /**********************
  *  GLOBAL VARIABLES
@@ -117,7 +142,7 @@ void lv_obj_set_flex_align(lv_obj_t * obj, lv_flex_align_t main_place, lv_flex_a
 void lv_obj_set_flex_grow(lv_obj_t * obj, uint8_t grow)
 {
     lv_obj_set_style_flex_grow(obj, grow, 0);
-    lv_obj_mark_layout_as_dirty(lv_obj_get_parent(obj));
+    _lv_obj_mark_layout_dirty_by_child(lv_obj_get_parent(obj), obj);
 }
 
 
@@ -238,6 +263,11 @@ static void flex_update(lv_obj_t * cont, void * user_data)
     lv_coord_t w_set = lv_obj_get_style_width(cont, LV_PART_MAIN);
     lv_coord_t h_set = lv_obj_get_style_height(cont, LV_PART_MAIN);
 
+    /*Can't wrap if the size if auto (i.e. the size depends on the children)*/
+    if(f.wrap && ((f.row && w_set == LV_SIZE_CONTENT) || (!f.row && h_set == LV_SIZE_CONTENT))) {
+        f.wrap = false;
+    }
+
     /*Content sized objects should squeezed the gap between the children, therefore any alignment will look like `START`*/
     if((f.row && h_set == LV_SIZE_CONTENT && cont->h_layout == 0) ||
        (!f.row && w_set == LV_SIZE_CONTENT && cont->w_layout == 0)) {
@@ -255,6 +285,17 @@ static void flex_update(lv_obj_t * cont, void * user_data)
     int32_t track_first_item;
     int32_t next_track_first_item;
 
+#if LV_USE_LAYOUT_INCREMENTAL
+    /*Only the children changed since the last time are placed if the others can stay.
+     *Not if the tracks are placed from the end or by their total size*/
+    lv_coord_t cross_start = *cross_pos;
+    flex_cache_t * cache = _lv_obj_get_layout_cache(cont, LV_LAYOUT_FLEX, sizeof(flex_cache_t));
+    if(cache && (track_cross_place != LV_FLEX_ALIGN_START || rtl || f.rev)) {
+        cache->valid = 0;
+        cache = NULL;
+    }
+#endif
+
     if(track_cross_place != LV_FLEX_ALIGN_START) {
         track_first_item = f.rev ? cont->spec_attr->child_cnt - 1 : 0;
         track_t t;
@@ -275,6 +316,11 @@ static void flex_update(lv_obj_t * cont, void * user_data)
     }
 
     track_first_item = f.rev ? cont->spec_attr->child_cnt - 1 : 0;
+#if LV_USE_LAYOUT_INCREMENTAL
+    if(cache) {
+        track_first_item = place_changed(cont, &f, cache, abs_x, abs_y, max_main_size, item_gap, track_gap, cross_pos);
+    }
+#endif
 
     if(rtl && !f.row) {
         *cross_pos += total_track_cross_size;
@@ -289,6 +335,16 @@ static void flex_update(lv_obj_t * cont, void * user_data)
         if(rtl && !f.row) {
             *cross_pos -= t.track_cross_size;
         }
+#if LV_USE_LAYOUT_INCREMENTAL
+        if(cache) {
+            cache->main_size_dep |= cache->track_grow;
+            cache->track_first_item = track_first_item;
+            cache->track_cross_pos = *cross_pos - cross_start;
+            cache->track_cross_size = t.track_cross_size;
+            cache->track_grow = t.grow_item_cnt ? 1 : 0;
+            cache->cross_exact = 1;
+        }
+#endif
         children_repos(cont, &f, track_first_item, next_track_first_item, abs_x, abs_y, max_main_size, item_gap, &t);
         track_first_item = next_track_first_item;
         lv_mem_buf_release(t.grow_dsc);
@@ -317,13 +373,6 @@ static void flex_update(lv_obj_t * cont, void * user_data)
 static int32_t find_track_end(lv_obj_t * cont, flex_t * f, int32_t item_start_id, lv_coord_t max_main_size,
                               lv_coord_t item_gap, track_t * t)
 {
-    lv_coord_t w_set = lv_obj_get_style_width(cont, LV_PART_MAIN);
-    lv_coord_t h_set = lv_obj_get_style_height(cont, LV_PART_MAIN);
-
-    /*Can't wrap if the size if auto (i.e. the size depends on the children)*/
-    if(f->wrap && ((f->row && w_set == LV_SIZE_CONTENT) || (!f->row && h_set == LV_SIZE_CONTENT))) {
-        f->wrap = false;
-    }
     lv_coord_t(*get_main_size)(const lv_obj_t *) = (f->row ? lv_obj_get_width : lv_obj_get_height);
     lv_coord_t(*get_cross_size)(const lv_obj_t *) = (!f->row ? lv_obj_get_width : lv_obj_get_height);
 
@@ -489,45 +538,11 @@ static void children_repos(lv_obj_t * cont, flex_t * f, int32_t item_first_id, i
             item->h_layout = 0;
         }
 
-        lv_coord_t cross_pos = 0;
-        switch(f->cross_place) {
-            case LV_FLEX_ALIGN_CENTER:
-                /*Round up the cross size to avoid rounding error when dividing by 2
-                 *The issue comes up e,g, with column direction with center cross direction if an element's width changes*/
-                cross_pos = (((t->track_cross_size + 1) & (~1)) - area_get_cross_size(&item->coords)) / 2;
-                break;
-            case LV_FLEX_ALIGN_END:
-                cross_pos = t->track_cross_size - area_get_cross_size(&item->coords);
-                break;
-            default:
-                break;
-        }
+        lv_coord_t cross_pos = item_cross_pos(f->cross_place, t->track_cross_size, area_get_cross_size(&item->coords));
 
         if(f->row && rtl) main_pos -= area_get_main_size(&item->coords);
 
-
-        /*Handle percentage value of translate*/
-        lv_coord_t tr_x = lv_obj_get_style_translate_x(item, LV_PART_MAIN);
-        lv_coord_t tr_y = lv_obj_get_style_translate_y(item, LV_PART_MAIN);
-        lv_coord_t w = lv_obj_get_width(item);
-        lv_coord_t h = lv_obj_get_height(item);
-        if(LV_COORD_IS_PCT(tr_x)) tr_x = (w * LV_COORD_GET_PCT(tr_x)) / 100;
-        if(LV_COORD_IS_PCT(tr_y)) tr_y = (h * LV_COORD_GET_PCT(tr_y)) / 100;
-
-        lv_coord_t diff_x = abs_x - item->coords.x1 + tr_x;
-        lv_coord_t diff_y = abs_y - item->coords.y1 + tr_y;
-        diff_x += f->row ? main_pos : cross_pos;
-        diff_y += f->row ? cross_pos : main_pos;
-
-        if(diff_x || diff_y) {
-            lv_obj_invalidate(item);
-            item->coords.x1 += diff_x;
-            item->coords.x2 += diff_x;
-            item->coords.y1 += diff_y;
-            item->coords.y2 += diff_y;
-            lv_obj_invalidate(item);
-            lv_obj_move_children_by(item, diff_x, diff_y, false);
-        }
+        item_move(item, abs_x + (f->row ? main_pos : cross_pos), abs_y + (f->row ? cross_pos : main_pos));
 
         if(!(f->row && rtl)) main_pos += area_get_main_size(&item->coords) + item_gap + place_gap;
         else main_pos -= item_gap + place_gap;
@@ -593,4 +608,166 @@ static lv_obj_t * get_next_item(lv_obj_t * cont, bool rev, int32_t * item_id)
     }
 }
 
+/**
+ * Tell the position of an item in its track
+ */
+static lv_coord_t item_cross_pos(lv_flex_align_t place, lv_coord_t track_cross_size, lv_coord_t item_cross_size)
+{
+    switch(place) {
+        case LV_FLEX_ALIGN_CENTER:
+            /*Round up the cross size to avoid rounding error when dividing by 2
+             *The issue comes up e,g, with column direction with center cross direction if an element's width changes*/
+            return (((track_cross_size + 1) & (~1)) - item_cross_size) / 2;
+        case LV_FLEX_ALIGN_END:
+            return track_cross_size - item_cross_size;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Move an item, translated by its style, to an absolute position
+ */
+static void item_move(lv_obj_t * item, lv_coord_t x, lv_coord_t y)
+{
+    /*Handle percentage value of translate*/
+    lv_coord_t tr_x = lv_obj_get_style_translate_x(item, LV_PART_MAIN);
+    lv_coord_t tr_y = lv_obj_get_style_translate_y(item, LV_PART_MAIN);
+    lv_coord_t w = lv_obj_get_width(item);
+    lv_coord_t h = lv_obj_get_height(item);
+    if(LV_COORD_IS_PCT(tr_x)) tr_x = (w * LV_COORD_GET_PCT(tr_x)) / 100;
+    if(LV_COORD_IS_PCT(tr_y)) tr_y = (h * LV_COORD_GET_PCT(tr_y)) / 100;
+
+    lv_coord_t diff_x = x - item->coords.x1 + tr_x;
+    lv_coord_t diff_y = y - item->coords.y1 + tr_y;
+
+    if(diff_x || diff_y) {
+        lv_obj_invalidate(item);
+        item->coords.x1 += diff_x;
+        item->coords.x2 += diff_x;
+        item->coords.y1 += diff_y;
+        item->coords.y2 += diff_y;
+        lv_obj_invalidate(item);
+        lv_obj_move_children_by(item, diff_x, diff_y, false);
+    }
+}
+
+#if LV_USE_LAYOUT_INCREMENTAL
+/**
+ * Place the children changed since the last update, if the ones before them can stay.
+ * In the last track the items after the last unchanged one are placed after it.
+ * @param cross_pos     set to where the tracks still to place start
+ * @return              the first item of the tracks still to place (0: all of them)
+ */
+static int32_t place_changed(lv_obj_t * cont, flex_t * f, flex_cache_t * c, lv_coord_t abs_x, lv_coord_t abs_y,
+                             lv_coord_t max_main_size, lv_coord_t item_gap, lv_coord_t track_gap, lv_coord_t * cross_pos)
+{
+    int32_t child_cnt = (int32_t)cont->spec_attr->child_cnt;
+    int32_t from = (int32_t)_lv_obj_get_layout_dirty_from(cont);
+    int32_t item_cnt = (int32_t)c->item_cnt;
+    if(from > item_cnt) from = item_cnt;
+
+    if(!c->valid || c->f.row != f->row || c->f.wrap != f->wrap || c->f.main_place != f->main_place ||
+       c->f.cross_place != f->cross_place || c->item_gap != item_gap || c->track_gap != track_gap ||
+       (c->main_size_dep && c->max_main_size != max_main_size) ||
+       child_cnt < item_cnt || from < c->track_first_item ||
+       (from == c->track_first_item && from > 0)) {   /*The first item might fit in the track before now*/
+        c->f = *f;
+        c->item_gap = item_gap;
+        c->track_gap = track_gap;
+        c->max_main_size = max_main_size;
+        c->item_cnt = child_cnt;
+        c->valid = 1;
+        c->main_size_dep = f->wrap || f->main_place != LV_FLEX_ALIGN_START;
+        c->track_grow = 0;
+        c->track_first_item = 0;
+        c->track_cross_pos = 0;
+        c->track_cross_size = 0;
+        c->cross_exact = 1;
+        return 0;
+    }
+
+    /*The grow items of the last track fill the new size*/
+    if(c->track_grow && c->max_main_size != max_main_size) from = LV_MIN(from, c->track_first_item);
+    c->max_main_size = max_main_size;
+    c->item_cnt = child_cnt;
+    if(from >= child_cnt) return child_cnt;
+
+    /*Lay out the last track again from its first item*/
+    *cross_pos += c->track_cross_pos;
+    if(c->track_grow || f->main_place != LV_FLEX_ALIGN_START ||
+       (f->cross_place != LV_FLEX_ALIGN_START && (from < item_cnt || !c->cross_exact))) {
+        c->track_grow = 0;
+        return c->track_first_item;
+    }
+
+    /*Or, if the items are packed to the start of the track, continue after the last unchanged one*/
+    lv_obj_t * item = NULL;
+    int32_t item_id;
+    for(item_id = from - 1; item_id >= c->track_first_item; item_id--) {
+        item = cont->spec_attr->children[item_id];
+        if(!lv_obj_has_flag_any(item, LV_OBJ_FLAG_IGNORE_LAYOUT | LV_OBJ_FLAG_HIDDEN | LV_OBJ_FLAG_FLOATING)) break;
+    }
+    if(item_id < c->track_first_item) {
+        c->track_grow = 0;
+        return c->track_first_item;
+    }
+
+    lv_coord_t(*get_main_size)(const lv_obj_t *) = (f->row ? lv_obj_get_width : lv_obj_get_height);
+    lv_coord_t(*get_cross_size)(const lv_obj_t *) = (!f->row ? lv_obj_get_width : lv_obj_get_height);
+
+    lv_coord_t tr = f->row ? lv_obj_get_style_translate_x(item, LV_PART_MAIN) : lv_obj_get_style_translate_y(item,
+                                                                                                           LV_PART_MAIN);
+    if(LV_COORD_IS_PCT(tr)) tr = (get_main_size(item) * LV_COORD_GET_PCT(tr)) / 100;
+    lv_coord_t main_pos = (f->row ? item->coords.x1 - abs_x : item->coords.y1 - abs_y) - tr;
+    main_pos += get_main_size(item) + item_gap;
+
+    lv_coord_t track_x = abs_x + (f->row ? 0 : c->track_cross_pos);
+    lv_coord_t track_y = abs_y + (f->row ? c->track_cross_pos : 0);
+    lv_coord_t track_cross_size = c->track_cross_size;
+    for(item_id = from; item_id < child_cnt; item_id++) {
+        item = cont->spec_attr->children[item_id];
+        if(lv_obj_has_flag(item, LV_OBJ_FLAG_FLEX_IN_NEW_TRACK)) break;
+        if(lv_obj_has_flag_any(item, LV_OBJ_FLAG_IGNORE_LAYOUT | LV_OBJ_FLAG_HIDDEN | LV_OBJ_FLAG_FLOATING)) continue;
+
+        /*A grow item or a larger one to align in the track moves the others*/
+        lv_coord_t item_cross_size = get_cross_size(item);
+        if(lv_obj_get_style_flex_grow(item, LV_PART_MAIN) ||
+           (f->cross_place != LV_FLEX_ALIGN_START && item_cross_size > track_cross_size)) {
+            c->track_grow = 0;
+            return c->track_first_item;
+        }
+
+        lv_coord_t item_main_size = get_main_size(item);
+        if(f->wrap && main_pos + item_main_size > max_main_size) break;
+
+        item->w_layout = 0;
+        item->h_layout = 0;
+        lv_coord_t pos = item_cross_pos(f->cross_place, track_cross_size, item_cross_size);
+        item_move(item, track_x + (f->row ? main_pos : pos), track_y + (f->row ? pos : main_pos));
+
+        track_cross_size = LV_MAX(track_cross_size, item_cross_size);
+        main_pos += item_main_size + item_gap;
+    }
+
+    /*Changed items might have been the largest ones*/
+    if(from < item_cnt) c->cross_exact = 0;
+    c->track_cross_size = track_cross_size;
+    if(item_id >= child_cnt) return child_cnt;
+
+    /*The rest go to new tracks*/
+    if(!c->cross_exact) {
+        int32_t i;
+        track_cross_size = 0;
+        for(i = c->track_first_item; i < item_id; i++) {
+            item = cont->spec_attr->children[i];
+            if(lv_obj_has_flag_any(item, LV_OBJ_FLAG_IGNORE_LAYOUT | LV_OBJ_FLAG_HIDDEN | LV_OBJ_FLAG_FLOATING)) continue;
+            track_cross_size = LV_MAX(track_cross_size, get_cross_size(item));
+        }
+    }
+    *cross_pos += track_cross_size + track_gap;
+    return item_id;
+}
+#endif
+
 #endif /*LV_USE_FLEX*/
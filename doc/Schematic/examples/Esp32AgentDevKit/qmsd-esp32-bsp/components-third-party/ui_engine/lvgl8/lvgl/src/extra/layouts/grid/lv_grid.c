@@ -10,6 +10,8 @@
 
 #if LV_USE_GRID
 
+#include <string.h>
+
 /*********************
  *      DEFINES
  *********************/
@@ -40,6 +42,17 @@ typedef struct {
     lv_coord_t grid_h;
 } _lv_grid_calc_t;
 
+#if LV_USE_LAYOUT_INCREMENTAL
+/*What `grid_update` keeps in the container to place only the changed children if the cells stay*/
+typedef struct {
+    _lv_layout_cache_t head;
+    uint32_t col_num;
+    uint32_t row_num;
+    bool valid;
+    /*Followed by the x and w of the columns and the y and h of the rows*/
+} grid_cache_t;
+#endif
+
 
 /**********************
  *  GLOBAL PROTOTYPES
@@ -57,6 +70,9 @@ static void item_repos(lv_obj_t * item, _lv_grid_calc_t * c, item_repos_hint_t *
 static lv_coord_t grid_align(lv_coord_t cont_size,  bool auto_size, uint8_t align, lv_coord_t gap, uint32_t track_num,
                              lv_coord_t * size_array, lv_coord_t * pos_array, bool reverse);
 static uint32_t count_tracks(const lv_coord_t * templ);
+#if LV_USE_LAYOUT_INCREMENTAL
+static bool cache_update(lv_obj_t * cont, const _lv_grid_calc_t * c);
+#endif
 
 static inline const lv_coord_t * get_col_dsc(lv_obj_t * obj)
 {
@@ -169,7 +185,7 @@ void lv_obj_set_grid_cell(lv_obj_t * obj, lv_grid_align_t x_align, uint8_t col_p
     lv_obj_set_style_grid_cell_row_span(obj, row_span, 0);
     lv_obj_set_style_grid_cell_y_align(obj, y_align, 0);
 
-    lv_obj_mark_layout_as_dirty(lv_obj_get_parent(obj));
+    _lv_obj_mark_layout_dirty_by_child(lv_obj_get_parent(obj), obj);
 }
 
 
@@ -364,8 +380,12 @@ static void grid_update(lv_obj_t * cont, void * user_data)
     hint.grid_abs.x = pad_left + cont->coords.x1 - lv_obj_get_scroll_x(cont);
     hint.grid_abs.y = pad_top + cont->coords.y1 - lv_obj_get_scroll_y(cont);
 
-    uint32_t i;
-    for(i = 0; i < cont->spec_attr->child_cnt; i++) {
+    uint32_t i = 0;
+#if LV_USE_LAYOUT_INCREMENTAL
+    /*In the same cells the children before the changed ones stay*/
+    if(cache_update(cont, &c)) i = _lv_obj_get_layout_dirty_from(cont);
+#endif
+    for(; i < cont->spec_attr->child_cnt; i++) {
         lv_obj_t * item = cont->spec_attr->children[i];
         item_repos(item, &c, &hint);
     }
@@ -778,5 +798,40 @@ static uint32_t count_tracks(const lv_coord_t * templ)
     return i;
 }
 
+#if LV_USE_LAYOUT_INCREMENTAL
+/**
+ * Keep the calculated cells in the container
+ * @param cont  an object that has a grid
+ * @param c     its calculated cells
+ * @return      true: they are the same as the last time
+ */
+static bool cache_update(lv_obj_t * cont, const _lv_grid_calc_t * c)
+{
+    uint32_t col_size = sizeof(lv_coord_t) * c->col_num;
+    uint32_t row_size = sizeof(lv_coord_t) * c->row_num;
+    grid_cache_t * cache = _lv_obj_get_layout_cache(cont, LV_LAYOUT_GRID,
+                                                    sizeof(grid_cache_t) + 2 * (col_size + row_size));
+    if(cache == NULL) return false;
+
+    uint8_t * x = (uint8_t *)(cache + 1);
+    uint8_t * w = x + col_size;
+    uint8_t * y = w + col_size;
+    uint8_t * h = y + row_size;
+    bool same = cache->valid && cache->col_num == c->col_num && cache->row_num == c->row_num &&
+                memcmp(x, c->x, col_size) == 0 && memcmp(w, c->w, col_size) == 0 &&
+                memcmp(y, c->y, row_size) == 0 && memcmp(h, c->h, row_size) == 0;
+    if(!same) {
+        lv_memcpy(x, c->x, col_size);
+        lv_memcpy(w, c->w, col_size);
+        lv_memcpy(y, c->y, row_size);
+        lv_memcpy(h, c->h, row_size);
+        cache->col_num = c->col_num;
+        cache->row_num = c->row_num;
+        cache->valid = true;
+    }
+    return same;
+}
+#endif
+
 
 #endif /*LV_USE_GRID*/
@@ -27,6 +27,7 @@ extern "C" {
 #include "spinner/lv_spinner.h"
 #include "tabview/lv_tabview.h"
 #include "tileview/lv_tileview.h"
+#include "vlist/lv_vlist.h"
 #include "win/lv_win.h"
 #include "colorwheel/lv_colorwheel.h"
 #include "led/lv_led.h"
@@ -57,16 +57,15 @@ static bool lv_txt_get_snippet(const char * txt, const lv_font_t * font, lv_coor
                                lv_coord_t max_width, lv_text_flag_t flag, lv_coord_t * use_width,
                                uint32_t * end_ofs);
 
-static void lv_snippet_clear(void);
-static uint16_t lv_get_snippet_cnt(void);
-static void lv_snippet_push(lv_snippet_t * item);
-static lv_snippet_t * lv_get_snippet(uint16_t index);
+static void lv_snippet_clear(struct _snippet_stack * snippet_stack);
+static uint16_t lv_get_snippet_cnt(struct _snippet_stack * snippet_stack);
+static void lv_snippet_push(struct _snippet_stack * snippet_stack, lv_snippet_t * item);
+static lv_snippet_t * lv_get_snippet(struct _snippet_stack * snippet_stack, uint16_t index);
 static lv_coord_t convert_indent_pct(lv_obj_t * spans, lv_coord_t width);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
-static struct _snippet_stack snippet_stack;
 
 const lv_obj_class_t lv_spangroup_class  = {
     .base_class = &lv_obj_class,
@@ -617,30 +616,30 @@ static bool lv_txt_get_snippet(const char * txt, const lv_font_t * font,
     }
 }
 
-static void lv_snippet_push(lv_snippet_t * item)
+static void lv_snippet_push(struct _snippet_stack * snippet_stack, lv_snippet_t * item)
 {
-    if(snippet_stack.index < LV_SPAN_SNIPPET_STACK_SIZE) {
-        memcpy(&snippet_stack.stack[snippet_stack.index], item, sizeof(lv_snippet_t));
-        snippet_stack.index++;
+    if(snippet_stack->index < LV_SPAN_SNIPPET_STACK_SIZE) {
+        memcpy(&snippet_stack->stack[snippet_stack->index], item, sizeof(lv_snippet_t));
+        snippet_stack->index++;
     }
     else {
         LV_LOG_ERROR("span draw stack overflow, please set LV_SPAN_SNIPPET_STACK_SIZE too larger");
     }
 }
 
-static uint16_t lv_get_snippet_cnt(void)
+static uint16_t lv_get_snippet_cnt(struct _snippet_stack * snippet_stack)
 {
-    return snippet_stack.index;
+    return snippet_stack->index;
 }
 
-static lv_snippet_t * lv_get_snippet(uint16_t index)
+static lv_snippet_t * lv_get_snippet(struct _snippet_stack * snippet_stack, uint16_t index)
 {
-    return &snippet_stack.stack[index];
+    return &snippet_stack->stack[index];
 }
 
-static void lv_snippet_clear(void)
+static void lv_snippet_clear(struct _snippet_stack * snippet_stack)
 {
-    snippet_stack.index = 0;
+    snippet_stack->index = 0;
 }
 
 static const lv_font_t * lv_span_get_style_text_font(lv_obj_t * par, lv_span_t * span)
@@ -773,6 +772,9 @@ static void lv_draw_span(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
     const lv_area_t * clip_area_ori = draw_ctx->clip_area;
     draw_ctx->clip_area = &clip_area;
 
+    /* the spans of a line, from the draw buffers: render threads may draw spangroups at the same time */
+    struct _snippet_stack * snippet_stack = lv_mem_buf_get(sizeof(struct _snippet_stack));
+
     /* init draw variable */
     lv_text_flag_t txt_flag = LV_TEXT_FLAG_NONE;
     lv_coord_t line_space = lv_obj_get_style_text_line_space(obj, LV_PART_MAIN);;
@@ -803,7 +805,7 @@ static void lv_draw_span(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
         bool ellipsis_valid = false;
         lv_coord_t max_line_h = 0;  /* the max height of span-font when a line have a lot of span */
         lv_coord_t max_baseline = 0; /*baseline of the highest span*/
-        lv_snippet_clear();
+        lv_snippet_clear(snippet_stack);
 
         /* the loop control to find a line and push the relevant span info into stack  */
         while(1) {
@@ -833,7 +835,7 @@ static void lv_draw_span(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
                                              max_w, txt_flag, &use_width, &next_ofs);
 
             if(isfill) {
-                if(next_ofs > 0 && lv_get_snippet_cnt() > 0) {
+                if(next_ofs > 0 && lv_get_snippet_cnt(snippet_stack) > 0) {
                     /* To prevent infinite loops, the _lv_txt_get_next_line() may return incomplete words, */
                     /* This phenomenon should be avoided when lv_get_snippet_cnt() > 0 */
                     if(max_w < use_width) {
@@ -860,7 +862,7 @@ static void lv_draw_span(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
                 max_baseline = snippet.font->base_line;
             }
 
-            lv_snippet_push(&snippet);
+            lv_snippet_push(snippet_stack, &snippet);
             max_w = max_w - use_width - snippet.letter_space;
             if(isfill || max_w <= 0) {
                 break;
@@ -869,14 +871,14 @@ static void lv_draw_span(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
 
         /* start current line deal with */
 
-        uint16_t item_cnt = lv_get_snippet_cnt();
+        uint16_t item_cnt = lv_get_snippet_cnt(snippet_stack);
         if(item_cnt == 0) {     /* break if stack is empty */
             break;
         }
 
         /* Whether the current line is the end line and does overflow processing */
         {
-            lv_snippet_t * last_snippet = lv_get_snippet(item_cnt - 1);
+            lv_snippet_t * last_snippet = lv_get_snippet(snippet_stack, item_cnt - 1);
             lv_coord_t next_line_h = last_snippet->line_h;
             if(last_snippet->txt[last_snippet->bytes] == '\0') {
                 next_line_h = 0;
@@ -907,10 +909,10 @@ static void lv_draw_span(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
             lv_coord_t align_ofs = 0;
             lv_coord_t txts_w = is_first_line ? indent : 0;
             for(int i = 0; i < item_cnt; i++) {
-                lv_snippet_t * pinfo = lv_get_snippet(i);
+                lv_snippet_t * pinfo = lv_get_snippet(snippet_stack, i);
                 txts_w = txts_w + pinfo->txt_w + pinfo->letter_space;
             }
-            txts_w -= lv_get_snippet(item_cnt - 1)->letter_space;
+            txts_w -= lv_get_snippet(snippet_stack, item_cnt - 1)->letter_space;
             align_ofs = max_width > txts_w ? max_width - txts_w : 0;
             if(align == LV_TEXT_ALIGN_CENTER) {
                 align_ofs = align_ofs >> 1;
@@ -921,7 +923,7 @@ static void lv_draw_span(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
         /* draw line letters */
         int i;
         for(i = 0; i < item_cnt; i++) {
-            lv_snippet_t * pinfo = lv_get_snippet(i);
+            lv_snippet_t * pinfo = lv_get_snippet(snippet_stack, i);
 
             /* bidi deal with:todo */
             const char * bidi_txt = pinfo->txt;
@@ -1022,11 +1024,13 @@ Next_line_init:
         txt_pos.x = coords.x1;
         txt_pos.y += max_line_h;
         if(is_end_line || txt_pos.y > clip_area.y2 + 1) {
+            lv_mem_buf_release(snippet_stack);
             draw_ctx->clip_area = clip_area_ori;
             return;
         }
         max_w = max_width;
     }
+    lv_mem_buf_release(snippet_stack);
     draw_ctx->clip_area = clip_area_ori;
 }
 
@@ -0,0 +1,836 @@
+/**
+ * @file lv_vlist.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_vlist.h"
+#if LV_USE_VLIST
+
+/*********************
+ *      DEFINES
+ *********************/
+#define MY_CLASS &lv_vlist_class
+
+#define CHUNK       _LV_VLIST_CHUNK_ROWS
+#define H_NONE      0xFFFF
+
+/*The scrolled content is at most this high: the rows are placed relative to `base`,
+ *and moved together when the view gets near the edge, to keep the coordinates in `lv_coord_t`*/
+#define WIN_MAX     (LV_COORD_MAX / 2)
+
+#define SCROLLBAR_MIN_SIZE (LV_DPX(10))
+
+/*Give up if the rows keep changing height while they are shown*/
+#define UPDATE_MAX  8
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void lv_vlist_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+static void lv_vlist_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+static void lv_vlist_event(const lv_obj_class_t * class_p, lv_event_t * e);
+static void rows_update(lv_obj_t * obj);
+static int32_t view_restore(lv_obj_t * obj);
+static void window_fill(lv_obj_t * obj, int32_t y);
+static void scrollbar_area(lv_obj_t * obj, lv_area_t * area);
+static void scrollbar_invalidate(lv_obj_t * obj);
+static void anchor_set(lv_vlist_t * vlist, int32_t y);
+static int32_t row_y(lv_vlist_t * vlist, uint32_t id);
+static uint32_t row_at(lv_vlist_t * vlist, int32_t y, int32_t * ofs);
+static int32_t total_h(lv_vlist_t * vlist);
+static int32_t est_h(lv_vlist_t * vlist);
+static uint16_t height_get(lv_vlist_t * vlist, uint32_t id);
+static void height_set(lv_vlist_t * vlist, uint32_t id, uint16_t h);
+static void heights_resize(lv_vlist_t * vlist, uint32_t cnt);
+static void heights_reset(lv_obj_t * obj);
+static void heights_query(lv_obj_t * obj, uint32_t from);
+static int32_t pool_find(lv_vlist_t * vlist, uint32_t id);
+static int32_t pool_find_obj(lv_vlist_t * vlist, const lv_obj_t * row_obj);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+const lv_obj_class_t lv_vlist_class = {
+    .constructor_cb = lv_vlist_constructor,
+    .destructor_cb = lv_vlist_destructor,
+    .event_cb = lv_vlist_event,
+    .width_def = (LV_DPI_DEF * 3) / 2,
+    .height_def = LV_DPI_DEF * 2,
+    .instance_size = sizeof(lv_vlist_t),
+    .base_class = &lv_obj_class
+};
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_obj_t * lv_vlist_create(lv_obj_t * parent)
+{
+    LV_LOG_INFO("begin");
+    lv_obj_t * obj = lv_obj_class_create_obj(MY_CLASS, parent);
+    lv_obj_class_init_obj(obj);
+    return obj;
+}
+
+/*=====================
+ * Setter functions
+ *====================*/
+
+void lv_vlist_set_cb(lv_obj_t * obj, lv_vlist_create_cb_t create_cb, lv_vlist_bind_cb_t bind_cb,
+                     lv_vlist_height_cb_t height_cb)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    vlist->create_cb = create_cb;
+    vlist->bind_cb = bind_cb;
+    vlist->height_cb = height_cb;
+
+    lv_vlist_refresh(obj);
+}
+
+void lv_vlist_set_row_cnt(lv_obj_t * obj, uint32_t cnt)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    uint32_t old_cnt = vlist->row_cnt;
+    if(cnt == old_cnt) return;
+
+    heights_resize(vlist, cnt);
+    vlist->row_cnt = cnt;
+
+    if(vlist->top_id >= cnt) {
+        vlist->top_id = cnt ? cnt - 1 : 0;
+        vlist->top_ofs = 0;
+    }
+
+    if(cnt > old_cnt) heights_query(obj, old_cnt);
+
+    rows_update(obj);
+}
+
+void lv_vlist_set_overscan(lv_obj_t * obj, lv_coord_t overscan)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    vlist->overscan = LV_MAX(overscan, 0);
+    rows_update(obj);
+}
+
+/*=====================
+ * Getter functions
+ *====================*/
+
+uint32_t lv_vlist_get_row_cnt(lv_obj_t * obj)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    return vlist->row_cnt;
+}
+
+lv_obj_t * lv_vlist_get_row_obj(lv_obj_t * obj, uint32_t id)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    if(id >= vlist->row_cnt) return NULL;
+
+    int32_t p = pool_find(vlist, id);
+    return p < 0 ? NULL : vlist->pool[p];
+}
+
+uint32_t lv_vlist_get_row_id(lv_obj_t * obj, const lv_obj_t * row_obj)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    int32_t p = pool_find_obj(vlist, row_obj);
+    return p < 0 ? LV_VLIST_ROW_NONE : vlist->pool_id[p];
+}
+
+/*=====================
+ * Other functions
+ *====================*/
+
+void lv_vlist_refresh_row(lv_obj_t * obj, uint32_t id)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    if(id >= vlist->row_cnt) return;
+
+    int32_t p = pool_find(vlist, id);
+    if(p >= 0) {
+        if(vlist->bind_cb) vlist->bind_cb(obj, vlist->pool[p], id);
+        lv_obj_update_layout(obj);
+    }
+    else {
+        lv_coord_t h = vlist->height_cb ? vlist->height_cb(obj, id) : LV_VLIST_HEIGHT_UNKNOWN;
+        height_set(vlist, id, h < 0 ? H_NONE : (uint16_t)h);
+    }
+
+    rows_update(obj);
+}
+
+void lv_vlist_refresh(lv_obj_t * obj)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    heights_reset(obj);
+
+    uint32_t p;
+    for(p = 0; p < vlist->pool_cnt; p++) {
+        if(vlist->pool_id[p] == LV_VLIST_ROW_NONE) continue;
+        if(vlist->bind_cb) vlist->bind_cb(obj, vlist->pool[p], vlist->pool_id[p]);
+    }
+    lv_obj_update_layout(obj);
+
+    rows_update(obj);
+}
+
+void lv_vlist_scroll_to_row(lv_obj_t * obj, uint32_t id, lv_anim_enable_t anim_en)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    if(vlist->row_cnt == 0) return;
+    if(id >= vlist->row_cnt) id = vlist->row_cnt - 1;
+
+    /*Only the scrolled window can be animated, so jump if the row is out of it*/
+    if(anim_en == LV_ANIM_ON) {
+        int32_t y = row_y(vlist, id) - vlist->base;
+        int32_t total = total_h(vlist);
+        int32_t win_h = LV_MIN(total - vlist->base, WIN_MAX);
+        int32_t view_h = lv_obj_get_content_height(obj);
+        if(y >= 0 && (y + view_h <= win_h || vlist->base + win_h >= total)) {
+            lv_obj_scroll_to_y(obj, (lv_coord_t)y, LV_ANIM_ON);
+            return;
+        }
+    }
+
+    /*Stop a running scroll animation*/
+    lv_obj_scroll_to_y(obj, lv_obj_get_scroll_y(obj), LV_ANIM_OFF);
+
+    vlist->top_id = id;
+    vlist->top_ofs = 0;
+    vlist->follow = 0;
+    rows_update(obj);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void lv_vlist_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
+{
+    LV_UNUSED(class_p);
+    LV_TRACE_OBJ_CREATE("begin");
+
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+    vlist->est_h = LV_DPI_DEF / 3;
+    vlist->overscan = LV_DPI_DEF / 2;
+    vlist->follow = 1;
+
+    /*The scrollbar is moved to show the whole list (see `LV_EVENT_DRAW_PART_BEGIN`)*/
+    lv_obj_set_scroll_dir(obj, LV_DIR_VER);
+
+    LV_TRACE_OBJ_CREATE("finished");
+}
+
+static void lv_vlist_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
+{
+    LV_UNUSED(class_p);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    heights_resize(vlist, 0);
+    lv_mem_free(vlist->pool);
+    lv_mem_free(vlist->pool_id);
+    vlist->pool = NULL;
+    vlist->pool_id = NULL;
+    vlist->pool_cnt = 0;
+}
+
+static void lv_vlist_event(const lv_obj_class_t * class_p, lv_event_t * e)
+{
+    LV_UNUSED(class_p);
+
+    /*Call the ancestor's event handler*/
+    if(lv_obj_event_base(MY_CLASS, e) != LV_RES_OK) return;
+
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    if(code == LV_EVENT_GET_SELF_SIZE) {
+        lv_point_t * p = lv_event_get_param(e);
+        int32_t h = LV_MIN(total_h(vlist) - vlist->base, WIN_MAX);
+        p->y = LV_MAX(p->y, h);
+    }
+    else if(code == LV_EVENT_SCROLL) {
+        if(vlist->busy) return;
+        int32_t y = vlist->base + lv_obj_get_scroll_y(obj);
+        anchor_set(vlist, y);
+        vlist->follow = y >= total_h(vlist) - lv_obj_get_content_height(obj);
+        rows_update(obj);
+    }
+    else if(code == LV_EVENT_SCROLL_END || code == LV_EVENT_STYLE_CHANGED) {
+        rows_update(obj);
+    }
+    else if(code == LV_EVENT_CHILD_CHANGED) {
+        /*A shown row might have changed its height*/
+        int32_t p = pool_find_obj(vlist, lv_event_get_param(e));
+        if(p < 0) return;
+        uint32_t id = vlist->pool_id[p];
+        if(id == LV_VLIST_ROW_NONE || id >= vlist->row_cnt) return;
+        if(lv_obj_get_height(vlist->pool[p]) != height_get(vlist, id)) rows_update(obj);
+    }
+    else if(code == LV_EVENT_SIZE_CHANGED) {
+        /*The rows might wrap differently so measure them again*/
+        const lv_area_t * ori = lv_event_get_param(e);
+        if(lv_area_get_width(ori) != lv_obj_get_width(obj)) heights_reset(obj);
+        rows_update(obj);
+    }
+    else if(code == LV_EVENT_DRAW_PART_BEGIN) {
+        lv_obj_draw_part_dsc_t * dsc = lv_event_get_draw_part_dsc(e);
+        if(dsc->part == LV_PART_SCROLLBAR && dsc->draw_area) scrollbar_area(obj, dsc->draw_area);
+    }
+}
+
+/**
+ * Place the view where the anchor row is, and show the rows around it.
+ * Measuring the new rows changes the estimated height of the others, so repeat till it settles.
+ * @param obj pointer to a list object
+ */
+static void rows_update(lv_obj_t * obj)
+{
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    if(vlist->busy) {
+        vlist->dirty = 1;
+        return;
+    }
+    vlist->busy = 1;
+
+    uint32_t i;
+    for(i = 0; i < UPDATE_MAX; i++) {
+        vlist->dirty = 0;
+        int32_t y = view_restore(obj);
+        window_fill(obj, y);
+        if(vlist->dirty == 0) break;
+    }
+
+    vlist->busy = 0;
+
+    int32_t total = total_h(vlist);
+    if(total != vlist->total) {
+        vlist->total = total;
+        lv_obj_refresh_self_size(obj);
+        scrollbar_invalidate(obj);
+    }
+}
+
+/**
+ * Scroll to the anchor, moving the window of scrolled content if it's near its edge
+ * @param obj pointer to a list object
+ * @return    the top of the view in the list
+ */
+static int32_t view_restore(lv_obj_t * obj)
+{
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    int32_t total = total_h(vlist);
+    int32_t view_h = lv_obj_get_content_height(obj);
+    int32_t max_y = LV_MAX(total - view_h, 0);
+    bool scrolling = lv_obj_is_scrolling(obj);
+
+    int32_t y;
+    if(vlist->follow && !scrolling) {
+        y = max_y;
+    }
+    else {
+        y = row_y(vlist, vlist->top_id) + vlist->top_ofs;
+        /*Keep the elastic scroll while dragged*/
+        if(!scrolling) {
+            y = LV_CLAMP(0, y, max_y);
+            if(y == max_y) vlist->follow = 1;
+        }
+    }
+    anchor_set(vlist, y);
+
+    int32_t margin = view_h / 2 + vlist->overscan;
+    int32_t base = vlist->base;
+    int32_t win_h = LV_MIN(total - base, WIN_MAX);
+    bool top_ok = base == 0 || y - base >= margin;
+    bool bottom_ok = base + win_h >= total || y - base + view_h <= win_h - margin;
+
+    /*A scroll animation works with the scroll position in the window so don't move it then*/
+    if((!top_ok || !bottom_ok) && lv_anim_get(obj, NULL) == NULL) {
+        base = y - (WIN_MAX - view_h) / 2;
+        base = LV_CLAMP(0, base, LV_MAX(total - WIN_MAX, 0));
+        if(base != vlist->base) {
+            vlist->base = base;
+            lv_obj_refresh_self_size(obj);
+        }
+    }
+
+    int32_t scroll_y = y - vlist->base;
+    scroll_y = LV_CLAMP(LV_COORD_MIN, scroll_y, LV_COORD_MAX);
+    lv_coord_t scroll_y_ori = lv_obj_get_scroll_y(obj);
+    if(scroll_y != scroll_y_ori) _lv_obj_scroll_by_raw(obj, 0, (lv_coord_t)(scroll_y_ori - scroll_y));
+
+    return y;
+}
+
+/**
+ * Show the rows in and around the view, bind the new ones and measure them
+ * @param obj   pointer to a list object
+ * @param y     the top of the view in the list
+ */
+static void window_fill(lv_obj_t * obj, int32_t y)
+{
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    uint32_t first = 0;
+    uint32_t last = 0;
+    bool any = vlist->row_cnt > 0;
+    if(any) {
+        int32_t view_h = lv_obj_get_content_height(obj);
+        int32_t hi = y + view_h + vlist->overscan;
+        int32_t ofs;
+        int32_t est = est_h(vlist);
+        lv_coord_t pad_row = lv_obj_get_style_pad_row(obj, LV_PART_MAIN);
+
+        first = row_at(vlist, LV_MAX(y - vlist->overscan, 0), &ofs);
+        int32_t row_end = row_y(vlist, first);
+        last = first;
+        while(1) {
+            uint16_t h = height_get(vlist, last);
+            row_end += (h == H_NONE ? est : h) + pad_row;
+            if(row_end >= hi || last + 1 >= vlist->row_cnt) break;
+            last++;
+        }
+    }
+
+    /*Free the rows that went out*/
+    uint32_t p;
+    for(p = 0; p < vlist->pool_cnt; p++) {
+        uint32_t id = vlist->pool_id[p];
+        if(id == LV_VLIST_ROW_NONE) continue;
+        if(any && id >= first && id <= last) continue;
+        vlist->pool_id[p] = LV_VLIST_ROW_NONE;
+        lv_obj_add_flag(vlist->pool[p], LV_OBJ_FLAG_HIDDEN);
+    }
+
+    if(!any) return;
+
+    /*Show the new ones in the free rows, or in new ones*/
+    bool bound = false;
+    uint32_t id;
+    for(id = first; id <= last; id++) {
+        if(pool_find(vlist, id) >= 0) continue;
+
+        for(p = 0; p < vlist->pool_cnt; p++) {
+            if(vlist->pool_id[p] == LV_VLIST_ROW_NONE) break;
+        }
+
+        if(p == vlist->pool_cnt) {
+            lv_obj_t * row;
+            if(vlist->create_cb) {
+                row = vlist->create_cb(obj);
+            }
+            else {
+                row = lv_obj_create(obj);
+                lv_obj_set_size(row, lv_pct(100), LV_SIZE_CONTENT);
+            }
+
+            lv_obj_t ** pool = lv_mem_realloc(vlist->pool, (p + 1) * sizeof(lv_obj_t *));
+            LV_ASSERT_MALLOC(pool);
+            if(pool == NULL) return;
+            vlist->pool = pool;
+            uint32_t * pool_id = lv_mem_realloc(vlist->pool_id, (p + 1) * sizeof(uint32_t));
+            LV_ASSERT_MALLOC(pool_id);
+            if(pool_id == NULL) return;
+            vlist->pool_id = pool_id;
+
+            vlist->pool[p] = row;
+            vlist->pool_cnt++;
+        }
+
+        vlist->pool_id[p] = id;
+        lv_obj_clear_flag(vlist->pool[p], LV_OBJ_FLAG_HIDDEN);
+        if(vlist->bind_cb) vlist->bind_cb(obj, vlist->pool[p], id);
+        bound = true;
+    }
+
+    if(bound) lv_obj_update_layout(obj);
+
+    /*Measure the rows and place them*/
+    for(p = 0; p < vlist->pool_cnt; p++) {
+        id = vlist->pool_id[p];
+        if(id == LV_VLIST_ROW_NONE) continue;
+        lv_coord_t h = lv_obj_get_height(vlist->pool[p]);
+        if(h != height_get(vlist, id)) {
+            height_set(vlist, id, (uint16_t)h);
+            vlist->dirty = 1;
+        }
+    }
+
+    if(vlist->dirty) return;
+
+    for(p = 0; p < vlist->pool_cnt; p++) {
+        id = vlist->pool_id[p];
+        if(id == LV_VLIST_ROW_NONE) continue;
+        lv_coord_t row_y_local = (lv_coord_t)(row_y(vlist, id) - vlist->base);
+        lv_obj_t * row = vlist->pool[p];
+        if(lv_obj_get_style_y(row, LV_PART_MAIN) != row_y_local) {
+            lv_obj_set_y(row, row_y_local);
+            lv_obj_refr_pos(row);
+        }
+    }
+}
+
+/**
+ * Set the scrollbar's place from the whole list instead of the scrolled window
+ * @param obj   pointer to a list object
+ * @param area  the area of the vertical scrollbar set by `lv_obj_get_scrollbar_area()`
+ */
+static void scrollbar_area(lv_obj_t * obj, lv_area_t * area)
+{
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    lv_coord_t top_space = lv_obj_get_style_pad_top(obj, LV_PART_SCROLLBAR);
+    lv_coord_t bottom_space = lv_obj_get_style_pad_bottom(obj, LV_PART_SCROLLBAR);
+    int32_t obj_h = lv_obj_get_height(obj);
+    int32_t view_h = lv_obj_get_content_height(obj);
+
+    int32_t st = vlist->base + lv_obj_get_scroll_y(obj);
+    int32_t sb = total_h(vlist) - view_h - st;
+    int32_t content_h = obj_h + st + sb;
+    int32_t scroll_h = content_h - obj_h;
+    if(scroll_h <= 0) return;
+
+    int32_t track_h = obj_h - top_space - bottom_space;
+    int32_t sb_h = (track_h * obj_h) / content_h;
+    sb_h = LV_MAX(sb_h, SCROLLBAR_MIN_SIZE);
+    int32_t rem = track_h - sb_h;
+    int32_t sb_y = rem - (int32_t)(((int64_t)rem * sb) / scroll_h);
+
+    area->y1 = obj->coords.y1 + sb_y + top_space;
+    area->y2 = area->y1 + sb_h - 1;
+    if(area->y1 < obj->coords.y1 + top_space) {
+        area->y1 = obj->coords.y1 + top_space;
+        if(area->y1 + SCROLLBAR_MIN_SIZE > area->y2) {
+            area->y2 = area->y1 + SCROLLBAR_MIN_SIZE;
+        }
+    }
+    if(area->y2 > obj->coords.y2 - bottom_space) {
+        area->y2 = obj->coords.y2 - bottom_space;
+        if(area->y2 - SCROLLBAR_MIN_SIZE < area->y1) {
+            area->y1 = area->y2 - SCROLLBAR_MIN_SIZE;
+        }
+    }
+}
+
+/**
+ * Invalidate the whole height of the scrollbar as its place doesn't come from the scrolled window
+ * @param obj pointer to a list object
+ */
+static void scrollbar_invalidate(lv_obj_t * obj)
+{
+    lv_area_t hor_area;
+    lv_area_t ver_area;
+    lv_obj_get_scrollbar_area(obj, &hor_area, &ver_area);
+    if(lv_area_get_size(&ver_area) <= 0) return;
+
+    ver_area.y1 = obj->coords.y1;
+    ver_area.y2 = obj->coords.y2;
+    lv_obj_invalidate_area(obj, &ver_area);
+}
+
+/**
+ * Remember the top of the view as a row and an offset in it,
+ * so it stays in place while the height of the rows above it is learned
+ * @param vlist pointer to a list object
+ * @param y     the top of the view in the list
+ */
+static void anchor_set(lv_vlist_t * vlist, int32_t y)
+{
+    vlist->top_id = row_at(vlist, y, &vlist->top_ofs);
+}
+
+/**
+ * Get where a row starts in the list
+ * @param vlist pointer to a list object
+ * @param id    index of a row
+ * @return      the y coordinate of the row, with the estimated height of the unknown rows
+ */
+static int32_t row_y(lv_vlist_t * vlist, uint32_t id)
+{
+    if(id >= vlist->row_cnt) return total_h(vlist);
+
+    int32_t est = est_h(vlist);
+    lv_coord_t pad_row = lv_obj_get_style_pad_row((lv_obj_t *)vlist, LV_PART_MAIN);
+    int32_t y = (int32_t)id * pad_row;
+
+    uint32_t c_id = id / CHUNK;
+    uint32_t c;
+    for(c = 0; c < c_id; c++) {
+        _lv_vlist_chunk_t * chunk = &vlist->chunks[c];
+        y += chunk->h_sum + (CHUNK - chunk->known_cnt) * est;
+    }
+
+    _lv_vlist_chunk_t * chunk = &vlist->chunks[c_id];
+    uint32_t j_end = id % CHUNK;
+    if(chunk->h == NULL) {
+        uint32_t known = LV_MIN(j_end, chunk->known_cnt);
+        y += (int32_t)known * chunk->same_h + (int32_t)(j_end - known) * est;
+    }
+    else {
+        uint32_t j;
+        for(j = 0; j < j_end; j++) y += chunk->h[j] == H_NONE ? est : chunk->h[j];
+    }
+
+    return y;
+}
+
+/**
+ * Get the row at a y coordinate
+ * @param vlist pointer to a list object
+ * @param y     a y coordinate in the list
+ * @param ofs   store how far `y` is from the top of the row. Out of the list it's measured from the first or last row.
+ * @return      index of the row
+ */
+static uint32_t row_at(lv_vlist_t * vlist, int32_t y, int32_t * ofs)
+{
+    *ofs = y;
+    if(vlist->row_cnt == 0 || y <= 0) return 0;
+
+    int32_t est = est_h(vlist);
+    lv_coord_t pad_row = lv_obj_get_style_pad_row((lv_obj_t *)vlist, LV_PART_MAIN);
+    uint32_t c_cnt = (vlist->row_cnt + CHUNK - 1) / CHUNK;
+
+    /*Find the chunk*/
+    int32_t chunk_y = 0;
+    uint32_t c;
+    for(c = 0; c < c_cnt - 1; c++) {
+        _lv_vlist_chunk_t * chunk = &vlist->chunks[c];
+        int32_t h = chunk->h_sum + (CHUNK - chunk->known_cnt) * est + CHUNK * pad_row;
+        if(chunk_y + h > y) break;
+        chunk_y += h;
+    }
+
+    /*Find the row in it*/
+    uint32_t id = c * CHUNK;
+    while(id + 1 < vlist->row_cnt) {
+        uint16_t h = height_get(vlist, id);
+        int32_t h_full = (h == H_NONE ? est : h) + pad_row;
+        if(chunk_y + h_full > y) break;
+        chunk_y += h_full;
+        id++;
+    }
+
+    *ofs = y - chunk_y;
+    return id;
+}
+
+static int32_t total_h(lv_vlist_t * vlist)
+{
+    if(vlist->row_cnt == 0) return 0;
+
+    lv_coord_t pad_row = lv_obj_get_style_pad_row((lv_obj_t *)vlist, LV_PART_MAIN);
+    return (int32_t)vlist->known_sum + (int32_t)(vlist->row_cnt - vlist->known_cnt) * est_h(vlist) +
+           (int32_t)(vlist->row_cnt - 1) * pad_row;
+}
+
+/**
+ * Get the estimated height of the rows not measured yet
+ * @param vlist pointer to a list object
+ * @return      the average of the known heights
+ */
+static int32_t est_h(lv_vlist_t * vlist)
+{
+    if(vlist->known_cnt == 0) return vlist->est_h;
+    return (int32_t)(vlist->known_sum / vlist->known_cnt);
+}
+
+static uint16_t height_get(lv_vlist_t * vlist, uint32_t id)
+{
+    _lv_vlist_chunk_t * chunk = &vlist->chunks[id / CHUNK];
+    uint32_t j = id % CHUNK;
+    if(chunk->h == NULL) return j < chunk->known_cnt ? chunk->same_h : H_NONE;
+    else return chunk->h[j];
+}
+
+/**
+ * Set the height of a row. Rows of the same height from the start of a chunk don't need the height array.
+ * @param vlist pointer to a list object
+ * @param id    index of a row
+ * @param h     the height or `H_NONE` to forget it
+ */
+static void height_set(lv_vlist_t * vlist, uint32_t id, uint16_t h)
+{
+    _lv_vlist_chunk_t * chunk = &vlist->chunks[id / CHUNK];
+    uint32_t j = id % CHUNK;
+
+    if(chunk->h == NULL) {
+        if(h == H_NONE) {
+            if(j >= chunk->known_cnt) return;
+            if(j == chunk->known_cnt - 1U) {
+                chunk->known_cnt--;
+                chunk->h_sum -= chunk->same_h;
+                vlist->known_cnt--;
+                vlist->known_sum -= chunk->same_h;
+                return;
+            }
+        }
+        else {
+            if(j < chunk->known_cnt && h == chunk->same_h) return;
+            if(j == chunk->known_cnt && (chunk->known_cnt == 0 || h == chunk->same_h)) {
+                chunk->same_h = h;
+                chunk->known_cnt++;
+                chunk->h_sum += h;
+                vlist->known_cnt++;
+                vlist->known_sum += h;
+                return;
+            }
+        }
+
+        chunk->h = lv_mem_alloc(CHUNK * sizeof(uint16_t));
+        LV_ASSERT_MALLOC(chunk->h);
+        if(chunk->h == NULL) return;
+        uint32_t k;
+        for(k = 0; k < CHUNK; k++) chunk->h[k] = k < chunk->known_cnt ? chunk->same_h : H_NONE;
+    }
+
+    uint16_t h_ori = chunk->h[j];
+    if(h_ori == h) return;
+    if(h_ori != H_NONE) {
+        chunk->known_cnt--;
+        chunk->h_sum -= h_ori;
+        vlist->known_cnt--;
+        vlist->known_sum -= h_ori;
+    }
+    if(h != H_NONE) {
+        chunk->known_cnt++;
+        chunk->h_sum += h;
+        vlist->known_cnt++;
+        vlist->known_sum += h;
+    }
+    chunk->h[j] = h;
+}
+
+/**
+ * Allocate or free the chunks for a new number of rows
+ * @param vlist pointer to a list object
+ * @param cnt   the new number of rows
+ */
+static void heights_resize(lv_vlist_t * vlist, uint32_t cnt)
+{
+    uint32_t c_cnt_ori = (vlist->row_cnt + CHUNK - 1) / CHUNK;
+    uint32_t c_cnt = (cnt + CHUNK - 1) / CHUNK;
+
+    /*Forget the removed rows of the last chunk*/
+    if(cnt < vlist->row_cnt && cnt % CHUNK) {
+        uint32_t id = LV_MIN(vlist->row_cnt, c_cnt * CHUNK);
+        while(id > cnt) {
+            id--;
+            height_set(vlist, id, H_NONE);
+        }
+    }
+
+    uint32_t c;
+    for(c = c_cnt; c < c_cnt_ori; c++) {
+        _lv_vlist_chunk_t * chunk = &vlist->chunks[c];
+        vlist->known_cnt -= chunk->known_cnt;
+        vlist->known_sum -= chunk->h_sum;
+        lv_mem_free(chunk->h);
+    }
+
+    if(c_cnt == c_cnt_ori) return;
+
+    if(c_cnt == 0) {
+        lv_mem_free(vlist->chunks);
+        vlist->chunks = NULL;
+        return;
+    }
+
+    _lv_vlist_chunk_t * chunks = lv_mem_realloc(vlist->chunks, c_cnt * sizeof(_lv_vlist_chunk_t));
+    LV_ASSERT_MALLOC(chunks);
+    if(chunks == NULL) return;
+    vlist->chunks = chunks;
+    if(c_cnt > c_cnt_ori) lv_memset_00(&chunks[c_cnt_ori], (c_cnt - c_cnt_ori) * sizeof(_lv_vlist_chunk_t));
+}
+
+/**
+ * Forget the height of all rows and ask the height callback again
+ * @param obj pointer to a list object
+ */
+static void heights_reset(lv_obj_t * obj)
+{
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+
+    uint32_t c_cnt = (vlist->row_cnt + CHUNK - 1) / CHUNK;
+    uint32_t c;
+    for(c = 0; c < c_cnt; c++) {
+        lv_mem_free(vlist->chunks[c].h);
+        lv_memset_00(&vlist->chunks[c], sizeof(_lv_vlist_chunk_t));
+    }
+    vlist->known_cnt = 0;
+    vlist->known_sum = 0;
+
+    heights_query(obj, 0);
+}
+
+/**
+ * Ask the height callback the height of the rows
+ * @param obj   pointer to a list object
+ * @param from  index of the first row to ask
+ */
+static void heights_query(lv_obj_t * obj, uint32_t from)
+{
+    lv_vlist_t * vlist = (lv_vlist_t *)obj;
+    if(vlist->height_cb == NULL) return;
+
+    uint32_t id;
+    for(id = from; id < vlist->row_cnt; id++) {
+        lv_coord_t h = vlist->height_cb(obj, id);
+        if(h >= 0) height_set(vlist, id, (uint16_t)h);
+    }
+}
+
+static int32_t pool_find(lv_vlist_t * vlist, uint32_t id)
+{
+    uint32_t p;
+    for(p = 0; p < vlist->pool_cnt; p++) {
+        if(vlist->pool_id[p] == id) return p;
+    }
+
+    return -1;
+}
+
+static int32_t pool_find_obj(lv_vlist_t * vlist, const lv_obj_t * row_obj)
+{
+    uint32_t p;
+    for(p = 0; p < vlist->pool_cnt; p++) {
+        if(vlist->pool[p] == row_obj) return p;
+    }
+
+    return -1;
+}
+
+#endif /*LV_USE_VLIST*/
@@ -0,0 +1,196 @@
+/**
+ * @file lv_vlist.h
+ *
+ */
+
+#ifndef LV_VLIST_H
+#define LV_VLIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../../core/lv_obj.h"
+
+#if LV_USE_VLIST
+
+/*********************
+ *      DEFINES
+ *********************/
+/*A height callback's return value: measure the row when it's shown*/
+#define LV_VLIST_HEIGHT_UNKNOWN     (-1)
+
+/*No row*/
+#define LV_VLIST_ROW_NONE           0xFFFFFFFF
+
+/*Rows in a `_lv_vlist_chunk_t`*/
+#define _LV_VLIST_CHUNK_ROWS        64
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**
+ * Create an object for the rows. The list keeps it and binds it to other rows as it scrolls.
+ * @param vlist     pointer to the list, the parent of the new object
+ * @return          the new object
+ */
+typedef lv_obj_t * (*lv_vlist_create_cb_t)(lv_obj_t * vlist);
+
+/**
+ * Show a row in an object made by the create callback. Its size is measured after it.
+ * @param vlist     pointer to the list
+ * @param row_obj   the object to show the row in
+ * @param id        index of the row
+ */
+typedef void (*lv_vlist_bind_cb_t)(lv_obj_t * vlist, lv_obj_t * row_obj, uint32_t id);
+
+/**
+ * Tell the height of a row without showing it
+ * @param vlist     pointer to the list
+ * @param id        index of the row
+ * @return          the height, or `LV_VLIST_HEIGHT_UNKNOWN` to measure it when it's shown
+ */
+typedef lv_coord_t (*lv_vlist_height_cb_t)(lv_obj_t * vlist, uint32_t id);
+
+/*The heights of `_LV_VLIST_CHUNK_ROWS` rows*/
+typedef struct {
+    uint16_t * h;           /**< The height of each row, 0xFFFF if not known. NULL: the first `known_cnt` are `same_h`*/
+    uint32_t h_sum;         /**< The sum of the known heights*/
+    uint16_t known_cnt;     /**< The number of rows with known height*/
+    uint16_t same_h;
+} _lv_vlist_chunk_t;
+
+/*Data of virtualized list*/
+typedef struct {
+    lv_obj_t obj;
+    lv_vlist_create_cb_t create_cb;
+    lv_vlist_bind_cb_t bind_cb;
+    lv_vlist_height_cb_t height_cb;
+    _lv_vlist_chunk_t * chunks;
+    uint32_t row_cnt;
+    uint32_t known_cnt;         /**< The number of rows with known height*/
+    uint32_t known_sum;         /**< The sum of their heights*/
+    lv_coord_t est_h;           /**< The height of the unknown rows while no row is known*/
+    lv_coord_t overscan;        /**< Rows are shown this far above and below the view*/
+    int32_t total;              /**< The height of all rows, as last shown*/
+    int32_t base;               /**< Where the scrolled content starts in the list*/
+    uint32_t top_id;            /**< The row at the top of the view...*/
+    int32_t top_ofs;            /**< ...and how much of it is scrolled out*/
+    lv_obj_t ** pool;           /**< The row objects*/
+    uint32_t * pool_id;         /**< The row each one shows, `LV_VLIST_ROW_NONE` if it's free*/
+    uint16_t pool_cnt;
+    uint8_t follow : 1;         /**< Stay at the bottom as rows are added*/
+    uint8_t busy : 1;           /**< The rows are being updated*/
+    uint8_t dirty : 1;          /**< A height changed while they were*/
+} lv_vlist_t;
+
+extern const lv_obj_class_t lv_vlist_class;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Create a virtualized list: only the rows in view, and `overscan` around them, have objects
+ * @param parent    pointer to an object, it will be the parent of the new list
+ * @return          pointer to the created list
+ */
+lv_obj_t * lv_vlist_create(lv_obj_t * parent);
+
+/*=====================
+ * Setter functions
+ *====================*/
+
+/**
+ * Set the callbacks giving the rows
+ * @param obj           pointer to a list object
+ * @param create_cb     creates the row objects
+ * @param bind_cb       shows a row in one of them
+ * @param height_cb     tells the height of a row without showing it. NULL: the rows are measured
+ *                      when they are shown and estimated till then
+ */
+void lv_vlist_set_cb(lv_obj_t * obj, lv_vlist_create_cb_t create_cb, lv_vlist_bind_cb_t bind_cb,
+                     lv_vlist_height_cb_t height_cb);
+
+/**
+ * Set the number of rows. Rows can be added and removed at the end.
+ * While the list is scrolled to the bottom it stays there.
+ * @param obj       pointer to a list object
+ * @param cnt       the number of rows
+ */
+void lv_vlist_set_row_cnt(lv_obj_t * obj, uint32_t cnt);
+
+/**
+ * Set how far around the view the rows are shown
+ * @param obj       pointer to a list object
+ * @param overscan  the distance in pixels
+ */
+void lv_vlist_set_overscan(lv_obj_t * obj, lv_coord_t overscan);
+
+/*=====================
+ * Getter functions
+ *====================*/
+
+/**
+ * Get the number of rows
+ * @param obj       pointer to a list object
+ * @return          the number of rows
+ */
+uint32_t lv_vlist_get_row_cnt(lv_obj_t * obj);
+
+/**
+ * Get the object showing a row
+ * @param obj       pointer to a list object
+ * @param id        index of a row
+ * @return          the object, or NULL if the row isn't shown
+ */
+lv_obj_t * lv_vlist_get_row_obj(lv_obj_t * obj, uint32_t id);
+
+/**
+ * Get the row an object shows, e.g. in its click event
+ * @param obj       pointer to a list object
+ * @param row_obj   one of its row objects
+ * @return          index of the row, or `LV_VLIST_ROW_NONE`
+ */
+uint32_t lv_vlist_get_row_id(lv_obj_t * obj, const lv_obj_t * row_obj);
+
+/*=====================
+ * Other functions
+ *====================*/
+
+/**
+ * Bind a row again because its content changed, and measure it again
+ * @param obj       pointer to a list object
+ * @param id        index of the row
+ */
+void lv_vlist_refresh_row(lv_obj_t * obj, uint32_t id);
+
+/**
+ * Bind and measure all the rows again, e.g. if they were all replaced
+ * @param obj       pointer to a list object
+ */
+void lv_vlist_refresh(lv_obj_t * obj);
+
+/**
+ * Scroll a row to the top of the list
+ * @param obj       pointer to a list object
+ * @param id        index of the row
+ * @param anim_en   LV_ANIM_ON: scroll with animation if the row is near; LV_ANIM_OFF: jump there
+ */
+void lv_vlist_scroll_to_row(lv_obj_t * obj, uint32_t id, lv_anim_enable_t anim_en);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_VLIST*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_VLIST_H*/
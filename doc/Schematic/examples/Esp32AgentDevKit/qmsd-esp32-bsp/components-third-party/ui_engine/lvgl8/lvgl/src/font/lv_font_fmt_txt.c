@@ -50,14 +50,20 @@ static int32_t kern_pair_16_compare(const void * ref, const void * element);
  *  STATIC VARIABLES
  **********************/
 #if LV_USE_FONT_COMPRESSED
-    static uint32_t rle_rdp;
-    static const uint8_t * rle_in;
-    static uint8_t rle_bpp;
-    static uint8_t rle_prev_v;
-    static uint8_t rle_cnt;
-    static rle_state_t rle_state;
+    static LV_DRAW_LOCAL uint32_t rle_rdp;
+    static LV_DRAW_LOCAL const uint8_t * rle_in;
+    static LV_DRAW_LOCAL uint8_t rle_bpp;
+    static LV_DRAW_LOCAL uint8_t rle_prev_v;
+    static LV_DRAW_LOCAL uint8_t rle_cnt;
+    static LV_DRAW_LOCAL rle_state_t rle_state;
 #endif /*LV_USE_FONT_COMPRESSED*/
 
+#if LV_USE_REFR_PARALLEL
+    /*The render threads would race on the letter and id in `fdsc->cache`, each keeps its own last letter*/
+    static LV_DRAW_LOCAL const lv_font_fmt_txt_dsc_t * glyph_cache_fdsc;
+    static LV_DRAW_LOCAL lv_font_fmt_txt_glyph_cache_t glyph_cache;
+#endif /*LV_USE_REFR_PARALLEL*/
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -92,8 +98,8 @@ const uint8_t * lv_font_get_bitmap_fmt_txt(const lv_font_t * font, uint32_t unic
     /*Handle compressed bitmap*/
     else {
 #if LV_USE_FONT_COMPRESSED
-        static size_t last_buf_size = 0;
-        if(LV_GC_ROOT(_lv_font_decompr_buf) == NULL) last_buf_size = 0;
+        static LV_DRAW_LOCAL size_t last_buf_size = 0;
+        if(LV_GC_DRAW_ROOT(_lv_font_decompr_buf) == NULL) last_buf_size = 0;
 
         uint32_t gsize = gdsc->box_w * gdsc->box_h;
         if(gsize == 0) return NULL;
@@ -116,17 +122,17 @@ const uint8_t * lv_font_get_bitmap_fmt_txt(const lv_font_t * font, uint32_t unic
         }
 
         if(last_buf_size < buf_size) {
-            uint8_t * tmp = lv_mem_realloc(LV_GC_ROOT(_lv_font_decompr_buf), buf_size);
+            uint8_t * tmp = lv_mem_realloc(LV_GC_DRAW_ROOT(_lv_font_decompr_buf), buf_size);
             LV_ASSERT_MALLOC(tmp);
             if(tmp == NULL) return NULL;
-            LV_GC_ROOT(_lv_font_decompr_buf) = tmp;
+            LV_GC_DRAW_ROOT(_lv_font_decompr_buf) = tmp;
             last_buf_size = buf_size;
         }
 
         bool prefilter = fdsc->bitmap_format == LV_FONT_FMT_TXT_COMPRESSED ? true : false;
-        decompress(&fdsc->glyph_bitmap[gdsc->bitmap_index], LV_GC_ROOT(_lv_font_decompr_buf), gdsc->box_w, gdsc->box_h,
+        decompress(&fdsc->glyph_bitmap[gdsc->bitmap_index], LV_GC_DRAW_ROOT(_lv_font_decompr_buf), gdsc->box_w, gdsc->box_h,
                    (uint8_t)fdsc->bpp, prefilter);
-        return LV_GC_ROOT(_lv_font_decompr_buf);
+        return LV_GC_DRAW_ROOT(_lv_font_decompr_buf);
 #else /*!LV_USE_FONT_COMPRESSED*/
         LV_LOG_WARN("Compressed fonts is used but LV_USE_FONT_COMPRESSED is not enabled in lv_conf.h");
         return NULL;
@@ -195,9 +201,9 @@ bool lv_font_get_glyph_dsc_fmt_txt(const lv_font_t * font, lv_font_glyph_dsc_t *
 void _lv_font_clean_up_fmt_txt(void)
 {
 #if LV_USE_FONT_COMPRESSED
-    if(LV_GC_ROOT(_lv_font_decompr_buf)) {
-        lv_mem_free(LV_GC_ROOT(_lv_font_decompr_buf));
-        LV_GC_ROOT(_lv_font_decompr_buf) = NULL;
+    if(LV_GC_DRAW_ROOT(_lv_font_decompr_buf)) {
+        lv_mem_free(LV_GC_DRAW_ROOT(_lv_font_decompr_buf));
+        LV_GC_DRAW_ROOT(_lv_font_decompr_buf) = NULL;
     }
 #endif
 }
@@ -212,8 +218,19 @@ static uint32_t get_glyph_dsc_id(const lv_font_t * font, uint32_t letter)
 
     lv_font_fmt_txt_dsc_t * fdsc = (lv_font_fmt_txt_dsc_t *)font->dsc;
 
+    lv_font_fmt_txt_glyph_cache_t * cache = fdsc->cache;
+#if LV_USE_REFR_PARALLEL
+    if(cache) {
+        cache = &glyph_cache;
+        if(glyph_cache_fdsc != fdsc) {
+            glyph_cache_fdsc = fdsc;
+            glyph_cache.last_letter = 0;    /*Never looked up, '\0' returns above*/
+        }
+    }
+#endif /*LV_USE_REFR_PARALLEL*/
+
     /*Check the cache first*/
-    if(fdsc->cache && letter == fdsc->cache->last_letter) return fdsc->cache->last_glyph_id;
+    if(cache && letter == cache->last_letter) return cache->last_glyph_id;
 
     uint16_t i;
     for(i = 0; i < fdsc->cmap_num; i++) {
@@ -252,16 +269,16 @@ static uint32_t get_glyph_dsc_id(const lv_font_t * font, uint32_t letter)
         }
 
         /*Update the cache*/
-        if(fdsc->cache) {
-            fdsc->cache->last_letter = letter;
-            fdsc->cache->last_glyph_id = glyph_id;
+        if(cache) {
+            cache->last_letter = letter;
+            cache->last_glyph_id = glyph_id;
         }
         return glyph_id;
     }
 
-    if(fdsc->cache) {
-        fdsc->cache->last_letter = letter;
-        fdsc->cache->last_glyph_id = 0;
+    if(cache) {
+        cache->last_letter = letter;
+        cache->last_glyph_id = 0;
     }
     return 0;
 
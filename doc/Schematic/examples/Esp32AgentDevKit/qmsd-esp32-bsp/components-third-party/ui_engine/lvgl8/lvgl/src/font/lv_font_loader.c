@@ -117,6 +117,10 @@ lv_font_t * lv_font_load(const char * font_name)
 void lv_font_free(lv_font_t * font)
 {
     if(NULL != font) {
+#if LV_USE_GLYPH_CACHE
+        /*A font loaded later may get the same address*/
+        lv_draw_sw_glyph_cache_invalidate();
+#endif
         lv_font_fmt_txt_dsc_t * dsc = (lv_font_fmt_txt_dsc_t *)font->dsc;
 
         if(NULL != dsc) {
@@ -22,6 +22,7 @@
 #include "../draw/sdl/lv_draw_sdl.h"
 #include "../draw/stm32_dma2d/lv_gpu_stm32_dma2d.h"
 #include "../draw/swm341_dma2d/lv_gpu_swm341_dma2d.h"
+#include "../draw/esp_pie/lv_draw_esp_pie.h"
 #include "../draw/arm2d/lv_gpu_arm2d.h"
 #if LV_USE_GPU_NXP_PXP || LV_USE_GPU_NXP_VG_LITE
     #include "../draw/nxp/lv_gpu_nxp.h"
@@ -105,6 +106,10 @@ void lv_disp_drv_init(lv_disp_drv_t * driver)
     driver->draw_ctx_init = lv_draw_swm341_dma2d_ctx_init;
     driver->draw_ctx_deinit = lv_draw_swm341_dma2d_ctx_init;
     driver->draw_ctx_size = sizeof(lv_draw_swm341_dma2d_ctx_t);
+#elif LV_USE_GPU_ESP_PIE
+    driver->draw_ctx_init = lv_draw_esp_pie_ctx_init;
+    driver->draw_ctx_deinit = lv_draw_esp_pie_ctx_deinit;
+    driver->draw_ctx_size = sizeof(lv_draw_esp_pie_ctx_t);
 #elif LV_USE_GPU_NXP_PXP || LV_USE_GPU_NXP_VG_LITE
     driver->draw_ctx_init = lv_draw_nxp_ctx_init;
     driver->draw_ctx_deinit = lv_draw_nxp_ctx_deinit;
@@ -173,6 +178,18 @@ lv_disp_t * lv_disp_drv_register(lv_disp_drv_t * driver)
         driver->draw_ctx = draw_ctx;
     }
 
+#if LV_USE_REFR_PARALLEL
+    uint32_t i;
+    for(i = 0; i < LV_REFR_PARALLEL_THREADS - 1; i++) {
+        if(driver->band_draw_ctx[i]) continue;
+        lv_draw_ctx_t * draw_ctx = lv_mem_alloc(driver->draw_ctx_size);
+        LV_ASSERT_MALLOC(draw_ctx);
+        if(draw_ctx == NULL) return NULL;
+        driver->draw_ctx_init(driver, draw_ctx);
+        driver->band_draw_ctx[i] = draw_ctx;
+    }
+#endif
+
     lv_memset_00(disp, sizeof(lv_disp_t));
 
     disp->driver = driver;
@@ -136,6 +136,16 @@ typedef struct _lv_disp_drv_t {
     /** OPTIONAL: called when start rendering */
     void (*render_start_cb)(struct _lv_disp_drv_t * disp_drv);
 
+#if LV_USE_REFR_PARALLEL
+    /** OPTIONAL: make the render threads `1..LV_REFR_PARALLEL_THREADS-1` call
+     * `lv_refr_render_bands(disp_drv, thread_id)` and return without waiting for them.
+     * The calling thread renders as thread 0. Without it the bands are rendered serially*/
+    void (*render_bands_start_cb)(struct _lv_disp_drv_t * disp_drv);
+
+    /** Return when the `lv_refr_render_bands()` calls started by `render_bands_start_cb` returned*/
+    void (*render_bands_wait_cb)(struct _lv_disp_drv_t * disp_drv);
+#endif
+
     /** On CHROMA_KEYED images this color will be transparent.
      * `LV_COLOR_CHROMA_KEY` by default. (lv_conf.h)*/
     lv_color_t color_chroma_key;
@@ -144,6 +154,9 @@ typedef struct _lv_disp_drv_t {
     void (*draw_ctx_init)(struct _lv_disp_drv_t * disp_drv, lv_draw_ctx_t * draw_ctx);
     void (*draw_ctx_deinit)(struct _lv_disp_drv_t * disp_drv, lv_draw_ctx_t * draw_ctx);
     size_t draw_ctx_size;
+#if LV_USE_REFR_PARALLEL
+    lv_draw_ctx_t * band_draw_ctx[LV_REFR_PARALLEL_THREADS - 1]; /**< The draw contexts of the other render threads*/
+#endif
 
 #if LV_USE_USER_DATA
     void * user_data; /**< Custom display driver user data*/
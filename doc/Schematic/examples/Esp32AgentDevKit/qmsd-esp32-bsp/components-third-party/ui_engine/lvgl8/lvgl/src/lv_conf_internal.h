@@ -255,6 +255,33 @@
     #endif
 #endif   /*LV_TICK_CUSTOM*/
 
+/*Render the invalidated areas in horizontal bands on several threads (cores) at once.
+ *The display driver runs the extra threads, see `render_bands_start_cb` in `lv_disp_drv_t`.
+ *Needs a thread safe allocator (`LV_MEM_CUSTOM`) and `__thread` support.*/
+#ifndef LV_USE_REFR_PARALLEL
+    #ifdef CONFIG_LV_USE_REFR_PARALLEL
+        #define LV_USE_REFR_PARALLEL CONFIG_LV_USE_REFR_PARALLEL
+    #else
+        #define LV_USE_REFR_PARALLEL 0
+    #endif
+#endif
+#if LV_USE_REFR_PARALLEL
+    #ifndef LV_REFR_PARALLEL_THREADS
+        #ifdef CONFIG_LV_REFR_PARALLEL_THREADS
+            #define LV_REFR_PARALLEL_THREADS CONFIG_LV_REFR_PARALLEL_THREADS
+        #else
+            #define LV_REFR_PARALLEL_THREADS 2      /*Render threads, the one running `lv_timer_handler()` included*/
+        #endif
+    #endif
+    #ifndef LV_REFR_PARALLEL_BANDS
+        #ifdef CONFIG_LV_REFR_PARALLEL_BANDS
+            #define LV_REFR_PARALLEL_BANDS CONFIG_LV_REFR_PARALLEL_BANDS
+        #else
+            #define LV_REFR_PARALLEL_BANDS   4      /*Bands an area is cut into, the threads take them as they get free*/
+        #endif
+    #endif
+#endif   /*LV_USE_REFR_PARALLEL*/
+
 /*Default Dot Per Inch. Used to initialize default sizes such as widgets sized, style paddings.
  *(Not so important, you can adjust it to modify default sizes and spaces)*/
 #ifndef LV_DPI_DEF
@@ -312,6 +339,57 @@
     #endif
 #endif /*LV_DRAW_COMPLEX*/
 
+/*Keep glyphs expanded to A8 masks (one opacity byte a pixel), keyed by font, letter and bpp,
+ *so drawing a letter again is a plain masked blend. Every render thread has its own cache:
+ *a main tier of LV_GLYPH_CACHE_SIZE bytes (PSRAM is fine) and a hot tier of
+ *LV_GLYPH_CACHE_FAST_SIZE bytes (internal RAM) for the glyphs hit again.
+ *See `lv_draw_sw_glyph_cache_set_alloc_cb()` to place them.*/
+#ifndef LV_USE_GLYPH_CACHE
+    #ifdef CONFIG_LV_USE_GLYPH_CACHE
+        #define LV_USE_GLYPH_CACHE CONFIG_LV_USE_GLYPH_CACHE
+    #else
+        #define LV_USE_GLYPH_CACHE 0
+    #endif
+#endif
+#if LV_USE_GLYPH_CACHE
+    #ifndef LV_GLYPH_CACHE_SIZE
+        #ifdef CONFIG_LV_GLYPH_CACHE_SIZE
+            #define LV_GLYPH_CACHE_SIZE CONFIG_LV_GLYPH_CACHE_SIZE
+        #else
+            #define LV_GLYPH_CACHE_SIZE (128 * 1024)
+        #endif
+    #endif
+    #ifndef LV_GLYPH_CACHE_FAST_SIZE
+        #ifdef CONFIG_LV_GLYPH_CACHE_FAST_SIZE
+            #define LV_GLYPH_CACHE_FAST_SIZE CONFIG_LV_GLYPH_CACHE_FAST_SIZE
+        #else
+            #define LV_GLYPH_CACHE_FAST_SIZE (16 * 1024)
+        #endif
+    #endif
+#endif /*LV_USE_GLYPH_CACHE*/
+
+/*Keep shadow corners, gradients, radius mask circles and decoded images in one cache of
+ *LV_DRAW_CACHE_SIZE bytes, split evenly among the render threads, instead of their own caches
+ *(LV_SHADOW_CACHE_SIZE, LV_GRAD_CACHE_DEF_SIZE, LV_CIRCLE_CACHE_SIZE and LV_IMG_CACHE_DEF_SIZE
+ *are ignored then). What's cheap to make again a byte goes first.
+ *See `lv_draw_cache_set_alloc_cb()` to place it (PSRAM is fine).*/
+#ifndef LV_USE_DRAW_CACHE
+    #ifdef CONFIG_LV_USE_DRAW_CACHE
+        #define LV_USE_DRAW_CACHE CONFIG_LV_USE_DRAW_CACHE
+    #else
+        #define LV_USE_DRAW_CACHE 0
+    #endif
+#endif
+#if LV_USE_DRAW_CACHE
+    #ifndef LV_DRAW_CACHE_SIZE
+        #ifdef CONFIG_LV_DRAW_CACHE_SIZE
+            #define LV_DRAW_CACHE_SIZE CONFIG_LV_DRAW_CACHE_SIZE
+        #else
+            #define LV_DRAW_CACHE_SIZE (256 * 1024)
+        #endif
+    #endif
+#endif /*LV_USE_DRAW_CACHE*/
+
 /**
  * "Simple layers" are used when a widget has `style_opa < 255` to buffer the widget into a layer
  * and blend it as an image with the given opacity.
@@ -460,6 +538,15 @@
     #endif
 #endif
 
+/*Use the ESP32-S3 PIE (SIMD) instructions for blending*/
+#ifndef LV_USE_GPU_ESP_PIE
+    #ifdef CONFIG_LV_USE_GPU_ESP_PIE
+        #define LV_USE_GPU_ESP_PIE CONFIG_LV_USE_GPU_ESP_PIE
+    #else
+        #define LV_USE_GPU_ESP_PIE 0
+    #endif
+#endif
+
 /*Use NXP's PXP GPU iMX RTxxx platforms*/
 #ifndef LV_USE_GPU_NXP_PXP
     #ifdef CONFIG_LV_USE_GPU_NXP_PXP
@@ -825,6 +912,16 @@
     #endif
 #endif
 
+/*Keep what the styles of an object give for the paddings, radius, opacities, colors and font
+ *in the object (about 300 bytes a part), until its styles or any style are changed*/
+#ifndef LV_USE_STYLE_CACHE
+    #ifdef CONFIG_LV_USE_STYLE_CACHE
+        #define LV_USE_STYLE_CACHE CONFIG_LV_USE_STYLE_CACHE
+    #else
+        #define LV_USE_STYLE_CACHE 0
+    #endif
+#endif
+
 /*Garbage Collector settings
  *Used if lvgl is bound to higher level language and the memory is managed by that language*/
 #ifndef LV_ENABLE_GC
@@ -1474,6 +1571,13 @@
             #define LV_LABEL_LONG_TXT_HINT 1  /*Store some extra info in labels to speed up drawing of very long texts*/
         #endif
     #endif
+    #ifndef LV_LABEL_METRICS_CACHE
+        #ifdef CONFIG_LV_LABEL_METRICS_CACHE
+            #define LV_LABEL_METRICS_CACHE CONFIG_LV_LABEL_METRICS_CACHE
+        #else
+            #define LV_LABEL_METRICS_CACHE 0  /*Keep the line starts and widths of long texts (12 bytes a line)*/
+        #endif
+    #endif
 #endif
 
 #ifndef LV_USE_LINE
@@ -1831,6 +1935,18 @@
     #endif
 #endif
 
+#ifndef LV_USE_VLIST
+    #ifdef _LV_KCONFIG_PRESENT
+        #ifdef CONFIG_LV_USE_VLIST
+            #define LV_USE_VLIST CONFIG_LV_USE_VLIST
+        #else
+            #define LV_USE_VLIST 0
+        #endif
+    #else
+        #define LV_USE_VLIST      1
+    #endif
+#endif
+
 #ifndef LV_USE_WIN
     #ifdef _LV_KCONFIG_PRESENT
         #ifdef CONFIG_LV_USE_WIN
@@ -1949,6 +2065,16 @@
     #endif
 #endif
 
+/*Lay out again only the children changed since the last layout (and the ones after them)
+ *and walk only the ancestors of the changed objects. About 40 bytes a laid out container*/
+#ifndef LV_USE_LAYOUT_INCREMENTAL
+    #ifdef CONFIG_LV_USE_LAYOUT_INCREMENTAL
+        #define LV_USE_LAYOUT_INCREMENTAL CONFIG_LV_USE_LAYOUT_INCREMENTAL
+    #else
+        #define LV_USE_LAYOUT_INCREMENTAL 0
+    #endif
+#endif
+
 /*---------------------
  * 3rd party libraries
  *--------------------*/
@@ -2459,6 +2585,14 @@ LV_EXPORT_CONST_INT(LV_DPI_DEF);
 #endif  /*LV_USE_LOG*/
 
 
+/*State the drawing writes (caches, scratch buffers) is kept per render thread with parallel rendering*/
+#if LV_USE_REFR_PARALLEL
+    #define LV_DRAW_LOCAL __thread
+#else
+    #define LV_DRAW_LOCAL
+#endif  /*LV_USE_REFR_PARALLEL*/
+
+
 /*If running without lv_conf.h add typedefs with default value*/
 #ifdef LV_CONF_SKIP
     #if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)    /*Disable warnings for Visual Studio*/
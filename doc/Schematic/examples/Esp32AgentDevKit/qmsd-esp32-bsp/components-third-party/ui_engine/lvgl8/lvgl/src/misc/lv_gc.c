@@ -28,6 +28,11 @@
     LV_ROOTS
 #endif /*LV_ENABLE_GC*/
 
+#if LV_USE_REFR_PARALLEL
+    static lv_draw_roots_t draw_roots;
+    LV_DRAW_LOCAL lv_draw_roots_t * _lv_draw_roots = &draw_roots;
+#endif /*LV_USE_REFR_PARALLEL*/
+
 /**********************
  *      MACROS
  **********************/
@@ -40,6 +45,9 @@ void _lv_gc_clear_roots(void)
 {
 #define LV_CLEAR_ROOT(root_type, root_name) lv_memset_00(&LV_GC_ROOT(root_name), sizeof(LV_GC_ROOT(root_name)));
     LV_ITERATE_ROOTS(LV_CLEAR_ROOT)
+#if LV_USE_REFR_PARALLEL
+    lv_memset_00(&draw_roots, sizeof(draw_roots));
+#endif
 }
 
 /**********************
@@ -22,16 +22,24 @@ extern "C" {
 #include "../draw/lv_img_cache.h"
 #include "../draw/lv_draw_mask.h"
 #include "../core/lv_obj_pos.h"
+#include "../core/lv_obj_style_cache.h"
 
 /*********************
  *      DEFINES
  *********************/
-#if LV_IMG_CACHE_DEF_SIZE
+/*The image and circle caches of their own, unless the draw cache has them*/
+#if LV_IMG_CACHE_DEF_SIZE && !LV_USE_DRAW_CACHE
 #    define LV_IMG_CACHE_DEF            1
 #else
 #    define LV_IMG_CACHE_DEF            0
 #endif
 
+#if LV_DRAW_COMPLEX && !LV_USE_DRAW_CACHE
+#    define LV_CIRCLE_CACHE_DEF         1
+#else
+#    define LV_CIRCLE_CACHE_DEF         0
+#endif
+
 #define LV_DISPATCH(f, t, n)            f(t, n)
 #define LV_DISPATCH_COND(f, t, n, m, v) LV_CONCAT3(LV_DISPATCH, m, v)(f, t, n)
 
@@ -40,7 +48,7 @@ extern "C" {
 #define LV_DISPATCH10(f, t, n)
 #define LV_DISPATCH11(f, t, n)          LV_DISPATCH(f, t, n)
 
-#define LV_ITERATE_ROOTS(f)                                                                            \
+#define LV_ITERATE_SHARED_ROOTS(f)                                                                     \
     LV_DISPATCH(f, lv_ll_t, _lv_timer_ll) /*Linked list to store the lv_timers*/                       \
     LV_DISPATCH(f, lv_ll_t, _lv_disp_ll)  /*Linked list of display device*/                            \
     LV_DISPATCH(f, lv_ll_t, _lv_indev_ll) /*Linked list of input device*/                              \
@@ -50,17 +58,32 @@ extern "C" {
     LV_DISPATCH(f, lv_ll_t, _lv_img_decoder_ll)                                                        \
     LV_DISPATCH(f, lv_ll_t, _lv_obj_style_trans_ll)                                                    \
     LV_DISPATCH(f, lv_layout_dsc_t *, _lv_layout_list)                                                 \
+    LV_DISPATCH(f, lv_timer_t*, _lv_timer_act)                                                         \
+    LV_DISPATCH(f, void *, _lv_timer_heap)   /*The timers by deadline*/                                \
+    LV_DISPATCH(f, void * , _lv_theme_default_styles)                                                  \
+    LV_DISPATCH(f, void * , _lv_theme_basic_styles)                                                  \
+    LV_DISPATCH(f, uint8_t * , _lv_style_custom_prop_flag_lookup_table)
+
+/*The roots written while drawing. Access them with `LV_GC_DRAW_ROOT()`:
+ *with `LV_USE_REFR_PARALLEL` every render thread has its own set*/
+#define LV_ITERATE_DRAW_ROOTS(f)                                                                       \
     LV_DISPATCH_COND(f, _lv_img_cache_entry_t*, _lv_img_cache_array, LV_IMG_CACHE_DEF, 1)              \
     LV_DISPATCH_COND(f, _lv_img_cache_entry_t, _lv_img_cache_single, LV_IMG_CACHE_DEF, 0)              \
-    LV_DISPATCH(f, lv_timer_t*, _lv_timer_act)                                                         \
     LV_DISPATCH(f, lv_mem_buf_arr_t , lv_mem_buf)                                                      \
-    LV_DISPATCH_COND(f, _lv_draw_mask_radius_circle_dsc_arr_t , _lv_circle_cache, LV_DRAW_COMPLEX, 1)  \
+    LV_DISPATCH_COND(f, _lv_draw_mask_radius_circle_dsc_arr_t , _lv_circle_cache, LV_CIRCLE_CACHE_DEF, 1) \
     LV_DISPATCH_COND(f, _lv_draw_mask_saved_arr_t , _lv_draw_mask_list, LV_DRAW_COMPLEX, 1)            \
-    LV_DISPATCH(f, void * , _lv_theme_default_styles)                                                  \
-    LV_DISPATCH(f, void * , _lv_theme_basic_styles)                                                  \
     LV_DISPATCH_COND(f, uint8_t *, _lv_font_decompr_buf, LV_USE_FONT_COMPRESSED, 1)                    \
     LV_DISPATCH(f, uint8_t * , _lv_grad_cache_mem)                                                     \
-    LV_DISPATCH(f, uint8_t * , _lv_style_custom_prop_flag_lookup_table)
+    LV_DISPATCH(f, const lv_area_t *, _lv_obj_draw_coords) /*Where lv_obj draws the object, if not its coords*/ \
+    LV_DISPATCH_COND(f, void *, _lv_glyph_cache, LV_USE_GLYPH_CACHE, 1)                                \
+    LV_DISPATCH_COND(f, void *, _lv_draw_cache, LV_USE_DRAW_CACHE, 1)                                  \
+    LV_DISPATCH_COND(f, lv_obj_style_cache_stats_t, _lv_obj_style_cache_stats, LV_USE_STYLE_CACHE, 1)
+
+#if LV_USE_REFR_PARALLEL
+#define LV_ITERATE_ROOTS(f) LV_ITERATE_SHARED_ROOTS(f)
+#else
+#define LV_ITERATE_ROOTS(f) LV_ITERATE_SHARED_ROOTS(f) LV_ITERATE_DRAW_ROOTS(f)
+#endif
 
 #define LV_DEFINE_ROOT(root_type, root_name) root_type root_name;
 #define LV_ROOTS LV_ITERATE_ROOTS(LV_DEFINE_ROOT)
@@ -69,6 +92,9 @@ extern "C" {
 #if LV_MEM_CUSTOM != 1
 #error "GC requires CUSTOM_MEM"
 #endif /*LV_MEM_CUSTOM*/
+#if LV_USE_REFR_PARALLEL
+#error "GC can't reach the draw roots of the render threads, disable LV_USE_REFR_PARALLEL"
+#endif /*LV_USE_REFR_PARALLEL*/
 #include LV_GC_INCLUDE
 #else  /*LV_ENABLE_GC*/
 #define LV_GC_ROOT(x) x
@@ -80,6 +106,20 @@ LV_ITERATE_ROOTS(LV_EXTERN_ROOT)
  *      TYPEDEFS
  **********************/
 
+#if LV_USE_REFR_PARALLEL
+/*One set of draw roots. A thread reaches its own through `_lv_draw_roots`, so the
+ *tasks that never draw pay only for that pointer in their thread local storage*/
+typedef struct {
+    LV_ITERATE_DRAW_ROOTS(LV_DEFINE_ROOT)
+} lv_draw_roots_t;
+
+/*Every thread starts on the set of `lv_init()`'s thread, a render thread binds its own*/
+extern LV_DRAW_LOCAL lv_draw_roots_t * _lv_draw_roots;
+#define LV_GC_DRAW_ROOT(x) (_lv_draw_roots->x)
+#else
+#define LV_GC_DRAW_ROOT(x) LV_GC_ROOT(x)
+#endif /*LV_USE_REFR_PARALLEL*/
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -132,6 +132,10 @@ const uint8_t _lv_style_builtin_prop_flag_lookup_table[_LV_STYLE_NUM_BUILT_IN_PR
 
 uint32_t _lv_style_custom_prop_flag_lookup_table_size = 0;
 
+#if LV_USE_STYLE_CACHE
+uint32_t _lv_style_gen = 0;
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -142,6 +146,11 @@ static const lv_style_value_t null_style_value = { .num = 0 };
 /**********************
  *      MACROS
  **********************/
+#if LV_USE_STYLE_CACHE
+    #define STYLE_EDITED() _lv_style_gen++
+#else
+    #define STYLE_EDITED()
+#endif
 
 /**********************
  *   GLOBAL FUNCTIONS
@@ -159,6 +168,7 @@ void lv_style_init(lv_style_t * style)
 #if LV_USE_ASSERT_STYLE
     style->sentinel = LV_STYLE_SENTINEL_VALUE;
 #endif
+    STYLE_EDITED();
 }
 
 void lv_style_reset(lv_style_t * style)
@@ -175,6 +185,7 @@ void lv_style_reset(lv_style_t * style)
 #if LV_USE_ASSERT_STYLE
     style->sentinel = LV_STYLE_SENTINEL_VALUE;
 #endif
+    STYLE_EDITED();
 }
 
 lv_style_prop_t lv_style_register_prop(uint8_t flag)
@@ -233,6 +244,7 @@ bool lv_style_remove_prop(lv_style_t * style, lv_style_prop_t prop)
         if(LV_STYLE_PROP_ID_MASK(style->prop1) == prop) {
             style->prop1 = LV_STYLE_PROP_INV;
             style->prop_cnt = 0;
+            STYLE_EDITED();
             return true;
         }
         return false;
@@ -272,6 +284,7 @@ bool lv_style_remove_prop(lv_style_t * style, lv_style_prop_t prop)
             }
 
             lv_mem_free(old_values);
+            STYLE_EDITED();
             return true;
         }
     }
@@ -420,6 +433,8 @@ static void lv_style_set_prop_internal(lv_style_t * style, lv_style_prop_t prop_
         return;
     }
 
+    STYLE_EDITED();
+
     lv_style_prop_t prop_id = LV_STYLE_PROP_ID_MASK(prop_and_meta);
 
     if(style->prop_cnt > 1) {
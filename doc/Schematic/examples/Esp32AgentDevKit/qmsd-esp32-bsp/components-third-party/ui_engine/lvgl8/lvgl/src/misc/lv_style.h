@@ -506,6 +506,11 @@ uint8_t _lv_style_get_prop_group(lv_style_prop_t prop);
  */
 uint8_t _lv_style_prop_lookup_flags(lv_style_prop_t prop);
 
+#if LV_USE_STYLE_CACHE
+/*Counts the edits of the styles: the style cache of the objects is stale when it changes*/
+extern uint32_t _lv_style_gen;
+#endif
+
 #include "lv_style_gen.h"
 
 static inline void lv_style_set_size(lv_style_t * style, lv_coord_t value)
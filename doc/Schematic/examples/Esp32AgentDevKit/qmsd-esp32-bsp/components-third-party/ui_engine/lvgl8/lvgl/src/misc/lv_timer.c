@@ -11,6 +11,7 @@
 #include "lv_mem.h"
 #include "lv_ll.h"
 #include "lv_gc.h"
+#include "lv_math.h"
 
 /*********************
  *      DEFINES
@@ -18,23 +19,43 @@
 #define IDLE_MEAS_PERIOD 500 /*[ms]*/
 #define DEF_PERIOD 500
 
+#define HEAP_NONE 0xFFFFFFFF   /*`heap_idx` of a paused timer*/
+#define HEAP_RAN  0x80000000   /*`heap_idx` of a timer run in this handler call, and its place among them*/
+
 /**********************
  *      TYPEDEFS
  **********************/
+/*The timers waiting to run are in a min-heap by deadline at the start of `_lv_timer_heap`.
+ *The ones run in a handler call wait at its end until the call is over*/
+typedef struct {
+    uint32_t due;           /*The tick it's ready at*/
+    lv_timer_t * timer;
+} heap_node_t;
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static bool lv_timer_exec(lv_timer_t * timer);
 static uint32_t lv_timer_time_remaining(lv_timer_t * timer);
+static uint32_t timer_due(lv_timer_t * timer);
+static void timer_reschedule(lv_timer_t * timer);
+static void timer_unschedule(lv_timer_t * timer);
+static bool heap_reserve(uint32_t cnt);
+static void heap_push(lv_timer_t * timer);
+static void heap_remove(uint32_t i);
+static void heap_fix(uint32_t i);
+static void ran_remove(uint32_t pos);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static bool lv_timer_run = false;
 static uint8_t idle_last = 0;
-static bool timer_deleted;
-static bool timer_created;
+static uint32_t heap_cnt;        /*Timers in the heap*/
+static uint32_t ran_cnt;         /*Timers run in this handler call*/
+static uint32_t heap_cap;
+static uint32_t timer_cnt;
+static uint32_t timer_seq;
 
 /**********************
  *      MACROS
@@ -45,6 +66,9 @@ static bool timer_created;
     #define TIMER_TRACE(...)
 #endif
 
+#define HEAP            ((heap_node_t *)LV_GC_ROOT(_lv_timer_heap))
+#define RAN_SLOT(pos)   (&HEAP[heap_cap - 1 - (pos)])
+
 /**********************
  *   GLOBAL FUNCTIONS
  **********************/
@@ -55,6 +79,11 @@ static bool timer_created;
 void _lv_timer_core_init(void)
 {
     _lv_ll_init(&LV_GC_ROOT(_lv_timer_ll), sizeof(lv_timer_t));
+    LV_GC_ROOT(_lv_timer_heap) = NULL;
+    heap_cnt = 0;
+    ran_cnt = 0;
+    heap_cap = 0;
+    timer_cnt = 0;
 
     /*Initially enable the lv_timer handling*/
     lv_timer_enable(true);
@@ -95,39 +124,29 @@ LV_ATTRIBUTE_TIMER_HANDLER uint32_t lv_timer_handler(void)
         }
     }
 
-    /*Run all timer from the list*/
-    lv_timer_t * next;
-    do {
-        timer_deleted             = false;
-        timer_created             = false;
-        LV_GC_ROOT(_lv_timer_act) = _lv_ll_get_head(&LV_GC_ROOT(_lv_timer_ll));
-        while(LV_GC_ROOT(_lv_timer_act)) {
-            /*The timer might be deleted if it runs only once ('repeat_count = 1')
-             *So get next element until the current is surely valid*/
-            next = _lv_ll_get_next(&LV_GC_ROOT(_lv_timer_ll), LV_GC_ROOT(_lv_timer_act));
-
-            if(lv_timer_exec(LV_GC_ROOT(_lv_timer_act))) {
-                /*If a timer was created or deleted then this or the next item might be corrupted*/
-                if(timer_created || timer_deleted) {
-                    TIMER_TRACE("Start from the first timer again because a timer was created or deleted");
-                    break;
-                }
-            }
-
-            LV_GC_ROOT(_lv_timer_act) = next; /*Load the next timer*/
-        }
-    } while(LV_GC_ROOT(_lv_timer_act));
+    /*Run the ready timers, the earliest deadline first. A timer that ran is set aside until
+     *the end, so it runs once a call even if it's ready again (e.g. with 0 period)*/
+    while(heap_cnt > 0 && (int32_t)(HEAP[0].due - lv_tick_get()) <= 0) {
+        lv_timer_t * timer = HEAP[0].timer;
+        heap_remove(0);
+        RAN_SLOT(ran_cnt)->timer = timer;
+        timer->heap_idx = HEAP_RAN | ran_cnt;
+        ran_cnt++;
+
+        LV_GC_ROOT(_lv_timer_act) = timer;
+        lv_timer_exec(timer);
+    }
+    LV_GC_ROOT(_lv_timer_act) = NULL;
 
-    uint32_t time_till_next = LV_NO_TIMER_READY;
-    next = _lv_ll_get_head(&LV_GC_ROOT(_lv_timer_ll));
-    while(next) {
-        if(!next->paused) {
-            uint32_t delay = lv_timer_time_remaining(next);
-            if(delay < time_till_next)
-                time_till_next = delay;
-        }
+    while(ran_cnt > 0) {
+        ran_cnt--;
+        heap_push(RAN_SLOT(ran_cnt)->timer);
+    }
 
-        next = _lv_ll_get_next(&LV_GC_ROOT(_lv_timer_ll), next); /*Find the next timer*/
+    uint32_t time_till_next = LV_NO_TIMER_READY;
+    if(heap_cnt > 0) {
+        int32_t delay = (int32_t)(HEAP[0].due - lv_tick_get());
+        time_till_next = delay > 0 ? delay : 0;
     }
 
     busy_time += lv_tick_elaps(handler_start);
@@ -172,14 +191,21 @@ lv_timer_t * lv_timer_create(lv_timer_cb_t timer_xcb, uint32_t period, void * us
     LV_ASSERT_MALLOC(new_timer);
     if(new_timer == NULL) return NULL;
 
+    if(!heap_reserve(timer_cnt + 1)) {
+        _lv_ll_remove(&LV_GC_ROOT(_lv_timer_ll), new_timer);
+        lv_mem_free(new_timer);
+        return NULL;
+    }
+    timer_cnt++;
+
     new_timer->period = period;
     new_timer->timer_cb = timer_xcb;
     new_timer->repeat_count = -1;
     new_timer->paused = 0;
     new_timer->last_run = lv_tick_get();
     new_timer->user_data = user_data;
-
-    timer_created = true;
+    new_timer->seq = timer_seq++;
+    heap_push(new_timer);
 
     return new_timer;
 }
@@ -200,8 +226,12 @@ void lv_timer_set_cb(lv_timer_t * timer, lv_timer_cb_t timer_cb)
  */
 void lv_timer_del(lv_timer_t * timer)
 {
+    timer_unschedule(timer);
     _lv_ll_remove(&LV_GC_ROOT(_lv_timer_ll), timer);
-    timer_deleted = true;
+    timer_cnt--;
+
+    /*Let the handler know if it was the running one*/
+    if(LV_GC_ROOT(_lv_timer_act) == timer) LV_GC_ROOT(_lv_timer_act) = NULL;
 
     lv_mem_free(timer);
 }
@@ -213,11 +243,13 @@ void lv_timer_del(lv_timer_t * timer)
 void lv_timer_pause(lv_timer_t * timer)
 {
     timer->paused = true;
+    timer_unschedule(timer);
 }
 
 void lv_timer_resume(lv_timer_t * timer)
 {
     timer->paused = false;
+    if(timer->heap_idx == HEAP_NONE) heap_push(timer);
 }
 
 /**
@@ -228,6 +260,7 @@ void lv_timer_resume(lv_timer_t * timer)
 void lv_timer_set_period(lv_timer_t * timer, uint32_t period)
 {
     timer->period = period;
+    timer_reschedule(timer);
 }
 
 /**
@@ -237,6 +270,7 @@ void lv_timer_set_period(lv_timer_t * timer, uint32_t period)
 void lv_timer_ready(lv_timer_t * timer)
 {
     timer->last_run = lv_tick_get() - timer->period - 1;
+    timer_reschedule(timer);
 }
 
 /**
@@ -247,6 +281,7 @@ void lv_timer_ready(lv_timer_t * timer)
 void lv_timer_set_repeat_count(lv_timer_t * timer, int32_t repeat_count)
 {
     timer->repeat_count = repeat_count;
+    timer_reschedule(timer);
 }
 
 /**
@@ -257,6 +292,7 @@ void lv_timer_set_repeat_count(lv_timer_t * timer, int32_t repeat_count)
 void lv_timer_reset(lv_timer_t * timer)
 {
     timer->last_run = lv_tick_get();
+    timer_reschedule(timer);
 }
 
 /**
@@ -304,8 +340,7 @@ static bool lv_timer_exec(lv_timer_t * timer)
     bool exec = false;
     if(lv_timer_time_remaining(timer) == 0) {
         /* Decrement the repeat count before executing the timer_cb.
-         * If any timer is deleted `if(timer->repeat_count == 0)` is not executed below
-         * but at least the repeat count is zero and the timer can be deleted in the next round*/
+         * If the timer deletes itself `if(timer->repeat_count == 0)` is not executed below*/
         int32_t original_repeat_count = timer->repeat_count;
         if(timer->repeat_count > 0) timer->repeat_count--;
         timer->last_run = lv_tick_get();
@@ -316,7 +351,7 @@ static bool lv_timer_exec(lv_timer_t * timer)
         exec = true;
     }
 
-    if(timer_deleted == false) { /*The timer might be deleted by itself as well*/
+    if(LV_GC_ROOT(_lv_timer_act) == timer) { /*The timer might be deleted by itself as well*/
         if(timer->repeat_count == 0) { /*The repeat count is over, delete the timer*/
             TIMER_TRACE("deleting timer with %p callback because the repeat count is over", *((void **)&timer->timer_cb));
             lv_timer_del(timer);
@@ -339,3 +374,135 @@ static uint32_t lv_timer_time_remaining(lv_timer_t * timer)
         return 0;
     return timer->period - elp;
 }
+
+/**
+ * The tick a timer gets ready at: now if it's ready, or if its repeat count is over to delete it
+ * @param timer pointer to lv_timer
+ * @return the tick
+ */
+static uint32_t timer_due(lv_timer_t * timer)
+{
+    uint32_t now = lv_tick_get();
+    if(timer->repeat_count == 0) return now;
+
+    /*Keep the deadlines comparable as signed differences, a longer one is checked again then*/
+    return now + LV_MIN(lv_timer_time_remaining(timer), INT32_MAX);
+}
+
+/**
+ * Move a timer in the heap after its deadline changed. The paused ones and the ones run in
+ * this handler call get theirs when they are put back.
+ * @param timer pointer to lv_timer
+ */
+static void timer_reschedule(lv_timer_t * timer)
+{
+    if(timer->heap_idx & HEAP_RAN) return;
+
+    HEAP[timer->heap_idx].due = timer_due(timer);
+    heap_fix(timer->heap_idx);
+}
+
+/**
+ * Take a timer out of the heap, or from among the ones run in this handler call
+ * @param timer pointer to lv_timer
+ */
+static void timer_unschedule(lv_timer_t * timer)
+{
+    if(timer->heap_idx == HEAP_NONE) return;
+
+    if(timer->heap_idx & HEAP_RAN) ran_remove(timer->heap_idx & ~HEAP_RAN);
+    else heap_remove(timer->heap_idx);
+    timer->heap_idx = HEAP_NONE;
+}
+
+/**
+ * Make room for `cnt` timers, the ones run in this handler call staying at the end
+ * @param cnt number of timers
+ * @return true: there is room; false: out of memory
+ */
+static bool heap_reserve(uint32_t cnt)
+{
+    if(cnt <= heap_cap) return true;
+
+    uint32_t new_cap = heap_cap ? heap_cap * 2 : 8;
+    heap_node_t * heap = lv_mem_realloc(LV_GC_ROOT(_lv_timer_heap), new_cap * sizeof(heap_node_t));
+    LV_ASSERT_MALLOC(heap);
+    if(heap == NULL) return false;
+
+    lv_memcpy(&heap[new_cap - ran_cnt], &heap[heap_cap - ran_cnt], ran_cnt * sizeof(heap_node_t));
+    LV_GC_ROOT(_lv_timer_heap) = heap;
+    heap_cap = new_cap;
+    return true;
+}
+
+/**
+ * Whether node `a` runs before node `b`: the earlier deadline, on the same deadline the newer
+ * timer as the list (newest first) was walked before
+ */
+static inline bool node_before(const heap_node_t * a, const heap_node_t * b)
+{
+    int32_t diff = (int32_t)(a->due - b->due);
+    if(diff != 0) return diff < 0;
+    return (int32_t)(a->timer->seq - b->timer->seq) > 0;
+}
+
+static void heap_push(lv_timer_t * timer)
+{
+    heap_node_t * node = &HEAP[heap_cnt];
+    node->due = timer_due(timer);
+    node->timer = timer;
+    timer->heap_idx = heap_cnt;
+    heap_cnt++;
+    heap_fix(heap_cnt - 1);
+}
+
+static void heap_remove(uint32_t i)
+{
+    heap_node_t * heap = HEAP;
+    heap_cnt--;
+    if(i == heap_cnt) return;
+
+    heap[i] = heap[heap_cnt];
+    heap[i].timer->heap_idx = i;
+    heap_fix(i);
+}
+
+/**
+ * Move the node at `i` up or down to its place
+ * @param i index in the heap
+ */
+static void heap_fix(uint32_t i)
+{
+    heap_node_t * heap = HEAP;
+    heap_node_t node = heap[i];
+    while(i > 0 && node_before(&node, &heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        heap[i].timer->heap_idx = i;
+        i = (i - 1) / 2;
+    }
+
+    while(2 * i + 1 < heap_cnt) {
+        uint32_t child = 2 * i + 1;
+        if(child + 1 < heap_cnt && node_before(&heap[child + 1], &heap[child])) child++;
+        if(!node_before(&heap[child], &node)) break;
+        heap[i] = heap[child];
+        heap[i].timer->heap_idx = i;
+        i = child;
+    }
+
+    heap[i] = node;
+    node.timer->heap_idx = i;
+}
+
+/**
+ * Forget a timer run in this handler call, the last one of them taking its place
+ * @param pos its place among them
+ */
+static void ran_remove(uint32_t pos)
+{
+    ran_cnt--;
+    if(pos == ran_cnt) return;
+
+    *RAN_SLOT(pos) = *RAN_SLOT(ran_cnt);
+    RAN_SLOT(pos)->timer->heap_idx = HEAP_RAN | pos;
+}
@@ -48,6 +48,8 @@ typedef struct _lv_timer_t {
     void * user_data; /**< Custom user data*/
     int32_t repeat_count; /**< 1: One time;  -1 : infinity;  n>0: residual times*/
     uint32_t paused : 1;
+    uint32_t heap_idx; /**< Where the scheduler keeps it, managed by lv_timer.c*/
+    uint32_t seq; /**< Creation order, the newer runs first on the same deadline*/
 } lv_timer_t;
 
 /**********************
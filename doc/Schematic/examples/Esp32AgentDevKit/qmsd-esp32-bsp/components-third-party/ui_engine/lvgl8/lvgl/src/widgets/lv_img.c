@@ -16,6 +16,7 @@
 #include "../misc/lv_txt.h"
 #include "../misc/lv_math.h"
 #include "../misc/lv_log.h"
+#include "../misc/lv_gc.h"
 
 /*********************
  *      DEFINES
@@ -601,15 +602,13 @@ static void draw_img(lv_event_t * e)
             bg_coords.y2 += obj->coords.y1;
         }
 
-        lv_area_t ori_coords;
-        lv_area_copy(&ori_coords, &obj->coords);
-        lv_area_copy(&obj->coords, &bg_coords);
-
+        /*Draw the background on the transformed coordinates. Not by changing `obj->coords`:
+         *with LV_USE_REFR_PARALLEL the other render threads are reading them*/
+        LV_GC_DRAW_ROOT(_lv_obj_draw_coords) = &bg_coords;
         lv_res_t res = lv_obj_event_base(MY_CLASS, e);
+        LV_GC_DRAW_ROOT(_lv_obj_draw_coords) = NULL;
         if(res != LV_RES_OK) return;
 
-        lv_area_copy(&obj->coords, &ori_coords);
-
         if(code == LV_EVENT_DRAW_MAIN) {
             if(img->h == 0 || img->w == 0) return;
             if(img->zoom == 0) return;
@@ -27,6 +27,8 @@
 #define LV_LABEL_SCROLL_DELAY       300
 #define LV_LABEL_DOT_END_INV 0xFFFFFFFF
 #define LV_LABEL_HINT_HEIGHT_LIMIT 1024 /*Enable "hint" to buffer info about labels larger than this. (Speed up drawing)*/
+#define LV_LABEL_METRICS_MIN_LEN    64  /*Keep the lines of texts longer than this (in bytes)*/
+#define LV_LABEL_METRICS_EDIT_LINES 16  /*Break this many lines again after an edit at most, then all the rest*/
 
 /**********************
  *      TYPEDEFS
@@ -49,6 +51,24 @@ static void lv_label_dot_tmp_free(lv_obj_t * label);
 static void set_ofs_x_anim(void * obj, int32_t v);
 static void set_ofs_y_anim(void * obj, int32_t v);
 
+#if LV_LABEL_METRICS_CACHE
+static _lv_label_metrics_t * metrics_get(lv_obj_t * obj, const lv_font_t * font, lv_coord_t letter_space,
+                                         lv_coord_t max_w, lv_text_flag_t flag);
+static _lv_label_metrics_t * metrics_peek(lv_obj_t * obj, const lv_font_t * font, lv_coord_t letter_space,
+                                          lv_coord_t max_w, lv_text_flag_t flag);
+static void metrics_norm_key(lv_coord_t * max_w, lv_text_flag_t * flag);
+static void metrics_free(lv_obj_t * obj);
+static void metrics_text_changed(lv_obj_t * obj);
+static void metrics_edited(lv_obj_t * obj, uint32_t pos, uint32_t del, uint32_t ins, int32_t char_diff);
+static bool metrics_build(_lv_label_metrics_t * m, const char * txt, uint32_t line, uint32_t start, uint32_t char_id);
+static void metrics_apply_edit(_lv_label_metrics_t * m, const char * txt);
+static bool metrics_reserve(_lv_label_metrics_t * m, uint32_t line_cnt);
+static uint32_t metrics_find_line(const _lv_label_metrics_t * m, uint32_t byte_id);
+static uint32_t metrics_find_line_of_char(const _lv_label_metrics_t * m, uint32_t char_id);
+static uint32_t metrics_find_line_at_y(const _lv_label_metrics_t * m, lv_coord_t y, lv_coord_t line_space);
+static void metrics_get_size(const _lv_label_metrics_t * m, const char * txt, lv_coord_t line_space, lv_point_t * size);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -62,6 +82,10 @@ const lv_obj_class_t lv_label_class = {
     .base_class = &lv_obj_class
 };
 
+#if LV_LABEL_METRICS_CACHE
+    static bool metrics_en = true;
+#endif
+
 /**********************
  *      MACROS
  **********************/
@@ -88,6 +112,9 @@ void lv_label_set_text(lv_obj_t * obj, const char * text)
     lv_label_t * label = (lv_label_t *)obj;
 
     lv_obj_invalidate(obj);
+#if LV_LABEL_METRICS_CACHE
+    metrics_text_changed(obj);
+#endif
 
     /*If text is NULL then just refresh with the current text*/
     if(text == NULL) text = label->text;
@@ -151,6 +178,9 @@ void lv_label_set_text_fmt(lv_obj_t * obj, const char * fmt, ...)
 
     lv_obj_invalidate(obj);
     lv_label_t * label = (lv_label_t *)obj;
+#if LV_LABEL_METRICS_CACHE
+    metrics_text_changed(obj);
+#endif
 
     /*If text is NULL then refresh*/
     if(fmt == NULL) {
@@ -176,6 +206,9 @@ void lv_label_set_text_static(lv_obj_t * obj, const char * text)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
     lv_label_t * label = (lv_label_t *)obj;
+#if LV_LABEL_METRICS_CACHE
+    metrics_text_changed(obj);
+#endif
 
     if(label->static_txt == 0 && label->text != NULL) {
         lv_mem_free(label->text);
@@ -325,16 +358,31 @@ void lv_label_get_letter_pos(const lv_obj_t * obj, uint32_t char_id, lv_point_t
     if(label->expand != 0) flag |= LV_TEXT_FLAG_EXPAND;
     if(lv_obj_get_style_width(obj, LV_PART_MAIN) == LV_SIZE_CONTENT && !obj->w_layout) flag |= LV_TEXT_FLAG_FIT;
 
-    uint32_t byte_id = _lv_txt_encoded_get_byte_id(txt, char_id);
+    uint32_t byte_id;
+#if LV_LABEL_METRICS_CACHE
+    uint32_t line = 0;
+    _lv_label_metrics_t * m = metrics_get((lv_obj_t *)obj, font, letter_space, max_w, flag);
+    if(m) {
+        line = metrics_find_line_of_char(m, char_id);
+        line_start = m->lines[line].start;
+        new_line_start = m->lines[line + 1].start;
+        byte_id = line_start + _lv_txt_encoded_get_byte_id(&txt[line_start], char_id - m->lines[line].char_id);
+        y = (int32_t)line * (letter_height + line_space);
+    }
+    else
+#endif
+    {
+        byte_id = _lv_txt_encoded_get_byte_id(txt, char_id);
 
-    /*Search the line of the index letter*/;
-    while(txt[new_line_start] != '\0') {
-        new_line_start += _lv_txt_get_next_line(&txt[line_start], font, letter_space, max_w, NULL, flag);
-        if(byte_id < new_line_start || txt[new_line_start] == '\0')
-            break; /*The line of 'index' letter begins at 'line_start'*/
+        /*Search the line of the index letter*/;
+        while(txt[new_line_start] != '\0') {
+            new_line_start += _lv_txt_get_next_line(&txt[line_start], font, letter_space, max_w, NULL, flag);
+            if(byte_id < new_line_start || txt[new_line_start] == '\0')
+                break; /*The line of 'index' letter begins at 'line_start'*/
 
-        y += letter_height + line_space;
-        line_start = new_line_start;
+            y += letter_height + line_space;
+            line_start = new_line_start;
+        }
     }
 
     /*If the last character is line break then go to the next line*/
@@ -377,17 +425,17 @@ void lv_label_get_letter_pos(const lv_obj_t * obj, uint32_t char_id, lv_point_t
     lv_coord_t x = lv_txt_get_width(bidi_txt, visual_byte_pos, font, letter_space, flag);
     if(char_id != line_start) x += letter_space;
 
-    if(align == LV_TEXT_ALIGN_CENTER) {
-        lv_coord_t line_w;
-        line_w = lv_txt_get_width(bidi_txt, new_line_start - line_start, font, letter_space, flag);
-        x += lv_area_get_width(&txt_coords) / 2 - line_w / 2;
-
-    }
-    else if(align == LV_TEXT_ALIGN_RIGHT) {
+    if(align == LV_TEXT_ALIGN_CENTER || align == LV_TEXT_ALIGN_RIGHT) {
         lv_coord_t line_w;
+#if LV_LABEL_METRICS_CACHE && LV_USE_BIDI == 0
+        if(m && line_start == m->lines[line].start) line_w = m->lines[line].w;
+        else line_w = lv_txt_get_width(bidi_txt, new_line_start - line_start, font, letter_space, flag);
+#else
         line_w = lv_txt_get_width(bidi_txt, new_line_start - line_start, font, letter_space, flag);
+#endif
 
-        x += lv_area_get_width(&txt_coords) - line_w;
+        if(align == LV_TEXT_ALIGN_CENTER) x += lv_area_get_width(&txt_coords) / 2 - line_w / 2;
+        else x += lv_area_get_width(&txt_coords) - line_w;
     }
     pos->x = x;
     pos->y = y;
@@ -428,22 +476,42 @@ uint32_t lv_label_get_letter_on(const lv_obj_t * obj, lv_point_t * pos_in)
 
     lv_text_align_t align = lv_obj_calculate_style_text_align(obj, LV_PART_MAIN, label->text);
 
-    /*Search the line of the index letter*/;
-    while(txt[line_start] != '\0') {
-        new_line_start += _lv_txt_get_next_line(&txt[line_start], font, letter_space, max_w, NULL, flag);
-
-        if(pos.y <= y + letter_height) {
-            /*The line is found (stored in 'line_start')*/
+#if LV_LABEL_METRICS_CACHE
+    uint32_t line = 0;
+    _lv_label_metrics_t * m = metrics_get((lv_obj_t *)obj, font, letter_space, max_w, flag);
+    if(m) {
+        line = metrics_find_line_at_y(m, pos.y, line_space);
+        line_start = m->lines[line].start;
+        new_line_start = line_start;
+        if(line < m->line_cnt) {
+            new_line_start = m->lines[line + 1].start;
             /*Include the NULL terminator in the last line*/
             uint32_t tmp = new_line_start;
             uint32_t letter;
             letter = _lv_txt_encoded_prev(txt, &tmp);
             if(letter != '\n' && txt[new_line_start] == '\0') new_line_start++;
-            break;
         }
-        y += letter_height + line_space;
+    }
+    else
+#endif
+    {
+        /*Search the line of the index letter*/;
+        while(txt[line_start] != '\0') {
+            new_line_start += _lv_txt_get_next_line(&txt[line_start], font, letter_space, max_w, NULL, flag);
+
+            if(pos.y <= y + letter_height) {
+                /*The line is found (stored in 'line_start')*/
+                /*Include the NULL terminator in the last line*/
+                uint32_t tmp = new_line_start;
+                uint32_t letter;
+                letter = _lv_txt_encoded_prev(txt, &tmp);
+                if(letter != '\n' && txt[new_line_start] == '\0') new_line_start++;
+                break;
+            }
+            y += letter_height + line_space;
 
-        line_start = new_line_start;
+            line_start = new_line_start;
+        }
     }
 
 #if LV_USE_BIDI
@@ -457,15 +525,17 @@ uint32_t lv_label_get_letter_on(const lv_obj_t * obj, lv_point_t * pos_in)
 
     /*Calculate the x coordinate*/
     lv_coord_t x = 0;
-    if(align == LV_TEXT_ALIGN_CENTER) {
-        lv_coord_t line_w;
-        line_w = lv_txt_get_width(bidi_txt, new_line_start - line_start, font, letter_space, flag);
-        x += lv_area_get_width(&txt_coords) / 2 - line_w / 2;
-    }
-    else if(align == LV_TEXT_ALIGN_RIGHT) {
+    if(align == LV_TEXT_ALIGN_CENTER || align == LV_TEXT_ALIGN_RIGHT) {
         lv_coord_t line_w;
+#if LV_LABEL_METRICS_CACHE && LV_USE_BIDI == 0
+        if(m && line < m->line_cnt && new_line_start == m->lines[line + 1].start) line_w = m->lines[line].w;
+        else line_w = lv_txt_get_width(bidi_txt, new_line_start - line_start, font, letter_space, flag);
+#else
         line_w = lv_txt_get_width(bidi_txt, new_line_start - line_start, font, letter_space, flag);
-        x += lv_area_get_width(&txt_coords) - line_w;
+#endif
+
+        if(align == LV_TEXT_ALIGN_CENTER) x += lv_area_get_width(&txt_coords) / 2 - line_w / 2;
+        else x += lv_area_get_width(&txt_coords) - line_w;
     }
 
     lv_text_cmd_state_t cmd_state = LV_TEXT_CMD_STATE_WAIT;
@@ -518,6 +588,10 @@ uint32_t lv_label_get_letter_on(const lv_obj_t * obj, lv_point_t * pos_in)
     logical_pos = _lv_txt_encoded_get_char_id(bidi_txt, i);
 #endif
 
+#if LV_LABEL_METRICS_CACHE
+    if(m) return logical_pos + m->lines[line].char_id;
+#endif
+
     return  logical_pos + _lv_txt_encoded_get_char_id(txt, line_start);
 }
 
@@ -546,28 +620,42 @@ bool lv_label_is_char_under_pos(const lv_obj_t * obj, lv_point_t * pos)
     if(label->expand != 0) flag |= LV_TEXT_FLAG_EXPAND;
     if(lv_obj_get_style_width(obj, LV_PART_MAIN) == LV_SIZE_CONTENT && !obj->w_layout) flag |= LV_TEXT_FLAG_FIT;
 
-    /*Search the line of the index letter*/;
-    while(txt[line_start] != '\0') {
-        new_line_start += _lv_txt_get_next_line(&txt[line_start], font, letter_space, max_w, NULL, flag);
+#if LV_LABEL_METRICS_CACHE
+    uint32_t line = 0;
+    _lv_label_metrics_t * m = metrics_get((lv_obj_t *)obj, font, letter_space, max_w, flag);
+    if(m) {
+        line = metrics_find_line_at_y(m, pos->y, line_space);
+        line_start = m->lines[line].start;
+        new_line_start = line < m->line_cnt ? m->lines[line + 1].start : line_start;
+    }
+    else
+#endif
+    {
+        /*Search the line of the index letter*/;
+        while(txt[line_start] != '\0') {
+            new_line_start += _lv_txt_get_next_line(&txt[line_start], font, letter_space, max_w, NULL, flag);
 
-        if(pos->y <= y + letter_height) break; /*The line is found (stored in 'line_start')*/
-        y += letter_height + line_space;
+            if(pos->y <= y + letter_height) break; /*The line is found (stored in 'line_start')*/
+            y += letter_height + line_space;
 
-        line_start = new_line_start;
+            line_start = new_line_start;
+        }
     }
 
     /*Calculate the x coordinate*/
     lv_coord_t x      = 0;
     lv_coord_t last_x = 0;
-    if(align == LV_TEXT_ALIGN_CENTER) {
-        lv_coord_t line_w;
-        line_w = lv_txt_get_width(&txt[line_start], new_line_start - line_start, font, letter_space, flag);
-        x += lv_area_get_width(&txt_coords) / 2 - line_w / 2;
-    }
-    else if(align == LV_TEXT_ALIGN_RIGHT) {
+    if(align == LV_TEXT_ALIGN_CENTER || align == LV_TEXT_ALIGN_RIGHT) {
         lv_coord_t line_w;
+#if LV_LABEL_METRICS_CACHE
+        if(m && line < m->line_cnt) line_w = m->lines[line].w;
+        else line_w = lv_txt_get_width(&txt[line_start], new_line_start - line_start, font, letter_space, flag);
+#else
         line_w = lv_txt_get_width(&txt[line_start], new_line_start - line_start, font, letter_space, flag);
-        x += lv_area_get_width(&txt_coords) - line_w;
+#endif
+
+        if(align == LV_TEXT_ALIGN_CENTER) x += lv_area_get_width(&txt_coords) / 2 - line_w / 2;
+        else x += lv_area_get_width(&txt_coords) - line_w;
     }
 
     lv_text_cmd_state_t cmd_state = LV_TEXT_CMD_STATE_WAIT;
@@ -659,6 +747,11 @@ void lv_label_ins_text(lv_obj_t * obj, uint32_t pos, const char * txt)
         pos = _lv_txt_get_encoded_length(label->text);
     }
 
+#if LV_LABEL_METRICS_CACHE && LV_USE_ARABIC_PERSIAN_CHARS == 0
+    /*Break only the lines around the new text (the Arabic/Persian processing could change more)*/
+    metrics_edited(obj, _lv_txt_encoded_get_byte_id(label->text, pos), 0, ins_len, _lv_txt_get_encoded_length(txt));
+#endif
+
     _lv_txt_ins(label->text, pos, txt);
     lv_label_set_text(obj, NULL);
 }
@@ -674,6 +767,14 @@ void lv_label_cut_text(lv_obj_t * obj, uint32_t pos, uint32_t cnt)
     lv_obj_invalidate(obj);
 
     char * label_txt = lv_label_get_text(obj);
+
+#if LV_LABEL_METRICS_CACHE
+    /*Break only the lines around the cut*/
+    uint32_t byte_pos = _lv_txt_encoded_get_byte_id(label_txt, pos);
+    uint32_t byte_cnt = _lv_txt_encoded_get_byte_id(&label_txt[byte_pos], cnt);
+    metrics_edited(obj, byte_pos, byte_cnt, 0, -(int32_t)_lv_txt_encoded_get_char_id(&label_txt[byte_pos], byte_cnt));
+#endif
+
     /*Delete the characters*/
     _lv_txt_cut(label_txt, pos, cnt);
 
@@ -681,6 +782,13 @@ void lv_label_cut_text(lv_obj_t * obj, uint32_t pos, uint32_t cnt)
     lv_label_refr_text(obj);
 }
 
+#if LV_LABEL_METRICS_CACHE
+void lv_label_enable_metrics_cache(bool en)
+{
+    metrics_en = en;
+}
+#endif
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -712,6 +820,9 @@ static void lv_label_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
 #endif
     label->dot.tmp_ptr   = NULL;
     label->dot_tmp_alloc = 0;
+#if LV_LABEL_METRICS_CACHE
+    label->metrics = NULL;
+#endif
 
     lv_obj_clear_flag(obj, LV_OBJ_FLAG_CLICKABLE);
     lv_label_set_long_mode(obj, LV_LABEL_LONG_WRAP);
@@ -727,6 +838,9 @@ static void lv_label_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     lv_label_t * label = (lv_label_t *)obj;
 
     lv_label_dot_tmp_free(obj);
+#if LV_LABEL_METRICS_CACHE
+    metrics_free(obj);
+#endif
     if(!label->static_txt) lv_mem_free(label->text);
     label->text = NULL;
 }
@@ -776,7 +890,13 @@ static void lv_label_event(const lv_obj_class_t * class_p, lv_event_t * e)
         if(lv_obj_get_style_width(obj, LV_PART_MAIN) == LV_SIZE_CONTENT && !obj->w_layout) w = LV_COORD_MAX;
         else w = lv_obj_get_content_width(obj);
 
+#if LV_LABEL_METRICS_CACHE
+        _lv_label_metrics_t * m = metrics_peek(obj, font, letter_space, w, flag);
+        if(m) metrics_get_size(m, label->text, line_space, &size);
+        else lv_txt_get_size(&size, label->text, font, letter_space, line_space, w, flag);
+#else
         lv_txt_get_size(&size, label->text, font, letter_space, line_space, w, flag);
+#endif
 
         lv_point_t * self_size = lv_event_get_param(e);
         self_size->x = LV_MAX(self_size->x, size.x);
@@ -834,6 +954,10 @@ static void draw_main(lv_event_t * e)
     lv_draw_label_hint_t * hint = &label->hint;
     if(label->long_mode == LV_LABEL_LONG_SCROLL_CIRCULAR || lv_area_get_height(&txt_coords) < LV_LABEL_HINT_HEIGHT_LIMIT)
         hint = NULL;
+#if LV_USE_REFR_PARALLEL
+    /*Only the thread of the display's own draw context updates the hint*/
+    if(draw_ctx != lv_obj_get_disp(obj)->driver->draw_ctx) hint = NULL;
+#endif
 
 #else
     /*Just for compatibility*/
@@ -849,6 +973,29 @@ static void draw_main(lv_event_t * e)
         lv_area_move(&txt_coords, 0, -s);
         txt_coords.y2 = obj->coords.y2;
     }
+
+#if LV_LABEL_METRICS_CACHE
+    /*Start at the first visible line if the lines are known.
+     *Only read them here as several threads might draw the label.*/
+    lv_draw_label_hint_t metrics_hint;
+    _lv_label_metrics_t * m = NULL;
+    if(label->long_mode != LV_LABEL_LONG_SCROLL_CIRCULAR && label->offset.y == 0 && txt_coords.y1 < 0) {
+        m = metrics_peek(obj, label_draw_dsc.font, label_draw_dsc.letter_space, lv_area_get_width(&txt_coords), flag);
+    }
+    if(m && m->line_cnt > 0) {
+        int32_t font_h = lv_font_get_line_height(label_draw_dsc.font);
+        int32_t line_h = font_h + label_draw_dsc.line_space;
+        int32_t hidden_h = draw_ctx->clip_area->y1 - txt_coords.y1 - font_h;
+        if(line_h > 0) {
+            uint32_t line = hidden_h > 0 ? (hidden_h + line_h - 1) / line_h : 0;
+            if(line >= m->line_cnt) line = m->line_cnt - 1;
+            metrics_hint.line_start = m->lines[line].start;
+            metrics_hint.y = (int32_t)line * line_h;
+            metrics_hint.coord_y = txt_coords.y1;
+            hint = &metrics_hint;
+        }
+    }
+#endif
     if(label->long_mode == LV_LABEL_LONG_SCROLL || label->long_mode == LV_LABEL_LONG_SCROLL_CIRCULAR) {
         const lv_area_t * clip_area_ori = draw_ctx->clip_area;
         draw_ctx->clip_area = &txt_clip;
@@ -914,7 +1061,13 @@ static void lv_label_refr_text(lv_obj_t * obj)
     if(label->expand != 0) flag |= LV_TEXT_FLAG_EXPAND;
     if(lv_obj_get_style_width(obj, LV_PART_MAIN) == LV_SIZE_CONTENT && !obj->w_layout) flag |= LV_TEXT_FLAG_FIT;
 
+#if LV_LABEL_METRICS_CACHE
+    _lv_label_metrics_t * m = metrics_get(obj, font, letter_space, max_w, flag);
+    if(m) metrics_get_size(m, label->text, line_space, &size);
+    else lv_txt_get_size(&size, label->text, font, letter_space, line_space, max_w, flag);
+#else
     lv_txt_get_size(&size, label->text, font, letter_space, line_space, max_w, flag);
+#endif
 
     lv_obj_refresh_self_size(obj);
 
@@ -1158,6 +1311,9 @@ static void lv_label_refr_text(lv_obj_t * obj)
                 }
                 label->text[byte_id_ori + LV_LABEL_DOT_NUM] = '\0';
                 label->dot_end                              = letter_id + LV_LABEL_DOT_NUM;
+#if LV_LABEL_METRICS_CACHE
+                metrics_text_changed(obj);
+#endif
             }
         }
     }
@@ -1190,6 +1346,9 @@ static void lv_label_revert_dots(lv_obj_t * obj)
     lv_label_dot_tmp_free(obj);
 
     label->dot_end = LV_LABEL_DOT_END_INV;
+#if LV_LABEL_METRICS_CACHE
+    metrics_text_changed(obj);
+#endif
 }
 
 /**
@@ -1270,5 +1429,373 @@ static void set_ofs_y_anim(void * obj, int32_t v)
     lv_obj_invalidate(obj);
 }
 
+#if LV_LABEL_METRICS_CACHE
+
+/**
+ * Only the new line characters break the lines with `LV_TEXT_FLAG_EXPAND` or `LV_TEXT_FLAG_FIT`,
+ * and the widths look only at `LV_TEXT_FLAG_RECOLOR`. Bring the settings to the form the lines are kept with.
+ * @param max_w     pointer to the max. width of the lines
+ * @param flag      pointer to the text flags
+ */
+static void metrics_norm_key(lv_coord_t * max_w, lv_text_flag_t * flag)
+{
+    if(*flag & (LV_TEXT_FLAG_EXPAND | LV_TEXT_FLAG_FIT)) {
+        *flag = (*flag & LV_TEXT_FLAG_RECOLOR) | LV_TEXT_FLAG_FIT;
+        *max_w = LV_COORD_MAX;
+    }
+    else {
+        *flag &= LV_TEXT_FLAG_RECOLOR;
+    }
+}
+
+/**
+ * Get the lines of a label's text, breaking it again if it changed or was broken with other settings
+ * @param obj           pointer to a label object
+ * @param font          font of the text
+ * @param letter_space  letter space of the text
+ * @param max_w         max. width of the lines
+ * @param flag          text flags
+ * @return              the lines, or NULL if the text is short or there is no memory
+ */
+static _lv_label_metrics_t * metrics_get(lv_obj_t * obj, const lv_font_t * font, lv_coord_t letter_space,
+                                         lv_coord_t max_w, lv_text_flag_t flag)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    _lv_label_metrics_t * m = label->metrics;
+    if(!metrics_en) return NULL;
+
+    metrics_norm_key(&max_w, &flag);
+    if(m && m->valid && m->font == font && m->letter_space == letter_space && m->max_w == max_w && m->flag == flag) {
+        if(m->edited) metrics_apply_edit(m, label->text);
+        if(m->valid) return m;
+    }
+
+    if(label->text == NULL || font == NULL || strlen(label->text) <= LV_LABEL_METRICS_MIN_LEN) {
+        metrics_free(obj);
+        return NULL;
+    }
+
+    if(m == NULL) {
+        m = lv_mem_alloc(sizeof(_lv_label_metrics_t));
+        LV_ASSERT_MALLOC(m);
+        if(m == NULL) return NULL;
+        lv_memset_00(m, sizeof(_lv_label_metrics_t));
+        label->metrics = m;
+    }
+
+    m->font = font;
+    m->letter_space = letter_space;
+    m->max_w = max_w;
+    m->flag = flag;
+    m->edited = 0;
+    m->valid = metrics_build(m, label->text, 0, 0, 0) ? 1 : 0;
+
+    return m->valid ? m : NULL;
+}
+
+/**
+ * Get the lines of a label's text only if they are up to date. Doesn't break the text.
+ * @param obj           pointer to a label object
+ * @param font          font of the text
+ * @param letter_space  letter space of the text
+ * @param max_w         max. width of the lines
+ * @param flag          text flags
+ * @return              the lines, or NULL
+ */
+static _lv_label_metrics_t * metrics_peek(lv_obj_t * obj, const lv_font_t * font, lv_coord_t letter_space,
+                                          lv_coord_t max_w, lv_text_flag_t flag)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    _lv_label_metrics_t * m = label->metrics;
+    if(m == NULL || m->valid == 0 || m->edited || !metrics_en) return NULL;
+
+    metrics_norm_key(&max_w, &flag);
+    if(m->font != font || m->letter_space != letter_space || m->max_w != max_w || m->flag != flag) return NULL;
+
+    return m;
+}
+
+static void metrics_free(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    if(label->metrics == NULL) return;
+
+    lv_mem_free(label->metrics->lines);
+    lv_mem_free(label->metrics);
+    label->metrics = NULL;
+}
+
+/**
+ * The text changed in an unknown way: break it again when the lines are needed.
+ * `lv_label_ins_text` and `lv_label_cut_text` tell what changed before refreshing.
+ * @param obj       pointer to a label object
+ */
+static void metrics_text_changed(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    _lv_label_metrics_t * m = label->metrics;
+    if(m == NULL || (m->edited && metrics_en)) return;
+
+    m->valid = 0;
+    m->edited = 0;
+}
+
+/**
+ * Tell that bytes were cut from and inserted into the text at a position
+ * @param obj           pointer to a label object
+ * @param pos           byte index of the change
+ * @param del           bytes cut
+ * @param ins           bytes inserted
+ * @param char_diff     letters inserted minus letters cut
+ */
+static void metrics_edited(lv_obj_t * obj, uint32_t pos, uint32_t del, uint32_t ins, int32_t char_diff)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    _lv_label_metrics_t * m = label->metrics;
+    if(m == NULL || m->valid == 0) return;
+
+    /*Only one edit is kept, and none while the cache is off*/
+    if(m->edited || !metrics_en) {
+        m->valid = 0;
+        m->edited = 0;
+        return;
+    }
+
+    m->edit_pos = pos;
+    m->edit_del = del;
+    m->edit_ins = ins;
+    m->edit_char_diff = char_diff;
+    m->edited = 1;
+}
+
+/**
+ * Break the text into lines from a line on and store them
+ * @param m         pointer to the lines
+ * @param txt       the text
+ * @param line      index of the first line to break
+ * @param start     byte index where it starts
+ * @param char_id   letter index where it starts
+ * @return          false if there was no memory
+ */
+static bool metrics_build(_lv_label_metrics_t * m, const char * txt, uint32_t line, uint32_t start, uint32_t char_id)
+{
+    while(txt[start] != '\0') {
+        if(!metrics_reserve(m, line + 1)) return false;
+
+        uint32_t end = start + _lv_txt_get_next_line(&txt[start], m->font, m->letter_space, m->max_w, NULL, m->flag);
+        m->lines[line].start = start;
+        m->lines[line].char_id = char_id;
+        m->lines[line].w = lv_txt_get_width(&txt[start], end - start, m->font, m->letter_space, m->flag);
+
+        char_id += _lv_txt_encoded_get_char_id(&txt[start], end - start);
+        start = end;
+        line++;
+    }
+
+    if(!metrics_reserve(m, line)) return false;
+    m->lines[line].start = start;
+    m->lines[line].char_id = char_id;
+    m->lines[line].w = 0;
+    m->line_cnt = line;
+
+    return true;
+}
+
+/**
+ * Break again only the lines around the edit told by `metrics_edited`
+ * and move the others after it.
+ * @param m         pointer to the lines of the text before the edit
+ * @param txt       the text after the edit
+ */
+static void metrics_apply_edit(_lv_label_metrics_t * m, const char * txt)
+{
+    m->edited = 0;
+
+    uint32_t old_cnt = m->line_cnt;
+    uint32_t old_end = m->edit_pos + m->edit_del;
+    uint32_t new_end = m->edit_pos + m->edit_ins;
+
+    /*A line ends before a word if the whole word (and the letter after it, for kerning) doesn't fit.
+     *So the lines before the line of the last break character before the edited word are the same.*/
+    uint32_t i = m->edit_pos;
+    if(i > 0) _lv_txt_encoded_prev(txt, &i);
+    while(i > 0) {
+        uint32_t letter = _lv_txt_encoded_prev(txt, &i);
+        if(letter == '\n' || letter == '\r' || _lv_txt_is_break_char(letter)) break;
+    }
+
+    uint32_t line = metrics_find_line(m, i);
+    uint32_t start = m->lines[line].start;
+    uint32_t char_id = m->lines[line].char_id;
+    uint32_t old_line = line;
+    uint32_t cnt = 0;
+    _lv_label_line_t new_lines[LV_LABEL_METRICS_EDIT_LINES];
+
+    while(1) {
+        /*After the edit the lines are the same as before from a line starting where one started before*/
+        if(start >= new_end) {
+            while(old_line < old_cnt && (m->lines[old_line].start < old_end ||
+                                         m->lines[old_line].start + m->edit_ins < start + m->edit_del)) {
+                old_line++;
+            }
+            if(m->lines[old_line].start >= old_end &&
+               m->lines[old_line].start + m->edit_ins == start + m->edit_del) break;
+        }
+
+        /*Many lines changed: break all the rest*/
+        if(cnt == LV_LABEL_METRICS_EDIT_LINES || txt[start] == '\0') {
+            if(!metrics_reserve(m, line + cnt)) {
+                m->valid = 0;
+                return;
+            }
+            lv_memcpy(&m->lines[line], new_lines, cnt * sizeof(_lv_label_line_t));
+            m->valid = metrics_build(m, txt, line + cnt, start, char_id) ? 1 : 0;
+            return;
+        }
+
+        uint32_t end = start + _lv_txt_get_next_line(&txt[start], m->font, m->letter_space, m->max_w, NULL, m->flag);
+        new_lines[cnt].start = start;
+        new_lines[cnt].char_id = char_id;
+        new_lines[cnt].w = lv_txt_get_width(&txt[start], end - start, m->font, m->letter_space, m->flag);
+
+        char_id += _lv_txt_encoded_get_char_id(&txt[start], end - start);
+        start = end;
+        cnt++;
+    }
+
+    /*Keep the lines after the edit (and the end of the text) but move them*/
+    uint32_t keep = old_cnt - old_line;
+    uint32_t new_cnt = line + cnt + keep;
+    if(!metrics_reserve(m, new_cnt)) {
+        m->valid = 0;
+        return;
+    }
+
+    memmove(&m->lines[line + cnt], &m->lines[old_line], (keep + 1) * sizeof(_lv_label_line_t));
+    for(i = line + cnt; i <= new_cnt; i++) {
+        m->lines[i].start = m->lines[i].start + m->edit_ins - m->edit_del;
+        m->lines[i].char_id += m->edit_char_diff;
+    }
+    lv_memcpy(&m->lines[line], new_lines, cnt * sizeof(_lv_label_line_t));
+    m->line_cnt = new_cnt;
+}
+
+/**
+ * Make room for some lines and the end of the text
+ * @param m         pointer to the lines
+ * @param line_cnt  number of lines
+ * @return          false if there was no memory
+ */
+static bool metrics_reserve(_lv_label_metrics_t * m, uint32_t line_cnt)
+{
+    if(line_cnt + 1 <= m->line_cap) return true;
+
+    uint32_t cap = LV_MAX(line_cnt + 1, m->line_cap + m->line_cap / 2 + 8);
+    _lv_label_line_t * lines = lv_mem_realloc(m->lines, cap * sizeof(_lv_label_line_t));
+    LV_ASSERT_MALLOC(lines);
+    if(lines == NULL) return false;
+
+    m->lines = lines;
+    m->line_cap = cap;
+    return true;
+}
+
+/**
+ * Get the line of a byte
+ * @param m         pointer to the lines
+ * @param byte_id   byte index in the text
+ * @return          index of the line, the last line if the byte is after it, 0 if there are no lines
+ */
+static uint32_t metrics_find_line(const _lv_label_metrics_t * m, uint32_t byte_id)
+{
+    if(m->line_cnt == 0) return 0;
+
+    uint32_t min = 0;
+    uint32_t max = m->line_cnt - 1;
+    while(min < max) {
+        uint32_t mid = (min + max + 1) / 2;
+        if(m->lines[mid].start <= byte_id) min = mid;
+        else max = mid - 1;
+    }
+    return min;
+}
+
+/**
+ * Get the line of a letter
+ * @param m         pointer to the lines
+ * @param char_id   letter index in the text
+ * @return          index of the line, the last line if the letter is after it, 0 if there are no lines
+ */
+static uint32_t metrics_find_line_of_char(const _lv_label_metrics_t * m, uint32_t char_id)
+{
+    if(m->line_cnt == 0) return 0;
+
+    uint32_t min = 0;
+    uint32_t max = m->line_cnt - 1;
+    while(min < max) {
+        uint32_t mid = (min + max + 1) / 2;
+        if(m->lines[mid].char_id <= char_id) min = mid;
+        else max = mid - 1;
+    }
+    return min;
+}
+
+/**
+ * Get the first line whose letters reach down to a coordinate
+ * @param m             pointer to the lines
+ * @param y             y coordinate relative to the text
+ * @param line_space    line space of the text
+ * @return              index of the line, `line_cnt` if it's below all the lines
+ */
+static uint32_t metrics_find_line_at_y(const _lv_label_metrics_t * m, lv_coord_t y, lv_coord_t line_space)
+{
+    lv_coord_t letter_height = lv_font_get_line_height(m->font);
+    int32_t line_h = letter_height + line_space;
+
+    if(y <= letter_height) return 0;
+    if(line_h <= 0) return m->line_cnt;
+
+    uint32_t line = (y - letter_height + line_h - 1) / line_h;
+    return LV_MIN(line, m->line_cnt);
+}
+
+/**
+ * Get the size of the text as `lv_txt_get_size` does
+ * @param m             pointer to the lines
+ * @param txt           the text
+ * @param line_space    line space of the text
+ * @param size_res      store the size here
+ */
+static void metrics_get_size(const _lv_label_metrics_t * m, const char * txt, lv_coord_t line_space,
+                             lv_point_t * size_res)
+{
+    size_res->x = 0;
+    size_res->y = 0;
+
+    uint16_t letter_height = lv_font_get_line_height(m->font);
+    uint32_t i;
+    for(i = 0; i < m->line_cnt; i++) {
+        if((unsigned long)size_res->y + (unsigned long)letter_height + (unsigned long)line_space > LV_MAX_OF(lv_coord_t)) {
+            LV_LOG_WARN("integer overflow while calculating text height");
+            return;
+        }
+        size_res->y += letter_height;
+        size_res->y += line_space;
+        size_res->x = LV_MAX(m->lines[i].w, size_res->x);
+    }
+
+    /*Make the text one line taller if the last character is '\n' or '\r'*/
+    uint32_t end = m->lines[m->line_cnt].start;
+    if(end != 0 && (txt[end - 1] == '\n' || txt[end - 1] == '\r')) {
+        size_res->y += letter_height + line_space;
+    }
+
+    /*Correction with the last line space or set the height manually if the text is empty*/
+    if(size_res->y == 0) size_res->y = letter_height;
+    else size_res->y -= line_space;
+}
+
+#endif /*LV_LABEL_METRICS_CACHE*/
+
 
 #endif
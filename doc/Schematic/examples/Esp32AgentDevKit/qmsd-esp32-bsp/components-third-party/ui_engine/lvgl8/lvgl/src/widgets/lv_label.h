@@ -50,6 +50,32 @@ enum {
 };
 typedef uint8_t lv_label_long_mode_t;
 
+#if LV_LABEL_METRICS_CACHE
+/*A line of a label's text*/
+typedef struct {
+    uint32_t start;     /**< Byte index of its first letter*/
+    uint32_t char_id;   /**< Letter index of it*/
+    lv_coord_t w;       /**< Its width, as `lv_txt_get_width` gives it*/
+} _lv_label_line_t;
+
+/*The lines of a label's text, as `_lv_txt_get_next_line` breaks it*/
+typedef struct {
+    _lv_label_line_t * lines;   /**< `line_cnt` lines and one more for the end of the text*/
+    uint32_t line_cnt;
+    uint32_t line_cap;
+    const lv_font_t * font;     /**< The lines were broken with these*/
+    lv_coord_t letter_space;
+    lv_coord_t max_w;           /**< `LV_COORD_MAX` if only the new line characters break the lines*/
+    lv_text_flag_t flag;
+    uint32_t edit_pos;          /**< Where text was inserted or cut since, in bytes*/
+    uint32_t edit_del;          /**< The bytes cut there...*/
+    uint32_t edit_ins;          /**< ...and inserted*/
+    int32_t edit_char_diff;     /**< Letters added (or removed if negative) there*/
+    uint8_t valid : 1;
+    uint8_t edited : 1;         /**< Only the text at `edit_pos` changed since*/
+} _lv_label_metrics_t;
+#endif
+
 typedef struct {
     lv_obj_t obj;
     char * text;
@@ -68,6 +94,10 @@ typedef struct {
     uint32_t sel_end;
 #endif
 
+#if LV_LABEL_METRICS_CACHE
+    _lv_label_metrics_t * metrics;  /*The lines of long texts, NULL for short ones*/
+#endif
+
     lv_point_t offset; /*Text draw position offset*/
     lv_label_long_mode_t long_mode : 3; /*Determine what to do with the long texts*/
     uint8_t static_txt : 1;             /*Flag to indicate the text is static*/
@@ -233,6 +263,15 @@ void lv_label_ins_text(lv_obj_t * obj, uint32_t pos, const char * txt);
  */
 void lv_label_cut_text(lv_obj_t * obj, uint32_t pos, uint32_t cnt);
 
+#if LV_LABEL_METRICS_CACHE
+/**
+ * Turn the line cache of the labels on or off (it's on by default).
+ * Off, the texts are broken into lines every time as without `LV_LABEL_METRICS_CACHE`.
+ * @param en        true: use the cache
+ */
+void lv_label_enable_metrics_cache(bool en);
+#endif
+
 /**********************
  *      MACROS
  **********************/
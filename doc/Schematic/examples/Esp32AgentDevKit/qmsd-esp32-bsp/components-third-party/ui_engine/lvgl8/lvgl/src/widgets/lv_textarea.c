@@ -222,13 +222,8 @@ void lv_textarea_del_char(lv_obj_t * obj)
     lv_res_t res = insert_handler(obj, del_buf);
     if(res != LV_RES_OK) return;
 
-    char * label_txt = lv_label_get_text(ta->label);
-
     /*Delete a character*/
-    _lv_txt_cut(label_txt, ta->cursor.pos - 1, 1);
-
-    /*Refresh the label*/
-    lv_label_set_text(ta->label, label_txt);
+    lv_label_cut_text(ta->label, ta->cursor.pos - 1, 1);
     lv_textarea_clear_selection(obj);
 
     /*If the textarea became empty, invalidate it to hide the placeholder*/
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#if LV_USE_DRAW_CACHE
+
+#define HOR         480
+#define VER         480
+#define FRAMES      120
+#define SCROLL_STEP 6
+#define ICON_SIZE   48
+
+// The budget is split among the render threads
+#if LV_USE_REFR_PARALLEL
+#define THREAD_NUM  LV_REFR_PARALLEL_THREADS
+#else
+#define THREAD_NUM  1
+#endif
+
+static lv_color_t g_frame[HOR * VER];
+static lv_disp_t* g_disp;
+
+static void frame_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&g_frame[y * HOR + area->x1], color_p, w * sizeof(lv_color_t));
+        color_p += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_init(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[HOR * VER];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, HOR * VER);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = HOR;
+        drv.ver_res = VER;
+        drv.flush_cb = frame_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+    }
+    // the test files share lv_init: make the widgets go on this display
+    lv_disp_set_default(g_disp);
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// An icon with alpha, like the ones of the screens
+static const lv_img_dsc_t* icon_get(void)
+{
+    static uint8_t map[ICON_SIZE * ICON_SIZE * LV_IMG_PX_SIZE_ALPHA_BYTE];
+    static lv_img_dsc_t icon;
+    if (icon.data == NULL) {
+        for (int y = 0; y < ICON_SIZE; y++) {
+            for (int x = 0; x < ICON_SIZE; x++) {
+                uint8_t* px = &map[(y * ICON_SIZE + x) * LV_IMG_PX_SIZE_ALPHA_BYTE];
+                lv_color_t c = lv_color_make(x * 5, y * 5, 255 - x * 2);
+                memcpy(px, &c, sizeof(c));
+                int dx = x - ICON_SIZE / 2, dy = y - ICON_SIZE / 2;
+                px[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = dx * dx + dy * dy < ICON_SIZE * ICON_SIZE / 4 ? 255 : 0;
+            }
+        }
+        icon.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+        icon.header.w = ICON_SIZE;
+        icon.header.h = ICON_SIZE;
+        icon.data_size = sizeof(map);
+        icon.data = map;
+    }
+    return &icon;
+}
+
+// The cards of a settings screen in a scrolling column: a shadow, a gradient and rounded corners each,
+// an icon, a title and a themed button with a border, the widths varying
+static lv_obj_t* cards_create(int cards)
+{
+    static const lv_palette_t palettes[] = {LV_PALETTE_BLUE, LV_PALETTE_TEAL, LV_PALETTE_ORANGE, LV_PALETTE_PURPLE};
+    lv_obj_t* col = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(col, HOR - 20, VER - 20);
+    lv_obj_center(col);
+    lv_obj_set_style_radius(col, 24, 0);
+    lv_obj_set_style_clip_corner(col, true, 0);
+    lv_obj_set_style_pad_row(col, 24, 0);
+    lv_obj_set_flex_flow(col, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_flex_align(col, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_set_scrollbar_mode(col, LV_SCROLLBAR_MODE_OFF);
+    for (int i = 0; i < cards; i++) {
+        lv_palette_t p = palettes[i % 4];
+        lv_obj_t* card = lv_obj_create(col);
+        lv_obj_set_size(card, i % 5 == 2 ? 120 : HOR - 80 - (i % 3) * 40, i % 5 == 2 ? 60 : 140);
+        lv_obj_clear_flag(card, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_set_style_radius(card, 20, 0);
+        lv_obj_set_style_shadow_width(card, 30, 0);
+        lv_obj_set_style_shadow_ofs_y(card, 8, 0);
+        lv_obj_set_style_shadow_opa(card, LV_OPA_40, 0);
+        lv_obj_set_style_bg_color(card, lv_palette_lighten(p, 4), 0);
+        lv_obj_set_style_bg_grad_color(card, lv_palette_lighten(p, 1), 0);
+        lv_obj_set_style_bg_grad_dir(card, i % 2 ? LV_GRAD_DIR_VER : LV_GRAD_DIR_HOR, 0);
+        if (i % 5 == 2) {
+            continue;
+        }
+
+        lv_obj_t* icon = lv_img_create(card);
+        lv_img_set_src(icon, icon_get());
+        lv_obj_align(icon, LV_ALIGN_LEFT_MID, 0, 0);
+
+        lv_obj_t* title = lv_label_create(card);
+        lv_label_set_text_fmt(title, "Room %d", i + 1);
+        lv_obj_align(title, LV_ALIGN_TOP_LEFT, ICON_SIZE + 12, 0);
+
+        lv_obj_t* btn = lv_btn_create(card);
+        lv_obj_set_size(btn, 200, 50);
+        lv_obj_set_style_border_width(btn, 2, 0);
+        lv_obj_set_style_border_color(btn, lv_palette_darken(p, 2), 0);
+        lv_obj_set_style_bg_color(btn, lv_palette_main(p), 0);
+        lv_obj_align(btn, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
+        lv_obj_t* label = lv_label_create(btn);
+        lv_label_set_text(label, i % 2 ? "Turn off" : "Turn on");
+        lv_obj_center(label);
+    }
+    return col;
+}
+
+// Scroll the column up a step a frame and render it, the cache of `size` bytes (0: off)
+static double run_scroll(lv_obj_t* col, uint32_t size, lv_color_t* frames)
+{
+    lv_draw_cache_set_size(size);
+    lv_obj_scroll_to_y(col, 0, LV_ANIM_OFF);
+    lv_refr_now(g_disp);
+    lv_draw_cache_reset_stats();
+    double t = now_us();
+    for (int i = 0; i < FRAMES; i++) {
+        lv_obj_scroll_by(col, 0, -SCROLL_STEP, LV_ANIM_OFF);
+        lv_refr_now(g_disp);
+        if (frames && i % 20 == 0) {
+            memcpy(&frames[(i / 20) * HOR * VER], g_frame, sizeof(g_frame));
+        }
+    }
+    return (now_us() - t) / FRAMES;
+}
+
+static const char* const g_type_names[] = {"shadow", "grad", "circle", "img"};
+
+TEST_CASE("the draw cache draws the same pixels as without it", "[lv_draw_cache]")
+{
+    disp_init();
+    lv_obj_t* col = cards_create(24);
+    lv_color_t* plain = malloc(FRAMES / 20 * sizeof(g_frame));
+    lv_color_t* cached = malloc(FRAMES / 20 * sizeof(g_frame));
+    run_scroll(col, 0, plain);
+    // a tiny budget too: the entries evict each other while drawing
+    uint32_t sizes[] = {LV_DRAW_CACHE_SIZE, 24 * 1024};
+    for (int s = 0; s < 2; s++) {
+        run_scroll(col, sizes[s], cached);
+        for (int f = 0; f < FRAMES / 20; f++) {
+            for (int i = 0; i < HOR * VER; i++) {
+                if (plain[f * HOR * VER + i].full != cached[f * HOR * VER + i].full) {
+                    printf("size %u: frame %d: px %d,%d differs\n", (unsigned)sizes[s], f * 20, i % HOR, i / HOR);
+                    TEST_ASSERT_EQUAL_HEX16(plain[f * HOR * VER + i].full, cached[f * HOR * VER + i].full);
+                }
+            }
+        }
+        uint32_t bytes = 0, evictions = 0;
+        for (int t = 0; t < _LV_DRAW_CACHE_TYPE_NUM; t++) {
+            lv_draw_cache_stats_t stats;
+            lv_draw_cache_get_stats(t, &stats);
+            TEST_ASSERT_GREATER_THAN(0, stats.hits);
+            bytes += stats.bytes;
+            evictions += stats.evictions;
+        }
+        TEST_ASSERT_LESS_OR_EQUAL(sizes[s] / THREAD_NUM, bytes);
+        if (s == 1) {
+            TEST_ASSERT_GREATER_THAN(0, evictions);
+        }
+    }
+    free(plain);
+    free(cached);
+    lv_obj_del(col);
+}
+
+TEST_CASE("an invalidate drops the entries of its type only", "[lv_draw_cache]")
+{
+    disp_init();
+    lv_obj_t* col = cards_create(6);
+    lv_draw_cache_set_size(LV_DRAW_CACHE_SIZE);
+    lv_refr_now(g_disp);
+    lv_draw_cache_stats_t shadow, grad;
+    lv_draw_cache_get_stats(LV_DRAW_CACHE_SHADOW, &shadow);
+    TEST_ASSERT_GREATER_THAN(0, shadow.entries);
+    lv_draw_cache_get_stats(LV_DRAW_CACHE_GRAD, &grad);
+    uint32_t grad_entries = grad.entries;
+
+    lv_draw_cache_invalidate(LV_DRAW_CACHE_SHADOW);
+    lv_obj_invalidate(col);
+    lv_draw_cache_reset_stats();
+    lv_refr_now(g_disp);
+    // the shadows came in again, the gradients were found
+    lv_draw_cache_get_stats(LV_DRAW_CACHE_SHADOW, &shadow);
+    TEST_ASSERT_EQUAL_UINT32(0, shadow.evictions);
+    TEST_ASSERT_EQUAL_UINT32(shadow.misses, shadow.entries);
+    lv_draw_cache_get_stats(LV_DRAW_CACHE_GRAD, &grad);
+    TEST_ASSERT_EQUAL_UINT32(0, grad.misses);
+    TEST_ASSERT_EQUAL_UINT32(grad_entries, grad.entries);
+    lv_obj_del(col);
+}
+
+TEST_CASE("scrolling the cards, draw cache on and off", "[lv_draw_cache]")
+{
+    disp_init();
+    lv_obj_t* col = cards_create(40);
+    run_scroll(col, 0, NULL);   // warm up
+    // in turns, the best of a few runs each: a single run swings with the load of the host
+    double off_us = 1e9, on_us = 1e9;
+    for (int rep = 0; rep < 5; rep++) {
+        off_us = LV_MIN(off_us, run_scroll(col, 0, NULL));
+        on_us = LV_MIN(on_us, run_scroll(col, LV_DRAW_CACHE_SIZE, NULL));
+    }
+    printf("%dx%d cards, %d px a frame: %.0f us a frame without the cache, %.0f us with it (%.2fx)\n",
+           HOR, VER, SCROLL_STEP, off_us, on_us, off_us / on_us);
+    for (int t = 0; t < _LV_DRAW_CACHE_TYPE_NUM; t++) {
+        lv_draw_cache_stats_t stats;
+        lv_draw_cache_get_stats(t, &stats);
+        uint32_t lookups = stats.hits + stats.misses + stats.rejects;
+        printf("%-6s: %u lookups, %.1f%% hits, %u misses, %u rejects, %u evictions, %u entries in %u bytes\n",
+               g_type_names[t], (unsigned)lookups, lookups ? 100.0 * stats.hits / lookups : 0.0,
+               (unsigned)stats.misses, (unsigned)stats.rejects, (unsigned)stats.evictions, (unsigned)stats.entries,
+               (unsigned)stats.bytes);
+        // the same few shapes on every card, drawn again every frame
+        TEST_ASSERT_GREATER_THAN(lookups * 9 / 10, stats.hits);
+    }
+    // the timings are printed only, wall clock time on a loaded host would make a bound flaky
+    lv_obj_del(col);
+}
+
+#endif
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+#include "src/draw/esp_pie/lv_draw_esp_pie.h"
+
+#if LV_USE_GPU_ESP_PIE
+
+#define BUF_W       240
+#define BUF_H       24
+#define BUF_PX      (BUF_W * BUF_H)
+#define BENCH_ROUNDS    200
+
+static lv_disp_t* g_disp;
+static lv_draw_sw_ctx_t g_ctx;
+
+static void null_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_disp_flush_ready(drv);
+}
+
+// blend reads the display being refreshed, a headless one is enough
+static lv_draw_ctx_t* pie_ctx(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[BUF_PX];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, BUF_PX);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = BUF_W;
+        drv.ver_res = BUF_H;
+        drv.flush_cb = null_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+        lv_draw_esp_pie_ctx_init(&drv, &g_ctx.base_draw);
+    }
+    _lv_refr_set_disp_refreshing(g_disp);
+    return &g_ctx.base_draw;
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static uint32_t g_seed = 1;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return g_seed >> 8;
+}
+
+// the values every branch of fill_normal/map_normal turns on
+static lv_opa_t rnd_opa(void)
+{
+    static const lv_opa_t edges[] = {0, 1, 2, 127, 128, 252, 253, 254, 255};
+    return rnd() % 2 ? edges[rnd() % sizeof(edges)] : (lv_opa_t)rnd();
+}
+
+// room for px pixels from any of the 8 offsets into a 16 byte block
+static lv_color_t* aligned_px(uint32_t px)
+{
+    return aligned_alloc(16, (px + 8) * sizeof(lv_color_t));
+}
+
+static void run_blend(lv_draw_ctx_t* ctx, lv_color_t* dest, lv_area_t* buf_area, const lv_area_t* clip,
+                      const lv_draw_sw_blend_dsc_t* dsc, bool pie)
+{
+    ctx->buf = dest;
+    ctx->buf_area = buf_area;
+    ctx->clip_area = clip;
+    if (pie) {
+        lv_draw_esp_pie_blend(ctx, dsc);
+    } else {
+        lv_draw_sw_blend_basic(ctx, dsc);
+    }
+}
+
+TEST_CASE("pie blend is bit exact with lv_draw_sw_blend_basic", "[lv_draw_esp_pie]")
+{
+    lv_draw_ctx_t* ctx = pie_ctx();
+    lv_area_t buf_area = {0, 0, BUF_W - 1, BUF_H - 1};
+    lv_color_t* expect = malloc(BUF_PX * sizeof(lv_color_t));
+    lv_color_t* got_base = aligned_px(BUF_PX);
+    lv_color_t* src_base = aligned_px(BUF_PX);
+    lv_opa_t* mask = malloc(BUF_PX);
+
+    for (int n = 0; n < 3000; n++) {
+        // every alignment of dest and src against the 16 byte blocks
+        lv_color_t* got = got_base + rnd() % 8;
+        lv_color_t* src = src_base + rnd() % 8;
+        for (int i = 0; i < BUF_PX; i++) {
+            expect[i].full = got[i].full = (uint16_t)rnd();
+            src[i].full = (uint16_t)rnd();
+        }
+        lv_area_t area;
+        area.x1 = rnd() % BUF_W - 8;
+        area.y1 = rnd() % BUF_H - 2;
+        area.x2 = area.x1 + 1 + rnd() % (n % 4 ? BUF_W : 24);
+        area.y2 = area.y1 + rnd() % 6;
+        lv_area_t clip = {rnd() % 8, 0, BUF_W - 1 - rnd() % 8, BUF_H - 1};
+
+        uint32_t mask_kind = rnd() % 4;
+        for (int i = 0; i < lv_area_get_size(&area); i++) {
+            mask[i] = mask_kind == 0 ? rnd_opa() : mask_kind == 1 ? 255 : mask_kind == 2 ? 0 : (lv_opa_t)rnd();
+        }
+        // runs of 0 and 255 as antialiased edges have them
+        if (mask_kind == 3 && lv_area_get_size(&area) > 80) {
+            memset(mask + 8, 0, 40);
+            memset(mask + 48, 255, 30);
+        }
+
+        lv_draw_sw_blend_dsc_t dsc = {
+            .blend_area = &area,
+            .src_buf = rnd() % 2 ? src : NULL,
+            .color.full = (uint16_t)rnd(),
+            .mask_buf = rnd() % 3 ? mask : NULL,
+            .mask_res = rnd() % 5 ? LV_DRAW_MASK_RES_CHANGED : LV_DRAW_MASK_RES_FULL_COVER,
+            .mask_area = &area,
+            .opa = rnd_opa(),
+            .blend_mode = rnd() % 16 ? LV_BLEND_MODE_NORMAL : LV_BLEND_MODE_ADDITIVE,
+        };
+        // lv_draw_sw_blend never passes these on
+        if (dsc.opa <= LV_OPA_MIN) {
+            dsc.opa = LV_OPA_COVER;
+        }
+
+        run_blend(ctx, expect, &buf_area, &clip, &dsc, false);
+        run_blend(ctx, got, &buf_area, &clip, &dsc, true);
+        for (int i = 0; i < BUF_PX; i++) {
+            if (expect[i].full != got[i].full) {
+                printf("case %d: px %d,%d of area %d,%d %d,%d src %d mask %d opa %d\n", n, i % BUF_W, i / BUF_W,
+                       area.x1, area.y1, area.x2, area.y2, dsc.src_buf != NULL, dsc.mask_buf != NULL, dsc.opa);
+                TEST_ASSERT_EQUAL_HEX16(expect[i].full, got[i].full);
+            }
+        }
+    }
+    free(expect);
+    free(got_base);
+    free(src_base);
+    free(mask);
+}
+
+typedef struct {
+    const char* name;
+    bool src;
+    bool mask;
+    lv_opa_t opa;
+} bench_t;
+
+TEST_CASE("pie blend on its model against lv_draw_sw_blend_basic, timed", "[lv_draw_esp_pie]")
+{
+    // a full-width band of the display, as the refresh blends it
+    static const bench_t benches[] = {
+        {"fill", false, false, LV_OPA_COVER},
+        {"fill, opa", false, false, LV_OPA_50},
+        {"fill, mask", false, true, LV_OPA_COVER},
+        {"copy", true, false, LV_OPA_COVER},
+        {"copy, opa", true, false, LV_OPA_50},
+        {"copy, mask and opa", true, true, LV_OPA_70},
+    };
+    lv_draw_ctx_t* ctx = pie_ctx();
+    lv_area_t buf_area = {0, 0, BUF_W - 1, BUF_H - 1};
+    lv_color_t* dest = aligned_px(BUF_PX);
+    lv_color_t* src = aligned_px(BUF_PX);
+    lv_opa_t* mask = malloc(BUF_PX);
+    for (int i = 0; i < BUF_PX; i++) {
+        dest[i].full = (uint16_t)rnd();
+        src[i].full = (uint16_t)rnd();
+        mask[i] = (lv_opa_t)rnd();
+    }
+
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        const bench_t* bench = &benches[b];
+        lv_draw_sw_blend_dsc_t dsc = {
+            .blend_area = &buf_area,
+            .src_buf = bench->src ? src : NULL,
+            .color.full = 0x1234,
+            .mask_buf = bench->mask ? mask : NULL,
+            .mask_res = bench->mask ? LV_DRAW_MASK_RES_CHANGED : LV_DRAW_MASK_RES_FULL_COVER,
+            .mask_area = &buf_area,
+            .opa = bench->opa,
+            .blend_mode = LV_BLEND_MODE_NORMAL,
+        };
+
+        // the two in turns, for the load of the host to slow them alike
+        double us[2] = {1e9, 1e9};
+        for (int rep = 0; rep < 9; rep++) {
+            for (int pie = 0; pie < 2; pie++) {
+                double t = now_us();
+                for (int i = 0; i < BENCH_ROUNDS; i++) {
+                    run_blend(ctx, dest, &buf_area, &buf_area, &dsc, pie);
+                }
+                us[pie] = LV_MIN(us[pie], (now_us() - t) / BENCH_ROUNDS);
+            }
+        }
+        printf("%-20s %dx%d px: %6.1f us basic, %6.1f us on the PIE model (%.2fx)\n", bench->name, BUF_W, BUF_H,
+               us[0], us[1], us[0] / us[1]);
+    }
+    free(dest);
+    free(src);
+    free(mask);
+}
+
+#endif
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+#include "src/draw/sw/lv_draw_sw.h"
+
+#if LV_COLOR_DEPTH == 16
+
+#define SRC_MAX     96
+#define DEST_MAX    160
+#define BENCH_ROUNDS 200
+
+static lv_disp_t* g_disp;
+static lv_draw_sw_ctx_t g_ctx;
+
+static void null_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_disp_flush_ready(drv);
+}
+
+// the kernels read the chroma key of the display being refreshed, a headless one is enough
+static lv_draw_ctx_t* sw_ctx(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[DEST_MAX * 8];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, DEST_MAX * 8);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = DEST_MAX;
+        drv.ver_res = 8;
+        drv.flush_cb = null_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+        lv_draw_sw_init_ctx(&drv, &g_ctx.base_draw);
+    }
+    _lv_refr_set_disp_refreshing(g_disp);
+    return &g_ctx.base_draw;
+}
+
+static uint32_t g_seed = 1;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return g_seed >> 8;
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static const lv_img_cf_t g_cfs[] = {LV_IMG_CF_TRUE_COLOR, LV_IMG_CF_TRUE_COLOR_ALPHA, LV_IMG_CF_RGB565A8};
+static const char* const g_cf_names[] = {"RGB565", "ARGB8565", "RGB565A8"};
+
+// smooth areas and hard edges, alpha from clear to opaque: both branches of the anti-aliasing
+static uint8_t* src_create(lv_img_cf_t cf, lv_coord_t w, lv_coord_t h)
+{
+    uint8_t* src = malloc(SRC_MAX * SRC_MAX * LV_IMG_PX_SIZE_ALPHA_BYTE);
+    lv_opa_t* a8 = src + w * h * sizeof(lv_color_t);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            lv_color_t c = (x / 8 + y / 8) % 3 ? lv_color_make(x * 4, y * 4, 128) : lv_color_make(rnd(), rnd(), rnd());
+            lv_opa_t a = x < 4 || y % 16 == 0 ? 0 : (x * 255 / w);
+            int i = y * w + x;
+            if (cf == LV_IMG_CF_TRUE_COLOR_ALPHA) {
+                src[i * 3] = c.full & 0xff;
+                src[i * 3 + 1] = c.full >> 8;
+                src[i * 3 + 2] = a;
+            } else {
+                ((lv_color_t*)src)[i] = c;
+                if (cf == LV_IMG_CF_RGB565A8) {
+                    a8[i] = a;
+                }
+            }
+        }
+    }
+    return src;
+}
+
+static void run(lv_draw_ctx_t* ctx, const lv_area_t* dest, const uint8_t* src, lv_coord_t w, lv_coord_t h,
+                const lv_draw_img_dsc_t* dsc, lv_img_cf_t cf, lv_color_t* cbuf, lv_opa_t* abuf, bool basic)
+{
+    if (basic) {
+        lv_draw_sw_transform_basic(ctx, dest, src, w, h, w, dsc, cf, cbuf, abuf);
+    } else {
+        lv_draw_sw_transform(ctx, dest, src, w, h, w, dsc, cf, cbuf, abuf);
+    }
+}
+
+TEST_CASE("transform kernels are bit exact with lv_draw_sw_transform_basic", "[lv_draw_sw_transform]")
+{
+    static const int16_t angles[] = {0, 900, 1800, 2700, 450, 3599, 1};
+    lv_draw_ctx_t* ctx = sw_ctx();
+    lv_color_t* expect_c = malloc(DEST_MAX * DEST_MAX * sizeof(lv_color_t));
+    lv_color_t* got_c = malloc(DEST_MAX * DEST_MAX * sizeof(lv_color_t));
+    lv_opa_t* expect_a = malloc(DEST_MAX * DEST_MAX);
+    lv_opa_t* got_a = malloc(DEST_MAX * DEST_MAX);
+    for (int round = 0; round < 3000; round++) {
+        lv_img_cf_t cf = g_cfs[round % 3];
+        lv_coord_t w = 1 + rnd() % SRC_MAX;
+        lv_coord_t h = 1 + rnd() % SRC_MAX;
+        uint8_t* src = src_create(cf, w, h);
+
+        lv_draw_img_dsc_t dsc;
+        lv_draw_img_dsc_init(&dsc);
+        dsc.angle = rnd() % 2 ? angles[rnd() % 7] : rnd() % 3600;
+        dsc.zoom = rnd() % 3 ? LV_IMG_ZOOM_NONE : 32 + rnd() % 1024;
+        if (dsc.angle == 0 && dsc.zoom == LV_IMG_ZOOM_NONE) {
+            dsc.zoom = 300;
+        }
+        dsc.pivot.x = rnd() % w;
+        dsc.pivot.y = rnd() % h;
+        dsc.antialias = rnd() % 2;
+
+        // anywhere around the image, out of it too
+        lv_area_t dest;
+        dest.x1 = (int32_t)(rnd() % (w + 80)) - 40;
+        dest.y1 = (int32_t)(rnd() % (h + 80)) - 40;
+        dest.x2 = dest.x1 + rnd() % DEST_MAX;
+        dest.y2 = dest.y1 + rnd() % DEST_MAX;
+        uint32_t px = lv_area_get_size(&dest);
+
+        // what a kernel leaves alone must be left alone by both
+        for (uint32_t i = 0; i < px; i++) {
+            expect_c[i].full = got_c[i].full = rnd();
+            expect_a[i] = got_a[i] = rnd();
+        }
+        run(ctx, &dest, src, w, h, &dsc, cf, expect_c, expect_a, true);
+        run(ctx, &dest, src, w, h, &dsc, cf, got_c, got_a, false);
+        for (uint32_t i = 0; i < px; i++) {
+            if (expect_c[i].full != got_c[i].full || expect_a[i] != got_a[i]) {
+                printf("round %d: %s %dx%d, angle %d, zoom %d, pivot %d,%d, aa %d: px %d,%d differs\n", round,
+                       g_cf_names[round % 3], w, h, dsc.angle, dsc.zoom, dsc.pivot.x, dsc.pivot.y, dsc.antialias,
+                       (int)(dest.x1 + i % lv_area_get_width(&dest)), (int)(dest.y1 + i / lv_area_get_width(&dest)));
+                TEST_ASSERT_EQUAL_HEX8(expect_a[i], got_a[i]);
+                TEST_ASSERT_EQUAL_HEX16(expect_c[i].full, got_c[i].full);
+            }
+        }
+        free(src);
+    }
+    free(expect_c);
+    free(got_c);
+    free(expect_a);
+    free(got_a);
+}
+
+TEST_CASE("right angles move whole pixels", "[lv_draw_sw_transform]")
+{
+    lv_draw_ctx_t* ctx = sw_ctx();
+    const lv_coord_t size = 40;
+    uint8_t* src = src_create(LV_IMG_CF_TRUE_COLOR, size, size);
+    const lv_color_t* src_c = (const lv_color_t*)src;
+    lv_color_t* cbuf = malloc(size * size * sizeof(lv_color_t));
+    lv_opa_t* abuf = malloc(size * size);
+
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+    dsc.pivot.x = size / 2;
+    dsc.pivot.y = size / 2;
+    dsc.antialias = 0;
+    lv_area_t dest = {0, 0, size - 1, size - 1};
+    for (int basic = 0; basic < 2; basic++) {
+        for (dsc.angle = 900; dsc.angle < 3600; dsc.angle += 900) {
+            run(ctx, &dest, src, size, size, &dsc, LV_IMG_CF_TRUE_COLOR, cbuf, abuf, basic);
+            for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++) {
+                    // the pixel of the source the dest pixel came from, about the pivot
+                    int dx = x - size / 2, dy = y - size / 2;
+                    int sx = dsc.angle == 900 ? dy : dsc.angle == 1800 ? -dx : -dy;
+                    int sy = dsc.angle == 900 ? -dx : dsc.angle == 1800 ? -dy : dx;
+                    sx += size / 2;
+                    sy += size / 2;
+                    if (sx < 0 || sx >= size || sy < 0 || sy >= size) {
+                        TEST_ASSERT_EQUAL_HEX8(0, abuf[y * size + x]);
+                    } else {
+                        TEST_ASSERT_EQUAL_HEX8(0xff, abuf[y * size + x]);
+                        TEST_ASSERT_EQUAL_HEX16(src_c[sy * size + sx].full, cbuf[y * size + x].full);
+                    }
+                }
+            }
+        }
+    }
+    free(src);
+    free(cbuf);
+    free(abuf);
+}
+
+typedef struct {
+    const char* name;
+    lv_img_cf_t cf;
+    lv_coord_t size;
+    int16_t angle;
+    uint16_t zoom;
+    bool aa;
+} bench_t;
+
+TEST_CASE("transform kernels against the basic transform", "[lv_draw_sw_transform]")
+{
+    // the thinking spinner is a 64 px ARGB icon, the avatar a 96 px RGB565 photo zoomed in and out
+    static const bench_t benches[] = {
+        {"zoom, nearest", LV_IMG_CF_TRUE_COLOR, 96, 0, 384, false},
+        {"zoom, bilinear", LV_IMG_CF_TRUE_COLOR, 96, 0, 384, true},
+        {"zoom, bilinear", LV_IMG_CF_RGB565A8, 96, 0, 200, true},
+        {"90 deg, nearest", LV_IMG_CF_TRUE_COLOR, 96, 900, 256, false},
+        {"90 deg, bilinear", LV_IMG_CF_TRUE_COLOR_ALPHA, 64, 900, 256, true},
+        {"rotate, nearest", LV_IMG_CF_TRUE_COLOR_ALPHA, 64, 300, 256, false},
+        {"rotate, bilinear", LV_IMG_CF_TRUE_COLOR_ALPHA, 64, 300, 256, true},
+        {"rotate+zoom, bilinear", LV_IMG_CF_RGB565A8, 64, 1234, 320, true},
+    };
+    lv_draw_ctx_t* ctx = sw_ctx();
+    lv_color_t* cbuf = malloc(DEST_MAX * DEST_MAX * sizeof(lv_color_t));
+    lv_opa_t* abuf = malloc(DEST_MAX * DEST_MAX);
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        const bench_t* bench = &benches[b];
+        uint8_t* src = src_create(bench->cf, bench->size, bench->size);
+        lv_draw_img_dsc_t dsc;
+        lv_draw_img_dsc_init(&dsc);
+        dsc.angle = bench->angle;
+        dsc.zoom = bench->zoom;
+        dsc.pivot.x = bench->size / 2;
+        dsc.pivot.y = bench->size / 2;
+        dsc.antialias = bench->aa;
+
+        // the bounding box the image is redrawn in, as lv_draw_img gives it
+        lv_area_t dest;
+        _lv_img_buf_get_transformed_area(&dest, bench->size, bench->size, dsc.angle, dsc.zoom, &dsc.pivot);
+        TEST_ASSERT_LESS_OR_EQUAL(DEST_MAX * DEST_MAX, lv_area_get_size(&dest));
+
+        // the two in turns, for the load of the host to slow them alike
+        double us[2] = {1e9, 1e9};
+        for (int rep = 0; rep < 9; rep++) {
+            for (int basic = 0; basic < 2; basic++) {
+                double t = now_us();
+                for (int i = 0; i < BENCH_ROUNDS; i++) {
+                    run(ctx, &dest, src, bench->size, bench->size, &dsc, bench->cf, cbuf, abuf, basic);
+                }
+                us[basic] = LV_MIN(us[basic], (now_us() - t) / BENCH_ROUNDS);
+            }
+        }
+        printf("%-22s %-8s %2d px, %dx%d out: %6.1f us basic, %6.1f us kernel (%.2fx)\n", bench->name,
+               g_cf_names[bench->cf == LV_IMG_CF_TRUE_COLOR ? 0 : bench->cf == LV_IMG_CF_TRUE_COLOR_ALPHA ? 1 : 2],
+               bench->size, lv_area_get_width(&dest), lv_area_get_height(&dest), us[1], us[0], us[1] / us[0]);
+        free(src);
+    }
+    free(cbuf);
+    free(abuf);
+}
+
+#endif
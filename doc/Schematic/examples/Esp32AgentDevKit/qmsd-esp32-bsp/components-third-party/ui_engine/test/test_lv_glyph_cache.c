@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#if LV_USE_GLYPH_CACHE
+
+#define HOR         480
+#define VER         480
+#define FRAMES      120
+#define SCROLL_STEP 6
+
+static lv_color_t g_frame[HOR * VER];
+static lv_disp_t* g_disp;
+
+static void frame_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&g_frame[y * HOR + area->x1], color_p, w * sizeof(lv_color_t));
+        color_p += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_init(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[HOR * VER];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, HOR * VER);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = HOR;
+        drv.ver_res = VER;
+        drv.flush_cb = frame_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+    }
+    // the test files share lv_init: make the widgets go on this display
+    lv_disp_set_default(g_disp);
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static const char* const g_lines[] = {
+    "Hi! What's the weather like in Shanghai tomorrow?",
+    "Tomorrow in Shanghai: light rain in the morning, clearing up by noon. 18 to 24 C, a light east wind.",
+    "Should I take an umbrella to the office then?",
+    "Yes, take one for the morning. You can leave it at work, the evening stays dry.",
+    "Remind me at 8:30 to leave, and play some quiet music until then.",
+    "Done: a reminder at 8:30, and a calm playlist is playing now.",
+#if LV_FONT_SIMSUN_16_CJK
+    "明天上海的天气怎么样？",
+    "明天上海早上有小雨，中午转晴，气温十八到二十四度，东风一到二级。",
+    "那我去公司要带伞吗？",
+    "早上出门记得带伞，晚上不会下雨，可以把伞留在公司。",
+#endif
+};
+#define LINE_NUM    (sizeof(g_lines) / sizeof(g_lines[0]))
+
+// A chat transcript: bubbles left and right, some faded, in a scrolling column
+// with rounded corners (a radius mask over the text while it scrolls)
+static lv_obj_t* transcript_create(int bubbles)
+{
+    lv_obj_t* col = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(col, HOR - 20, VER - 20);
+    lv_obj_center(col);
+    lv_obj_set_style_radius(col, 24, 0);
+    lv_obj_set_style_clip_corner(col, true, 0);
+    lv_obj_set_flex_flow(col, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_scrollbar_mode(col, LV_SCROLLBAR_MODE_OFF);
+    for (int i = 0; i < bubbles; i++) {
+        const char* text = g_lines[i % LINE_NUM];
+        lv_obj_t* label = lv_label_create(col);
+        lv_label_set_text(label, text);
+        lv_obj_set_width(label, HOR * 2 / 3);
+        lv_obj_set_style_pad_all(label, 8, 0);
+        lv_obj_set_style_radius(label, 12, 0);
+        lv_obj_set_style_bg_opa(label, LV_OPA_COVER, 0);
+        lv_obj_set_style_bg_color(label, lv_palette_lighten(i % 2 ? LV_PALETTE_BLUE : LV_PALETTE_GREY, 3), 0);
+        lv_obj_set_style_align(label, i % 2 ? LV_ALIGN_TOP_RIGHT : LV_ALIGN_TOP_LEFT, 0);
+        if ((unsigned char)text[0] >= 0x80) {
+#if LV_FONT_SIMSUN_16_CJK
+            lv_obj_set_style_text_font(label, &lv_font_simsun_16_cjk, 0);
+#endif
+        } else if (i % 7 == 3) {
+#if LV_FONT_MONTSERRAT_28_COMPRESSED
+            lv_obj_set_style_text_font(label, &lv_font_montserrat_28_compressed, 0);
+#endif
+        }
+        if (i % 5 == 4) {
+            lv_obj_set_style_text_opa(label, LV_OPA_60, 0);
+        }
+    }
+    return col;
+}
+
+// Scroll the column up a step a frame and render it, the cache on (sizes) or off (0)
+static double run_scroll(lv_obj_t* col, uint32_t size, uint32_t fast_size, lv_color_t* frames)
+{
+    lv_draw_sw_glyph_cache_set_size(size, fast_size);
+    lv_obj_scroll_to_y(col, 0, LV_ANIM_OFF);
+    lv_refr_now(g_disp);
+    lv_draw_sw_glyph_cache_reset_stats();
+    double t = now_us();
+    for (int i = 0; i < FRAMES; i++) {
+        lv_obj_scroll_by(col, 0, -SCROLL_STEP, LV_ANIM_OFF);
+        lv_refr_now(g_disp);
+        if (frames && i % 20 == 0) {
+            memcpy(&frames[(i / 20) * HOR * VER], g_frame, sizeof(g_frame));
+        }
+    }
+    return (now_us() - t) / FRAMES;
+}
+
+TEST_CASE("cached glyphs draw the same pixels as the font", "[lv_glyph_cache]")
+{
+    disp_init();
+    lv_obj_t* col = transcript_create(40);
+    lv_color_t* plain = malloc(FRAMES / 20 * sizeof(g_frame));
+    lv_color_t* cached = malloc(FRAMES / 20 * sizeof(g_frame));
+    run_scroll(col, 0, 0, plain);
+    // a tiny main tier too: eviction and reuse of slots while drawing
+    uint32_t sizes[][2] = {{LV_GLYPH_CACHE_SIZE, LV_GLYPH_CACHE_FAST_SIZE}, {8 * 1024, 4 * 1024}, {16 * 1024, 0}};
+    for (int s = 0; s < 3; s++) {
+        run_scroll(col, sizes[s][0], sizes[s][1], cached);
+        for (int f = 0; f < FRAMES / 20; f++) {
+            for (int i = 0; i < HOR * VER; i++) {
+                if (plain[f * HOR * VER + i].full != cached[f * HOR * VER + i].full) {
+                    printf("sizes %d: frame %d: px %d,%d differs\n", s, f * 20, i % HOR, i / HOR);
+                    TEST_ASSERT_EQUAL_HEX16(plain[f * HOR * VER + i].full, cached[f * HOR * VER + i].full);
+                }
+            }
+        }
+        lv_glyph_cache_stats_t stats;
+        lv_draw_sw_glyph_cache_get_stats(&stats);
+        TEST_ASSERT_GREATER_THAN(0, stats.hits);
+        TEST_ASSERT_LESS_OR_EQUAL(stats.size, stats.bytes);
+        TEST_ASSERT_LESS_OR_EQUAL(stats.fast_size, stats.fast_bytes);
+        if (s == 1) {
+            TEST_ASSERT_GREATER_THAN(0, stats.evictions);
+        }
+    }
+    free(plain);
+    free(cached);
+    lv_obj_del(col);
+}
+
+TEST_CASE("an invalidate drops the glyphs of every font", "[lv_glyph_cache]")
+{
+    disp_init();
+    lv_obj_t* col = transcript_create(8);
+    lv_draw_sw_glyph_cache_set_size(LV_GLYPH_CACHE_SIZE, LV_GLYPH_CACHE_FAST_SIZE);
+    lv_refr_now(g_disp);
+    lv_glyph_cache_stats_t stats;
+    lv_draw_sw_glyph_cache_get_stats(&stats);
+    TEST_ASSERT_GREATER_THAN(0, stats.entries);
+
+    lv_draw_sw_glyph_cache_invalidate();
+    lv_obj_invalidate(col);
+    lv_draw_sw_glyph_cache_reset_stats();
+    lv_refr_now(g_disp);
+    lv_draw_sw_glyph_cache_get_stats(&stats);
+    // the first letter after the invalidate found an empty cache: all it holds now came in again
+    TEST_ASSERT_EQUAL_UINT32(0, stats.evictions);
+    TEST_ASSERT_EQUAL_UINT32(stats.misses, stats.entries);
+    lv_obj_del(col);
+}
+
+TEST_CASE("scrolling a transcript, glyph cache on and off", "[lv_glyph_cache]")
+{
+    disp_init();
+    lv_obj_t* col = transcript_create(60);
+    run_scroll(col, 0, 0, NULL);    // warm up
+    double off_us = LV_MIN(run_scroll(col, 0, 0, NULL), run_scroll(col, 0, 0, NULL));
+    double on_us = LV_MIN(run_scroll(col, LV_GLYPH_CACHE_SIZE, LV_GLYPH_CACHE_FAST_SIZE, NULL),
+                          run_scroll(col, LV_GLYPH_CACHE_SIZE, LV_GLYPH_CACHE_FAST_SIZE, NULL));
+    lv_glyph_cache_stats_t stats;
+    lv_draw_sw_glyph_cache_get_stats(&stats);
+    uint32_t lookups = stats.hits + stats.misses + stats.uncached;
+    printf("%dx%d transcript, %d px a frame: %.0f us a frame without the cache, %.0f us with it (%.2fx)\n",
+           HOR, VER, SCROLL_STEP, off_us, on_us, off_us / on_us);
+    printf("glyph cache: %u lookups, %.1f%% hits (%.1f%% hot), %u misses, %u evictions, %u glyphs in %u/%u bytes, "
+           "%u hot in %u/%u bytes, %u promotions\n",
+           (unsigned)lookups, 100.0 * stats.hits / lookups, 100.0 * stats.fast_hits / lookups, (unsigned)stats.misses,
+           (unsigned)stats.evictions, (unsigned)stats.entries, (unsigned)stats.bytes, (unsigned)stats.size,
+           (unsigned)stats.fast_entries, (unsigned)stats.fast_bytes, (unsigned)stats.fast_size,
+           (unsigned)stats.promotions);
+    // every glyph on screen is drawn again next frame, the few new ones come in at the bottom
+    TEST_ASSERT_GREATER_THAN(lookups * 95 / 100, stats.hits);
+    // the timings are printed only, wall clock time on a loaded host would make a bound flaky
+    lv_obj_del(col);
+}
+
+#endif
@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#if LV_LABEL_METRICS_CACHE
+
+#define HOR         480
+#define VER         480
+#define STEPS       1500
+#define TEXT_MAX    2500
+#define PROBES      12
+#define KEYS        40
+#define REPS        5
+
+static lv_disp_t* g_disp;
+static lv_color_t g_fb[HOR * VER];
+
+static void frame_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&g_fb[y * HOR + area->x1], color_p, lv_area_get_width(area) * sizeof(lv_color_t));
+        color_p += lv_area_get_width(area);
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_init(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[HOR * VER / 10];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, HOR * VER / 10);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = HOR;
+        drv.ver_res = VER;
+        drv.flush_cb = frame_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+    }
+    // the test files share lv_init: make the widgets go on this display
+    lv_disp_set_default(g_disp);
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand() % n;
+}
+
+static const char* const g_words[] = {
+    "a", "the", "weather", "tomorrow", "light", "rain,", "sunny.", "18-24", "degrees;", "Wi-Fi:", "password_123",
+    "\xc3\xa9t\xc3\xa9", "\xe4\xbd\xa0\xe5\xa5\xbd", "supercalifragilisticexpialidocious", "#ff0000 red#", "\n",
+    "\r\n", " ", "  ",
+};
+#define WORD_NUM    (sizeof(g_words) / sizeof(g_words[0]))
+
+// A text of words and spaces, a new line now and then
+static void text_make(char* buf, uint32_t len)
+{
+    uint32_t i = 0;
+    while (i < len) {
+        const char* w = g_words[rnd(WORD_NUM - 5)];
+        if (rnd(12) == 0) w = "\n";
+        uint32_t n = strlen(w);
+        if (i + n + 1 >= len) break;
+        memcpy(&buf[i], w, n);
+        i += n;
+        buf[i++] = ' ';
+    }
+    buf[i] = '\0';
+}
+
+// What the label looks at to break its text, as lv_label_refr_text does
+static void key_get(lv_obj_t* label, const lv_font_t** font, lv_coord_t* letter_space, lv_coord_t* max_w,
+                    lv_text_flag_t* flag)
+{
+    lv_label_t* l = (lv_label_t*)label;
+    *font = lv_obj_get_style_text_font(label, LV_PART_MAIN);
+    *letter_space = lv_obj_get_style_text_letter_space(label, LV_PART_MAIN);
+    *max_w = lv_obj_get_content_width(label);
+    *flag = LV_TEXT_FLAG_NONE;
+    if (l->recolor) *flag |= LV_TEXT_FLAG_RECOLOR;
+    if (l->expand) *flag |= LV_TEXT_FLAG_EXPAND;
+    if (lv_obj_get_style_width(label, LV_PART_MAIN) == LV_SIZE_CONTENT && !label->w_layout) *flag |= LV_TEXT_FLAG_FIT;
+}
+
+// The kept lines against breaking the whole text again
+static void lines_check(lv_obj_t* label, int step, int op)
+{
+    lv_label_t* l = (lv_label_t*)label;
+    const char* txt = l->text;
+    if (strlen(txt) <= 64) return;
+
+    _lv_label_metrics_t* m = l->metrics;
+    TEST_ASSERT_NOT_NULL(m);
+    TEST_ASSERT_TRUE(m->valid);
+    TEST_ASSERT_FALSE(m->edited);
+
+    const lv_font_t* font;
+    lv_coord_t letter_space, max_w;
+    lv_text_flag_t flag;
+    key_get(label, &font, &letter_space, &max_w, &flag);
+
+    uint32_t start = 0, char_id = 0, line = 0;
+    while (txt[start] != '\0') {
+        uint32_t end = start + _lv_txt_get_next_line(&txt[start], font, letter_space, max_w, NULL, flag);
+        lv_coord_t w = lv_txt_get_width(&txt[start], end - start, font, letter_space, flag);
+        if (line >= m->line_cnt || m->lines[line].start != start || m->lines[line].char_id != char_id ||
+            m->lines[line].w != w) {
+            printf("step %d, op %d, line %u: %u, %u, %d broken again, %u, %u, %d kept\n", step, op, (unsigned)line,
+                   (unsigned)start, (unsigned)char_id, w, (unsigned)m->lines[line].start,
+                   (unsigned)m->lines[line].char_id, m->lines[line].w);
+        }
+        TEST_ASSERT_LESS_THAN_UINT32(m->line_cnt, line);
+        TEST_ASSERT_EQUAL_UINT32(start, m->lines[line].start);
+        TEST_ASSERT_EQUAL_UINT32(char_id, m->lines[line].char_id);
+        TEST_ASSERT_EQUAL_INT(w, m->lines[line].w);
+        char_id += _lv_txt_encoded_get_char_id(&txt[start], end - start);
+        start = end;
+        line++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(line, m->line_cnt);
+    TEST_ASSERT_EQUAL_UINT32(start, m->lines[line].start);
+    TEST_ASSERT_EQUAL_UINT32(char_id, m->lines[line].char_id);
+}
+
+typedef struct {
+    lv_point_t self_size;
+    lv_point_t letter_pos[PROBES];
+    uint32_t letter_on[PROBES];
+    bool under[PROBES];
+} answers_t;
+
+// What the label answers for some letters and points
+static void answers_get(lv_obj_t* label, const uint32_t* char_ids, const lv_point_t* points, answers_t* a)
+{
+    memset(a, 0, sizeof(*a));
+    lv_event_send(label, LV_EVENT_GET_SELF_SIZE, &a->self_size);
+    for (int i = 0; i < PROBES; i++) {
+        lv_label_get_letter_pos(label, char_ids[i], &a->letter_pos[i]);
+        lv_point_t p = points[i];
+        a->letter_on[i] = lv_label_get_letter_on(label, &p);
+        p = points[i];
+        a->under[i] = lv_label_is_char_under_pos(label, &p);
+    }
+}
+
+// The answers with the kept lines against the ones breaking the text every time
+static void answers_check(lv_obj_t* label, int step, int op)
+{
+    uint32_t len = _lv_txt_get_encoded_length(lv_label_get_text(label));
+    uint32_t char_ids[PROBES];
+    lv_point_t points[PROBES];
+    for (int i = 0; i < PROBES; i++) {
+        char_ids[i] = i == 0 ? 0 : i == 1 ? len : rnd(len + 1);
+        points[i].x = (lv_coord_t)rnd(lv_obj_get_width(label) + 40) - 20;
+        points[i].y = (lv_coord_t)rnd(lv_obj_get_height(label) + 40) - 20;
+    }
+
+    answers_t cached, uncached;
+    answers_get(label, char_ids, points, &cached);
+    lv_label_enable_metrics_cache(false);
+    answers_get(label, char_ids, points, &uncached);
+    lv_label_enable_metrics_cache(true);
+
+    if (memcmp(&cached, &uncached, sizeof(answers_t))) {
+        printf("step %d, op %d: size %d,%d cached, %d,%d breaking the text\n", step, op, cached.self_size.x,
+               cached.self_size.y, uncached.self_size.x, uncached.self_size.y);
+        for (int i = 0; i < PROBES; i++) {
+            printf("  letter %u at %d,%d / %d,%d; at %d,%d letter %u / %u, under: %d / %d\n", (unsigned)char_ids[i],
+                   cached.letter_pos[i].x, cached.letter_pos[i].y, uncached.letter_pos[i].x,
+                   uncached.letter_pos[i].y, points[i].x, points[i].y, (unsigned)cached.letter_on[i],
+                   (unsigned)uncached.letter_on[i], cached.under[i], uncached.under[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_MEMORY(&uncached, &cached, sizeof(answers_t));
+}
+
+// The screen drawn with the kept lines against drawing it breaking the text
+static void pixels_check(int step)
+{
+    static lv_color_t cached[HOR * VER];
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(g_disp);
+    memcpy(cached, g_fb, sizeof(cached));
+    lv_label_enable_metrics_cache(false);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(g_disp);
+    lv_label_enable_metrics_cache(true);
+    if (memcmp(cached, g_fb, sizeof(cached))) printf("step %d: the screen is drawn differently\n", step);
+    TEST_ASSERT_EQUAL_MEMORY(g_fb, cached, sizeof(cached));
+}
+
+TEST_CASE("a label's kept lines give what breaking its text does, through edits and changes", "[lv_label_metrics]")
+{
+    disp_init();
+    srand(50);
+    lv_obj_t* ta = lv_textarea_create(lv_scr_act());
+    lv_obj_set_size(ta, 220, 300);
+    lv_obj_t* label = lv_textarea_get_label(ta);
+    static char text[TEXT_MAX];
+    text_make(text, 900);
+    lv_textarea_set_text(ta, text);
+
+    uint32_t edits = 0;
+    for (int step = 0; step < STEPS; step++) {
+        int op = rnd(100);
+        uint32_t len = _lv_txt_get_encoded_length(lv_textarea_get_text(ta));
+        if (op < 30) {
+            // type a letter or a word somewhere
+            lv_textarea_set_cursor_pos(ta, rnd(len + 1));
+            if (len < TEXT_MAX - 100) {
+                if (rnd(2)) lv_textarea_add_char(ta, "ab ,\n"[rnd(5)]);
+                else lv_textarea_add_text(ta, g_words[rnd(WORD_NUM)]);
+                edits++;
+            }
+        } else if (op < 50) {
+            lv_textarea_set_cursor_pos(ta, rnd(len + 1));
+            if (rnd(2)) lv_textarea_del_char(ta);
+            else lv_textarea_del_char_forward(ta);
+            edits++;
+        } else if (op < 58 && len > 0) {
+            // cut a longer part
+            lv_label_cut_text(label, rnd(len), 1 + rnd(LV_MIN(len, 120)));
+            edits++;
+        } else if (op < 62) {
+            lv_label_ins_text(label, LV_LABEL_POS_LAST, g_words[rnd(WORD_NUM)]);
+            edits++;
+        } else if (op < 68) {
+            lv_obj_set_width(ta, 120 + rnd(300));
+        } else if (op < 72) {
+            lv_obj_set_style_text_letter_space(ta, rnd(4), 0);
+        } else if (op < 76) {
+            static const lv_text_align_t aligns[] = {LV_TEXT_ALIGN_LEFT, LV_TEXT_ALIGN_CENTER, LV_TEXT_ALIGN_RIGHT};
+            lv_obj_set_style_text_align(ta, aligns[rnd(3)], 0);
+        } else if (op < 79) {
+            lv_label_set_recolor(label, rnd(2));
+        } else if (op < 82) {
+            // one line mode sizes the label to its text
+            lv_textarea_set_one_line(ta, rnd(4) == 0);
+            if (!lv_textarea_get_one_line(ta)) lv_obj_set_height(ta, 300);
+        } else if (op < 84) {
+            text_make(text, 100 + rnd(TEXT_MAX - 200));
+            lv_textarea_set_text(ta, text);
+        } else if (op < 86) {
+            const lv_font_t* font = LV_FONT_DEFAULT;
+#if LV_FONT_SIMSUN_16_CJK
+            if (rnd(2)) font = &lv_font_simsun_16_cjk;
+#endif
+            lv_obj_set_style_text_font(ta, font, 0);
+        } else {
+            lv_obj_scroll_to_y(ta, rnd(lv_obj_get_scroll_bottom(ta) + lv_obj_get_scroll_y(ta) + 1), LV_ANIM_OFF);
+        }
+        lv_obj_update_layout(lv_scr_act());
+        lines_check(label, step, op);
+        answers_check(label, step, op);
+        if (step % 50 == 0) pixels_check(step);
+    }
+    printf("%u edits\n", (unsigned)edits);
+    lv_obj_del(ta);
+}
+
+// A keystroke in a text area: the character, the layout and drawing what it changed
+static double type_keys(lv_obj_t* ta, bool cached)
+{
+    lv_label_enable_metrics_cache(cached);
+    lv_textarea_add_char(ta, ' ');
+    lv_textarea_del_char(ta);
+    lv_refr_now(g_disp);
+
+    double t = now_us();
+    for (int i = 0; i < KEYS; i++) {
+        lv_textarea_add_char(ta, "hello, world "[i % 13]);
+        lv_refr_now(g_disp);
+    }
+    for (int i = 0; i < KEYS; i++) {
+        lv_textarea_del_char(ta);
+        lv_refr_now(g_disp);
+    }
+    t = (now_us() - t) / (2 * KEYS);
+    lv_label_enable_metrics_cache(true);
+    return t;
+}
+
+// Finding the letter under the pointer and the cursor of the next line
+static double hit_test(lv_obj_t* ta, bool cached)
+{
+    lv_label_enable_metrics_cache(cached);
+    lv_obj_t* label = lv_textarea_get_label(ta);
+    lv_coord_t h = lv_obj_get_height(label);
+    double t = now_us();
+    for (int i = 0; i < KEYS; i++) {
+        lv_point_t p = {(lv_coord_t)(i * 5), (lv_coord_t)(h - 1 - i * 3)};
+        uint32_t id = lv_label_get_letter_on(label, &p);
+        lv_label_get_letter_pos(label, id, &p);
+    }
+    t = (now_us() - t) / KEYS;
+    lv_label_enable_metrics_cache(true);
+    return t;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+    double d = *(const double*)a - *(const double*)b;
+    return d < 0 ? -1 : d > 0;
+}
+
+TEST_CASE("typing into a text area of 1 kB and 10 kB, line cache on and off", "[lv_label_metrics]")
+{
+    disp_init();
+    srand(10);
+    static char text[10 * 1024];
+    static const uint32_t sizes[] = {1024, 10 * 1024};
+    lv_obj_t* ta = lv_textarea_create(lv_scr_act());
+    lv_obj_set_size(ta, 300, 200);
+
+    for (int s = 0; s < 2; s++) {
+        text_make(text, sizes[s]);
+        lv_textarea_set_text(ta, text);
+        lv_obj_update_layout(lv_scr_act());
+        uint32_t lines = ((lv_label_t*)lv_textarea_get_label(ta))->metrics->line_cnt;
+
+        double off[REPS], on[REPS], hit_off[REPS], hit_on[REPS];
+        for (int rep = 0; rep < REPS; rep++) {
+            off[rep] = type_keys(ta, false);
+            on[rep] = type_keys(ta, true);
+            hit_off[rep] = hit_test(ta, false);
+            hit_on[rep] = hit_test(ta, true);
+        }
+        qsort(off, REPS, sizeof(double), cmp_double);
+        qsort(on, REPS, sizeof(double), cmp_double);
+        qsort(hit_off, REPS, sizeof(double), cmp_double);
+        qsort(hit_on, REPS, sizeof(double), cmp_double);
+
+        printf("%u bytes, %u lines: a keystroke %.1f us breaking the text, %.1f us with the kept lines (%.1fx); "
+               "a hit test %.1f us, %.1f us (%.1fx)\n", (unsigned)strlen(text), (unsigned)lines,
+               off[REPS / 2], on[REPS / 2], off[REPS / 2] / on[REPS / 2],
+               hit_off[REPS / 2], hit_on[REPS / 2], hit_off[REPS / 2] / hit_on[REPS / 2]);
+    }
+    lv_obj_del(ta);
+}
+
+#endif
@@ -0,0 +1,327 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#if LV_USE_LAYOUT_INCREMENTAL
+
+#define HOR         480
+#define VER         480
+#define CONT_NUM    6
+#define ITEM_MAX    90
+#define STEPS       2500
+#define OBJ_MAX     1024
+#define ITEMS       1000
+#define WINDOW      50
+
+static lv_disp_t* g_disp;
+
+static void frame_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_init(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[HOR * VER / 10];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, HOR * VER / 10);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = HOR;
+        drv.ver_res = VER;
+        drv.flush_cb = frame_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+    }
+    // the test files share lv_init: make the widgets go on this display
+    lv_disp_set_default(g_disp);
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand() % n;
+}
+
+static const char* const g_lines[] = {
+    "ok",
+    "Hello, what's the weather tomorrow?",
+    "Tomorrow: light rain in the morning, sunny from noon, 18 to 24 degrees.",
+    "Set a reminder at 8:30 and play something calm please, thanks a lot.",
+    "",
+    "A\nB\nC",
+};
+#define LINE_NUM    (sizeof(g_lines) / sizeof(g_lines[0]))
+
+static lv_coord_t g_grid_cols[] = {60, LV_GRID_CONTENT, LV_GRID_FR(1), LV_GRID_TEMPLATE_LAST};
+static lv_coord_t g_grid_rows[ITEM_MAX / 3 + 2];
+
+// The containers the items go in: every kind of flow and place the layout has a shortcut for, or not
+static lv_obj_t* g_conts[CONT_NUM];
+
+static void conts_create(lv_obj_t* root)
+{
+    // a fixed column, scrolled
+    g_conts[0] = lv_obj_create(root);
+    lv_obj_set_size(g_conts[0], 220, 300);
+    lv_obj_set_flex_flow(g_conts[0], LV_FLEX_FLOW_COLUMN);
+
+    // a column as high as its content, in a scrolled box: the chat list
+    lv_obj_t* box = lv_obj_create(root);
+    lv_obj_set_size(box, 220, 300);
+    g_conts[1] = lv_obj_create(box);
+    lv_obj_set_size(g_conts[1], LV_PCT(100), LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(g_conts[1], LV_FLEX_FLOW_COLUMN);
+
+    // wrapped rows, as high as their content
+    g_conts[2] = lv_obj_create(root);
+    lv_obj_set_size(g_conts[2], 300, LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(g_conts[2], LV_FLEX_FLOW_ROW_WRAP);
+
+    // wrapped rows spread out and centered in the track: laid out as a whole
+    g_conts[3] = lv_obj_create(root);
+    lv_obj_set_size(g_conts[3], 300, LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(g_conts[3], LV_FLEX_FLOW_ROW_WRAP);
+    lv_obj_set_flex_align(g_conts[3], LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_START);
+
+    // wrapped columns in a fixed box, the items at the end of their track
+    g_conts[4] = lv_obj_create(root);
+    lv_obj_set_size(g_conts[4], 400, 260);
+    lv_obj_set_flex_flow(g_conts[4], LV_FLEX_FLOW_COLUMN_WRAP);
+    lv_obj_set_flex_align(g_conts[4], LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_END, LV_FLEX_ALIGN_START);
+
+    // a grid of content rows, an item a cell in the order they come
+    for (int i = 0; i < ITEM_MAX / 3 + 1; i++) {
+        g_grid_rows[i] = LV_GRID_CONTENT;
+    }
+    g_grid_rows[ITEM_MAX / 3 + 1] = LV_GRID_TEMPLATE_LAST;
+    g_conts[5] = lv_obj_create(root);
+    lv_obj_set_size(g_conts[5], 320, LV_SIZE_CONTENT);
+    lv_obj_set_grid_dsc_array(g_conts[5], g_grid_cols, g_grid_rows);
+}
+
+// An item: a label, a box, or a bubble of labels as big as its content
+static void item_add(lv_obj_t* cont)
+{
+    uint32_t cnt = lv_obj_get_child_cnt(cont);
+    bool grid = cont == g_conts[5];
+    lv_obj_t* item;
+    switch (rnd(3)) {
+        case 0:
+            item = lv_label_create(cont);
+            lv_label_set_text_static(item, g_lines[rnd(LINE_NUM)]);
+            if (rnd(2)) {
+                lv_obj_set_width(item, grid ? 50 + rnd(60) : LV_PCT(30 + rnd(60)));
+            }
+            break;
+        case 1:
+            item = lv_obj_create(cont);
+            lv_obj_set_size(item, 10 + rnd(100), 10 + rnd(60));
+            break;
+        default:
+            item = lv_obj_create(cont);
+            lv_obj_set_size(item, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+            lv_obj_set_flex_flow(item, LV_FLEX_FLOW_COLUMN);
+            for (uint32_t i = rnd(3); i < 3; i++) {
+                lv_obj_t* label = lv_label_create(item);
+                lv_label_set_text_static(label, g_lines[rnd(LINE_NUM)]);
+            }
+            break;
+    }
+    if (grid) {
+        lv_obj_set_grid_cell(item, LV_GRID_ALIGN_START, cnt % 3, 1, LV_GRID_ALIGN_START, cnt / 3, 1);
+    }
+}
+
+// A label somewhere in an item, or NULL
+static lv_obj_t* label_find(lv_obj_t* obj)
+{
+    if (lv_obj_check_type(obj, &lv_label_class)) {
+        return obj;
+    }
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(obj); i++) {
+        lv_obj_t* label = label_find(lv_obj_get_child(obj, i));
+        if (label) {
+            return label;
+        }
+    }
+    return NULL;
+}
+
+static int coords_get(lv_obj_t* obj, lv_area_t* out, int n)
+{
+    out[n++] = obj->coords;
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(obj); i++) {
+        n = coords_get(lv_obj_get_child(obj, i), out, n);
+    }
+    return n;
+}
+
+// Lay out every object again, not only the ones changed
+static void layout_mark(lv_obj_t* obj)
+{
+    lv_obj_mark_layout_as_dirty(obj);
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(obj); i++) {
+        layout_mark(lv_obj_get_child(obj, i));
+    }
+}
+
+// What the changes gave against laying out the whole tree again from it
+static void check_tree(lv_obj_t* root, int step, int op)
+{
+    static lv_area_t inc[OBJ_MAX], full[OBJ_MAX];
+    lv_obj_update_layout(root);
+    int n = coords_get(root, inc, 0);
+    layout_mark(root);
+    lv_obj_update_layout(root);
+    TEST_ASSERT_EQUAL_INT(n, coords_get(root, full, 0));
+    for (int i = 0; i < n; i++) {
+        if (memcmp(&inc[i], &full[i], sizeof(lv_area_t))) {
+            printf("step %d, op %d, object %d: %d,%d %d,%d changed, %d,%d %d,%d laid out again\n", step, op, i,
+                   inc[i].x1, inc[i].y1, inc[i].x2, inc[i].y2, full[i].x1, full[i].y1, full[i].x2, full[i].y2);
+        }
+        TEST_ASSERT_EQUAL_MEMORY(&full[i], &inc[i], sizeof(lv_area_t));
+    }
+}
+
+TEST_CASE("laying out only the changed children gives what a full layout does", "[lv_layout_incremental]")
+{
+    disp_init();
+    srand(48);
+    lv_obj_t* root = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(root, HOR, VER);
+    lv_obj_set_flex_flow(root, LV_FLEX_FLOW_ROW_WRAP);
+    conts_create(root);
+
+    for (int step = 0; step < STEPS; step++) {
+        lv_obj_t* cont = g_conts[rnd(CONT_NUM)];
+        uint32_t cnt = lv_obj_get_child_cnt(cont);
+        lv_obj_t* item = cnt ? lv_obj_get_child(cont, rnd(cnt)) : NULL;
+        int op = rnd(12);
+        if (cnt < 4 || op < 3) {
+            // appending, what the streamed lists do most
+            if (cnt < ITEM_MAX) {
+                item_add(cont);
+            }
+            op = 0;
+        } else if (op == 3) {
+            lv_obj_t* label = label_find(item);
+            if (label) {
+                lv_label_set_text_static(label, g_lines[rnd(LINE_NUM)]);
+            }
+        } else if (op == 4) {
+            lv_obj_t* label = label_find(lv_obj_get_child(cont, -1));
+            if (label) {
+                lv_label_set_text_static(label, g_lines[rnd(LINE_NUM)]);
+            }
+        } else if (op == 5) {
+            lv_obj_set_height(item, rnd(2) ? LV_SIZE_CONTENT : (lv_coord_t)(5 + rnd(80)));
+        } else if (op == 6) {
+            if (lv_obj_has_flag(item, LV_OBJ_FLAG_HIDDEN)) {
+                lv_obj_clear_flag(item, LV_OBJ_FLAG_HIDDEN);
+            } else {
+                lv_obj_add_flag(item, LV_OBJ_FLAG_HIDDEN);
+            }
+        } else if (op == 7) {
+            if (cont != g_conts[5]) {
+                lv_obj_move_to_index(item, rnd(cnt));
+            } else {
+                lv_obj_del(lv_obj_get_child(cont, -1));
+            }
+        } else if (op == 8) {
+            if (cont != g_conts[5]) {
+                lv_obj_del(item);
+            }
+        } else if (op == 9) {
+            if (lv_obj_has_flag(item, LV_OBJ_FLAG_FLEX_IN_NEW_TRACK)) {
+                lv_obj_clear_flag(item, LV_OBJ_FLAG_FLEX_IN_NEW_TRACK);
+            } else {
+                lv_obj_add_flag(item, LV_OBJ_FLAG_FLEX_IN_NEW_TRACK);
+            }
+        } else if (op == 10) {
+            if (rnd(2)) {
+                lv_obj_set_width(cont, 200 + rnd(200));
+            } else {
+                lv_obj_set_style_pad_row(cont, rnd(12), 0);
+                lv_obj_set_style_pad_column(cont, rnd(12), 0);
+            }
+        } else {
+            if (rnd(2)) {
+                lv_obj_set_style_translate_y(item, rnd(20), 0);
+            } else {
+                // out of the layout, aligned to the container instead
+                if (lv_obj_has_flag(item, LV_OBJ_FLAG_FLOATING)) {
+                    lv_obj_clear_flag(item, LV_OBJ_FLAG_FLOATING);
+                } else {
+                    lv_obj_add_flag(item, LV_OBJ_FLAG_FLOATING);
+                    lv_obj_align(item, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
+                }
+            }
+        }
+        check_tree(root, step, op);
+    }
+
+    lv_obj_del(root);
+}
+
+// The median time of appending a chat line to a list and laying it out, over a window of the appends
+static int cmp_double(const void* a, const void* b)
+{
+    double d = *(const double*)a - *(const double*)b;
+    return d < 0 ? -1 : d > 0;
+}
+
+static void append_run(bool content_col, double* first_us, double* last_us)
+{
+    static double t_us[ITEMS];
+    lv_obj_t* box = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(box, HOR, VER);
+    lv_obj_t* list = box;
+    if (content_col) {
+        list = lv_obj_create(box);
+        lv_obj_set_size(list, LV_PCT(100), LV_SIZE_CONTENT);
+    }
+    lv_obj_set_flex_flow(list, LV_FLEX_FLOW_COLUMN);
+    lv_obj_update_layout(box);
+
+    for (int i = 0; i < ITEMS; i++) {
+        double t = now_us();
+        lv_obj_t* label = lv_label_create(list);
+        lv_label_set_text_static(label, g_lines[1 + i % 3]);
+        lv_obj_set_width(label, LV_PCT(80));
+        lv_obj_update_layout(box);
+        t_us[i] = now_us() - t;
+    }
+    qsort(&t_us[100 - WINDOW], WINDOW, sizeof(double), cmp_double);
+    qsort(&t_us[ITEMS - WINDOW], WINDOW, sizeof(double), cmp_double);
+    *first_us = t_us[100 - WINDOW / 2];
+    *last_us = t_us[ITEMS - WINDOW / 2];
+    lv_obj_del(box);
+}
+
+TEST_CASE("appending to a list of 100 and of 1000, timed", "[lv_layout_incremental]")
+{
+    disp_init();
+    for (int content_col = 0; content_col < 2; content_col++) {
+        double first_us, last_us;
+        append_run(content_col, &first_us, &last_us);
+        printf("%s: %.1f us an append at 100 items, %.1f us at %d (%.2fx)\n",
+               content_col ? "column as high as its content" : "fixed column", first_us, last_us, ITEMS,
+               last_us / first_us);
+        // printed only, wall clock time is too noisy to bound here; laid out as a whole,
+        // the list took 3.7x as long at 1000 items as at 100
+    }
+}
+
+#endif
@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#if LV_USE_STYLE_CACHE
+
+#define HOR         480
+#define VER         480
+#define OBJ_NUM     24
+#define STYLE_NUM   6
+#define STEPS       3000
+#define FRAMES      40
+
+static lv_color_t g_frame[HOR * VER];
+static lv_disp_t* g_disp;
+
+static void frame_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&g_frame[y * HOR + area->x1], color_p, w * sizeof(lv_color_t));
+        color_p += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_init(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[HOR * VER];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, HOR * VER);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = HOR;
+        drv.ver_res = VER;
+        drv.flush_cb = frame_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+    }
+    // the test files share lv_init: make the widgets go on this display
+    lv_disp_set_default(g_disp);
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// The cached properties, and a few others for the lookups around them
+static const lv_style_prop_t g_props[] = {
+    LV_STYLE_PAD_TOP, LV_STYLE_PAD_BOTTOM, LV_STYLE_PAD_LEFT, LV_STYLE_PAD_RIGHT, LV_STYLE_PAD_ROW,
+    LV_STYLE_PAD_COLUMN, LV_STYLE_RADIUS, LV_STYLE_OPA, LV_STYLE_BG_COLOR, LV_STYLE_BG_OPA,
+    LV_STYLE_BORDER_COLOR, LV_STYLE_BORDER_OPA, LV_STYLE_BORDER_WIDTH, LV_STYLE_TEXT_COLOR,
+    LV_STYLE_TEXT_OPA, LV_STYLE_TEXT_FONT, LV_STYLE_TEXT_LETTER_SPACE, LV_STYLE_TEXT_ALIGN, LV_STYLE_BASE_DIR,
+    LV_STYLE_CLIP_CORNER, LV_STYLE_SHADOW_WIDTH, LV_STYLE_BG_GRAD_DIR,
+};
+#define PROP_NUM    (sizeof(g_props) / sizeof(g_props[0]))
+
+static const lv_part_t g_parts[] = {LV_PART_MAIN, LV_PART_INDICATOR, LV_PART_KNOB};
+static const lv_state_t g_states[] = {
+    LV_STATE_DEFAULT, LV_STATE_PRESSED, LV_STATE_CHECKED, LV_STATE_FOCUSED, LV_STATE_PRESSED | LV_STATE_CHECKED,
+};
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand() % n;
+}
+
+static lv_style_value_t value_rnd(lv_style_prop_t prop)
+{
+    static const lv_font_t* const fonts[] = {
+        LV_FONT_DEFAULT,
+#if LV_FONT_SIMSUN_16_CJK
+        &lv_font_simsun_16_cjk,
+#endif
+    };
+    lv_style_value_t v;
+    memset(&v, 0, sizeof(v));
+    switch (prop) {
+        case LV_STYLE_BG_COLOR:
+        case LV_STYLE_BORDER_COLOR:
+        case LV_STYLE_TEXT_COLOR:
+            v.color = lv_color_make(rnd(256), rnd(256), rnd(256));
+            break;
+        case LV_STYLE_TEXT_FONT:
+            v.ptr = fonts[rnd(sizeof(fonts) / sizeof(fonts[0]))];
+            break;
+        case LV_STYLE_TEXT_ALIGN:
+        case LV_STYLE_BASE_DIR:
+            v.num = rnd(3);
+            break;
+        default:
+            v.num = rnd(40);
+            break;
+    }
+    return v;
+}
+
+static lv_style_selector_t selector_rnd(void)
+{
+    return g_parts[rnd(3)] | g_states[rnd(5)];
+}
+
+// What a lookup gave, the bits of the value its type uses
+static uintptr_t value_bits(lv_style_prop_t prop, lv_style_value_t v)
+{
+    switch (prop) {
+        case LV_STYLE_BG_COLOR:
+        case LV_STYLE_BORDER_COLOR:
+        case LV_STYLE_TEXT_COLOR:
+            return v.color.full;
+        case LV_STYLE_TEXT_FONT:
+            return (uintptr_t)v.ptr;
+        default:
+            return (uint32_t)v.num;
+    }
+}
+
+// Every property of every part of an object: twice with the cache (a miss and a hit) and once without
+static void check_obj(lv_obj_t* obj, int step)
+{
+    for (uint32_t p = 0; p < 3; p++) {
+        for (uint32_t i = 0; i < PROP_NUM; i++) {
+            lv_style_prop_t prop = g_props[i];
+            uintptr_t first = value_bits(prop, lv_obj_get_style_prop(obj, g_parts[p], prop));
+            uintptr_t again = value_bits(prop, lv_obj_get_style_prop(obj, g_parts[p], prop));
+            lv_obj_enable_style_cache(false);
+            uintptr_t ref = value_bits(prop, lv_obj_get_style_prop(obj, g_parts[p], prop));
+            lv_obj_enable_style_cache(true);
+            if (first != ref || again != ref) {
+                printf("step %d, part 0x%x, prop %d: %lx, %lx cached, %lx from the styles\n", step,
+                       (unsigned)g_parts[p], (int)prop, (unsigned long)first, (unsigned long)again,
+                       (unsigned long)ref);
+            }
+            TEST_ASSERT_EQUAL_UINT64(ref, first);
+            TEST_ASSERT_EQUAL_UINT64(ref, again);
+        }
+    }
+}
+
+TEST_CASE("the style cache gives what the styles do through every kind of change", "[lv_obj_style_cache]")
+{
+    disp_init();
+    srand(47);
+    static lv_style_t styles[STYLE_NUM];
+    for (int i = 0; i < STYLE_NUM; i++) {
+        lv_style_init(&styles[i]);
+        for (int j = 0; j < 6; j++) {
+            lv_style_prop_t prop = g_props[rnd(PROP_NUM)];
+            lv_style_set_prop(&styles[i], prop, value_rnd(prop));
+        }
+    }
+
+    // A tree of three levels, for the inherited text properties
+    lv_obj_t* objs[OBJ_NUM];
+    lv_obj_t* root = lv_obj_create(lv_scr_act());
+    for (int i = 0; i < OBJ_NUM; i++) {
+        objs[i] = lv_obj_create(i < 4 ? root : objs[rnd(i)]);
+    }
+
+    for (int step = 0; step < STEPS; step++) {
+        lv_obj_t* obj = objs[rnd(OBJ_NUM)];
+        lv_style_t* style = &styles[rnd(STYLE_NUM)];
+        lv_style_prop_t prop = g_props[rnd(PROP_NUM)];
+        switch (rnd(10)) {
+            case 0:
+            case 1:
+                lv_obj_add_style(obj, style, selector_rnd());
+                break;
+            case 2:
+                lv_obj_remove_style(obj, rnd(2) ? style : NULL, selector_rnd());
+                break;
+            case 3:
+                lv_obj_set_local_style_prop(obj, prop, value_rnd(prop), selector_rnd());
+                break;
+            case 4:
+                lv_obj_remove_local_style_prop(obj, prop, selector_rnd());
+                break;
+            case 5:
+                // an edit of a shared style, not reported to the objects
+                lv_style_set_prop(style, prop, value_rnd(prop));
+                break;
+            case 6:
+                lv_style_remove_prop(style, prop);
+                break;
+            case 7:
+                lv_obj_add_state(obj, g_states[rnd(5)]);
+                break;
+            case 8:
+                lv_obj_clear_state(obj, g_states[1 + rnd(4)]);
+                break;
+            case 9:
+                if (obj != objs[0]) {
+                    lv_obj_set_parent(obj, rnd(2) ? root : objs[0]);
+                }
+                break;
+        }
+        check_obj(obj, step);
+        check_obj(objs[rnd(OBJ_NUM)], step);
+    }
+
+    lv_obj_del(root);
+    for (int i = 0; i < STYLE_NUM; i++) {
+        lv_style_reset(&styles[i]);
+    }
+}
+
+// A settings screen: rows of a title, a value, a switch and a slider, themed
+static lv_obj_t* rows_create(int rows)
+{
+    lv_obj_t* col = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(col, HOR, VER);
+    lv_obj_set_flex_flow(col, LV_FLEX_FLOW_COLUMN);
+    for (int i = 0; i < rows; i++) {
+        lv_obj_t* row = lv_obj_create(col);
+        lv_obj_set_size(row, LV_PCT(100), LV_SIZE_CONTENT);
+        lv_obj_set_flex_flow(row, LV_FLEX_FLOW_ROW_WRAP);
+        lv_obj_t* title = lv_label_create(row);
+        lv_label_set_text_fmt(title, "Setting %d", i + 1);
+        lv_obj_t* value = lv_label_create(row);
+        lv_label_set_text_fmt(value, "%d %%", i * 7 % 100);
+        lv_obj_t* sw = lv_switch_create(row);
+        if (i % 2) {
+            lv_obj_add_state(sw, LV_STATE_CHECKED);
+        }
+        lv_obj_t* slider = lv_slider_create(row);
+        lv_slider_set_value(slider, i * 7 % 100, LV_ANIM_OFF);
+    }
+    return col;
+}
+
+// Lay out every object again, not only the one changed
+static void layout_mark(lv_obj_t* obj)
+{
+    lv_obj_mark_layout_as_dirty(obj);
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(obj); i++) {
+        layout_mark(lv_obj_get_child(obj, i));
+    }
+}
+
+// Redraw the whole screen `FRAMES` times, then lay it out again as many times
+static void run_frames(bool cache_en, double* frame_us, double* layout_us, lv_obj_style_cache_stats_t* stats)
+{
+    lv_obj_enable_style_cache(cache_en);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(g_disp);
+    lv_obj_style_cache_reset_stats();
+    double t = now_us();
+    for (int i = 0; i < FRAMES; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(g_disp);
+    }
+    *frame_us = (now_us() - t) / FRAMES;
+    lv_obj_style_cache_get_stats(stats);
+
+    t = now_us();
+    for (int i = 0; i < FRAMES; i++) {
+        layout_mark(lv_obj_get_child(lv_scr_act(), -1));
+        lv_obj_update_layout(lv_scr_act());
+    }
+    *layout_us = (now_us() - t) / FRAMES;
+    lv_obj_enable_style_cache(true);
+}
+
+TEST_CASE("drawing and laying out a settings screen, style cache on and off", "[lv_obj_style_cache]")
+{
+    disp_init();
+    lv_obj_t* col = rows_create(12);
+    double off_us = 1e12, on_us = 1e12, off_layout_us = 1e12, on_layout_us = 1e12;
+    lv_obj_style_cache_stats_t off, on;
+    for (int rep = 0; rep < 3; rep++) {
+        double f, l;
+        run_frames(false, &f, &l, &off);
+        off_us = LV_MIN(off_us, f);
+        off_layout_us = LV_MIN(off_layout_us, l);
+        run_frames(true, &f, &l, &on);
+        on_us = LV_MIN(on_us, f);
+        on_layout_us = LV_MIN(on_layout_us, l);
+    }
+
+    uint32_t queries = on.hits + on.misses + on.uncached;
+    uint32_t cached = on.hits + on.misses;
+    printf("%u style lookups a frame, %u of the cached properties: %.1f%% hits\n", (unsigned)(queries / FRAMES),
+           (unsigned)(cached / FRAMES), 100.0 * on.hits / cached);
+    printf("frame: %.0f us without the cache, %.0f us with it (%.2fx); layout: %.0f us, %.0f us (%.2fx)\n",
+           off_us, on_us, off_us / on_us, off_layout_us, on_layout_us, off_layout_us / on_layout_us);
+    // the lookups are the same, only served from the objects
+    TEST_ASSERT_EQUAL_UINT32(queries, off.uncached);
+    TEST_ASSERT_GREATER_THAN(cached * 99 / 100, on.hits);
+    lv_obj_del(col);
+}
+
+#endif
@@ -0,0 +1,320 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#if LV_USE_REFR_PARALLEL
+
+#define HOR         480
+#define VER         480
+#define BUF_ROWS    VER         // a full frame buffer, as the board has
+#define FRAMES      60
+
+// The flush copies the parts into a full frame to compare
+static lv_color_t g_frame[HOR * VER];
+static lv_disp_drv_t g_drv;
+static lv_disp_t* g_disp;
+
+static void frame_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&g_frame[y * HOR + area->x1], color_p, w * sizeof(lv_color_t));
+        color_p += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static double cpu_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// pthreads stand in for the cores: thread 0 is the test, the others wait for a start.
+// Every thread times its bands on its own cpu clock, so the work of a frame is known
+// even where the host has fewer cores than threads (and shares the bands out unevenly).
+typedef struct {
+    pthread_t thread;
+    uint32_t id;
+    sem_t start;
+    bool quit;
+    double band_us;
+} worker_t;
+
+static worker_t g_workers[LV_REFR_PARALLEL_THREADS - 1];
+static sem_t g_done;
+static double g_start_us;
+static double g_main_band_us;       // the test thread's bands
+static double g_band_us;            // the bands of every thread
+
+static void* worker_main(void* arg)
+{
+    worker_t* worker = arg;
+    for (;;) {
+        sem_wait(&worker->start);
+        if (worker->quit) {
+            return NULL;
+        }
+        double t = cpu_us();
+        lv_refr_render_bands(&g_drv, worker->id);
+        worker->band_us = cpu_us() - t;
+        sem_post(&g_done);
+    }
+}
+
+static void bands_start(lv_disp_drv_t* drv)
+{
+    for (int i = 0; i < LV_REFR_PARALLEL_THREADS - 1; i++) {
+        sem_post(&g_workers[i].start);
+    }
+    g_start_us = cpu_us();
+}
+
+static void bands_wait(lv_disp_drv_t* drv)
+{
+    double main_us = cpu_us() - g_start_us;
+    g_main_band_us += main_us;
+    g_band_us += main_us;
+    for (int i = 0; i < LV_REFR_PARALLEL_THREADS - 1; i++) {
+        sem_wait(&g_done);
+    }
+    for (int i = 0; i < LV_REFR_PARALLEL_THREADS - 1; i++) {
+        g_band_us += g_workers[i].band_us;
+    }
+}
+
+static void workers_start(void)
+{
+    sem_init(&g_done, 0, 0);
+    for (int i = 0; i < LV_REFR_PARALLEL_THREADS - 1; i++) {
+        g_workers[i].id = i + 1;
+        g_workers[i].quit = false;
+        sem_init(&g_workers[i].start, 0, 0);
+        pthread_create(&g_workers[i].thread, NULL, worker_main, &g_workers[i]);
+    }
+}
+
+static void workers_stop(void)
+{
+    for (int i = 0; i < LV_REFR_PARALLEL_THREADS - 1; i++) {
+        g_workers[i].quit = true;
+        sem_post(&g_workers[i].start);
+        pthread_join(g_workers[i].thread, NULL);
+        sem_destroy(&g_workers[i].start);
+    }
+    sem_destroy(&g_done);
+}
+
+static void set_parallel(bool on)
+{
+    g_drv.render_bands_start_cb = on ? bands_start : NULL;
+    g_drv.render_bands_wait_cb = on ? bands_wait : NULL;
+}
+
+static void disp_init(void)
+{
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[HOR * BUF_ROWS];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, HOR * BUF_ROWS);
+        lv_disp_drv_init(&g_drv);
+        g_drv.hor_res = HOR;
+        g_drv.ver_res = VER;
+        g_drv.flush_cb = frame_flush;
+        g_drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&g_drv);
+    }
+    // the test files share lv_init: make the widgets go on this display
+    lv_disp_set_default(g_disp);
+}
+
+// An ARGB icon with a soft edge, drawn through the image decoder
+static lv_img_dsc_t* icon_create(void)
+{
+    const int n = 48;
+    lv_img_dsc_t* img = calloc(1, sizeof(lv_img_dsc_t));
+    uint8_t* data = malloc(n * n * LV_IMG_PX_SIZE_ALPHA_BYTE);
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            uint8_t* px = &data[(y * n + x) * LV_IMG_PX_SIZE_ALPHA_BYTE];
+            lv_color_t c = lv_color_make(x * 5, y * 5, 255 - x * 2);
+            memcpy(px, &c, sizeof(c));
+            int dx = x - n / 2, dy = y - n / 2;
+            int d = dx * dx + dy * dy;
+            px[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = d > 24 * 24 ? 0 : d > 20 * 20 ? 128 : 255;
+        }
+    }
+    img->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    img->header.w = n;
+    img->header.h = n;
+    img->data_size = n * n * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    img->data = data;
+    return img;
+}
+
+// The screens of a transition: cards with gradients, shadows, text and icons
+static lv_obj_t* scene_create(const lv_img_dsc_t* icon, int seed)
+{
+    lv_obj_t* scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(scr, lv_color_hex(seed ? 0x102030 : 0x302010), 0);
+    lv_obj_set_style_bg_grad_color(scr, lv_color_hex(0x406080), 0);
+    lv_obj_set_style_bg_grad_dir(scr, LV_GRAD_DIR_VER, 0);
+    for (int i = 0; i < 12; i++) {
+        lv_obj_t* card = lv_obj_create(scr);
+        lv_obj_set_size(card, 200, 100);
+        lv_obj_set_pos(card, 20 + (i % 2) * 230, 10 + (i / 2) * 78);
+        lv_obj_set_style_radius(card, 16, 0);
+        lv_obj_set_style_bg_color(card, lv_palette_main(i % 19), 0);
+        lv_obj_set_style_bg_grad_color(card, lv_palette_darken(i % 19, 3), 0);
+        lv_obj_set_style_bg_grad_dir(card, i % 2 ? LV_GRAD_DIR_HOR : LV_GRAD_DIR_VER, 0);
+        lv_obj_set_style_bg_opa(card, i % 3 ? LV_OPA_COVER : LV_OPA_70, 0);
+        lv_obj_set_style_shadow_width(card, 12, 0);
+        lv_obj_set_style_shadow_ofs_y(card, 4, 0);
+        lv_obj_set_style_border_width(card, 2, 0);
+        lv_obj_set_scrollbar_mode(card, LV_SCROLLBAR_MODE_OFF);
+
+        lv_obj_t* label = lv_label_create(card);
+        lv_label_set_text_fmt(label, "Card %d\nThe quick brown fox jumps over the lazy dog", i + seed);
+        lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
+        lv_obj_set_width(label, 120);
+        lv_obj_align(label, LV_ALIGN_LEFT_MID, 0, 0);
+
+        lv_obj_t* img = lv_img_create(card);
+        lv_img_set_src(img, icon);
+        lv_obj_align(img, LV_ALIGN_RIGHT_MID, 0, 0);
+    }
+    lv_obj_t* arc = lv_arc_create(scr);
+    lv_obj_set_size(arc, 160, 160);
+    lv_obj_center(arc);
+    lv_arc_set_value(arc, 70);
+
+    // widgets that keep state while they draw: a spangroup over every band, and two
+    // colorwheels of other modes, each drawn by two bands
+    lv_obj_t* spans = lv_spangroup_create(scr);
+    lv_obj_set_size(spans, 200, VER - 20);
+    lv_obj_set_pos(spans, 250, 10);
+    lv_spangroup_set_mode(spans, LV_SPAN_MODE_BREAK);
+    for (int i = 0; i < 24; i++) {
+        lv_span_t* span = lv_spangroup_new_span(spans);
+        lv_span_set_text(span, i % 3 ? "spans of text in many colours, " : "underlined and wrapped, ");
+        lv_style_set_text_color(&span->style, lv_palette_main((i + seed) % 19));
+        lv_style_set_text_decor(&span->style, i % 3 ? LV_TEXT_DECOR_NONE : LV_TEXT_DECOR_UNDERLINE);
+    }
+    lv_spangroup_refr_mode(spans);
+    for (int i = 0; i < 2; i++) {
+        lv_obj_t* wheel = lv_colorwheel_create(scr, true);
+        lv_obj_set_size(wheel, 150, 150);
+        lv_obj_set_pos(wheel, 10 + i * 160, 60 + i * 220);
+        lv_colorwheel_set_hsv(wheel, (lv_color_hsv_t){120 + seed * 60, 80, 90});
+        lv_colorwheel_set_mode(wheel, i ? LV_COLORWHEEL_MODE_SATURATION : LV_COLORWHEEL_MODE_VALUE);
+    }
+    return scr;
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// Step the transition to frame i (a slide of the new screen over the old one) and render it
+static void render_frame(lv_obj_t* old_scr, lv_obj_t* new_scr, int i)
+{
+    lv_obj_set_x(old_scr, -i * HOR / FRAMES / 2);
+    lv_obj_set_x(new_scr, HOR - i * HOR / FRAMES);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(g_disp);
+}
+
+typedef struct {
+    double wall_us;         // a frame on this host
+    double work_us;         // the cpu time of a frame over all the threads
+    double path_us;         // a frame with a core for every render thread, the bands shared out evenly
+} frame_time_t;
+
+static frame_time_t run_transition(lv_obj_t* old_scr, lv_obj_t* new_scr, bool parallel, lv_color_t* frames)
+{
+    set_parallel(parallel);
+    g_main_band_us = 0;
+    g_band_us = 0;
+    double wall_us = 0, main_us = 0;
+    for (int i = 0; i < FRAMES; i++) {
+        double t = now_us();
+        double c = cpu_us();
+        render_frame(old_scr, new_scr, i);
+        main_us += cpu_us() - c;
+        wall_us += now_us() - t;
+        if (frames && i % 10 == 0) {
+            memcpy(&frames[(i / 10) * HOR * VER], g_frame, sizeof(g_frame));
+        }
+    }
+    double serial_us = main_us - g_main_band_us;
+    frame_time_t ft = {
+        wall_us / FRAMES,
+        (serial_us + g_band_us) / FRAMES,
+        (serial_us + g_band_us / (parallel ? LV_REFR_PARALLEL_THREADS : 1)) / FRAMES,
+    };
+    return ft;
+}
+
+TEST_CASE("bands render the same pixels as the single thread", "[lv_refr_parallel]")
+{
+    disp_init();
+    workers_start();
+    lv_img_dsc_t* icon = icon_create();
+    // the old screen stays the active one, the new one slides in as a child of it
+    lv_obj_t* old_scr = scene_create(icon, 0);
+    lv_scr_load(old_scr);
+    lv_obj_t* new_scr = scene_create(icon, 1);
+    lv_obj_set_parent(new_scr, old_scr);
+    lv_obj_set_size(new_scr, HOR, VER);
+
+    lv_color_t* serial = malloc(FRAMES / 10 * sizeof(g_frame));
+    lv_color_t* parallel = malloc(FRAMES / 10 * sizeof(g_frame));
+    run_transition(old_scr, new_scr, false, NULL);  // warm the caches of every thread
+    run_transition(old_scr, new_scr, true, NULL);
+    // the best of a few runs, the host has other work going on
+    frame_time_t serial_t = run_transition(old_scr, new_scr, false, serial);
+    frame_time_t parallel_t = run_transition(old_scr, new_scr, true, parallel);
+    for (int run = 0; run < 4; run++) {
+        frame_time_t t = run_transition(old_scr, new_scr, false, NULL);
+        serial_t = t.path_us < serial_t.path_us ? t : serial_t;
+        t = run_transition(old_scr, new_scr, true, NULL);
+        parallel_t = t.work_us < parallel_t.work_us ? t : parallel_t;
+    }
+
+    for (int f = 0; f < FRAMES / 10; f++) {
+        for (int i = 0; i < HOR * VER; i++) {
+            if (serial[f * HOR * VER + i].full != parallel[f * HOR * VER + i].full) {
+                printf("frame %d: px %d,%d differs\n", f * 10, i % HOR, i / HOR);
+                TEST_ASSERT_EQUAL_HEX16(serial[f * HOR * VER + i].full, parallel[f * HOR * VER + i].full);
+            }
+        }
+    }
+    printf("%dx%d slide, %d rows a part: %.0f us a frame on 1 thread, %.0f us of work on %d, "
+           "%.0f us with a core each (%.2fx), %.0f us here on %ld cpus\n",
+           HOR, VER, BUF_ROWS, serial_t.path_us, parallel_t.work_us, LV_REFR_PARALLEL_THREADS,
+           parallel_t.path_us, serial_t.path_us / parallel_t.path_us, parallel_t.wall_us,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    // not asserted, a loaded host makes any bound flaky: every band walks the tree and builds
+    // its gradients and shadows again, compare the work on all threads with the one thread
+
+    set_parallel(false);
+    workers_stop();
+    lv_obj_del(old_scr);
+    free(serial);
+    free(parallel);
+    free((void*)icon->data);
+    free(icon);
+}
+
+#endif
@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#define TIMER_MAX   64
+#define CALLS       4000
+#define LOG_MAX     (TIMER_MAX * 4)
+
+// The list walk lv_timer_handler did before the heap, on timers of its own: the reference of
+// the equivalence test and the baseline of the benchmark. Two things the heap does on purpose
+// differ: a timer runs once a call (the walk's restarts ran the ones ready again, like a 0
+// period timer, again) and a deleted timer doesn't keep the others' repeat count from ending
+typedef struct {
+    uint32_t period;
+    uint32_t last_run;
+    int32_t repeat_count;
+    bool paused;
+    int id;
+    uint32_t ran_call;
+} walk_timer_t;
+
+static lv_ll_t g_walk_ll;
+static bool g_walk_created;
+static bool g_walk_deleted;
+static uint32_t g_walk_call;
+
+// What fired in a handler call, by id
+typedef struct {
+    int ids[LOG_MAX];
+    int cnt;
+} fire_log_t;
+
+static fire_log_t g_heap_log;
+static fire_log_t g_walk_log;
+
+static void log_fire(fire_log_t* log, int id)
+{
+    TEST_ASSERT_LESS_THAN(LOG_MAX, log->cnt);
+    log->ids[log->cnt++] = id;
+}
+
+static uint32_t walk_remaining(walk_timer_t* t)
+{
+    uint32_t elp = lv_tick_elaps(t->last_run);
+    return elp >= t->period ? 0 : t->period - elp;
+}
+
+static walk_timer_t* walk_create(int id, uint32_t period)
+{
+    walk_timer_t* t = _lv_ll_ins_head(&g_walk_ll);
+    t->period = period;
+    t->last_run = lv_tick_get();
+    t->repeat_count = -1;
+    t->paused = false;
+    t->id = id;
+    t->ran_call = 0;
+    g_walk_created = true;
+    return t;
+}
+
+static void walk_del(walk_timer_t* t)
+{
+    _lv_ll_remove(&g_walk_ll, t);
+    g_walk_deleted = true;
+    lv_mem_free(t);
+}
+
+static bool walk_exec(walk_timer_t* t)
+{
+    if (t->paused || t->ran_call == g_walk_call) {
+        return false;
+    }
+    bool exec = false;
+    if (walk_remaining(t) == 0) {
+        t->ran_call = g_walk_call;
+        int32_t original_repeat_count = t->repeat_count;
+        if (t->repeat_count > 0) {
+            t->repeat_count--;
+        }
+        t->last_run = lv_tick_get();
+        if (original_repeat_count != 0) {
+            log_fire(&g_walk_log, t->id);
+        }
+        exec = true;
+    }
+    if (t->repeat_count == 0) {
+        walk_del(t);
+    }
+    return exec;
+}
+
+static uint32_t walk_handler(void)
+{
+    walk_timer_t* act;
+    g_walk_call++;
+    do {
+        g_walk_deleted = false;
+        g_walk_created = false;
+        act = _lv_ll_get_head(&g_walk_ll);
+        while (act) {
+            walk_timer_t* next = _lv_ll_get_next(&g_walk_ll, act);
+            if (walk_exec(act) && (g_walk_created || g_walk_deleted)) {
+                break;
+            }
+            act = next;
+        }
+    } while (act);
+
+    uint32_t time_till_next = LV_NO_TIMER_READY;
+    for (walk_timer_t* t = _lv_ll_get_head(&g_walk_ll); t; t = _lv_ll_get_next(&g_walk_ll, t)) {
+        // the heap asks to be called right away for a timer to delete, the walk waited its period
+        uint32_t delay = t->repeat_count == 0 ? 0 : walk_remaining(t);
+        if (!t->paused && delay < time_till_next) {
+            time_till_next = delay;
+        }
+    }
+    return time_till_next;
+}
+
+static walk_timer_t* walk_find(int id)
+{
+    for (walk_timer_t* t = _lv_ll_get_head(&g_walk_ll); t; t = _lv_ll_get_next(&g_walk_ll, t)) {
+        if (t->id == id) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+static void heap_cb(lv_timer_t* t)
+{
+    log_fire(&g_heap_log, (int)(intptr_t)t->user_data);
+}
+
+static lv_timer_t* heap_find(int id)
+{
+    for (lv_timer_t* t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t)) {
+        if (t->timer_cb == heap_cb && (int)(intptr_t)t->user_data == id) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// Pause the timers of lv_init and of the other tests' displays, so only ours run
+static lv_timer_t* g_others[16];
+static int g_others_cnt;
+
+static void timers_isolate(void)
+{
+    if (!lv_is_initialized()) {
+        lv_init();
+    }
+    _lv_ll_init(&g_walk_ll, sizeof(walk_timer_t));
+    g_others_cnt = 0;
+    for (lv_timer_t* t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t)) {
+        if (!t->paused && g_others_cnt < 16) {
+            g_others[g_others_cnt++] = t;
+            lv_timer_pause(t);
+        }
+    }
+}
+
+static void timers_restore(void)
+{
+    for (int i = 0; i < g_others_cnt; i++) {
+        lv_timer_resume(g_others[i]);
+    }
+}
+
+static int int_cmp(const void* a, const void* b)
+{
+    return *(const int*)a - *(const int*)b;
+}
+
+TEST_CASE("the timer heap fires like the list walk", "[lv_timer]")
+{
+    timers_isolate();
+    srand(46);
+    int next_id = 0;
+    for (int call = 0; call < CALLS; call++) {
+        // a few changes between the calls, the same on both
+        int changes = rand() % 4;
+        for (int c = 0; c < changes; c++) {
+            int op = rand() % 9;
+            int id = next_id ? rand() % next_id : 0;
+            lv_timer_t* h = heap_find(id);
+            walk_timer_t* w = walk_find(id);
+            TEST_ASSERT_EQUAL(w != NULL, h != NULL);
+            if (op == 0 || next_id == 0) {
+                uint32_t period = rand() % 4 == 0 ? 0 : rand() % 200;
+                if (_lv_ll_get_len(&g_walk_ll) < TIMER_MAX) {
+                    lv_timer_create(heap_cb, period, (void*)(intptr_t)next_id);
+                    walk_create(next_id, period);
+                    next_id++;
+                }
+                continue;
+            }
+            if (h == NULL) {
+                continue;
+            }
+            switch (op) {
+            case 1:
+                lv_timer_del(h);
+                walk_del(w);
+                break;
+            case 2:
+                lv_timer_pause(h);
+                w->paused = true;
+                break;
+            case 3:
+                lv_timer_resume(h);
+                w->paused = false;
+                break;
+            case 4: {
+                uint32_t period = rand() % 300;
+                lv_timer_set_period(h, period);
+                w->period = period;
+                break;
+            }
+            case 5:
+                lv_timer_ready(h);
+                w->last_run = lv_tick_get() - w->period - 1;
+                break;
+            case 6:
+                lv_timer_reset(h);
+                w->last_run = lv_tick_get();
+                break;
+            default: {
+                int32_t repeat = rand() % 6 - 1;
+                lv_timer_set_repeat_count(h, repeat);
+                w->repeat_count = repeat;
+                break;
+            }
+            }
+        }
+
+        g_heap_log.cnt = 0;
+        g_walk_log.cnt = 0;
+        uint32_t heap_next = lv_timer_handler();
+        uint32_t walk_next = walk_handler();
+        TEST_ASSERT_EQUAL_UINT32(walk_next, heap_next);
+        qsort(g_heap_log.ids, g_heap_log.cnt, sizeof(int), int_cmp);
+        qsort(g_walk_log.ids, g_walk_log.cnt, sizeof(int), int_cmp);
+        TEST_ASSERT_EQUAL(g_walk_log.cnt, g_heap_log.cnt);
+        TEST_ASSERT_EQUAL_INT_ARRAY(g_walk_log.ids, g_heap_log.ids, g_walk_log.cnt);
+
+        lv_tick_inc(rand() % 8 == 0 ? 0 : rand() % 40);
+    }
+
+    for (int id = 0; id < next_id; id++) {
+        lv_timer_t* h = heap_find(id);
+        walk_timer_t* w = walk_find(id);
+        TEST_ASSERT_EQUAL(w != NULL, h != NULL);
+        if (h) {
+            lv_timer_del(h);
+            walk_del(w);
+        }
+    }
+    timers_restore();
+}
+
+// Timers that change the timers from their callbacks
+static lv_timer_t* g_victim;
+static fire_log_t g_order;
+
+static void order_cb(lv_timer_t* t)
+{
+    log_fire(&g_order, (int)(intptr_t)t->user_data);
+}
+
+static void del_self_cb(lv_timer_t* t)
+{
+    order_cb(t);
+    lv_timer_del(t);
+}
+
+static void del_victim_cb(lv_timer_t* t)
+{
+    order_cb(t);
+    if (g_victim) {
+        lv_timer_del(g_victim);
+        g_victim = NULL;
+    }
+}
+
+static void spawn_cb(lv_timer_t* t)
+{
+    order_cb(t);
+    lv_timer_t* child = lv_timer_create(order_cb, 0, (void*)(intptr_t)100);
+    lv_timer_set_repeat_count(child, 1);
+}
+
+TEST_CASE("timers run by deadline and once a call while they change", "[lv_timer]")
+{
+    timers_isolate();
+
+    // the earlier deadline first, on the same deadline the newer timer first
+    lv_timer_t* a = lv_timer_create(order_cb, 30, (void*)(intptr_t)1);
+    lv_timer_t* b = lv_timer_create(order_cb, 10, (void*)(intptr_t)2);
+    lv_timer_t* c = lv_timer_create(order_cb, 30, (void*)(intptr_t)3);
+    lv_tick_inc(30);
+    g_order.cnt = 0;
+    lv_timer_handler();
+    TEST_ASSERT_EQUAL(3, g_order.cnt);
+    TEST_ASSERT_EQUAL(2, g_order.ids[0]);
+    TEST_ASSERT_EQUAL(3, g_order.ids[1]);
+    TEST_ASSERT_EQUAL(1, g_order.ids[2]);
+    lv_timer_del(a);
+    lv_timer_del(b);
+    lv_timer_del(c);
+
+    // a 0 period timer runs once a call; deleting a ready timer keeps it from running;
+    // a timer made in a callback runs in the same call when it's ready
+    lv_timer_t* zero = lv_timer_create(order_cb, 0, (void*)(intptr_t)10);
+    lv_timer_create(del_self_cb, 5, (void*)(intptr_t)11);
+    g_victim = lv_timer_create(order_cb, 5, (void*)(intptr_t)12);
+    lv_timer_t* killer = lv_timer_create(del_victim_cb, 5, (void*)(intptr_t)13);
+    lv_timer_t* spawner = lv_timer_create(spawn_cb, 5, (void*)(intptr_t)14);
+    lv_timer_set_repeat_count(spawner, 1);
+    lv_tick_inc(5);
+    g_order.cnt = 0;
+    lv_timer_handler();
+    // 10 was due first; of the others 14 is the newest and spawns 100 (newer still),
+    // then 13 deletes 12 and 11 deletes itself
+    int expect[] = {10, 14, 100, 13, 11};
+    TEST_ASSERT_EQUAL(5, g_order.cnt);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expect, g_order.ids, 5);
+
+    // what's left: the 0 period timer and the killer, ready again in 0 and 5 ms
+    int left = 0;
+    for (lv_timer_t* t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t)) {
+        left += !t->paused;
+    }
+    TEST_ASSERT_EQUAL(2, left);
+    TEST_ASSERT_EQUAL_UINT32(0, lv_timer_handler());
+    lv_timer_pause(zero);
+    g_order.cnt = 0;
+    TEST_ASSERT_EQUAL_UINT32(5, lv_timer_handler());
+    TEST_ASSERT_EQUAL(0, g_order.cnt);
+    lv_timer_pause(killer);
+    TEST_ASSERT_EQUAL_UINT32(LV_NO_TIMER_READY, lv_timer_handler());
+    lv_timer_del(zero);
+    lv_timer_del(killer);
+    timers_restore();
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static void count_cb(lv_timer_t* t)
+{
+    (*(uint32_t*)t->user_data)++;
+}
+
+// The periods of a screen: animations and input reads at 30 ms, the refresh at 33 ms,
+// the rest app timers of 100 ms to 2 s
+static uint32_t bench_period(int i)
+{
+    static const uint32_t fast[] = {30, 30, 33};
+    return i < 3 ? fast[i] : 100 + (i * 7919) % 1900;
+}
+
+TEST_CASE("lv_timer_handler with 10 to 500 timers, heap against list walk", "[lv_timer]")
+{
+    static const int counts[] = {10, 50, 100, 200, 500};
+    const int ms = 20000;
+    timers_isolate();
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        int n = counts[c];
+        uint32_t fired = 0;
+        lv_timer_t** timers = malloc(n * sizeof(lv_timer_t*));
+        for (int i = 0; i < n; i++) {
+            timers[i] = lv_timer_create(count_cb, bench_period(i), &fired);
+        }
+        // a handler call every ms
+        double t = now_us();
+        for (int i = 0; i < ms; i++) {
+            lv_tick_inc(1);
+            lv_timer_handler();
+        }
+        double heap_us = (now_us() - t) / ms;
+        uint32_t heap_fired = fired;
+        for (int i = 0; i < n; i++) {
+            lv_timer_del(timers[i]);
+        }
+
+        for (int i = 0; i < n; i++) {
+            walk_create(i, bench_period(i));
+        }
+        g_walk_log.cnt = 0;
+        t = now_us();
+        for (int i = 0; i < ms; i++) {
+            lv_tick_inc(1);
+            walk_handler();
+            g_walk_log.cnt = 0;
+        }
+        double walk_us = (now_us() - t) / ms;
+        while (_lv_ll_get_head(&g_walk_ll)) {
+            walk_del(_lv_ll_get_head(&g_walk_ll));
+        }
+
+        printf("%3d timers: %6.2f us a call walking the list, %6.2f us with the heap (%.1fx), %u runs in %d ms\n",
+               n, walk_us, heap_us, walk_us / heap_us, (unsigned)heap_fired, ms);
+        free(timers);
+    }
+    timers_restore();
+}
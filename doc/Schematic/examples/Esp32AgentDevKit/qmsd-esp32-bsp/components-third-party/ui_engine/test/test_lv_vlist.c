@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include "unity.h"
+#include "lvgl.h"
+
+#if LV_USE_VLIST
+
+#define HOR         480
+#define VER         480
+#define STEPS       3000
+#define ROWS        10000
+#define ROWS_PLAIN  150
+#define FRAMES      60
+
+static lv_disp_t* g_disp;
+
+static void frame_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_init(void)
+{
+    static lv_disp_drv_t drv;
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[HOR * VER / 10];
+    if (g_disp == NULL) {
+        lv_init();
+        lv_disp_draw_buf_init(&draw_buf, buf, NULL, HOR * VER / 10);
+        lv_disp_drv_init(&drv);
+        drv.hor_res = HOR;
+        drv.ver_res = VER;
+        drv.flush_cb = frame_flush;
+        drv.draw_buf = &draw_buf;
+        g_disp = lv_disp_drv_register(&drv);
+    }
+    // the test files share lv_init: make the widgets go on this display
+    lv_disp_set_default(g_disp);
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static uint32_t rnd(uint32_t n)
+{
+    return (uint32_t)rand() % n;
+}
+
+static const char* const g_lines[] = {
+    "ok",
+    "Hello, what's the weather tomorrow?",
+    "Tomorrow: light rain in the morning, sunny from noon, 18 to 24 degrees.",
+    "Set a reminder at 8:30 and play something calm please, thanks a lot.",
+    "A\nB\nC",
+};
+#define LINE_NUM    (sizeof(g_lines) / sizeof(g_lines[0]))
+
+// What each row shows: changing it and refreshing the row changes its height
+static uint8_t g_variant[ROWS + 100];
+
+static void row_text(uint32_t id, char* buf, size_t size)
+{
+    snprintf(buf, size, "%u: %s", (unsigned)id, g_lines[(id + g_variant[id]) % LINE_NUM]);
+}
+
+static lv_obj_t* row_create(lv_obj_t* vlist)
+{
+    lv_obj_t* label = lv_label_create(vlist);
+    lv_obj_set_width(label, LV_PCT(100));
+    lv_obj_set_style_pad_ver(label, 4, 0);
+    return label;
+}
+
+static void row_bind(lv_obj_t* vlist, lv_obj_t* row_obj, uint32_t id)
+{
+    char buf[128];
+    row_text(id, buf, sizeof(buf));
+    lv_label_set_text(row_obj, buf);
+}
+
+// The rows in view, by id
+static lv_obj_t* g_shown[ROWS + 100];
+
+static void check_rows(lv_obj_t* vlist, int step, int op)
+{
+    lv_vlist_t* v = (lv_vlist_t*)vlist;
+    lv_obj_update_layout(vlist);
+    memset(g_shown, 0, sizeof(g_shown));
+
+    uint32_t first = LV_VLIST_ROW_NONE;
+    uint32_t last = 0;
+    uint32_t shown_cnt = 0;
+    TEST_ASSERT_EQUAL_UINT32(v->pool_cnt, lv_obj_get_child_cnt(vlist));
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(vlist); i++) {
+        lv_obj_t* row = lv_obj_get_child(vlist, i);
+        uint32_t id = lv_vlist_get_row_id(vlist, row);
+        TEST_ASSERT_EQUAL(id == LV_VLIST_ROW_NONE, lv_obj_has_flag(row, LV_OBJ_FLAG_HIDDEN));
+        if (id == LV_VLIST_ROW_NONE) continue;
+        TEST_ASSERT_LESS_THAN_UINT32(lv_vlist_get_row_cnt(vlist), id);
+        TEST_ASSERT_NULL(g_shown[id]);
+        TEST_ASSERT_EQUAL_PTR(row, lv_vlist_get_row_obj(vlist, id));
+        g_shown[id] = row;
+        first = LV_MIN(first, id);
+        last = LV_MAX(last, id);
+        shown_cnt++;
+
+        char buf[128];
+        row_text(id, buf, sizeof(buf));
+        TEST_ASSERT_EQUAL_STRING(buf, lv_label_get_text(row));
+    }
+
+    lv_area_t view;
+    lv_obj_get_content_coords(vlist, &view);
+    if (lv_vlist_get_row_cnt(vlist) == 0) {
+        TEST_ASSERT_EQUAL_UINT32(0, shown_cnt);
+        return;
+    }
+
+    // one run of rows, one under the other
+    TEST_ASSERT_EQUAL_UINT32(last - first + 1, shown_cnt);
+    lv_coord_t pad_row = lv_obj_get_style_pad_row(vlist, LV_PART_MAIN);
+    for (uint32_t id = first + 1; id <= last; id++) {
+        if (g_shown[id]->coords.y1 != g_shown[id - 1]->coords.y2 + 1 + pad_row) {
+            printf("step %d, op %d: row %u at %d, the one before ends at %d\n", step, op, (unsigned)id,
+                   g_shown[id]->coords.y1, g_shown[id - 1]->coords.y2);
+        }
+        TEST_ASSERT_EQUAL_INT(g_shown[id - 1]->coords.y2 + 1 + pad_row, g_shown[id]->coords.y1);
+    }
+
+    // covering the view, and not much more
+    if (first > 0) {
+        TEST_ASSERT_LESS_OR_EQUAL_INT(view.y1, g_shown[first]->coords.y1);
+        TEST_ASSERT_GREATER_THAN_INT(view.y1 - v->overscan, g_shown[first]->coords.y2 + pad_row + 1);
+    }
+    if (last + 1 < lv_vlist_get_row_cnt(vlist)) {
+        TEST_ASSERT_GREATER_OR_EQUAL_INT(view.y2, g_shown[last]->coords.y2);
+        TEST_ASSERT_LESS_THAN_INT(view.y2 + 1 + v->overscan, g_shown[last]->coords.y1);
+    }
+}
+
+TEST_CASE("a virtualized list shows the rows in view, one under the other", "[lv_vlist]")
+{
+    disp_init();
+    srand(1);
+    memset(g_variant, 0, sizeof(g_variant));
+
+    lv_obj_t* vlist = lv_vlist_create(lv_scr_act());
+    lv_obj_set_size(vlist, 300, 400);
+    lv_vlist_set_cb(vlist, row_create, row_bind, NULL);
+    lv_vlist_set_row_cnt(vlist, 3000);
+    check_rows(vlist, 0, -1);
+
+    for (int step = 1; step <= STEPS; step++) {
+        int op = rnd(9);
+        uint32_t cnt = lv_vlist_get_row_cnt(vlist);
+        switch (op) {
+            case 0:
+            case 1:
+                lv_obj_scroll_by(vlist, 0, (lv_coord_t)rnd(1200) - 600, LV_ANIM_OFF);
+                break;
+            case 2:
+                lv_vlist_scroll_to_row(vlist, rnd(cnt + 1), LV_ANIM_OFF);
+                break;
+            case 3:
+                lv_vlist_scroll_to_row(vlist, rnd(cnt + 1), LV_ANIM_ON);
+                for (int i = 0; i < 40; i++) {
+                    lv_tick_inc(20);
+                    lv_anim_refr_now();
+                }
+                break;
+            case 4:
+                lv_vlist_set_row_cnt(vlist, LV_MIN(cnt + rnd(40), ROWS + 100));
+                break;
+            case 5:
+                lv_vlist_set_row_cnt(vlist, cnt - LV_MIN(cnt, rnd(40)));
+                break;
+            case 6:
+                if (cnt) {
+                    uint32_t id = rnd(cnt);
+                    g_variant[id]++;
+                    lv_vlist_refresh_row(vlist, id);
+                }
+                break;
+            case 7:
+                lv_obj_set_width(vlist, 200 + rnd(200));
+                break;
+            case 8:
+                lv_obj_set_style_pad_row(vlist, rnd(8), 0);
+                break;
+        }
+        check_rows(vlist, step, op);
+    }
+
+    // the pool is what one view and the overscan need, not what was ever shown
+    lv_vlist_t* v = (lv_vlist_t*)vlist;
+    printf("%u row objects for the 3000 rows\n", (unsigned)v->pool_cnt);
+    TEST_ASSERT_LESS_THAN_UINT32(40, v->pool_cnt);
+    lv_obj_del(vlist);
+}
+
+TEST_CASE("a virtualized list keeps the view in place as rows above it change, and follows the bottom", "[lv_vlist]")
+{
+    disp_init();
+    memset(g_variant, 0, sizeof(g_variant));
+
+    lv_obj_t* vlist = lv_vlist_create(lv_scr_act());
+    lv_obj_set_size(vlist, 300, 400);
+    lv_vlist_set_cb(vlist, row_create, row_bind, NULL);
+
+    // appended while at the bottom: the last row stays at the bottom
+    lv_area_t view;
+    for (uint32_t cnt = 1; cnt <= 300; cnt++) {
+        lv_vlist_set_row_cnt(vlist, cnt);
+        lv_obj_update_layout(vlist);
+        lv_obj_get_content_coords(vlist, &view);
+        lv_obj_t* row = lv_vlist_get_row_obj(vlist, cnt - 1);
+        TEST_ASSERT_NOT_NULL(row);
+        if (lv_obj_get_scroll_y(vlist) + ((lv_vlist_t*)vlist)->base > 0) {
+            TEST_ASSERT_EQUAL_INT(view.y2, row->coords.y2);
+        }
+    }
+
+    // scrolled up, the view stays as rows are appended
+    lv_vlist_scroll_to_row(vlist, 150, LV_ANIM_OFF);
+    lv_obj_update_layout(vlist);
+    lv_coord_t y1 = lv_vlist_get_row_obj(vlist, 150)->coords.y1;
+    TEST_ASSERT_EQUAL_INT(view.y1, y1);
+    lv_vlist_set_row_cnt(vlist, 400);
+    lv_obj_update_layout(vlist);
+    TEST_ASSERT_EQUAL_INT(y1, lv_vlist_get_row_obj(vlist, 150)->coords.y1);
+
+    // a row above the view gets higher: the view doesn't move
+    lv_obj_scroll_by(vlist, 0, -20, LV_ANIM_OFF);
+    lv_obj_update_layout(vlist);
+    uint32_t above = 150;
+    while (lv_vlist_get_row_obj(vlist, above - 1)) above--;
+    lv_obj_t* in_view = lv_vlist_get_row_obj(vlist, 152);
+    y1 = in_view->coords.y1;
+    for (int i = 0; i < (int)LINE_NUM; i++) {
+        g_variant[above]++;
+        lv_vlist_refresh_row(vlist, above);
+        lv_obj_update_layout(vlist);
+        TEST_ASSERT_EQUAL_PTR(in_view, lv_vlist_get_row_obj(vlist, 152));
+        TEST_ASSERT_EQUAL_INT(y1, in_view->coords.y1);
+    }
+
+    // and rows not shown are measured when they get in view
+    g_variant[10]++;
+    lv_vlist_refresh_row(vlist, 10);
+    lv_obj_update_layout(vlist);
+    TEST_ASSERT_EQUAL_INT(y1, in_view->coords.y1);
+    lv_obj_del(vlist);
+}
+
+// The heap in use, with the allocations of lv_mem going to malloc
+static size_t heap_used(void)
+{
+    return mallinfo2().uordblks;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+    double d = *(const double*)a - *(const double*)b;
+    return d < 0 ? -1 : d > 0;
+}
+
+// The median time of scrolling a list a few pixels and drawing it
+static double frame_us(lv_obj_t* list, double* scroll_us)
+{
+    static double t_us[FRAMES];
+    static double t_scroll_us[FRAMES];
+    lv_refr_now(g_disp);
+    for (int i = 0; i < FRAMES; i++) {
+        lv_coord_t dy = (i / 10) % 2 ? -7 : 7;
+        double t = now_us();
+        lv_obj_scroll_by(list, 0, dy, LV_ANIM_OFF);
+        lv_obj_update_layout(list);
+        t_scroll_us[i] = now_us() - t;
+        lv_refr_now(g_disp);
+        t_us[i] = now_us() - t;
+    }
+    qsort(t_us, FRAMES, sizeof(double), cmp_double);
+    qsort(t_scroll_us, FRAMES, sizeof(double), cmp_double);
+    *scroll_us = t_scroll_us[FRAMES / 2];
+    return t_us[FRAMES / 2];
+}
+
+TEST_CASE("10000 rows take the objects of a view, scrolling timed against a short list", "[lv_vlist]")
+{
+    disp_init();
+    memset(g_variant, 0, sizeof(g_variant));
+
+    // a virtualized list of 10000 rows
+    size_t heap0 = heap_used();
+    lv_obj_t* vlist = lv_vlist_create(lv_scr_act());
+    lv_obj_set_size(vlist, HOR, VER);
+    lv_vlist_set_cb(vlist, row_create, row_bind, NULL);
+    lv_vlist_set_row_cnt(vlist, ROWS);
+    lv_vlist_scroll_to_row(vlist, ROWS / 2, LV_ANIM_OFF);
+    lv_obj_update_layout(vlist);
+    size_t vlist_bytes = heap_used() - heap0;
+    uint32_t vlist_objs = lv_obj_get_child_cnt(vlist) + 1;
+    double vlist_scroll_us;
+    double vlist_us = frame_us(vlist, &vlist_scroll_us);
+    lv_obj_del(vlist);
+
+    // the same rows in a plain column, as many as its coordinates can hold
+    heap0 = heap_used();
+    lv_obj_t* col = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(col, HOR, VER);
+    lv_obj_set_flex_flow(col, LV_FLEX_FLOW_COLUMN);
+    for (uint32_t id = 0; id < ROWS_PLAIN; id++) row_bind(col, row_create(col), id);
+    lv_obj_update_layout(col);
+    lv_obj_scroll_to_y(col, lv_obj_get_scroll_bottom(col) / 2, LV_ANIM_OFF);
+    size_t plain_bytes = heap_used() - heap0;
+    uint32_t plain_objs = lv_obj_get_child_cnt(col) + 1;
+    double plain_scroll_us;
+    double plain_us = frame_us(col, &plain_scroll_us);
+    lv_obj_del(col);
+
+    printf("virtualized, %d rows: %u objects, %u bytes, a frame %.1f us (the scroll %.1f us)\n", ROWS,
+           (unsigned)vlist_objs, (unsigned)vlist_bytes, vlist_us, vlist_scroll_us);
+    printf("plain column, %d rows: %u objects, %u bytes, a frame %.1f us (the scroll %.1f us)\n", ROWS_PLAIN,
+           (unsigned)plain_objs, (unsigned)plain_bytes, plain_us, plain_scroll_us);
+
+    // 66 times the rows in less memory than the plain column; the frame times are only printed
+    TEST_ASSERT_LESS_THAN_UINT32(plain_objs, vlist_objs);
+    TEST_ASSERT_LESS_THAN(plain_bytes, vlist_bytes);
+}
+
+#endif
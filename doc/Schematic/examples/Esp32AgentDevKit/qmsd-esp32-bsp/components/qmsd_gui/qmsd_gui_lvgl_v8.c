@@ -5,6 +5,8 @@
 #include "qmsd_utils.h"
 #include "lvgl.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "qmsd_metrics.h"
 
 #ifdef CONFIG_QMSD_GUI_LVGL_V8
 
@@ -12,6 +14,26 @@ static qmsd_gui_config_t* g_lvgl_config;
 static QueueHandle_t g_image_queue;
 static SemaphoreHandle_t g_gui_semaphore = NULL;
 
+QMSD_METRIC_HISTOGRAM(s_gui_handler_us, "gui.handler_us", 1000, 5000, 10000, 25000, 50000);
+QMSD_METRIC_HISTOGRAM(s_gui_flush_us, "gui.flush_us", 500, 2000, 5000, 10000, 20000);
+QMSD_METRIC_COUNTER(s_gui_flush_px, "gui.flush_px");
+#if LV_USE_GLYPH_CACHE
+QMSD_METRIC_COUNTER(s_gui_glyph_hits, "gui.glyph_hits");
+QMSD_METRIC_COUNTER(s_gui_glyph_misses, "gui.glyph_misses");
+QMSD_METRIC_GAUGE(s_gui_glyph_bytes, "gui.glyph_bytes");
+#endif
+#if LV_USE_DRAW_CACHE
+QMSD_METRIC_GAUGE(s_gui_cache_shadow_hit_pct, "gui.cache.shadow_hit_pct");
+QMSD_METRIC_GAUGE(s_gui_cache_grad_hit_pct, "gui.cache.grad_hit_pct");
+QMSD_METRIC_GAUGE(s_gui_cache_circle_hit_pct, "gui.cache.circle_hit_pct");
+QMSD_METRIC_GAUGE(s_gui_cache_img_hit_pct, "gui.cache.img_hit_pct");
+QMSD_METRIC_GAUGE(s_gui_cache_bytes, "gui.cache.bytes");
+#endif
+#if LV_USE_STYLE_CACHE
+QMSD_METRIC_COUNTER(s_gui_style_hits, "gui.style_hits");
+QMSD_METRIC_COUNTER(s_gui_style_misses, "gui.style_misses");
+#endif
+
 typedef struct {
     int offsetx1;
     int offsetx2;
@@ -30,7 +52,10 @@ static void refresh_task(void* arg) {
             int w = show_data->offsetx2 - show_data->offsetx1 + 1;
             int offsety1 = show_data->offsety1;
             int h = show_data->offsety2 - show_data->offsety1 + 1;
+            int64_t t = esp_timer_get_time();
             g_lvgl_config->draw_bitmap(offsetx1, offsety1, w, h, (uint16_t*)show_data->color);
+            qmsd_metric_observe(&s_gui_flush_us, esp_timer_get_time() - t);
+            qmsd_metric_add(&s_gui_flush_px, w * h);
             xQueueReceive(g_image_queue, &show_data, 0);
             free(show_data);
         }
@@ -50,7 +75,10 @@ static void lvgl_task_refresh(lv_disp_drv_t* drv, const lv_area_t* area, lv_colo
 }
 
 static void lvgl_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map) {
+    int64_t t = esp_timer_get_time();
     g_lvgl_config->draw_bitmap(area->x1, area->y1, (uint16_t)(area->x2 - area->x1 + 1), (uint16_t)(area->y2 - area->y1 + 1), (uint16_t*)color_map);
+    qmsd_metric_observe(&s_gui_flush_us, esp_timer_get_time() - t);
+    qmsd_metric_add(&s_gui_flush_px, lv_area_get_size(area));
     lv_disp_flush_ready(drv);
 }
 
@@ -79,6 +107,121 @@ static void lvgl_encoder_read(struct _lv_indev_drv_t* indev_drv, lv_indev_data_t
     }
 }
 
+#if LV_USE_REFR_PARALLEL
+// Band workers: gui-update renders as thread 0, worker i as thread i, on the next cores.
+#define BAND_WORKER_NUM (LV_REFR_PARALLEL_THREADS - 1)
+
+typedef struct {
+    lv_disp_drv_t* drv;
+    uint32_t thread_id;
+    SemaphoreHandle_t start;
+} band_worker_t;
+
+static band_worker_t g_band_workers[BAND_WORKER_NUM];
+static SemaphoreHandle_t g_band_done;
+
+static void band_task(void* arg) {
+    band_worker_t* worker = (band_worker_t*)arg;
+    for (;;) {
+        xSemaphoreTake(worker->start, portMAX_DELAY);
+        lv_refr_render_bands(worker->drv, worker->thread_id);
+        xSemaphoreGive(g_band_done);
+    }
+}
+
+static void lvgl_render_bands_start(lv_disp_drv_t* drv) {
+    for (int i = 0; i < BAND_WORKER_NUM; i++) {
+        xSemaphoreGive(g_band_workers[i].start);
+    }
+}
+
+static void lvgl_render_bands_wait(lv_disp_drv_t* drv) {
+    for (int i = 0; i < BAND_WORKER_NUM; i++) {
+        xSemaphoreTake(g_band_done, portMAX_DELAY);
+    }
+}
+
+static void band_workers_init(lv_disp_drv_t* drv, const qmsd_gui_config_t* config) {
+    g_band_done = xSemaphoreCreateCounting(BAND_WORKER_NUM, 0);
+    for (int i = 0; i < BAND_WORKER_NUM; i++) {
+        band_worker_t* worker = &g_band_workers[i];
+        worker->drv = drv;
+        worker->thread_id = i + 1;
+        worker->start = xSemaphoreCreateBinary();
+        char name[16];
+        snprintf(name, sizeof(name), "gui-band%d", i + 1);
+        int8_t core = config->update_task.core;
+        if (core >= 0) {
+            core = (core + i + 1) % portNUM_PROCESSORS;
+        }
+        // The band stacks hold the draw state (thread locals), keep them in internal ram
+        qmsd_thread_create(band_task, name, config->update_task.stack_size, worker, config->update_task.priority, NULL, core, false);
+    }
+    drv->render_bands_start_cb = lvgl_render_bands_start;
+    drv->render_bands_wait_cb = lvgl_render_bands_wait;
+}
+#endif
+
+#if LV_USE_GLYPH_CACHE
+// The main tier is big and read once a letter, so PSRAM; the hot tier is what the blend reads
+static void* glyph_cache_alloc(size_t size, lv_glyph_cache_mem_t mem) {
+    if (mem == LV_GLYPH_CACHE_MEM_FAST) {
+        return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_8BIT);
+}
+
+static void glyph_cache_free(void* p, lv_glyph_cache_mem_t mem) {
+    heap_caps_free(p);
+}
+
+// The stats of the update task's cache, the band workers keep their own
+static void glyph_cache_metrics_update(void) {
+    lv_glyph_cache_stats_t stats;
+    lv_draw_sw_glyph_cache_get_stats(&stats);
+    qmsd_metric_add(&s_gui_glyph_hits, stats.hits);
+    qmsd_metric_add(&s_gui_glyph_misses, stats.misses + stats.uncached);
+    qmsd_metric_set(&s_gui_glyph_bytes, stats.bytes + stats.fast_bytes);
+    lv_draw_sw_glyph_cache_reset_stats();
+}
+#endif
+
+#if LV_USE_DRAW_CACHE
+static void* draw_cache_alloc(size_t size) {
+    return heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_8BIT);
+}
+
+// The hit rates of the update task's cache since the last call, a type not drawn keeps its last rate
+static void draw_cache_metrics_update(void) {
+    static qmsd_metric_t* const hit_pct[_LV_DRAW_CACHE_TYPE_NUM] = {
+        &s_gui_cache_shadow_hit_pct, &s_gui_cache_grad_hit_pct, &s_gui_cache_circle_hit_pct, &s_gui_cache_img_hit_pct,
+    };
+    uint32_t bytes = 0;
+    for (int type = 0; type < _LV_DRAW_CACHE_TYPE_NUM; type++) {
+        lv_draw_cache_stats_t stats;
+        lv_draw_cache_get_stats(type, &stats);
+        uint32_t lookups = stats.hits + stats.misses + stats.rejects;
+        if (lookups) {
+            qmsd_metric_set(hit_pct[type], stats.hits * 100 / lookups);
+        }
+        bytes += stats.bytes;
+    }
+    qmsd_metric_set(&s_gui_cache_bytes, bytes);
+    lv_draw_cache_reset_stats();
+}
+#endif
+
+#if LV_USE_STYLE_CACHE
+// The lookups of the cached properties by the update task, the band workers count their own
+static void style_cache_metrics_update(void) {
+    lv_obj_style_cache_stats_t stats;
+    lv_obj_style_cache_get_stats(&stats);
+    qmsd_metric_add(&s_gui_style_hits, stats.hits);
+    qmsd_metric_add(&s_gui_style_misses, stats.misses);
+    lv_obj_style_cache_reset_stats();
+}
+#endif
+
 static void increase_lvgl_tick(void* arg) {
     lv_tick_inc(portTICK_PERIOD_MS);
 }
@@ -87,7 +230,18 @@ static void gui_update_task(void* arg) {
     while (1) {
         uint32_t handler_start = lv_tick_get();
         if (qmsd_gui_lock(portMAX_DELAY) == 0) {
+            int64_t t = esp_timer_get_time();
             lv_task_handler();
+            qmsd_metric_observe(&s_gui_handler_us, esp_timer_get_time() - t);
+#if LV_USE_GLYPH_CACHE
+            glyph_cache_metrics_update();
+#endif
+#if LV_USE_DRAW_CACHE
+            draw_cache_metrics_update();
+#endif
+#if LV_USE_STYLE_CACHE
+            style_cache_metrics_update();
+#endif
             qmsd_gui_unlock();
         }
 
@@ -117,6 +271,12 @@ void qmsd_gui_init(qmsd_gui_config_t* lvgl_config) {
     g_gui_semaphore = xSemaphoreCreateMutex();
 
     lv_init();
+#if LV_USE_GLYPH_CACHE
+    lv_draw_sw_glyph_cache_set_alloc_cb(glyph_cache_alloc, glyph_cache_free);
+#endif
+#if LV_USE_DRAW_CACHE
+    lv_draw_cache_set_alloc_cb(draw_cache_alloc, heap_caps_free);
+#endif
     lv_disp_draw_buf_init(&disp_buf, lvgl_config->buffer[0], lvgl_config->buffer[1], lvgl_config->buffer_size >> 1);
     lv_disp_drv_init(&disp_drv);
     disp_drv.hor_res = lvgl_config->width;
@@ -135,6 +295,12 @@ void qmsd_gui_init(qmsd_gui_config_t* lvgl_config) {
         disp_drv.flush_cb = lvgl_flush;
     }
 
+#if LV_USE_REFR_PARALLEL
+    if (lvgl_config->update_task.en) {
+        band_workers_init(&disp_drv, lvgl_config);
+    }
+#endif
+
     lv_disp_drv_register(&disp_drv);
 
     if (lvgl_config->touch_read) {
@@ -110,9 +110,10 @@ qmsd_err_t touch_init(touch_panel_driver_t* touch_panel, touch_panel_config_t* p
         gpio_config(&io_conf);
     }
     if (panel_config->task_en) {
-        TaskHandle_t task_handle;
-        xTaskCreatePinnedToCore(touch_read_task, "touch", panel_config->task_stack_size, (void *)(panel_config->intr_pin < 0), panel_config->task_priority, &task_handle, 0);
-        if (panel_config->intr_pin > -1) {
+        TaskHandle_t task_handle = NULL;
+        qmsd_thread_create(touch_read_task, "touch", panel_config->task_stack_size, (void *)(panel_config->intr_pin < 0),
+                           panel_config->task_priority, &task_handle, panel_config->task_core, 0);
+        if (panel_config->intr_pin > -1 && task_handle) {
             gpio_set_intr_type(panel_config->intr_pin, GPIO_INTR_NEGEDGE);
             gpio_isr_handler_add(panel_config->intr_pin, touch_isr_handler, task_handle);
         }
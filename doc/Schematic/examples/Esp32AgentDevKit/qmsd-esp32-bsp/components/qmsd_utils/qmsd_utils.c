@@ -6,6 +6,8 @@
 #include "freertos/task.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "qmsd_mem.h"
+#include "qmsd_sched.h"
 #define TAG "qmsd_utils"
 #define REF_TIME        1577808000 /* 2020-01-01 00:00:00 */
 
@@ -125,25 +127,21 @@ void qmsd_debug_heap_print(uint32_t caps, uint32_t interval_time) {
     }
 }
 
-//static int __malloc_cont =0;
-
 void* qmsd_malloc(size_t size)
 {
-    void* mem = malloc(size);
-    //__malloc_cont++;
-    //printf("malloc: %d\n", __malloc_cont);
-    return mem;
+    return qmsd_mem_malloc_at(QMSD_MEM_TAG_OTHER, size, 0, __builtin_return_address(0));
 }
 
 void qmsd_free(void* p)
 {
-    free(p);
-    //__malloc_cont--;
-    //printf("free: %d\n", __malloc_cont);
+    qmsd_mem_free(p);
 }
 
-esp_err_t qmsd_thread_create(TaskFunction_t main_func, const char* const name, const uint32_t stack_size, void* const arg,
-                             UBaseType_t prio, TaskHandle_t* const p_handle, const BaseType_t core_id, uint8_t stack_in_ext) {
+esp_err_t qmsd_thread_create(TaskFunction_t main_func, const char* const name, uint32_t stack_size, void* const arg,
+                             UBaseType_t prio, TaskHandle_t* const p_handle, BaseType_t core_id, uint8_t stack_in_ext) {
+    if (qmsd_sched_place(name, &prio, &core_id, &stack_size)) {
+        ESP_LOGI(TAG, "The %s task placed by plan: prio %u, core %d", name, (unsigned)prio, (int)core_id);
+    }
     if (stack_in_ext) {
 #if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 2, 0)
         assert(false && "thread in psarm only support idf version >= 5.2.0 !");
@@ -99,10 +99,12 @@ uint16_t crc16tablefast(uint8_t *data, uint32_t len);
 
 uint16_t crc16tablefast_muti(uint8_t *data, uint32_t len, uint8_t *data1, uint32_t len1);
 
+// Tagged QMSD_MEM_TAG_OTHER (qmsd_mem.h), free only with qmsd_free.
 void* qmsd_malloc(size_t size);
 
 void qmsd_free(void* p);
 
+// The task plan (qmsd_task_plan.h) overrides prio, core_id and stack for the tasks it names.
 // Note: If stack_in_ext is true, deleting tasks will cause memory leaks, so it can only be used for threads that never end !!!!
 esp_err_t qmsd_thread_create(TaskFunction_t main_func, const char* const name, const uint32_t stack, void* const arg,
                              UBaseType_t prio, TaskHandle_t* const p_handle, const BaseType_t core_id, uint8_t stack_in_ext);
@@ -0,0 +1,162 @@
+import os
+import re
+import sys
+import json
+import struct
+import argparse
+
+# Decoder for qmsd_metrics snapshots (format in components-ext/qmsd_metrics/qmsd_metrics.h).
+# Reads a raw snapshot file, or a serial log holding "QMTS:<hex>" lines from the
+# `metrics bin` console command. Snapshots without names need the schema of an
+# earlier one with names, schemas are kept in a json file by hash.
+
+MAGIC = 0x53544D51
+VERSION = 1
+FLAG_NAMES = 0x01
+COUNTER, GAUGE, HISTOGRAM = 0, 1, 2
+HEADER = struct.Struct("<IBBHII")
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def u8(self):
+        if self.pos >= len(self.data):
+            raise ValueError("snapshot truncated")
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            b = self.u8()
+            value |= (b & 0x7f) << shift
+            if not b & 0x80:
+                return value
+            shift += 7
+
+    def zigzag(self):
+        z = self.varint()
+        return (z >> 1) ^ -(z & 1)
+
+    def bytes(self, n):
+        if self.pos + n > len(self.data):
+            raise ValueError("snapshot truncated")
+        self.pos += n
+        return self.data[self.pos - n:self.pos]
+
+def decode(data, schemas):
+    if len(data) < HEADER.size:
+        raise ValueError("snapshot truncated")
+    magic, version, flags, count, schema_hash, timestamp = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError(f"not a v{VERSION} snapshot")
+    reader = Reader(data)
+    reader.pos = HEADER.size
+    schema = schemas.get(schema_hash)
+    if not flags & FLAG_NAMES and schema is None:
+        raise ValueError(f"unknown schema {schema_hash:08x}, dump one snapshot with `metrics bin names` first")
+    new_schema = []
+    metrics = []
+    for i in range(count):
+        if flags & FLAG_NAMES:
+            kind = reader.u8()
+            name = reader.bytes(reader.u8()).decode()
+            bounds = [reader.varint() for _ in range(reader.u8())] if kind == HISTOGRAM else []
+            new_schema.append([name, kind, bounds])
+        else:
+            name, kind, bounds = schema[i]
+        if kind == COUNTER:
+            value = reader.varint()
+        elif kind == GAUGE:
+            value = reader.zigzag()
+        else:
+            value = {"buckets": [reader.varint() for _ in range(len(bounds) + 1)]}
+            value["sum"] = reader.varint()
+        metrics.append((name, kind, bounds, value))
+    if reader.pos != len(data):
+        raise ValueError(f"{len(data) - reader.pos} trailing bytes")
+    if new_schema:
+        schemas[schema_hash] = new_schema
+    return timestamp, schema_hash, metrics
+
+def delta(metric, last):
+    name, kind, bounds, value = metric
+    if last is None or kind == GAUGE:
+        return metric
+    if kind == COUNTER:
+        return (name, kind, bounds, (value - last) & 0xffffffff)
+    return (name, kind, bounds, {
+        "buckets": [(a - b) & 0xffffffff for a, b in zip(value["buckets"], last["buckets"])],
+        "sum": (value["sum"] - last["sum"]) & 0xffffffff,
+    })
+
+def print_snapshot(timestamp, metrics, prefix):
+    print(f"@ {timestamp / 1000:.3f} s")
+    for name, kind, bounds, value in metrics:
+        if prefix and not name.startswith(prefix):
+            continue
+        if kind != HISTOGRAM:
+            print(f"  {name:<28} {value}")
+            continue
+        count = sum(value["buckets"])
+        mean = value["sum"] // count if count else 0
+        print(f"  {name:<28} n {count}, mean {mean}")
+        for i, n in enumerate(value["buckets"]):
+            if n == 0:
+                continue
+            edge = f"<= {bounds[i]}" if i < len(bounds) else f" > {bounds[-1]}"
+            print(f"  {'':<28} {edge:<11} {n}")
+
+def read_snapshots(path):
+    with open(path, "rb") as fin:
+        data = fin.read()
+    if data[:4] == struct.pack("<I", MAGIC):
+        return [data]
+    text = data.decode(errors="ignore")
+    return [bytes.fromhex(m) for m in re.findall(r"QMTS:([0-9a-fA-F]+)", text)]
+
+def load_schemas(path):
+    if not path or not os.path.exists(path):
+        return {}
+    with open(path) as fin:
+        return {int(k, 16): v for k, v in json.load(fin).items()}
+
+def save_schemas(path, schemas):
+    if not path:
+        return
+    with open(path, "w") as fout:
+        json.dump({f"{k:08x}": v for k, v in schemas.items()}, fout, indent=1)
+
+def run():
+    parser = argparse.ArgumentParser(description='QMSD metrics snapshot decoder')
+    parser.add_argument('input', help='raw snapshot or serial log with QMTS: lines')
+    parser.add_argument('-s', '--schemas', default='metrics_schemas.json', help='schema cache, "" to disable')
+    parser.add_argument('-p', '--prefix', default=None, help='only metrics starting with this')
+    parser.add_argument('-d', '--delta', action='store_true', help='counters and histograms as the change since the last snapshot')
+    args = parser.parse_args()
+
+    schemas = load_schemas(args.schemas)
+    last = {}
+    snapshots = read_snapshots(args.input)
+    if not snapshots:
+        print(f"No snapshot in {args.input}")
+        sys.exit(1)
+    for data in snapshots:
+        try:
+            timestamp, schema_hash, metrics = decode(data, schemas)
+        except ValueError as e:
+            print(f"Skipped a snapshot: {e}")
+            continue
+        if args.delta:
+            shown = [delta(m, last.get((schema_hash, m[0]))) for m in metrics]
+            last = {(schema_hash, m[0]): m[3] for m in metrics}
+        else:
+            shown = metrics
+        print_snapshot(timestamp, shown, args.prefix)
+    save_schemas(args.schemas, schemas)
+
+if __name__ == "__main__":
+    run()
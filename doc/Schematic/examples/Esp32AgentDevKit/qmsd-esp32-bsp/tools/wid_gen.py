@@ -0,0 +1,140 @@
+import os
+import re
+import sys
+import argparse
+
+# Widget id table generator for components-ext/qmsd_middleware_8ms/qmsd_wid.h.
+# Collects the `extern lv_obj_t * name;` declarations of ui headers, numbers
+# them in declaration order and builds the perfect hash table qmsd_wid_build
+# would build at runtime, with the same hash, seeds and placement order, so a
+# lookup on the device finds what this script placed.
+
+MASK32 = 0xffffffff
+SEEDS = 256
+DISP_MAX = 0xffff
+EMPTY = 0xffff
+WID_MAX = 256
+
+def pow2(n):
+    p = 1
+    while p < n:
+        p <<= 1
+    return p
+
+def wid_hash(name, seed):
+    h = 2166136261 ^ seed
+    for b in name.encode():
+        h ^= b
+        h = (h * 16777619) & MASK32
+    return h
+
+def wid_mix(h, d):
+    h ^= (d * 0x9e3779b9) & MASK32
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & MASK32
+    h ^= h >> 13
+    h = (h * 0xc2b2ae35) & MASK32
+    h ^= h >> 16
+    return h
+
+def try_build(names, seed):
+    buckets = pow2((len(names) + 3) // 4)
+    size = pow2(len(names))
+    hashes = [wid_hash(n, seed) for n in names]
+    members = [[] for _ in range(buckets)]
+    for i, h in enumerate(hashes):
+        members[wid_mix(h, 0) & (buckets - 1)].append(i)
+    disp = [0] * buckets
+    slots = [EMPTY] * size
+    largest = max(len(m) for m in members)
+    for n in range(largest, 0, -1):
+        for b in range(buckets):
+            if len(members[b]) != n:
+                continue
+            for d in range(1, DISP_MAX + 1):
+                taken = [wid_mix(hashes[i], d) & (size - 1) for i in members[b]]
+                if len(set(taken)) == len(taken) and all(slots[s] == EMPTY for s in taken):
+                    for i, s in zip(members[b], taken):
+                        slots[s] = i
+                    disp[b] = d
+                    break
+            else:
+                return None
+    return disp, slots
+
+def build(names):
+    if not names or len(names) > WID_MAX:
+        raise ValueError(f"{len(names)} widgets, 1 to {WID_MAX} supported")
+    if len(set(names)) != len(names):
+        raise ValueError("duplicate widget names")
+    for seed in range(SEEDS):
+        table = try_build(names, seed)
+        if table:
+            return seed, table[0], table[1]
+    raise ValueError("no perfect hash found")
+
+def collect(paths):
+    names = []
+    for path in paths:
+        with open(path, encoding="utf-8", errors="ignore") as fin:
+            names += re.findall(r"^\s*extern\s+lv_obj_t\s*\*\s*(\w+)\s*;", fin.read(), re.M)
+    return list(dict.fromkeys(names))
+
+def c_array(values, per_line=12):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(str(v) for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+def emit(names, seed, disp, slots, out, prefix, strip, include, sources):
+    base = os.path.splitext(os.path.basename(out))[0]
+    macro = lambda n: prefix + (n[len(strip):] if strip and n.startswith(strip) else n)
+    width = max(len(macro(n)) for n in names) + 1
+    note = f"// Generated by tools/wid_gen.py from {', '.join(sources)}, do not edit."
+
+    with open(out + ".h", "w") as fout:
+        fout.write("#pragma once\n\n" + note + "\n\n#include \"qmsd_wid.h\"\n\n")
+        for i, n in enumerate(names):
+            fout.write(f"#define {macro(n):<{width}} {i}\n")
+        fout.write(f"#define {prefix + 'NUM':<{width}} {len(names)}\n\n")
+        fout.write(f"extern const qmsd_wid_table_t {base}_table;\n\n")
+        fout.write("// Binds every widget of the table to its object, after ui_init.\n")
+        fout.write(f"void {base}_bind_all(void);\n")
+
+    with open(out + ".c", "w") as fout:
+        fout.write(note + "\n\n")
+        fout.write(f"#include \"{base}.h\"\n#include \"qmsd_ui_ctrl.h\"\n#include \"{include}\"\n\n")
+        fout.write("static const char* const g_names[] = {\n")
+        fout.write("\n".join(f"    \"{n}\"," for n in names) + "\n};\n\n")
+        fout.write("static const uint16_t g_disp[] = {\n" + c_array(disp) + "\n};\n\n")
+        fout.write("static const uint16_t g_slots[] = {\n" + c_array([f"0x{s:04x}" if s == EMPTY else s for s in slots]) + "\n};\n\n")
+        fout.write(f"const qmsd_wid_table_t {base}_table = {{\n")
+        fout.write(f"    .seed = {seed},\n    .num = {len(names)},\n")
+        fout.write(f"    .bucket_mask = {len(disp) - 1},\n    .slot_mask = {len(slots) - 1},\n")
+        fout.write("    .disp = g_disp,\n    .slots = g_slots,\n    .names = g_names,\n};\n\n")
+        fout.write(f"void {base}_bind_all(void)\n{{\n")
+        for n in names:
+            fout.write(f"    qmsd_ui_bind({macro(n)}, {n});\n")
+        fout.write("}\n")
+
+def run():
+    parser = argparse.ArgumentParser(description='QMSD widget id table generator')
+    parser.add_argument('headers', nargs='+', help='ui headers with the extern lv_obj_t declarations')
+    parser.add_argument('-o', '--output', required=True, help='output path without extension, writes .h and .c')
+    parser.add_argument('-p', '--prefix', default='UI_WID_', help='id macro prefix')
+    parser.add_argument('-s', '--strip', default='ui_', help='name prefix left out of the macros')
+    parser.add_argument('-i', '--include', default='ui.h', help='header the .c includes for the objects')
+    args = parser.parse_args()
+
+    names = collect(args.headers)
+    try:
+        seed, disp, slots = build(names)
+    except ValueError as e:
+        print(f"wid_gen: {e}")
+        sys.exit(1)
+    sources = [os.path.relpath(h, os.path.dirname(os.path.abspath(args.output))) for h in args.headers]
+    emit(names, seed, disp, slots, args.output, args.prefix, args.strip, args.include, sources)
+    print(f"{len(names)} widgets, seed {seed}, {len(disp)} buckets, {len(slots)} slots")
+
+if __name__ == "__main__":
+    run()